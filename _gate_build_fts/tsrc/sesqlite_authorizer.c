@@ -0,0 +1,1150 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/* SeSqlite extension to add SELinux checks in SQLite */
+
+#if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
+
+#include "sesqlite_authorizer.h"
+#include "sesqlite_attach.h"
+#include "sesqlite_utils.h"
+#include "sesqlite_shm.h"
+#include "sesqlite_init.h"
+#include "sesqlite_stmt.h"
+
+/* Comment the following line to disable the userspace AVC */
+#define USE_AVC
+
+#ifdef USE_AVC
+/*
+ * The userspace AVC keeps the decisions for the subject of the process,
+ * which is the same for all the connections. The label ids are the small
+ * dense rowids of selinux_id, so the decisions are stored in a matrix with
+ * one row for each label id and one byte for each class and permission,
+ * and the rows are added as the dictionary grows. A byte is AVC_UNKNOWN
+ * until the policy is asked, then AVC_DENY or AVC_ALLOW.
+ */
+#define AVC_UNKNOWN 0
+#define AVC_DENY    1
+#define AVC_ALLOW   2
+#define AVC_NSLOT   ((SELINUX_NELEM_CLASS+1) * SELINUX_NELEM_PERM)
+#define AVC_SLOT(id, tclass, perm) \
+	((id) * AVC_NSLOT + (tclass) * SELINUX_NELEM_PERM + (perm))
+
+static unsigned char *avc;    /* nAvcRow rows of AVC_NSLOT decisions */
+static int nAvcRow;
+static unsigned int avc_generation; /* incremented when the AVC is cleared */
+
+/*
+ * Memo of the last decisions taken by one selinux_check_access call site
+ * while a statement runs, attached to the (constant) class argument with
+ * sqlite3_set_auxdata. The rows of a leaf page usually carry a handful of
+ * distinct labels, so a scan finds the decision for most of its rows in
+ * here, without resolving the class and the permission, translating the
+ * label of an attached database and looking up the AVC again for every row.
+ */
+#define SESQLITE_MEMO_SIZE 4
+
+typedef struct sesqlite_memo {
+	unsigned int generation;        /* avc_generation of the decisions */
+	int tclass;                     /* class code of the call site */
+	int tperm;                      /* permission code of the call site */
+	int nUsed;                      /* slots filled in aId and aRes */
+	int iNext;                      /* next slot to replace */
+	int aId[SESQLITE_MEMO_SIZE];    /* labels, as stored in the tuples */
+	int aRes[SESQLITE_MEMO_SIZE];   /* decisions for the labels in aId */
+} sesqlite_memo;
+
+/*
+ * Returns the decision stored in the AVC for the label id, the class and
+ * the permission: 1 allow, 0 deny, -1 if the decision was never taken.
+ */
+static int avc_lookup(int id, int tclass, int perm){
+    int res = AVC_UNKNOWN;
+
+    assert( tclass<=SELINUX_NELEM_CLASS && perm<SELINUX_NELEM_PERM );
+    sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+    if( id<nAvcRow )
+	res = avc[AVC_SLOT(id, tclass, perm)];
+    sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+    return res - 1;
+}
+
+/*
+ * Stores a decision, adding the rows up to the label id if needed. If the
+ * memory is not available the decision is simply not cached.
+ */
+static void avc_store(int id, int tclass, int perm, int res){
+    sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+    if( id>=nAvcRow ){
+	int nNew = nAvcRow ? nAvcRow : 64;
+	unsigned char *aNew;
+	while( nNew<=id ) nNew *= 2;
+	aNew = sqlite3_realloc(avc, nNew * AVC_NSLOT);
+	if( aNew!=NULL ){
+	    memset(&aNew[nAvcRow * AVC_NSLOT], AVC_UNKNOWN,
+		(nNew - nAvcRow) * AVC_NSLOT);
+	    avc = aNew;
+	    nAvcRow = nNew;
+	}
+    }
+    if( id<nAvcRow )
+	avc[AVC_SLOT(id, tclass, perm)] = ( res==1 ? AVC_ALLOW : AVC_DENY );
+    sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+}
+#endif
+
+int insert_id(sqlite3 *db, char *db_name, char *sec_label){
+
+    struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+    int rc = SQLITE_OK;
+    int rowid = 0;
+
+    rowid = sesqlite_label_id(sec_label);
+	if( rowid!=0 )
+		return rowid;
+	sqlite3_bind_int(pConn->stmt_insert, 1, lookup_security_context(hash_id, db_name, SELINUX_ID));
+	sqlite3_bind_text(pConn->stmt_insert, 2, sec_label, strlen(sec_label), SQLITE_TRANSIENT);
+
+	rc = sqlite3_step(pConn->stmt_insert);
+	sqlite3_reset(pConn->stmt_insert);
+
+	if( rc==SQLITE_DONE ){
+		rowid = sqlite3_last_insert_rowid(db);
+		sesqlite_shm_publish(db, rowid, sec_label);
+	}else{
+		/* added by another process (or connection), not yet known */
+		sqlite3_bind_text(pConn->stmt_select_id, 1, sec_label, -1, SQLITE_TRANSIENT);
+		if( sqlite3_step(pConn->stmt_select_id)==SQLITE_ROW )
+			rowid = sqlite3_column_int(pConn->stmt_select_id, 0);
+		sqlite3_reset(pConn->stmt_select_id);
+		if( rowid==0 )
+			return 0;
+	}
+
+	sesqlite_label_add(rowid, sec_label);
+    return rowid;
+}
+
+/*
+ * Return the security context of the given (table), (table, column) element.
+ *
+ * Function: getContext
+ * Purpose: Given the table name or table and column name, returns the security
+ * context associated.
+ * Parameters:
+ *     dbname: database name;
+ *     table: table name;
+ *     column: column name, it is NULL if tclass == 1.
+ *     tclass: 1 = table, 2 = column;
+ * Return value: Return the security context associated to the table/column
+ * given.
+ */
+int getContext(
+    sqlite3 *db,
+    const char *dbname,
+    const char *table,
+    const char *column,
+    int tclass
+){
+	int id = 0;
+
+    id = get_key(db, dbname, table, column);
+
+    if (id != -1) {
+
+#ifdef SQLITE_DEBUG
+		char *after = sqlite3_mprintf("-> %d", id);
+		sesqlite_print("Hash hint for", dbname, table, column, after);
+		sqlite3_free(after);
+#endif
+
+    }else{
+        struct sesqlite_context *contexts = sesqlite_get_contexts();
+        security_context_t security_context_new = 0;
+        switch (tclass) {
+
+        case SELINUX_DB_DATABASE:
+            compute_sql_context(0,
+                (char *) dbname,
+                NULL,
+                NULL,
+                contexts->db_context,
+                &security_context_new);
+            break;
+
+        case SELINUX_DB_TABLE:
+            compute_sql_context(0,
+                (char *) dbname,
+                (char *) table,
+                NULL,
+                contexts->table_context,
+                &security_context_new);
+            break;
+
+        case SELINUX_DB_COLUMN:
+            compute_sql_context(1,
+                (char *) dbname,
+                (char *) table,
+                (char *) column,
+                contexts->column_context,
+                &security_context_new);
+            break;
+
+        }
+        id = insert_id(db, (char*) dbname, security_context_new);
+        insert_key(db, dbname, table, column, id);
+
+#ifdef SQLITE_DEBUG
+        fprintf(stdout, "Compute New Context: db=%s, table=%s, column=%s -> %d\n",
+            dbname, table, (column ? column : "NULL"), id);
+#endif
+
+    }
+	return id;
+}
+
+
+/*
+ * Checks whether the table has the security_context attribute.
+ */
+int is_table_sesqlite_enabled(sqlite3 *db,char *zDatabase, char *zName){
+
+	int rc = SQLITE_OK;
+
+	Table *pTab = sqlite3FindTable(db, zName, zDatabase);
+	
+	/* security_context is ALWAYS the last column */
+	if(!strcasecmp(pTab->aCol[pTab->nCol-1].zName, SECURITY_CONTEXT_COLUMN_NAME))
+		rc = SQLITE_OK;
+	else{
+		fprintf(stderr,
+			"Error: table %s does not support the security_context attribute.\n", 
+			zName);
+		rc = SQLITE_ERROR;
+	}
+
+	return rc;
+}
+
+/*
+ * Checks whether the source context has been granted the specified permission
+ * for the classes 'db_table' and 'db_column' and the target context associated with the table/column.
+ * Returns 1 if the access has been granted, 0 otherwise.
+ */
+int checkAccess(
+	sqlite3 *db,
+	const char *dbname,
+	const char *table,
+	const char *column,
+	int tclass,
+	int perm
+){
+    int res = 0;
+    assert(tclass <= NELEMS(access_vector));
+
+	/* Check whether the table supports the security_context attribute.
+	 * Do not grant access to the table if the table does not have the security_context. */
+//	res = is_table_sesqlite_enabled(db, (char *) dbname, (char *) table);
+//	if( SQLITE_OK!=res ) return SQLITE_ERROR;
+
+    int id = getContext(db, dbname, table, column, tclass);
+    assert(id != 0);
+
+#ifdef USE_AVC
+    int c_code = access_vector[tclass].c_code;
+    int p_code = access_vector[tclass].perm[perm].p_code;
+
+    res = avc_lookup(id, c_code, p_code);
+    if ( res==-1 ){
+#endif
+	char *ttcon = sesqlite_label(id);
+	sqlite3Dequote(ttcon);
+	res = ( 0==selinux_check_access(
+	    scon,
+	    ttcon,
+	    access_vector[tclass].c_name,
+	    access_vector[tclass].perm[perm].p_name,
+	    NULL
+	));
+#ifdef USE_AVC
+	avc_store(id, c_code, p_code, res);
+    }
+#endif
+
+    return res;
+}
+
+/**
+ * Scan all the columns and call checkAccess
+ */
+int checkAllColumns(sqlite3* pdb, const char *dbName, const char* tblName,
+		int type, int action) {
+
+	int rc = SQLITE_OK;
+	int i = -1; /* Database number */
+	int j;
+	Hash *pTbls;
+	HashElem *x;
+	Db *pDb;
+
+	// TODO type = db_column
+
+	Table *pTab = sqlite3FindTable(pdb, tblName, dbName);
+	if (pTab) {
+		Column *pCol;
+		for (j = 0, pCol = pTab->aCol; j < pTab->nCol; j++, pCol++) {
+			if (!checkAccess(pdb, dbName, tblName, pCol->zName, type, action)) {
+				return SQLITE_DENY;
+			}
+		}
+	}
+
+	return rc;
+}
+
+/*
+ * Authorizer to be set with sqlite3_set_authorizer that checks the SELinux
+ * permission at schema level (tables and columns).
+ */
+int selinuxAuthorizer(void *pUserData, int type, const char *arg1,
+		const char *arg2, const char *dbname, const char *source) {
+	int rc = SQLITE_OK;
+
+	sqlite3 *pdb = (sqlite3*) pUserData;
+
+#ifdef SQLITE_DEBUG
+	//fprintf(stdout, "authorizer: type=%s arg1=%s arg2=%s\n", authtype[type],
+	//		(arg1 ? arg1 : "NULL"), (arg2 ? arg2 : "NULL"));
+#endif
+
+	/* check whether the caller can access the db */
+	if (dbname && !checkAccess(pdb, dbname, NULL, NULL, SELINUX_DB_DATABASE,
+	SELINUX_ACCESS)) {
+		rc = SQLITE_DENY;
+	}
+
+	switch (type) /* arg1          | arg2            */
+	{
+
+	case SQLITE_CREATE_INDEX: /* Index Name    | Table Name      */
+		break;
+
+	case SQLITE_CREATE_TABLE: /* Table Name    | NULL            */
+		//check if the sesqlite_master contains the security_context to assign,
+		//otherwise use the default security_context.
+		//TODO in android the default security_context is not always the same (e.g., untrusted_app->app_data_file,
+		//release_app->platform_app_data_file)
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_CREATE)) {
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_CREATE_TEMP_INDEX: /* Index Name    | Table Name      */
+		break;
+
+	case SQLITE_CREATE_TEMP_TABLE: /* Table Name    | NULL            */
+		//see SQLITE_CREATE_TABLE comment
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_CREATE)) {
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_CREATE_TEMP_TRIGGER: /* Trigger Name  | Table Name      */
+		break;
+
+	case SQLITE_CREATE_TEMP_VIEW: /* View Name     | NULL            */
+		//TODO TABLE == VIEW??
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_CREATE)) {
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_CREATE_TRIGGER: /* Trigger Name  | Table Name      */
+		if (!checkAccess(pdb, dbname, arg2, NULL, SELINUX_DB_TABLE,
+		SELINUX_SETATTR)) {
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_CREATE_VIEW: /* View Name     | NULL            */
+		//TODO TABLE == VIEW??
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_CREATE)) {
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_DELETE: /* Table Name    | NULL            */
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_DELETE)) {
+			rc = SQLITE_DENY;
+		/* no need to check drop on columns  */
+		}
+
+		break;
+
+	case SQLITE_DROP_INDEX: /* Index Name    | Table Name      */
+		if (!checkAccess(pdb, dbname, arg2, NULL, SELINUX_DB_TABLE,
+		SELINUX_SETATTR)) {
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_DROP_TABLE: /* Table Name    | NULL            */
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		    SELINUX_DROP)) {
+			rc = SQLITE_DENY;
+		}else if(checkAllColumns(pdb, dbname, arg1, SELINUX_DB_COLUMN,
+		    SELINUX_DROP)){
+			rc = SQLITE_DENY;
+		}
+
+		break;
+
+	case SQLITE_DROP_TEMP_INDEX: /* Index Name    | Table Name      */
+		break;
+
+	case SQLITE_DROP_TEMP_TABLE: /* Table Name    | NULL            */
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_DROP)) {
+			rc = SQLITE_DENY;
+		}else if(checkAllColumns(pdb, dbname, arg1, SELINUX_DB_COLUMN,
+		    SELINUX_DROP)){
+			rc = SQLITE_DENY;
+		}
+
+		break;
+
+	case SQLITE_DROP_TEMP_TRIGGER: /* Trigger Name  | Table Name      */
+		break;
+
+	case SQLITE_DROP_TEMP_VIEW: /* View Name     | NULL            */
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_DROP)) {
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_DROP_TRIGGER: /* Trigger Name  | Table Name      */
+		if (!checkAccess(pdb, dbname, arg2, NULL, SELINUX_DB_TABLE,
+		SELINUX_SETATTR)) {
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_DROP_VIEW: /* View Name     | NULL            */
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_DROP)) {
+			rc = SQLITE_DENY;
+		}else if(checkAllColumns(pdb, dbname, arg1, SELINUX_DB_COLUMN,
+		    SELINUX_DROP)){
+			rc = SQLITE_DENY;
+		}
+
+		break;
+
+	case SQLITE_INSERT: /* Table Name    | NULL            */
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_INSERT)) {
+			rc = SQLITE_DENY;
+		}else if(checkAllColumns(pdb, dbname, arg1, SELINUX_DB_COLUMN,
+		    SELINUX_INSERT)){
+			rc = SQLITE_DENY;
+		}
+
+		break;
+
+	case SQLITE_PRAGMA: /* Pragma Name   | 1st arg or NULL */
+		if (0 == sqlite3_stricmp(arg1, "writable_schema")) {
+			fprintf(stderr,
+					"Pragma disabled to guarantee SeSqlite checks. [pragma command: %s]\n",
+					arg1);
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_READ: /* Table Name    | Column Name     */
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_SELECT)) {
+			rc = SQLITE_DENY;
+		}else if (!checkAccess(pdb, dbname, arg1, arg2, SELINUX_DB_COLUMN,
+		    SELINUX_SELECT)) {
+			rc = SQLITE_DENY;
+		}
+
+		break;
+
+	case SQLITE_SELECT: /* NULL          | NULL            */
+		break;
+
+	case SQLITE_TRANSACTION: /* Operation     | NULL            */
+		break;
+
+	case SQLITE_UPDATE: /* Table Name    | Column Name     */
+		if (!checkAccess(pdb, dbname, arg1, arg2, SELINUX_DB_COLUMN,
+		SELINUX_UPDATE)) {
+			rc = SQLITE_DENY;
+		}
+
+		break;
+
+	case SQLITE_ATTACH: /* Filename      | NULL            */
+		/* The labels of the attached database are loaded by the schema
+		 * change callback, which also checks the access to the file
+		 * against its own db_database context (see sesqlite_attach). */
+		break;
+
+	case SQLITE_DETACH: /* Database Name | NULL            */
+		if (arg1 == NULL || !checkAccess(pdb, arg1, NULL, NULL,
+		SELINUX_DB_DATABASE, SELINUX_ACCESS)) {
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_ALTER_TABLE: /* Database Name | Table Name      */
+		if (!checkAccess(pdb, arg1, arg2, NULL, SELINUX_DB_TABLE,
+		SELINUX_GETATTR)) {
+			rc = SQLITE_DENY;
+		}
+		break;
+
+	case SQLITE_REINDEX: /* Index Name    | NULL            */
+		break;
+
+	case SQLITE_ANALYZE: /* Table Name    | NULL            */
+		break;
+
+	case SQLITE_CREATE_VTABLE: /* Table Name    | Module Name     */
+		break;
+
+	case SQLITE_DROP_VTABLE: /* Table Name    | Module Name     */
+		if (!checkAccess(pdb, dbname, arg1, NULL, SELINUX_DB_TABLE,
+		SELINUX_DROP)) {
+			rc = SQLITE_DENY;
+		}else if(checkAllColumns(pdb, dbname, arg1, SELINUX_DB_COLUMN,
+		    SELINUX_DROP)){
+			rc = SQLITE_DENY;
+		}
+
+		break;
+
+	case SQLITE_FUNCTION: /* NULL          | Function Name   */
+		break;
+
+	case SQLITE_SAVEPOINT: /* Operation     | Savepoint Name  */
+		break;
+
+	case SQLITE_COPY: /*       - No longer used -        */
+		break;
+
+	default:
+		break;
+	}
+
+#ifdef SQLITE_DEBUG
+//	printf("\n");
+#endif
+
+	return rc;
+}
+
+int set_vacuum(sqlite3 *db, int type){
+    struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+    if( pConn ) pConn->vacuum = type;
+    return SQLITE_OK;
+}
+
+int is_vacuum(sqlite3 *db){
+    struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+    return pConn!=NULL && pConn->vacuum;
+}
+
+#ifdef USE_AVC
+/*
+ * Returns the decisions cache of the selinux_check_access call site, creating
+ * it the first time a row reaches the call site. Returns NULL on OOM, in
+ * which case the decision is taken without the cache.
+ */
+static sesqlite_memo *getMemo(
+	sqlite3_context *context,
+	sqlite3_value **argv
+){
+	sesqlite_memo *memo = sqlite3_get_auxdata(context, 1);
+	int i, j;
+
+	if( memo!=NULL ){
+		/* read without the mutex, a stale value only delays the reset */
+		if( memo->generation!=avc_generation ){
+			/* the AVC was cleared while the statement was running */
+			memo->generation = avc_generation;
+			memo->nUsed = 0;
+			memo->iNext = 0;
+		}
+		return memo;
+	}
+
+	memo = sqlite3_malloc(sizeof(sesqlite_memo));
+	if( memo==NULL )
+		return NULL;
+	memset(memo, 0, sizeof(sesqlite_memo));
+	memo->generation = avc_generation;
+
+	for(i = 0; i <= SELINUX_NELEM_CLASS; i++){
+		if( strcmp(access_vector[i].c_name, argv[1]->z)==0 ){
+			for(j = 0; j <= SELINUX_NELEM_PERM; j++){
+				if( strcmp(access_vector[i].perm[j].p_name, argv[2]->z)==0 ){
+					memo->tclass = access_vector[i].c_code;
+					memo->tperm = access_vector[i].perm[j].p_code;
+					break;
+				}
+			}
+		}
+	}
+
+	/* the cache is kept only if the class is a constant of the statement */
+	sqlite3_set_auxdata(context, 1, memo, sqlite3_free);
+	return sqlite3_get_auxdata(context, 1);
+}
+#endif
+
+/*
+ * Function invoked when using the SQL function selinux_check_access
+ */
+static void selinuxCheckAccessFunction(
+	sqlite3_context *context,
+	int argc,
+	sqlite3_value **argv
+){
+    sqlite3 *db = sqlite3_user_data(context);
+    int res = 0;
+    int label = sqlite3_value_int(argv[0]);
+    int id = label;
+    char *ttcon = NULL;
+
+#ifdef USE_AVC
+    sesqlite_memo *memo = getMemo(context, argv);
+    int i;
+
+    if( memo!=NULL ){
+	for(i = 0; i < memo->nUsed; i++){
+	    if( memo->aId[i]==label ){
+		res = memo->aRes[i];
+		goto check_done;
+	    }
+	}
+    }
+#endif
+
+    /* the optional 5th argument is the database the tuple belongs to */
+    if( argc==5 )
+	id = sesqlite_global_id(db, (const char*) sqlite3_value_text(argv[4]), id);
+    if( id==0 ){
+	/* unknown label */
+	sqlite3_result_int(context, 0);
+	return;
+    }
+
+#ifdef USE_AVC
+    int tclass = 0;
+    int tperm = 0;
+
+    if( memo!=NULL ){
+	tclass = memo->tclass;
+	tperm = memo->tperm;
+    }else{
+	int j;
+	for(i = 0; i <= SELINUX_NELEM_CLASS; i++){
+	    if(strcmp(access_vector[i].c_name, argv[1]->z) == 0){
+		for(j = 0; j <= SELINUX_NELEM_PERM; j++){
+		    if(strcmp(access_vector[i].perm[j].p_name, argv[2]->z) == 0){
+			tclass = access_vector[i].c_code;
+			tperm = access_vector[i].perm[j].p_code;
+			break;
+		     }
+		 }
+	    }
+	}
+    }
+
+    res = avc_lookup(id, tclass, tperm);
+    if( res==-1 ){
+	ttcon = sesqlite_label(id);
+	res = ( 0==selinux_check_access(
+	    scon,       /* source security context */
+	    ttcon,      /* target security context */
+	    argv[1]->z, /* target security class string */
+	    argv[2]->z, /* requested permissions string */
+	    NULL        /* auxiliary audit data */
+	));
+	avc_store(id, tclass, tperm, res);
+    }
+
+    if( memo!=NULL ){
+	/* round robin: the labels of the previous pages are replaced first */
+	memo->aId[memo->iNext] = label;
+	memo->aRes[memo->iNext] = res;
+	memo->iNext = (memo->iNext + 1) % SESQLITE_MEMO_SIZE;
+	if( memo->nUsed < SESQLITE_MEMO_SIZE )
+	    memo->nUsed++;
+    }
+
+check_done:
+#else
+    ttcon = sesqlite_label(id);
+    res = ( 0==selinux_check_access(
+	scon,       /* source security context */
+	ttcon, /* target security context */
+	argv[1]->z, /* target security class string */
+	argv[2]->z, /* requested permissions string */
+	NULL        /* auxiliary audit data */
+    ));
+#endif
+
+#ifdef SQLITE_DEBUG
+    ttcon = sesqlite_label(id);
+    fprintf(stdout, "table: %s, context: %s, action: %s => %s\n", 
+	    argv[3]->z,
+	    ttcon,
+	    argv[2]->z,
+	    (res ? "ALLOW": "DENY")
+    );
+#endif
+
+    sqlite3_result_int(context, res);
+}
+
+/*
+ * Function invoked when using the SQL function getcon_id
+ */
+static void selinuxGetconIdFunction(
+    sqlite3_context *context,
+    int argc,
+    sqlite3_value **argv
+){
+    sqlite3 *db = sqlite3_user_data(context);
+    if(security_check_context(argv[0]->z) == 0){
+	int id = insert_id(db, "main", argv[0]->z);
+	/* getcon_id(label, db) returns the id to store in a table of db */
+	if( argc==2 )
+	    id = sesqlite_local_id(db, (const char*) sqlite3_value_text(argv[1]), id);
+	sqlite3_result_int(context, id);
+
+    }else{
+	sqlite3_result_error(context,
+	    "SeSQLite - The requested label is not a valid selinux context.", -1);
+    }
+	sqlite3_reset(SESQLITE_CONN(db)->stmt_select_id);
+}
+
+/*
+ * Function invoked when using the SQL function getcon_label
+ */
+static void selinuxGetconLabelFunction(
+    sqlite3_context *context,
+    int argc,
+    sqlite3_value **argv
+){
+    sqlite3 *db = sqlite3_user_data(context);
+    sqlite3_stmt *stmt = SESQLITE_CONN(db)->stmt_select_label;
+    int id = sqlite3_value_int(argv[0]);
+    if( argc==2 )
+	id = sesqlite_global_id(db, (const char*) sqlite3_value_text(argv[1]), id);
+    sqlite3_bind_int(stmt, 1, id);
+
+    if( SQLITE_ROW==sqlite3_step(stmt) )
+        sqlite3_result_text(context,
+            sqlite3_column_text(stmt, 0), -1, SQLITE_TRANSIENT);
+    else
+        sqlite3_result_error(context,
+            "SeSQLite - The requested id is not registered.", -1);
+
+    sqlite3_reset(stmt);
+}
+
+int create_security_context_column(
+    void *pArg, 
+    void *parse, 
+    int type, 
+    void *pNew, 
+    char **zColumn
+) {
+
+	Column *pCol;
+	char *zName = 0;
+	char *zType = 0;
+	int iDb = 0;
+	int i = 0;
+	int id = 0;
+	*zColumn = NULL;
+
+	sqlite3* db = (sqlite3*) pArg;
+	Parse *pParse = ((Vdbe*) sqlite3_next_stmt(db, 0))->pParse;
+	Table *p = pNew;
+
+	*zColumn = sqlite3MPrintf(db, SECURITY_CONTEXT_COLUMN_DEFINITION);
+	zName = sqlite3MPrintf(db, SECURITY_CONTEXT_COLUMN_NAME);
+	sqlite3Dequote(*zColumn);
+	sqlite3Dequote(zName);
+
+	iDb = sqlite3SchemaToIndex(db, p->pSchema);
+	pCol = &p->aCol[0];
+	for(i=1; i<p->nCol; i++){
+		if( STRICMP(zName, p->aCol[i].zName) ){
+			sqlite3ErrorMsg(pParse, "object name reserved for internal use: %s", zName);
+			sqlite3DbFree(db, zName);
+			sqlite3DbFree(db, *zColumn);
+			return SQLITE_ERROR;
+		}
+	}
+
+	if( (p->nCol & 0x7)==0 ){
+		Column *aNew;
+		aNew = sqlite3DbRealloc(db,p->aCol,(p->nCol+8)*sizeof(p->aCol[0]));
+		if( aNew==0 ){
+			sqlite3ErrorMsg(pParse, "memory error");
+			sqlite3DbFree(db, zName);
+			sqlite3DbFree(db, *zColumn);
+			return SQLITE_ERROR;
+		}
+		p->aCol = aNew;
+	}
+
+	pCol = &p->aCol[p->nCol];
+	memset(pCol, 0, sizeof(p->aCol[0]));
+	pCol->zName = zName;
+	p->nCol++;
+
+	zType = sqlite3MPrintf(db, SECURITY_CONTEXT_COLUMN_TYPE);
+	pCol->zType = sqlite3MPrintf(db, zType);
+	sqlite3DbFree(db, zType);
+	pCol->affinity = SQLITE_AFF_INTEGER;
+	pCol->colFlags |= COLFLAG_HIDDEN;
+
+	/* Get id */
+	id = get_key(db, pParse->db->aDb[iDb].zName, p->zName, NULL);
+	if( id==-1 ){
+		id = lookup_security_label(db,
+			SESQLITE_CONN(db)->stmt_insert,
+			hash_id,
+			0,
+			pParse->db->aDb[iDb].zName,
+			p->zName,
+			NULL
+		);
+		insert_key(db, pParse->db->aDb[iDb].zName, p->zName, NULL, id);
+	}
+
+	sqlite3NestedParse(pParse,
+		"INSERT INTO %Q.%s (security_context, security_label, db, name) VALUES(\
+		%d, %d,\
+		'%s',\
+		'%s')",
+		pParse->db->aDb[iDb].zName, SELINUX_CONTEXT,
+		sesqlite_local_id(db, pParse->db->aDb[iDb].zName,
+			lookup_security_context(hash_id, 
+				pParse->db->aDb[iDb].zName, 
+				SELINUX_CONTEXT)),
+		sesqlite_local_id(db, pParse->db->aDb[iDb].zName, id),
+		sesqlite_stored_db(db, pParse->db->aDb[iDb].zName), 
+		p->zName);
+	sqlite3ChangeCookie(pParse, iDb);
+
+
+	//add security context to columns
+	int iCol;
+	for (iCol = 0; iCol < p->nCol; iCol++) {
+
+		/* Get id */
+		id = get_key(db, pParse->db->aDb[iDb].zName, p->zName, p->aCol[iCol].zName);
+		if( id==-1 ){
+			id = lookup_security_label(db,
+				SESQLITE_CONN(db)->stmt_insert,
+				hash_id,
+				1,
+				pParse->db->aDb[iDb].zName,
+				p->zName,
+				p->aCol[iCol].zName
+			);
+			insert_key(db, pParse->db->aDb[iDb].zName, p->zName, p->aCol[iCol].zName, id);
+		}
+
+		sqlite3NestedParse(pParse,
+			"INSERT INTO %Q.%s(security_context, security_label, db, name, column) VALUES(\
+			%d, %d,\
+			'%s',\
+			'%s',\
+			'%s')",
+			pParse->db->aDb[iDb].zName, SELINUX_CONTEXT,
+			sesqlite_local_id(db, pParse->db->aDb[iDb].zName,
+				lookup_security_context(hash_id, 
+					pParse->db->aDb[iDb].zName, 
+					SELINUX_CONTEXT)),
+			sesqlite_local_id(db, pParse->db->aDb[iDb].zName, id),
+			sesqlite_stored_db(db, pParse->db->aDb[iDb].zName), 
+			p->zName, 
+			p->aCol[iCol].zName);
+
+	}
+	sqlite3ChangeCookie(pParse, iDb);
+
+	if(HasRowid(p)){
+		/* Get id */
+		id = get_key(db, pParse->db->aDb[iDb].zName, p->zName, "ROWID");
+		if( id==-1 ){
+			id = lookup_security_label(db,
+				SESQLITE_CONN(db)->stmt_insert,
+				hash_id,
+				1,
+				pParse->db->aDb[iDb].zName,
+				p->zName,
+				"ROWID"
+			);
+			insert_key(db, pParse->db->aDb[iDb].zName, p->zName, "ROWID", id);
+		}
+
+		sqlite3NestedParse(pParse,
+			"INSERT INTO %Q.%s(security_context, security_label, db, name, column) VALUES(\
+			%d, %d,\
+			'%s',\
+			'%s',\
+			'%s')",
+			pParse->db->aDb[iDb].zName, SELINUX_CONTEXT,
+			sesqlite_local_id(db, pParse->db->aDb[iDb].zName,
+				lookup_security_context(hash_id, 
+					pParse->db->aDb[iDb].zName, 
+					SELINUX_CONTEXT)),
+			sesqlite_local_id(db, pParse->db->aDb[iDb].zName, id),
+			sesqlite_stored_db(db, pParse->db->aDb[iDb].zName), p->zName, "ROWID");
+
+		sqlite3ChangeCookie(pParse, iDb);
+	}
+
+	return SQLITE_OK;
+}
+
+static int selinux_schemachange_callback(
+    void* pArg,                  /* the user argument (the db in our case) */
+    int op,                      /* the schema operation that triggered the callback */
+    const char* zDb,             /* the name of the database */
+    const char* zTable,          /* the name of the table */
+    void* arg1,                  /* arg1 depends on the op */
+    void* arg2                   /* arg2 depends on the op */
+){
+    sqlite3 *db = (sqlite3*) pArg;
+    Parse *pParse = ((Vdbe*) sqlite3_next_stmt(db, 0))->pParse;
+
+    switch( op ){
+
+    case SQLITE_SCHEMA_CREATE_TABLE:
+	break;
+
+    case SQLITE_SCHEMA_DROP_TABLE:
+	sqlite3NestedParse(pParse,
+	    "DELETE FROM %s.%s WHERE db = '%s' AND name = '%s'",
+	    zDb, SELINUX_CONTEXT, sesqlite_stored_db(db, zDb), zTable);
+	break;
+
+    case SQLITE_SCHEMA_ALTER_RENAME:
+	sqlite3NestedParse(pParse,
+	    "UPDATE %s.%s SET name = '%s' WHERE db = '%s' AND name = '%s'",
+	    zDb, SELINUX_CONTEXT, zTable, sesqlite_stored_db(db, zDb), arg1);
+	break;
+
+    case SQLITE_SCHEMA_ALTER_ADD:
+    	sqlite3NestedParse(pParse,
+    	  "INSERT INTO %s.%s(security_context, security_label, db, name, column) VALUES(\
+	    %d, %d,\
+	    '%s',\
+	    '%s',\
+	    '%s')",
+    	  zDb, SELINUX_CONTEXT,
+	  sesqlite_local_id(db, zDb,
+	      lookup_security_context(hash_id, 
+		  (char *) zDb, 
+		  SELINUX_CONTEXT)),
+	  sesqlite_local_id(db, zDb,
+	      lookup_security_label(db, 
+		  SESQLITE_CONN(db)->stmt_insert, 
+		  hash_id, 
+		  1, 
+		  (char *) zDb, 
+		  (char *) zTable, 
+		  arg1)),
+    	  sesqlite_stored_db(db, zDb), (char *) zTable, arg1);
+	break;
+
+    case SQLITE_SCHEMA_ATTACH:
+	/* the decisions cached by name (e.g. the scan guards) may refer to
+	 * a different database attached with the same name */
+	sesqlite_clearavc();
+	return sesqlite_attach(db, zDb);
+
+    case SQLITE_SCHEMA_DETACH:
+	sesqlite_clearavc();
+	sesqlite_detach(db, zDb);
+	break;
+    }
+
+    return SQLITE_OK;
+}
+
+void sesqlite_clearavc(){
+#ifdef USE_AVC
+    sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+    if( avc!=NULL )
+	memset(avc, AVC_UNKNOWN, nAvcRow * AVC_NSLOT);
+    avc_generation++;
+    sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+#endif
+    /* the statements kept by the cache were checked with the old decisions */
+    sesqlite_policy_changed();
+}
+
+unsigned int sesqlite_avc_generation(){
+#ifdef USE_AVC
+    return avc_generation;
+#else
+    return 0;
+#endif
+}
+
+int sesqlite_vtab_labeled(sqlite3 *db){
+    return db->xAddExtraColumn!=NULL && !is_vacuum(db);
+}
+
+int sesqlite_tuple_visible(sqlite3 *db, const char *zDb, int label){
+    int res = 0;
+    int id = sesqlite_global_id(db, zDb, label);
+    char *ttcon = NULL;
+
+    if( id==0 )
+	return 0; /* unknown label */
+
+#ifdef USE_AVC
+    res = avc_lookup(id, SELINUX_DB_TUPLE, SELINUX_SELECT);
+    if( res!=-1 )
+	return res;
+#endif
+
+    ttcon = sesqlite_label(id);
+    res = ( 0==selinux_check_access(
+	scon,
+	ttcon,
+	access_vector[SELINUX_DB_TUPLE].c_name,
+	"select",
+	NULL
+    ));
+
+#ifdef USE_AVC
+    avc_store(id, SELINUX_DB_TUPLE, SELINUX_SELECT, res);
+#endif
+    return res;
+}
+
+int selinux_commit_callback(void *pArg){
+    sqlite3 *db = (sqlite3*) pArg;
+    sesqlite_shm_commit(db);
+#if defined(USE_AVC) && defined(SQLITE_DEBUG)
+    fprintf(stdout, "Checking the policy after commit\n");
+#endif
+    /* a commit alone does not change the decisions, only a new policy does */
+    sesqlite_policy_check();
+    return 0;
+}
+
+void selinux_rollback_callback(void *pArg){
+    sqlite3 *db = (sqlite3*) pArg;
+    sesqlite_shm_rollback(db);
+#if defined(USE_AVC) && defined(SQLITE_DEBUG)
+    fprintf(stdout, "Checking the policy after rollback\n");
+#endif
+    /* a rollback alone does not change the decisions, only a new policy does */
+    sesqlite_policy_check();
+}
+
+int initialize_authorizer(sqlite3 *db){
+
+    int rc = SQLITE_OK;
+
+    rc =sqlite3_set_add_extra_column(db, create_security_context_column, db);
+    if (rc != SQLITE_OK)
+	return rc;
+
+    /* set the schemachange_callback */
+    sqlite3_schemachange_hook(db, selinux_schemachange_callback, db);
+
+    /* set the commit callback */
+    sqlite3_commit_hook(db, selinux_commit_callback, db);
+
+    /* set the rollback callback */
+    sqlite3_rollback_hook(db, selinux_rollback_callback, db);
+
+    /* create the SQL function selinux_check_access */
+    rc = sqlite3_create_function(db, "selinux_check_access", 4,
+	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxCheckAccessFunction,
+	0, 0);
+    if (rc != SQLITE_OK)
+	return rc;
+
+    /* selinux_check_access on a tuple of a given (possibly attached) db */
+    rc = sqlite3_create_function(db, "selinux_check_access", 5,
+	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxCheckAccessFunction,
+	0, 0);
+    if (rc != SQLITE_OK)
+	return rc;
+
+    /* create the SQL function getcon_id */
+    rc = sqlite3_create_function(db, "getcon_id", 1,
+	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxGetconIdFunction,
+	0, 0);
+    if (rc != SQLITE_OK)
+	return rc;
+
+    /* getcon_id(label, db) for tables of an attached db */
+    rc = sqlite3_create_function(db, "getcon_id", 2,
+	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxGetconIdFunction,
+	0, 0);
+    if (rc != SQLITE_OK)
+	return rc;
+
+    /* create the SQL function getcon_label */
+    rc = sqlite3_create_function(db, "getcon_label", 1,
+	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxGetconLabelFunction,
+	0, 0);
+    if (rc != SQLITE_OK)
+	return rc;
+
+    /* getcon_label(id, db) for tables of an attached db */
+    rc = sqlite3_create_function(db, "getcon_label", 2,
+	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxGetconLabelFunction,
+	0, 0);
+    if (rc != SQLITE_OK)
+	return rc;
+
+    /* set the authorizer */
+    rc = sqlite3_set_authorizer(db, selinuxAuthorizer, db);
+
+    return rc;
+}
+
+#endif /* !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX) */
@@ -0,0 +1,111 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include "sesqlite.h"
+
+#define SELINUX_COUNT "selinux_count"
+
+/*
+ * Number of rows of each table, split by the label of the rows. Only the
+ * tables enabled with "pragma labelcount" have rows in here.
+ *
+ * The security_context of a counter is the label it counts, so that the
+ * tuple-level checks hide the counters of the labels the subject can not
+ * select. The counters of a table the subject can not read are hidden by
+ * the term returned by sesqlite_count_guard.
+ */
+#define SELINUX_COUNT_TABLE \
+	"CREATE TABLE IF NOT EXISTS %Q." SELINUX_COUNT "(" \
+	" name TEXT," \
+	" label INT," \
+	" count INT," \
+	" security_context INT," \
+	" PRIMARY KEY(name, label)" \
+	");"
+
+/*
+ * The counters are kept up to date by three triggers on the table, named
+ * selinux_count_insert_<table>, selinux_count_delete_<table> and
+ * selinux_count_update_<table>.
+ */
+#define SELINUX_COUNT_TRIGGER "selinux_count_"
+
+/*
+ * Returns 1 if the counters of zDb.zTab can be used to answer a count(*)
+ * on the table, 0 otherwise.
+ */
+int sesqlite_count_enabled(
+	sqlite3 *db,
+	const char *zDb,
+	const char *zTab
+);
+
+/*
+ * Returns 1 while the connection computes the counters: the rows of the
+ * table are counted regardless of the tuple-level checks.
+ */
+int sesqlite_count_loading(sqlite3 *db);
+
+/* Releases the scan guards of the connection */
+void sesqlite_count_close(sqlite3 *db);
+
+/*
+ * Invoked while parsing a SELECT with no WHERE, GROUP BY, HAVING and LIMIT.
+ * If the query is "SELECT count(*) FROM t" and t has its counters enabled,
+ * pEList and pSrc are changed to sum the counters of selinux_count and the
+ * WHERE clause to use is returned. Otherwise returns NULL.
+ */
+Expr *sesqlite_count_rewrite(
+	Parse *pParse,
+	ExprList *pEList,
+	SrcList *pSrc
+);
+
+/*
+ * Invoked while parsing a SELECT for each table in the FROM clause. If the
+ * table has its counters enabled, returns a constant term for the WHERE
+ * clause which is false when the subject can not select any label of the
+ * rows of the table, so that the scan is skipped. If the table is
+ * selinux_count, referred to as zAlias in the query, returns a term which
+ * is false for the counters of the tables the subject can not read.
+ * Otherwise returns NULL.
+ */
+Expr *sesqlite_count_guard(
+	Parse *pParse,
+	const char *zDb,
+	const char *zTab,
+	const char *zAlias
+);
+
+/*
+ * Registers the SQL functions used by the rewritten queries.
+ */
+int initialize_count(sqlite3 *db);
+
+void selinux_labelcount_pragma(
+	void* pArg,
+	sqlite3 *db,
+	char *args
+);
+
+void selinux_nolabelcount_pragma(
+	void* pArg,
+	sqlite3 *db,
+	char *args
+);
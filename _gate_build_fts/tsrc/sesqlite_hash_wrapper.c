@@ -0,0 +1,26 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
+
+#include "sesqlite_hash_wrapper.h"
+#include "sesqlite_hash_impl.h"
+
+#endif /* !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX) */
+
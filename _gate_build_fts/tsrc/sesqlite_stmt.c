@@ -0,0 +1,266 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Prepared statement cache.
+ *
+ * Preparing a statement under SeSQLite is expensive: the authorizer checks
+ * every table and column it uses, and the SELECTs get the tuple-level
+ * checks in their WHERE clause. Applications often prepare the same SQL
+ * over and over, so the statements released with sqlite3_finalize are
+ * reset and kept by the connection, and a later sqlite3_prepare_v2 of the
+ * same text gets them back without parsing it again.
+ *
+ * The kept statements stay in the list of the connection (db->pVdbe), but
+ * sqlite3_next_stmt does not return them. A statement is used again only
+ * if it was not expired (e.g. by a schema change) and it was compiled
+ * under the current policy generation, see sesqlite_policy_changed. The
+ * generation changes when the kernel reports a new policy or new booleans
+ * (read from the SELinux status page, or from the netlink socket when the
+ * kernel has no status page) and when an object is relabeled, not at every
+ * commit.
+ * Only the queries and the DML prepared with sqlite3_prepare_v2 are kept:
+ * the other statements (e.g. the pragmas of SeSQLite) act while they are
+ * prepared, so parsing them again is not a waste.
+ */
+
+#if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
+
+#include <selinux/avc.h>
+
+#include "sesqlite_stmt.h"
+#include "sesqlite_init.h"
+#include "sesqlite_utils.h"
+
+/* A statement kept by the cache, linked in the LRU list of the connection */
+typedef struct kept_stmt kept_stmt;
+struct kept_stmt {
+	Vdbe *v;                   /* the statement, v->zSql is the hash key */
+	kept_stmt *pPrev;          /* more recently used */
+	kept_stmt *pNext;          /* less recently used */
+};
+
+/* incremented when the checks done at prepare time may have changed */
+static unsigned int policy_generation = 0;
+
+void sesqlite_policy_changed(void){
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+	policy_generation++;
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+}
+
+/* true while selinux_status_updated tells when the policy changes */
+static int policy_status = 0;
+
+void sesqlite_policy_open(void){
+	if( !policy_status )
+		policy_status = ( selinux_status_open(1)>=0 );
+}
+
+void sesqlite_policy_close(void){
+	if( policy_status )
+		selinux_status_close();
+	policy_status = 0;
+}
+
+void sesqlite_policy_check(void){
+	if( !policy_status || selinux_status_updated()!=0 )
+		sesqlite_clearavc();
+}
+
+unsigned int sqlite3SelinuxPolicy(void){
+	unsigned int generation;
+
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+	generation = policy_generation;
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+	return generation;
+}
+
+/*
+ * Returns 1 if the statement is a query or a DML statement, judging by its
+ * first keyword, 0 otherwise.
+ */
+static int is_cacheable(const char *zSql){
+	const unsigned char *z = (const unsigned char*) zSql;
+	int tokenType = TK_SPACE;
+
+	while( *z ){
+		z += sqlite3GetToken(z, &tokenType);
+		if( tokenType!=TK_SPACE ) break;
+	}
+
+	switch( tokenType ){
+	case TK_SELECT:
+	case TK_VALUES:
+	case TK_WITH:
+	case TK_INSERT:
+	case TK_REPLACE:
+	case TK_UPDATE:
+	case TK_DELETE:
+		return 1;
+	}
+	return 0;
+}
+
+static void lru_unlink(struct sesqlite_conn *pConn, kept_stmt *p){
+	if( p->pPrev ) p->pPrev->pNext = p->pNext;
+	else pConn->pLru = p->pNext;
+	if( p->pNext ) p->pNext->pPrev = p->pPrev;
+	p->pPrev = p->pNext = NULL;
+}
+
+/*
+ * Takes the statement out of the cache and frees the entry. The statement
+ * is returned, the caller either uses it or finalizes it.
+ */
+static Vdbe *unpark(struct sesqlite_conn *pConn, kept_stmt *p){
+	Vdbe *v = p->v;
+
+	lru_unlink(pConn, p);
+	sqlite3HashInsert(&pConn->stmts, v->zSql, sqlite3Strlen30(v->zSql), 0);
+	sqlite3_free(p);
+	pConn->nStmt--;
+	v->isParked = 0;
+	return v;
+}
+
+/* Finalizes the least recently used statements above the size limit */
+static void shrink(struct sesqlite_conn *pConn, int mxStmt){
+	kept_stmt *pLast = pConn->pLru;
+
+	while( pLast && pLast->pNext )
+		pLast = pLast->pNext;
+
+	while( pLast && pConn->nStmt>mxStmt ){
+		kept_stmt *pPrev = pLast->pPrev;
+		sqlite3VdbeFinalize(unpark(pConn, pLast));
+		pLast = pPrev;
+	}
+}
+
+int sqlite3SelinuxStmtPark(sqlite3 *db, sqlite3_stmt *pStmt, int *pRc){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	Vdbe *v = (Vdbe*) pStmt;
+	kept_stmt *p;
+	int nSql;
+
+	assert( sqlite3_mutex_held(db->mutex) );
+	if( pConn==NULL || pConn->mxStmt<=0 || db->magic!=SQLITE_MAGIC_OPEN )
+		return 0;
+
+	/* the statements that depend on their bindings are never reused */
+	if( !v->isPrepareV2 || v->zSql==NULL || v->expired || v->runOnlyOnce
+	    || v->expmask || v->iPolicy!=sqlite3SelinuxPolicy()
+	    || !is_cacheable(v->zSql) )
+		return 0;
+
+	/* a copy of the same SQL is already kept */
+	nSql = sqlite3Strlen30(v->zSql);
+	if( sqlite3HashFind(&pConn->stmts, v->zSql, nSql)!=NULL )
+		return 0;
+
+	p = sqlite3_malloc(sizeof(kept_stmt));
+	if( p==NULL )
+		return 0;
+	p->v = v;
+	if( sqlite3HashInsert(&pConn->stmts, v->zSql, nSql, p)==p ){
+		sqlite3_free(p);
+		return 0;
+	}
+
+	/* the statement looks finalized to the application */
+	*pRc = sqlite3VdbeReset(v);
+	sqlite3VdbeRewind(v);
+	sqlite3_clear_bindings(pStmt);
+	v->isParked = 1;
+
+	p->pPrev = NULL;
+	p->pNext = pConn->pLru;
+	if( p->pNext ) p->pNext->pPrev = p;
+	pConn->pLru = p;
+	pConn->nStmt++;
+
+	shrink(pConn, pConn->mxStmt);
+	return 1;
+}
+
+sqlite3_stmt *sqlite3SelinuxStmtLookup(
+	sqlite3 *db,
+	const char *zSql,
+	int nBytes,
+	const char **pzTail
+){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	kept_stmt *p;
+	Vdbe *v;
+	int n = 0;
+
+	assert( sqlite3_mutex_held(db->mutex) );
+	if( pConn==NULL || pConn->nStmt==0 || zSql==NULL )
+		return NULL;
+
+	while( (nBytes<0 || n<nBytes) && zSql[n] )
+		n++;
+
+	/* the keys of the hash are compared ignoring the case */
+	p = sqlite3HashFind(&pConn->stmts, zSql, n);
+	if( p==NULL || memcmp(p->v->zSql, zSql, n)!=0 )
+		return NULL;
+
+	/* the policy may have been reloaded since the last commit */
+	if( policy_status && selinux_status_updated()!=0 )
+		sesqlite_clearavc();
+
+	v = unpark(pConn, p);
+	if( v->expired || v->iPolicy!=sqlite3SelinuxPolicy() ){
+		sqlite3VdbeFinalize(v);
+		return NULL;
+	}
+
+	if( pzTail ) *pzTail = &zSql[n];
+	return (sqlite3_stmt*) v;
+}
+
+void sesqlite_stmt_close(sqlite3 *db){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+
+	shrink(pConn, 0);
+	sqlite3HashClear(&pConn->stmts);
+}
+
+void selinux_stmtcache_pragma(
+	void* pArg,
+	sqlite3 *db,
+	char *args
+){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	char *zSave = NULL;
+	char *zSize = strtok_r(args, " ", &zSave);
+
+	CHECK_WRONG_USAGE( zSize==NULL || MORE_TOKENS(zSave)
+		|| !sqlite3Isdigit(zSize[0]),
+		"USAGE: pragma stmtcache(\"N\")\n" );
+
+	pConn->mxStmt = atoi(zSize);
+	shrink(pConn, pConn->mxStmt);
+	fprintf(stdout, "%d statements kept.\n", pConn->mxStmt);
+}
+
+#endif /* !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX) */
@@ -0,0 +1,96 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/* SeSqlite extension to add SELinux checks in SQLite */
+
+#if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
+
+#include "sesqlite_utils.h"
+#include "sesqlite.h"
+
+/*
+ * Print messages for SeSQLite.
+ */
+void sesqlite_print(
+	const char *before,
+	const char *dbName,
+	const char *tblName,
+	const char *colName,
+	const char *after
+){
+	fprintf(stdout, "SeSQLite: ");
+
+	if( before )  fprintf(stdout, "%s ", before);
+	if( dbName )  fprintf(stdout, "db=%s ", dbName);
+	if( tblName ) fprintf(stdout, "table=%s ", tblName);
+	if( colName ) fprintf(stdout, "column=%s ", colName);
+	if( after )   fprintf(stdout, "%s\n", after);
+}
+
+/*
+ * Makes the key based on the database, the table and the column.
+ * The user must invoke free on the returned pointer to free the memory.
+ * It returns db:tbl:col if the column is not NULL, otherwise db:tbl.
+ */
+char *make_key(
+	const char *dbName,
+	const char *tblName,
+	const char *colName
+){
+	char *key;
+
+	if( tblName==NULL )
+		key = sqlite3_mprintf("%s", dbName);
+	else if( colName==NULL )
+		key = sqlite3_mprintf("%s:%s", dbName, tblName);
+	else
+		key = sqlite3_mprintf("%s:%s:%s", dbName, tblName, colName);
+
+	return key;
+}
+
+static sqlite3_mutex *aMutex[SESQLITE_NMUTEX];
+
+int sesqlite_mutex_init(void){
+	sqlite3_mutex *pMaster = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_MASTER);
+	int rc = SQLITE_OK;
+	int i;
+
+	sqlite3_mutex_enter(pMaster);
+	for( i = 0; i<SESQLITE_NMUTEX && rc==SQLITE_OK; i++ ){
+		if( aMutex[i]!=NULL )
+			continue;
+		/* the label functions call each other while holding the mutex */
+		aMutex[i] = sqlite3_mutex_alloc(i==SESQLITE_MUTEX_AVC
+			? SQLITE_MUTEX_FAST : SQLITE_MUTEX_RECURSIVE);
+		if( aMutex[i]==NULL && sqlite3_threadsafe() )
+			rc = SQLITE_NOMEM;
+	}
+	sqlite3_mutex_leave(pMaster);
+
+	return rc;
+}
+
+sqlite3_mutex *sesqlite_mutex(int id){
+	assert( id>=0 && id<SESQLITE_NMUTEX );
+	return aMutex[id];
+}
+
+#endif
+
@@ -0,0 +1,278 @@
+/*
+** 2014 June 9
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+**
+** This file contains the background checkpointer used when the
+** "PRAGMA wal_checkpoint_thread" setting of a WAL database is non-zero.
+**
+** Without it, the connection that commits the transaction that takes the
+** WAL file over the wal_autocheckpoint threshold runs the checkpoint
+** before its COMMIT returns. The background checkpointer instead runs
+** PASSIVE checkpoints from a thread of its own. Commits only signal the
+** thread, passing it the size of the WAL.
+**
+** The thread does not use the pager of the connection that started it.
+** It opens a second file handle on the database, holding a SHARED lock on
+** it as every WAL connection does, and a second Wal object on the same
+** WAL and wal-index files. Apart from the WAL_CKPT_LOCK taken by each
+** checkpoint, it takes no locks that could block readers or writers.
+**
+** If a checkpoint can not copy every frame in the WAL into the database,
+** because readers are still using older snapshots, or if another
+** connection is running a checkpoint, the thread backs off before it
+** tries again. The delay is doubled each time, up to WALCKPT_MAX_DELAY.
+**
+** Background checkpoints require pthreads. In other builds, and if SQLite
+** was started without mutexes, sqlite3WalCkptOpen() does not create a
+** checkpointer and the caller goes on checkpointing inline.
+*/
+#include "sqliteInt.h"
+#include "wal.h"
+
+#if !defined(SQLITE_OMIT_WAL) && SQLITE_MAX_WORKER_THREADS>0 \
+ && SQLITE_OS_UNIX && defined(SQLITE_MUTEX_PTHREADS) && SQLITE_THREADSAFE>0
+
+#include <pthread.h>
+#include <errno.h>
+#include <sys/time.h>
+
+/*
+** Smallest and largest delay, in milliseconds, before the thread retries
+** a checkpoint that could not copy the whole WAL.
+*/
+#define WALCKPT_MIN_DELAY   10
+#define WALCKPT_MAX_DELAY 1000
+
+/*
+** A background checkpointer. The fields following the mutex may only be
+** used while holding it.
+*/
+struct WalCkpt {
+  sqlite3_vfs *pVfs;              /* VFS used to open the database */
+  sqlite3_file *pDbFd;            /* Checkpointer's handle on the db file */
+  Wal *pWal;                      /* Checkpointer's handle on the WAL */
+  int szPage;                     /* Database page size */
+  int syncFlags;                  /* Flags to sync the database file with */
+  u8 *aBuf;                       /* Buffer of szPage bytes */
+  pthread_t tid;                  /* Checkpointer thread */
+  pthread_mutex_t mutex;          /* Mutex protecting the following */
+  pthread_cond_t cond;            /* Signalled by commits and on close */
+  int bStop;                      /* Set to ask the thread to exit */
+  int nFrame;                     /* Checkpoint once the WAL is this large */
+  int nPending;                   /* Size of the WAL at the last commit */
+  int aStat[WALCKPT_NSTAT];       /* Values for sqlite3WalCkptStatus() */
+};
+
+/*
+** Wait for up to nMs milliseconds, or until the checkpointer is closed.
+** The mutex must be held.
+*/
+static void walCkptSleep(WalCkpt *p, int nMs){
+  struct timeval now;
+  struct timespec ts;
+  i64 iUs;
+  gettimeofday(&now, 0);
+  iUs = now.tv_usec + (i64)nMs*1000;
+  ts.tv_sec = now.tv_sec + (time_t)(iUs/1000000);
+  ts.tv_nsec = (long)(iUs%1000000)*1000;
+  while( !p->bStop ){
+    if( pthread_cond_timedwait(&p->cond, &p->mutex, &ts)==ETIMEDOUT ) break;
+  }
+}
+
+/*
+** The body of the checkpointer thread.
+*/
+static void *walCkptMain(void *pCtx){
+  WalCkpt *p = (WalCkpt*)pCtx;
+  int nDelay = 0;                 /* Current backoff, or 0 */
+
+  pthread_mutex_lock(&p->mutex);
+  while( !p->bStop ){
+    int rc;
+    int nLog = 0;
+    int nCkpt = 0;
+
+    if( nDelay ){
+      walCkptSleep(p, nDelay);
+      if( p->bStop ) break;
+    }else if( p->nPending<p->nFrame ){
+      pthread_cond_wait(&p->cond, &p->mutex);
+      continue;
+    }
+    p->nPending = 0;
+    pthread_mutex_unlock(&p->mutex);
+
+    rc = sqlite3WalCheckpoint(p->pWal, SQLITE_CHECKPOINT_PASSIVE, 0, 0,
+        p->syncFlags, p->szPage, p->aBuf, &nLog, &nCkpt
+    );
+
+    pthread_mutex_lock(&p->mutex);
+    p->aStat[WALCKPT_STAT_RUN]++;
+    if( rc==SQLITE_OK ){
+      p->aStat[WALCKPT_STAT_LOG] = nLog;
+      p->aStat[WALCKPT_STAT_CKPT] = nCkpt;
+    }
+    if( rc!=SQLITE_OK || nCkpt<nLog ){
+      p->aStat[WALCKPT_STAT_BACKOFF]++;
+      nDelay = nDelay ? MIN(nDelay*2, WALCKPT_MAX_DELAY) : WALCKPT_MIN_DELAY;
+    }else{
+      nDelay = 0;
+    }
+  }
+  pthread_mutex_unlock(&p->mutex);
+  return 0;
+}
+
+/*
+** Release the resources held by a checkpointer whose thread is not
+** running.
+*/
+static void walCkptFree(WalCkpt *p){
+  sqlite3WalClose(p->pWal, 0, 0, 0);
+  if( p->pDbFd ) sqlite3OsCloseFree(p->pDbFd);
+  sqlite3PageFree(p->aBuf);
+  pthread_cond_destroy(&p->cond);
+  pthread_mutex_destroy(&p->mutex);
+  sqlite3_free(p);
+}
+
+/*
+** Start a background checkpointer for the database zDb, which must be
+** in WAL mode. The caller must hold a SHARED lock on zDb so that it can
+** not be taken out of WAL mode while this function runs.
+*/
+int sqlite3WalCkptOpen(
+  sqlite3_vfs *pVfs,              /* VFS used to open the database */
+  const char *zDb,                /* Database file name */
+  const char *zWal,               /* WAL file name */
+  int bWal2,                      /* True for a wal2 mode database */
+  int szPage,                     /* Database page size */
+  int sync_flags,                 /* Flags to sync db file with (or 0) */
+  int nFrame,                     /* Checkpoint once the WAL is this large */
+  WalCkpt **ppCkpt                /* OUT: New checkpointer */
+){
+  WalCkpt *p;
+  int rc;
+
+  *ppCkpt = 0;
+  if( sqlite3GlobalConfig.bCoreMutex==0 ) return SQLITE_OK;
+
+  p = (WalCkpt*)sqlite3MallocZero(sizeof(WalCkpt));
+  if( p==0 ) return SQLITE_NOMEM;
+  pthread_mutex_init(&p->mutex, 0);
+  pthread_cond_init(&p->cond, 0);
+  p->pVfs = pVfs;
+  p->szPage = szPage;
+  p->syncFlags = sync_flags;
+  p->nFrame = nFrame;
+  p->aBuf = (u8*)sqlite3PageMalloc(szPage);
+  if( p->aBuf==0 ){
+    rc = SQLITE_NOMEM;
+  }else{
+    rc = sqlite3OsOpenMalloc(pVfs, zDb, &p->pDbFd,
+        SQLITE_OPEN_READWRITE|SQLITE_OPEN_MAIN_DB, 0
+    );
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3OsLock(p->pDbFd, SQLITE_LOCK_SHARED);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3WalOpen(pVfs, p->pDbFd, zWal, 0, bWal2, -1, &p->pWal);
+  }
+  if( rc==SQLITE_OK ){
+    /* Map the wal-index, which sqlite3WalCheckpoint() expects to have
+    ** been done by an earlier read transaction. */
+    int isChanged = 0;
+    rc = sqlite3WalBeginReadTransaction(p->pWal, &isChanged);
+    sqlite3WalEndReadTransaction(p->pWal);
+  }
+  if( rc==SQLITE_OK && pthread_create(&p->tid, 0, walCkptMain, (void*)p) ){
+    rc = SQLITE_ERROR;
+  }
+  if( rc!=SQLITE_OK ){
+    walCkptFree(p);
+    return rc;
+  }
+  *ppCkpt = p;
+  return SQLITE_OK;
+}
+
+/*
+** Stop the checkpointer thread and free the checkpointer. A checkpoint
+** that is already running is completed first.
+*/
+void sqlite3WalCkptClose(WalCkpt *p){
+  if( p ){
+    void *pOut;
+    pthread_mutex_lock(&p->mutex);
+    p->bStop = 1;
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+    pthread_join(p->tid, &pOut);
+    walCkptFree(p);
+  }
+}
+
+/*
+** Change the WAL size at which the thread runs a checkpoint.
+*/
+void sqlite3WalCkptLimit(WalCkpt *p, int nFrame){
+  pthread_mutex_lock(&p->mutex);
+  p->nFrame = nFrame;
+  pthread_mutex_unlock(&p->mutex);
+}
+
+/*
+** Called after each commit with the number of frames in the WAL. Wake
+** the thread if this reaches the threshold.
+*/
+void sqlite3WalCkptNotify(WalCkpt *p, int nFrame){
+  pthread_mutex_lock(&p->mutex);
+  p->nPending = nFrame;
+  if( nFrame>=p->nFrame ) pthread_cond_signal(&p->cond);
+  pthread_mutex_unlock(&p->mutex);
+}
+
+/*
+** Copy the WALCKPT_NSTAT statistics of the checkpointer into aStat[].
+*/
+void sqlite3WalCkptStatus(WalCkpt *p, int *aStat){
+  pthread_mutex_lock(&p->mutex);
+  memcpy(aStat, p->aStat, sizeof(p->aStat));
+  pthread_mutex_unlock(&p->mutex);
+}
+
+#elif !defined(SQLITE_OMIT_WAL)
+
+/*
+** No thread support. Checkpoints are always run by the committing
+** connection.
+*/
+int sqlite3WalCkptOpen(
+  sqlite3_vfs *pVfs,
+  const char *zDb,
+  const char *zWal,
+  int bWal2,
+  int szPage,
+  int sync_flags,
+  int nFrame,
+  WalCkpt **ppCkpt
+){
+  *ppCkpt = 0;
+  return SQLITE_OK;
+}
+void sqlite3WalCkptClose(WalCkpt *p){ assert( p==0 ); }
+void sqlite3WalCkptLimit(WalCkpt *p, int nFrame){ }
+void sqlite3WalCkptNotify(WalCkpt *p, int nFrame){ }
+void sqlite3WalCkptStatus(WalCkpt *p, int *aStat){ }
+
+#endif
@@ -0,0 +1,275 @@
+/***** This file contains automatically generated code ******
+**
+** The code in this file has been automatically generated by
+**
+**   sqlite/tool/mkkeywordhash.c
+**
+** The code in this file implements a function that determines whether
+** or not a given identifier is really an SQL keyword.  The same thing
+** might be implemented more directly using a hand-written hash table.
+** But by using this automatically generated code, the size of the code
+** is substantially reduced.  This is important for embedded applications
+** on platforms with limited memory.
+*/
+/* Hash score: 184 */
+static int keywordCode(const char *z, int n){
+  /* zText[] encodes 845 bytes of keywords in 556 bytes */
+  /*   CONCURRENT_DATEMPORARYREINDEXEDESCAPEACHECKEYBEFOREIGNOREGEXP      */
+  /*   LAINSTEADDATABASELECTABLEFTHENDEFERRABLELSEXCEPTRANSACTION         */
+  /*   ATURALTERAISEXCLUSIVEXISTSAVEPOINTERSECTRIGGEREFERENCES            */
+  /*   CONSTRAINTOFFSETUNIQUERYWITHOUTERELEASEATTACHAVINGROUPDATE         */
+  /*   BEGINNERECURSIVEBETWEENOTNULLIKECASCADELETECASECOLLATECREATE       */
+  /*   DETACHIMMEDIATEJOINSERTMATCHPLANALYZEPRAGMABORTVALUESVIRTUAL       */
+  /*   IMITWHENWHERENAMEAFTEREPLACEANDEFAULTAUTOINCREMENTCASTCOLUMN       */
+  /*   COMMITCONFLICTCROSSCURRENT_TIMESTAMPRIMARYDEFERREDISTINCTDROP      */
+  /*   FAILFROMFULLGLOBYIFISNULLORDERESTRICTRIGHTROLLBACKROWUNION         */
+  /*   USINGVACUUMVIEWINITIALLY                                           */
+  static const char zText[555] = {
+    'C','O','N','C','U','R','R','E','N','T','_','D','A','T','E','M','P','O',
+    'R','A','R','Y','R','E','I','N','D','E','X','E','D','E','S','C','A','P',
+    'E','A','C','H','E','C','K','E','Y','B','E','F','O','R','E','I','G','N',
+    'O','R','E','G','E','X','P','L','A','I','N','S','T','E','A','D','D','A',
+    'T','A','B','A','S','E','L','E','C','T','A','B','L','E','F','T','H','E',
+    'N','D','E','F','E','R','R','A','B','L','E','L','S','E','X','C','E','P',
+    'T','R','A','N','S','A','C','T','I','O','N','A','T','U','R','A','L','T',
+    'E','R','A','I','S','E','X','C','L','U','S','I','V','E','X','I','S','T',
+    'S','A','V','E','P','O','I','N','T','E','R','S','E','C','T','R','I','G',
+    'G','E','R','E','F','E','R','E','N','C','E','S','C','O','N','S','T','R',
+    'A','I','N','T','O','F','F','S','E','T','U','N','I','Q','U','E','R','Y',
+    'W','I','T','H','O','U','T','E','R','E','L','E','A','S','E','A','T','T',
+    'A','C','H','A','V','I','N','G','R','O','U','P','D','A','T','E','B','E',
+    'G','I','N','N','E','R','E','C','U','R','S','I','V','E','B','E','T','W',
+    'E','E','N','O','T','N','U','L','L','I','K','E','C','A','S','C','A','D',
+    'E','L','E','T','E','C','A','S','E','C','O','L','L','A','T','E','C','R',
+    'E','A','T','E','D','E','T','A','C','H','I','M','M','E','D','I','A','T',
+    'E','J','O','I','N','S','E','R','T','M','A','T','C','H','P','L','A','N',
+    'A','L','Y','Z','E','P','R','A','G','M','A','B','O','R','T','V','A','L',
+    'U','E','S','V','I','R','T','U','A','L','I','M','I','T','W','H','E','N',
+    'W','H','E','R','E','N','A','M','E','A','F','T','E','R','E','P','L','A',
+    'C','E','A','N','D','E','F','A','U','L','T','A','U','T','O','I','N','C',
+    'R','E','M','E','N','T','C','A','S','T','C','O','L','U','M','N','C','O',
+    'M','M','I','T','C','O','N','F','L','I','C','T','C','R','O','S','S','C',
+    'U','R','R','E','N','T','_','T','I','M','E','S','T','A','M','P','R','I',
+    'M','A','R','Y','D','E','F','E','R','R','E','D','I','S','T','I','N','C',
+    'T','D','R','O','P','F','A','I','L','F','R','O','M','F','U','L','L','G',
+    'L','O','B','Y','I','F','I','S','N','U','L','L','O','R','D','E','R','E',
+    'S','T','R','I','C','T','R','I','G','H','T','R','O','L','L','B','A','C',
+    'K','R','O','W','U','N','I','O','N','U','S','I','N','G','V','A','C','U',
+    'U','M','V','I','E','W','I','N','I','T','I','A','L','L','Y',
+  };
+  static const unsigned char aHash[127] = {
+      77, 106, 118,  75,   0,   4,   0,   0,  83,   0,  78,   0,   0,
+      47,  17,  79,  20,   0, 117,  86,  56, 113,   0,  24,   0,   0,
+     122,   0, 120, 116,   0,  27,  94,   0,  14,   0,   0,  72,  73,
+       0,  71,  11,   0,  50,  91, 103,   0, 119, 102,   0,   0,  38,
+       0, 104,  29,   0,  22,   0, 123,  55,  28,   0,  10, 111,  30,
+      97,   0,   0, 125, 107,  62, 124,  59,  33,  57,   0,  92,   0,
+     101,  31,   0, 100,   0,   0,   0,  96,  93,  98,  89, 110,  19,
+      44, 109,   0,  82,   0,  23,  90, 112,  37,   0, 121,  81, 114,
+      64,  26,  85,   0,   0,  95,  45,  61, 115,   0,  41,   0,   0,
+      34,   0,  87,  65,  66,   0,  25,  63,   0,  58,
+  };
+  static const unsigned char aNext[125] = {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   9,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   7,   0,   0,   0,   0,   0,   5,
+      18,   0,   0,   0,   0,   0,  12,   0,   0,   0,   0,   3,   0,
+       0,   0,   0,   0,   1,   0,   0,   0,   0,   0,   0,   0,   0,
+       0,  52,   0,  48,   8,  49,   0,   0,   0,   0,  35,   0,  60,
+       0,  43,   0,   0,   0,   6,  68,   0,  69,   0,  46,   0,   0,
+       0,   0,   0,   0,  51,  67,   0,   0,   0,   0,  36,  54,  21,
+      39,  15,   0,   0,   0,   0,   0,   0,   0,  16,   2,  80,   0,
+      13,   0, 105,  99,   0, 108,   0,  88,   0,  76,  53,   0,  32,
+      42,  74,  84,   0,  40,  70,   0,   0,
+  };
+  static const unsigned char aLen[125] = {
+      10,  12,   9,   4,   2,   7,   7,   5,   4,   6,   4,   5,   3,
+       6,   7,   3,   6,   6,   7,   7,   3,   8,   2,   6,   5,   4,
+       4,   3,  10,   4,   6,  11,   6,   2,   7,   5,   5,   9,   6,
+       9,   9,   7,  10,  10,   4,   6,   2,   3,   6,   5,   7,   4,
+       5,   7,   6,   6,   5,   6,   5,   5,   9,   7,   7,   3,   2,
+       4,   4,   7,   3,   6,   4,   7,   6,   6,   9,   4,   6,   5,
+       4,   7,   6,   5,   6,   7,   5,   4,   5,   6,   5,   7,   3,
+       7,  13,   2,   2,   4,   6,   6,   8,   5,  17,  12,   7,   8,
+       8,   2,   4,   4,   4,   4,   4,   2,   2,   6,   5,   8,   5,
+       8,   3,   5,   5,   6,   4,   9,   3,
+  };
+  static const unsigned short int aOffset[125] = {
+       0,   3,  13,  13,  17,  22,  24,  24,  30,  31,  36,  38,  42,
+      45,  47,  47,  51,  55,  58,  63,  68,  70,  75,  76,  81,  84,
+      87,  89,  91, 100, 103, 108, 113, 117, 118, 123, 127, 131, 139,
+     144, 150, 158, 164, 174, 181, 184, 184, 187, 190, 193, 198, 198,
+     202, 206, 213, 218, 223, 226, 232, 235, 239, 248, 254, 254, 254,
+     257, 260, 264, 265, 269, 275, 279, 286, 292, 298, 307, 309, 315,
+     320, 322, 329, 334, 339, 345, 351, 356, 360, 363, 369, 373, 380,
+     382, 389, 391, 393, 402, 406, 412, 418, 426, 431, 431, 447, 454,
+     461, 462, 469, 473, 477, 481, 485, 488, 490, 492, 498, 502, 510,
+     515, 523, 526, 531, 536, 542, 546, 551,
+  };
+  static const unsigned char aCode[125] = {
+    TK_CONCURRENT, TK_CTIME_KW,   TK_TEMP,       TK_TEMP,       TK_OR,         
+    TK_REINDEX,    TK_INDEXED,    TK_INDEX,      TK_DESC,       TK_ESCAPE,     
+    TK_EACH,       TK_CHECK,      TK_KEY,        TK_BEFORE,     TK_FOREIGN,    
+    TK_FOR,        TK_IGNORE,     TK_LIKE_KW,    TK_EXPLAIN,    TK_INSTEAD,    
+    TK_ADD,        TK_DATABASE,   TK_AS,         TK_SELECT,     TK_TABLE,      
+    TK_JOIN_KW,    TK_THEN,       TK_END,        TK_DEFERRABLE, TK_ELSE,       
+    TK_EXCEPT,     TK_TRANSACTION,TK_ACTION,     TK_ON,         TK_JOIN_KW,    
+    TK_ALTER,      TK_RAISE,      TK_EXCLUSIVE,  TK_EXISTS,     TK_SAVEPOINT,  
+    TK_INTERSECT,  TK_TRIGGER,    TK_REFERENCES, TK_CONSTRAINT, TK_INTO,       
+    TK_OFFSET,     TK_OF,         TK_SET,        TK_UNIQUE,     TK_QUERY,      
+    TK_WITHOUT,    TK_WITH,       TK_JOIN_KW,    TK_RELEASE,    TK_ATTACH,     
+    TK_HAVING,     TK_GROUP,      TK_UPDATE,     TK_BEGIN,      TK_JOIN_KW,    
+    TK_RECURSIVE,  TK_BETWEEN,    TK_NOTNULL,    TK_NOT,        TK_NO,         
+    TK_NULL,       TK_LIKE_KW,    TK_CASCADE,    TK_ASC,        TK_DELETE,     
+    TK_CASE,       TK_COLLATE,    TK_CREATE,     TK_DETACH,     TK_IMMEDIATE,  
+    TK_JOIN,       TK_INSERT,     TK_MATCH,      TK_PLAN,       TK_ANALYZE,    
+    TK_PRAGMA,     TK_ABORT,      TK_VALUES,     TK_VIRTUAL,    TK_LIMIT,      
+    TK_WHEN,       TK_WHERE,      TK_RENAME,     TK_AFTER,      TK_REPLACE,    
+    TK_AND,        TK_DEFAULT,    TK_AUTOINCR,   TK_TO,         TK_IN,         
+    TK_CAST,       TK_COLUMNKW,   TK_COMMIT,     TK_CONFLICT,   TK_JOIN_KW,    
+    TK_CTIME_KW,   TK_CTIME_KW,   TK_PRIMARY,    TK_DEFERRED,   TK_DISTINCT,   
+    TK_IS,         TK_DROP,       TK_FAIL,       TK_FROM,       TK_JOIN_KW,    
+    TK_LIKE_KW,    TK_BY,         TK_IF,         TK_ISNULL,     TK_ORDER,      
+    TK_RESTRICT,   TK_JOIN_KW,    TK_ROLLBACK,   TK_ROW,        TK_UNION,      
+    TK_USING,      TK_VACUUM,     TK_VIEW,       TK_INITIALLY,  TK_ALL,        
+  };
+  int h, i;
+  if( n<2 ) return TK_ID;
+  h = ((charMap(z[0])*4) ^
+      (charMap(z[n-1])*3) ^
+      n) % 127;
+  for(i=((int)aHash[h])-1; i>=0; i=((int)aNext[i])-1){
+    if( aLen[i]==n && sqlite3StrNICmp(&zText[aOffset[i]],z,n)==0 ){
+      testcase( i==0 ); /* CONCURRENT */
+      testcase( i==1 ); /* CURRENT_DATE */
+      testcase( i==2 ); /* TEMPORARY */
+      testcase( i==3 ); /* TEMP */
+      testcase( i==4 ); /* OR */
+      testcase( i==5 ); /* REINDEX */
+      testcase( i==6 ); /* INDEXED */
+      testcase( i==7 ); /* INDEX */
+      testcase( i==8 ); /* DESC */
+      testcase( i==9 ); /* ESCAPE */
+      testcase( i==10 ); /* EACH */
+      testcase( i==11 ); /* CHECK */
+      testcase( i==12 ); /* KEY */
+      testcase( i==13 ); /* BEFORE */
+      testcase( i==14 ); /* FOREIGN */
+      testcase( i==15 ); /* FOR */
+      testcase( i==16 ); /* IGNORE */
+      testcase( i==17 ); /* REGEXP */
+      testcase( i==18 ); /* EXPLAIN */
+      testcase( i==19 ); /* INSTEAD */
+      testcase( i==20 ); /* ADD */
+      testcase( i==21 ); /* DATABASE */
+      testcase( i==22 ); /* AS */
+      testcase( i==23 ); /* SELECT */
+      testcase( i==24 ); /* TABLE */
+      testcase( i==25 ); /* LEFT */
+      testcase( i==26 ); /* THEN */
+      testcase( i==27 ); /* END */
+      testcase( i==28 ); /* DEFERRABLE */
+      testcase( i==29 ); /* ELSE */
+      testcase( i==30 ); /* EXCEPT */
+      testcase( i==31 ); /* TRANSACTION */
+      testcase( i==32 ); /* ACTION */
+      testcase( i==33 ); /* ON */
+      testcase( i==34 ); /* NATURAL */
+      testcase( i==35 ); /* ALTER */
+      testcase( i==36 ); /* RAISE */
+      testcase( i==37 ); /* EXCLUSIVE */
+      testcase( i==38 ); /* EXISTS */
+      testcase( i==39 ); /* SAVEPOINT */
+      testcase( i==40 ); /* INTERSECT */
+      testcase( i==41 ); /* TRIGGER */
+      testcase( i==42 ); /* REFERENCES */
+      testcase( i==43 ); /* CONSTRAINT */
+      testcase( i==44 ); /* INTO */
+      testcase( i==45 ); /* OFFSET */
+      testcase( i==46 ); /* OF */
+      testcase( i==47 ); /* SET */
+      testcase( i==48 ); /* UNIQUE */
+      testcase( i==49 ); /* QUERY */
+      testcase( i==50 ); /* WITHOUT */
+      testcase( i==51 ); /* WITH */
+      testcase( i==52 ); /* OUTER */
+      testcase( i==53 ); /* RELEASE */
+      testcase( i==54 ); /* ATTACH */
+      testcase( i==55 ); /* HAVING */
+      testcase( i==56 ); /* GROUP */
+      testcase( i==57 ); /* UPDATE */
+      testcase( i==58 ); /* BEGIN */
+      testcase( i==59 ); /* INNER */
+      testcase( i==60 ); /* RECURSIVE */
+      testcase( i==61 ); /* BETWEEN */
+      testcase( i==62 ); /* NOTNULL */
+      testcase( i==63 ); /* NOT */
+      testcase( i==64 ); /* NO */
+      testcase( i==65 ); /* NULL */
+      testcase( i==66 ); /* LIKE */
+      testcase( i==67 ); /* CASCADE */
+      testcase( i==68 ); /* ASC */
+      testcase( i==69 ); /* DELETE */
+      testcase( i==70 ); /* CASE */
+      testcase( i==71 ); /* COLLATE */
+      testcase( i==72 ); /* CREATE */
+      testcase( i==73 ); /* DETACH */
+      testcase( i==74 ); /* IMMEDIATE */
+      testcase( i==75 ); /* JOIN */
+      testcase( i==76 ); /* INSERT */
+      testcase( i==77 ); /* MATCH */
+      testcase( i==78 ); /* PLAN */
+      testcase( i==79 ); /* ANALYZE */
+      testcase( i==80 ); /* PRAGMA */
+      testcase( i==81 ); /* ABORT */
+      testcase( i==82 ); /* VALUES */
+      testcase( i==83 ); /* VIRTUAL */
+      testcase( i==84 ); /* LIMIT */
+      testcase( i==85 ); /* WHEN */
+      testcase( i==86 ); /* WHERE */
+      testcase( i==87 ); /* RENAME */
+      testcase( i==88 ); /* AFTER */
+      testcase( i==89 ); /* REPLACE */
+      testcase( i==90 ); /* AND */
+      testcase( i==91 ); /* DEFAULT */
+      testcase( i==92 ); /* AUTOINCREMENT */
+      testcase( i==93 ); /* TO */
+      testcase( i==94 ); /* IN */
+      testcase( i==95 ); /* CAST */
+      testcase( i==96 ); /* COLUMN */
+      testcase( i==97 ); /* COMMIT */
+      testcase( i==98 ); /* CONFLICT */
+      testcase( i==99 ); /* CROSS */
+      testcase( i==100 ); /* CURRENT_TIMESTAMP */
+      testcase( i==101 ); /* CURRENT_TIME */
+      testcase( i==102 ); /* PRIMARY */
+      testcase( i==103 ); /* DEFERRED */
+      testcase( i==104 ); /* DISTINCT */
+      testcase( i==105 ); /* IS */
+      testcase( i==106 ); /* DROP */
+      testcase( i==107 ); /* FAIL */
+      testcase( i==108 ); /* FROM */
+      testcase( i==109 ); /* FULL */
+      testcase( i==110 ); /* GLOB */
+      testcase( i==111 ); /* BY */
+      testcase( i==112 ); /* IF */
+      testcase( i==113 ); /* ISNULL */
+      testcase( i==114 ); /* ORDER */
+      testcase( i==115 ); /* RESTRICT */
+      testcase( i==116 ); /* RIGHT */
+      testcase( i==117 ); /* ROLLBACK */
+      testcase( i==118 ); /* ROW */
+      testcase( i==119 ); /* UNION */
+      testcase( i==120 ); /* USING */
+      testcase( i==121 ); /* VACUUM */
+      testcase( i==122 ); /* VIEW */
+      testcase( i==123 ); /* INITIALLY */
+      testcase( i==124 ); /* ALL */
+      return aCode[i];
+    }
+  }
+  return TK_ID;
+}
+int sqlite3KeywordCode(const unsigned char *z, int n){
+  return keywordCode((char*)z, n);
+}
+#define SQLITE_N_KEYWORD 125
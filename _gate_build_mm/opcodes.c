@@ -0,0 +1,178 @@
+/* Automatically generated.  Do not edit */
+/* See the mkopcodec.awk script for details. */
+#if !defined(SQLITE_OMIT_EXPLAIN) || defined(VDBE_PROFILE) || defined(SQLITE_DEBUG)
+#if defined(SQLITE_ENABLE_EXPLAIN_COMMENTS) || defined(SQLITE_DEBUG)
+# define OpHelp(X) "\0" X
+#else
+# define OpHelp(X)
+#endif
+const char *sqlite3OpcodeName(int i){
+ static const char *const azName[] = { "?",
+     /*   1 */ "Function"         OpHelp("r[P3]=func(r[P2@P5])"),
+     /*   2 */ "Savepoint"        OpHelp(""),
+     /*   3 */ "AutoCommit"       OpHelp(""),
+     /*   4 */ "Transaction"      OpHelp(""),
+     /*   5 */ "SorterNext"       OpHelp(""),
+     /*   6 */ "PrevIfOpen"       OpHelp(""),
+     /*   7 */ "NextIfOpen"       OpHelp(""),
+     /*   8 */ "Prev"             OpHelp(""),
+     /*   9 */ "Next"             OpHelp(""),
+     /*  10 */ "AggStep"          OpHelp("accum=r[P3] step(r[P2@P5])"),
+     /*  11 */ "Checkpoint"       OpHelp(""),
+     /*  12 */ "JournalMode"      OpHelp(""),
+     /*  13 */ "Vacuum"           OpHelp(""),
+     /*  14 */ "VFilter"          OpHelp("iPlan=r[P3] zPlan='P4'"),
+     /*  15 */ "VUpdate"          OpHelp("data=r[P3@P2]"),
+     /*  16 */ "Goto"             OpHelp(""),
+     /*  17 */ "Gosub"            OpHelp(""),
+     /*  18 */ "Return"           OpHelp(""),
+     /*  19 */ "InitCoroutine"    OpHelp(""),
+     /*  20 */ "Not"              OpHelp("r[P2]= !r[P1]"),
+     /*  21 */ "EndCoroutine"     OpHelp(""),
+     /*  22 */ "Yield"            OpHelp(""),
+     /*  23 */ "HaltIfNull"       OpHelp("if r[P3]=null halt"),
+     /*  24 */ "Halt"             OpHelp(""),
+     /*  25 */ "Integer"          OpHelp("r[P2]=P1"),
+     /*  26 */ "Int64"            OpHelp("r[P2]=P4"),
+     /*  27 */ "String"           OpHelp("r[P2]='P4' (len=P1)"),
+     /*  28 */ "Null"             OpHelp("r[P2..P3]=NULL"),
+     /*  29 */ "SoftNull"         OpHelp("r[P1]=NULL"),
+     /*  30 */ "Blob"             OpHelp("r[P2]=P4 (len=P1)"),
+     /*  31 */ "Variable"         OpHelp("r[P2]=parameter(P1,P4)"),
+     /*  32 */ "Move"             OpHelp("r[P2@P3]=r[P1@P3]"),
+     /*  33 */ "Copy"             OpHelp("r[P2@P3+1]=r[P1@P3+1]"),
+     /*  34 */ "SCopy"            OpHelp("r[P2]=r[P1]"),
+     /*  35 */ "ResultRow"        OpHelp("output=r[P1@P2]"),
+     /*  36 */ "CollSeq"          OpHelp(""),
+     /*  37 */ "AddImm"           OpHelp("r[P1]=r[P1]+P2"),
+     /*  38 */ "MustBeInt"        OpHelp(""),
+     /*  39 */ "RealAffinity"     OpHelp(""),
+     /*  40 */ "Permutation"      OpHelp(""),
+     /*  41 */ "Compare"          OpHelp(""),
+     /*  42 */ "Jump"             OpHelp(""),
+     /*  43 */ "Once"             OpHelp(""),
+     /*  44 */ "If"               OpHelp(""),
+     /*  45 */ "IfNot"            OpHelp(""),
+     /*  46 */ "Column"           OpHelp("r[P3]=PX"),
+     /*  47 */ "Affinity"         OpHelp("affinity(r[P1@P2])"),
+     /*  48 */ "MakeRecord"       OpHelp("r[P3]=mkrec(r[P1@P2])"),
+     /*  49 */ "Count"            OpHelp("r[P2]=count()"),
+     /*  50 */ "ReadCookie"       OpHelp(""),
+     /*  51 */ "SetCookie"        OpHelp(""),
+     /*  52 */ "OpenRead"         OpHelp("root=P2 iDb=P3"),
+     /*  53 */ "OpenWrite"        OpHelp("root=P2 iDb=P3"),
+     /*  54 */ "OpenAutoindex"    OpHelp("nColumn=P2"),
+     /*  55 */ "OpenEphemeral"    OpHelp("nColumn=P2"),
+     /*  56 */ "ReuseAutoindex"   OpHelp("root=P3 iDb=P5"),
+     /*  57 */ "SaveAutoindex"    OpHelp(""),
+     /*  58 */ "SorterOpen"       OpHelp(""),
+     /*  59 */ "HashOpen"         OpHelp("nColumn=P2 nKey=P3"),
+     /*  60 */ "HashInsert"       OpHelp("key=r[P2]"),
+     /*  61 */ "HashProbe"        OpHelp("key=r[P3@P4]"),
+     /*  62 */ "FilterAdd"        OpHelp("filter(P1) += key(P3@P4)"),
+     /*  63 */ "Filter"           OpHelp("if key(P3@P4) not in filter(P1) goto P2"),
+     /*  64 */ "OpenPseudo"       OpHelp("P3 columns in r[P2]"),
+     /*  65 */ "Close"            OpHelp(""),
+     /*  66 */ "SeekLT"           OpHelp(""),
+     /*  67 */ "SeekLE"           OpHelp(""),
+     /*  68 */ "SeekGE"           OpHelp(""),
+     /*  69 */ "SeekGT"           OpHelp(""),
+     /*  70 */ "Seek"             OpHelp("intkey=r[P2]"),
+     /*  71 */ "NoConflict"       OpHelp("key=r[P3@P4]"),
+     /*  72 */ "Or"               OpHelp("r[P3]=(r[P1] || r[P2])"),
+     /*  73 */ "And"              OpHelp("r[P3]=(r[P1] && r[P2])"),
+     /*  74 */ "NotFound"         OpHelp("key=r[P3@P4]"),
+     /*  75 */ "Found"            OpHelp("key=r[P3@P4]"),
+     /*  76 */ "NotExists"        OpHelp("intkey=r[P3]"),
+     /*  77 */ "IsNull"           OpHelp("if r[P1]==NULL goto P2"),
+     /*  78 */ "NotNull"          OpHelp("if r[P1]!=NULL goto P2"),
+     /*  79 */ "Ne"               OpHelp("if r[P1]!=r[P3] goto P2"),
+     /*  80 */ "Eq"               OpHelp("if r[P1]==r[P3] goto P2"),
+     /*  81 */ "Gt"               OpHelp("if r[P1]>r[P3] goto P2"),
+     /*  82 */ "Le"               OpHelp("if r[P1]<=r[P3] goto P2"),
+     /*  83 */ "Lt"               OpHelp("if r[P1]<r[P3] goto P2"),
+     /*  84 */ "Ge"               OpHelp("if r[P1]>=r[P3] goto P2"),
+     /*  85 */ "Sequence"         OpHelp("r[P2]=rowid"),
+     /*  86 */ "BitAnd"           OpHelp("r[P3]=r[P1]&r[P2]"),
+     /*  87 */ "BitOr"            OpHelp("r[P3]=r[P1]|r[P2]"),
+     /*  88 */ "ShiftLeft"        OpHelp("r[P3]=r[P2]<<r[P1]"),
+     /*  89 */ "ShiftRight"       OpHelp("r[P3]=r[P2]>>r[P1]"),
+     /*  90 */ "Add"              OpHelp("r[P3]=r[P1]+r[P2]"),
+     /*  91 */ "Subtract"         OpHelp("r[P3]=r[P2]-r[P1]"),
+     /*  92 */ "Multiply"         OpHelp("r[P3]=r[P1]*r[P2]"),
+     /*  93 */ "Divide"           OpHelp("r[P3]=r[P2]/r[P1]"),
+     /*  94 */ "Remainder"        OpHelp("r[P3]=r[P2]%r[P1]"),
+     /*  95 */ "Concat"           OpHelp("r[P3]=r[P2]+r[P1]"),
+     /*  96 */ "NewRowid"         OpHelp("r[P2]=rowid"),
+     /*  97 */ "BitNot"           OpHelp("r[P1]= ~r[P1]"),
+     /*  98 */ "String8"          OpHelp("r[P2]='P4'"),
+     /*  99 */ "Insert"           OpHelp("intkey=r[P3] data=r[P2]"),
+     /* 100 */ "InsertInt"        OpHelp("intkey=P3 data=r[P2]"),
+     /* 101 */ "Delete"           OpHelp(""),
+     /* 102 */ "ResetCount"       OpHelp(""),
+     /* 103 */ "SorterCompare"    OpHelp("if key(P1)!=rtrim(r[P3],P4) goto P2"),
+     /* 104 */ "SorterData"       OpHelp("r[P2]=data"),
+     /* 105 */ "RowKey"           OpHelp("r[P2]=key"),
+     /* 106 */ "RowData"          OpHelp("r[P2]=data"),
+     /* 107 */ "Rowid"            OpHelp("r[P2]=rowid"),
+     /* 108 */ "NullRow"          OpHelp(""),
+     /* 109 */ "Last"             OpHelp(""),
+     /* 110 */ "SorterSort"       OpHelp(""),
+     /* 111 */ "Sort"             OpHelp(""),
+     /* 112 */ "Rewind"           OpHelp(""),
+     /* 113 */ "HashNext"         OpHelp(""),
+     /* 114 */ "SorterInsert"     OpHelp(""),
+     /* 115 */ "IdxInsert"        OpHelp("key=r[P2]"),
+     /* 116 */ "IdxDelete"        OpHelp("key=r[P2@P3]"),
+     /* 117 */ "IdxRowid"         OpHelp("r[P2]=rowid"),
+     /* 118 */ "IdxLE"            OpHelp("key=r[P3@P4]"),
+     /* 119 */ "IdxGT"            OpHelp("key=r[P3@P4]"),
+     /* 120 */ "IdxLT"            OpHelp("key=r[P3@P4]"),
+     /* 121 */ "IdxGE"            OpHelp("key=r[P3@P4]"),
+     /* 122 */ "Destroy"          OpHelp(""),
+     /* 123 */ "Clear"            OpHelp(""),
+     /* 124 */ "CreateIndex"      OpHelp("r[P2]=root iDb=P1"),
+     /* 125 */ "CreateTable"      OpHelp("r[P2]=root iDb=P1"),
+     /* 126 */ "ParseSchema"      OpHelp(""),
+     /* 127 */ "LoadAnalysis"     OpHelp(""),
+     /* 128 */ "DropTable"        OpHelp(""),
+     /* 129 */ "DropIndex"        OpHelp(""),
+     /* 130 */ "DropTrigger"      OpHelp(""),
+     /* 131 */ "IntegrityCk"      OpHelp(""),
+     /* 132 */ "RowSetAdd"        OpHelp("rowset(P1)=r[P2]"),
+     /* 133 */ "RowSetRead"       OpHelp("r[P3]=rowset(P1)"),
+     /* 134 */ "Real"             OpHelp("r[P2]=P4"),
+     /* 135 */ "RowSetTest"       OpHelp("if r[P3] in rowset(P1) goto P2"),
+     /* 136 */ "Program"          OpHelp(""),
+     /* 137 */ "Param"            OpHelp(""),
+     /* 138 */ "FkCounter"        OpHelp("fkctr[P1]+=P2"),
+     /* 139 */ "FkIfZero"         OpHelp("if fkctr[P1]==0 goto P2"),
+     /* 140 */ "MemMax"           OpHelp("r[P1]=max(r[P1],r[P2])"),
+     /* 141 */ "IfPos"            OpHelp("if r[P1]>0 goto P2"),
+     /* 142 */ "IfNeg"            OpHelp("if r[P1]<0 goto P2"),
+     /* 143 */ "IfZero"           OpHelp("r[P1]+=P3, if r[P1]==0 goto P2"),
+     /* 144 */ "ToText"           OpHelp(""),
+     /* 145 */ "ToBlob"           OpHelp(""),
+     /* 146 */ "ToNumeric"        OpHelp(""),
+     /* 147 */ "ToInt"            OpHelp(""),
+     /* 148 */ "ToReal"           OpHelp(""),
+     /* 149 */ "AggFinal"         OpHelp("accum=r[P1] N=P2"),
+     /* 150 */ "IncrVacuum"       OpHelp(""),
+     /* 151 */ "Expire"           OpHelp(""),
+     /* 152 */ "TableLock"        OpHelp("iDb=P1 root=P2 write=P3"),
+     /* 153 */ "VBegin"           OpHelp(""),
+     /* 154 */ "VCreate"          OpHelp(""),
+     /* 155 */ "VDestroy"         OpHelp(""),
+     /* 156 */ "VOpen"            OpHelp(""),
+     /* 157 */ "VColumn"          OpHelp("r[P3]=vcolumn(P2)"),
+     /* 158 */ "VNext"            OpHelp(""),
+     /* 159 */ "VRename"          OpHelp(""),
+     /* 160 */ "Pagecount"        OpHelp(""),
+     /* 161 */ "MaxPgcnt"         OpHelp(""),
+     /* 162 */ "Init"             OpHelp("Start at P2"),
+     /* 163 */ "Noop"             OpHelp(""),
+     /* 164 */ "Explain"          OpHelp(""),
+  };
+  return azName[i];
+}
+#endif
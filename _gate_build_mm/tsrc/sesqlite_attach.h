@@ -0,0 +1,101 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include "sesqlite.h"
+
+/*
+ * Every database attached to a SeSQLite connection brings its own
+ * selinux_id and selinux_context tables, so the security_context stored
+ * in its rows refers to its own selinux_id. This structure keeps the
+ * translation between those ids and the ids of the main database, and
+ * the labels of its objects: the name it is attached as is local to the
+ * connection, so they can not be shared like the ones of main.
+ */
+struct sesqlite_attached {
+	char *zDb;                       /* name used to attach the database */
+	SESQLITE_HASH *local2global;     /* attached id -> main id */
+	SESQLITE_HASH *global2local;     /* main id -> attached id */
+	SESQLITE_HASH *objects;          /* "zDb:table:column" -> main id */
+	sqlite3_stmt *stmt_insert;       /* insert into zDb.selinux_id */
+	sqlite3_stmt *stmt_select_id;    /* label -> id in zDb.selinux_id */
+	sqlite3_stmt *stmt_select_label; /* id -> label in zDb.selinux_id */
+	sqlite3_stmt *stmt_con_insert;   /* insert or replace into zDb.selinux_context */
+};
+
+/*
+ * Load (or create, if the file was never labeled) the dictionaries of the
+ * database attached as zDb. Invoked by the schema change callback.
+ */
+int sesqlite_attach(
+	sqlite3 *db,
+	const char *zDb
+);
+
+/* Release everything that was loaded for zDb by sesqlite_attach */
+void sesqlite_detach(
+	sqlite3 *db,
+	const char *zDb
+);
+
+/* Release all the attached databases of the connection */
+void sesqlite_detach_all(
+	sqlite3 *db
+);
+
+/*
+ * Returns the map from "db:table:column" to the label id of the objects
+ * of zDb: its own map if zDb is attached, the shared one otherwise. The
+ * SESQLITE_MUTEX_LABELS mutex must be held while it is used.
+ */
+SESQLITE_HASH *sesqlite_objects(
+	sqlite3 *db,
+	const char *zDb
+);
+
+/* Returns 1 if pStmt was prepared for one of the attached databases */
+int sesqlite_attached_stmt(
+	sqlite3 *db,
+	sqlite3_stmt *pStmt
+);
+
+/*
+ * Returns the INSERT OR REPLACE statement on the selinux_context table
+ * of zDb, or stmt if zDb is not an attached database.
+ */
+sqlite3_stmt *sesqlite_context_stmt(
+	sqlite3 *db,
+	const char *zDb,
+	sqlite3_stmt *stmt
+);
+
+/* Defined in sesqlite_authorizer.c */
+int insert_id(
+	sqlite3 *db,
+	char *db_name,
+	char *sec_label
+);
+
+int checkAccess(
+	sqlite3 *db,
+	const char *dbname,
+	const char *table,
+	const char *column,
+	int tclass,
+	int perm
+);
@@ -0,0 +1,534 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/* SeSqlite extension to add SELinux checks in SQLite */
+
+#if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
+
+#include "sesqlite_contexts.h"
+#include "sesqlite_attach.h"
+#include "sesqlite_shm.h"
+
+/*
+ * Function to insert a new_node in a list. Note that this
+ * function expects a pointer to head_ref as this can modify the
+ * head of the input linked list (similar to push())
+ */
+void sorted_insert(
+	struct sesqlite_context_element** head_ref,
+	struct sesqlite_context_element* new_node
+){
+	struct sesqlite_context_element* current;
+
+	if( *head_ref==NULL
+	    || strcasecmp((*head_ref)->origin, new_node->origin)<=0 ){
+		new_node->next = *head_ref;
+		*head_ref = new_node;
+	}else{
+		current = *head_ref;
+		while( current->next!=NULL
+		       && strcasecmp(current->next->origin, new_node->origin)>0 ){
+			current = current->next;
+		}
+		new_node->next = current->next;
+		current->next = new_node;
+	}
+}
+
+/* Free a list contained in sesqlite_context */
+void free_sesqlite_context_list(
+	struct sesqlite_context_element *head
+){
+	struct sesqlite_context_element *temp;
+	while( head!=NULL ){
+		sqlite3_free(head->origin);
+		sqlite3_free(head->fparam);
+		sqlite3_free(head->sparam);
+		sqlite3_free(head->tparam);
+		sqlite3_free(head->security_context);
+		temp = head;
+		head = head->next;
+		sqlite3_free(temp);
+	}
+}
+
+/* Free the entire sesqlite_context structure */
+void free_sesqlite_context(
+	struct sesqlite_context *sc
+){
+	free_sesqlite_context_list(sc->db_context);
+	free_sesqlite_context_list(sc->table_context);
+	free_sesqlite_context_list(sc->column_context);
+	free_sesqlite_context_list(sc->view_context);
+	free_sesqlite_context_list(sc->tuple_context);
+	sqlite3_free(sc);
+}
+
+struct sesqlite_context *read_sesqlite_context(
+	sqlite3 *db,
+	char *path
+){
+	int rc = SQLITE_OK;
+	int n_line, ndb_line, ntable_line, nview_line, ncolumn_line, ntuple_line;
+	char line[255];
+	char *p      = NULL;
+	char *token  = NULL;
+	char *stoken = NULL;
+	char *rest   = NULL; /* to point to the rest of the string */
+	char *srest   = NULL; /* to point to the rest of the string */
+	FILE *fp     = NULL;
+
+	struct sesqlite_context *sc = sqlite3_malloc(
+		sizeof(struct sesqlite_context));
+
+	// TODO modify the liselinux in order to retrieve the context from the targeted folder
+	fp = fopen(path, "rb");
+	if( fp == NULL ){
+		fprintf(stderr, "Error. Unable to open '%s' configuration file.\n", path);
+		return NULL;
+	}
+
+	sc->db_context     = NULL;
+	sc->table_context  = NULL;
+	sc->view_context   = NULL;
+	sc->column_context = NULL;
+	sc->tuple_context  = NULL;
+
+	n_line = 0;
+	ndb_line = 0;
+	ntable_line = 0;
+	nview_line = 0;
+	ncolumn_line = 0;
+	ntuple_line = 0;
+
+	/* Read the file */
+	while( fgets(line, sizeof line - 1, fp) ){
+
+		if( line[strlen(line) - 1] == '\n' )
+			line[strlen(line) - 1] = 0;
+
+		p = line;
+
+		while( isspace(*p) )
+			p++;
+
+		if( *p=='#' || *p==0 )
+			continue;
+
+		token = strtok_r(p, " \t", &rest);
+		if( !token ){
+			fprintf(stderr, "Error. Unable to parse the configuration file.\n");
+			fclose(fp);
+			return NULL;
+		}
+
+		if( !strcasecmp(token, "db_database") ){
+
+			struct sesqlite_context_element *new;
+			new = sqlite3_malloc(sizeof(struct sesqlite_context_element));
+			new->next = NULL;
+
+			token = strtok_r(NULL, " \t", &rest);
+			new->origin = sqlite3_mprintf("%s", token);
+			char *con = strtok_r(NULL, " \t", &rest);
+			new->security_context = sqlite3_mprintf("%s", con);
+
+			new->fparam = sqlite3_mprintf("%s", token);
+			new->sparam = sqlite3_mprintf("%s", token);
+			new->tparam = sqlite3_mprintf("%s", token);
+
+			sorted_insert(&sc->db_context, new);
+			ndb_line++;
+
+		}else if( !strcasecmp(token, "db_table") ){
+
+			struct sesqlite_context_element *new;
+			new = sqlite3_malloc(sizeof(struct sesqlite_context_element));
+			new->next = NULL;
+
+			token = strtok_r(NULL, " \t", &rest);
+			new->origin = sqlite3_mprintf("%s", token);
+			char *con = strtok_r(NULL, " \t", &rest);
+			new->security_context = sqlite3_mprintf("%s", con);
+
+			stoken = strtok_r(token, ".", &srest);
+			new->fparam = sqlite3_mprintf("%s", stoken);
+			stoken = strtok_r(NULL, ".", &srest);
+			new->sparam = sqlite3_mprintf("%s", stoken);
+			new->tparam = NULL;
+
+			sorted_insert(&sc->table_context, new);
+			ntable_line++;
+
+		}else if( !strcasecmp(token, "db_view") ){
+
+			struct sesqlite_context_element *new;
+			new = sqlite3_malloc(sizeof(struct sesqlite_context_element));
+			new->next = NULL;
+
+			token = strtok_r(NULL, " \t", &rest);
+			new->origin = sqlite3_mprintf("%s", token);
+			char *con = strtok_r(NULL, " \t", &rest);
+			new->security_context = sqlite3_mprintf("%s", con);
+
+			stoken = strtok_r(token, ".", &srest);
+			new->fparam = sqlite3_mprintf("%s", stoken);
+			stoken = strtok_r(NULL, ".", &srest);
+			new->sparam = sqlite3_mprintf("%s", stoken);
+			new->tparam = NULL;
+
+			sorted_insert(&sc->view_context, new);
+			nview_line++;
+
+		}else if( !strcasecmp(token, "db_column") ){
+
+			struct sesqlite_context_element *new;
+			new = sqlite3_malloc(sizeof(struct sesqlite_context_element));
+			new->next = NULL;
+
+			token = strtok_r(NULL, " \t", &rest);
+			new->origin = sqlite3_mprintf("%s", token);
+			char *con = strtok_r(NULL, " \t", &rest);
+			new->security_context = sqlite3_mprintf("%s", con);
+
+			stoken = strtok_r(token, ".", &srest);
+			new->fparam = sqlite3_mprintf("%s", stoken);
+			stoken = strtok_r(NULL, ".", &srest);
+			new->sparam = sqlite3_mprintf("%s", stoken);
+			stoken = strtok_r(NULL, ".", &srest);
+			new->tparam = sqlite3_mprintf("%s", stoken);
+
+			sorted_insert(&sc->column_context, new);
+			ncolumn_line++;
+
+		}else if( !strcasecmp(token, "db_tuple") ){
+
+			struct sesqlite_context_element *new;
+			new = sqlite3_malloc(sizeof(struct sesqlite_context_element));
+			new->next = NULL;
+
+			token = strtok_r(NULL, " \t", &rest);
+			new->origin = sqlite3_mprintf("%s", token);
+			char *con = strtok_r(NULL, " \t", &rest);
+			new->security_context = sqlite3_mprintf("%s", con);
+			
+			stoken = strtok_r(token, ".", &srest);
+			new->fparam = sqlite3_mprintf("%s", stoken);
+			stoken = strtok_r(NULL, ".", &srest);
+			new->sparam = sqlite3_mprintf("%s", stoken);
+			new->tparam = NULL;
+
+			sorted_insert(&sc->tuple_context, new);
+			ntuple_line++;
+
+		}else{
+			fprintf(stderr,
+				"Error, unable to recognize '%s' in sesqlite_context file.\n",
+				token);
+		}
+	}
+
+	fclose(fp);
+	return sc;
+}
+
+/*
+ * Returns 1 if the name is accepted by the filter, otherwise 0.
+ * The name is accepted if the filter and the name are the same
+ * (case insensitive) up to the first '*' or till the end of the string.
+ * A NULL filter can be used to always returns 0.
+ */
+int filter_accepts(
+	const char *filter,
+	const char *name
+){
+	if( filter==NULL )
+		return 0;
+	
+	int wildcard = strcspn(filter, "*");
+	if( wildcard==strlen(filter) )
+		return ( sqlite3StrICmp(filter, name)==0 );
+
+	return ( sqlite3StrNICmp(filter, name, wildcard)==0 );
+}
+
+/*
+ * An object labeled by reload_sesqlite_contexts, stored in the hashmaps
+ * only after its label was written.
+ */
+struct sesqlite_labeled {
+	char *dbName;
+	char *tblName;                  /* NULL for a database */
+	char *colName;                  /* NULL for a database or a table */
+	int id;                         /* the new label */
+	struct sesqlite_labeled *next;
+};
+
+static int labeled_add(
+	struct sesqlite_labeled **ppLabeled,
+	const char *dbName,
+	const char *tblName,
+	const char *colName,
+	int id
+){
+	struct sesqlite_labeled *p;
+	int nDb = strlen(dbName) + 1;
+	int nTbl = tblName ? strlen(tblName) + 1 : 0;
+	int nCol = colName ? strlen(colName) + 1 : 0;
+
+	p = sqlite3_malloc(sizeof(*p) + nDb + nTbl + nCol);
+	if( !p ) return SQLITE_NOMEM;
+
+	p->dbName = (char*) &p[1];
+	memcpy(p->dbName, dbName, nDb);
+	p->tblName = tblName ? memcpy(&p->dbName[nDb], tblName, nTbl) : NULL;
+	p->colName = colName ? memcpy(&p->dbName[nDb + nTbl], colName, nCol) : NULL;
+	p->id = id;
+	p->next = *ppLabeled;
+	*ppLabeled = p;
+	return SQLITE_OK;
+}
+
+void free_labeled_objects(
+	struct sesqlite_labeled *pLabeled
+){
+	struct sesqlite_labeled *pNext;
+
+	for( ; pLabeled; pLabeled = pNext ){
+		pNext = pLabeled->next;
+		sqlite3_free(pLabeled);
+	}
+}
+
+void store_labeled_objects(
+	sqlite3 *db,
+	struct sesqlite_labeled *pLabeled
+){
+	struct sesqlite_labeled *p;
+
+	for( p = pLabeled; p; p = p->next )
+		insert_key(db, p->dbName, p->tblName, p->colName, p->id);
+	free_labeled_objects(pLabeled);
+}
+
+/*
+ * Store the context of a db/table/column in the selinux_context table of
+ * the database it belongs to, translating the ids if it is attached.
+ * Returns SQLITE_OK or the error of the INSERT.
+ */
+static int write_context(
+	sqlite3 *db,
+	sqlite3_stmt *stmt,
+	const char *dbName,
+	const char *tblName,
+	const char *colName,
+	int sec_con_id,
+	int sec_label_id
+){
+	int rc = SQLITE_OK;
+
+	stmt = sesqlite_context_stmt(db, dbName, stmt);
+
+	sqlite3_bind_int( stmt, 1, sesqlite_local_id(db, dbName, sec_con_id));
+	sqlite3_bind_int( stmt, 2, sesqlite_local_id(db, dbName, sec_label_id));
+	sqlite3_bind_text(stmt, 3, sesqlite_stored_db(db, dbName), -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text(stmt, 4, tblName ? tblName : "", -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text(stmt, 5, colName ? colName : "", -1, SQLITE_TRANSIENT);
+
+	rc = sqlite3_step(stmt);
+	if( SQLITE_DONE==rc )
+		rc = SQLITE_OK;
+	sqlite3_reset(stmt);
+
+	return rc;
+}
+
+/*
+ * Label a db/table/column with the rules in con. If old is not NULL the
+ * label is written only if it differs from the one the object has now,
+ * which is read from the hashmap without touching the database.
+ * Once written, the object is added to *ppLabeled and *pnCount (if not
+ * NULL) is incremented. Returns SQLITE_OK or the error of the write.
+ */
+static int label_object(
+	sqlite3 *db,
+	sqlite3_stmt *stmt,
+	struct sesqlite_context *sc,
+	struct sesqlite_context *old,
+	int isColumn,
+	struct sesqlite_context_element *con,
+	char *dbName,
+	char *tblName,
+	char *colName,
+	int sec_con_id,
+	struct sesqlite_labeled **ppLabeled,
+	int *pnCount
+){
+	char *sec_label = NULL;
+	int id = 0;
+	int sec_label_id = 0;
+	int rc = SQLITE_OK;
+
+	if( old ){
+		compute_sql_context(isColumn, dbName, tblName, colName, con, &sec_label);
+		if( sec_label!=NULL )
+			id = sesqlite_label_id(sec_label);
+		if( id!=0 && id==get_key(db, dbName, tblName, colName) )
+			return SQLITE_OK;
+	}
+
+	sec_label_id = insert_context(db, isColumn, dbName, tblName, colName,
+		con, sc->tuple_context);
+
+	rc = write_context(db, stmt, dbName, tblName, colName,
+		sec_con_id, sec_label_id);
+	if( SQLITE_OK==rc )
+		rc = labeled_add(ppLabeled, dbName, tblName, colName, sec_label_id);
+	if( SQLITE_OK==rc && pnCount )
+		(*pnCount)++;
+
+	return rc;
+}
+
+int reload_sesqlite_contexts(
+	sqlite3 *db,                  /* the database connection */
+	sqlite3_stmt *stmt,           /* the INSERT OR REPLACE statement */
+	struct sesqlite_context *sc,  /* the sesqlite_context */
+	struct sesqlite_context *old, /* the previous one or NULL */
+	char *dbFilter,               /* the db filter or NULL as wildcard */
+	char *tblFilter,              /* the table filter or NULL as wildcard */
+	char *colFilter,              /* the column filter or NULL as wildcard */
+	int *pnCount,                 /* OUT: number of labels written or NULL */
+	struct sesqlite_labeled **ppLabeled /* OUT: the labeled objects or NULL */
+){
+	/* The following code is used to scan all the databases, tables
+	 * and columns directly from the structs used to store the schema */
+
+	int i, j;
+	Hash *pTbls;
+	HashElem * x;
+	Db *pDb;
+	char *dbName = NULL;
+	char *tblName = NULL;
+	char *colName = NULL;
+	char *sec_con = NULL;
+	char *old_sec_con = NULL;
+	struct sesqlite_context *prev = NULL;
+	struct sesqlite_labeled *pLabeled = NULL;
+	int count = 0;
+	int rc = SQLITE_OK;
+
+	int sec_con_id = 0;
+
+	/* Scan the databases */
+	for( i = (db->nDb - 1), pDb = &db->aDb[i]; i>=0; i--, pDb-- ){
+
+		if( OMIT_TEMPDB && i==1 )
+			continue;
+
+		/* Filter database */
+		dbName = pDb->zName;
+		if( !filter_accepts(dbFilter, dbName) )
+			continue;
+
+		/* the label of the tuples of selinux_context, when it changes
+		 * every row of the database has to be written again */
+		sec_con_id = insert_context(db, 0, dbName, SELINUX_CONTEXT, NULL,
+			sc->tuple_context, sc->tuple_context);
+
+		prev = old;
+		if( old ){
+			compute_sql_context(0, dbName, SELINUX_CONTEXT, NULL,
+				sc->tuple_context, &sec_con);
+			compute_sql_context(0, dbName, SELINUX_CONTEXT, NULL,
+				old->tuple_context, &old_sec_con);
+			if( sec_con==NULL || old_sec_con==NULL
+			    || strcmp(sec_con, old_sec_con)!=0 )
+				prev = NULL;
+		}
+
+		rc = label_object(db, stmt, sc, prev, 0, sc->db_context,
+			dbName, NULL, NULL, sec_con_id, &pLabeled, NULL);
+		if( SQLITE_OK!=rc ) goto reload_done;
+
+		/* Scan the tables */
+		pTbls = &db->aDb[i].pSchema->tblHash;
+		for( x = sqliteHashFirst(pTbls); x; x = sqliteHashNext(x) ){
+
+			Table *pTab = sqliteHashData(x);
+			if( !pTab )
+				continue;
+
+			/* Filter table */
+			tblName = pTab->zName;
+			if( !filter_accepts(tblFilter, tblName) )
+				continue;
+
+			rc = label_object(db, stmt, sc, prev, 0, sc->table_context,
+				dbName, tblName, NULL, sec_con_id, &pLabeled, &count);
+			if( SQLITE_OK!=rc ) goto reload_done;
+
+			/* Scan the columns */
+			Column *pCol;
+			for (j = 0, pCol = pTab->aCol; j < pTab->nCol; j++, pCol++) {
+
+				/* Filter column */
+				colName = pCol->zName;
+				if( !filter_accepts(colFilter, colName) )
+					continue;
+
+				rc = label_object(db, stmt, sc, prev, 1, sc->column_context,
+					dbName, tblName, colName, sec_con_id, &pLabeled, &count);
+				if( SQLITE_OK!=rc ) goto reload_done;
+			}
+
+			/* assign security context to rowid if exists */
+			if( HasRowid(pTab) && filter_accepts(colFilter, "ROWID") ){
+				rc = label_object(db, stmt, sc, prev, 1, sc->column_context,
+					dbName, tblName, "ROWID", sec_con_id, &pLabeled, &count);
+				if( SQLITE_OK!=rc ) goto reload_done;
+			}
+		}
+	}
+
+reload_done:
+	if( SQLITE_OK!=rc ){
+		free_labeled_objects(pLabeled);
+		count = 0;
+	}else if( ppLabeled ){
+		*ppLabeled = pLabeled;
+	}else{
+		store_labeled_objects(db, pLabeled);
+	}
+
+	if( pnCount ) *pnCount = count;
+	return rc;
+}
+
+int load_sesqlite_contexts(
+	sqlite3 *db,                   /* the database connection */
+	sqlite3_stmt *stmt,            /* the INSERT OR REPLACE statement */
+	struct sesqlite_context *sc    /* the sesqlite_context */
+){
+	return reload_sesqlite_contexts(db, stmt, sc, NULL, "*", "*", "*",
+		NULL, NULL);
+}
+
+#endif
+
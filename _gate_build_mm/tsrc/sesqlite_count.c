@@ -0,0 +1,645 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Label-aware row counters.
+ *
+ * The tuple-level checks add a WHERE clause to every SELECT, so SQLite can
+ * not use OP_Count for "SELECT count(*) FROM t" and has to visit every row.
+ * For the tables enabled with "pragma labelcount" the number of rows of
+ * each label is kept in selinux_count, and the count(*) is answered by
+ * summing the counters of the labels that the subject can select.
+ *
+ * The counters also summarize the labels of the rows of the table. When the
+ * subject can not select any of them, a scan would read every page only to
+ * discard every row: the SELECTs on the table get a constant term in the
+ * WHERE clause, evaluated once before the loop, which skips the scan.
+ */
+
+#if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
+
+#include "sesqlite_count.h"
+#include "sesqlite_attach.h"
+#include "sesqlite_init.h"
+#include "sesqlite_utils.h"
+
+/* trigger names, %w is the name of the table */
+static const char *count_trigger_op[] = { "insert", "delete", "update" };
+
+#define SELINUX_COUNT_INSERT_TRIGGER \
+	"CREATE TRIGGER %Q.\"" SELINUX_COUNT_TRIGGER "insert_%w\"" \
+	" AFTER INSERT ON \"%w\" BEGIN" \
+	" INSERT OR IGNORE INTO " SELINUX_COUNT \
+	" VALUES(%Q, new.security_context, 0, new.security_context);" \
+	" UPDATE " SELINUX_COUNT " SET count=count+1" \
+	" WHERE name=%Q AND label=new.security_context;" \
+	" END;"
+
+#define SELINUX_COUNT_DELETE_TRIGGER \
+	"CREATE TRIGGER %Q.\"" SELINUX_COUNT_TRIGGER "delete_%w\"" \
+	" AFTER DELETE ON \"%w\" BEGIN" \
+	" UPDATE " SELINUX_COUNT " SET count=count-1" \
+	" WHERE name=%Q AND label=old.security_context;" \
+	" END;"
+
+#define SELINUX_COUNT_UPDATE_TRIGGER \
+	"CREATE TRIGGER %Q.\"" SELINUX_COUNT_TRIGGER "update_%w\"" \
+	" AFTER UPDATE OF security_context ON \"%w\"" \
+	" WHEN old.security_context IS NOT new.security_context BEGIN" \
+	" UPDATE " SELINUX_COUNT " SET count=count-1" \
+	" WHERE name=%Q AND label=old.security_context;" \
+	" INSERT OR IGNORE INTO " SELINUX_COUNT \
+	" VALUES(%Q, new.security_context, 0, new.security_context);" \
+	" UPDATE " SELINUX_COUNT " SET count=count+1" \
+	" WHERE name=%Q AND label=new.security_context;" \
+	" END;"
+
+/* the rows are counted without the tuple-level checks */
+#define SELINUX_COUNT_LOAD \
+	"INSERT INTO %Q." SELINUX_COUNT \
+	" SELECT %Q, security_context, count(*), security_context FROM %Q.\"%w\"" \
+	" GROUP BY security_context;"
+
+/* is there a row of zTab with a label the subject can select? */
+#define SELINUX_COUNT_VISIBLE \
+	"SELECT 1 FROM %Q." SELINUX_COUNT " WHERE name=%Q AND count>0" \
+	" AND selinux_check_access(label, 'db_tuple', 'select', %Q, %Q)" \
+	" LIMIT 1;"
+
+/* the constant term added to the WHERE clause by sesqlite_count_guard */
+#define SELINUX_COUNT_VISIBLE_FUNCTION "selinux_count_visible"
+
+/* the term added by sesqlite_count_guard to the scans of selinux_count */
+#define SELINUX_COUNT_READABLE_FUNCTION "selinux_count_readable"
+
+/*
+ * The answer of SELINUX_COUNT_VISIBLE for a table. It is still valid as
+ * long as selinux_count is not changed (the counters are maintained by
+ * triggers, by this or by any other connection to the file) and the AVC is
+ * not cleared.
+ */
+typedef struct count_guard {
+	char *zKey;                /* "db.table", key of the entry */
+	unsigned int generation;   /* sesqlite_avc_generation() of the answer */
+	u32 iVersion;              /* version of selinux_count of the answer */
+	int valid;                 /* true once the answer is computed */
+	int visible;               /* the answer */
+} count_guard;
+
+int sesqlite_count_loading(sqlite3 *db){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	return pConn!=NULL && pConn->loading;
+}
+
+void sesqlite_count_close(sqlite3 *db){
+	Hash *pGuards = &SESQLITE_CONN(db)->guards;
+	HashElem *x;
+
+	for( x = sqliteHashFirst(pGuards); x; x = sqliteHashNext(x) ){
+		count_guard *pGuard = sqliteHashData(x);
+		sqlite3_free(pGuard->zKey);
+		sqlite3_free(pGuard);
+	}
+	sqlite3HashClear(pGuards);
+}
+
+/*
+ * Returns the table zDb.zTab if its rows are labeled by SeSQLite,
+ * NULL otherwise.
+ */
+static Table *find_labeled_table(
+	sqlite3 *db,
+	const char *zDb,
+	const char *zTab
+){
+	Table *pTab = sqlite3FindTable(db, zTab, zDb);
+
+	if( pTab==0 || pTab->pSelect || IsVirtual(pTab) )
+		return 0;
+
+	if( 0==sqlite3StrNICmp(pTab->zName, "sqlite_", 7)
+	 || 0==sqlite3StrNICmp(pTab->zName, "selinux_", 8) )
+		return 0;
+
+	return pTab;
+}
+
+/*
+ * Returns 1 if the subject can read zDb.zTab and the labels of its rows,
+ * that is if it could count the rows without the counters.
+ */
+static int count_readable(
+	sqlite3 *db,
+	const char *zDb,
+	const char *zTab
+){
+	return checkAccess(db, zDb, zTab, NULL, SELINUX_DB_TABLE, SELINUX_SELECT)
+		&& checkAccess(db, zDb, zTab, SECURITY_CONTEXT_COLUMN_NAME,
+			SELINUX_DB_COLUMN, SELINUX_SELECT);
+}
+
+int sesqlite_count_enabled(
+	sqlite3 *db,
+	const char *zDb,
+	const char *zTab
+){
+	Schema *pSchema;
+	Trigger *pTrig;
+	char *zName;
+	int iDb;
+	int i;
+
+	iDb = sqlite3FindDbName(db, zDb);
+	if( iDb<0 || sqlite3FindTable(db, SELINUX_COUNT, zDb)==0 )
+		return 0;
+
+	/* all the triggers must be there and still be on this table, if the
+	 * table was renamed the counters must be enabled again */
+	pSchema = db->aDb[iDb].pSchema;
+	for(i = 0; i < ArraySize(count_trigger_op); i++){
+		zName = sqlite3_mprintf(SELINUX_COUNT_TRIGGER "%s_%s",
+			count_trigger_op[i], zTab);
+		if( !zName ) return 0;
+		pTrig = sqlite3HashFind(&pSchema->trigHash, zName, sqlite3Strlen30(zName));
+		sqlite3_free(zName);
+
+		if( pTrig==0 || sqlite3StrICmp(pTrig->table, zTab)!=0 )
+			return 0;
+	}
+
+	return 1;
+}
+
+static Expr *count_function(
+	Parse *pParse,
+	const char *zName,
+	ExprList *pList
+){
+	Token t;
+
+	t.z = zName;
+	t.n = sqlite3Strlen30(zName);
+	return sqlite3ExprFunction(pParse, pList, &t);
+}
+
+Expr *sesqlite_count_rewrite(
+	Parse *pParse,
+	ExprList *pEList,
+	SrcList *pSrc
+){
+	sqlite3 *db = pParse->db;
+	struct SrcList_item *pItem;
+	Expr *pCount;
+	Expr *pWhere;
+	ExprList *pList;
+	Table *pTab;
+	const char *zDb;
+
+	if( pEList==0 || pEList->nExpr!=1 || pSrc==0 || pSrc->nSrc!=1 )
+		return 0;
+
+	pCount = pEList->a[0].pExpr;
+	if( pCount==0 || pCount->op!=TK_FUNCTION || pCount->x.pList!=0
+	 || sqlite3StrICmp(pCount->u.zToken, "count")!=0 )
+		return 0;
+
+	pItem = &pSrc->a[0];
+	if( pItem->zName==0 || pItem->pSelect || pItem->zIndex || pItem->notIndexed )
+		return 0;
+
+	pTab = find_labeled_table(db, pItem->zDatabase, pItem->zName);
+	if( pTab==0 )
+		return 0;
+
+	zDb = db->aDb[sqlite3SchemaToIndex(db, pTab->pSchema)].zName;
+	if( !sesqlite_count_enabled(db, zDb, pTab->zName) )
+		return 0;
+
+	/* left as it is, so that the authorizer refuses it */
+	if( !count_readable(db, zDb, pTab->zName) )
+		return 0;
+
+	/*
+	 * SELECT count(*) FROM t
+	 * becomes
+	 * SELECT ifnull(sum(count), 0) FROM selinux_count WHERE name='t'
+	 *   AND selinux_check_access(label, 'db_tuple', 'select', 't', 'db')
+	 * The span of the result column is left untouched, so that the name
+	 * of the column is still count(*).
+	 */
+	pList = sqlite3ExprListAppend(pParse, 0, sqlite3Expr(db, TK_ID, "label"));
+	pList = sqlite3ExprListAppend(pParse, pList, sqlite3Expr(db, TK_STRING, "db_tuple"));
+	pList = sqlite3ExprListAppend(pParse, pList, sqlite3Expr(db, TK_STRING, "select"));
+	pList = sqlite3ExprListAppend(pParse, pList, sqlite3Expr(db, TK_STRING, pTab->zName));
+	pList = sqlite3ExprListAppend(pParse, pList, sqlite3Expr(db, TK_STRING, zDb));
+	pWhere = sqlite3ExprAnd(db,
+		sqlite3PExpr(pParse, TK_EQ,
+			sqlite3Expr(db, TK_ID, "name"),
+			sqlite3Expr(db, TK_STRING, pTab->zName), 0),
+		count_function(pParse, "selinux_check_access", pList));
+
+	pList = sqlite3ExprListAppend(pParse, 0, sqlite3Expr(db, TK_ID, "count"));
+	pList = sqlite3ExprListAppend(pParse, 0, count_function(pParse, "sum", pList));
+	pList = sqlite3ExprListAppend(pParse, pList, sqlite3Expr(db, TK_INTEGER, "0"));
+	sqlite3ExprDelete(db, pCount);
+	pEList->a[0].pExpr = count_function(pParse, "ifnull", pList);
+
+	sqlite3DbFree(db, pItem->zDatabase);
+	sqlite3DbFree(db, pItem->zName);
+	pItem->zDatabase = sqlite3DbStrDup(db, zDb);
+	pItem->zName = sqlite3DbStrDup(db, SELINUX_COUNT);
+
+	return pWhere;
+}
+
+Expr *sesqlite_count_guard(
+	Parse *pParse,
+	const char *zDb,
+	const char *zTab,
+	const char *zAlias
+){
+	sqlite3 *db = pParse->db;
+	ExprList *pList;
+	Table *pTab;
+
+	if( sqlite3StrICmp(zTab, SELINUX_COUNT)==0 ){
+		/* selinux_count_readable(alias.name, 'db') */
+		pList = sqlite3ExprListAppend(pParse, 0, sqlite3PExpr(pParse, TK_DOT,
+			sqlite3Expr(db, TK_ID, zAlias), sqlite3Expr(db, TK_ID, "name"), 0));
+		pList = sqlite3ExprListAppend(pParse, pList, sqlite3Expr(db, TK_STRING, zDb));
+		return count_function(pParse, SELINUX_COUNT_READABLE_FUNCTION, pList);
+	}
+
+	pTab = find_labeled_table(db, zDb, zTab);
+	if( pTab==0 )
+		return 0;
+
+	zDb = db->aDb[sqlite3SchemaToIndex(db, pTab->pSchema)].zName;
+	if( !sesqlite_count_enabled(db, zDb, pTab->zName) )
+		return 0;
+
+	/* selinux_count_visible('db', 't') */
+	pList = sqlite3ExprListAppend(pParse, 0, sqlite3Expr(db, TK_STRING, zDb));
+	pList = sqlite3ExprListAppend(pParse, pList, sqlite3Expr(db, TK_STRING, pTab->zName));
+	return count_function(pParse, SELINUX_COUNT_VISIBLE_FUNCTION, pList);
+}
+
+/*
+ * Computes SELINUX_COUNT_VISIBLE for zDb.zTab, returns 1 if the query can
+ * not be run, so that the rows are checked one by one as usual.
+ */
+static int count_visible(
+	sqlite3 *db,
+	const char *zDb,
+	const char *zTab
+){
+	sqlite3_stmt *pStmt = NULL;
+	char *zSql;
+	int visible = 1;
+	int rc;
+
+	zSql = sqlite3_mprintf(SELINUX_COUNT_VISIBLE, zDb, zTab, zTab, zDb);
+	if( !zSql ) return 1;
+
+	rc = sqlite3_prepare_v2(db, zSql, -1, &pStmt, 0);
+	sqlite3_free(zSql);
+	if( SQLITE_OK==rc ){
+		rc = sqlite3_step(pStmt);
+		if( SQLITE_DONE==rc )
+			visible = 0;
+	}
+	sqlite3_finalize(pStmt);
+
+	return visible;
+}
+
+/*
+ * Sets *piVersion to a value that changes whenever selinux_count of zDb
+ * may have changed, including the writes made by other connections and
+ * processes, and the rollbacks. Returns 0 if it is not known, i.e. if the
+ * database has no read transaction open.
+ */
+static int count_version(
+	sqlite3 *db,
+	const char *zDb,
+	u32 *piVersion
+){
+	Btree *pBt;
+	Table *pTab;
+	int iDb;
+	int rc = 0;
+
+	iDb = sqlite3FindDbName(db, zDb);
+	pTab = sqlite3FindTable(db, SELINUX_COUNT, zDb);
+	if( iDb<0 || pTab==0 || (pBt = db->aDb[iDb].pBt)==0 )
+		return 0;
+
+	sqlite3BtreeEnter(pBt);
+	if( sqlite3BtreeIsInReadTrans(pBt) ){
+		*piVersion = sqlite3BtreeTableVersion(pBt, pTab->tnum);
+		rc = 1;
+	}
+	sqlite3BtreeLeave(pBt);
+
+	return rc;
+}
+
+/*
+ * Function invoked when using the SQL function selinux_count_visible,
+ * once for each execution of the statement.
+ */
+static void selinuxCountVisibleFunction(
+	sqlite3_context *context,
+	int argc,
+	sqlite3_value **argv
+){
+	sqlite3 *db = sqlite3_context_db_handle(context);
+	Hash *pGuards = &SESQLITE_CONN(db)->guards;
+	const char *zDb = (const char*) sqlite3_value_text(argv[0]);
+	const char *zTab = (const char*) sqlite3_value_text(argv[1]);
+	count_guard *pGuard;
+	char *zKey;
+	u32 iVersion;
+
+	if( zDb==NULL || zTab==NULL ){
+		sqlite3_result_int(context, 1);
+		return;
+	}
+
+	if( !count_version(db, zDb, &iVersion) ){
+		sqlite3_result_int(context, count_visible(db, zDb, zTab));
+		return;
+	}
+
+	zKey = sqlite3_mprintf("%s.%s", zDb, zTab);
+	if( !zKey ){
+		sqlite3_result_error_nomem(context);
+		return;
+	}
+
+	pGuard = sqlite3HashFind(pGuards, zKey, sqlite3Strlen30(zKey));
+	if( pGuard==NULL ){
+		pGuard = sqlite3_malloc(sizeof(count_guard));
+		if( pGuard==NULL ){
+			sqlite3_free(zKey);
+			sqlite3_result_error_nomem(context);
+			return;
+		}
+		pGuard->zKey = zKey;
+		pGuard->valid = 0;
+		if( sqlite3HashInsert(pGuards, zKey, sqlite3Strlen30(zKey), pGuard) ){
+			/* the hash could not grow */
+			sqlite3_free(pGuard);
+			sqlite3_free(zKey);
+			sqlite3_result_int(context, count_visible(db, zDb, zTab));
+			return;
+		}
+	}else{
+		sqlite3_free(zKey);
+	}
+
+	if( !pGuard->valid || pGuard->iVersion!=iVersion
+	 || pGuard->generation!=sesqlite_avc_generation() ){
+		pGuard->visible = count_visible(db, zDb, zTab);
+		pGuard->iVersion = iVersion;
+		pGuard->generation = sesqlite_avc_generation();
+		pGuard->valid = 1;
+	}
+
+	sqlite3_result_int(context, pGuard->visible);
+}
+
+/*
+ * Function invoked when using the SQL function selinux_count_readable,
+ * once for each counter read from selinux_count.
+ */
+static void selinuxCountReadableFunction(
+	sqlite3_context *context,
+	int argc,
+	sqlite3_value **argv
+){
+	sqlite3 *db = sqlite3_context_db_handle(context);
+	const char *zTab = (const char*) sqlite3_value_text(argv[0]);
+	const char *zDb = (const char*) sqlite3_value_text(argv[1]);
+
+	if( zDb==NULL || zTab==NULL ){
+		sqlite3_result_int(context, 0);
+		return;
+	}
+
+	sqlite3_result_int(context, count_readable(db, zDb, zTab));
+}
+
+int initialize_count(sqlite3 *db){
+	int rc;
+
+	/* deterministic, so that the term is evaluated once before the scan */
+	rc = sqlite3_create_function(db, SELINUX_COUNT_VISIBLE_FUNCTION, 2,
+		SQLITE_UTF8 | SQLITE_DETERMINISTIC, db, selinuxCountVisibleFunction,
+		0, 0);
+	if( SQLITE_OK==rc )
+		rc = sqlite3_create_function(db, SELINUX_COUNT_READABLE_FUNCTION, 2,
+			SQLITE_UTF8, db, selinuxCountReadableFunction, 0, 0);
+
+	return rc;
+}
+
+/*
+ * Drops the triggers used to maintain the counters of zDb.zTab.
+ */
+static int drop_count_triggers(
+	sqlite3 *db,
+	const char *zDb,
+	const char *zTab
+){
+	Table *pTab;
+	Trigger *pTrig;
+	char *zSql = NULL;
+	int rc = SQLITE_OK;
+
+	pTab = sqlite3FindTable(db, zTab, zDb);
+	if( pTab==0 ) return SQLITE_OK;
+
+	/* collect them first, dropping a trigger changes pTab->pTrigger */
+	for(pTrig = pTab->pTrigger; pTrig; pTrig = pTrig->pNext){
+		if( pTrig->pSchema!=pTab->pSchema ) continue;
+		if( sqlite3StrNICmp(pTrig->zName, SELINUX_COUNT_TRIGGER,
+			sizeof(SELINUX_COUNT_TRIGGER) - 1)!=0 ) continue;
+
+		zSql = sqlite3_mprintf("%z DROP TRIGGER %Q.\"%w\";",
+			zSql, zDb, pTrig->zName);
+		if( !zSql ) return SQLITE_NOMEM;
+	}
+
+	if( zSql ){
+		rc = sqlite3_exec(db, zSql, 0, 0, 0);
+		sqlite3_free(zSql);
+	}
+
+	return rc;
+}
+
+static int exec_printf(
+	sqlite3 *db,
+	const char *zFormat,
+	...
+){
+	va_list ap;
+	char *zSql;
+	int rc;
+
+	va_start(ap, zFormat);
+	zSql = sqlite3_vmprintf(zFormat, ap);
+	va_end(ap);
+	if( !zSql ) return SQLITE_NOMEM;
+
+	rc = sqlite3_exec(db, zSql, 0, 0, 0);
+	sqlite3_free(zSql);
+	return rc;
+}
+
+static int enable_count(
+	sqlite3 *db,
+	const char *zDb,
+	const char *zTab
+){
+	int (*xAddExtraColumn)(void*,void*,int,void*,char**);
+	int rc = SQLITE_OK;
+
+	/* like the other internal tables, no security_context column */
+	xAddExtraColumn = db->xAddExtraColumn;
+	db->xAddExtraColumn = 0;
+	rc = exec_printf(db, SELINUX_COUNT_TABLE, zDb);
+	db->xAddExtraColumn = xAddExtraColumn;
+
+	if( SQLITE_OK==rc )
+		rc = drop_count_triggers(db, zDb, zTab);
+
+	if( SQLITE_OK==rc )
+		rc = exec_printf(db, "DELETE FROM %Q." SELINUX_COUNT " WHERE name=%Q;",
+			zDb, zTab);
+
+	if( SQLITE_OK==rc )
+		rc = exec_printf(db, SELINUX_COUNT_INSERT_TRIGGER,
+			zDb, zTab, zTab, zTab, zTab);
+
+	if( SQLITE_OK==rc )
+		rc = exec_printf(db, SELINUX_COUNT_DELETE_TRIGGER,
+			zDb, zTab, zTab, zTab);
+
+	if( SQLITE_OK==rc )
+		rc = exec_printf(db, SELINUX_COUNT_UPDATE_TRIGGER,
+			zDb, zTab, zTab, zTab, zTab, zTab);
+
+	if( SQLITE_OK==rc ){
+		SESQLITE_CONN(db)->loading = 1;
+		rc = exec_printf(db, SELINUX_COUNT_LOAD, zDb, zTab, zDb, zTab);
+		SESQLITE_CONN(db)->loading = 0;
+	}
+
+	return rc;
+}
+
+static int disable_count(
+	sqlite3 *db,
+	const char *zDb,
+	const char *zTab
+){
+	int rc = drop_count_triggers(db, zDb, zTab);
+
+	if( SQLITE_OK==rc && sqlite3FindTable(db, SELINUX_COUNT, zDb) )
+		rc = exec_printf(db, "DELETE FROM %Q." SELINUX_COUNT " WHERE name=%Q;",
+			zDb, zTab);
+
+	return rc;
+}
+
+/*
+ * Runs xCount on zDb.zTab inside a savepoint, so that the counters and the
+ * triggers are either all in place or not there at all.
+ */
+static int change_count(
+	sqlite3 *db,
+	const char *zDb,
+	const char *zTab,
+	int (*xCount)(sqlite3*,const char*,const char*)
+){
+	Table *pTab;
+	char *zName;
+	int rc;
+
+	pTab = find_labeled_table(db, zDb, zTab);
+	if( pTab==0 ) return SQLITE_ERROR;
+
+	zName = sqlite3_mprintf("%s", pTab->zName);
+	if( !zName ) return SQLITE_NOMEM;
+
+	rc = sqlite3_exec(db, "SAVEPOINT " SELINUX_COUNT ";", 0, 0, 0);
+	if( SQLITE_OK==rc ){
+		rc = xCount(db, zDb, zName);
+		if( SQLITE_OK!=rc )
+			sqlite3_exec(db, "ROLLBACK TO " SELINUX_COUNT ";", 0, 0, 0);
+		sqlite3_exec(db, "RELEASE " SELINUX_COUNT ";", 0, 0, 0);
+	}
+
+	sqlite3_free(zName);
+	return rc;
+}
+
+void selinux_labelcount_pragma(
+	void* pArg,
+	sqlite3 *db,
+	char *args
+){
+	char *zSave   = NULL;
+	char *dbName  = strtok_r(args, ". ", &zSave);
+	char *tblName = strtok_r(NULL, ". ", &zSave);
+
+	CHECK_WRONG_USAGE( dbName==NULL || tblName==NULL || MORE_TOKENS(zSave),
+		"USAGE: pragma labelcount(\"db.table\")\n" );
+
+	if( SQLITE_OK==change_count(db, dbName, tblName, enable_count) ){
+		sesqlite_print("Label counters enabled for", dbName, tblName, NULL, ".");
+	}else{
+		sesqlite_print("ERROR - Unable to enable the label counters for",
+			dbName, tblName, NULL, ".");
+	}
+}
+
+void selinux_nolabelcount_pragma(
+	void* pArg,
+	sqlite3 *db,
+	char *args
+){
+	char *zSave   = NULL;
+	char *dbName  = strtok_r(args, ". ", &zSave);
+	char *tblName = strtok_r(NULL, ". ", &zSave);
+
+	CHECK_WRONG_USAGE( dbName==NULL || tblName==NULL || MORE_TOKENS(zSave),
+		"USAGE: pragma nolabelcount(\"db.table\")\n" );
+
+	if( SQLITE_OK==change_count(db, dbName, tblName, disable_count) ){
+		sesqlite_print("Label counters disabled for", dbName, tblName, NULL, ".");
+	}else{
+		sesqlite_print("ERROR - Unable to disable the label counters for",
+			dbName, tblName, NULL, ".");
+	}
+}
+
+#endif /* !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX) */
@@ -0,0 +1,529 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Label dictionary shared among processes.
+ *
+ * Every process keeps the labels of selinux_id in hash_id, loaded when the
+ * database is opened. The labels added later by the other processes are
+ * published in a shared memory log, mapped with xShmMap like the WAL index
+ * but on a "<database>-sesqlite" file, so that the two never collide.
+ *
+ * The log starts with a header followed by the entries, (id, length, label)
+ * padded to 8 bytes, which never cross a region: an entry with id 0 moves
+ * the log to the next region. The entries are written under an exclusive
+ * lock and made visible by advancing iEnd after a memory barrier, so the
+ * readers need no lock: they copy the entries between the last offset
+ * they read and iEnd into hash_id.
+ *
+ * Within the process, hash_id and the state of the logs are protected by
+ * the SESQLITE_MUTEX_LABELS mutex. There is one log for each database
+ * file, shared by the connections of the process to it. Each connection
+ * keeps the labels it added in its own pending list until its transaction
+ * ends: they are published if it commits, and removed from hash_id if it
+ * rolls back, since SQLite then reuses their ids for the next labels.
+ *
+ * Every process holds a SHARED lock on the "-sesqlite" file while it uses
+ * the log. The last connection of a process to close the log deletes it,
+ * with its "-sesqlite-shm" index, if it can take an EXCLUSIVE lock.
+ */
+
+#if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
+
+#include "sesqlite_shm.h"
+#include "sesqlite_stmt.h"
+#include "sesqlite_utils.h"
+
+#define SESQLITE_SHM_SUFFIX  "-sesqlite" /* appended to the database name */
+#define SESQLITE_SHM_MAGIC   0x5e5e1d01
+#define SESQLITE_SHM_REGION  32768
+#define SESQLITE_SHM_LOCK    0        /* xShmLock slot of the writers */
+#define SESQLITE_SHM_ALIGN(n) (((n) + 7) & ~7)
+
+typedef struct sesqlite_shm_hdr {
+	u32 magic;        /* SESQLITE_SHM_MAGIC once initialized */
+	u32 generation;   /* number of labels published */
+	u32 iEnd;         /* offset of the end of the log */
+	u32 unused;
+} sesqlite_shm_hdr;
+
+typedef struct sesqlite_shm_entry {
+	u32 id;           /* label id, 0 to continue in the next region */
+	u32 n;            /* bytes of the label, including the terminator */
+	/* the label follows */
+} sesqlite_shm_entry;
+
+/* a label added by the transaction of a connection */
+typedef struct sesqlite_shm_pending {
+	int id;
+	char *label;
+	struct sesqlite_shm_pending *next;
+} sesqlite_shm_pending;
+
+/* the labels removed from hash_id, the other connections may still be
+ * using their strings */
+static char **azRetiredLabel = NULL;
+static int nRetiredLabel = 0;
+
+/*
+ * Removes the label with the given id from hash_id. Its string is kept
+ * until the last connection closes, it is only leaked if the memory to
+ * keep it is not available. The SESQLITE_MUTEX_LABELS mutex must be held.
+ * The AVC is cleared, so the statements checked with the label expire too.
+ */
+static void label_remove(int id){
+	char **azNew;
+	char *old = NULL;
+
+	SESQLITE_BIHASH_FIND(hash_id, &id, sizeof(int), (void**) &old, 0);
+	if( old==NULL )
+		return;
+
+	azNew = sqlite3_realloc(azRetiredLabel,
+		(nRetiredLabel + 1) * sizeof(*azRetiredLabel));
+	if( azNew ){
+		azRetiredLabel = azNew;
+		azRetiredLabel[nRetiredLabel++] = old;
+	}
+
+	/* hash_id copies the labels, it must not free this one */
+	hash_id->key2val->copyValue = 0;
+	SESQLITE_BIHASH_INSERT(hash_id, &id, sizeof(int), NULL, 0);
+	hash_id->key2val->copyValue = 1;
+
+	/* the decisions cached for the id were taken for the old label */
+	sesqlite_clearavc();
+}
+
+/* Frees the pending list of the connection */
+static void pending_free(struct sesqlite_conn *pConn){
+	sesqlite_shm_pending *p;
+
+	while( pConn->pPending ){
+		p = pConn->pPending;
+		pConn->pPending = p->next;
+		sqlite3_free(p->label);
+		sqlite3_free(p);
+	}
+}
+
+#ifdef USE_SHARED_LABELS
+/* the log of a database, shared by the connections of the process to it */
+typedef struct sesqlite_shm sesqlite_shm;
+struct sesqlite_shm {
+	char *zPath;                  /* the "-sesqlite" file, outlives pFile */
+	sqlite3_vfs *pVfs;            /* the VFS of the first connection */
+	sqlite3_file *pFile;          /* the "-sesqlite" file */
+	volatile void **apRegion;     /* the regions mapped so far */
+	int nRegion;
+	u32 iRead;                    /* offset of the next entry to read */
+	u32 iGeneration;              /* generation read so far */
+	int nRef;                     /* connections using the log */
+	sesqlite_shm *pNext;          /* next log open in the process */
+};
+
+static sesqlite_shm *pShmList = NULL; /* the logs open in the process */
+
+/*
+ * Closes the log and frees it. If bDelete is set and no other process has
+ * the log open, the "-sesqlite" and "-sesqlite-shm" files are deleted, as
+ * SQLite does with the WAL and its index when the last connection closes.
+ */
+static void shm_free(sesqlite_shm *p, int bDelete){
+	sqlite3_file *pFile = p->pFile;
+
+	if( pFile && pFile->pMethods ){
+		/* every process holds a SHARED lock while it uses the log */
+		if( bDelete && SQLITE_OK!=pFile->pMethods->xLock(pFile,
+				SQLITE_LOCK_EXCLUSIVE) )
+			bDelete = 0;
+		pFile->pMethods->xShmUnmap(pFile, bDelete);
+		if( bDelete )
+			p->pVfs->xDelete(p->pVfs, p->zPath, 0);
+		pFile->pMethods->xClose(pFile);
+	}
+	sqlite3_free(pFile);
+	sqlite3_free(p->zPath);
+	sqlite3_free((void*) p->apRegion);
+	sqlite3_free(p);
+}
+
+/*
+ * Returns the address of offset iOff of the log, mapping its region if
+ * needed, or NULL if the region does not exist (and bExtend is 0).
+ */
+static void *shm_at(sesqlite_shm *pShm, u32 iOff, int bExtend){
+	int iRegion = iOff / SESQLITE_SHM_REGION;
+	volatile void *p = NULL;
+	int rc;
+
+	if( iRegion>=pShm->nRegion ){
+		volatile void **aNew = sqlite3_realloc((void*) pShm->apRegion,
+			(iRegion + 1) * sizeof(void*));
+		if( aNew==NULL ) return NULL;
+		memset((void*) &aNew[pShm->nRegion], 0,
+			(iRegion + 1 - pShm->nRegion) * sizeof(void*));
+		pShm->apRegion = aNew;
+		pShm->nRegion = iRegion + 1;
+	}
+
+	if( pShm->apRegion[iRegion]==NULL ){
+		rc = pShm->pFile->pMethods->xShmMap(pShm->pFile, iRegion,
+			SESQLITE_SHM_REGION, bExtend, &p);
+		if( rc!=SQLITE_OK || p==NULL ) return NULL;
+		pShm->apRegion[iRegion] = p;
+	}
+
+	return (char*) pShm->apRegion[iRegion] + iOff % SESQLITE_SHM_REGION;
+}
+
+/*
+ * Copies into hash_id the entries of the log added since the last call.
+ * Returns the number of entries copied.
+ */
+static int shm_sync(sesqlite_shm *pShm){
+	sesqlite_shm_hdr *pHdr;
+	sesqlite_shm_entry *pEntry;
+	u32 iEnd;
+	int nNew = 0;
+
+	pHdr = shm_at(pShm, 0, 0);
+	pShm->pFile->pMethods->xShmBarrier(pShm->pFile);
+	if( pHdr==NULL || pHdr->magic!=SESQLITE_SHM_MAGIC
+	 || pHdr->generation==pShm->iGeneration )
+		return 0;
+	iEnd = pHdr->iEnd;
+	pShm->iGeneration = pHdr->generation;
+	pShm->pFile->pMethods->xShmBarrier(pShm->pFile);
+
+	if( pShm->iRead<sizeof(sesqlite_shm_hdr) )
+		pShm->iRead = sizeof(sesqlite_shm_hdr);
+
+	while( pShm->iRead<iEnd ){
+		pEntry = shm_at(pShm, pShm->iRead, 0);
+		if( pEntry==NULL )
+			break;
+		if( pEntry->id==0 ){
+			pShm->iRead = (pShm->iRead / SESQLITE_SHM_REGION + 1)
+				* SESQLITE_SHM_REGION;
+			continue;
+		}
+
+		sesqlite_label_add(pEntry->id, (char*) &pEntry[1]);
+		pShm->iRead += SESQLITE_SHM_ALIGN(sizeof(sesqlite_shm_entry) + pEntry->n);
+		nNew++;
+	}
+
+	return nNew;
+}
+#endif /* USE_SHARED_LABELS */
+
+int sesqlite_shm_open(sqlite3 *db){
+#ifdef USE_SHARED_LABELS
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	const char *zDb = sqlite3_db_filename(db, "main");
+	sqlite3_vfs *pVfs = db->pVfs;
+	sesqlite_shm *pShm;
+	int flags = 0;
+	int nDb;
+	int rc;
+
+	if( zDb==NULL || zDb[0]==0 )
+		return SQLITE_OK; /* in-memory or temporary database */
+
+	/* the VFS expects the name to be followed by two nul terminators */
+	nDb = strlen(zDb);
+
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	for(pShm = pShmList; pShm; pShm = pShm->pNext){
+		if( strncmp(pShm->zPath, zDb, nDb)==0
+		 && strcmp(pShm->zPath + nDb, SESQLITE_SHM_SUFFIX)==0 )
+			break;
+	}
+	if( pShm ){
+		pShm->nRef++;
+		pConn->pShm = pShm;
+		sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+		return SQLITE_OK;
+	}
+
+	pShm = sqlite3_malloc(sizeof(sesqlite_shm));
+	if( pShm==NULL ){
+		sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+		return SQLITE_NOMEM;
+	}
+	memset(pShm, 0, sizeof(sesqlite_shm));
+	pShm->pVfs = pVfs;
+	pShm->zPath = sqlite3_malloc(nDb + sizeof(SESQLITE_SHM_SUFFIX) + 1);
+	pShm->pFile = sqlite3_malloc(pVfs->szOsFile);
+	if( pShm->zPath==NULL || pShm->pFile==NULL ){
+		shm_free(pShm, 0);
+		sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+		return SQLITE_NOMEM;
+	}
+	memcpy(pShm->zPath, zDb, nDb);
+	memcpy(pShm->zPath + nDb, SESQLITE_SHM_SUFFIX, sizeof(SESQLITE_SHM_SUFFIX));
+	pShm->zPath[nDb + sizeof(SESQLITE_SHM_SUFFIX)] = 0;
+	memset(pShm->pFile, 0, pVfs->szOsFile);
+
+	rc = pVfs->xOpen(pVfs, pShm->zPath, pShm->pFile,
+		SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_MAIN_DB, &flags);
+	if( rc!=SQLITE_OK || pShm->pFile->pMethods==NULL
+	 || pShm->pFile->pMethods->iVersion<2
+	 || pShm->pFile->pMethods->xLock(pShm->pFile, SQLITE_LOCK_SHARED)!=SQLITE_OK
+	 || shm_at(pShm, 0, 1)==NULL ){
+		/* not an error, the labels are just not shared */
+		shm_free(pShm, 0);
+	}else{
+		/* the labels published until now are already in selinux_id */
+		shm_sync(pShm);
+		pShm->nRef = 1;
+		pShm->pNext = pShmList;
+		pShmList = pShm;
+		pConn->pShm = pShm;
+	}
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+#endif
+	return SQLITE_OK;
+}
+
+void sesqlite_shm_close(sqlite3 *db){
+#ifdef USE_SHARED_LABELS
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	sesqlite_shm *pShm = pConn->pShm;
+	sesqlite_shm **pp;
+
+	if( pShm==NULL )
+		return;
+	pConn->pShm = NULL;
+
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	if( --pShm->nRef==0 ){
+		for(pp = &pShmList; *pp!=pShm; pp = &(*pp)->pNext);
+		*pp = pShm->pNext;
+		shm_free(pShm, 1);
+	}
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+#endif
+}
+
+void sesqlite_shm_sync(void){
+#ifdef USE_SHARED_LABELS
+	sesqlite_shm *pShm;
+	int nNew = 0;
+
+	for(pShm = pShmList; pShm; pShm = pShm->pNext)
+		nNew += shm_sync(pShm);
+
+	/* another process added labels (e.g. to relabel an object), the
+	 * statements kept by the cache may have been checked without them */
+	if( nNew>0 )
+		sesqlite_policy_changed();
+#endif
+}
+
+/* Returns 1 if the connection has a write transaction open */
+static int in_write_trans(sqlite3 *db){
+	int i;
+
+	for(i = 0; i < db->nDb; i++){
+		Btree *pBt = db->aDb[i].pBt;
+		if( pBt && sqlite3BtreeIsInTrans(pBt) )
+			return 1;
+	}
+	return 0;
+}
+
+void sesqlite_shm_publish(sqlite3 *db, int id, const char *label){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	sesqlite_shm_pending *p;
+
+	p = sqlite3_malloc(sizeof(sesqlite_shm_pending));
+	if( p==NULL )
+		return;
+	p->id = id;
+	p->label = sqlite3_mprintf("%s", label);
+	if( p->label==NULL ){
+		sqlite3_free(p);
+		return;
+	}
+	p->next = pConn->pPending;
+	pConn->pPending = p;
+
+	/* In autocommit mode, when the statement that added the label only
+	 * reads (e.g. SELECT getcon_id(...)), the INSERT into selinux_id was
+	 * committed on its own and the commit hook has already run. */
+	if( !in_write_trans(db) )
+		sesqlite_shm_commit(db);
+}
+
+void sesqlite_shm_commit(sqlite3 *db){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+#ifdef USE_SHARED_LABELS
+	sesqlite_shm *pShm = pConn->pShm;
+	sqlite3_file *pShmFile;
+	sesqlite_shm_hdr *pHdr;
+	sesqlite_shm_entry *pEntry;
+	sesqlite_shm_pending *p;
+	u32 iEnd;
+	u32 n;
+	int nNew = 0;
+	int rc;
+
+	if( pConn->pPending==NULL || pShm==NULL ){
+		pending_free(pConn);
+		return;
+	}
+
+	/* the lock of the file does not exclude the other connections of
+	 * this process, the mutex does */
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	pShmFile = pShm->pFile;
+	rc = pShmFile->pMethods->xShmLock(pShmFile, SESQLITE_SHM_LOCK, 1,
+		SQLITE_SHM_LOCK | SQLITE_SHM_EXCLUSIVE);
+	if( rc!=SQLITE_OK ){
+		/* the others will not know the labels until they reopen */
+		sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+		pending_free(pConn);
+		return;
+	}
+
+	pHdr = shm_at(pShm, 0, 1);
+	if( pHdr->magic!=SESQLITE_SHM_MAGIC ){
+		pHdr->generation = 0;
+		pHdr->iEnd = sizeof(sesqlite_shm_hdr);
+		pShmFile->pMethods->xShmBarrier(pShmFile);
+		pHdr->magic = SESQLITE_SHM_MAGIC;
+	}
+	iEnd = pHdr->iEnd;
+
+	for(p = pConn->pPending; p; p = p->next){
+		n = SESQLITE_SHM_ALIGN(sizeof(sesqlite_shm_entry) + strlen(p->label) + 1);
+		if( n>SESQLITE_SHM_REGION - sizeof(sesqlite_shm_hdr) )
+			continue;
+
+		if( iEnd % SESQLITE_SHM_REGION + n > SESQLITE_SHM_REGION ){
+			/* the entry would cross the region, continue in the next one */
+			pEntry = shm_at(pShm, iEnd, 1);
+			if( pEntry==NULL ) break;
+			pEntry->id = 0;
+			iEnd = (iEnd / SESQLITE_SHM_REGION + 1) * SESQLITE_SHM_REGION;
+		}
+
+		pEntry = shm_at(pShm, iEnd, 1);
+		if( pEntry==NULL ) break;
+		pEntry->id = p->id;
+		pEntry->n = strlen(p->label) + 1;
+		memcpy(&pEntry[1], p->label, pEntry->n);
+		iEnd += n;
+		nNew++;
+	}
+
+	/* the entries must be visible before the new end of the log */
+	pShmFile->pMethods->xShmBarrier(pShmFile);
+	pHdr->iEnd = iEnd;
+	pHdr->generation += nNew;
+
+	pShmFile->pMethods->xShmLock(pShmFile, SESQLITE_SHM_LOCK, 1,
+		SQLITE_SHM_UNLOCK | SQLITE_SHM_EXCLUSIVE);
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+#endif
+	pending_free(pConn);
+}
+
+void sesqlite_shm_rollback(sqlite3 *db){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	sesqlite_shm_pending *p;
+	char *label;
+
+	if( pConn==NULL || pConn->pPending==NULL )
+		return;
+
+	/* the rows of selinux_id are gone and their ids will be reused */
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	for(p = pConn->pPending; p; p = p->next){
+		label = NULL;
+		SESQLITE_BIHASH_FIND(hash_id, &p->id, sizeof(int), (void**) &label, 0);
+		if( label && strcmp(label, p->label)==0 )
+			label_remove(p->id);
+	}
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	pending_free(pConn);
+}
+
+char *sesqlite_label(int id){
+	char *label = NULL;
+
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	SESQLITE_BIHASH_FIND(hash_id, &id, sizeof(int), (void**) &label, 0);
+	if( label==NULL ){
+		sesqlite_shm_sync();
+		SESQLITE_BIHASH_FIND(hash_id, &id, sizeof(int), (void**) &label, 0);
+	}
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	return label;
+}
+
+int sesqlite_label_id(const char *label){
+	int *id = NULL;
+	int res = 0;
+
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	SESQLITE_BIHASH_FINDKEY(hash_id, label, -1, (void**) &id, 0);
+	if( id==NULL ){
+		sesqlite_shm_sync();
+		SESQLITE_BIHASH_FINDKEY(hash_id, label, -1, (void**) &id, 0);
+	}
+	if( id!=NULL )
+		res = *id;
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	return res;
+}
+
+void sesqlite_label_add(int id, const char *label){
+	char *old = NULL;
+	int *pOld = NULL;
+
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	SESQLITE_BIHASH_FIND(hash_id, &id, sizeof(int), (void**) &old, 0);
+	if( old && strcmp(old, label)!=0 ){
+		/* the id of a label added by a rolled back transaction */
+		label_remove(id);
+		old = NULL;
+	}
+	if( old==NULL ){
+		SESQLITE_BIHASH_FINDKEY(hash_id, label, -1, (void**) &pOld, 0);
+		if( pOld )
+			label_remove(*pOld);
+		SESQLITE_BIHASH_INSERT(hash_id, &id, sizeof(int), label, -1);
+	}
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+}
+
+void sesqlite_label_free(void){
+	int i;
+
+	for( i = 0; i<nRetiredLabel; i++ )
+		free(azRetiredLabel[i]);  /* allocated by hash_id */
+	sqlite3_free(azRetiredLabel);
+	azRetiredLabel = NULL;
+	nRetiredLabel = 0;
+}
+
+#endif /* !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX) */
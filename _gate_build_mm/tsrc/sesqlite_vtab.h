@@ -0,0 +1,132 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include "sesqlite.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/*
+ * The label catalog: one row for each database, table and column known to
+ * SeSQLite, with its label. It is read from the schema and the in-memory
+ * hashmaps, the selinux_context table is never queried. Usage:
+ *
+ *     CREATE VIRTUAL TABLE selinux_catalog USING selinux_catalog;
+ *     SELECT * FROM selinux_catalog WHERE db='main' AND name='t1';
+ */
+#define SESQLITE_CATALOG_MODULE "selinux_catalog"
+
+static const char *sesqlite_sql =
+		"CREATE TABLE x(db TEXT, name TEXT, column TEXT, label TEXT, label_id INT);";
+
+/* The columns of the catalog */
+#define CATALOG_DB        0
+#define CATALOG_NAME      1
+#define CATALOG_COLUMN    2
+#define CATALOG_LABEL     3
+#define CATALOG_LABEL_ID  4
+#define CATALOG_NCOL      5
+
+/*
+ * The constraints used by xFilter are described by idxStr, two characters
+ * for each argument: the column (a digit) and the operator, one of
+ * CATALOG_OP_*. idxNum has the bit (1<<column) set for each equality.
+ */
+#define CATALOG_OP_EQ  '='
+#define CATALOG_OP_GT  '>'
+#define CATALOG_OP_GE  'g'
+#define CATALOG_OP_LT  '<'
+#define CATALOG_OP_LE  'l'
+
+/* at most this many range constraints are handled by xFilter */
+#define CATALOG_MAX_RANGE 8
+
+typedef struct sesqlite_vtab_s {
+	sqlite3_vtab vtab; /* this must go first */
+	sqlite3 *db; /* module specific fields then follow */
+	char *zDb; /* the database of the virtual table */
+} sesqlite_vtab;
+
+/* A row of the catalog, the names point into the schema */
+typedef struct sesqlite_catalog_row {
+	const char *zDb;
+	const char *zTab; /* NULL for the database */
+	const char *zCol; /* NULL for the database and the table */
+	int id; /* label id, -1 if the object has no label */
+} sesqlite_catalog_row;
+
+typedef struct sesqlite_cursor_s {
+	sqlite3_vtab_cursor cur; /* this must go first */
+	sesqlite_catalog_row *aRow; /* the rows matching the constraints */
+	int nRow; /* number of rows in aRow */
+	int nAlloc; /* slots allocated in aRow */
+	int iRow; /* the current row */
+} sesqlite_cursor;
+
+static int sesqlite_connect(sqlite3 *db, void *udp, int argc,
+		const char * const *argv, sqlite3_vtab **vtab, char **errmsg);
+
+static int sesqlite_disconnect(sqlite3_vtab *vtab);
+
+static int sesqlite_bestindex(sqlite3_vtab *vtab, sqlite3_index_info *info);
+
+static int sesqlite_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **cur);
+
+static int sesqlite_close(sqlite3_vtab_cursor *cur);
+
+static int sesqlite_filter(sqlite3_vtab_cursor *cur, int idxnum,
+		const char *idxstr, int argc, sqlite3_value **value);
+
+static int sesqlite_next(sqlite3_vtab_cursor *cur);
+
+static int sesqlite_eof(sqlite3_vtab_cursor *cur);
+
+static int sesqlite_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx,
+		int cidx);
+
+static int sesqlite_rowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid);
+
+static int sesqlite_rename(sqlite3_vtab *vtab, const char *newname);
+
+static sqlite3_module sesqlite_mod = {
+/* iVersion      */0,
+/* xCreate       */sesqlite_connect,
+/* xConnect      */sesqlite_connect,
+/* xBestIndex    */sesqlite_bestindex,
+/* xDisconnect   */sesqlite_disconnect,
+/* xDestroy      */sesqlite_disconnect,
+/* xOpen         */sesqlite_open,
+/* xClose        */sesqlite_close,
+/* xFilter       */sesqlite_filter,
+/* xNext         */sesqlite_next,
+/* xEof          */sesqlite_eof,
+/* xColumn       */sesqlite_column,
+/* xRowid        */sesqlite_rowid,
+/* xUpdate       */0,
+/* xBegin        */0,
+/* xSync         */0,
+/* xCommit       */0,
+/* xRollback     */0,
+/* xFindFunction */0,
+/* xRename		 */sesqlite_rename, };
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif  /* __cplusplus */
@@ -0,0 +1,3982 @@
+/* Driver template for the LEMON parser generator.
+** The author disclaims copyright to this source code.
+**
+** This version of "lempar.c" is modified, slightly, for use by SQLite.
+** The only modifications are the addition of a couple of NEVER()
+** macros to disable tests that are needed in the case of a general
+** LALR(1) grammar but which are always false in the
+** specific grammar used by SQLite.
+*/
+/* First off, code is included that follows the "include" declaration
+** in the input grammar file. */
+#include <stdio.h>
+#line 49 "parse.y"
+
+#include "sqliteInt.h"
+
+/*
+** Disable all error recovery processing in the parser push-down
+** automaton.
+*/
+#define YYNOERRORRECOVERY 1
+
+/*
+** Make yytestcase() the same as testcase()
+*/
+#define yytestcase(X) testcase(X)
+
+/*
+** An instance of this structure holds information about the
+** LIMIT clause of a SELECT statement.
+*/
+struct LimitVal {
+  Expr *pLimit;    /* The LIMIT expression.  NULL if there is no limit */
+  Expr *pOffset;   /* The OFFSET expression.  NULL if there is none */
+};
+
+/*
+** An instance of this structure is used to store the LIKE,
+** GLOB, NOT LIKE, and NOT GLOB operators.
+*/
+struct LikeOp {
+  Token eOperator;  /* "like" or "glob" or "regexp" */
+  int bNot;         /* True if the NOT keyword is present */
+};
+
+/*
+** An instance of the following structure describes the event of a
+** TRIGGER.  "a" is the event type, one of TK_UPDATE, TK_INSERT,
+** TK_DELETE, or TK_INSTEAD.  If the event is of the form
+**
+**      UPDATE ON (a,b,c)
+**
+** Then the "b" IdList records the list "a,b,c".
+*/
+struct TrigEvent { int a; IdList * b; };
+
+/*
+** An instance of this structure holds the ATTACH key and the key type.
+*/
+struct AttachKey { int type;  Token key; };
+
+#line 776 "parse.y"
+
+  /* This is a utility routine used to set the ExprSpan.zStart and
+  ** ExprSpan.zEnd values of pOut so that the span covers the complete
+  ** range of text beginning with pStart and going to the end of pEnd.
+  */
+  static void spanSet(ExprSpan *pOut, Token *pStart, Token *pEnd){
+    pOut->zStart = pStart->z;
+    pOut->zEnd = &pEnd->z[pEnd->n];
+  }
+
+  /* Construct a new Expr object from a single identifier.  Use the
+  ** new Expr to populate pOut.  Set the span of pOut to be the identifier
+  ** that created the expression.
+  */
+  static void spanExpr(ExprSpan *pOut, Parse *pParse, int op, Token *pValue){
+    pOut->pExpr = sqlite3PExpr(pParse, op, 0, 0, pValue);
+    pOut->zStart = pValue->z;
+    pOut->zEnd = &pValue->z[pValue->n];
+  }
+#line 866 "parse.y"
+
+  /* This routine constructs a binary expression node out of two ExprSpan
+  ** objects and uses the result to populate a new ExprSpan object.
+  */
+  static void spanBinaryExpr(
+    ExprSpan *pOut,     /* Write the result here */
+    Parse *pParse,      /* The parsing context.  Errors accumulate here */
+    int op,             /* The binary operation */
+    ExprSpan *pLeft,    /* The left operand */
+    ExprSpan *pRight    /* The right operand */
+  ){
+    pOut->pExpr = sqlite3PExpr(pParse, op, pLeft->pExpr, pRight->pExpr, 0);
+    pOut->zStart = pLeft->zStart;
+    pOut->zEnd = pRight->zEnd;
+  }
+#line 920 "parse.y"
+
+  /* Construct an expression node for a unary postfix operator
+  */
+  static void spanUnaryPostfix(
+    ExprSpan *pOut,        /* Write the new expression node here */
+    Parse *pParse,         /* Parsing context to record errors */
+    int op,                /* The operator */
+    ExprSpan *pOperand,    /* The operand */
+    Token *pPostOp         /* The operand token for setting the span */
+  ){
+    pOut->pExpr = sqlite3PExpr(pParse, op, pOperand->pExpr, 0, 0);
+    pOut->zStart = pOperand->zStart;
+    pOut->zEnd = &pPostOp->z[pPostOp->n];
+  }                           
+#line 939 "parse.y"
+
+  /* A routine to convert a binary TK_IS or TK_ISNOT expression into a
+  ** unary TK_ISNULL or TK_NOTNULL expression. */
+  static void binaryToUnaryIfNull(Parse *pParse, Expr *pY, Expr *pA, int op){
+    sqlite3 *db = pParse->db;
+    if( db->mallocFailed==0 && pY->op==TK_NULL ){
+      pA->op = (u8)op;
+      sqlite3ExprDelete(db, pA->pRight);
+      pA->pRight = 0;
+    }
+  }
+#line 967 "parse.y"
+
+  /* Construct an expression node for a unary prefix operator
+  */
+  static void spanUnaryPrefix(
+    ExprSpan *pOut,        /* Write the new expression node here */
+    Parse *pParse,         /* Parsing context to record errors */
+    int op,                /* The operator */
+    ExprSpan *pOperand,    /* The operand */
+    Token *pPreOp         /* The operand token for setting the span */
+  ){
+    pOut->pExpr = sqlite3PExpr(pParse, op, pOperand->pExpr, 0, 0);
+    pOut->zStart = pPreOp->z;
+    pOut->zEnd = pOperand->zEnd;
+  }
+#line 141 "parse.c"
+/* Next is all token values, in a form suitable for use by makeheaders.
+** This section will be null unless lemon is run with the -m switch.
+*/
+/* 
+** These constants (all generated automatically by the parser generator)
+** specify the various kinds of tokens (terminals) that the parser
+** understands. 
+**
+** Each symbol here is a terminal symbol in the grammar.
+*/
+/* Make sure the INTERFACE macro is defined.
+*/
+#ifndef INTERFACE
+# define INTERFACE 1
+#endif
+/* The next thing included is series of defines which control
+** various aspects of the generated parser.
+**    YYCODETYPE         is the data type used for storing terminal
+**                       and nonterminal numbers.  "unsigned char" is
+**                       used if there are fewer than 250 terminals
+**                       and nonterminals.  "int" is used otherwise.
+**    YYNOCODE           is a number of type YYCODETYPE which corresponds
+**                       to no legal terminal or nonterminal number.  This
+**                       number is used to fill in empty slots of the hash 
+**                       table.
+**    YYFALLBACK         If defined, this indicates that one or more tokens
+**                       have fall-back values which should be used if the
+**                       original value of the token will not parse.
+**    YYACTIONTYPE       is the data type used for storing terminal
+**                       and nonterminal numbers.  "unsigned char" is
+**                       used if there are fewer than 250 rules and
+**                       states combined.  "int" is used otherwise.
+**    sqlite3ParserTOKENTYPE     is the data type used for minor tokens given 
+**                       directly to the parser from the tokenizer.
+**    YYMINORTYPE        is the data type used for all minor tokens.
+**                       This is typically a union of many types, one of
+**                       which is sqlite3ParserTOKENTYPE.  The entry in the union
+**                       for base tokens is called "yy0".
+**    YYSTACKDEPTH       is the maximum depth of the parser's stack.  If
+**                       zero the stack is dynamically sized using realloc()
+**    sqlite3ParserARG_SDECL     A static variable declaration for the %extra_argument
+**    sqlite3ParserARG_PDECL     A parameter declaration for the %extra_argument
+**    sqlite3ParserARG_STORE     Code to store %extra_argument into yypParser
+**    sqlite3ParserARG_FETCH     Code to extract %extra_argument from yypParser
+**    YYNSTATE           the combined number of states.
+**    YYNRULE            the number of rules in the grammar
+**    YYERRORSYMBOL      is the code number of the error symbol.  If not
+**                       defined, then do no error processing.
+*/
+#define YYCODETYPE unsigned char
+#define YYNOCODE 255
+#define YYACTIONTYPE unsigned short int
+#define YYWILDCARD 71
+#define sqlite3ParserTOKENTYPE Token
+typedef union {
+  int yyinit;
+  sqlite3ParserTOKENTYPE yy0;
+  Select* yy27;
+  u16 yy89;
+  struct LikeOp yy90;
+  ExprSpan yy94;
+  SrcList* yy115;
+  int yy156;
+  u8 yy162;
+  IdList* yy164;
+  struct {int value; int mask;} yy199;
+  ExprList* yy298;
+  Expr* yy326;
+  With* yy363;
+  struct TrigEvent yy382;
+  TriggerStep* yy427;
+  struct LimitVal yy504;
+} YYMINORTYPE;
+#ifndef YYSTACKDEPTH
+#define YYSTACKDEPTH 100
+#endif
+#define sqlite3ParserARG_SDECL Parse *pParse;
+#define sqlite3ParserARG_PDECL ,Parse *pParse
+#define sqlite3ParserARG_FETCH Parse *pParse = yypParser->pParse
+#define sqlite3ParserARG_STORE yypParser->pParse = pParse
+#define YYNSTATE 643
+#define YYNRULE 328
+#define YYFALLBACK 1
+#define YY_NO_ACTION      (YYNSTATE+YYNRULE+2)
+#define YY_ACCEPT_ACTION  (YYNSTATE+YYNRULE+1)
+#define YY_ERROR_ACTION   (YYNSTATE+YYNRULE)
+
+/* The yyzerominor constant is used to initialize instances of
+** YYMINORTYPE objects to zero. */
+static const YYMINORTYPE yyzerominor = { 0 };
+
+/* Define the yytestcase() macro to be a no-op if is not already defined
+** otherwise.
+**
+** Applications can choose to define yytestcase() in the %include section
+** to a macro that can assist in verifying code coverage.  For production
+** code the yytestcase() macro should be turned off.  But it is useful
+** for testing.
+*/
+#ifndef yytestcase
+# define yytestcase(X)
+#endif
+
+
+/* Next are the tables used to determine what action to take based on the
+** current state and lookahead token.  These tables are used to implement
+** functions that take a state number and lookahead value and return an
+** action integer.  
+**
+** Suppose the action integer is N.  Then the action is determined as
+** follows
+**
+**   0 <= N < YYNSTATE                  Shift N.  That is, push the lookahead
+**                                      token onto the stack and goto state N.
+**
+**   YYNSTATE <= N < YYNSTATE+YYNRULE   Reduce by rule N-YYNSTATE.
+**
+**   N == YYNSTATE+YYNRULE              A syntax error has occurred.
+**
+**   N == YYNSTATE+YYNRULE+1            The parser accepts its input.
+**
+**   N == YYNSTATE+YYNRULE+2            No such action.  Denotes unused
+**                                      slots in the yy_action[] table.
+**
+** The action table is constructed as a single large table named yy_action[].
+** Given state S and lookahead X, the action is computed as
+**
+**      yy_action[ yy_shift_ofst[S] + X ]
+**
+** If the index value yy_shift_ofst[S]+X is out of range or if the value
+** yy_lookahead[yy_shift_ofst[S]+X] is not equal to X or if yy_shift_ofst[S]
+** is equal to YY_SHIFT_USE_DFLT, it means that the action is not in the table
+** and that yy_default[S] should be used instead.  
+**
+** The formula above is for computing the action when the lookahead is
+** a terminal symbol.  If the lookahead is a non-terminal (as occurs after
+** a reduce action) then the yy_reduce_ofst[] array is used in place of
+** the yy_shift_ofst[] array and YY_REDUCE_USE_DFLT is used in place of
+** YY_SHIFT_USE_DFLT.
+**
+** The following are the tables generated in this section:
+**
+**  yy_action[]        A single table containing all actions.
+**  yy_lookahead[]     A table containing the lookahead for each entry in
+**                     yy_action.  Used to detect hash collisions.
+**  yy_shift_ofst[]    For each state, the offset into yy_action for
+**                     shifting terminals.
+**  yy_reduce_ofst[]   For each state, the offset into yy_action for
+**                     shifting non-terminals after a reduce.
+**  yy_default[]       Default action for each state.
+*/
+#define YY_ACTTAB_COUNT (1611)
+static const YYACTIONTYPE yy_action[] = {
+ /*     0 */   306,  633,  632,  631,  630,  191,  328,  327,  559,   88,
+ /*    10 */    88,   88,   88,   81,   86,   86,   86,   86,   85,   85,
+ /*    20 */    84,   84,   84,   83,  330,   82,   79,  165,  636,  636,
+ /*    30 */   640,  606,  606,   88,   88,   88,   88,  295,   86,   86,
+ /*    40 */    86,   86,   85,   85,   84,   84,   84,   83,  330,  593,
+ /*    50 */   593,  292,   89,   90,   80,  600,  599,  601,  601,   87,
+ /*    60 */    87,   88,   88,   88,   88,  685,   86,   86,   86,   86,
+ /*    70 */    85,   85,   84,   84,   84,   83,  330,  306,  559,   84,
+ /*    80 */    84,   84,   83,  330,   65,   86,   86,   86,   86,   85,
+ /*    90 */    85,   84,   84,   84,   83,  330,  636,  636,  635,  634,
+ /*   100 */   182,  636,  636,  379,  376,  375,  566,  322,  606,  606,
+ /*   110 */   185,  184,  183,   91,  374,   85,   85,   84,   84,   84,
+ /*   120 */    83,  330,    1,   77,  636,  636,  568,  636,  636,   89,
+ /*   130 */    90,   80,  600,  599,  601,  601,   87,   87,   88,   88,
+ /*   140 */    88,   88,   16,   86,   86,   86,   86,   85,   85,   84,
+ /*   150 */    84,   84,   83,  330,  306,  429,  639,  209,  328,  327,
+ /*   160 */   564,  230,  686,  105,  213,  548,  635,  634,  585,  448,
+ /*   170 */   460,  635,  634,   82,   79,  165,  450,  584,  449,  636,
+ /*   180 */   636,  636,  636,  319,  198,  606,  606,  199,  157,  273,
+ /*   190 */   382,  268,  381,  187,  635,  634,  479,  635,  634,   17,
+ /*   200 */   266,  593,  593,  155,   18,  588,   89,   90,   80,  600,
+ /*   210 */   599,  601,  601,   87,   87,   88,   88,   88,   88,  478,
+ /*   220 */    86,   86,   86,   86,   85,   85,   84,   84,   84,   83,
+ /*   230 */   330,  306,  164,  536,  243,   21,  146,  610,  594,  594,
+ /*   240 */   636,  636,  636,  636,  575,  249,  344,  238,  197,  635,
+ /*   250 */   634,  635,  634,  334,  212,  543,  229,  388,  564,  592,
+ /*   260 */   592,  574,  606,  606,  684,  195,  391,  479,  608,  608,
+ /*   270 */   608,  432,  957,  142,  119,  957,  563,  573,  562,  407,
+ /*   280 */   240,  342,  242,   89,   90,   80,  600,  599,  601,  601,
+ /*   290 */    87,   87,   88,   88,   88,   88,  597,   86,   86,   86,
+ /*   300 */    86,   85,   85,   84,   84,   84,   83,  330,  306,  371,
+ /*   310 */   635,  634,  635,  634,  589,  506,  249,  349,  248,  436,
+ /*   320 */   394,  182,  605,  605,  379,  376,  375,  620,  111,  395,
+ /*   330 */   506,  108,  424,  153,  424,  374,  591,  587,  293,  606,
+ /*   340 */   606,  186,  496,  111,  479,  523,  603,  602,  221,  228,
+ /*   350 */   497,  119,  261,  469,  614,   45,  614,   45,  241,   51,
+ /*   360 */    89,   90,   80,  600,  599,  601,  601,   87,   87,   88,
+ /*   370 */    88,   88,   88,  604,   86,   86,   86,   86,   85,   85,
+ /*   380 */    84,   84,   84,   83,  330,  306,  575,  110,  402,  385,
+ /*   390 */   402,  389,  484,  249,  349,  248,  585,  311,  257,  515,
+ /*   400 */   259,  598,  266,  574,  107,  584,  591,   82,   79,  165,
+ /*   410 */   283,  451,  350,  283,  380,  451,  606,  606,   20,  573,
+ /*   420 */   150,  530,  514,  567,   19,  586,  445,   71,  195,  348,
+ /*   430 */   452,  453,  186,  529,  452,  339,  347,   89,   90,   80,
+ /*   440 */   600,  599,  601,  601,   87,   87,   88,   88,   88,   88,
+ /*   450 */   393,   86,   86,   86,   86,   85,   85,   84,   84,   84,
+ /*   460 */    83,  330,  306,  550,  424,  557,  542,  424,  190,  415,
+ /*   470 */    82,   79,  165,  320,  482,  386,   82,   79,  165,  432,
+ /*   480 */   956,  272,  384,  956,  110,  564,  614,   27,  311,  614,
+ /*   490 */    44,  454,  271,  606,  606,  340,  300,  435,  615,  188,
+ /*   500 */   162,  300,  434,  616,   68,  191,  469,  615,  559,  110,
+ /*   510 */   413,  885,  616,  417,   89,   90,   80,  600,  599,  601,
+ /*   520 */   601,   87,   87,   88,   88,   88,   88,  436,   86,   86,
+ /*   530 */    86,   86,   85,   85,   84,   84,   84,   83,  330,  306,
+ /*   540 */   110,  196,  282,  538,  433,  972,  144,  430,    2,  433,
+ /*   550 */   387,  424,  544,  544,  486,  212,  543,  164,  487,  488,
+ /*   560 */   488,  364,  643,  641,  333,  350,  424,  391,  499,  520,
+ /*   570 */   606,  606,  362,  614,    9,  255,  500,  305,  559,  507,
+ /*   580 */   312,  310,  357,  564,  119,  611,  555,  546,  614,   45,
+ /*   590 */    67,   89,   90,   80,  600,  599,  601,  601,   87,   87,
+ /*   600 */    88,   88,   88,   88,  424,   86,   86,   86,   86,   85,
+ /*   610 */    85,   84,   84,   84,   83,  330,  306,  337,  424,  400,
+ /*   620 */   521,  506,  398,  329,  596,  595,  614,   45,  421,  596,
+ /*   630 */   595,  582,  509,  440,  111,  173,  424,  966,  966,  424,
+ /*   640 */   614,   26,   72,  424,   70,  526,  525,  606,  606,  516,
+ /*   650 */   517,  211,  162,  324,  361,  611,  590,  358,  614,   22,
+ /*   660 */   323,  614,   47,  313,  120,  614,   50,  335,   89,   90,
+ /*   670 */    80,  600,  599,  601,  601,   87,   87,   88,   88,   88,
+ /*   680 */    88,  424,   86,   86,   86,   86,   85,   85,   84,   84,
+ /*   690 */    84,   83,  330,  306,  424,  613,  424,  263,  424,  354,
+ /*   700 */   424,  582,  509,  614,   48,  424,  391,  424,  355,  424,
+ /*   710 */   152,  424,  264,  424,  580,  195,  614,  100,  614,   99,
+ /*   720 */   614,  101,  614,  102,  606,  606,  590,  614,  109,  614,
+ /*   730 */   112,  614,   94,  614,   98,  614,   97,  372,  418,   62,
+ /*   740 */   195,  250,  151,  414,  195,   89,   90,   80,  600,  599,
+ /*   750 */   601,  601,   87,   87,   88,   88,   88,   88,  424,   86,
+ /*   760 */    86,   86,   86,   85,   85,   84,   84,   84,   83,  330,
+ /*   770 */   306,  424,  110,  424,  410,   54,  424,  110,  229,  388,
+ /*   780 */   614,   46,  424,  495,  424,  472,  438,  424,  190,  302,
+ /*   790 */   424,  420,  312,  614,   96,  614,   30,  424,  614,   49,
+ /*   800 */   411,  606,  606,  356,  614,  115,  614,  114,  110,  614,
+ /*   810 */   113,  731,  614,   29,  498,  492,  578,  110,  255,  614,
+ /*   820 */    43,  457,   89,   90,   80,  600,  599,  601,  601,   87,
+ /*   830 */    87,   88,   88,   88,   88,  424,   86,   86,   86,   86,
+ /*   840 */    85,   85,   84,   84,   84,   83,  330,  306,  424,  110,
+ /*   850 */   424,  193,  424,  579,  424,  110,  284,  614,   42,  119,
+ /*   860 */   254,  424,  471,  424,  194,  424,  577,  424,  642,    2,
+ /*   870 */   614,   28,  614,   41,  614,   40,  614,   95,  606,  606,
+ /*   880 */   356,   53,  356,  614,   39,  614,   10,  614,   38,  614,
+ /*   890 */    37,  219,  326,  341,  284,  284,  110,  284,  555,   89,
+ /*   900 */    90,   80,  600,  599,  601,  601,   87,   87,   88,   88,
+ /*   910 */    88,   88,  424,   86,   86,   86,   86,   85,   85,   84,
+ /*   920 */    84,   84,   83,  330,  306,  424,  284,  424,   67,  424,
+ /*   930 */   220,  318,  255,  317,  614,   36,  424,  351,  424,  351,
+ /*   940 */   576,  424,  555,  572,  424,  532,  531,  614,   25,  614,
+ /*   950 */    24,  614,   35,   83,  330,  606,  606,  571,  614,   34,
+ /*   960 */   614,   33,  316,  614,   23,  363,  614,   11,  247,   14,
+ /*   970 */   217,  255,  255,  255,  465,  255,   89,   90,   80,  600,
+ /*   980 */   599,  601,  601,   87,   87,   88,   88,   88,   88,  424,
+ /*   990 */    86,   86,   86,   86,   85,   85,   84,   84,   84,   83,
+ /*  1000 */   330,  306,  424,  255,  392,   64,  218,   13,  214,  315,
+ /*  1010 */   255,  614,   32,  463,  462,  461,  561,  216,  437,  301,
+ /*  1020 */   481,  531,  619,  141,  614,   31,  614,    8,  641,  333,
+ /*  1030 */   510,  189,  606,  606,  553,  208,  161,  390,    4,  545,
+ /*  1040 */   547,   12,  118,  541,  540,  215,  539,  223,   60,  378,
+ /*  1050 */   265,  140,  237,   89,   78,   80,  600,  599,  601,  601,
+ /*  1060 */    87,   87,   88,   88,   88,   88,  513,   86,   86,   86,
+ /*  1070 */    86,   85,   85,   84,   84,   84,   83,  330,  306,  139,
+ /*  1080 */    59,  181,  138,  373,  271,  369,  149,  137,  493,  365,
+ /*  1090 */   190,  136,  489,  485,  252,  176,  135,    7,  477,  175,
+ /*  1100 */   474,  174,  133,   57,   56,  132,  130,  468,  245,  606,
+ /*  1110 */   606,  171,  125,  456,  464,  123,  122,  104,  447,  446,
+ /*  1120 */   336,  166,  154,  231,  332,  116,  431,  222,  106,  121,
+ /*  1130 */   306,   90,   80,  600,  599,  601,  601,   87,   87,   88,
+ /*  1140 */    88,   88,   88,  638,   86,   86,   86,   86,   85,   85,
+ /*  1150 */    84,   84,   84,   83,  330,  309,  204,  308,  629,  628,
+ /*  1160 */   428,  606,  606,  203,  427,  627,  201,    6,  200,  290,
+ /*  1170 */    62,  289,   63,  399,  288,  401,  622,   92,  287,  416,
+ /*  1180 */   143,  612,  227,  325,   80,  600,  599,  601,  601,   87,
+ /*  1190 */    87,   88,   88,   88,   88,  226,   86,   86,   86,   86,
+ /*  1200 */    85,   85,   84,   84,   84,   83,  330,   76,  419,  569,
+ /*  1210 */     3,  880,  412,   69,  210,  331,  331,   61,  225,  424,
+ /*  1220 */    76,  419,  558,    3,  192,  383,  422,  533,  331,  331,
+ /*  1230 */   403,  278,  528,  396,  276,  321,  523,  527,  274,  422,
+ /*  1240 */   304,  614,   45,  180,  370,  408,  269,  524,  494,  552,
+ /*  1250 */   368,  551,  303,  522,  119,  508,  503,  588,  408,  502,
+ /*  1260 */   501,  179,  178,  366,  110,   58,  117,  131,  207,  345,
+ /*  1270 */   588,  491,  253,  177,  172,  402,  404,   73,   74,  490,
+ /*  1280 */   360,  483,  444,  470,   75,  426,  425,  480,  346,  610,
+ /*  1290 */    73,   74,  549,  314,  443,  134,   55,   75,  426,  425,
+ /*  1300 */   439,  148,  610,  124,  442,  145,   76,  419,  103,    3,
+ /*  1310 */   129,  623,  128,  127,  331,  331,  459,  126,  520,  583,
+ /*  1320 */   608,  608,  608,  607,   15,  422,  156,  291,   52,  299,
+ /*  1330 */   581,  270,  160,  608,  608,  608,  607,   15,  377,  473,
+ /*  1340 */   279,  637,  458,  626,  408,  625,    5,  239,  147,  624,
+ /*  1350 */   621,  618,  565,  119,   76,  419,  588,    3,  423,  343,
+ /*  1360 */   409,  609,  331,  331,  286,  285,  224,  406,  277,  518,
+ /*  1370 */   275,  405,  570,  422,  353,  560,   73,   74,   66,  419,
+ /*  1380 */   246,    3,  556,   75,  426,  425,  331,  331,  610,  554,
+ /*  1390 */   267,  519,  408,  512,  511,  504,  206,  422,  367,  262,
+ /*  1400 */   260,  258,  256,  505,  588,  251,  359,  476,  475,  352,
+ /*  1410 */   244,  467,  455,  119,  236,  233,  408,  232,  441,  608,
+ /*  1420 */   608,  608,  607,   15,   73,   74,  281,  163,  588,  397,
+ /*  1430 */   280,   75,  426,  425,  330,  973,  610,  973,  537,  973,
+ /*  1440 */    93,  535,  617,  973,  973,  534,  534,  973,   73,   74,
+ /*  1450 */   973,  973,  973,  973,  973,   75,  426,  425,  973,  973,
+ /*  1460 */   610,  973,  973,  973,  973,  973,  973,  608,  608,  608,
+ /*  1470 */   607,   15,  973,  205,  973,  973,  973,  973,  973,  298,
+ /*  1480 */   297,  296,  202,  294,  973,  973,  466,  588,  973,  973,
+ /*  1490 */   973,  608,  608,  608,  607,   15,  973,  973,  973,  973,
+ /*  1500 */   973,  167,  973,  235,  973,  973,  973,  159,  158,  973,
+ /*  1510 */   973,  973,  234,  973,  973,  536,  973,  973,  973,  610,
+ /*  1520 */   973,  973,  973,  973,  973,  169,  973,  973,  973,  973,
+ /*  1530 */   973,  973,  170,  973,  973,  119,  168,  973,  973,  973,
+ /*  1540 */   973,  973,  973,  973,  973,  973,  973,  973,  973,  973,
+ /*  1550 */   608,  608,  608,  973,  973,  973,  973,  973,  973,  973,
+ /*  1560 */   973,  973,  973,  973,  973,  973,  973,  973,  973,  973,
+ /*  1570 */   973,  973,  973,  973,  973,  973,  973,  973,  973,  973,
+ /*  1580 */   973,  973,  973,  307,  973,  973,  973,  973,  973,  973,
+ /*  1590 */   973,  973,  973,  973,  973,  973,  973,  973,  973,  973,
+ /*  1600 */   973,  973,  973,  973,  973,  973,  973,  973,  973,  973,
+ /*  1610 */   338,
+};
+static const YYCODETYPE yy_lookahead[] = {
+ /*     0 */    20,    7,    8,    9,   10,   25,   90,   91,   28,   81,
+ /*    10 */    82,   83,   84,   85,   86,   87,   88,   89,   90,   91,
+ /*    20 */    92,   93,   94,   95,   96,  225,  226,  227,   28,   29,
+ /*    30 */     1,   51,   52,   81,   82,   83,   84,   16,   86,   87,
+ /*    40 */    88,   89,   90,   91,   92,   93,   94,   95,   96,  133,
+ /*    50 */   134,   24,   72,   73,   74,   75,   76,   77,   78,   79,
+ /*    60 */    80,   81,   82,   83,   84,  123,   86,   87,   88,   89,
+ /*    70 */    90,   91,   92,   93,   94,   95,   96,   20,   98,   92,
+ /*    80 */    93,   94,   95,   96,   27,   86,   87,   88,   89,   90,
+ /*    90 */    91,   92,   93,   94,   95,   96,   28,   29,   98,   99,
+ /*   100 */   100,   28,   29,  103,  104,  105,   27,   20,   51,   52,
+ /*   110 */   109,  110,  111,   56,  114,   90,   91,   92,   93,   94,
+ /*   120 */    95,   96,   23,   23,   28,   29,  178,   28,   29,   72,
+ /*   130 */    73,   74,   75,   76,   77,   78,   79,   80,   81,   82,
+ /*   140 */    83,   84,   23,   86,   87,   88,   89,   90,   91,   92,
+ /*   150 */    93,   94,   95,   96,   20,  149,  150,   24,   90,   91,
+ /*   160 */    27,  155,  123,  157,   23,   92,   98,   99,   34,  101,
+ /*   170 */   164,   98,   99,  225,  226,  227,  108,   43,  110,   28,
+ /*   180 */    29,   28,   29,   96,  123,   51,   52,  100,  101,  102,
+ /*   190 */   103,  104,  105,  106,   98,   99,   60,   98,   99,   80,
+ /*   200 */   113,  133,  134,  124,  198,   70,   72,   73,   74,   75,
+ /*   210 */    76,   77,   78,   79,   80,   81,   82,   83,   84,   12,
+ /*   220 */    86,   87,   88,   89,   90,   91,   92,   93,   94,   95,
+ /*   230 */    96,   20,   99,   98,   17,   23,   25,  102,  133,  134,
+ /*   240 */    28,   29,   28,   29,   13,  109,  110,  111,  123,   98,
+ /*   250 */    99,   98,   99,  247,  196,  197,  120,  121,  125,  133,
+ /*   260 */   134,   30,   51,   52,  123,   27,  208,   60,  133,  134,
+ /*   270 */   135,   23,   24,   59,   67,   27,  125,   46,  125,   48,
+ /*   280 */    63,  223,   65,   72,   73,   74,   75,   76,   77,   78,
+ /*   290 */    79,   80,   81,   82,   83,   84,   24,   86,   87,   88,
+ /*   300 */    89,   90,   91,   92,   93,   94,   95,   96,   20,   20,
+ /*   310 */    98,   99,   98,   99,   24,  153,  109,  110,  111,   71,
+ /*   320 */    20,  100,   51,   52,  103,  104,  105,  165,  166,   29,
+ /*   330 */   153,   23,  153,   23,  153,  114,   28,   24,  161,   51,
+ /*   340 */    52,   52,  165,  166,   60,  107,   75,   76,  186,  201,
+ /*   350 */   188,   67,   17,  164,  175,  176,  175,  176,  141,  211,
+ /*   360 */    72,   73,   74,   75,   76,   77,   78,   79,   80,   81,
+ /*   370 */    82,   83,   84,  102,   86,   87,   88,   89,   90,   91,
+ /*   380 */    92,   93,   94,   95,   96,   20,   13,  198,  209,  210,
+ /*   390 */   209,  210,   22,  109,  110,  111,   34,  108,   63,   38,
+ /*   400 */    65,   24,  113,   30,   27,   43,   98,  225,  226,  227,
+ /*   410 */   153,  153,  223,  153,   53,  153,   51,   52,   23,   46,
+ /*   420 */    25,   48,   61,  178,  235,   24,  244,  139,   27,  240,
+ /*   430 */   172,  173,   52,   60,  172,  173,   66,   72,   73,   74,
+ /*   440 */    75,   76,   77,   78,   79,   80,   81,   82,   83,   84,
+ /*   450 */   164,   86,   87,   88,   89,   90,   91,   92,   93,   94,
+ /*   460 */    95,   96,   20,  212,  153,   24,   24,  153,   27,   25,
+ /*   470 */   225,  226,  227,  112,  104,  164,  225,  226,  227,   23,
+ /*   480 */    24,  102,   92,   27,  198,   27,  175,  176,  108,  175,
+ /*   490 */   176,  233,  113,   51,   52,  233,   23,   24,  117,  213,
+ /*   500 */   214,   23,   24,  122,  139,   25,  164,  117,   28,  198,
+ /*   510 */   253,  141,  122,  253,   72,   73,   74,   75,   76,   77,
+ /*   520 */    78,   79,   80,   81,   82,   83,   84,   71,   86,   87,
+ /*   530 */    88,   89,   90,   91,   92,   93,   94,   95,   96,   20,
+ /*   540 */   198,   27,  228,   24,   71,  145,  146,  147,  148,   71,
+ /*   550 */   116,  153,  118,  119,   32,  196,  197,   99,   36,  109,
+ /*   560 */   110,  111,    0,    1,    2,  223,  153,  208,  182,  183,
+ /*   570 */    51,   52,   50,  175,  176,  153,  190,  167,   98,  169,
+ /*   580 */   170,  158,  240,  125,   67,   28,  153,   24,  175,  176,
+ /*   590 */    27,   72,   73,   74,   75,   76,   77,   78,   79,   80,
+ /*   600 */    81,   82,   83,   84,  153,   86,   87,   88,   89,   90,
+ /*   610 */    91,   92,   93,   94,   95,   96,   20,  195,  153,  221,
+ /*   620 */    24,  153,  209,  171,  172,  173,  175,  176,  171,  172,
+ /*   630 */   173,   28,   28,  165,  166,   27,  153,  120,  121,  153,
+ /*   640 */   175,  176,  138,  153,  140,    7,    8,   51,   52,  101,
+ /*   650 */   102,  213,  214,  220,  231,   98,   28,  234,  175,  176,
+ /*   660 */   209,  175,  176,  248,  249,  175,  176,  245,   72,   73,
+ /*   670 */    74,   75,   76,   77,   78,   79,   80,   81,   82,   83,
+ /*   680 */    84,  153,   86,   87,   88,   89,   90,   91,   92,   93,
+ /*   690 */    94,   95,   96,   20,  153,  197,  153,   24,  153,   20,
+ /*   700 */   153,   98,   98,  175,  176,  153,  208,  153,   29,  153,
+ /*   710 */    23,  153,   24,  153,   24,   27,  175,  176,  175,  176,
+ /*   720 */   175,  176,  175,  176,   51,   52,   98,  175,  176,  175,
+ /*   730 */   176,  175,  176,  175,  176,  175,  176,   24,  164,  131,
+ /*   740 */    27,   24,   23,  164,   27,   72,   73,   74,   75,   76,
+ /*   750 */    77,   78,   79,   80,   81,   82,   83,   84,  153,   86,
+ /*   760 */    87,   88,   89,   90,   91,   92,   93,   94,   95,   96,
+ /*   770 */    20,  153,  198,  153,  164,   25,  153,  198,  120,  121,
+ /*   780 */   175,  176,  153,  164,  153,   24,   24,  153,   27,   27,
+ /*   790 */   153,  169,  170,  175,  176,  175,  176,  153,  175,  176,
+ /*   800 */    25,   51,   52,  153,  175,  176,  175,  176,  198,  175,
+ /*   810 */   176,   24,  175,  176,   27,  164,   12,  198,  153,  175,
+ /*   820 */   176,  164,   72,   73,   74,   75,   76,   77,   78,   79,
+ /*   830 */    80,   81,   82,   83,   84,  153,   86,   87,   88,   89,
+ /*   840 */    90,   91,   92,   93,   94,   95,   96,   20,  153,  198,
+ /*   850 */   153,   27,  153,   24,  153,  198,  153,  175,  176,   67,
+ /*   860 */   195,  153,  164,  153,   23,  153,   24,  153,  147,  148,
+ /*   870 */   175,  176,  175,  176,  175,  176,  175,  176,   51,   52,
+ /*   880 */   153,   54,  153,  175,  176,  175,  176,  175,  176,  175,
+ /*   890 */   176,  241,  189,  101,  153,  153,  198,  153,  153,   72,
+ /*   900 */    73,   74,   75,   76,   77,   78,   79,   80,   81,   82,
+ /*   910 */    83,   84,  153,   86,   87,   88,   89,   90,   91,   92,
+ /*   920 */    93,   94,   95,   96,   20,  153,  153,  153,   27,  153,
+ /*   930 */   189,  189,  153,  189,  175,  176,  153,  153,  153,  153,
+ /*   940 */    24,  153,  153,   24,  153,  192,  193,  175,  176,  175,
+ /*   950 */   176,  175,  176,   95,   96,   51,   52,   24,  175,  176,
+ /*   960 */   175,  176,  189,  175,  176,  220,  175,  176,  241,   37,
+ /*   970 */   241,  153,  153,  153,  195,  153,   72,   73,   74,   75,
+ /*   980 */    76,   77,   78,   79,   80,   81,   82,   83,   84,  153,
+ /*   990 */    86,   87,   88,   89,   90,   91,   92,   93,   94,   95,
+ /*  1000 */    96,   20,  153,  153,  153,   27,  222,   37,  222,  220,
+ /*  1010 */   153,  175,  176,  195,  195,  195,  125,  195,  250,  251,
+ /*  1020 */   192,  193,  174,   23,  175,  176,  175,  176,    1,    2,
+ /*  1030 */   182,   37,   51,   52,   29,   24,  123,   27,   23,  117,
+ /*  1040 */    24,   23,   41,   24,   24,  195,   24,   54,   23,   54,
+ /*  1050 */    24,   23,  195,   72,   73,   74,   75,   76,   77,   78,
+ /*  1060 */    79,   80,   81,   82,   83,   84,   31,   86,   87,   88,
+ /*  1070 */    89,   90,   91,   92,   93,   94,   95,   96,   20,   23,
+ /*  1080 */    23,  106,   23,   54,  113,   20,   25,  108,   21,   45,
+ /*  1090 */    27,   55,   62,   55,  141,  108,   23,    5,    1,  123,
+ /*  1100 */    29,   37,  112,   80,   80,  132,  124,    1,   17,   51,
+ /*  1110 */    52,  126,  124,  121,   21,  112,  132,   17,   24,   24,
+ /*  1120 */    69,   16,   23,  143,    3,  168,    4,  181,  181,  249,
+ /*  1130 */    20,   73,   74,   75,   76,   77,   78,   79,   80,   81,
+ /*  1140 */    82,   83,   84,  152,   86,   87,   88,   89,   90,   91,
+ /*  1150 */    92,   93,   94,   95,   96,  252,    6,  252,  152,  152,
+ /*  1160 */   152,   51,   52,  154,  162,   14,  154,   27,   26,  203,
+ /*  1170 */   131,  204,  129,  128,  205,  127,  163,  130,  206,  180,
+ /*  1180 */    23,  207,  232,   96,   74,   75,   76,   77,   78,   79,
+ /*  1190 */    80,   81,   82,   83,   84,  232,   86,   87,   88,   89,
+ /*  1200 */    90,   91,   92,   93,   94,   95,   96,   20,   21,  160,
+ /*  1210 */    23,   24,  180,  138,  160,   28,   29,  108,  229,  153,
+ /*  1220 */    20,   21,  218,   23,  123,  108,   39,  177,   28,   29,
+ /*  1230 */   164,  217,  177,  126,  217,   49,  107,  185,  217,   39,
+ /*  1240 */   180,  175,  176,  159,   19,   58,  177,  179,  160,  218,
+ /*  1250 */   160,  218,  180,  177,   67,  185,  177,   70,   58,  177,
+ /*  1260 */   177,  159,  159,   47,  198,  138,   72,   23,  160,   19,
+ /*  1270 */    70,  160,  238,  159,  159,  209,  210,   90,   91,  239,
+ /*  1280 */   160,  203,   42,  203,   97,   98,   99,  191,  160,  102,
+ /*  1290 */    90,   91,   92,  160,  160,  191,  243,   97,   98,   99,
+ /*  1300 */    40,  224,  102,  191,  160,  224,   20,   21,  246,   23,
+ /*  1310 */   194,  156,  194,  194,   28,   29,  203,  194,  183,  178,
+ /*  1320 */   133,  134,  135,  136,  137,   39,  200,  202,  243,  151,
+ /*  1330 */   178,  178,  187,  133,  134,  135,  136,  137,  179,  203,
+ /*  1340 */   216,  153,  203,  153,   58,  153,  200,  216,  199,  153,
+ /*  1350 */   153,  153,  215,   67,   20,   21,   70,   23,  153,  216,
+ /*  1360 */   230,  153,   28,   29,  153,  153,  212,  193,  212,  184,
+ /*  1370 */   212,  153,  153,   39,  242,  153,   90,   91,   20,   21,
+ /*  1380 */   242,   23,  153,   97,   98,   99,   28,   29,  102,  153,
+ /*  1390 */   153,  153,   58,  184,  184,  153,  236,   39,  237,  153,
+ /*  1400 */   153,  153,  153,  188,   70,  153,  153,  153,  153,  153,
+ /*  1410 */   153,  153,  153,   67,  153,  153,   58,  153,  153,  133,
+ /*  1420 */   134,  135,  136,  137,   90,   91,  153,  153,   70,  153,
+ /*  1430 */   153,   97,   98,   99,   96,  254,  102,  254,  175,  254,
+ /*  1440 */    23,  175,  175,  254,  254,   28,   29,  254,   90,   91,
+ /*  1450 */   254,  254,  254,  254,  254,   97,   98,   99,  254,  254,
+ /*  1460 */   102,  254,  254,  254,  254,  254,  254,  133,  134,  135,
+ /*  1470 */   136,  137,  254,    5,  254,  254,  254,  254,  254,   11,
+ /*  1480 */    12,   13,   14,   15,  254,  254,   18,   70,  254,  254,
+ /*  1490 */   254,  133,  134,  135,  136,  137,  254,  254,  254,  254,
+ /*  1500 */   254,   33,  254,   35,  254,  254,  254,   90,   91,  254,
+ /*  1510 */   254,  254,   44,  254,  254,   98,  254,  254,  254,  102,
+ /*  1520 */   254,  254,  254,  254,  254,   57,  254,  254,  254,  254,
+ /*  1530 */   254,  254,   64,  254,  254,   67,   68,  254,  254,  254,
+ /*  1540 */   254,  254,  254,  254,  254,  254,  254,  254,  254,  254,
+ /*  1550 */   133,  134,  135,  254,  254,  254,  254,  254,  254,  254,
+ /*  1560 */   254,  254,  254,  254,  254,  254,  254,  254,  254,  254,
+ /*  1570 */   254,  254,  254,  254,  254,  254,  254,  254,  254,  254,
+ /*  1580 */   254,  254,  254,  115,  254,  254,  254,  254,  254,  254,
+ /*  1590 */   254,  254,  254,  254,  254,  254,  254,  254,  254,  254,
+ /*  1600 */   254,  254,  254,  254,  254,  254,  254,  254,  254,  254,
+ /*  1610 */   142,
+};
+#define YY_SHIFT_USE_DFLT (-85)
+#define YY_SHIFT_COUNT (429)
+#define YY_SHIFT_MIN   (-84)
+#define YY_SHIFT_MAX   (1468)
+static const short yy_shift_ofst[] = {
+ /*     0 */  1027, 1187, 1468, 1286, 1334, 1334,    0,  284,  -20,  134,
+ /*    10 */   134,  827, 1334, 1334, 1334, 1334,   68,   68,  136,  207,
+ /*    20 */    96,  517,   57,  750,  673,  596,  519,  442,  365,  288,
+ /*    30 */   211,  904,  904,  904,  904,  904,  904,  904,  904,  904,
+ /*    40 */   904,  904,  904,  904,  904,  904,  981,  904, 1058, 1110,
+ /*    50 */  1110, 1200, 1334, 1334, 1334, 1334, 1334, 1334, 1334, 1334,
+ /*    60 */  1334, 1334, 1334, 1334, 1334, 1334, 1334, 1334, 1334, 1334,
+ /*    70 */  1334, 1334, 1334, 1334, 1334, 1334, 1334, 1334, 1334, 1334,
+ /*    80 */  1358, 1334, 1334, 1334, 1334, 1334, 1334, 1334, 1334, 1334,
+ /*    90 */  1334, 1334, 1334, 1334,  -72,  -48,  -48,  -48,  -48,  -48,
+ /*   100 */    -1,   25,  -13,   96,   96,  370,  289,  -84,  -84,  858,
+ /*   110 */   658,  628, 1338,  -85,  -85,  -85,   87,  373,  373,  214,
+ /*   120 */   456,  248,   96,   96,   96,   96,   96,   96,   96,   96,
+ /*   130 */    96,   96,   96,   96,   96,   96,   96,   96,   96,   96,
+ /*   140 */    96,   96,   96,   96,  562,  792,  628,  658, 1346, 1346,
+ /*   150 */  1346, 1346, 1346, 1346,  -85,  -85,  -85, 1417,  135,  135,
+ /*   160 */   221,   73,  212,  153,  151,   99,   96,   96,   96,   96,
+ /*   170 */    96,   96,   96,   96,   96,   96,   96,   96,   96,   96,
+ /*   180 */    96,   96,   96,  361,  361,  361,   96,   96,  133,   96,
+ /*   190 */    96,   96,   96,   96,  231,   96,   96,   96,   96,   96,
+ /*   200 */    96,   96,   96,   96,   96,   -6,  450,  522,  480,  480,
+ /*   210 */   480,  458,  434,  390,  608,  300,  300,  679,  608,  679,
+ /*   220 */   238,  787,  380,  362,  300,  504,  362,  362,   79,  381,
+ /*   230 */   395, 1260, 1101, 1101, 1240, 1240, 1101, 1244, 1194, 1039,
+ /*   240 */  1250, 1250, 1250, 1250, 1101, 1225, 1039, 1244, 1194, 1194,
+ /*   250 */  1039, 1101, 1225, 1127, 1216, 1101, 1101, 1225, 1101, 1225,
+ /*   260 */  1101, 1225, 1157, 1117, 1117, 1117, 1186, 1157, 1117, 1129,
+ /*   270 */  1117, 1186, 1117, 1117, 1107, 1109, 1107, 1109, 1107, 1109,
+ /*   280 */  1101, 1101, 1075, 1157, 1087, 1087, 1157, 1047, 1048, 1043,
+ /*   290 */  1045, 1039, 1142, 1140, 1151, 1151, 1150, 1150, 1150, 1150,
+ /*   300 */   -85,  -85,  -85,  -85,  -85,  -85,  271,  217,  478,  473,
+ /*   310 */   335,    1,  308,  762,  119,  761,  717,  713,  688,  604,
+ /*   320 */   548,  638,  379,  563,  441,  603,  401,  126,  105,  377,
+ /*   330 */   557,  141, 1122, 1121, 1099,  980, 1105, 1051, 1100, 1095,
+ /*   340 */  1094,  992,  984, 1003,  988, 1093,  985, 1091, 1106,  982,
+ /*   350 */   973, 1024, 1023,  990, 1071, 1064,  976, 1097, 1092, 1073,
+ /*   360 */   987,  953, 1038, 1063, 1036, 1030, 1044,  979, 1061, 1067,
+ /*   370 */  1065,  971,  975, 1059, 1029, 1057, 1056, 1026, 1028,  995,
+ /*   380 */  1035, 1025,  993, 1001, 1022, 1020, 1019,  922, 1018, 1016,
+ /*   390 */  1015, 1010,  913, 1011, 1005,  994, 1000,  891,  901,  970,
+ /*   400 */   978,  932,  901,  933,  919,  916,  824,  842,  841,  804,
+ /*   410 */   829,  719,  775,  514,  690,  687,  444,  514,  313,  310,
+ /*   420 */   290,  272,  100,  125,   61,   39,  -58,   27,   21,   29,
+};
+#define YY_REDUCE_USE_DFLT (-201)
+#define YY_REDUCE_COUNT (305)
+#define YY_REDUCE_MIN   (-200)
+#define YY_REDUCE_MAX   (1277)
+static const short yy_reduce_ofst[] = {
+ /*     0 */   400, 1066,    6,  311,  181,  179,  162,  189,  251,  245,
+ /*    10 */   -52,  182,  451,  413,  398,  314,  262,  258,   58,  342,
+ /*    20 */   177,  286, -200, -200, -200, -200, -200, -200, -200, -200,
+ /*    30 */  -200, -200, -200, -200, -200, -200, -200, -200, -200, -200,
+ /*    40 */  -200, -200, -200, -200, -200, -200, -200, -200, -200, -200,
+ /*    50 */  -200,  851,  849,  836,  791,  788,  785,  783,  776,  774,
+ /*    60 */   772,  759,  714,  712,  710,  708,  701,  699,  697,  695,
+ /*    70 */   682,  644,  637,  634,  631,  629,  623,  620,  618,  605,
+ /*    80 */   560,  558,  556,  554,  552,  547,  545,  543,  541,  528,
+ /*    90 */   490,  486,  483,  465, -200, -200, -200, -200, -200, -200,
+ /*   100 */  -200, -200, -200,  468,  422,  423,  386,  457,  452, -200,
+ /*   110 */   359,  410, -200, -200, -200, -200,  848,  828,  753,  260,
+ /*   120 */   768,  768,  857,  786,  850,  822,  820,  819,  818,  779,
+ /*   130 */   729,  789,  727,  784,  650,  773,  745,  665,  744,  742,
+ /*   140 */   741,  433,  257,  703,  721,  657,  622,  498,  698,  651,
+ /*   150 */   619,  610,  579,  574,  415,  438,  148, 1267, 1266, 1263,
+ /*   160 */  1215, 1205, 1277, 1276, 1274, 1273, 1265, 1264, 1262, 1261,
+ /*   170 */  1259, 1258, 1257, 1256, 1255, 1254, 1253, 1252, 1249, 1248,
+ /*   180 */  1247, 1246, 1242, 1210, 1209, 1185, 1238, 1237, 1137, 1236,
+ /*   190 */  1229, 1222, 1219, 1218, 1174, 1212, 1211, 1208, 1205, 1198,
+ /*   200 */  1197, 1196, 1192, 1190, 1188, 1178, 1161, 1160, 1158, 1156,
+ /*   210 */  1154, 1137, 1149, 1146, 1139, 1143, 1131, 1138, 1136, 1132,
+ /*   220 */  1159, 1145, 1135, 1153, 1124, 1130, 1152, 1141, 1125, 1126,
+ /*   230 */  1155, 1062, 1144, 1134, 1085, 1053, 1133, 1081, 1112, 1113,
+ /*   240 */  1123, 1119, 1118, 1116, 1128, 1115, 1080, 1077, 1104, 1096,
+ /*   250 */  1078, 1120, 1114, 1040, 1034, 1111, 1108, 1103, 1090, 1102,
+ /*   260 */  1088, 1084, 1072, 1083, 1082, 1079, 1070, 1060, 1076, 1068,
+ /*   270 */  1069, 1052, 1055, 1050, 1033, 1021, 1031, 1017, 1004, 1014,
+ /*   280 */  1054, 1049,  989, 1032,  963,  950,  999,  974,  972,  969,
+ /*   290 */   967,  966, 1013, 1002, 1012, 1009, 1008, 1007, 1006,  991,
+ /*   300 */   905,  903,  880,  947,  946,  957,
+};
+static const YYACTIONTYPE yy_default[] = {
+ /*     0 */   648,  966,  966,  966,  880,  880,  971,  966,  776,  804,
+ /*    10 */   804,  940,  971,  971,  971,  878,  971,  971,  971,  966,
+ /*    20 */   971,  780,  810,  971,  971,  971,  971,  971,  971,  971,
+ /*    30 */   971,  939,  941,  818,  817,  920,  791,  815,  808,  812,
+ /*    40 */   881,  874,  875,  873,  877,  882,  971,  811,  843,  858,
+ /*    50 */   842,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*    60 */   971,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*    70 */   971,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*    80 */   971,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*    90 */   971,  971,  971,  971,  852,  857,  864,  856,  853,  845,
+ /*   100 */   844,  846,  847,  971,  971,  675,  741,  971,  971,  848,
+ /*   110 */   971,  687,  849,  861,  860,  859,  682,  971,  971,  971,
+ /*   120 */   971,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*   130 */   971,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*   140 */   971,  971,  971,  971,  648,  966,  971,  971,  966,  966,
+ /*   150 */   966,  966,  966,  966,  958,  780,  770,  971,  971,  971,
+ /*   160 */   971,  971,  971,  971,  971,  971,  971,  946,  944,  971,
+ /*   170 */   893,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*   180 */   971,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*   190 */   971,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*   200 */   971,  971,  971,  971,  654,  656,  971,  913,  776,  776,
+ /*   210 */   776,  778,  756,  768,  814,  793,  793,  925,  814,  925,
+ /*   220 */   712,  735,  709,  804,  793,  876,  804,  804,  777,  768,
+ /*   230 */   971,  951,  784,  784,  943,  943,  784,  823,  745,  814,
+ /*   240 */   752,  752,  752,  752,  784,  672,  814,  823,  745,  745,
+ /*   250 */   814,  784,  672,  919,  917,  784,  784,  672,  784,  672,
+ /*   260 */   784,  672,  886,  743,  743,  743,  727,  886,  743,  712,
+ /*   270 */   743,  727,  743,  743,  797,  792,  797,  792,  797,  792,
+ /*   280 */   784,  784,  971,  886,  890,  890,  886,  809,  798,  807,
+ /*   290 */   805,  814,  678,  730,  665,  665,  653,  653,  653,  653,
+ /*   300 */   963,  963,  958,  714,  714,  697,  971,  971,  971,  971,
+ /*   310 */   971,  971,  689,  971,  895,  971,  971,  971,  971,  971,
+ /*   320 */   971,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*   330 */   971,  830,  971,  649,  953,  971,  971,  950,  971,  971,
+ /*   340 */   971,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*   350 */   971,  971,  971,  971,  971,  971,  923,  971,  971,  971,
+ /*   360 */   971,  971,  971,  916,  915,  971,  971,  971,  971,  971,
+ /*   370 */   971,  971,  971,  971,  971,  971,  971,  971,  971,  971,
+ /*   380 */   971,  971,  971,  971,  971,  971,  971,  759,  971,  971,
+ /*   390 */   971,  763,  971,  971,  971,  971,  971,  971,  806,  971,
+ /*   400 */   799,  971,  879,  971,  971,  971,  971,  971,  971,  971,
+ /*   410 */   971,  971,  971,  968,  971,  971,  971,  967,  971,  971,
+ /*   420 */   971,  971,  971,  832,  971,  831,  835,  971,  663,  971,
+ /*   430 */   645,  650,  962,  965,  964,  961,  960,  959,  954,  952,
+ /*   440 */   949,  948,  947,  945,  942,  938,  899,  897,  904,  903,
+ /*   450 */   902,  901,  900,  898,  896,  894,  820,  819,  816,  813,
+ /*   460 */   755,  937,  892,  754,  751,  750,  671,  955,  922,  931,
+ /*   470 */   930,  929,  824,  928,  927,  926,  924,  921,  908,  822,
+ /*   480 */   821,  746,  884,  883,  674,  912,  911,  910,  914,  918,
+ /*   490 */   909,  786,  753,  673,  670,  677,  681,  733,  734,  742,
+ /*   500 */   740,  739,  738,  737,  736,  732,  683,  688,  726,  711,
+ /*   510 */   710,  719,  718,  724,  723,  722,  721,  720,  717,  716,
+ /*   520 */   715,  708,  707,  713,  706,  729,  728,  725,  705,  749,
+ /*   530 */   748,  747,  744,  704,  703,  702,  835,  701,  700,  840,
+ /*   540 */   839,  868,  828,  757,  761,  760,  764,  765,  773,  772,
+ /*   550 */   771,  782,  783,  795,  794,  826,  825,  796,  781,  775,
+ /*   560 */   774,  790,  789,  788,  787,  779,  769,  801,  800,  870,
+ /*   570 */   785,  869,  867,  936,  935,  934,  933,  932,  872,  969,
+ /*   580 */   970,  889,  891,  888,  803,  802,  887,  871,  841,  838,
+ /*   590 */   692,  693,  907,  906,  905,  695,  694,  691,  690,  865,
+ /*   600 */   862,  854,  866,  863,  855,  851,  850,  836,  834,  833,
+ /*   610 */   829,  837,  762,  758,  827,  767,  766,  699,  698,  696,
+ /*   620 */   680,  679,  676,  669,  667,  666,  668,  664,  662,  661,
+ /*   630 */   660,  659,  658,  657,  686,  685,  684,  655,  652,  651,
+ /*   640 */   647,  646,  644,
+};
+
+/* The next table maps tokens into fallback tokens.  If a construct
+** like the following:
+** 
+**      %fallback ID X Y Z.
+**
+** appears in the grammar, then ID becomes a fallback token for X, Y,
+** and Z.  Whenever one of the tokens X, Y, or Z is input to the parser
+** but it does not parse, the type of the token is changed to ID and
+** the parse is retried before an error is thrown.
+*/
+#ifdef YYFALLBACK
+static const YYCODETYPE yyFallback[] = {
+    0,  /*          $ => nothing */
+    0,  /*       SEMI => nothing */
+   28,  /*    EXPLAIN => ID */
+   28,  /*      QUERY => ID */
+   28,  /*       PLAN => ID */
+   28,  /*      BEGIN => ID */
+    0,  /* TRANSACTION => nothing */
+   28,  /*   DEFERRED => ID */
+   28,  /*  IMMEDIATE => ID */
+   28,  /*  EXCLUSIVE => ID */
+   28,  /* CONCURRENT => ID */
+    0,  /*     COMMIT => nothing */
+   28,  /*        END => ID */
+   28,  /*   ROLLBACK => ID */
+   28,  /*  SAVEPOINT => ID */
+   28,  /*    RELEASE => ID */
+    0,  /*         TO => nothing */
+    0,  /*      TABLE => nothing */
+    0,  /*     CREATE => nothing */
+   28,  /*         IF => ID */
+    0,  /*        NOT => nothing */
+    0,  /*     EXISTS => nothing */
+   28,  /*       TEMP => ID */
+    0,  /*         LP => nothing */
+    0,  /*         RP => nothing */
+    0,  /*         AS => nothing */
+   28,  /*    WITHOUT => ID */
+    0,  /*      COMMA => nothing */
+    0,  /*         ID => nothing */
+    0,  /*    INDEXED => nothing */
+   28,  /*      ABORT => ID */
+   28,  /*     ACTION => ID */
+   28,  /*      AFTER => ID */
+   28,  /*    ANALYZE => ID */
+   28,  /*        ASC => ID */
+   28,  /*     ATTACH => ID */
+   28,  /*     BEFORE => ID */
+   28,  /*         BY => ID */
+   28,  /*    CASCADE => ID */
+   28,  /*       CAST => ID */
+   28,  /*   COLUMNKW => ID */
+   28,  /*   CONFLICT => ID */
+   28,  /*   DATABASE => ID */
+   28,  /*       DESC => ID */
+   28,  /*     DETACH => ID */
+   28,  /*       EACH => ID */
+   28,  /*       FAIL => ID */
+   28,  /*        FOR => ID */
+   28,  /*     IGNORE => ID */
+   28,  /*  INITIALLY => ID */
+   28,  /*    INSTEAD => ID */
+   28,  /*    LIKE_KW => ID */
+   28,  /*      MATCH => ID */
+   28,  /*         NO => ID */
+   28,  /*        KEY => ID */
+   28,  /*         OF => ID */
+   28,  /*     OFFSET => ID */
+   28,  /*     PRAGMA => ID */
+   28,  /*      RAISE => ID */
+   28,  /*  RECURSIVE => ID */
+   28,  /*    REPLACE => ID */
+   28,  /*   RESTRICT => ID */
+   28,  /*        ROW => ID */
+   28,  /*    TRIGGER => ID */
+   28,  /*     VACUUM => ID */
+   28,  /*       VIEW => ID */
+   28,  /*    VIRTUAL => ID */
+   28,  /*       WITH => ID */
+   28,  /*    REINDEX => ID */
+   28,  /*     RENAME => ID */
+   28,  /*   CTIME_KW => ID */
+};
+#endif /* YYFALLBACK */
+
+/* The following structure represents a single element of the
+** parser's stack.  Information stored includes:
+**
+**   +  The state number for the parser at this level of the stack.
+**
+**   +  The value of the token stored at this level of the stack.
+**      (In other words, the "major" token.)
+**
+**   +  The semantic value stored at this level of the stack.  This is
+**      the information used by the action routines in the grammar.
+**      It is sometimes called the "minor" token.
+*/
+struct yyStackEntry {
+  YYACTIONTYPE stateno;  /* The state-number */
+  YYCODETYPE major;      /* The major token value.  This is the code
+                         ** number for the token at this stack level */
+  YYMINORTYPE minor;     /* The user-supplied minor token value.  This
+                         ** is the value of the token  */
+};
+typedef struct yyStackEntry yyStackEntry;
+
+/* The state of the parser is completely contained in an instance of
+** the following structure */
+struct yyParser {
+  int yyidx;                    /* Index of top element in stack */
+#ifdef YYTRACKMAXSTACKDEPTH
+  int yyidxMax;                 /* Maximum value of yyidx */
+#endif
+  int yyerrcnt;                 /* Shifts left before out of the error */
+  sqlite3ParserARG_SDECL                /* A place to hold %extra_argument */
+#if YYSTACKDEPTH<=0
+  int yystksz;                  /* Current side of the stack */
+  yyStackEntry *yystack;        /* The parser's stack */
+#else
+  yyStackEntry yystack[YYSTACKDEPTH];  /* The parser's stack */
+#endif
+};
+typedef struct yyParser yyParser;
+
+#ifndef NDEBUG
+#include <stdio.h>
+static FILE *yyTraceFILE = 0;
+static char *yyTracePrompt = 0;
+#endif /* NDEBUG */
+
+#ifndef NDEBUG
+/* 
+** Turn parser tracing on by giving a stream to which to write the trace
+** and a prompt to preface each trace message.  Tracing is turned off
+** by making either argument NULL 
+**
+** Inputs:
+** <ul>
+** <li> A FILE* to which trace output should be written.
+**      If NULL, then tracing is turned off.
+** <li> A prefix string written at the beginning of every
+**      line of trace output.  If NULL, then tracing is
+**      turned off.
+** </ul>
+**
+** Outputs:
+** None.
+*/
+void sqlite3ParserTrace(FILE *TraceFILE, char *zTracePrompt){
+  yyTraceFILE = TraceFILE;
+  yyTracePrompt = zTracePrompt;
+  if( yyTraceFILE==0 ) yyTracePrompt = 0;
+  else if( yyTracePrompt==0 ) yyTraceFILE = 0;
+}
+#endif /* NDEBUG */
+
+#ifndef NDEBUG
+/* For tracing shifts, the names of all terminals and nonterminals
+** are required.  The following table supplies these names */
+static const char *const yyTokenName[] = { 
+  "$",             "SEMI",          "EXPLAIN",       "QUERY",       
+  "PLAN",          "BEGIN",         "TRANSACTION",   "DEFERRED",    
+  "IMMEDIATE",     "EXCLUSIVE",     "CONCURRENT",    "COMMIT",      
+  "END",           "ROLLBACK",      "SAVEPOINT",     "RELEASE",     
+  "TO",            "TABLE",         "CREATE",        "IF",          
+  "NOT",           "EXISTS",        "TEMP",          "LP",          
+  "RP",            "AS",            "WITHOUT",       "COMMA",       
+  "ID",            "INDEXED",       "ABORT",         "ACTION",      
+  "AFTER",         "ANALYZE",       "ASC",           "ATTACH",      
+  "BEFORE",        "BY",            "CASCADE",       "CAST",        
+  "COLUMNKW",      "CONFLICT",      "DATABASE",      "DESC",        
+  "DETACH",        "EACH",          "FAIL",          "FOR",         
+  "IGNORE",        "INITIALLY",     "INSTEAD",       "LIKE_KW",     
+  "MATCH",         "NO",            "KEY",           "OF",          
+  "OFFSET",        "PRAGMA",        "RAISE",         "RECURSIVE",   
+  "REPLACE",       "RESTRICT",      "ROW",           "TRIGGER",     
+  "VACUUM",        "VIEW",          "VIRTUAL",       "WITH",        
+  "REINDEX",       "RENAME",        "CTIME_KW",      "ANY",         
+  "OR",            "AND",           "IS",            "BETWEEN",     
+  "IN",            "ISNULL",        "NOTNULL",       "NE",          
+  "EQ",            "GT",            "LE",            "LT",          
+  "GE",            "ESCAPE",        "BITAND",        "BITOR",       
+  "LSHIFT",        "RSHIFT",        "PLUS",          "MINUS",       
+  "STAR",          "SLASH",         "REM",           "CONCAT",      
+  "COLLATE",       "BITNOT",        "STRING",        "JOIN_KW",     
+  "CONSTRAINT",    "DEFAULT",       "NULL",          "PRIMARY",     
+  "UNIQUE",        "CHECK",         "REFERENCES",    "AUTOINCR",    
+  "ON",            "INSERT",        "DELETE",        "UPDATE",      
+  "SET",           "DEFERRABLE",    "FOREIGN",       "DROP",        
+  "UNION",         "ALL",           "EXCEPT",        "INTERSECT",   
+  "SELECT",        "VALUES",        "DISTINCT",      "DOT",         
+  "FROM",          "JOIN",          "USING",         "ORDER",       
+  "GROUP",         "HAVING",        "LIMIT",         "WHERE",       
+  "INTO",          "INTEGER",       "FLOAT",         "BLOB",        
+  "VARIABLE",      "CASE",          "WHEN",          "THEN",        
+  "ELSE",          "INDEX",         "ALTER",         "ADD",         
+  "error",         "input",         "cmdlist",       "ecmd",        
+  "explain",       "cmdx",          "cmd",           "transtype",   
+  "trans_opt",     "nm",            "savepoint_opt",  "create_table",
+  "create_table_args",  "createkw",      "temp",          "ifnotexists", 
+  "dbnm",          "columnlist",    "conslist_opt",  "table_options",
+  "select",        "column",        "columnid",      "type",        
+  "carglist",      "typetoken",     "typename",      "signed",      
+  "plus_num",      "minus_num",     "ccons",         "term",        
+  "expr",          "onconf",        "sortorder",     "autoinc",     
+  "idxlist_opt",   "refargs",       "defer_subclause",  "refarg",      
+  "refact",        "init_deferred_pred_opt",  "conslist",      "tconscomma",  
+  "tcons",         "idxlist",       "defer_subclause_opt",  "orconf",      
+  "resolvetype",   "raisetype",     "ifexists",      "fullname",    
+  "selectnowith",  "oneselect",     "with",          "multiselect_op",
+  "distinct",      "selcollist",    "from",          "where_opt",   
+  "groupby_opt",   "having_opt",    "orderby_opt",   "limit_opt",   
+  "values",        "nexprlist",     "exprlist",      "sclp",        
+  "as",            "seltablist",    "stl_prefix",    "joinop",      
+  "indexed_opt",   "on_opt",        "using_opt",     "joinop2",     
+  "idlist",        "sortlist",      "setlist",       "insert_cmd",  
+  "inscollist_opt",  "likeop",        "between_op",    "in_op",       
+  "case_operand",  "case_exprlist",  "case_else",     "uniqueflag",  
+  "collate",       "nmnum",         "trigger_decl",  "trigger_cmd_list",
+  "trigger_time",  "trigger_event",  "foreach_clause",  "when_clause", 
+  "trigger_cmd",   "trnm",          "tridxby",       "database_kw_opt",
+  "key_opt",       "add_column_fullname",  "kwcolumn_opt",  "create_vtab", 
+  "vtabarglist",   "vtabarg",       "vtabargtoken",  "lp",          
+  "anylist",       "wqlist",      
+};
+#endif /* NDEBUG */
+
+#ifndef NDEBUG
+/* For tracing reduce actions, the names of all rules are required.
+*/
+static const char *const yyRuleName[] = {
+ /*   0 */ "input ::= cmdlist",
+ /*   1 */ "cmdlist ::= cmdlist ecmd",
+ /*   2 */ "cmdlist ::= ecmd",
+ /*   3 */ "ecmd ::= SEMI",
+ /*   4 */ "ecmd ::= explain cmdx SEMI",
+ /*   5 */ "explain ::=",
+ /*   6 */ "explain ::= EXPLAIN",
+ /*   7 */ "explain ::= EXPLAIN QUERY PLAN",
+ /*   8 */ "cmdx ::= cmd",
+ /*   9 */ "cmd ::= BEGIN transtype trans_opt",
+ /*  10 */ "trans_opt ::=",
+ /*  11 */ "trans_opt ::= TRANSACTION",
+ /*  12 */ "trans_opt ::= TRANSACTION nm",
+ /*  13 */ "transtype ::=",
+ /*  14 */ "transtype ::= DEFERRED",
+ /*  15 */ "transtype ::= IMMEDIATE",
+ /*  16 */ "transtype ::= EXCLUSIVE",
+ /*  17 */ "transtype ::= CONCURRENT",
+ /*  18 */ "cmd ::= COMMIT trans_opt",
+ /*  19 */ "cmd ::= END trans_opt",
+ /*  20 */ "cmd ::= ROLLBACK trans_opt",
+ /*  21 */ "savepoint_opt ::= SAVEPOINT",
+ /*  22 */ "savepoint_opt ::=",
+ /*  23 */ "cmd ::= SAVEPOINT nm",
+ /*  24 */ "cmd ::= RELEASE savepoint_opt nm",
+ /*  25 */ "cmd ::= ROLLBACK trans_opt TO savepoint_opt nm",
+ /*  26 */ "cmd ::= create_table create_table_args",
+ /*  27 */ "create_table ::= createkw temp TABLE ifnotexists nm dbnm",
+ /*  28 */ "createkw ::= CREATE",
+ /*  29 */ "ifnotexists ::=",
+ /*  30 */ "ifnotexists ::= IF NOT EXISTS",
+ /*  31 */ "temp ::= TEMP",
+ /*  32 */ "temp ::=",
+ /*  33 */ "create_table_args ::= LP columnlist conslist_opt RP table_options",
+ /*  34 */ "create_table_args ::= AS select",
+ /*  35 */ "table_options ::=",
+ /*  36 */ "table_options ::= WITHOUT nm",
+ /*  37 */ "columnlist ::= columnlist COMMA column",
+ /*  38 */ "columnlist ::= column",
+ /*  39 */ "column ::= columnid type carglist",
+ /*  40 */ "columnid ::= nm",
+ /*  41 */ "nm ::= ID|INDEXED",
+ /*  42 */ "nm ::= STRING",
+ /*  43 */ "nm ::= JOIN_KW",
+ /*  44 */ "type ::=",
+ /*  45 */ "type ::= typetoken",
+ /*  46 */ "typetoken ::= typename",
+ /*  47 */ "typetoken ::= typename LP signed RP",
+ /*  48 */ "typetoken ::= typename LP signed COMMA signed RP",
+ /*  49 */ "typename ::= ID|STRING",
+ /*  50 */ "typename ::= typename ID|STRING",
+ /*  51 */ "signed ::= plus_num",
+ /*  52 */ "signed ::= minus_num",
+ /*  53 */ "carglist ::= carglist ccons",
+ /*  54 */ "carglist ::=",
+ /*  55 */ "ccons ::= CONSTRAINT nm",
+ /*  56 */ "ccons ::= DEFAULT term",
+ /*  57 */ "ccons ::= DEFAULT LP expr RP",
+ /*  58 */ "ccons ::= DEFAULT PLUS term",
+ /*  59 */ "ccons ::= DEFAULT MINUS term",
+ /*  60 */ "ccons ::= DEFAULT ID|INDEXED",
+ /*  61 */ "ccons ::= NULL onconf",
+ /*  62 */ "ccons ::= NOT NULL onconf",
+ /*  63 */ "ccons ::= PRIMARY KEY sortorder onconf autoinc",
+ /*  64 */ "ccons ::= UNIQUE onconf",
+ /*  65 */ "ccons ::= CHECK LP expr RP",
+ /*  66 */ "ccons ::= REFERENCES nm idxlist_opt refargs",
+ /*  67 */ "ccons ::= defer_subclause",
+ /*  68 */ "ccons ::= COLLATE ID|STRING",
+ /*  69 */ "autoinc ::=",
+ /*  70 */ "autoinc ::= AUTOINCR",
+ /*  71 */ "refargs ::=",
+ /*  72 */ "refargs ::= refargs refarg",
+ /*  73 */ "refarg ::= MATCH nm",
+ /*  74 */ "refarg ::= ON INSERT refact",
+ /*  75 */ "refarg ::= ON DELETE refact",
+ /*  76 */ "refarg ::= ON UPDATE refact",
+ /*  77 */ "refact ::= SET NULL",
+ /*  78 */ "refact ::= SET DEFAULT",
+ /*  79 */ "refact ::= CASCADE",
+ /*  80 */ "refact ::= RESTRICT",
+ /*  81 */ "refact ::= NO ACTION",
+ /*  82 */ "defer_subclause ::= NOT DEFERRABLE init_deferred_pred_opt",
+ /*  83 */ "defer_subclause ::= DEFERRABLE init_deferred_pred_opt",
+ /*  84 */ "init_deferred_pred_opt ::=",
+ /*  85 */ "init_deferred_pred_opt ::= INITIALLY DEFERRED",
+ /*  86 */ "init_deferred_pred_opt ::= INITIALLY IMMEDIATE",
+ /*  87 */ "conslist_opt ::=",
+ /*  88 */ "conslist_opt ::= COMMA conslist",
+ /*  89 */ "conslist ::= conslist tconscomma tcons",
+ /*  90 */ "conslist ::= tcons",
+ /*  91 */ "tconscomma ::= COMMA",
+ /*  92 */ "tconscomma ::=",
+ /*  93 */ "tcons ::= CONSTRAINT nm",
+ /*  94 */ "tcons ::= PRIMARY KEY LP idxlist autoinc RP onconf",
+ /*  95 */ "tcons ::= UNIQUE LP idxlist RP onconf",
+ /*  96 */ "tcons ::= CHECK LP expr RP onconf",
+ /*  97 */ "tcons ::= FOREIGN KEY LP idxlist RP REFERENCES nm idxlist_opt refargs defer_subclause_opt",
+ /*  98 */ "defer_subclause_opt ::=",
+ /*  99 */ "defer_subclause_opt ::= defer_subclause",
+ /* 100 */ "onconf ::=",
+ /* 101 */ "onconf ::= ON CONFLICT resolvetype",
+ /* 102 */ "orconf ::=",
+ /* 103 */ "orconf ::= OR resolvetype",
+ /* 104 */ "resolvetype ::= raisetype",
+ /* 105 */ "resolvetype ::= IGNORE",
+ /* 106 */ "resolvetype ::= REPLACE",
+ /* 107 */ "cmd ::= DROP TABLE ifexists fullname",
+ /* 108 */ "ifexists ::= IF EXISTS",
+ /* 109 */ "ifexists ::=",
+ /* 110 */ "cmd ::= createkw temp VIEW ifnotexists nm dbnm AS select",
+ /* 111 */ "cmd ::= DROP VIEW ifexists fullname",
+ /* 112 */ "cmd ::= select",
+ /* 113 */ "select ::= with selectnowith",
+ /* 114 */ "selectnowith ::= oneselect",
+ /* 115 */ "selectnowith ::= selectnowith multiselect_op oneselect",
+ /* 116 */ "multiselect_op ::= UNION",
+ /* 117 */ "multiselect_op ::= UNION ALL",
+ /* 118 */ "multiselect_op ::= EXCEPT|INTERSECT",
+ /* 119 */ "oneselect ::= SELECT distinct selcollist from where_opt groupby_opt having_opt orderby_opt limit_opt",
+ /* 120 */ "oneselect ::= values",
+ /* 121 */ "values ::= VALUES LP nexprlist RP",
+ /* 122 */ "values ::= values COMMA LP exprlist RP",
+ /* 123 */ "distinct ::= DISTINCT",
+ /* 124 */ "distinct ::= ALL",
+ /* 125 */ "distinct ::=",
+ /* 126 */ "sclp ::= selcollist COMMA",
+ /* 127 */ "sclp ::=",
+ /* 128 */ "selcollist ::= sclp expr as",
+ /* 129 */ "selcollist ::= sclp STAR",
+ /* 130 */ "selcollist ::= sclp nm DOT STAR",
+ /* 131 */ "as ::= AS nm",
+ /* 132 */ "as ::= ID|STRING",
+ /* 133 */ "as ::=",
+ /* 134 */ "from ::=",
+ /* 135 */ "from ::= FROM seltablist",
+ /* 136 */ "stl_prefix ::= seltablist joinop",
+ /* 137 */ "stl_prefix ::=",
+ /* 138 */ "seltablist ::= stl_prefix nm dbnm as indexed_opt on_opt using_opt",
+ /* 139 */ "seltablist ::= stl_prefix LP select RP as on_opt using_opt",
+ /* 140 */ "seltablist ::= stl_prefix LP seltablist RP as on_opt using_opt",
+ /* 141 */ "dbnm ::=",
+ /* 142 */ "dbnm ::= DOT nm",
+ /* 143 */ "fullname ::= nm dbnm",
+ /* 144 */ "joinop ::= COMMA|JOIN",
+ /* 145 */ "joinop ::= JOIN_KW JOIN",
+ /* 146 */ "joinop ::= JOIN_KW nm JOIN",
+ /* 147 */ "joinop ::= JOIN_KW nm nm JOIN",
+ /* 148 */ "on_opt ::= ON expr",
+ /* 149 */ "on_opt ::=",
+ /* 150 */ "indexed_opt ::=",
+ /* 151 */ "indexed_opt ::= INDEXED BY nm",
+ /* 152 */ "indexed_opt ::= NOT INDEXED",
+ /* 153 */ "using_opt ::= USING LP idlist RP",
+ /* 154 */ "using_opt ::=",
+ /* 155 */ "orderby_opt ::=",
+ /* 156 */ "orderby_opt ::= ORDER BY sortlist",
+ /* 157 */ "sortlist ::= sortlist COMMA expr sortorder",
+ /* 158 */ "sortlist ::= expr sortorder",
+ /* 159 */ "sortorder ::= ASC",
+ /* 160 */ "sortorder ::= DESC",
+ /* 161 */ "sortorder ::=",
+ /* 162 */ "groupby_opt ::=",
+ /* 163 */ "groupby_opt ::= GROUP BY nexprlist",
+ /* 164 */ "having_opt ::=",
+ /* 165 */ "having_opt ::= HAVING expr",
+ /* 166 */ "limit_opt ::=",
+ /* 167 */ "limit_opt ::= LIMIT expr",
+ /* 168 */ "limit_opt ::= LIMIT expr OFFSET expr",
+ /* 169 */ "limit_opt ::= LIMIT expr COMMA expr",
+ /* 170 */ "cmd ::= with DELETE FROM fullname indexed_opt where_opt",
+ /* 171 */ "where_opt ::=",
+ /* 172 */ "where_opt ::= WHERE expr",
+ /* 173 */ "cmd ::= with UPDATE orconf fullname indexed_opt SET setlist where_opt",
+ /* 174 */ "setlist ::= setlist COMMA nm EQ expr",
+ /* 175 */ "setlist ::= nm EQ expr",
+ /* 176 */ "cmd ::= with insert_cmd INTO fullname inscollist_opt select",
+ /* 177 */ "cmd ::= with insert_cmd INTO fullname inscollist_opt DEFAULT VALUES",
+ /* 178 */ "insert_cmd ::= INSERT orconf",
+ /* 179 */ "insert_cmd ::= REPLACE",
+ /* 180 */ "inscollist_opt ::=",
+ /* 181 */ "inscollist_opt ::= LP idlist RP",
+ /* 182 */ "idlist ::= idlist COMMA nm",
+ /* 183 */ "idlist ::= nm",
+ /* 184 */ "expr ::= term",
+ /* 185 */ "expr ::= LP expr RP",
+ /* 186 */ "term ::= NULL",
+ /* 187 */ "expr ::= ID|INDEXED",
+ /* 188 */ "expr ::= JOIN_KW",
+ /* 189 */ "expr ::= nm DOT nm",
+ /* 190 */ "expr ::= nm DOT nm DOT nm",
+ /* 191 */ "term ::= INTEGER|FLOAT|BLOB",
+ /* 192 */ "term ::= STRING",
+ /* 193 */ "expr ::= VARIABLE",
+ /* 194 */ "expr ::= expr COLLATE ID|STRING",
+ /* 195 */ "expr ::= CAST LP expr AS typetoken RP",
+ /* 196 */ "expr ::= ID|INDEXED LP distinct exprlist RP",
+ /* 197 */ "expr ::= ID|INDEXED LP STAR RP",
+ /* 198 */ "term ::= CTIME_KW",
+ /* 199 */ "expr ::= expr AND expr",
+ /* 200 */ "expr ::= expr OR expr",
+ /* 201 */ "expr ::= expr LT|GT|GE|LE expr",
+ /* 202 */ "expr ::= expr EQ|NE expr",
+ /* 203 */ "expr ::= expr BITAND|BITOR|LSHIFT|RSHIFT expr",
+ /* 204 */ "expr ::= expr PLUS|MINUS expr",
+ /* 205 */ "expr ::= expr STAR|SLASH|REM expr",
+ /* 206 */ "expr ::= expr CONCAT expr",
+ /* 207 */ "likeop ::= LIKE_KW|MATCH",
+ /* 208 */ "likeop ::= NOT LIKE_KW|MATCH",
+ /* 209 */ "expr ::= expr likeop expr",
+ /* 210 */ "expr ::= expr likeop expr ESCAPE expr",
+ /* 211 */ "expr ::= expr ISNULL|NOTNULL",
+ /* 212 */ "expr ::= expr NOT NULL",
+ /* 213 */ "expr ::= expr IS expr",
+ /* 214 */ "expr ::= expr IS NOT expr",
+ /* 215 */ "expr ::= NOT expr",
+ /* 216 */ "expr ::= BITNOT expr",
+ /* 217 */ "expr ::= MINUS expr",
+ /* 218 */ "expr ::= PLUS expr",
+ /* 219 */ "between_op ::= BETWEEN",
+ /* 220 */ "between_op ::= NOT BETWEEN",
+ /* 221 */ "expr ::= expr between_op expr AND expr",
+ /* 222 */ "in_op ::= IN",
+ /* 223 */ "in_op ::= NOT IN",
+ /* 224 */ "expr ::= expr in_op LP exprlist RP",
+ /* 225 */ "expr ::= LP select RP",
+ /* 226 */ "expr ::= expr in_op LP select RP",
+ /* 227 */ "expr ::= expr in_op nm dbnm",
+ /* 228 */ "expr ::= EXISTS LP select RP",
+ /* 229 */ "expr ::= CASE case_operand case_exprlist case_else END",
+ /* 230 */ "case_exprlist ::= case_exprlist WHEN expr THEN expr",
+ /* 231 */ "case_exprlist ::= WHEN expr THEN expr",
+ /* 232 */ "case_else ::= ELSE expr",
+ /* 233 */ "case_else ::=",
+ /* 234 */ "case_operand ::= expr",
+ /* 235 */ "case_operand ::=",
+ /* 236 */ "exprlist ::= nexprlist",
+ /* 237 */ "exprlist ::=",
+ /* 238 */ "nexprlist ::= nexprlist COMMA expr",
+ /* 239 */ "nexprlist ::= expr",
+ /* 240 */ "cmd ::= createkw uniqueflag INDEX ifnotexists nm dbnm ON nm LP idxlist RP where_opt",
+ /* 241 */ "uniqueflag ::= UNIQUE",
+ /* 242 */ "uniqueflag ::=",
+ /* 243 */ "idxlist_opt ::=",
+ /* 244 */ "idxlist_opt ::= LP idxlist RP",
+ /* 245 */ "idxlist ::= idxlist COMMA nm collate sortorder",
+ /* 246 */ "idxlist ::= nm collate sortorder",
+ /* 247 */ "collate ::=",
+ /* 248 */ "collate ::= COLLATE ID|STRING",
+ /* 249 */ "cmd ::= DROP INDEX ifexists fullname",
+ /* 250 */ "cmd ::= VACUUM",
+ /* 251 */ "cmd ::= VACUUM nm",
+ /* 252 */ "cmd ::= PRAGMA nm dbnm",
+ /* 253 */ "cmd ::= PRAGMA nm dbnm EQ nmnum",
+ /* 254 */ "cmd ::= PRAGMA nm dbnm LP nmnum RP",
+ /* 255 */ "cmd ::= PRAGMA nm dbnm EQ minus_num",
+ /* 256 */ "cmd ::= PRAGMA nm dbnm LP minus_num RP",
+ /* 257 */ "nmnum ::= plus_num",
+ /* 258 */ "nmnum ::= nm",
+ /* 259 */ "nmnum ::= ON",
+ /* 260 */ "nmnum ::= DELETE",
+ /* 261 */ "nmnum ::= DEFAULT",
+ /* 262 */ "plus_num ::= PLUS INTEGER|FLOAT",
+ /* 263 */ "plus_num ::= INTEGER|FLOAT",
+ /* 264 */ "minus_num ::= MINUS INTEGER|FLOAT",
+ /* 265 */ "cmd ::= createkw trigger_decl BEGIN trigger_cmd_list END",
+ /* 266 */ "trigger_decl ::= temp TRIGGER ifnotexists nm dbnm trigger_time trigger_event ON fullname foreach_clause when_clause",
+ /* 267 */ "trigger_time ::= BEFORE",
+ /* 268 */ "trigger_time ::= AFTER",
+ /* 269 */ "trigger_time ::= INSTEAD OF",
+ /* 270 */ "trigger_time ::=",
+ /* 271 */ "trigger_event ::= DELETE|INSERT",
+ /* 272 */ "trigger_event ::= UPDATE",
+ /* 273 */ "trigger_event ::= UPDATE OF idlist",
+ /* 274 */ "foreach_clause ::=",
+ /* 275 */ "foreach_clause ::= FOR EACH ROW",
+ /* 276 */ "when_clause ::=",
+ /* 277 */ "when_clause ::= WHEN expr",
+ /* 278 */ "trigger_cmd_list ::= trigger_cmd_list trigger_cmd SEMI",
+ /* 279 */ "trigger_cmd_list ::= trigger_cmd SEMI",
+ /* 280 */ "trnm ::= nm",
+ /* 281 */ "trnm ::= nm DOT nm",
+ /* 282 */ "tridxby ::=",
+ /* 283 */ "tridxby ::= INDEXED BY nm",
+ /* 284 */ "tridxby ::= NOT INDEXED",
+ /* 285 */ "trigger_cmd ::= UPDATE orconf trnm tridxby SET setlist where_opt",
+ /* 286 */ "trigger_cmd ::= insert_cmd INTO trnm inscollist_opt select",
+ /* 287 */ "trigger_cmd ::= DELETE FROM trnm tridxby where_opt",
+ /* 288 */ "trigger_cmd ::= select",
+ /* 289 */ "expr ::= RAISE LP IGNORE RP",
+ /* 290 */ "expr ::= RAISE LP raisetype COMMA nm RP",
+ /* 291 */ "raisetype ::= ROLLBACK",
+ /* 292 */ "raisetype ::= ABORT",
+ /* 293 */ "raisetype ::= FAIL",
+ /* 294 */ "cmd ::= DROP TRIGGER ifexists fullname",
+ /* 295 */ "cmd ::= ATTACH database_kw_opt expr AS expr key_opt",
+ /* 296 */ "cmd ::= DETACH database_kw_opt expr",
+ /* 297 */ "key_opt ::=",
+ /* 298 */ "key_opt ::= KEY expr",
+ /* 299 */ "database_kw_opt ::= DATABASE",
+ /* 300 */ "database_kw_opt ::=",
+ /* 301 */ "cmd ::= REINDEX",
+ /* 302 */ "cmd ::= REINDEX nm dbnm",
+ /* 303 */ "cmd ::= ANALYZE",
+ /* 304 */ "cmd ::= ANALYZE nm dbnm",
+ /* 305 */ "cmd ::= ALTER TABLE fullname RENAME TO nm",
+ /* 306 */ "cmd ::= ALTER TABLE add_column_fullname ADD kwcolumn_opt column",
+ /* 307 */ "add_column_fullname ::= fullname",
+ /* 308 */ "kwcolumn_opt ::=",
+ /* 309 */ "kwcolumn_opt ::= COLUMNKW",
+ /* 310 */ "cmd ::= create_vtab",
+ /* 311 */ "cmd ::= create_vtab LP vtabarglist RP",
+ /* 312 */ "create_vtab ::= createkw VIRTUAL TABLE ifnotexists nm dbnm USING nm",
+ /* 313 */ "vtabarglist ::= vtabarg",
+ /* 314 */ "vtabarglist ::= vtabarglist COMMA vtabarg",
+ /* 315 */ "vtabarg ::=",
+ /* 316 */ "vtabarg ::= vtabarg vtabargtoken",
+ /* 317 */ "vtabargtoken ::= ANY",
+ /* 318 */ "vtabargtoken ::= lp anylist RP",
+ /* 319 */ "lp ::= LP",
+ /* 320 */ "anylist ::=",
+ /* 321 */ "anylist ::= anylist LP anylist RP",
+ /* 322 */ "anylist ::= anylist ANY",
+ /* 323 */ "with ::=",
+ /* 324 */ "with ::= WITH wqlist",
+ /* 325 */ "with ::= WITH RECURSIVE wqlist",
+ /* 326 */ "wqlist ::= nm idxlist_opt AS LP select RP",
+ /* 327 */ "wqlist ::= wqlist COMMA nm idxlist_opt AS LP select RP",
+};
+#endif /* NDEBUG */
+
+
+#if YYSTACKDEPTH<=0
+/*
+** Try to increase the size of the parser stack.
+*/
+static void yyGrowStack(yyParser *p){
+  int newSize;
+  yyStackEntry *pNew;
+
+  newSize = p->yystksz*2 + 100;
+  pNew = realloc(p->yystack, newSize*sizeof(pNew[0]));
+  if( pNew ){
+    p->yystack = pNew;
+    p->yystksz = newSize;
+#ifndef NDEBUG
+    if( yyTraceFILE ){
+      fprintf(yyTraceFILE,"%sStack grows to %d entries!\n",
+              yyTracePrompt, p->yystksz);
+    }
+#endif
+  }
+}
+#endif
+
+/* 
+** This function allocates a new parser.
+** The only argument is a pointer to a function which works like
+** malloc.
+**
+** Inputs:
+** A pointer to the function used to allocate memory.
+**
+** Outputs:
+** A pointer to a parser.  This pointer is used in subsequent calls
+** to sqlite3Parser and sqlite3ParserFree.
+*/
+void *sqlite3ParserAlloc(void *(*mallocProc)(size_t)){
+  yyParser *pParser;
+  pParser = (yyParser*)(*mallocProc)( (size_t)sizeof(yyParser) );
+  if( pParser ){
+    pParser->yyidx = -1;
+#ifdef YYTRACKMAXSTACKDEPTH
+    pParser->yyidxMax = 0;
+#endif
+#if YYSTACKDEPTH<=0
+    pParser->yystack = NULL;
+    pParser->yystksz = 0;
+    yyGrowStack(pParser);
+#endif
+  }
+  return pParser;
+}
+
+/* The following function deletes the value associated with a
+** symbol.  The symbol can be either a terminal or nonterminal.
+** "yymajor" is the symbol code, and "yypminor" is a pointer to
+** the value.
+*/
+static void yy_destructor(
+  yyParser *yypParser,    /* The parser */
+  YYCODETYPE yymajor,     /* Type code for object to destroy */
+  YYMINORTYPE *yypminor   /* The object to be destroyed */
+){
+  sqlite3ParserARG_FETCH;
+  switch( yymajor ){
+    /* Here is inserted the actions which take place when a
+    ** terminal or non-terminal is destroyed.  This can happen
+    ** when the symbol is popped from the stack during a
+    ** reduce or during error processing or when a parser is 
+    ** being destroyed before it is finished parsing.
+    **
+    ** Note: during a reduce, the only symbols destroyed are those
+    ** which appear on the RHS of the rule, but which are not used
+    ** inside the C code.
+    */
+    case 164: /* select */
+    case 196: /* selectnowith */
+    case 197: /* oneselect */
+    case 208: /* values */
+{
+#line 410 "parse.y"
+sqlite3SelectDelete(pParse->db, (yypminor->yy27));
+#line 1421 "parse.c"
+}
+      break;
+    case 175: /* term */
+    case 176: /* expr */
+{
+#line 774 "parse.y"
+sqlite3ExprDelete(pParse->db, (yypminor->yy94).pExpr);
+#line 1429 "parse.c"
+}
+      break;
+    case 180: /* idxlist_opt */
+    case 189: /* idxlist */
+    case 201: /* selcollist */
+    case 204: /* groupby_opt */
+    case 206: /* orderby_opt */
+    case 209: /* nexprlist */
+    case 210: /* exprlist */
+    case 211: /* sclp */
+    case 221: /* sortlist */
+    case 222: /* setlist */
+    case 229: /* case_exprlist */
+{
+#line 1151 "parse.y"
+sqlite3ExprListDelete(pParse->db, (yypminor->yy298));
+#line 1446 "parse.c"
+}
+      break;
+    case 195: /* fullname */
+    case 202: /* from */
+    case 213: /* seltablist */
+    case 214: /* stl_prefix */
+{
+#line 592 "parse.y"
+sqlite3SrcListDelete(pParse->db, (yypminor->yy115));
+#line 1456 "parse.c"
+}
+      break;
+    case 198: /* with */
+    case 253: /* wqlist */
+{
+#line 1412 "parse.y"
+sqlite3WithDelete(pParse->db, (yypminor->yy363));
+#line 1464 "parse.c"
+}
+      break;
+    case 203: /* where_opt */
+    case 205: /* having_opt */
+    case 217: /* on_opt */
+    case 228: /* case_operand */
+    case 230: /* case_else */
+    case 239: /* when_clause */
+    case 244: /* key_opt */
+{
+#line 701 "parse.y"
+sqlite3ExprDelete(pParse->db, (yypminor->yy326));
+#line 1477 "parse.c"
+}
+      break;
+    case 218: /* using_opt */
+    case 220: /* idlist */
+    case 224: /* inscollist_opt */
+{
+#line 624 "parse.y"
+sqlite3IdListDelete(pParse->db, (yypminor->yy164));
+#line 1486 "parse.c"
+}
+      break;
+    case 235: /* trigger_cmd_list */
+    case 240: /* trigger_cmd */
+{
+#line 1248 "parse.y"
+sqlite3DeleteTriggerStep(pParse->db, (yypminor->yy427));
+#line 1494 "parse.c"
+}
+      break;
+    case 237: /* trigger_event */
+{
+#line 1234 "parse.y"
+sqlite3IdListDelete(pParse->db, (yypminor->yy382).b);
+#line 1501 "parse.c"
+}
+      break;
+    default:  break;   /* If no destructor action specified: do nothing */
+  }
+}
+
+/*
+** Pop the parser's stack once.
+**
+** If there is a destructor routine associated with the token which
+** is popped from the stack, then call it.
+**
+** Return the major token number for the symbol popped.
+*/
+static int yy_pop_parser_stack(yyParser *pParser){
+  YYCODETYPE yymajor;
+  yyStackEntry *yytos = &pParser->yystack[pParser->yyidx];
+
+  /* There is no mechanism by which the parser stack can be popped below
+  ** empty in SQLite.  */
+  if( NEVER(pParser->yyidx<0) ) return 0;
+#ifndef NDEBUG
+  if( yyTraceFILE && pParser->yyidx>=0 ){
+    fprintf(yyTraceFILE,"%sPopping %s\n",
+      yyTracePrompt,
+      yyTokenName[yytos->major]);
+  }
+#endif
+  yymajor = yytos->major;
+  yy_destructor(pParser, yymajor, &yytos->minor);
+  pParser->yyidx--;
+  return yymajor;
+}
+
+/* 
+** Deallocate and destroy a parser.  Destructors are all called for
+** all stack elements before shutting the parser down.
+**
+** Inputs:
+** <ul>
+** <li>  A pointer to the parser.  This should be a pointer
+**       obtained from sqlite3ParserAlloc.
+** <li>  A pointer to a function used to reclaim memory obtained
+**       from malloc.
+** </ul>
+*/
+void sqlite3ParserFree(
+  void *p,                    /* The parser to be deleted */
+  void (*freeProc)(void*)     /* Function used to reclaim memory */
+){
+  yyParser *pParser = (yyParser*)p;
+  /* In SQLite, we never try to destroy a parser that was not successfully
+  ** created in the first place. */
+  if( NEVER(pParser==0) ) return;
+  while( pParser->yyidx>=0 ) yy_pop_parser_stack(pParser);
+#if YYSTACKDEPTH<=0
+  free(pParser->yystack);
+#endif
+  (*freeProc)((void*)pParser);
+}
+
+/*
+** Return the peak depth of the stack for a parser.
+*/
+#ifdef YYTRACKMAXSTACKDEPTH
+int sqlite3ParserStackPeak(void *p){
+  yyParser *pParser = (yyParser*)p;
+  return pParser->yyidxMax;
+}
+#endif
+
+/*
+** Find the appropriate action for a parser given the terminal
+** look-ahead token iLookAhead.
+**
+** If the look-ahead token is YYNOCODE, then check to see if the action is
+** independent of the look-ahead.  If it is, return the action, otherwise
+** return YY_NO_ACTION.
+*/
+static int yy_find_shift_action(
+  yyParser *pParser,        /* The parser */
+  YYCODETYPE iLookAhead     /* The look-ahead token */
+){
+  int i;
+  int stateno = pParser->yystack[pParser->yyidx].stateno;
+ 
+  if( stateno>YY_SHIFT_COUNT
+   || (i = yy_shift_ofst[stateno])==YY_SHIFT_USE_DFLT ){
+    return yy_default[stateno];
+  }
+  assert( iLookAhead!=YYNOCODE );
+  i += iLookAhead;
+  if( i<0 || i>=YY_ACTTAB_COUNT || yy_lookahead[i]!=iLookAhead ){
+    if( iLookAhead>0 ){
+#ifdef YYFALLBACK
+      YYCODETYPE iFallback;            /* Fallback token */
+      if( iLookAhead<sizeof(yyFallback)/sizeof(yyFallback[0])
+             && (iFallback = yyFallback[iLookAhead])!=0 ){
+#ifndef NDEBUG
+        if( yyTraceFILE ){
+          fprintf(yyTraceFILE, "%sFALLBACK %s => %s\n",
+             yyTracePrompt, yyTokenName[iLookAhead], yyTokenName[iFallback]);
+        }
+#endif
+        return yy_find_shift_action(pParser, iFallback);
+      }
+#endif
+#ifdef YYWILDCARD
+      {
+        int j = i - iLookAhead + YYWILDCARD;
+        if( 
+#if YY_SHIFT_MIN+YYWILDCARD<0
+          j>=0 &&
+#endif
+#if YY_SHIFT_MAX+YYWILDCARD>=YY_ACTTAB_COUNT
+          j<YY_ACTTAB_COUNT &&
+#endif
+          yy_lookahead[j]==YYWILDCARD
+        ){
+#ifndef NDEBUG
+          if( yyTraceFILE ){
+            fprintf(yyTraceFILE, "%sWILDCARD %s => %s\n",
+               yyTracePrompt, yyTokenName[iLookAhead], yyTokenName[YYWILDCARD]);
+          }
+#endif /* NDEBUG */
+          return yy_action[j];
+        }
+      }
+#endif /* YYWILDCARD */
+    }
+    return yy_default[stateno];
+  }else{
+    return yy_action[i];
+  }
+}
+
+/*
+** Find the appropriate action for a parser given the non-terminal
+** look-ahead token iLookAhead.
+**
+** If the look-ahead token is YYNOCODE, then check to see if the action is
+** independent of the look-ahead.  If it is, return the action, otherwise
+** return YY_NO_ACTION.
+*/
+static int yy_find_reduce_action(
+  int stateno,              /* Current state number */
+  YYCODETYPE iLookAhead     /* The look-ahead token */
+){
+  int i;
+#ifdef YYERRORSYMBOL
+  if( stateno>YY_REDUCE_COUNT ){
+    return yy_default[stateno];
+  }
+#else
+  assert( stateno<=YY_REDUCE_COUNT );
+#endif
+  i = yy_reduce_ofst[stateno];
+  assert( i!=YY_REDUCE_USE_DFLT );
+  assert( iLookAhead!=YYNOCODE );
+  i += iLookAhead;
+#ifdef YYERRORSYMBOL
+  if( i<0 || i>=YY_ACTTAB_COUNT || yy_lookahead[i]!=iLookAhead ){
+    return yy_default[stateno];
+  }
+#else
+  assert( i>=0 && i<YY_ACTTAB_COUNT );
+  assert( yy_lookahead[i]==iLookAhead );
+#endif
+  return yy_action[i];
+}
+
+/*
+** The following routine is called if the stack overflows.
+*/
+static void yyStackOverflow(yyParser *yypParser, YYMINORTYPE *yypMinor){
+   sqlite3ParserARG_FETCH;
+   yypParser->yyidx--;
+#ifndef NDEBUG
+   if( yyTraceFILE ){
+     fprintf(yyTraceFILE,"%sStack Overflow!\n",yyTracePrompt);
+   }
+#endif
+   while( yypParser->yyidx>=0 ) yy_pop_parser_stack(yypParser);
+   /* Here code is inserted which will execute if the parser
+   ** stack every overflows */
+#line 37 "parse.y"
+
+  UNUSED_PARAMETER(yypMinor); /* Silence some compiler warnings */
+  sqlite3ErrorMsg(pParse, "parser stack overflow");
+#line 1691 "parse.c"
+   sqlite3ParserARG_STORE; /* Suppress warning about unused %extra_argument var */
+}
+
+/*
+** Perform a shift action.
+*/
+static void yy_shift(
+  yyParser *yypParser,          /* The parser to be shifted */
+  int yyNewState,               /* The new state to shift in */
+  int yyMajor,                  /* The major token to shift in */
+  YYMINORTYPE *yypMinor         /* Pointer to the minor token to shift in */
+){
+  yyStackEntry *yytos;
+  yypParser->yyidx++;
+#ifdef YYTRACKMAXSTACKDEPTH
+  if( yypParser->yyidx>yypParser->yyidxMax ){
+    yypParser->yyidxMax = yypParser->yyidx;
+  }
+#endif
+#if YYSTACKDEPTH>0 
+  if( yypParser->yyidx>=YYSTACKDEPTH ){
+    yyStackOverflow(yypParser, yypMinor);
+    return;
+  }
+#else
+  if( yypParser->yyidx>=yypParser->yystksz ){
+    yyGrowStack(yypParser);
+    if( yypParser->yyidx>=yypParser->yystksz ){
+      yyStackOverflow(yypParser, yypMinor);
+      return;
+    }
+  }
+#endif
+  yytos = &yypParser->yystack[yypParser->yyidx];
+  yytos->stateno = (YYACTIONTYPE)yyNewState;
+  yytos->major = (YYCODETYPE)yyMajor;
+  yytos->minor = *yypMinor;
+#ifndef NDEBUG
+  if( yyTraceFILE && yypParser->yyidx>0 ){
+    int i;
+    fprintf(yyTraceFILE,"%sShift %d\n",yyTracePrompt,yyNewState);
+    fprintf(yyTraceFILE,"%sStack:",yyTracePrompt);
+    for(i=1; i<=yypParser->yyidx; i++)
+      fprintf(yyTraceFILE," %s",yyTokenName[yypParser->yystack[i].major]);
+    fprintf(yyTraceFILE,"\n");
+  }
+#endif
+}
+
+/* The following table contains information about every rule that
+** is used during the reduce.
+*/
+static const struct {
+  YYCODETYPE lhs;         /* Symbol on the left-hand side of the rule */
+  unsigned char nrhs;     /* Number of right-hand side symbols in the rule */
+} yyRuleInfo[] = {
+  { 145, 1 },
+  { 146, 2 },
+  { 146, 1 },
+  { 147, 1 },
+  { 147, 3 },
+  { 148, 0 },
+  { 148, 1 },
+  { 148, 3 },
+  { 149, 1 },
+  { 150, 3 },
+  { 152, 0 },
+  { 152, 1 },
+  { 152, 2 },
+  { 151, 0 },
+  { 151, 1 },
+  { 151, 1 },
+  { 151, 1 },
+  { 151, 1 },
+  { 150, 2 },
+  { 150, 2 },
+  { 150, 2 },
+  { 154, 1 },
+  { 154, 0 },
+  { 150, 2 },
+  { 150, 3 },
+  { 150, 5 },
+  { 150, 2 },
+  { 155, 6 },
+  { 157, 1 },
+  { 159, 0 },
+  { 159, 3 },
+  { 158, 1 },
+  { 158, 0 },
+  { 156, 5 },
+  { 156, 2 },
+  { 163, 0 },
+  { 163, 2 },
+  { 161, 3 },
+  { 161, 1 },
+  { 165, 3 },
+  { 166, 1 },
+  { 153, 1 },
+  { 153, 1 },
+  { 153, 1 },
+  { 167, 0 },
+  { 167, 1 },
+  { 169, 1 },
+  { 169, 4 },
+  { 169, 6 },
+  { 170, 1 },
+  { 170, 2 },
+  { 171, 1 },
+  { 171, 1 },
+  { 168, 2 },
+  { 168, 0 },
+  { 174, 2 },
+  { 174, 2 },
+  { 174, 4 },
+  { 174, 3 },
+  { 174, 3 },
+  { 174, 2 },
+  { 174, 2 },
+  { 174, 3 },
+  { 174, 5 },
+  { 174, 2 },
+  { 174, 4 },
+  { 174, 4 },
+  { 174, 1 },
+  { 174, 2 },
+  { 179, 0 },
+  { 179, 1 },
+  { 181, 0 },
+  { 181, 2 },
+  { 183, 2 },
+  { 183, 3 },
+  { 183, 3 },
+  { 183, 3 },
+  { 184, 2 },
+  { 184, 2 },
+  { 184, 1 },
+  { 184, 1 },
+  { 184, 2 },
+  { 182, 3 },
+  { 182, 2 },
+  { 185, 0 },
+  { 185, 2 },
+  { 185, 2 },
+  { 162, 0 },
+  { 162, 2 },
+  { 186, 3 },
+  { 186, 1 },
+  { 187, 1 },
+  { 187, 0 },
+  { 188, 2 },
+  { 188, 7 },
+  { 188, 5 },
+  { 188, 5 },
+  { 188, 10 },
+  { 190, 0 },
+  { 190, 1 },
+  { 177, 0 },
+  { 177, 3 },
+  { 191, 0 },
+  { 191, 2 },
+  { 192, 1 },
+  { 192, 1 },
+  { 192, 1 },
+  { 150, 4 },
+  { 194, 2 },
+  { 194, 0 },
+  { 150, 8 },
+  { 150, 4 },
+  { 150, 1 },
+  { 164, 2 },
+  { 196, 1 },
+  { 196, 3 },
+  { 199, 1 },
+  { 199, 2 },
+  { 199, 1 },
+  { 197, 9 },
+  { 197, 1 },
+  { 208, 4 },
+  { 208, 5 },
+  { 200, 1 },
+  { 200, 1 },
+  { 200, 0 },
+  { 211, 2 },
+  { 211, 0 },
+  { 201, 3 },
+  { 201, 2 },
+  { 201, 4 },
+  { 212, 2 },
+  { 212, 1 },
+  { 212, 0 },
+  { 202, 0 },
+  { 202, 2 },
+  { 214, 2 },
+  { 214, 0 },
+  { 213, 7 },
+  { 213, 7 },
+  { 213, 7 },
+  { 160, 0 },
+  { 160, 2 },
+  { 195, 2 },
+  { 215, 1 },
+  { 215, 2 },
+  { 215, 3 },
+  { 215, 4 },
+  { 217, 2 },
+  { 217, 0 },
+  { 216, 0 },
+  { 216, 3 },
+  { 216, 2 },
+  { 218, 4 },
+  { 218, 0 },
+  { 206, 0 },
+  { 206, 3 },
+  { 221, 4 },
+  { 221, 2 },
+  { 178, 1 },
+  { 178, 1 },
+  { 178, 0 },
+  { 204, 0 },
+  { 204, 3 },
+  { 205, 0 },
+  { 205, 2 },
+  { 207, 0 },
+  { 207, 2 },
+  { 207, 4 },
+  { 207, 4 },
+  { 150, 6 },
+  { 203, 0 },
+  { 203, 2 },
+  { 150, 8 },
+  { 222, 5 },
+  { 222, 3 },
+  { 150, 6 },
+  { 150, 7 },
+  { 223, 2 },
+  { 223, 1 },
+  { 224, 0 },
+  { 224, 3 },
+  { 220, 3 },
+  { 220, 1 },
+  { 176, 1 },
+  { 176, 3 },
+  { 175, 1 },
+  { 176, 1 },
+  { 176, 1 },
+  { 176, 3 },
+  { 176, 5 },
+  { 175, 1 },
+  { 175, 1 },
+  { 176, 1 },
+  { 176, 3 },
+  { 176, 6 },
+  { 176, 5 },
+  { 176, 4 },
+  { 175, 1 },
+  { 176, 3 },
+  { 176, 3 },
+  { 176, 3 },
+  { 176, 3 },
+  { 176, 3 },
+  { 176, 3 },
+  { 176, 3 },
+  { 176, 3 },
+  { 225, 1 },
+  { 225, 2 },
+  { 176, 3 },
+  { 176, 5 },
+  { 176, 2 },
+  { 176, 3 },
+  { 176, 3 },
+  { 176, 4 },
+  { 176, 2 },
+  { 176, 2 },
+  { 176, 2 },
+  { 176, 2 },
+  { 226, 1 },
+  { 226, 2 },
+  { 176, 5 },
+  { 227, 1 },
+  { 227, 2 },
+  { 176, 5 },
+  { 176, 3 },
+  { 176, 5 },
+  { 176, 4 },
+  { 176, 4 },
+  { 176, 5 },
+  { 229, 5 },
+  { 229, 4 },
+  { 230, 2 },
+  { 230, 0 },
+  { 228, 1 },
+  { 228, 0 },
+  { 210, 1 },
+  { 210, 0 },
+  { 209, 3 },
+  { 209, 1 },
+  { 150, 12 },
+  { 231, 1 },
+  { 231, 0 },
+  { 180, 0 },
+  { 180, 3 },
+  { 189, 5 },
+  { 189, 3 },
+  { 232, 0 },
+  { 232, 2 },
+  { 150, 4 },
+  { 150, 1 },
+  { 150, 2 },
+  { 150, 3 },
+  { 150, 5 },
+  { 150, 6 },
+  { 150, 5 },
+  { 150, 6 },
+  { 233, 1 },
+  { 233, 1 },
+  { 233, 1 },
+  { 233, 1 },
+  { 233, 1 },
+  { 172, 2 },
+  { 172, 1 },
+  { 173, 2 },
+  { 150, 5 },
+  { 234, 11 },
+  { 236, 1 },
+  { 236, 1 },
+  { 236, 2 },
+  { 236, 0 },
+  { 237, 1 },
+  { 237, 1 },
+  { 237, 3 },
+  { 238, 0 },
+  { 238, 3 },
+  { 239, 0 },
+  { 239, 2 },
+  { 235, 3 },
+  { 235, 2 },
+  { 241, 1 },
+  { 241, 3 },
+  { 242, 0 },
+  { 242, 3 },
+  { 242, 2 },
+  { 240, 7 },
+  { 240, 5 },
+  { 240, 5 },
+  { 240, 1 },
+  { 176, 4 },
+  { 176, 6 },
+  { 193, 1 },
+  { 193, 1 },
+  { 193, 1 },
+  { 150, 4 },
+  { 150, 6 },
+  { 150, 3 },
+  { 244, 0 },
+  { 244, 2 },
+  { 243, 1 },
+  { 243, 0 },
+  { 150, 1 },
+  { 150, 3 },
+  { 150, 1 },
+  { 150, 3 },
+  { 150, 6 },
+  { 150, 6 },
+  { 245, 1 },
+  { 246, 0 },
+  { 246, 1 },
+  { 150, 1 },
+  { 150, 4 },
+  { 247, 8 },
+  { 248, 1 },
+  { 248, 3 },
+  { 249, 0 },
+  { 249, 2 },
+  { 250, 1 },
+  { 250, 3 },
+  { 251, 1 },
+  { 252, 0 },
+  { 252, 4 },
+  { 252, 2 },
+  { 198, 0 },
+  { 198, 2 },
+  { 198, 3 },
+  { 253, 6 },
+  { 253, 8 },
+};
+
+static void yy_accept(yyParser*);  /* Forward Declaration */
+
+/*
+** Perform a reduce action and the shift that must immediately
+** follow the reduce.
+*/
+static void yy_reduce(
+  yyParser *yypParser,         /* The parser */
+  int yyruleno                 /* Number of the rule by which to reduce */
+){
+  int yygoto;                     /* The next state */
+  int yyact;                      /* The next action */
+  YYMINORTYPE yygotominor;        /* The LHS of the rule reduced */
+  yyStackEntry *yymsp;            /* The top of the parser's stack */
+  int yysize;                     /* Amount to pop the stack */
+  sqlite3ParserARG_FETCH;
+  yymsp = &yypParser->yystack[yypParser->yyidx];
+#ifndef NDEBUG
+  if( yyTraceFILE && yyruleno>=0 
+        && yyruleno<(int)(sizeof(yyRuleName)/sizeof(yyRuleName[0])) ){
+    fprintf(yyTraceFILE, "%sReduce [%s].\n", yyTracePrompt,
+      yyRuleName[yyruleno]);
+  }
+#endif /* NDEBUG */
+
+  /* Silence complaints from purify about yygotominor being uninitialized
+  ** in some cases when it is copied into the stack after the following
+  ** switch.  yygotominor is uninitialized when a rule reduces that does
+  ** not set the value of its left-hand side nonterminal.  Leaving the
+  ** value of the nonterminal uninitialized is utterly harmless as long
+  ** as the value is never used.  So really the only thing this code
+  ** accomplishes is to quieten purify.  
+  **
+  ** 2007-01-16:  The wireshark project (www.wireshark.org) reports that
+  ** without this code, their parser segfaults.  I'm not sure what there
+  ** parser is doing to make this happen.  This is the second bug report
+  ** from wireshark this week.  Clearly they are stressing Lemon in ways
+  ** that it has not been previously stressed...  (SQLite ticket #2172)
+  */
+  /*memset(&yygotominor, 0, sizeof(yygotominor));*/
+  yygotominor = yyzerominor;
+
+
+  switch( yyruleno ){
+  /* Beginning here are the reduction cases.  A typical example
+  ** follows:
+  **   case 0:
+  **  #line <lineno> <grammarfile>
+  **     { ... }           // User supplied code
+  **  #line <lineno> <thisfile>
+  **     break;
+  */
+      case 5: /* explain ::= */
+#line 105 "parse.y"
+{ sqlite3BeginParse(pParse, 0); }
+#line 2133 "parse.c"
+        break;
+      case 6: /* explain ::= EXPLAIN */
+#line 107 "parse.y"
+{ sqlite3BeginParse(pParse, 1); }
+#line 2138 "parse.c"
+        break;
+      case 7: /* explain ::= EXPLAIN QUERY PLAN */
+#line 108 "parse.y"
+{ sqlite3BeginParse(pParse, 2); }
+#line 2143 "parse.c"
+        break;
+      case 8: /* cmdx ::= cmd */
+#line 110 "parse.y"
+{ sqlite3FinishCoding(pParse); }
+#line 2148 "parse.c"
+        break;
+      case 9: /* cmd ::= BEGIN transtype trans_opt */
+#line 115 "parse.y"
+{sqlite3BeginTransaction(pParse, yymsp[-1].minor.yy156);}
+#line 2153 "parse.c"
+        break;
+      case 13: /* transtype ::= */
+#line 120 "parse.y"
+{yygotominor.yy156 = TK_DEFERRED;}
+#line 2158 "parse.c"
+        break;
+      case 14: /* transtype ::= DEFERRED */
+      case 15: /* transtype ::= IMMEDIATE */ yytestcase(yyruleno==15);
+      case 16: /* transtype ::= EXCLUSIVE */ yytestcase(yyruleno==16);
+      case 17: /* transtype ::= CONCURRENT */ yytestcase(yyruleno==17);
+      case 116: /* multiselect_op ::= UNION */ yytestcase(yyruleno==116);
+      case 118: /* multiselect_op ::= EXCEPT|INTERSECT */ yytestcase(yyruleno==118);
+#line 121 "parse.y"
+{yygotominor.yy156 = yymsp[0].major;}
+#line 2168 "parse.c"
+        break;
+      case 18: /* cmd ::= COMMIT trans_opt */
+      case 19: /* cmd ::= END trans_opt */ yytestcase(yyruleno==19);
+#line 125 "parse.y"
+{sqlite3CommitTransaction(pParse);}
+#line 2174 "parse.c"
+        break;
+      case 20: /* cmd ::= ROLLBACK trans_opt */
+#line 127 "parse.y"
+{sqlite3RollbackTransaction(pParse);}
+#line 2179 "parse.c"
+        break;
+      case 23: /* cmd ::= SAVEPOINT nm */
+#line 131 "parse.y"
+{
+  sqlite3Savepoint(pParse, SAVEPOINT_BEGIN, &yymsp[0].minor.yy0);
+}
+#line 2186 "parse.c"
+        break;
+      case 24: /* cmd ::= RELEASE savepoint_opt nm */
+#line 134 "parse.y"
+{
+  sqlite3Savepoint(pParse, SAVEPOINT_RELEASE, &yymsp[0].minor.yy0);
+}
+#line 2193 "parse.c"
+        break;
+      case 25: /* cmd ::= ROLLBACK trans_opt TO savepoint_opt nm */
+#line 137 "parse.y"
+{
+  sqlite3Savepoint(pParse, SAVEPOINT_ROLLBACK, &yymsp[0].minor.yy0);
+}
+#line 2200 "parse.c"
+        break;
+      case 27: /* create_table ::= createkw temp TABLE ifnotexists nm dbnm */
+#line 144 "parse.y"
+{
+   sqlite3StartTable(pParse,&yymsp[-1].minor.yy0,&yymsp[0].minor.yy0,yymsp[-4].minor.yy156,0,0,yymsp[-2].minor.yy156);
+}
+#line 2207 "parse.c"
+        break;
+      case 28: /* createkw ::= CREATE */
+#line 147 "parse.y"
+{
+  pParse->db->lookaside.bEnabled = 0;
+  yygotominor.yy0 = yymsp[0].minor.yy0;
+}
+#line 2215 "parse.c"
+        break;
+      case 29: /* ifnotexists ::= */
+      case 32: /* temp ::= */ yytestcase(yyruleno==32);
+      case 69: /* autoinc ::= */ yytestcase(yyruleno==69);
+      case 82: /* defer_subclause ::= NOT DEFERRABLE init_deferred_pred_opt */ yytestcase(yyruleno==82);
+      case 84: /* init_deferred_pred_opt ::= */ yytestcase(yyruleno==84);
+      case 86: /* init_deferred_pred_opt ::= INITIALLY IMMEDIATE */ yytestcase(yyruleno==86);
+      case 98: /* defer_subclause_opt ::= */ yytestcase(yyruleno==98);
+      case 109: /* ifexists ::= */ yytestcase(yyruleno==109);
+      case 219: /* between_op ::= BETWEEN */ yytestcase(yyruleno==219);
+      case 222: /* in_op ::= IN */ yytestcase(yyruleno==222);
+#line 152 "parse.y"
+{yygotominor.yy156 = 0;}
+#line 2229 "parse.c"
+        break;
+      case 30: /* ifnotexists ::= IF NOT EXISTS */
+      case 31: /* temp ::= TEMP */ yytestcase(yyruleno==31);
+      case 70: /* autoinc ::= AUTOINCR */ yytestcase(yyruleno==70);
+      case 85: /* init_deferred_pred_opt ::= INITIALLY DEFERRED */ yytestcase(yyruleno==85);
+      case 108: /* ifexists ::= IF EXISTS */ yytestcase(yyruleno==108);
+      case 220: /* between_op ::= NOT BETWEEN */ yytestcase(yyruleno==220);
+      case 223: /* in_op ::= NOT IN */ yytestcase(yyruleno==223);
+#line 153 "parse.y"
+{yygotominor.yy156 = 1;}
+#line 2240 "parse.c"
+        break;
+      case 33: /* create_table_args ::= LP columnlist conslist_opt RP table_options */
+#line 159 "parse.y"
+{
+  sqlite3EndTable(pParse,&yymsp[-2].minor.yy0,&yymsp[-1].minor.yy0,yymsp[0].minor.yy162,0);
+}
+#line 2247 "parse.c"
+        break;
+      case 34: /* create_table_args ::= AS select */
+#line 162 "parse.y"
+{
+  sqlite3EndTable(pParse,0,0,0,yymsp[0].minor.yy27);
+  sqlite3SelectDelete(pParse->db, yymsp[0].minor.yy27);
+}
+#line 2255 "parse.c"
+        break;
+      case 35: /* table_options ::= */
+#line 167 "parse.y"
+{yygotominor.yy162 = 0;}
+#line 2260 "parse.c"
+        break;
+      case 36: /* table_options ::= WITHOUT nm */
+#line 168 "parse.y"
+{
+  if( yymsp[0].minor.yy0.n==5 && sqlite3_strnicmp(yymsp[0].minor.yy0.z,"rowid",5)==0 ){
+    yygotominor.yy162 = TF_WithoutRowid;
+  }else{
+    yygotominor.yy162 = 0;
+    sqlite3ErrorMsg(pParse, "unknown table option: %.*s", yymsp[0].minor.yy0.n, yymsp[0].minor.yy0.z);
+  }
+}
+#line 2272 "parse.c"
+        break;
+      case 39: /* column ::= columnid type carglist */
+#line 184 "parse.y"
+{
+  yygotominor.yy0.z = yymsp[-2].minor.yy0.z;
+  yygotominor.yy0.n = (int)(pParse->sLastToken.z-yymsp[-2].minor.yy0.z) + pParse->sLastToken.n;
+}
+#line 2280 "parse.c"
+        break;
+      case 40: /* columnid ::= nm */
+#line 188 "parse.y"
+{
+  sqlite3AddColumn(pParse,&yymsp[0].minor.yy0);
+  yygotominor.yy0 = yymsp[0].minor.yy0;
+  pParse->constraintName.n = 0;
+}
+#line 2289 "parse.c"
+        break;
+      case 41: /* nm ::= ID|INDEXED */
+      case 42: /* nm ::= STRING */ yytestcase(yyruleno==42);
+      case 43: /* nm ::= JOIN_KW */ yytestcase(yyruleno==43);
+      case 46: /* typetoken ::= typename */ yytestcase(yyruleno==46);
+      case 49: /* typename ::= ID|STRING */ yytestcase(yyruleno==49);
+      case 131: /* as ::= AS nm */ yytestcase(yyruleno==131);
+      case 132: /* as ::= ID|STRING */ yytestcase(yyruleno==132);
+      case 142: /* dbnm ::= DOT nm */ yytestcase(yyruleno==142);
+      case 151: /* indexed_opt ::= INDEXED BY nm */ yytestcase(yyruleno==151);
+      case 248: /* collate ::= COLLATE ID|STRING */ yytestcase(yyruleno==248);
+      case 257: /* nmnum ::= plus_num */ yytestcase(yyruleno==257);
+      case 258: /* nmnum ::= nm */ yytestcase(yyruleno==258);
+      case 259: /* nmnum ::= ON */ yytestcase(yyruleno==259);
+      case 260: /* nmnum ::= DELETE */ yytestcase(yyruleno==260);
+      case 261: /* nmnum ::= DEFAULT */ yytestcase(yyruleno==261);
+      case 262: /* plus_num ::= PLUS INTEGER|FLOAT */ yytestcase(yyruleno==262);
+      case 263: /* plus_num ::= INTEGER|FLOAT */ yytestcase(yyruleno==263);
+      case 264: /* minus_num ::= MINUS INTEGER|FLOAT */ yytestcase(yyruleno==264);
+      case 280: /* trnm ::= nm */ yytestcase(yyruleno==280);
+#line 248 "parse.y"
+{yygotominor.yy0 = yymsp[0].minor.yy0;}
+#line 2312 "parse.c"
+        break;
+      case 45: /* type ::= typetoken */
+#line 258 "parse.y"
+{sqlite3AddColumnType(pParse,&yymsp[0].minor.yy0);}
+#line 2317 "parse.c"
+        break;
+      case 47: /* typetoken ::= typename LP signed RP */
+#line 260 "parse.y"
+{
+  yygotominor.yy0.z = yymsp[-3].minor.yy0.z;
+  yygotominor.yy0.n = (int)(&yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n] - yymsp[-3].minor.yy0.z);
+}
+#line 2325 "parse.c"
+        break;
+      case 48: /* typetoken ::= typename LP signed COMMA signed RP */
+#line 264 "parse.y"
+{
+  yygotominor.yy0.z = yymsp[-5].minor.yy0.z;
+  yygotominor.yy0.n = (int)(&yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n] - yymsp[-5].minor.yy0.z);
+}
+#line 2333 "parse.c"
+        break;
+      case 50: /* typename ::= typename ID|STRING */
+#line 270 "parse.y"
+{yygotominor.yy0.z=yymsp[-1].minor.yy0.z; yygotominor.yy0.n=yymsp[0].minor.yy0.n+(int)(yymsp[0].minor.yy0.z-yymsp[-1].minor.yy0.z);}
+#line 2338 "parse.c"
+        break;
+      case 55: /* ccons ::= CONSTRAINT nm */
+      case 93: /* tcons ::= CONSTRAINT nm */ yytestcase(yyruleno==93);
+#line 279 "parse.y"
+{pParse->constraintName = yymsp[0].minor.yy0;}
+#line 2344 "parse.c"
+        break;
+      case 56: /* ccons ::= DEFAULT term */
+      case 58: /* ccons ::= DEFAULT PLUS term */ yytestcase(yyruleno==58);
+#line 280 "parse.y"
+{sqlite3AddDefaultValue(pParse,&yymsp[0].minor.yy94);}
+#line 2350 "parse.c"
+        break;
+      case 57: /* ccons ::= DEFAULT LP expr RP */
+#line 281 "parse.y"
+{sqlite3AddDefaultValue(pParse,&yymsp[-1].minor.yy94);}
+#line 2355 "parse.c"
+        break;
+      case 59: /* ccons ::= DEFAULT MINUS term */
+#line 283 "parse.y"
+{
+  ExprSpan v;
+  v.pExpr = sqlite3PExpr(pParse, TK_UMINUS, yymsp[0].minor.yy94.pExpr, 0, 0);
+  v.zStart = yymsp[-1].minor.yy0.z;
+  v.zEnd = yymsp[0].minor.yy94.zEnd;
+  sqlite3AddDefaultValue(pParse,&v);
+}
+#line 2366 "parse.c"
+        break;
+      case 60: /* ccons ::= DEFAULT ID|INDEXED */
+#line 290 "parse.y"
+{
+  ExprSpan v;
+  spanExpr(&v, pParse, TK_STRING, &yymsp[0].minor.yy0);
+  sqlite3AddDefaultValue(pParse,&v);
+}
+#line 2375 "parse.c"
+        break;
+      case 62: /* ccons ::= NOT NULL onconf */
+#line 300 "parse.y"
+{sqlite3AddNotNull(pParse, yymsp[0].minor.yy156);}
+#line 2380 "parse.c"
+        break;
+      case 63: /* ccons ::= PRIMARY KEY sortorder onconf autoinc */
+#line 302 "parse.y"
+{sqlite3AddPrimaryKey(pParse,0,yymsp[-1].minor.yy156,yymsp[0].minor.yy156,yymsp[-2].minor.yy156);}
+#line 2385 "parse.c"
+        break;
+      case 64: /* ccons ::= UNIQUE onconf */
+#line 303 "parse.y"
+{sqlite3CreateIndex(pParse,0,0,0,0,yymsp[0].minor.yy156,0,0,0,0);}
+#line 2390 "parse.c"
+        break;
+      case 65: /* ccons ::= CHECK LP expr RP */
+#line 304 "parse.y"
+{sqlite3AddCheckConstraint(pParse,yymsp[-1].minor.yy94.pExpr);}
+#line 2395 "parse.c"
+        break;
+      case 66: /* ccons ::= REFERENCES nm idxlist_opt refargs */
+#line 306 "parse.y"
+{sqlite3CreateForeignKey(pParse,0,&yymsp[-2].minor.yy0,yymsp[-1].minor.yy298,yymsp[0].minor.yy156);}
+#line 2400 "parse.c"
+        break;
+      case 67: /* ccons ::= defer_subclause */
+#line 307 "parse.y"
+{sqlite3DeferForeignKey(pParse,yymsp[0].minor.yy156);}
+#line 2405 "parse.c"
+        break;
+      case 68: /* ccons ::= COLLATE ID|STRING */
+#line 308 "parse.y"
+{sqlite3AddCollateType(pParse, &yymsp[0].minor.yy0);}
+#line 2410 "parse.c"
+        break;
+      case 71: /* refargs ::= */
+#line 321 "parse.y"
+{ yygotominor.yy156 = OE_None*0x0101; /* EV: R-19803-45884 */}
+#line 2415 "parse.c"
+        break;
+      case 72: /* refargs ::= refargs refarg */
+#line 322 "parse.y"
+{ yygotominor.yy156 = (yymsp[-1].minor.yy156 & ~yymsp[0].minor.yy199.mask) | yymsp[0].minor.yy199.value; }
+#line 2420 "parse.c"
+        break;
+      case 73: /* refarg ::= MATCH nm */
+      case 74: /* refarg ::= ON INSERT refact */ yytestcase(yyruleno==74);
+#line 324 "parse.y"
+{ yygotominor.yy199.value = 0;     yygotominor.yy199.mask = 0x000000; }
+#line 2426 "parse.c"
+        break;
+      case 75: /* refarg ::= ON DELETE refact */
+#line 326 "parse.y"
+{ yygotominor.yy199.value = yymsp[0].minor.yy156;     yygotominor.yy199.mask = 0x0000ff; }
+#line 2431 "parse.c"
+        break;
+      case 76: /* refarg ::= ON UPDATE refact */
+#line 327 "parse.y"
+{ yygotominor.yy199.value = yymsp[0].minor.yy156<<8;  yygotominor.yy199.mask = 0x00ff00; }
+#line 2436 "parse.c"
+        break;
+      case 77: /* refact ::= SET NULL */
+#line 329 "parse.y"
+{ yygotominor.yy156 = OE_SetNull;  /* EV: R-33326-45252 */}
+#line 2441 "parse.c"
+        break;
+      case 78: /* refact ::= SET DEFAULT */
+#line 330 "parse.y"
+{ yygotominor.yy156 = OE_SetDflt;  /* EV: R-33326-45252 */}
+#line 2446 "parse.c"
+        break;
+      case 79: /* refact ::= CASCADE */
+#line 331 "parse.y"
+{ yygotominor.yy156 = OE_Cascade;  /* EV: R-33326-45252 */}
+#line 2451 "parse.c"
+        break;
+      case 80: /* refact ::= RESTRICT */
+#line 332 "parse.y"
+{ yygotominor.yy156 = OE_Restrict; /* EV: R-33326-45252 */}
+#line 2456 "parse.c"
+        break;
+      case 81: /* refact ::= NO ACTION */
+#line 333 "parse.y"
+{ yygotominor.yy156 = OE_None;     /* EV: R-33326-45252 */}
+#line 2461 "parse.c"
+        break;
+      case 83: /* defer_subclause ::= DEFERRABLE init_deferred_pred_opt */
+      case 99: /* defer_subclause_opt ::= defer_subclause */ yytestcase(yyruleno==99);
+      case 101: /* onconf ::= ON CONFLICT resolvetype */ yytestcase(yyruleno==101);
+      case 104: /* resolvetype ::= raisetype */ yytestcase(yyruleno==104);
+#line 336 "parse.y"
+{yygotominor.yy156 = yymsp[0].minor.yy156;}
+#line 2469 "parse.c"
+        break;
+      case 87: /* conslist_opt ::= */
+#line 342 "parse.y"
+{yygotominor.yy0.n = 0; yygotominor.yy0.z = 0;}
+#line 2474 "parse.c"
+        break;
+      case 88: /* conslist_opt ::= COMMA conslist */
+#line 343 "parse.y"
+{yygotominor.yy0 = yymsp[-1].minor.yy0;}
+#line 2479 "parse.c"
+        break;
+      case 91: /* tconscomma ::= COMMA */
+#line 346 "parse.y"
+{pParse->constraintName.n = 0;}
+#line 2484 "parse.c"
+        break;
+      case 94: /* tcons ::= PRIMARY KEY LP idxlist autoinc RP onconf */
+#line 350 "parse.y"
+{sqlite3AddPrimaryKey(pParse,yymsp[-3].minor.yy298,yymsp[0].minor.yy156,yymsp[-2].minor.yy156,0);}
+#line 2489 "parse.c"
+        break;
+      case 95: /* tcons ::= UNIQUE LP idxlist RP onconf */
+#line 352 "parse.y"
+{sqlite3CreateIndex(pParse,0,0,0,yymsp[-2].minor.yy298,yymsp[0].minor.yy156,0,0,0,0);}
+#line 2494 "parse.c"
+        break;
+      case 96: /* tcons ::= CHECK LP expr RP onconf */
+#line 354 "parse.y"
+{sqlite3AddCheckConstraint(pParse,yymsp[-2].minor.yy94.pExpr);}
+#line 2499 "parse.c"
+        break;
+      case 97: /* tcons ::= FOREIGN KEY LP idxlist RP REFERENCES nm idxlist_opt refargs defer_subclause_opt */
+#line 356 "parse.y"
+{
+    sqlite3CreateForeignKey(pParse, yymsp[-6].minor.yy298, &yymsp[-3].minor.yy0, yymsp[-2].minor.yy298, yymsp[-1].minor.yy156);
+    sqlite3DeferForeignKey(pParse, yymsp[0].minor.yy156);
+}
+#line 2507 "parse.c"
+        break;
+      case 100: /* onconf ::= */
+#line 370 "parse.y"
+{yygotominor.yy156 = OE_Default;}
+#line 2512 "parse.c"
+        break;
+      case 102: /* orconf ::= */
+#line 372 "parse.y"
+{yygotominor.yy162 = OE_Default;}
+#line 2517 "parse.c"
+        break;
+      case 103: /* orconf ::= OR resolvetype */
+#line 373 "parse.y"
+{yygotominor.yy162 = (u8)yymsp[0].minor.yy156;}
+#line 2522 "parse.c"
+        break;
+      case 105: /* resolvetype ::= IGNORE */
+#line 375 "parse.y"
+{yygotominor.yy156 = OE_Ignore;}
+#line 2527 "parse.c"
+        break;
+      case 106: /* resolvetype ::= REPLACE */
+#line 376 "parse.y"
+{yygotominor.yy156 = OE_Replace;}
+#line 2532 "parse.c"
+        break;
+      case 107: /* cmd ::= DROP TABLE ifexists fullname */
+#line 380 "parse.y"
+{
+  sqlite3DropTable(pParse, yymsp[0].minor.yy115, 0, yymsp[-1].minor.yy156);
+}
+#line 2539 "parse.c"
+        break;
+      case 110: /* cmd ::= createkw temp VIEW ifnotexists nm dbnm AS select */
+#line 390 "parse.y"
+{
+  sqlite3CreateView(pParse, &yymsp[-7].minor.yy0, &yymsp[-3].minor.yy0, &yymsp[-2].minor.yy0, yymsp[0].minor.yy27, yymsp[-6].minor.yy156, yymsp[-4].minor.yy156);
+}
+#line 2546 "parse.c"
+        break;
+      case 111: /* cmd ::= DROP VIEW ifexists fullname */
+#line 393 "parse.y"
+{
+  sqlite3DropTable(pParse, yymsp[0].minor.yy115, 1, yymsp[-1].minor.yy156);
+}
+#line 2553 "parse.c"
+        break;
+      case 112: /* cmd ::= select */
+#line 400 "parse.y"
+{
+  SelectDest dest = {SRT_Output, 0, 0, 0, 0, 0};
+  sqlite3Select(pParse, yymsp[0].minor.yy27, &dest);
+  sqlite3ExplainBegin(pParse->pVdbe);
+  sqlite3ExplainSelect(pParse->pVdbe, yymsp[0].minor.yy27);
+  sqlite3ExplainFinish(pParse->pVdbe);
+  sqlite3SelectDelete(pParse->db, yymsp[0].minor.yy27);
+}
+#line 2565 "parse.c"
+        break;
+      case 113: /* select ::= with selectnowith */
+#line 416 "parse.y"
+{
+  Select *p = yymsp[0].minor.yy27, *pNext, *pLoop;
+  if( p ){
+    int cnt = 0, mxSelect;
+    p->pWith = yymsp[-1].minor.yy363;
+    if( p->pPrior ){
+      pNext = 0;
+      for(pLoop=p; pLoop; pNext=pLoop, pLoop=pLoop->pPrior, cnt++){
+        pLoop->pNext = pNext;
+        pLoop->selFlags |= SF_Compound;
+      }
+      mxSelect = pParse->db->aLimit[SQLITE_LIMIT_COMPOUND_SELECT];
+      if( mxSelect && cnt>mxSelect ){
+        sqlite3ErrorMsg(pParse, "too many terms in compound SELECT");
+      }
+    }
+  }else{
+    sqlite3WithDelete(pParse->db, yymsp[-1].minor.yy363);
+  }
+  yygotominor.yy27 = p;
+}
+#line 2590 "parse.c"
+        break;
+      case 114: /* selectnowith ::= oneselect */
+      case 120: /* oneselect ::= values */ yytestcase(yyruleno==120);
+#line 438 "parse.y"
+{yygotominor.yy27 = yymsp[0].minor.yy27;}
+#line 2596 "parse.c"
+        break;
+      case 115: /* selectnowith ::= selectnowith multiselect_op oneselect */
+#line 440 "parse.y"
+{
+  Select *pRhs = yymsp[0].minor.yy27;
+  if( pRhs && pRhs->pPrior ){
+    SrcList *pFrom;
+    Token x;
+    x.n = 0;
+    pFrom = sqlite3SrcListAppendFromTerm(pParse,0,0,0,&x,pRhs,0,0);
+    pRhs = sqlite3SelectNew(pParse,0,pFrom,0,0,0,0,0,0,0);
+  }
+  if( pRhs ){
+    pRhs->op = (u8)yymsp[-1].minor.yy156;
+    pRhs->pPrior = yymsp[-2].minor.yy27;
+    if( yymsp[-1].minor.yy156!=TK_ALL ) pParse->hasCompound = 1;
+  }else{
+    sqlite3SelectDelete(pParse->db, yymsp[-2].minor.yy27);
+  }
+  yygotominor.yy27 = pRhs;
+}
+#line 2618 "parse.c"
+        break;
+      case 117: /* multiselect_op ::= UNION ALL */
+#line 460 "parse.y"
+{yygotominor.yy156 = TK_ALL;}
+#line 2623 "parse.c"
+        break;
+      case 119: /* oneselect ::= SELECT distinct selcollist from where_opt groupby_opt having_opt orderby_opt limit_opt */
+#line 464 "parse.y"
+{
+  yygotominor.yy27 = sqlite3SelectNew(pParse,yymsp[-6].minor.yy298,yymsp[-5].minor.yy115,yymsp[-4].minor.yy326,yymsp[-3].minor.yy298,yymsp[-2].minor.yy326,yymsp[-1].minor.yy298,yymsp[-7].minor.yy89,yymsp[0].minor.yy504.pLimit,yymsp[0].minor.yy504.pOffset);
+}
+#line 2630 "parse.c"
+        break;
+      case 121: /* values ::= VALUES LP nexprlist RP */
+#line 471 "parse.y"
+{
+  yygotominor.yy27 = sqlite3SelectNew(pParse,yymsp[-1].minor.yy298,0,0,0,0,0,SF_Values,0,0);
+}
+#line 2637 "parse.c"
+        break;
+      case 122: /* values ::= values COMMA LP exprlist RP */
+#line 474 "parse.y"
+{
+  Select *pRight = sqlite3SelectNew(pParse,yymsp[-1].minor.yy298,0,0,0,0,0,SF_Values,0,0);
+  if( pRight ){
+    pRight->op = TK_ALL;
+    pRight->pPrior = yymsp[-4].minor.yy27;
+    yygotominor.yy27 = pRight;
+  }else{
+    yygotominor.yy27 = yymsp[-4].minor.yy27;
+  }
+}
+#line 2651 "parse.c"
+        break;
+      case 123: /* distinct ::= DISTINCT */
+#line 489 "parse.y"
+{yygotominor.yy89 = SF_Distinct;}
+#line 2656 "parse.c"
+        break;
+      case 124: /* distinct ::= ALL */
+      case 125: /* distinct ::= */ yytestcase(yyruleno==125);
+#line 490 "parse.y"
+{yygotominor.yy89 = 0;}
+#line 2662 "parse.c"
+        break;
+      case 126: /* sclp ::= selcollist COMMA */
+      case 244: /* idxlist_opt ::= LP idxlist RP */ yytestcase(yyruleno==244);
+#line 502 "parse.y"
+{yygotominor.yy298 = yymsp[-1].minor.yy298;}
+#line 2668 "parse.c"
+        break;
+      case 127: /* sclp ::= */
+      case 155: /* orderby_opt ::= */ yytestcase(yyruleno==155);
+      case 162: /* groupby_opt ::= */ yytestcase(yyruleno==162);
+      case 237: /* exprlist ::= */ yytestcase(yyruleno==237);
+      case 243: /* idxlist_opt ::= */ yytestcase(yyruleno==243);
+#line 503 "parse.y"
+{yygotominor.yy298 = 0;}
+#line 2677 "parse.c"
+        break;
+      case 128: /* selcollist ::= sclp expr as */
+#line 504 "parse.y"
+{
+   yygotominor.yy298 = sqlite3ExprListAppend(pParse, yymsp[-2].minor.yy298, yymsp[-1].minor.yy94.pExpr);
+   if( yymsp[0].minor.yy0.n>0 ) sqlite3ExprListSetName(pParse, yygotominor.yy298, &yymsp[0].minor.yy0, 1);
+   sqlite3ExprListSetSpan(pParse,yygotominor.yy298,&yymsp[-1].minor.yy94);
+}
+#line 2686 "parse.c"
+        break;
+      case 129: /* selcollist ::= sclp STAR */
+#line 509 "parse.y"
+{
+  Expr *p = sqlite3Expr(pParse->db, TK_ALL, 0);
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse, yymsp[-1].minor.yy298, p);
+}
+#line 2694 "parse.c"
+        break;
+      case 130: /* selcollist ::= sclp nm DOT STAR */
+#line 513 "parse.y"
+{
+  Expr *pRight = sqlite3PExpr(pParse, TK_ALL, 0, 0, &yymsp[0].minor.yy0);
+  Expr *pLeft = sqlite3PExpr(pParse, TK_ID, 0, 0, &yymsp[-2].minor.yy0);
+  Expr *pDot = sqlite3PExpr(pParse, TK_DOT, pLeft, pRight, 0);
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse,yymsp[-3].minor.yy298, pDot);
+}
+#line 2704 "parse.c"
+        break;
+      case 133: /* as ::= */
+#line 526 "parse.y"
+{yygotominor.yy0.n = 0;}
+#line 2709 "parse.c"
+        break;
+      case 134: /* from ::= */
+#line 538 "parse.y"
+{yygotominor.yy115 = sqlite3DbMallocZero(pParse->db, sizeof(*yygotominor.yy115));}
+#line 2714 "parse.c"
+        break;
+      case 135: /* from ::= FROM seltablist */
+#line 539 "parse.y"
+{
+  yygotominor.yy115 = yymsp[0].minor.yy115;
+  sqlite3SrcListShiftJoinType(yygotominor.yy115);
+}
+#line 2722 "parse.c"
+        break;
+      case 136: /* stl_prefix ::= seltablist joinop */
+#line 547 "parse.y"
+{
+   yygotominor.yy115 = yymsp[-1].minor.yy115;
+   if( ALWAYS(yygotominor.yy115 && yygotominor.yy115->nSrc>0) ) yygotominor.yy115->a[yygotominor.yy115->nSrc-1].jointype = (u8)yymsp[0].minor.yy156;
+}
+#line 2730 "parse.c"
+        break;
+      case 137: /* stl_prefix ::= */
+#line 551 "parse.y"
+{yygotominor.yy115 = 0;}
+#line 2735 "parse.c"
+        break;
+      case 138: /* seltablist ::= stl_prefix nm dbnm as indexed_opt on_opt using_opt */
+#line 553 "parse.y"
+{
+  yygotominor.yy115 = sqlite3SrcListAppendFromTerm(pParse,yymsp[-6].minor.yy115,&yymsp[-5].minor.yy0,&yymsp[-4].minor.yy0,&yymsp[-3].minor.yy0,0,yymsp[-1].minor.yy326,yymsp[0].minor.yy164);
+  sqlite3SrcListIndexedBy(pParse, yygotominor.yy115, &yymsp[-2].minor.yy0);
+}
+#line 2743 "parse.c"
+        break;
+      case 139: /* seltablist ::= stl_prefix LP select RP as on_opt using_opt */
+#line 559 "parse.y"
+{
+    yygotominor.yy115 = sqlite3SrcListAppendFromTerm(pParse,yymsp[-6].minor.yy115,0,0,&yymsp[-2].minor.yy0,yymsp[-4].minor.yy27,yymsp[-1].minor.yy326,yymsp[0].minor.yy164);
+  }
+#line 2750 "parse.c"
+        break;
+      case 140: /* seltablist ::= stl_prefix LP seltablist RP as on_opt using_opt */
+#line 563 "parse.y"
+{
+    if( yymsp[-6].minor.yy115==0 && yymsp[-2].minor.yy0.n==0 && yymsp[-1].minor.yy326==0 && yymsp[0].minor.yy164==0 ){
+      yygotominor.yy115 = yymsp[-4].minor.yy115;
+    }else if( yymsp[-4].minor.yy115->nSrc==1 ){
+      yygotominor.yy115 = sqlite3SrcListAppendFromTerm(pParse,yymsp[-6].minor.yy115,0,0,&yymsp[-2].minor.yy0,0,yymsp[-1].minor.yy326,yymsp[0].minor.yy164);
+      if( yygotominor.yy115 ){
+        struct SrcList_item *pNew = &yygotominor.yy115->a[yygotominor.yy115->nSrc-1];
+        struct SrcList_item *pOld = yymsp[-4].minor.yy115->a;
+        pNew->zName = pOld->zName;
+        pNew->zDatabase = pOld->zDatabase;
+        pNew->pSelect = pOld->pSelect;
+        pOld->zName = pOld->zDatabase = 0;
+        pOld->pSelect = 0;
+      }
+      sqlite3SrcListDelete(pParse->db, yymsp[-4].minor.yy115);
+    }else{
+      Select *pSubquery;
+      sqlite3SrcListShiftJoinType(yymsp[-4].minor.yy115);
+      pSubquery = sqlite3SelectNew(pParse,0,yymsp[-4].minor.yy115,0,0,0,0,SF_NestedFrom,0,0);
+      yygotominor.yy115 = sqlite3SrcListAppendFromTerm(pParse,yymsp[-6].minor.yy115,0,0,&yymsp[-2].minor.yy0,pSubquery,yymsp[-1].minor.yy326,yymsp[0].minor.yy164);
+    }
+  }
+#line 2776 "parse.c"
+        break;
+      case 141: /* dbnm ::= */
+      case 150: /* indexed_opt ::= */ yytestcase(yyruleno==150);
+#line 588 "parse.y"
+{yygotominor.yy0.z=0; yygotominor.yy0.n=0;}
+#line 2782 "parse.c"
+        break;
+      case 143: /* fullname ::= nm dbnm */
+#line 593 "parse.y"
+{yygotominor.yy115 = sqlite3SrcListAppend(pParse->db,0,&yymsp[-1].minor.yy0,&yymsp[0].minor.yy0);}
+#line 2787 "parse.c"
+        break;
+      case 144: /* joinop ::= COMMA|JOIN */
+#line 597 "parse.y"
+{ yygotominor.yy156 = JT_INNER; }
+#line 2792 "parse.c"
+        break;
+      case 145: /* joinop ::= JOIN_KW JOIN */
+#line 598 "parse.y"
+{ yygotominor.yy156 = sqlite3JoinType(pParse,&yymsp[-1].minor.yy0,0,0); }
+#line 2797 "parse.c"
+        break;
+      case 146: /* joinop ::= JOIN_KW nm JOIN */
+#line 599 "parse.y"
+{ yygotominor.yy156 = sqlite3JoinType(pParse,&yymsp[-2].minor.yy0,&yymsp[-1].minor.yy0,0); }
+#line 2802 "parse.c"
+        break;
+      case 147: /* joinop ::= JOIN_KW nm nm JOIN */
+#line 601 "parse.y"
+{ yygotominor.yy156 = sqlite3JoinType(pParse,&yymsp[-3].minor.yy0,&yymsp[-2].minor.yy0,&yymsp[-1].minor.yy0); }
+#line 2807 "parse.c"
+        break;
+      case 148: /* on_opt ::= ON expr */
+      case 165: /* having_opt ::= HAVING expr */ yytestcase(yyruleno==165);
+      case 172: /* where_opt ::= WHERE expr */ yytestcase(yyruleno==172);
+      case 232: /* case_else ::= ELSE expr */ yytestcase(yyruleno==232);
+      case 234: /* case_operand ::= expr */ yytestcase(yyruleno==234);
+#line 605 "parse.y"
+{yygotominor.yy326 = yymsp[0].minor.yy94.pExpr;}
+#line 2816 "parse.c"
+        break;
+      case 149: /* on_opt ::= */
+      case 164: /* having_opt ::= */ yytestcase(yyruleno==164);
+      case 171: /* where_opt ::= */ yytestcase(yyruleno==171);
+      case 233: /* case_else ::= */ yytestcase(yyruleno==233);
+      case 235: /* case_operand ::= */ yytestcase(yyruleno==235);
+#line 606 "parse.y"
+{yygotominor.yy326 = 0;}
+#line 2825 "parse.c"
+        break;
+      case 152: /* indexed_opt ::= NOT INDEXED */
+#line 621 "parse.y"
+{yygotominor.yy0.z=0; yygotominor.yy0.n=1;}
+#line 2830 "parse.c"
+        break;
+      case 153: /* using_opt ::= USING LP idlist RP */
+      case 181: /* inscollist_opt ::= LP idlist RP */ yytestcase(yyruleno==181);
+#line 625 "parse.y"
+{yygotominor.yy164 = yymsp[-1].minor.yy164;}
+#line 2836 "parse.c"
+        break;
+      case 154: /* using_opt ::= */
+      case 180: /* inscollist_opt ::= */ yytestcase(yyruleno==180);
+#line 626 "parse.y"
+{yygotominor.yy164 = 0;}
+#line 2842 "parse.c"
+        break;
+      case 156: /* orderby_opt ::= ORDER BY sortlist */
+      case 163: /* groupby_opt ::= GROUP BY nexprlist */ yytestcase(yyruleno==163);
+      case 236: /* exprlist ::= nexprlist */ yytestcase(yyruleno==236);
+#line 635 "parse.y"
+{yygotominor.yy298 = yymsp[0].minor.yy298;}
+#line 2849 "parse.c"
+        break;
+      case 157: /* sortlist ::= sortlist COMMA expr sortorder */
+#line 636 "parse.y"
+{
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse,yymsp[-3].minor.yy298,yymsp[-1].minor.yy94.pExpr);
+  if( yygotominor.yy298 ) yygotominor.yy298->a[yygotominor.yy298->nExpr-1].sortOrder = (u8)yymsp[0].minor.yy156;
+}
+#line 2857 "parse.c"
+        break;
+      case 158: /* sortlist ::= expr sortorder */
+#line 640 "parse.y"
+{
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse,0,yymsp[-1].minor.yy94.pExpr);
+  if( yygotominor.yy298 && ALWAYS(yygotominor.yy298->a) ) yygotominor.yy298->a[0].sortOrder = (u8)yymsp[0].minor.yy156;
+}
+#line 2865 "parse.c"
+        break;
+      case 159: /* sortorder ::= ASC */
+      case 161: /* sortorder ::= */ yytestcase(yyruleno==161);
+#line 647 "parse.y"
+{yygotominor.yy156 = SQLITE_SO_ASC;}
+#line 2871 "parse.c"
+        break;
+      case 160: /* sortorder ::= DESC */
+#line 648 "parse.y"
+{yygotominor.yy156 = SQLITE_SO_DESC;}
+#line 2876 "parse.c"
+        break;
+      case 166: /* limit_opt ::= */
+#line 674 "parse.y"
+{yygotominor.yy504.pLimit = 0; yygotominor.yy504.pOffset = 0;}
+#line 2881 "parse.c"
+        break;
+      case 167: /* limit_opt ::= LIMIT expr */
+#line 675 "parse.y"
+{yygotominor.yy504.pLimit = yymsp[0].minor.yy94.pExpr; yygotominor.yy504.pOffset = 0;}
+#line 2886 "parse.c"
+        break;
+      case 168: /* limit_opt ::= LIMIT expr OFFSET expr */
+#line 677 "parse.y"
+{yygotominor.yy504.pLimit = yymsp[-2].minor.yy94.pExpr; yygotominor.yy504.pOffset = yymsp[0].minor.yy94.pExpr;}
+#line 2891 "parse.c"
+        break;
+      case 169: /* limit_opt ::= LIMIT expr COMMA expr */
+#line 679 "parse.y"
+{yygotominor.yy504.pOffset = yymsp[-2].minor.yy94.pExpr; yygotominor.yy504.pLimit = yymsp[0].minor.yy94.pExpr;}
+#line 2896 "parse.c"
+        break;
+      case 170: /* cmd ::= with DELETE FROM fullname indexed_opt where_opt */
+#line 693 "parse.y"
+{
+  sqlite3WithPush(pParse, yymsp[-5].minor.yy363, 1);
+  sqlite3SrcListIndexedBy(pParse, yymsp[-2].minor.yy115, &yymsp[-1].minor.yy0);
+  sqlite3DeleteFrom(pParse,yymsp[-2].minor.yy115,yymsp[0].minor.yy326);
+}
+#line 2905 "parse.c"
+        break;
+      case 173: /* cmd ::= with UPDATE orconf fullname indexed_opt SET setlist where_opt */
+#line 720 "parse.y"
+{
+  sqlite3WithPush(pParse, yymsp[-7].minor.yy363, 1);
+  sqlite3SrcListIndexedBy(pParse, yymsp[-4].minor.yy115, &yymsp[-3].minor.yy0);
+  sqlite3ExprListCheckLength(pParse,yymsp[-1].minor.yy298,"set list"); 
+  sqlite3Update(pParse,yymsp[-4].minor.yy115,yymsp[-1].minor.yy298,yymsp[0].minor.yy326,yymsp[-5].minor.yy162);
+}
+#line 2915 "parse.c"
+        break;
+      case 174: /* setlist ::= setlist COMMA nm EQ expr */
+#line 731 "parse.y"
+{
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse, yymsp[-4].minor.yy298, yymsp[0].minor.yy94.pExpr);
+  sqlite3ExprListSetName(pParse, yygotominor.yy298, &yymsp[-2].minor.yy0, 1);
+}
+#line 2923 "parse.c"
+        break;
+      case 175: /* setlist ::= nm EQ expr */
+#line 735 "parse.y"
+{
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse, 0, yymsp[0].minor.yy94.pExpr);
+  sqlite3ExprListSetName(pParse, yygotominor.yy298, &yymsp[-2].minor.yy0, 1);
+}
+#line 2931 "parse.c"
+        break;
+      case 176: /* cmd ::= with insert_cmd INTO fullname inscollist_opt select */
+#line 742 "parse.y"
+{
+  sqlite3WithPush(pParse, yymsp[-5].minor.yy363, 1);
+  sqlite3Insert(pParse, yymsp[-2].minor.yy115, yymsp[0].minor.yy27, yymsp[-1].minor.yy164, yymsp[-4].minor.yy162);
+}
+#line 2939 "parse.c"
+        break;
+      case 177: /* cmd ::= with insert_cmd INTO fullname inscollist_opt DEFAULT VALUES */
+#line 747 "parse.y"
+{
+  sqlite3WithPush(pParse, yymsp[-6].minor.yy363, 1);
+  sqlite3Insert(pParse, yymsp[-3].minor.yy115, 0, yymsp[-2].minor.yy164, yymsp[-5].minor.yy162);
+}
+#line 2947 "parse.c"
+        break;
+      case 178: /* insert_cmd ::= INSERT orconf */
+#line 753 "parse.y"
+{yygotominor.yy162 = yymsp[0].minor.yy162;}
+#line 2952 "parse.c"
+        break;
+      case 179: /* insert_cmd ::= REPLACE */
+#line 754 "parse.y"
+{yygotominor.yy162 = OE_Replace;}
+#line 2957 "parse.c"
+        break;
+      case 182: /* idlist ::= idlist COMMA nm */
+#line 764 "parse.y"
+{yygotominor.yy164 = sqlite3IdListAppend(pParse->db,yymsp[-2].minor.yy164,&yymsp[0].minor.yy0);}
+#line 2962 "parse.c"
+        break;
+      case 183: /* idlist ::= nm */
+#line 766 "parse.y"
+{yygotominor.yy164 = sqlite3IdListAppend(pParse->db,0,&yymsp[0].minor.yy0);}
+#line 2967 "parse.c"
+        break;
+      case 184: /* expr ::= term */
+#line 797 "parse.y"
+{yygotominor.yy94 = yymsp[0].minor.yy94;}
+#line 2972 "parse.c"
+        break;
+      case 185: /* expr ::= LP expr RP */
+#line 798 "parse.y"
+{yygotominor.yy94.pExpr = yymsp[-1].minor.yy94.pExpr; spanSet(&yygotominor.yy94,&yymsp[-2].minor.yy0,&yymsp[0].minor.yy0);}
+#line 2977 "parse.c"
+        break;
+      case 186: /* term ::= NULL */
+      case 191: /* term ::= INTEGER|FLOAT|BLOB */ yytestcase(yyruleno==191);
+      case 192: /* term ::= STRING */ yytestcase(yyruleno==192);
+#line 799 "parse.y"
+{spanExpr(&yygotominor.yy94, pParse, yymsp[0].major, &yymsp[0].minor.yy0);}
+#line 2984 "parse.c"
+        break;
+      case 187: /* expr ::= ID|INDEXED */
+      case 188: /* expr ::= JOIN_KW */ yytestcase(yyruleno==188);
+#line 800 "parse.y"
+{spanExpr(&yygotominor.yy94, pParse, TK_ID, &yymsp[0].minor.yy0);}
+#line 2990 "parse.c"
+        break;
+      case 189: /* expr ::= nm DOT nm */
+#line 802 "parse.y"
+{
+  Expr *temp1 = sqlite3PExpr(pParse, TK_ID, 0, 0, &yymsp[-2].minor.yy0);
+  Expr *temp2 = sqlite3PExpr(pParse, TK_ID, 0, 0, &yymsp[0].minor.yy0);
+  yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_DOT, temp1, temp2, 0);
+  spanSet(&yygotominor.yy94,&yymsp[-2].minor.yy0,&yymsp[0].minor.yy0);
+}
+#line 3000 "parse.c"
+        break;
+      case 190: /* expr ::= nm DOT nm DOT nm */
+#line 808 "parse.y"
+{
+  Expr *temp1 = sqlite3PExpr(pParse, TK_ID, 0, 0, &yymsp[-4].minor.yy0);
+  Expr *temp2 = sqlite3PExpr(pParse, TK_ID, 0, 0, &yymsp[-2].minor.yy0);
+  Expr *temp3 = sqlite3PExpr(pParse, TK_ID, 0, 0, &yymsp[0].minor.yy0);
+  Expr *temp4 = sqlite3PExpr(pParse, TK_DOT, temp2, temp3, 0);
+  yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_DOT, temp1, temp4, 0);
+  spanSet(&yygotominor.yy94,&yymsp[-4].minor.yy0,&yymsp[0].minor.yy0);
+}
+#line 3012 "parse.c"
+        break;
+      case 193: /* expr ::= VARIABLE */
+#line 818 "parse.y"
+{
+  if( yymsp[0].minor.yy0.n>=2 && yymsp[0].minor.yy0.z[0]=='#' && sqlite3Isdigit(yymsp[0].minor.yy0.z[1]) ){
+    /* When doing a nested parse, one can include terms in an expression
+    ** that look like this:   #1 #2 ...  These terms refer to registers
+    ** in the virtual machine.  #N is the N-th register. */
+    if( pParse->nested==0 ){
+      sqlite3ErrorMsg(pParse, "near \"%T\": syntax error", &yymsp[0].minor.yy0);
+      yygotominor.yy94.pExpr = 0;
+    }else{
+      yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_REGISTER, 0, 0, &yymsp[0].minor.yy0);
+      if( yygotominor.yy94.pExpr ) sqlite3GetInt32(&yymsp[0].minor.yy0.z[1], &yygotominor.yy94.pExpr->iTable);
+    }
+  }else{
+    spanExpr(&yygotominor.yy94, pParse, TK_VARIABLE, &yymsp[0].minor.yy0);
+    sqlite3ExprAssignVarNumber(pParse, yygotominor.yy94.pExpr);
+  }
+  spanSet(&yygotominor.yy94, &yymsp[0].minor.yy0, &yymsp[0].minor.yy0);
+}
+#line 3034 "parse.c"
+        break;
+      case 194: /* expr ::= expr COLLATE ID|STRING */
+#line 836 "parse.y"
+{
+  yygotominor.yy94.pExpr = sqlite3ExprAddCollateToken(pParse, yymsp[-2].minor.yy94.pExpr, &yymsp[0].minor.yy0);
+  yygotominor.yy94.zStart = yymsp[-2].minor.yy94.zStart;
+  yygotominor.yy94.zEnd = &yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n];
+}
+#line 3043 "parse.c"
+        break;
+      case 195: /* expr ::= CAST LP expr AS typetoken RP */
+#line 842 "parse.y"
+{
+  yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_CAST, yymsp[-3].minor.yy94.pExpr, 0, &yymsp[-1].minor.yy0);
+  spanSet(&yygotominor.yy94,&yymsp[-5].minor.yy0,&yymsp[0].minor.yy0);
+}
+#line 3051 "parse.c"
+        break;
+      case 196: /* expr ::= ID|INDEXED LP distinct exprlist RP */
+#line 847 "parse.y"
+{
+  if( yymsp[-1].minor.yy298 && yymsp[-1].minor.yy298->nExpr>pParse->db->aLimit[SQLITE_LIMIT_FUNCTION_ARG] ){
+    sqlite3ErrorMsg(pParse, "too many arguments on function %T", &yymsp[-4].minor.yy0);
+  }
+  yygotominor.yy94.pExpr = sqlite3ExprFunction(pParse, yymsp[-1].minor.yy298, &yymsp[-4].minor.yy0);
+  spanSet(&yygotominor.yy94,&yymsp[-4].minor.yy0,&yymsp[0].minor.yy0);
+  if( yymsp[-2].minor.yy89 && yygotominor.yy94.pExpr ){
+    yygotominor.yy94.pExpr->flags |= EP_Distinct;
+  }
+}
+#line 3065 "parse.c"
+        break;
+      case 197: /* expr ::= ID|INDEXED LP STAR RP */
+#line 857 "parse.y"
+{
+  yygotominor.yy94.pExpr = sqlite3ExprFunction(pParse, 0, &yymsp[-3].minor.yy0);
+  spanSet(&yygotominor.yy94,&yymsp[-3].minor.yy0,&yymsp[0].minor.yy0);
+}
+#line 3073 "parse.c"
+        break;
+      case 198: /* term ::= CTIME_KW */
+#line 861 "parse.y"
+{
+  yygotominor.yy94.pExpr = sqlite3ExprFunction(pParse, 0, &yymsp[0].minor.yy0);
+  spanSet(&yygotominor.yy94, &yymsp[0].minor.yy0, &yymsp[0].minor.yy0);
+}
+#line 3081 "parse.c"
+        break;
+      case 199: /* expr ::= expr AND expr */
+      case 200: /* expr ::= expr OR expr */ yytestcase(yyruleno==200);
+      case 201: /* expr ::= expr LT|GT|GE|LE expr */ yytestcase(yyruleno==201);
+      case 202: /* expr ::= expr EQ|NE expr */ yytestcase(yyruleno==202);
+      case 203: /* expr ::= expr BITAND|BITOR|LSHIFT|RSHIFT expr */ yytestcase(yyruleno==203);
+      case 204: /* expr ::= expr PLUS|MINUS expr */ yytestcase(yyruleno==204);
+      case 205: /* expr ::= expr STAR|SLASH|REM expr */ yytestcase(yyruleno==205);
+      case 206: /* expr ::= expr CONCAT expr */ yytestcase(yyruleno==206);
+#line 883 "parse.y"
+{spanBinaryExpr(&yygotominor.yy94,pParse,yymsp[-1].major,&yymsp[-2].minor.yy94,&yymsp[0].minor.yy94);}
+#line 3093 "parse.c"
+        break;
+      case 207: /* likeop ::= LIKE_KW|MATCH */
+#line 896 "parse.y"
+{yygotominor.yy90.eOperator = yymsp[0].minor.yy0; yygotominor.yy90.bNot = 0;}
+#line 3098 "parse.c"
+        break;
+      case 208: /* likeop ::= NOT LIKE_KW|MATCH */
+#line 897 "parse.y"
+{yygotominor.yy90.eOperator = yymsp[0].minor.yy0; yygotominor.yy90.bNot = 1;}
+#line 3103 "parse.c"
+        break;
+      case 209: /* expr ::= expr likeop expr */
+#line 898 "parse.y"
+{
+  ExprList *pList;
+  pList = sqlite3ExprListAppend(pParse,0, yymsp[0].minor.yy94.pExpr);
+  pList = sqlite3ExprListAppend(pParse,pList, yymsp[-2].minor.yy94.pExpr);
+  yygotominor.yy94.pExpr = sqlite3ExprFunction(pParse, pList, &yymsp[-1].minor.yy90.eOperator);
+  if( yymsp[-1].minor.yy90.bNot ) yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_NOT, yygotominor.yy94.pExpr, 0, 0);
+  yygotominor.yy94.zStart = yymsp[-2].minor.yy94.zStart;
+  yygotominor.yy94.zEnd = yymsp[0].minor.yy94.zEnd;
+  if( yygotominor.yy94.pExpr ) yygotominor.yy94.pExpr->flags |= EP_InfixFunc;
+}
+#line 3117 "parse.c"
+        break;
+      case 210: /* expr ::= expr likeop expr ESCAPE expr */
+#line 908 "parse.y"
+{
+  ExprList *pList;
+  pList = sqlite3ExprListAppend(pParse,0, yymsp[-2].minor.yy94.pExpr);
+  pList = sqlite3ExprListAppend(pParse,pList, yymsp[-4].minor.yy94.pExpr);
+  pList = sqlite3ExprListAppend(pParse,pList, yymsp[0].minor.yy94.pExpr);
+  yygotominor.yy94.pExpr = sqlite3ExprFunction(pParse, pList, &yymsp[-3].minor.yy90.eOperator);
+  if( yymsp[-3].minor.yy90.bNot ) yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_NOT, yygotominor.yy94.pExpr, 0, 0);
+  yygotominor.yy94.zStart = yymsp[-4].minor.yy94.zStart;
+  yygotominor.yy94.zEnd = yymsp[0].minor.yy94.zEnd;
+  if( yygotominor.yy94.pExpr ) yygotominor.yy94.pExpr->flags |= EP_InfixFunc;
+}
+#line 3132 "parse.c"
+        break;
+      case 211: /* expr ::= expr ISNULL|NOTNULL */
+#line 936 "parse.y"
+{spanUnaryPostfix(&yygotominor.yy94,pParse,yymsp[0].major,&yymsp[-1].minor.yy94,&yymsp[0].minor.yy0);}
+#line 3137 "parse.c"
+        break;
+      case 212: /* expr ::= expr NOT NULL */
+#line 937 "parse.y"
+{spanUnaryPostfix(&yygotominor.yy94,pParse,TK_NOTNULL,&yymsp[-2].minor.yy94,&yymsp[0].minor.yy0);}
+#line 3142 "parse.c"
+        break;
+      case 213: /* expr ::= expr IS expr */
+#line 958 "parse.y"
+{
+  spanBinaryExpr(&yygotominor.yy94,pParse,TK_IS,&yymsp[-2].minor.yy94,&yymsp[0].minor.yy94);
+  binaryToUnaryIfNull(pParse, yymsp[0].minor.yy94.pExpr, yygotominor.yy94.pExpr, TK_ISNULL);
+}
+#line 3150 "parse.c"
+        break;
+      case 214: /* expr ::= expr IS NOT expr */
+#line 962 "parse.y"
+{
+  spanBinaryExpr(&yygotominor.yy94,pParse,TK_ISNOT,&yymsp[-3].minor.yy94,&yymsp[0].minor.yy94);
+  binaryToUnaryIfNull(pParse, yymsp[0].minor.yy94.pExpr, yygotominor.yy94.pExpr, TK_NOTNULL);
+}
+#line 3158 "parse.c"
+        break;
+      case 215: /* expr ::= NOT expr */
+      case 216: /* expr ::= BITNOT expr */ yytestcase(yyruleno==216);
+#line 985 "parse.y"
+{spanUnaryPrefix(&yygotominor.yy94,pParse,yymsp[-1].major,&yymsp[0].minor.yy94,&yymsp[-1].minor.yy0);}
+#line 3164 "parse.c"
+        break;
+      case 217: /* expr ::= MINUS expr */
+#line 988 "parse.y"
+{spanUnaryPrefix(&yygotominor.yy94,pParse,TK_UMINUS,&yymsp[0].minor.yy94,&yymsp[-1].minor.yy0);}
+#line 3169 "parse.c"
+        break;
+      case 218: /* expr ::= PLUS expr */
+#line 990 "parse.y"
+{spanUnaryPrefix(&yygotominor.yy94,pParse,TK_UPLUS,&yymsp[0].minor.yy94,&yymsp[-1].minor.yy0);}
+#line 3174 "parse.c"
+        break;
+      case 221: /* expr ::= expr between_op expr AND expr */
+#line 995 "parse.y"
+{
+  ExprList *pList = sqlite3ExprListAppend(pParse,0, yymsp[-2].minor.yy94.pExpr);
+  pList = sqlite3ExprListAppend(pParse,pList, yymsp[0].minor.yy94.pExpr);
+  yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_BETWEEN, yymsp[-4].minor.yy94.pExpr, 0, 0);
+  if( yygotominor.yy94.pExpr ){
+    yygotominor.yy94.pExpr->x.pList = pList;
+  }else{
+    sqlite3ExprListDelete(pParse->db, pList);
+  } 
+  if( yymsp[-3].minor.yy156 ) yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_NOT, yygotominor.yy94.pExpr, 0, 0);
+  yygotominor.yy94.zStart = yymsp[-4].minor.yy94.zStart;
+  yygotominor.yy94.zEnd = yymsp[0].minor.yy94.zEnd;
+}
+#line 3191 "parse.c"
+        break;
+      case 224: /* expr ::= expr in_op LP exprlist RP */
+#line 1012 "parse.y"
+{
+    if( yymsp[-1].minor.yy298==0 ){
+      /* Expressions of the form
+      **
+      **      expr1 IN ()
+      **      expr1 NOT IN ()
+      **
+      ** simplify to constants 0 (false) and 1 (true), respectively,
+      ** regardless of the value of expr1.
+      */
+      yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_INTEGER, 0, 0, &sqlite3IntTokens[yymsp[-3].minor.yy156]);
+      sqlite3ExprDelete(pParse->db, yymsp[-4].minor.yy94.pExpr);
+    }else{
+      yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_IN, yymsp[-4].minor.yy94.pExpr, 0, 0);
+      if( yygotominor.yy94.pExpr ){
+        yygotominor.yy94.pExpr->x.pList = yymsp[-1].minor.yy298;
+        sqlite3ExprSetHeight(pParse, yygotominor.yy94.pExpr);
+      }else{
+        sqlite3ExprListDelete(pParse->db, yymsp[-1].minor.yy298);
+      }
+      if( yymsp[-3].minor.yy156 ) yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_NOT, yygotominor.yy94.pExpr, 0, 0);
+    }
+    yygotominor.yy94.zStart = yymsp[-4].minor.yy94.zStart;
+    yygotominor.yy94.zEnd = &yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n];
+  }
+#line 3220 "parse.c"
+        break;
+      case 225: /* expr ::= LP select RP */
+#line 1037 "parse.y"
+{
+    yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_SELECT, 0, 0, 0);
+    if( yygotominor.yy94.pExpr ){
+      yygotominor.yy94.pExpr->x.pSelect = yymsp[-1].minor.yy27;
+      ExprSetProperty(yygotominor.yy94.pExpr, EP_xIsSelect);
+      sqlite3ExprSetHeight(pParse, yygotominor.yy94.pExpr);
+    }else{
+      sqlite3SelectDelete(pParse->db, yymsp[-1].minor.yy27);
+    }
+    yygotominor.yy94.zStart = yymsp[-2].minor.yy0.z;
+    yygotominor.yy94.zEnd = &yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n];
+  }
+#line 3236 "parse.c"
+        break;
+      case 226: /* expr ::= expr in_op LP select RP */
+#line 1049 "parse.y"
+{
+    yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_IN, yymsp[-4].minor.yy94.pExpr, 0, 0);
+    if( yygotominor.yy94.pExpr ){
+      yygotominor.yy94.pExpr->x.pSelect = yymsp[-1].minor.yy27;
+      ExprSetProperty(yygotominor.yy94.pExpr, EP_xIsSelect);
+      sqlite3ExprSetHeight(pParse, yygotominor.yy94.pExpr);
+    }else{
+      sqlite3SelectDelete(pParse->db, yymsp[-1].minor.yy27);
+    }
+    if( yymsp[-3].minor.yy156 ) yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_NOT, yygotominor.yy94.pExpr, 0, 0);
+    yygotominor.yy94.zStart = yymsp[-4].minor.yy94.zStart;
+    yygotominor.yy94.zEnd = &yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n];
+  }
+#line 3253 "parse.c"
+        break;
+      case 227: /* expr ::= expr in_op nm dbnm */
+#line 1062 "parse.y"
+{
+    SrcList *pSrc = sqlite3SrcListAppend(pParse->db, 0,&yymsp[-1].minor.yy0,&yymsp[0].minor.yy0);
+    yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_IN, yymsp[-3].minor.yy94.pExpr, 0, 0);
+    if( yygotominor.yy94.pExpr ){
+      yygotominor.yy94.pExpr->x.pSelect = sqlite3SelectNew(pParse, 0,pSrc,0,0,0,0,0,0,0);
+      ExprSetProperty(yygotominor.yy94.pExpr, EP_xIsSelect);
+      sqlite3ExprSetHeight(pParse, yygotominor.yy94.pExpr);
+    }else{
+      sqlite3SrcListDelete(pParse->db, pSrc);
+    }
+    if( yymsp[-2].minor.yy156 ) yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_NOT, yygotominor.yy94.pExpr, 0, 0);
+    yygotominor.yy94.zStart = yymsp[-3].minor.yy94.zStart;
+    yygotominor.yy94.zEnd = yymsp[0].minor.yy0.z ? &yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n] : &yymsp[-1].minor.yy0.z[yymsp[-1].minor.yy0.n];
+  }
+#line 3271 "parse.c"
+        break;
+      case 228: /* expr ::= EXISTS LP select RP */
+#line 1076 "parse.y"
+{
+    Expr *p = yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_EXISTS, 0, 0, 0);
+    if( p ){
+      p->x.pSelect = yymsp[-1].minor.yy27;
+      ExprSetProperty(p, EP_xIsSelect);
+      sqlite3ExprSetHeight(pParse, p);
+    }else{
+      sqlite3SelectDelete(pParse->db, yymsp[-1].minor.yy27);
+    }
+    yygotominor.yy94.zStart = yymsp[-3].minor.yy0.z;
+    yygotominor.yy94.zEnd = &yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n];
+  }
+#line 3287 "parse.c"
+        break;
+      case 229: /* expr ::= CASE case_operand case_exprlist case_else END */
+#line 1091 "parse.y"
+{
+  yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_CASE, yymsp[-3].minor.yy326, 0, 0);
+  if( yygotominor.yy94.pExpr ){
+    yygotominor.yy94.pExpr->x.pList = yymsp[-1].minor.yy326 ? sqlite3ExprListAppend(pParse,yymsp[-2].minor.yy298,yymsp[-1].minor.yy326) : yymsp[-2].minor.yy298;
+    sqlite3ExprSetHeight(pParse, yygotominor.yy94.pExpr);
+  }else{
+    sqlite3ExprListDelete(pParse->db, yymsp[-2].minor.yy298);
+    sqlite3ExprDelete(pParse->db, yymsp[-1].minor.yy326);
+  }
+  yygotominor.yy94.zStart = yymsp[-4].minor.yy0.z;
+  yygotominor.yy94.zEnd = &yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n];
+}
+#line 3303 "parse.c"
+        break;
+      case 230: /* case_exprlist ::= case_exprlist WHEN expr THEN expr */
+#line 1105 "parse.y"
+{
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse,yymsp[-4].minor.yy298, yymsp[-2].minor.yy94.pExpr);
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse,yygotominor.yy298, yymsp[0].minor.yy94.pExpr);
+}
+#line 3311 "parse.c"
+        break;
+      case 231: /* case_exprlist ::= WHEN expr THEN expr */
+#line 1109 "parse.y"
+{
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse,0, yymsp[-2].minor.yy94.pExpr);
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse,yygotominor.yy298, yymsp[0].minor.yy94.pExpr);
+}
+#line 3319 "parse.c"
+        break;
+      case 238: /* nexprlist ::= nexprlist COMMA expr */
+#line 1130 "parse.y"
+{yygotominor.yy298 = sqlite3ExprListAppend(pParse,yymsp[-2].minor.yy298,yymsp[0].minor.yy94.pExpr);}
+#line 3324 "parse.c"
+        break;
+      case 239: /* nexprlist ::= expr */
+#line 1132 "parse.y"
+{yygotominor.yy298 = sqlite3ExprListAppend(pParse,0,yymsp[0].minor.yy94.pExpr);}
+#line 3329 "parse.c"
+        break;
+      case 240: /* cmd ::= createkw uniqueflag INDEX ifnotexists nm dbnm ON nm LP idxlist RP where_opt */
+#line 1138 "parse.y"
+{
+  sqlite3CreateIndex(pParse, &yymsp[-7].minor.yy0, &yymsp[-6].minor.yy0, 
+                     sqlite3SrcListAppend(pParse->db,0,&yymsp[-4].minor.yy0,0), yymsp[-2].minor.yy298, yymsp[-10].minor.yy156,
+                      &yymsp[-11].minor.yy0, yymsp[0].minor.yy326, SQLITE_SO_ASC, yymsp[-8].minor.yy156);
+}
+#line 3338 "parse.c"
+        break;
+      case 241: /* uniqueflag ::= UNIQUE */
+      case 292: /* raisetype ::= ABORT */ yytestcase(yyruleno==292);
+#line 1145 "parse.y"
+{yygotominor.yy156 = OE_Abort;}
+#line 3344 "parse.c"
+        break;
+      case 242: /* uniqueflag ::= */
+#line 1146 "parse.y"
+{yygotominor.yy156 = OE_None;}
+#line 3349 "parse.c"
+        break;
+      case 245: /* idxlist ::= idxlist COMMA nm collate sortorder */
+#line 1155 "parse.y"
+{
+  Expr *p = sqlite3ExprAddCollateToken(pParse, 0, &yymsp[-1].minor.yy0);
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse,yymsp[-4].minor.yy298, p);
+  sqlite3ExprListSetName(pParse,yygotominor.yy298,&yymsp[-2].minor.yy0,1);
+  sqlite3ExprListCheckLength(pParse, yygotominor.yy298, "index");
+  if( yygotominor.yy298 ) yygotominor.yy298->a[yygotominor.yy298->nExpr-1].sortOrder = (u8)yymsp[0].minor.yy156;
+}
+#line 3360 "parse.c"
+        break;
+      case 246: /* idxlist ::= nm collate sortorder */
+#line 1162 "parse.y"
+{
+  Expr *p = sqlite3ExprAddCollateToken(pParse, 0, &yymsp[-1].minor.yy0);
+  yygotominor.yy298 = sqlite3ExprListAppend(pParse,0, p);
+  sqlite3ExprListSetName(pParse, yygotominor.yy298, &yymsp[-2].minor.yy0, 1);
+  sqlite3ExprListCheckLength(pParse, yygotominor.yy298, "index");
+  if( yygotominor.yy298 ) yygotominor.yy298->a[yygotominor.yy298->nExpr-1].sortOrder = (u8)yymsp[0].minor.yy156;
+}
+#line 3371 "parse.c"
+        break;
+      case 247: /* collate ::= */
+#line 1171 "parse.y"
+{yygotominor.yy0.z = 0; yygotominor.yy0.n = 0;}
+#line 3376 "parse.c"
+        break;
+      case 249: /* cmd ::= DROP INDEX ifexists fullname */
+#line 1177 "parse.y"
+{sqlite3DropIndex(pParse, yymsp[0].minor.yy115, yymsp[-1].minor.yy156);}
+#line 3381 "parse.c"
+        break;
+      case 250: /* cmd ::= VACUUM */
+      case 251: /* cmd ::= VACUUM nm */ yytestcase(yyruleno==251);
+#line 1183 "parse.y"
+{sqlite3Vacuum(pParse);}
+#line 3387 "parse.c"
+        break;
+      case 252: /* cmd ::= PRAGMA nm dbnm */
+#line 1191 "parse.y"
+{sqlite3Pragma(pParse,&yymsp[-1].minor.yy0,&yymsp[0].minor.yy0,0,0);}
+#line 3392 "parse.c"
+        break;
+      case 253: /* cmd ::= PRAGMA nm dbnm EQ nmnum */
+#line 1192 "parse.y"
+{sqlite3Pragma(pParse,&yymsp[-3].minor.yy0,&yymsp[-2].minor.yy0,&yymsp[0].minor.yy0,0);}
+#line 3397 "parse.c"
+        break;
+      case 254: /* cmd ::= PRAGMA nm dbnm LP nmnum RP */
+#line 1193 "parse.y"
+{sqlite3Pragma(pParse,&yymsp[-4].minor.yy0,&yymsp[-3].minor.yy0,&yymsp[-1].minor.yy0,0);}
+#line 3402 "parse.c"
+        break;
+      case 255: /* cmd ::= PRAGMA nm dbnm EQ minus_num */
+#line 1195 "parse.y"
+{sqlite3Pragma(pParse,&yymsp[-3].minor.yy0,&yymsp[-2].minor.yy0,&yymsp[0].minor.yy0,1);}
+#line 3407 "parse.c"
+        break;
+      case 256: /* cmd ::= PRAGMA nm dbnm LP minus_num RP */
+#line 1197 "parse.y"
+{sqlite3Pragma(pParse,&yymsp[-4].minor.yy0,&yymsp[-3].minor.yy0,&yymsp[-1].minor.yy0,1);}
+#line 3412 "parse.c"
+        break;
+      case 265: /* cmd ::= createkw trigger_decl BEGIN trigger_cmd_list END */
+#line 1213 "parse.y"
+{
+  Token all;
+  all.z = yymsp[-3].minor.yy0.z;
+  all.n = (int)(yymsp[0].minor.yy0.z - yymsp[-3].minor.yy0.z) + yymsp[0].minor.yy0.n;
+  sqlite3FinishTrigger(pParse, yymsp[-1].minor.yy427, &all);
+}
+#line 3422 "parse.c"
+        break;
+      case 266: /* trigger_decl ::= temp TRIGGER ifnotexists nm dbnm trigger_time trigger_event ON fullname foreach_clause when_clause */
+#line 1222 "parse.y"
+{
+  sqlite3BeginTrigger(pParse, &yymsp[-7].minor.yy0, &yymsp[-6].minor.yy0, yymsp[-5].minor.yy156, yymsp[-4].minor.yy382.a, yymsp[-4].minor.yy382.b, yymsp[-2].minor.yy115, yymsp[0].minor.yy326, yymsp[-10].minor.yy156, yymsp[-8].minor.yy156);
+  yygotominor.yy0 = (yymsp[-6].minor.yy0.n==0?yymsp[-7].minor.yy0:yymsp[-6].minor.yy0);
+}
+#line 3430 "parse.c"
+        break;
+      case 267: /* trigger_time ::= BEFORE */
+      case 270: /* trigger_time ::= */ yytestcase(yyruleno==270);
+#line 1228 "parse.y"
+{ yygotominor.yy156 = TK_BEFORE; }
+#line 3436 "parse.c"
+        break;
+      case 268: /* trigger_time ::= AFTER */
+#line 1229 "parse.y"
+{ yygotominor.yy156 = TK_AFTER;  }
+#line 3441 "parse.c"
+        break;
+      case 269: /* trigger_time ::= INSTEAD OF */
+#line 1230 "parse.y"
+{ yygotominor.yy156 = TK_INSTEAD;}
+#line 3446 "parse.c"
+        break;
+      case 271: /* trigger_event ::= DELETE|INSERT */
+      case 272: /* trigger_event ::= UPDATE */ yytestcase(yyruleno==272);
+#line 1235 "parse.y"
+{yygotominor.yy382.a = yymsp[0].major; yygotominor.yy382.b = 0;}
+#line 3452 "parse.c"
+        break;
+      case 273: /* trigger_event ::= UPDATE OF idlist */
+#line 1237 "parse.y"
+{yygotominor.yy382.a = TK_UPDATE; yygotominor.yy382.b = yymsp[0].minor.yy164;}
+#line 3457 "parse.c"
+        break;
+      case 276: /* when_clause ::= */
+      case 297: /* key_opt ::= */ yytestcase(yyruleno==297);
+#line 1244 "parse.y"
+{ yygotominor.yy326 = 0; }
+#line 3463 "parse.c"
+        break;
+      case 277: /* when_clause ::= WHEN expr */
+      case 298: /* key_opt ::= KEY expr */ yytestcase(yyruleno==298);
+#line 1245 "parse.y"
+{ yygotominor.yy326 = yymsp[0].minor.yy94.pExpr; }
+#line 3469 "parse.c"
+        break;
+      case 278: /* trigger_cmd_list ::= trigger_cmd_list trigger_cmd SEMI */
+#line 1249 "parse.y"
+{
+  assert( yymsp[-2].minor.yy427!=0 );
+  yymsp[-2].minor.yy427->pLast->pNext = yymsp[-1].minor.yy427;
+  yymsp[-2].minor.yy427->pLast = yymsp[-1].minor.yy427;
+  yygotominor.yy427 = yymsp[-2].minor.yy427;
+}
+#line 3479 "parse.c"
+        break;
+      case 279: /* trigger_cmd_list ::= trigger_cmd SEMI */
+#line 1255 "parse.y"
+{ 
+  assert( yymsp[-1].minor.yy427!=0 );
+  yymsp[-1].minor.yy427->pLast = yymsp[-1].minor.yy427;
+  yygotominor.yy427 = yymsp[-1].minor.yy427;
+}
+#line 3488 "parse.c"
+        break;
+      case 281: /* trnm ::= nm DOT nm */
+#line 1267 "parse.y"
+{
+  yygotominor.yy0 = yymsp[0].minor.yy0;
+  sqlite3ErrorMsg(pParse, 
+        "qualified table names are not allowed on INSERT, UPDATE, and DELETE "
+        "statements within triggers");
+}
+#line 3498 "parse.c"
+        break;
+      case 283: /* tridxby ::= INDEXED BY nm */
+#line 1279 "parse.y"
+{
+  sqlite3ErrorMsg(pParse,
+        "the INDEXED BY clause is not allowed on UPDATE or DELETE statements "
+        "within triggers");
+}
+#line 3507 "parse.c"
+        break;
+      case 284: /* tridxby ::= NOT INDEXED */
+#line 1284 "parse.y"
+{
+  sqlite3ErrorMsg(pParse,
+        "the NOT INDEXED clause is not allowed on UPDATE or DELETE statements "
+        "within triggers");
+}
+#line 3516 "parse.c"
+        break;
+      case 285: /* trigger_cmd ::= UPDATE orconf trnm tridxby SET setlist where_opt */
+#line 1297 "parse.y"
+{ yygotominor.yy427 = sqlite3TriggerUpdateStep(pParse->db, &yymsp[-4].minor.yy0, yymsp[-1].minor.yy298, yymsp[0].minor.yy326, yymsp[-5].minor.yy162); }
+#line 3521 "parse.c"
+        break;
+      case 286: /* trigger_cmd ::= insert_cmd INTO trnm inscollist_opt select */
+#line 1301 "parse.y"
+{yygotominor.yy427 = sqlite3TriggerInsertStep(pParse->db, &yymsp[-2].minor.yy0, yymsp[-1].minor.yy164, yymsp[0].minor.yy27, yymsp[-4].minor.yy162);}
+#line 3526 "parse.c"
+        break;
+      case 287: /* trigger_cmd ::= DELETE FROM trnm tridxby where_opt */
+#line 1305 "parse.y"
+{yygotominor.yy427 = sqlite3TriggerDeleteStep(pParse->db, &yymsp[-2].minor.yy0, yymsp[0].minor.yy326);}
+#line 3531 "parse.c"
+        break;
+      case 288: /* trigger_cmd ::= select */
+#line 1308 "parse.y"
+{yygotominor.yy427 = sqlite3TriggerSelectStep(pParse->db, yymsp[0].minor.yy27); }
+#line 3536 "parse.c"
+        break;
+      case 289: /* expr ::= RAISE LP IGNORE RP */
+#line 1311 "parse.y"
+{
+  yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_RAISE, 0, 0, 0); 
+  if( yygotominor.yy94.pExpr ){
+    yygotominor.yy94.pExpr->affinity = OE_Ignore;
+  }
+  yygotominor.yy94.zStart = yymsp[-3].minor.yy0.z;
+  yygotominor.yy94.zEnd = &yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n];
+}
+#line 3548 "parse.c"
+        break;
+      case 290: /* expr ::= RAISE LP raisetype COMMA nm RP */
+#line 1319 "parse.y"
+{
+  yygotominor.yy94.pExpr = sqlite3PExpr(pParse, TK_RAISE, 0, 0, &yymsp[-1].minor.yy0); 
+  if( yygotominor.yy94.pExpr ) {
+    yygotominor.yy94.pExpr->affinity = (char)yymsp[-3].minor.yy156;
+  }
+  yygotominor.yy94.zStart = yymsp[-5].minor.yy0.z;
+  yygotominor.yy94.zEnd = &yymsp[0].minor.yy0.z[yymsp[0].minor.yy0.n];
+}
+#line 3560 "parse.c"
+        break;
+      case 291: /* raisetype ::= ROLLBACK */
+#line 1330 "parse.y"
+{yygotominor.yy156 = OE_Rollback;}
+#line 3565 "parse.c"
+        break;
+      case 293: /* raisetype ::= FAIL */
+#line 1332 "parse.y"
+{yygotominor.yy156 = OE_Fail;}
+#line 3570 "parse.c"
+        break;
+      case 294: /* cmd ::= DROP TRIGGER ifexists fullname */
+#line 1337 "parse.y"
+{
+  sqlite3DropTrigger(pParse,yymsp[0].minor.yy115,yymsp[-1].minor.yy156);
+}
+#line 3577 "parse.c"
+        break;
+      case 295: /* cmd ::= ATTACH database_kw_opt expr AS expr key_opt */
+#line 1344 "parse.y"
+{
+  sqlite3Attach(pParse, yymsp[-3].minor.yy94.pExpr, yymsp[-1].minor.yy94.pExpr, yymsp[0].minor.yy326);
+}
+#line 3584 "parse.c"
+        break;
+      case 296: /* cmd ::= DETACH database_kw_opt expr */
+#line 1347 "parse.y"
+{
+  sqlite3Detach(pParse, yymsp[0].minor.yy94.pExpr);
+}
+#line 3591 "parse.c"
+        break;
+      case 301: /* cmd ::= REINDEX */
+#line 1362 "parse.y"
+{sqlite3Reindex(pParse, 0, 0);}
+#line 3596 "parse.c"
+        break;
+      case 302: /* cmd ::= REINDEX nm dbnm */
+#line 1363 "parse.y"
+{sqlite3Reindex(pParse, &yymsp[-1].minor.yy0, &yymsp[0].minor.yy0);}
+#line 3601 "parse.c"
+        break;
+      case 303: /* cmd ::= ANALYZE */
+#line 1368 "parse.y"
+{sqlite3Analyze(pParse, 0, 0);}
+#line 3606 "parse.c"
+        break;
+      case 304: /* cmd ::= ANALYZE nm dbnm */
+#line 1369 "parse.y"
+{sqlite3Analyze(pParse, &yymsp[-1].minor.yy0, &yymsp[0].minor.yy0);}
+#line 3611 "parse.c"
+        break;
+      case 305: /* cmd ::= ALTER TABLE fullname RENAME TO nm */
+#line 1374 "parse.y"
+{
+  sqlite3AlterRenameTable(pParse,yymsp[-3].minor.yy115,&yymsp[0].minor.yy0);
+}
+#line 3618 "parse.c"
+        break;
+      case 306: /* cmd ::= ALTER TABLE add_column_fullname ADD kwcolumn_opt column */
+#line 1377 "parse.y"
+{
+  sqlite3AlterFinishAddColumn(pParse, &yymsp[0].minor.yy0);
+}
+#line 3625 "parse.c"
+        break;
+      case 307: /* add_column_fullname ::= fullname */
+#line 1380 "parse.y"
+{
+  pParse->db->lookaside.bEnabled = 0;
+  sqlite3AlterBeginAddColumn(pParse, yymsp[0].minor.yy115);
+}
+#line 3633 "parse.c"
+        break;
+      case 310: /* cmd ::= create_vtab */
+#line 1390 "parse.y"
+{sqlite3VtabFinishParse(pParse,0);}
+#line 3638 "parse.c"
+        break;
+      case 311: /* cmd ::= create_vtab LP vtabarglist RP */
+#line 1391 "parse.y"
+{sqlite3VtabFinishParse(pParse,&yymsp[0].minor.yy0);}
+#line 3643 "parse.c"
+        break;
+      case 312: /* create_vtab ::= createkw VIRTUAL TABLE ifnotexists nm dbnm USING nm */
+#line 1393 "parse.y"
+{
+    sqlite3VtabBeginParse(pParse, &yymsp[-3].minor.yy0, &yymsp[-2].minor.yy0, &yymsp[0].minor.yy0, yymsp[-4].minor.yy156);
+}
+#line 3650 "parse.c"
+        break;
+      case 315: /* vtabarg ::= */
+#line 1398 "parse.y"
+{sqlite3VtabArgInit(pParse);}
+#line 3655 "parse.c"
+        break;
+      case 317: /* vtabargtoken ::= ANY */
+      case 318: /* vtabargtoken ::= lp anylist RP */ yytestcase(yyruleno==318);
+      case 319: /* lp ::= LP */ yytestcase(yyruleno==319);
+#line 1400 "parse.y"
+{sqlite3VtabArgExtend(pParse,&yymsp[0].minor.yy0);}
+#line 3662 "parse.c"
+        break;
+      case 323: /* with ::= */
+#line 1415 "parse.y"
+{yygotominor.yy363 = 0;}
+#line 3667 "parse.c"
+        break;
+      case 324: /* with ::= WITH wqlist */
+      case 325: /* with ::= WITH RECURSIVE wqlist */ yytestcase(yyruleno==325);
+#line 1417 "parse.y"
+{ yygotominor.yy363 = yymsp[0].minor.yy363; }
+#line 3673 "parse.c"
+        break;
+      case 326: /* wqlist ::= nm idxlist_opt AS LP select RP */
+#line 1420 "parse.y"
+{
+  yygotominor.yy363 = sqlite3WithAdd(pParse, 0, &yymsp[-5].minor.yy0, yymsp[-4].minor.yy298, yymsp[-1].minor.yy27);
+}
+#line 3680 "parse.c"
+        break;
+      case 327: /* wqlist ::= wqlist COMMA nm idxlist_opt AS LP select RP */
+#line 1423 "parse.y"
+{
+  yygotominor.yy363 = sqlite3WithAdd(pParse, yymsp[-7].minor.yy363, &yymsp[-5].minor.yy0, yymsp[-4].minor.yy298, yymsp[-1].minor.yy27);
+}
+#line 3687 "parse.c"
+        break;
+      default:
+      /* (0) input ::= cmdlist */ yytestcase(yyruleno==0);
+      /* (1) cmdlist ::= cmdlist ecmd */ yytestcase(yyruleno==1);
+      /* (2) cmdlist ::= ecmd */ yytestcase(yyruleno==2);
+      /* (3) ecmd ::= SEMI */ yytestcase(yyruleno==3);
+      /* (4) ecmd ::= explain cmdx SEMI */ yytestcase(yyruleno==4);
+      /* (10) trans_opt ::= */ yytestcase(yyruleno==10);
+      /* (11) trans_opt ::= TRANSACTION */ yytestcase(yyruleno==11);
+      /* (12) trans_opt ::= TRANSACTION nm */ yytestcase(yyruleno==12);
+      /* (21) savepoint_opt ::= SAVEPOINT */ yytestcase(yyruleno==21);
+      /* (22) savepoint_opt ::= */ yytestcase(yyruleno==22);
+      /* (26) cmd ::= create_table create_table_args */ yytestcase(yyruleno==26);
+      /* (37) columnlist ::= columnlist COMMA column */ yytestcase(yyruleno==37);
+      /* (38) columnlist ::= column */ yytestcase(yyruleno==38);
+      /* (44) type ::= */ yytestcase(yyruleno==44);
+      /* (51) signed ::= plus_num */ yytestcase(yyruleno==51);
+      /* (52) signed ::= minus_num */ yytestcase(yyruleno==52);
+      /* (53) carglist ::= carglist ccons */ yytestcase(yyruleno==53);
+      /* (54) carglist ::= */ yytestcase(yyruleno==54);
+      /* (61) ccons ::= NULL onconf */ yytestcase(yyruleno==61);
+      /* (89) conslist ::= conslist tconscomma tcons */ yytestcase(yyruleno==89);
+      /* (90) conslist ::= tcons */ yytestcase(yyruleno==90);
+      /* (92) tconscomma ::= */ yytestcase(yyruleno==92);
+      /* (274) foreach_clause ::= */ yytestcase(yyruleno==274);
+      /* (275) foreach_clause ::= FOR EACH ROW */ yytestcase(yyruleno==275);
+      /* (282) tridxby ::= */ yytestcase(yyruleno==282);
+      /* (299) database_kw_opt ::= DATABASE */ yytestcase(yyruleno==299);
+      /* (300) database_kw_opt ::= */ yytestcase(yyruleno==300);
+      /* (308) kwcolumn_opt ::= */ yytestcase(yyruleno==308);
+      /* (309) kwcolumn_opt ::= COLUMNKW */ yytestcase(yyruleno==309);
+      /* (313) vtabarglist ::= vtabarg */ yytestcase(yyruleno==313);
+      /* (314) vtabarglist ::= vtabarglist COMMA vtabarg */ yytestcase(yyruleno==314);
+      /* (316) vtabarg ::= vtabarg vtabargtoken */ yytestcase(yyruleno==316);
+      /* (320) anylist ::= */ yytestcase(yyruleno==320);
+      /* (321) anylist ::= anylist LP anylist RP */ yytestcase(yyruleno==321);
+      /* (322) anylist ::= anylist ANY */ yytestcase(yyruleno==322);
+        break;
+  };
+  assert( yyruleno>=0 && yyruleno<sizeof(yyRuleInfo)/sizeof(yyRuleInfo[0]) );
+  yygoto = yyRuleInfo[yyruleno].lhs;
+  yysize = yyRuleInfo[yyruleno].nrhs;
+  yypParser->yyidx -= yysize;
+  yyact = yy_find_reduce_action(yymsp[-yysize].stateno,(YYCODETYPE)yygoto);
+  if( yyact < YYNSTATE ){
+#ifdef NDEBUG
+    /* If we are not debugging and the reduce action popped at least
+    ** one element off the stack, then we can push the new element back
+    ** onto the stack here, and skip the stack overflow test in yy_shift().
+    ** That gives a significant speed improvement. */
+    if( yysize ){
+      yypParser->yyidx++;
+      yymsp -= yysize-1;
+      yymsp->stateno = (YYACTIONTYPE)yyact;
+      yymsp->major = (YYCODETYPE)yygoto;
+      yymsp->minor = yygotominor;
+    }else
+#endif
+    {
+      yy_shift(yypParser,yyact,yygoto,&yygotominor);
+    }
+  }else{
+    assert( yyact == YYNSTATE + YYNRULE + 1 );
+    yy_accept(yypParser);
+  }
+}
+
+/*
+** The following code executes when the parse fails
+*/
+#ifndef YYNOERRORRECOVERY
+static void yy_parse_failed(
+  yyParser *yypParser           /* The parser */
+){
+  sqlite3ParserARG_FETCH;
+#ifndef NDEBUG
+  if( yyTraceFILE ){
+    fprintf(yyTraceFILE,"%sFail!\n",yyTracePrompt);
+  }
+#endif
+  while( yypParser->yyidx>=0 ) yy_pop_parser_stack(yypParser);
+  /* Here code is inserted which will be executed whenever the
+  ** parser fails */
+  sqlite3ParserARG_STORE; /* Suppress warning about unused %extra_argument variable */
+}
+#endif /* YYNOERRORRECOVERY */
+
+/*
+** The following code executes when a syntax error first occurs.
+*/
+static void yy_syntax_error(
+  yyParser *yypParser,           /* The parser */
+  int yymajor,                   /* The major type of the error token */
+  YYMINORTYPE yyminor            /* The minor type of the error token */
+){
+  sqlite3ParserARG_FETCH;
+#define TOKEN (yyminor.yy0)
+#line 32 "parse.y"
+
+  UNUSED_PARAMETER(yymajor);  /* Silence some compiler warnings */
+  assert( TOKEN.z[0] );  /* The tokenizer always gives us a token */
+  sqlite3ErrorMsg(pParse, "near \"%T\": syntax error", &TOKEN);
+#line 3790 "parse.c"
+  sqlite3ParserARG_STORE; /* Suppress warning about unused %extra_argument variable */
+}
+
+/*
+** The following is executed when the parser accepts
+*/
+static void yy_accept(
+  yyParser *yypParser           /* The parser */
+){
+  sqlite3ParserARG_FETCH;
+#ifndef NDEBUG
+  if( yyTraceFILE ){
+    fprintf(yyTraceFILE,"%sAccept!\n",yyTracePrompt);
+  }
+#endif
+  while( yypParser->yyidx>=0 ) yy_pop_parser_stack(yypParser);
+  /* Here code is inserted which will be executed whenever the
+  ** parser accepts */
+  sqlite3ParserARG_STORE; /* Suppress warning about unused %extra_argument variable */
+}
+
+/* The main parser program.
+** The first argument is a pointer to a structure obtained from
+** "sqlite3ParserAlloc" which describes the current state of the parser.
+** The second argument is the major token number.  The third is
+** the minor token.  The fourth optional argument is whatever the
+** user wants (and specified in the grammar) and is available for
+** use by the action routines.
+**
+** Inputs:
+** <ul>
+** <li> A pointer to the parser (an opaque structure.)
+** <li> The major token number.
+** <li> The minor token number.
+** <li> An option argument of a grammar-specified type.
+** </ul>
+**
+** Outputs:
+** None.
+*/
+void sqlite3Parser(
+  void *yyp,                   /* The parser */
+  int yymajor,                 /* The major token code number */
+  sqlite3ParserTOKENTYPE yyminor       /* The value for the token */
+  sqlite3ParserARG_PDECL               /* Optional %extra_argument parameter */
+){
+  YYMINORTYPE yyminorunion;
+  int yyact;            /* The parser action. */
+#if !defined(YYERRORSYMBOL) && !defined(YYNOERRORRECOVERY)
+  int yyendofinput;     /* True if we are at the end of input */
+#endif
+#ifdef YYERRORSYMBOL
+  int yyerrorhit = 0;   /* True if yymajor has invoked an error */
+#endif
+  yyParser *yypParser;  /* The parser */
+
+  /* (re)initialize the parser, if necessary */
+  yypParser = (yyParser*)yyp;
+  if( yypParser->yyidx<0 ){
+#if YYSTACKDEPTH<=0
+    if( yypParser->yystksz <=0 ){
+      /*memset(&yyminorunion, 0, sizeof(yyminorunion));*/
+      yyminorunion = yyzerominor;
+      yyStackOverflow(yypParser, &yyminorunion);
+      return;
+    }
+#endif
+    yypParser->yyidx = 0;
+    yypParser->yyerrcnt = -1;
+    yypParser->yystack[0].stateno = 0;
+    yypParser->yystack[0].major = 0;
+  }
+  yyminorunion.yy0 = yyminor;
+#if !defined(YYERRORSYMBOL) && !defined(YYNOERRORRECOVERY)
+  yyendofinput = (yymajor==0);
+#endif
+  sqlite3ParserARG_STORE;
+
+#ifndef NDEBUG
+  if( yyTraceFILE ){
+    fprintf(yyTraceFILE,"%sInput %s\n",yyTracePrompt,yyTokenName[yymajor]);
+  }
+#endif
+
+  do{
+    yyact = yy_find_shift_action(yypParser,(YYCODETYPE)yymajor);
+    if( yyact<YYNSTATE ){
+      yy_shift(yypParser,yyact,yymajor,&yyminorunion);
+      yypParser->yyerrcnt--;
+      yymajor = YYNOCODE;
+    }else if( yyact < YYNSTATE + YYNRULE ){
+      yy_reduce(yypParser,yyact-YYNSTATE);
+    }else{
+      assert( yyact == YY_ERROR_ACTION );
+#ifdef YYERRORSYMBOL
+      int yymx;
+#endif
+#ifndef NDEBUG
+      if( yyTraceFILE ){
+        fprintf(yyTraceFILE,"%sSyntax Error!\n",yyTracePrompt);
+      }
+#endif
+#ifdef YYERRORSYMBOL
+      /* A syntax error has occurred.
+      ** The response to an error depends upon whether or not the
+      ** grammar defines an error token "ERROR".  
+      **
+      ** This is what we do if the grammar does define ERROR:
+      **
+      **  * Call the %syntax_error function.
+      **
+      **  * Begin popping the stack until we enter a state where
+      **    it is legal to shift the error symbol, then shift
+      **    the error symbol.
+      **
+      **  * Set the error count to three.
+      **
+      **  * Begin accepting and shifting new tokens.  No new error
+      **    processing will occur until three tokens have been
+      **    shifted successfully.
+      **
+      */
+      if( yypParser->yyerrcnt<0 ){
+        yy_syntax_error(yypParser,yymajor,yyminorunion);
+      }
+      yymx = yypParser->yystack[yypParser->yyidx].major;
+      if( yymx==YYERRORSYMBOL || yyerrorhit ){
+#ifndef NDEBUG
+        if( yyTraceFILE ){
+          fprintf(yyTraceFILE,"%sDiscard input token %s\n",
+             yyTracePrompt,yyTokenName[yymajor]);
+        }
+#endif
+        yy_destructor(yypParser, (YYCODETYPE)yymajor,&yyminorunion);
+        yymajor = YYNOCODE;
+      }else{
+         while(
+          yypParser->yyidx >= 0 &&
+          yymx != YYERRORSYMBOL &&
+          (yyact = yy_find_reduce_action(
+                        yypParser->yystack[yypParser->yyidx].stateno,
+                        YYERRORSYMBOL)) >= YYNSTATE
+        ){
+          yy_pop_parser_stack(yypParser);
+        }
+        if( yypParser->yyidx < 0 || yymajor==0 ){
+          yy_destructor(yypParser,(YYCODETYPE)yymajor,&yyminorunion);
+          yy_parse_failed(yypParser);
+          yymajor = YYNOCODE;
+        }else if( yymx!=YYERRORSYMBOL ){
+          YYMINORTYPE u2;
+          u2.YYERRSYMDT = 0;
+          yy_shift(yypParser,yyact,YYERRORSYMBOL,&u2);
+        }
+      }
+      yypParser->yyerrcnt = 3;
+      yyerrorhit = 1;
+#elif defined(YYNOERRORRECOVERY)
+      /* If the YYNOERRORRECOVERY macro is defined, then do not attempt to
+      ** do any kind of error recovery.  Instead, simply invoke the syntax
+      ** error routine and continue going as if nothing had happened.
+      **
+      ** Applications can set this macro (for example inside %include) if
+      ** they intend to abandon the parse upon the first syntax error seen.
+      */
+      yy_syntax_error(yypParser,yymajor,yyminorunion);
+      yy_destructor(yypParser,(YYCODETYPE)yymajor,&yyminorunion);
+      yymajor = YYNOCODE;
+      
+#else  /* YYERRORSYMBOL is not defined */
+      /* This is what we do if the grammar does not define ERROR:
+      **
+      **  * Report an error message, and throw away the input token.
+      **
+      **  * If the input token is $, then fail the parse.
+      **
+      ** As before, subsequent error messages are suppressed until
+      ** three input tokens have been successfully shifted.
+      */
+      if( yypParser->yyerrcnt<=0 ){
+        yy_syntax_error(yypParser,yymajor,yyminorunion);
+      }
+      yypParser->yyerrcnt = 3;
+      yy_destructor(yypParser,(YYCODETYPE)yymajor,&yyminorunion);
+      if( yyendofinput ){
+        yy_parse_failed(yypParser);
+      }
+      yymajor = YYNOCODE;
+#endif
+    }
+  }while( yymajor!=YYNOCODE && yypParser->yyidx>=0 );
+  return;
+}
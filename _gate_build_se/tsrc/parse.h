@@ -0,0 +1,160 @@
+#define TK_SEMI                             1
+#define TK_EXPLAIN                          2
+#define TK_QUERY                            3
+#define TK_PLAN                             4
+#define TK_BEGIN                            5
+#define TK_TRANSACTION                      6
+#define TK_DEFERRED                         7
+#define TK_IMMEDIATE                        8
+#define TK_EXCLUSIVE                        9
+#define TK_CONCURRENT                      10
+#define TK_COMMIT                          11
+#define TK_END                             12
+#define TK_ROLLBACK                        13
+#define TK_SAVEPOINT                       14
+#define TK_RELEASE                         15
+#define TK_TO                              16
+#define TK_TABLE                           17
+#define TK_CREATE                          18
+#define TK_IF                              19
+#define TK_NOT                             20
+#define TK_EXISTS                          21
+#define TK_TEMP                            22
+#define TK_LP                              23
+#define TK_RP                              24
+#define TK_AS                              25
+#define TK_WITHOUT                         26
+#define TK_COMMA                           27
+#define TK_ID                              28
+#define TK_INDEXED                         29
+#define TK_ABORT                           30
+#define TK_ACTION                          31
+#define TK_AFTER                           32
+#define TK_ANALYZE                         33
+#define TK_ASC                             34
+#define TK_ATTACH                          35
+#define TK_BEFORE                          36
+#define TK_BY                              37
+#define TK_CASCADE                         38
+#define TK_CAST                            39
+#define TK_COLUMNKW                        40
+#define TK_CONFLICT                        41
+#define TK_DATABASE                        42
+#define TK_DESC                            43
+#define TK_DETACH                          44
+#define TK_EACH                            45
+#define TK_FAIL                            46
+#define TK_FOR                             47
+#define TK_IGNORE                          48
+#define TK_INITIALLY                       49
+#define TK_INSTEAD                         50
+#define TK_LIKE_KW                         51
+#define TK_MATCH                           52
+#define TK_NO                              53
+#define TK_KEY                             54
+#define TK_OF                              55
+#define TK_OFFSET                          56
+#define TK_PRAGMA                          57
+#define TK_RAISE                           58
+#define TK_RECURSIVE                       59
+#define TK_REPLACE                         60
+#define TK_RESTRICT                        61
+#define TK_ROW                             62
+#define TK_TRIGGER                         63
+#define TK_VACUUM                          64
+#define TK_VIEW                            65
+#define TK_VIRTUAL                         66
+#define TK_WITH                            67
+#define TK_REINDEX                         68
+#define TK_RENAME                          69
+#define TK_CTIME_KW                        70
+#define TK_ANY                             71
+#define TK_OR                              72
+#define TK_AND                             73
+#define TK_IS                              74
+#define TK_BETWEEN                         75
+#define TK_IN                              76
+#define TK_ISNULL                          77
+#define TK_NOTNULL                         78
+#define TK_NE                              79
+#define TK_EQ                              80
+#define TK_GT                              81
+#define TK_LE                              82
+#define TK_LT                              83
+#define TK_GE                              84
+#define TK_ESCAPE                          85
+#define TK_BITAND                          86
+#define TK_BITOR                           87
+#define TK_LSHIFT                          88
+#define TK_RSHIFT                          89
+#define TK_PLUS                            90
+#define TK_MINUS                           91
+#define TK_STAR                            92
+#define TK_SLASH                           93
+#define TK_REM                             94
+#define TK_CONCAT                          95
+#define TK_COLLATE                         96
+#define TK_BITNOT                          97
+#define TK_STRING                          98
+#define TK_JOIN_KW                         99
+#define TK_CONSTRAINT                     100
+#define TK_DEFAULT                        101
+#define TK_NULL                           102
+#define TK_PRIMARY                        103
+#define TK_UNIQUE                         104
+#define TK_CHECK                          105
+#define TK_REFERENCES                     106
+#define TK_AUTOINCR                       107
+#define TK_ON                             108
+#define TK_INSERT                         109
+#define TK_DELETE                         110
+#define TK_UPDATE                         111
+#define TK_SET                            112
+#define TK_DEFERRABLE                     113
+#define TK_FOREIGN                        114
+#define TK_DROP                           115
+#define TK_UNION                          116
+#define TK_ALL                            117
+#define TK_EXCEPT                         118
+#define TK_INTERSECT                      119
+#define TK_SELECT                         120
+#define TK_VALUES                         121
+#define TK_DISTINCT                       122
+#define TK_DOT                            123
+#define TK_FROM                           124
+#define TK_JOIN                           125
+#define TK_USING                          126
+#define TK_ORDER                          127
+#define TK_GROUP                          128
+#define TK_HAVING                         129
+#define TK_LIMIT                          130
+#define TK_WHERE                          131
+#define TK_INTO                           132
+#define TK_INTEGER                        133
+#define TK_FLOAT                          134
+#define TK_BLOB                           135
+#define TK_VARIABLE                       136
+#define TK_CASE                           137
+#define TK_WHEN                           138
+#define TK_THEN                           139
+#define TK_ELSE                           140
+#define TK_INDEX                          141
+#define TK_ALTER                          142
+#define TK_ADD                            143
+#define TK_TO_TEXT                        144
+#define TK_TO_BLOB                        145
+#define TK_TO_NUMERIC                     146
+#define TK_TO_INT                         147
+#define TK_TO_REAL                        148
+#define TK_ISNOT                          149
+#define TK_END_OF_FILE                    150
+#define TK_ILLEGAL                        151
+#define TK_SPACE                          152
+#define TK_UNCLOSED_STRING                153
+#define TK_FUNCTION                       154
+#define TK_COLUMN                         155
+#define TK_AGG_FUNCTION                   156
+#define TK_AGG_COLUMN                     157
+#define TK_UMINUS                         158
+#define TK_UPLUS                          159
+#define TK_REGISTER                       160
@@ -0,0 +1,312 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include "sqlite3.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <selinux/selinux.h>
+
+#include "sesqlite_hash.h"
+
+extern security_context_t scon;
+extern security_context_t tcon;
+extern int scon_id;
+extern int tcon_id;
+
+extern SESQLITE_HASH *hash;
+extern SESQLITE_BIHASH *hash_id;
+
+/*
+ * The state of a SeSQLite connection, stored in db->pSelinux. The rest
+ * (the label dictionary, the labels of the objects of main, the contexts
+ * and the AVC) is shared by all the connections of the process, which
+ * must open the same main database, and is protected by the mutexes
+ * returned by sesqlite_mutex.
+ */
+struct sesqlite_conn {
+	sqlite3_stmt *stmt_insert;       /* insert into main.selinux_id */
+	sqlite3_stmt *stmt_update;       /* relabel the rows of main.selinux_id */
+	sqlite3_stmt *stmt_select_id;    /* label -> id in main.selinux_id */
+	sqlite3_stmt *stmt_select_label; /* id -> label in main.selinux_id */
+	sqlite3_stmt *stmt_con_insert;   /* insert or replace into main.selinux_context */
+	SESQLITE_HASH *attached;         /* attached db name -> struct sesqlite_attached */
+	void *pPending;                  /* labels added by the transaction, see sesqlite_shm.c */
+	void *pShm;                      /* the shared label log of main, see sesqlite_shm.c */
+	Hash guards;                     /* scan guards of the label counts, see sesqlite_count.c */
+	int vacuum;                      /* 1 while VACUUM copies the database */
+	int loading;                     /* 1 while the label counts are computed */
+	Hash stmts;                      /* SQL text -> statement kept by the cache, see sesqlite_stmt.c */
+	void *pLru;                      /* the kept statements, most recently used first */
+	int nStmt;                       /* statements kept by the cache */
+	int mxStmt;                      /* size of the cache, 0 disables it */
+};
+
+#define SESQLITE_CONN(db) ((struct sesqlite_conn*) (db)->pSelinux)
+
+/*
+ * The mutexes of the state shared by the connections. They are allocated
+ * by the first sqlite3SelinuxInit and are no-ops if SQLite is built with
+ * SQLITE_THREADSAFE=0. No SQL is ever run while one of them is held,
+ * except for SESQLITE_MUTEX_INIT, which serializes the initialization.
+ */
+#define SESQLITE_MUTEX_INIT    0 /* the connection count, the shared state setup */
+#define SESQLITE_MUTEX_LABELS  1 /* the label dictionary, the object labels, the contexts */
+#define SESQLITE_MUTEX_AVC     2 /* the userspace AVC */
+#define SESQLITE_NMUTEX        3
+
+sqlite3_mutex *sesqlite_mutex(int id);
+
+int set_vacuum(sqlite3 *db, int type);
+int is_vacuum(sqlite3 *db);
+
+#define SECURITY_CONTEXT_COLUMN_NAME "security_context"
+#define SECURITY_CONTEXT_COLUMN_TYPE "hidden INT"
+#define SECURITY_CONTEXT_COLUMN_DEFINITION SECURITY_CONTEXT_COLUMN_NAME " " SECURITY_CONTEXT_COLUMN_TYPE
+
+#define SELINUX_CONTEXT "selinux_context"
+#define SELINUX_ID "selinux_id"
+
+const char *authtype[] = { "SQLITE_COPY", "SQLITE_CREATE_INDEX",
+		"SQLITE_CREATE_TABLE", "SQLITE_CREATE_TEMP_INDEX",
+		"SQLITE_CREATE_TEMP_TABLE", "SQLITE_CREATE_TEMP_TRIGGER",
+		"SQLITE_CREATE_TEMP_VIEW", "SQLITE_CREATE_TRIGGER",
+		"SQLITE_CREATE_VIEW", "SQLITE_DELETE", "SQLITE_DROP_INDEX",
+		"SQLITE_DROP_TABLE", "SQLITE_DROP_TEMP_INDEX", "SQLITE_DROP_TEMP_TABLE",
+		"SQLITE_DROP_TEMP_TRIGGER", "SQLITE_DROP_TEMP_VIEW",
+		"SQLITE_DROP_TRIGGER", "SQLITE_DROP_VIEW", "SQLITE_INSERT",
+		"SQLITE_PRAGMA", "SQLITE_READ", "SQLITE_SELECT", "SQLITE_TRANSACTION",
+		"SQLITE_UPDATE", "SQLITE_ATTACH", "SQLITE_DETACH", "SQLITE_ALTER_TABLE",
+		"SQLITE_REINDEX", "SQLITE_ANALYZE", "SQLITE_CREATE_VTABLE",
+		"SQLITE_DROP_VTABLE", "SQLITE_FUNCTION", "SQLITE_SAVEPOINT",
+		"SQLITE_RECURSIVE" };
+
+/* SELinux classes */
+#define SELINUX_DB_DATABASE      	0
+#define SELINUX_DB_TABLE      		1
+#define SELINUX_DB_COLUMN     		2
+#define SELINUX_DB_TUPLE    		3
+
+/* SELinux permissions */
+/* common database */
+#define SELINUX_CREATE 			0
+#define SELINUX_DROP 			1
+#define SELINUX_GETATTR 		2
+#define SELINUX_SETATTR 		3
+#define SELINUX_RELABEL_FROM 	4
+#define SELINUX_RELABEL_TO 		5
+
+/* db_xxx */
+#define SELINUX_SELECT 			6
+#define SELINUX_UPDATE 			7
+#define SELINUX_INSERT 			8
+#define SELINUX_DELETE 			9
+
+/* other */
+#define SELINUX_ACCESS 		(SELINUX_SELECT)
+//#define SELINUX_LOAD_MODULE 		11 /* compile time check */
+
+#define SELINUX_NELEM_CLASS		3
+#define SELINUX_NELEM_PERM		10
+
+
+/*
+ * Returns the contexts read from the sesqlite_contexts file. The contexts
+ * replaced by restorecon are kept until the last connection is closed,
+ * so the strings of the returned contexts can be used without locking.
+ */
+struct sesqlite_context *sesqlite_get_contexts(void);
+
+int lookup_security_context(
+	SESQLITE_BIHASH *hash,
+	char *db_name,
+	char *tbl_name
+);
+
+int lookup_security_label(
+	sqlite3 *db,
+	sqlite3_stmt *stmt,
+	SESQLITE_BIHASH *hash,
+	int type,
+	char *db_name,
+	char *tbl_name,
+	char *col_name
+);
+
+/*
+ * Attached databases keep their own selinux_id dictionary. The ids stored
+ * in their rows are translated to and from the ids of the main database,
+ * which are the ones used by the in-memory hashmaps and the AVC.
+ * Both functions return the id unchanged for main and temp.
+ */
+int sesqlite_global_id(
+	sqlite3 *db,
+	const char *zDb,
+	int id
+);
+
+int sesqlite_local_id(
+	sqlite3 *db,
+	const char *zDb,
+	int id
+);
+
+/*
+ * Returns the name to store in the db column of selinux_context for
+ * objects of zDb: attached databases always describe themselves as main,
+ * so that they can be opened on their own as well.
+ */
+const char *sesqlite_stored_db(
+	sqlite3 *db,
+	const char *zDb
+);
+
+/* */
+int sqlite3SelinuxInit(
+	sqlite3 *db
+);
+
+/*
+ * Returns 1 if the connection has statements (other than the ones
+ * prepared by SeSQLite) or backups still running, 0 otherwise.
+ */
+int sqlite3SelinuxBusy(
+	sqlite3 *db
+);
+
+/*
+ * Finalizes the statements prepared by SeSQLite for the connection and
+ * releases its state. The shared state is released with the last
+ * connection. Invoked by sqlite3_close before the connection is closed.
+ */
+void sqlite3SelinuxClose(
+	sqlite3 *db
+);
+
+/*
+ * Returns a statement kept by the statement cache of the connection for
+ * the SQL text, if it is still valid, and sets *pzTail past the text.
+ * Returns NULL otherwise. Invoked by sqlite3_prepare_v2, see sesqlite_stmt.c.
+ */
+sqlite3_stmt *sqlite3SelinuxStmtLookup(
+	sqlite3 *db,
+	const char *zSql,
+	int nBytes,
+	const char **pzTail
+);
+
+/*
+ * Resets the statement and keeps it in the statement cache of the
+ * connection instead of deleting it. Returns 1 and the result of the
+ * reset in *pRc if it did, 0 if the statement has to be finalized.
+ * Invoked by sqlite3_finalize.
+ */
+int sqlite3SelinuxStmtPark(
+	sqlite3 *db,
+	sqlite3_stmt *pStmt,
+	int *pRc
+);
+
+/*
+ * Returns the generation of the policy that the statements compiled now
+ * are checked against, see sesqlite_policy_changed.
+ */
+unsigned int sqlite3SelinuxPolicy(void);
+/**
+ * Used to store
+ */
+struct sesqlite_context_element {
+	char *origin;
+	char *fparam;
+	char *sparam;
+	char *tparam;
+	char *security_context;
+	struct sesqlite_context_element *next;
+};
+
+struct sesqlite_context {
+
+	int ndb_context;
+	int ntable_context;
+	int nview_context;
+	int ncolumn_context;
+	int ntuple_context;
+
+	struct sesqlite_context_element *db_context;
+	struct sesqlite_context_element *table_context;
+	struct sesqlite_context_element *view_context;
+	struct sesqlite_context_element *column_context;
+	struct sesqlite_context_element *tuple_context;
+};
+
+
+/* struct for the management of selinux classes and the relative permissions*/
+static struct {
+	const char *c_name;
+	uint16_t c_code;
+	struct {
+		const char *p_name;
+		uint16_t p_code;
+	} perm[32];
+
+} access_vector[] = { 
+	{ "db_database", SELINUX_DB_DATABASE, { 
+		{ "create", SELINUX_CREATE }, 
+		{ "drop", SELINUX_DROP }, 
+		{ "getattr", SELINUX_GETATTR }, 
+		{ "setattr", SELINUX_SETATTR }, 
+		{ "relabelfrom", SELINUX_RELABEL_FROM }, 
+		{ "relabelto", SELINUX_RELABEL_TO }, 
+		{ "access", SELINUX_ACCESS }, } 
+	}, 
+	{ "db_table", SELINUX_DB_TABLE, { 
+		{ "create", SELINUX_CREATE }, 
+		{ "drop", SELINUX_DROP }, 
+		{ "getattr", SELINUX_GETATTR }, 
+		{ "setattr", SELINUX_SETATTR },
+		{ "relabelfrom", SELINUX_RELABEL_FROM }, 
+		{ "relabelto", SELINUX_RELABEL_TO }, 
+		{ "select", SELINUX_SELECT }, 
+		{ "update", SELINUX_UPDATE }, 
+		{ "insert", SELINUX_INSERT }, 
+		{ "delete", SELINUX_DELETE }, } 
+	}, 
+	{ "db_column", SELINUX_DB_COLUMN, { 
+		{ "create", SELINUX_CREATE }, 
+		{ "drop", SELINUX_DROP }, 
+		{ "getattr", SELINUX_GETATTR }, 
+		{ "setattr", SELINUX_SETATTR }, 
+		{ "relabelfrom", SELINUX_RELABEL_FROM }, 
+		{ "relabelto", SELINUX_RELABEL_TO }, 
+		{ "select", SELINUX_SELECT },
+		{ "update", SELINUX_UPDATE }, 
+		{ "insert", SELINUX_INSERT }, } 
+	},
+	{ "db_tuple", SELINUX_DB_TUPLE, { 
+		{ "relabelfrom", SELINUX_RELABEL_FROM }, 
+		{ "relabelto", SELINUX_RELABEL_TO },
+		{ "select", SELINUX_SELECT }, 
+		{ "update", SELINUX_UPDATE }, 
+		{ "insert", SELINUX_INSERT }, 
+		{ "delete", SELINUX_DELETE }, } 
+	}, 
+}; 
@@ -0,0 +1,809 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
+
+#ifndef SQLITE_CORE
+#include "sqlite3ext.h"
+SQLITE_EXTENSION_INIT1
+#else
+#include "sqlite3.h"
+#endif
+
+#include "sesqlite_init.h"
+#include "sesqlite_utils.h"
+#include "sesqlite_contexts.h"
+#include "sesqlite_count.h"
+#include "sesqlite_stmt.h"
+#include "sesqlite_shm.h"
+#include "sesqlite_attach.h"
+
+security_context_t scon = NULL;
+security_context_t tcon = NULL;
+int scon_id = 0;
+int tcon_id = 0;
+
+SESQLITE_HASH *hash = NULL;
+SESQLITE_BIHASH *hash_id = NULL;
+
+static struct sesqlite_context *contexts = NULL;
+
+/* the contexts replaced by restorecon, the other connections may still
+ * be using their strings */
+static struct sesqlite_context **aRetired = NULL;
+static int nRetired = 0;
+
+static int nConn = 0;          /* open SeSQLite connections */
+static char *zMainDb = NULL;   /* the main database of the connections */
+
+/* Milliseconds the initialization waits for the other connections that are
+ * writing the database: the busy handler of the user is not set yet */
+#ifndef SESQLITE_INIT_TIMEOUT
+# define SESQLITE_INIT_TIMEOUT 10000
+#endif
+
+struct sesqlite_context *sesqlite_get_contexts(void){
+	struct sesqlite_context *sc;
+
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	sc = contexts;
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	return sc;
+}
+
+/*
+ * In order to check if the database was already opened with SeSQLite we
+ * check if the table selinux_id is already in the database.
+ */
+int isReopen(
+	sqlite3 *db,
+	const char *zDb,
+	int *reopen
+){
+	sqlite3_stmt *check_stmt = NULL;
+	char *zSql = NULL;
+	int count = 0;
+	int rc = SQLITE_OK;
+
+	zSql = sqlite3_mprintf("SELECT count(*) FROM %Q.sqlite_master"
+		" WHERE type='table' AND tbl_name IN (%Q, %Q);",
+		zDb, SELINUX_CONTEXT, SELINUX_ID);
+	if( !zSql ) return SQLITE_NOMEM;
+
+	rc = sqlite3_prepare_v2(db, zSql, -1, &check_stmt, 0);
+	sqlite3_free(zSql);
+
+	if( SQLITE_OK!=rc ){
+		fprintf(stderr, "Error: SQL error in function isReopen\n");
+		return rc==SQLITE_BUSY ? rc : SQLITE_ERROR;
+	}
+
+	while( sqlite3_step(check_stmt)==SQLITE_ROW ){
+		count = sqlite3_column_int(check_stmt, 0);
+	}
+
+	sqlite3_reset(check_stmt);
+	sqlite3_finalize(check_stmt);
+
+	if( count == 0 ){ /* first open */
+		*reopen = 0;
+		rc = SQLITE_OK;
+	}else if( count == 2 ){ /* this is a reopen */
+		*reopen = 1;
+		rc = SQLITE_OK;
+	}else
+		rc = SQLITE_ERROR; /* something wrong happened. */
+
+	return rc;
+}
+
+int insert_context(sqlite3 *db, int isColumn, char *dbName, char *tblName,
+	char *colName, struct sesqlite_context_element * con, 
+	struct sesqlite_context_element *tuple_context) {
+
+    struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+    int rc = SQLITE_OK;
+    int tid = 0;
+    int rowid = 0;
+    char *sec_label = NULL;
+    char *sec_context = NULL;
+
+    rc = compute_sql_context(isColumn, dbName, tblName, colName, con, &sec_label); 
+    assert( sec_label != NULL);
+
+    rowid = sesqlite_label_id(sec_label);
+	if( rowid!=0 )
+		return rowid;
+
+	rc = compute_sql_context(0, dbName, tblName, NULL, tuple_context, &sec_context); 
+
+	tid = sesqlite_label_id(sec_context);
+	assert(tid != 0); /* check if SELinux can compute a security context */
+
+	sqlite3_bind_int(pConn->stmt_insert, 1, tid);
+	sqlite3_bind_text(pConn->stmt_insert, 2, sec_label, strlen(sec_label), SQLITE_TRANSIENT);
+
+	rc = sqlite3_step(pConn->stmt_insert);
+	rc = sqlite3_reset(pConn->stmt_insert);
+
+	rowid = sqlite3_last_insert_rowid(db);
+	sesqlite_label_add(rowid, sec_label);
+	sesqlite_shm_publish(db, rowid, sec_label);
+    return rowid;
+}
+
+/*
+ * Returns the context id associated to the column or the table (if
+ * colName is NULL) or -1 if there is no context associated.
+ */
+int get_key(
+	sqlite3 *db,
+	const char *dbName,
+	const char *tblName,
+	const char *colName
+){
+	char *key = make_key(dbName, tblName, colName);
+	int *id;
+	int res;
+
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	SESQLITE_HASH_FIND(sesqlite_objects(db, dbName), key, -1, (void**) &id, 0);
+	res = id ? *id : -1;
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+
+	sqlite3_free(key);
+	return res;
+}
+
+/*
+ * Insert the context id specified for the column or the table
+ * (if colName is NULL).
+ */
+void insert_key(
+	sqlite3 *db,
+	const char *dbName,
+	const char *tblName,
+	const char *colName,
+	int id
+){
+	char *key = make_key(dbName, tblName, colName);
+
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	SESQLITE_HASH_INSERT(sesqlite_objects(db, dbName), key, -1, &id, sizeof(int));
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	sqlite3_free(key);
+
+#ifdef SQLITE_DEBUG
+	char *after = sqlite3_mprintf("context: %d.", id);
+	sesqlite_print(NULL, dbName, tblName, colName, after);
+	sqlite3_free(after);
+#endif
+}
+
+int create_internal_table(
+	sqlite3 *db,
+	const char *zDb
+){
+	int rc = SQLITE_OK;
+	char *zSql = NULL;
+
+	zSql = sqlite3_mprintf(SELINUX_CONTEXT_TABLE, zDb);
+	if( !zSql ) return SQLITE_NOMEM;
+	rc = sqlite3_exec(db, zSql, 0, 0, 0);
+	sqlite3_free(zSql);
+	if( SQLITE_OK!=rc ) return rc;
+
+	zSql = sqlite3_mprintf(SELINUX_ID_TABLE, zDb);
+	if( !zSql ) return SQLITE_NOMEM;
+	rc = sqlite3_exec(db, zSql, 0, 0, 0);
+	sqlite3_free(zSql);
+	return rc;
+}
+
+/* Prepare the statements used in SeSQLite */
+int prepare_stmt(
+	sqlite3 *db
+){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+
+	int rc = sqlite3_prepare_v2(db, "INSERT INTO"
+		" selinux_id(security_context, security_label)"
+		" VALUES (?1, ?2);", -1, &pConn->stmt_insert, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	rc = sqlite3_prepare_v2(db, "UPDATE selinux_id"
+		" SET security_context = ?1;", -1, &pConn->stmt_update, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	rc = sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO"
+		" selinux_context(security_context, security_label, db, name, column)"
+		" VALUES (?1, ?2, ?3, ?4, ?5);", -1, &pConn->stmt_con_insert, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	rc = sqlite3_prepare_v2(db, "SELECT rowid"
+		" FROM selinux_id"
+		" WHERE security_label = ?1;", -1, &pConn->stmt_select_id, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	rc = sqlite3_prepare_v2(db,
+		"SELECT security_label"
+		" FROM selinux_id"
+		" WHERE rowid = ?1;", -1, &pConn->stmt_select_label, 0);
+	return rc;
+}
+
+int initialize_mapping(
+	sqlite3* db
+){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	int rc = SQLITE_OK;
+	char *result = NULL;
+	int id = 0;
+
+	struct sesqlite_context_element *pp;
+	pp = contexts->tuple_context;
+
+	while( pp!=NULL ){
+		if( sesqlite_label_id(pp->security_context)==0 ){
+			sqlite3_bind_int( pConn->stmt_insert, 1, 0);
+			sqlite3_bind_text(pConn->stmt_insert, 2, pp->security_context, -1, SQLITE_TRANSIENT);
+
+			rc = sqlite3_step(pConn->stmt_insert);
+			assert( rc==SQLITE_DONE );
+
+			id = sqlite3_last_insert_rowid(db);
+
+			rc = sqlite3_reset(pConn->stmt_insert);
+			assert( rc==SQLITE_OK);
+
+			sesqlite_label_add(id, pp->security_context);
+		}
+		pp = pp->next;
+	}
+
+	compute_sql_context(0, "main", SELINUX_ID, NULL, contexts->tuple_context, &result);
+	id = sesqlite_label_id(result);
+	assert(id != 0);
+	sqlite3_bind_int(pConn->stmt_update, 1, id);
+
+	rc = sqlite3_step(pConn->stmt_update);
+	sqlite3_finalize(pConn->stmt_update);
+	pConn->stmt_update = NULL;
+
+	if( rc!=SQLITE_DONE ){
+		fprintf(stderr, "SESQLITE ERROR: Unable to update selinux_id table\n");
+		return SQLITE_ERROR;
+    }
+
+	return SQLITE_OK;
+}
+
+
+/*
+ * This function loads the selinux_id and selinux_context tables into the
+ * respective hashmaps. This is used when the database is reopened and
+ * the contexts must not be loaded from the sesqlite_contexts file.
+ */
+int load_contexts_from_table(
+	sqlite3 *db
+){
+	sqlite3_stmt *select_stmt;
+	int rc = SQLITE_OK;
+
+	/* load the data from selinux_id table */
+	rc = sqlite3_prepare_v2(db,
+		"SELECT rowid, security_context, security_label FROM selinux_id;", -1,
+		&select_stmt, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	while( sqlite3_step(select_stmt)==SQLITE_ROW ){
+		sesqlite_label_add(sqlite3_column_int(select_stmt, 0),
+			(const char*) sqlite3_column_text(select_stmt, 2));
+	}
+
+	sqlite3_finalize(select_stmt);
+
+	/* load the data from selinux_context table */
+	rc = sqlite3_prepare_v2(db,
+		"SELECT security_label, db, name, column FROM selinux_context;", -1,
+		&select_stmt, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	while( sqlite3_step(select_stmt)==SQLITE_ROW ){
+		int id = sqlite3_column_int(select_stmt, 0);
+		const char *dbName  = sqlite3_column_text(select_stmt, 1);
+		const char *tblName = sqlite3_column_text(select_stmt, 2);
+		const char *colName = sqlite3_column_text(select_stmt, 3);
+
+		insert_key(db, 
+			dbName, 
+			( tblName==0 || strlen(tblName)==0) ? NULL : tblName,
+			( colName==0 || strlen(colName)==0) ? NULL : colName, 
+			id);
+	}
+
+	sqlite3_finalize(select_stmt);
+	return SQLITE_OK;
+}
+
+void selinux_restorecon_pragma(
+	void* pArg,
+	sqlite3 *db,
+	char *args
+){
+	char *zSave   = NULL;
+	char *dbName  = strtok_r(args, ". ", &zSave);
+	char *tblName = strtok_r(NULL, ". ", &zSave);
+	char *colName = strtok_r(NULL, ". ", &zSave);
+
+	CHECK_WRONG_USAGE( dbName==NULL || MORE_TOKENS(zSave),
+		"USAGE: pragma restorecon(\"db.[table.[column]]\")\n" );
+
+	sesqlite_print("Restoring labels for", dbName, tblName, colName, ".");
+
+	struct sesqlite_context *old = NULL;
+	struct sesqlite_context **aNew = NULL;
+	struct sesqlite_labeled *pLabeled = NULL;
+	int count = 0;
+	int rc, rc2;
+	struct sesqlite_context *sc = read_sesqlite_context(db, SESQLITE_CONTEXTS_PATH);
+	if( !sc ){
+		sesqlite_print("ERROR - Unable to restore the labels for",
+			dbName, tblName, colName, ".");
+		return;
+	}
+
+	/* the old contexts are released with the last connection */
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	aNew = sqlite3_realloc(aRetired, (nRetired + 1) * sizeof(*aRetired));
+	if( aNew ){
+		old = contexts;
+		contexts = sc;
+		aRetired = aNew;
+		aRetired[nRetired++] = old;
+	}
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
+	if( !aNew ){
+		free_sesqlite_context(sc);
+		sesqlite_print("ERROR - Unable to restore the labels for",
+			dbName, tblName, colName, ".");
+		return;
+	}
+
+	/* only the labels that change are written, all in one transaction, and
+	 * the hashmaps are changed once it is released */
+	rc = sqlite3_exec(db, "SAVEPOINT selinux_restorecon;", 0, 0, 0);
+	if( SQLITE_OK==rc ){
+		rc = reload_sesqlite_contexts(db, SESQLITE_CONN(db)->stmt_con_insert,
+			sc, old, dbName, tblName, colName, &count, &pLabeled);
+		if( SQLITE_OK!=rc )
+			sqlite3_exec(db, "ROLLBACK TO selinux_restorecon;", 0, 0, 0);
+		rc2 = sqlite3_exec(db, "RELEASE selinux_restorecon;", 0, 0, 0);
+		if( SQLITE_OK!=rc2 ){
+			/* the commit failed (e.g. the database is busy), undo the writes */
+			sqlite3_exec(db, "ROLLBACK TO selinux_restorecon;", 0, 0, 0);
+			sqlite3_exec(db, "RELEASE selinux_restorecon;", 0, 0, 0);
+			if( SQLITE_OK==rc ) rc = rc2;
+		}
+	}
+
+	/* the rules of sc are kept: the next restorecon compares them with the
+	 * labels in the hashmaps, so it writes again what was not written */
+	if( SQLITE_OK!=rc ){
+		free_labeled_objects(pLabeled);
+		sesqlite_print("ERROR - Unable to restore the labels for",
+			dbName, tblName, colName, ".");
+		return;
+	}
+
+	store_labeled_objects(db, pLabeled);
+	sesqlite_policy_changed();
+
+	fprintf(stdout, "%d contexts updated.\n", count);
+}
+
+void selinux_chcon_pragma(
+	void* pArg,
+	sqlite3 *db,
+	char *args
+){
+	char *zSave   = NULL;
+	char *label   = strtok_r(args, " ", &zSave);
+	char *dbName  = strtok_r(NULL, ". ", &zSave);
+	char *tblName = strtok_r(NULL, ". ", &zSave);
+	char *colName = strtok_r(NULL, ". ", &zSave);
+
+	CHECK_WRONG_USAGE( label==NULL || dbName==NULL || MORE_TOKENS(zSave),
+		"USAGE: pragma chcon(\"label db.[table.[column]]\")\n" );
+
+	sesqlite_print("Changing label for", dbName, tblName, colName, ".");
+	if( get_key(db, dbName, tblName, colName)==-1 ){
+		sesqlite_print("ERROR - No known context for", dbName, tblName, colName, ".");
+	}else{
+		insert_key(db, dbName, tblName, colName, insert_id(db, dbName, label));
+		sesqlite_policy_changed();
+		sesqlite_print("Label for", dbName, tblName, colName, "successfully changed.");
+	}
+}
+
+void selinux_getcon_pragma(
+	void* pArg,
+	sqlite3 *db,
+	char *args
+){
+	char *zSave   = NULL;
+	char *dbName  = strtok_r(args, ". ", &zSave);
+	char *tblName = strtok_r(NULL, ". ", &zSave);
+	char *colName = strtok_r(NULL, ". ", &zSave);
+
+	CHECK_WRONG_USAGE( dbName==NULL || MORE_TOKENS(zSave),
+		"USAGE: pragma getcon(\"db.[table.[column]]\")\n" );
+
+	int tclass = -1;
+	if( tblName==NULL )
+		tclass = SELINUX_DB_DATABASE;
+	else
+		tclass = colName==NULL ? SELINUX_DB_TABLE : SELINUX_DB_COLUMN;
+
+	int id = getContext(db, dbName, tblName, colName, tclass);
+	sqlite3_stmt *stmt = SESQLITE_CONN(db)->stmt_select_label;
+
+	sqlite3_bind_int(stmt, 1, id);
+	sqlite3_step(stmt);
+
+	sesqlite_print("Getting context for", dbName, tblName, colName, ":");
+	fprintf(stdout, "id: %d, label: %s\n", id,
+		sqlite3_column_text(stmt, 0), -1, SQLITE_TRANSIENT);
+
+	sqlite3_reset(stmt);
+}
+
+void selinux_getdefaultcon_pragma(
+	void* pArg,
+	sqlite3 *db,
+	char *args
+){
+	char *zSave   = NULL;
+	char *dbName  = strtok_r(args, ". ", &zSave);
+	char *tblName = strtok_r(NULL, ". ", &zSave);
+	char *colName = strtok_r(NULL, ". ", &zSave);
+
+	CHECK_WRONG_USAGE( dbName==NULL || MORE_TOKENS(zSave),
+		"USAGE: pragma getdefaultcon(\"db.[table.[column]]\")\n" );
+
+	struct sesqlite_context *sc = sesqlite_get_contexts();
+	char *defaultcon = NULL;
+	if( tblName ){
+		compute_sql_context(colName!=NULL, dbName, tblName, colName,
+			colName==NULL ? sc->table_context : sc->column_context,
+			&defaultcon);
+	}else{
+		compute_sql_context(colName!=NULL, dbName, tblName, colName,
+			sc->db_context,
+			&defaultcon);
+	}
+	
+	if( defaultcon==NULL ){
+		sesqlite_print("ERROR - Default context not found for", dbName, tblName, colName, ".");
+	}else{
+		int id = insert_id(db, "main", defaultcon);
+		sesqlite_print("Getting default context for", dbName, tblName, colName, ":");
+		fprintf(stdout, "id: %d, label: %s\n", id, defaultcon);
+	}
+}
+
+void selinux_clearavc_pragma(
+	void* pArg,
+	sqlite3 *db,
+	char *args
+){
+	sesqlite_clearavc();
+	fprintf(stdout, "AVC cleared\n");
+}
+
+int register_pragmas(sqlite3 *db){
+	int rc;
+
+	rc = sqlite3_create_pragma(db, "restorecon", selinux_restorecon_pragma, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	rc = sqlite3_create_pragma(db, "chcon", selinux_chcon_pragma, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+    rc = sqlite3_create_pragma(db, "getcon", selinux_getcon_pragma, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+    rc = sqlite3_create_pragma(db, "getdefaultcon", selinux_getdefaultcon_pragma, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	rc = sqlite3_create_pragma(db, "clearavc", selinux_clearavc_pragma, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	rc = sqlite3_create_pragma(db, "labelcount", selinux_labelcount_pragma, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	rc = sqlite3_create_pragma(db, "nolabelcount", selinux_nolabelcount_pragma, 0);
+	if( SQLITE_OK!=rc ) return rc;
+
+	rc = sqlite3_create_pragma(db, "stmtcache", selinux_stmtcache_pragma, 0);
+	return rc;
+}
+
+/*
+ * Loads the state shared by the connections, on the first open. The
+ * SESQLITE_MUTEX_INIT mutex is held.
+ */
+static int init_shared(
+	sqlite3 *db,
+	int reopen
+){
+	const char *zFile = sqlite3_db_filename(db, "main");
+	int rc = SQLITE_OK;
+
+	/* Allocate and initialize the hash-table used to store tokenizers. */
+	hash = sqlite3_malloc(sizeof(SESQLITE_HASH));
+	hash_id = sqlite3_malloc(sizeof(SESQLITE_BIHASH));
+	zMainDb = sqlite3_mprintf("%s", zFile ? zFile : "");
+
+	if( !hash || !hash_id || !zMainDb ){
+		return SQLITE_NOMEM;
+	}else{
+		SESQLITE_HASH_INIT(hash, SESQLITE_HASH_STRING, 1, 1); /* init */
+		SESQLITE_BIHASH_INIT(hash_id, SESQLITE_HASH_BINARY, SESQLITE_HASH_STRING, 1, 1); /* init mapping */
+	}
+
+	/* needed on reopen too, to label new subjects and objects */
+	contexts = read_sesqlite_context(db, SESQLITE_CONTEXTS_PATH);
+	if( !contexts ) return SQLITE_ERROR;
+
+	if( reopen ){
+		rc = load_contexts_from_table(db);
+		if( SQLITE_OK!=rc ) return rc;
+	}else{
+		rc = initialize_mapping(db);
+		if( SQLITE_OK!=rc ) return rc;
+
+		rc = load_sesqlite_contexts(db, SESQLITE_CONN(db)->stmt_con_insert,
+			contexts);
+		if( SQLITE_OK!=rc ) return rc;
+	}
+
+	return SQLITE_OK;
+}
+
+/*
+ * Releases the state shared by the connections, when the last one is
+ * closed. The SESQLITE_MUTEX_INIT mutex is held.
+ */
+static void free_shared(void){
+	int i;
+
+	sesqlite_clearavc();
+
+	if( hash ){
+		SESQLITE_HASH_CLEAR(hash);
+		sqlite3_free(hash);
+		hash = NULL;
+	}
+	if( hash_id ){
+		SESQLITE_BIHASH_FREE(hash_id);
+		sqlite3_free(hash_id);
+		hash_id = NULL;
+	}
+	sesqlite_label_free();
+	if( contexts ){
+		free_sesqlite_context(contexts);
+		contexts = NULL;
+	}
+	for( i = 0; i<nRetired; i++ )
+		free_sesqlite_context(aRetired[i]);
+	sqlite3_free(aRetired);
+	aRetired = NULL;
+	nRetired = 0;
+
+	sqlite3_free(scon);
+	scon = NULL;
+	scon_id = 0;
+	sesqlite_policy_close();
+	sqlite3_free(zMainDb);
+	zMainDb = NULL;
+}
+
+/*
+ * Function: sqlite3SelinuxInit
+ * Purpose: Initialize SeSqlite and register objects, authorizer and functions.
+ * 			This function is called by the SQLite core in case the SQLITE_CORE
+ * 			compile flag has been enabled or at runtime when the extension is loaded.
+ * Parameters:
+ * 				sqlite3 *db: a pointer to the SQLite database.
+ * Return value: 0->OK, other->ERROR (see **pzErr for info about error)
+ */
+int sqlite3SelinuxInit(sqlite3 *db) {
+
+	struct sesqlite_conn *pConn = NULL;
+	const char *zFile = NULL;
+	int rc = SQLITE_OK;
+	int reopen = 0;
+
+#ifdef SQLITE_DEBUG
+	fprintf(stdout, "\n == SeSqlite Initialization == \n");
+#endif
+
+	rc = sesqlite_mutex_init();
+	if( SQLITE_OK!=rc ) return rc;
+
+	pConn = sqlite3_malloc(sizeof(struct sesqlite_conn));
+	if( !pConn ) return SQLITE_NOMEM;
+	memset(pConn, 0, sizeof(struct sesqlite_conn));
+	sqlite3HashInit(&pConn->stmts);
+	pConn->mxStmt = SESQLITE_STMT_CACHE_SIZE;
+
+	/* the connections are initialized one at a time */
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_INIT));
+	db->pSelinux = pConn;
+	nConn++;
+	sqlite3_busy_timeout(db, SESQLITE_INIT_TIMEOUT);
+
+	/* the object labels and the subject of main are shared */
+	zFile = sqlite3_db_filename(db, "main");
+	if( nConn>1 && ( zFile==NULL || zFile[0]==0 || zMainDb==NULL
+	    || strcmp(zFile, zMainDb)!=0 ) ){
+		fprintf(stderr, "Error: the SeSQLite connections of a process"
+			" must open the same database file.\n");
+		rc = SQLITE_ERROR;
+		goto init_done;
+	}
+
+	rc = isReopen(db, "main", &reopen);
+	if( SQLITE_OK!=rc ) goto init_done;
+
+	rc = create_internal_table(db, "main");
+	if( SQLITE_OK!=rc ) goto init_done;
+
+	rc = prepare_stmt(db);
+	if( SQLITE_OK!=rc ) goto init_done;
+
+	if( nConn==1 ){
+		rc = init_shared(db, reopen);
+		if( SQLITE_OK!=rc ) goto init_done;
+	}
+
+	rc = sesqlite_shm_open(db);
+	if( SQLITE_OK!=rc ) goto init_done;
+
+	rc = register_pragmas(db);
+	if( SQLITE_OK!=rc ) goto init_done;
+
+	rc = initialize_authorizer(db);
+	if( SQLITE_OK!=rc ) goto init_done;
+
+	rc = initialize_count(db);
+	if( SQLITE_OK!=rc ) goto init_done;
+
+	rc = initialize_catalog(db);
+	if( SQLITE_OK!=rc ) goto init_done;
+
+#ifdef SELINUX_STATIC_CONTEXT
+	sqlite3_set_xattr(db, "security.selinux", "unconfined_u:unconfined_r:unconfined_t:s0");
+#else
+	security_context_t con = NULL;
+	rc = getcon(&con);
+	sqlite3_set_xattr(db, "security.selinux", con);
+//	deprecated
+//	if(security_compute_create_raw(scon, scon, 4, &tcon) < 0){
+//		fprintf(stderr, "SELinux could not compute a default context\n");
+//		return SQLITE_ERROR;
+//	}
+#endif
+
+	if( !sqlite3_get_xattr(db, "security.selinux") ){
+		fprintf(stderr, "Error: SeSQLite was unable to retrieve the security context.\n");
+		rc = SQLITE_ERROR;
+		goto init_done;
+	}
+
+	/* the subject is the process, the same for all the connections */
+	if( scon==NULL ){
+		scon = sqlite3_mprintf("%s", sqlite3_get_xattr(db, "security.selinux"));
+		if( !scon ){
+			rc = SQLITE_NOMEM;
+			goto init_done;
+		}
+		scon_id = insert_id(db, "main", scon);
+		assert( scon_id != 0);
+		/* the statements of the previous subject are stale */
+		sesqlite_policy_changed();
+		sesqlite_policy_open();
+	}
+
+init_done:
+	sqlite3_busy_timeout(db, 0);
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_INIT));
+	return rc;
+}
+
+int sqlite3SelinuxBusy(sqlite3 *db){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	sqlite3_stmt *pStmt = NULL;
+	int i;
+
+	for( i = 0; i<db->nDb; i++ ){
+		Btree *pBt = db->aDb[i].pBt;
+		if( pBt && sqlite3BtreeIsInBackup(pBt) ) return 1;
+	}
+
+	while( (pStmt = sqlite3_next_stmt(db, pStmt))!=NULL ){
+		if( pConn && ( pStmt==pConn->stmt_insert
+		    || pStmt==pConn->stmt_update
+		    || pStmt==pConn->stmt_select_id
+		    || pStmt==pConn->stmt_select_label
+		    || pStmt==pConn->stmt_con_insert
+		    || sesqlite_attached_stmt(db, pStmt) ) )
+			continue;
+		return 1;
+	}
+	return 0;
+}
+
+void sqlite3SelinuxClose(sqlite3 *db){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	sqlite3_stmt *aStmt[5];
+	int i;
+
+	if( pConn==NULL )
+		return;
+
+	sesqlite_stmt_close(db);
+	sesqlite_detach_all(db);
+	sesqlite_count_close(db);
+	sesqlite_shm_rollback(db);
+	sesqlite_shm_close(db);
+
+	/* as in free_attached, the statements bypass sqlite3_finalize */
+	aStmt[0] = pConn->stmt_insert;
+	aStmt[1] = pConn->stmt_update;
+	aStmt[2] = pConn->stmt_select_id;
+	aStmt[3] = pConn->stmt_select_label;
+	aStmt[4] = pConn->stmt_con_insert;
+	for( i = 0; i<5; i++ ){
+		if( aStmt[i] ) sqlite3VdbeFinalize((Vdbe*) aStmt[i]);
+	}
+
+	db->pSelinux = NULL;
+	sqlite3_free(pConn);
+
+	sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_INIT));
+	if( --nConn==0 )
+		free_shared();
+	sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_INIT));
+}
+
+
+/* Runtime-loading extension support */
+
+#if !SQLITE_CORE
+int sqlite3_extension_init(sqlite3 *db, char **pzErrMsg,
+		const sqlite3_api_routines *pApi) {
+	SQLITE_EXTENSION_INIT2(pApi);
+	return sqlite3SelinuxInit(db);
+}
+#endif
+
+#endif /* !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX) */
+
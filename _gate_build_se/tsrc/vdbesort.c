@@ -0,0 +1,1500 @@
+/*
+** 2011 July 9
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains code for the VdbeSorter object, used in concert with
+** a VdbeCursor to sort large numbers of keys (as may be required, for
+** example, by CREATE INDEX statements on tables too large to fit in main
+** memory).
+*/
+
+#include "sqliteInt.h"
+#include "vdbeInt.h"
+
+
+typedef struct VdbeSorterIter VdbeSorterIter;
+typedef struct SorterRecord SorterRecord;
+typedef struct FileWriter FileWriter;
+typedef struct MergeEngine MergeEngine;
+typedef struct SortSubtask SortSubtask;
+
+/*
+** A function used to compare two sorter records, see
+** vdbeSorterCompareRecord() for the details.
+*/
+typedef int (*SorterCompare)(
+  const SortSubtask*, int*, const void*, int, const void*, int
+);
+
+/*
+** NOTES ON DATA STRUCTURE USED FOR N-WAY MERGES:
+**
+** As keys are added to the sorter, they are written to disk in a series
+** of sorted packed-memory-arrays (PMAs). The size of each PMA is roughly
+** the same as the cache-size allowed for temporary databases. In order
+** to allow the caller to extract keys from the sorter in sorted order,
+** all PMAs currently stored on disk must be merged together. This comment
+** describes the data structure used to do so. The structure supports 
+** merging any number of arrays in a single pass with no redundant comparison 
+** operations.
+**
+** The aIter[] array contains an iterator for each of the PMAs being merged.
+** An aIter[] iterator either points to a valid key or else is at EOF. For 
+** the purposes of the paragraphs below, we assume that the array is actually 
+** N elements in size, where N is the smallest power of 2 greater to or equal 
+** to the number of iterators being merged. The extra aIter[] elements are 
+** treated as if they are empty (always at EOF).
+**
+** The aTree[] array is also N elements in size. The value of N is stored in
+** the MergeEngine.nTree variable.
+**
+** The final (N/2) elements of aTree[] contain the results of comparing
+** pairs of iterator keys together. Element i contains the result of 
+** comparing aIter[2*i-N] and aIter[2*i-N+1]. Whichever key is smaller, the
+** aTree element is set to the index of it. 
+**
+** For the purposes of this comparison, EOF is considered greater than any
+** other key value. If the keys are equal (only possible with two EOF
+** values), it doesn't matter which index is stored.
+**
+** The (N/4) elements of aTree[] that precede the final (N/2) described 
+** above contains the index of the smallest of each block of 4 iterators.
+** And so on. So that aTree[1] contains the index of the iterator that 
+** currently points to the smallest key value. aTree[0] is unused.
+**
+** Example:
+**
+**     aIter[0] -> Banana
+**     aIter[1] -> Feijoa
+**     aIter[2] -> Elderberry
+**     aIter[3] -> Currant
+**     aIter[4] -> Grapefruit
+**     aIter[5] -> Apple
+**     aIter[6] -> Durian
+**     aIter[7] -> EOF
+**
+**     aTree[] = { X, 5   0, 5    0, 3, 5, 6 }
+**
+** The current element is "Apple" (the value of the key indicated by 
+** iterator 5). When the Next() operation is invoked, iterator 5 will
+** be advanced to the next key in its segment. Say the next key is
+** "Eggplant":
+**
+**     aIter[5] -> Eggplant
+**
+** The contents of aTree[] are updated first by comparing the new iterator
+** 5 key to the current key of iterator 4 (still "Grapefruit"). The iterator
+** 5 value is still smaller, so aTree[6] is set to 5. And so on up the tree.
+** The value of iterator 6 - "Durian" - is now smaller than that of iterator
+** 5, so aTree[3] is set to 6. Key 0 is smaller than key 6 (Banana<Durian),
+** so the value written into element 1 of the array is 0. As follows:
+**
+**     aTree[] = { X, 0   0, 6    0, 3, 5, 6 }
+**
+** In other words, each time we advance to the next sorter element, log2(N)
+** key comparison operations are required, where N is the number of segments
+** being merged (rounded up to the next power of 2).
+*/
+struct MergeEngine {
+  int nTree;                      /* Used size of aTree/aIter (power of 2) */
+  int *aTree;                     /* Current state of incremental merge */
+  VdbeSorterIter *aIter;          /* Array of iterators to merge */
+};
+
+/*
+** NOTES ON WORKER THREADS:
+**
+** The work of the sorter is split between one or more sub-tasks, one for
+** each worker thread the statement may use (see "PRAGMA threads"), or a
+** single one if it may not use any. Each sub-task owns a temporary file
+** and the PMAs written to it.
+**
+** When the in-memory list is full, it is handed to the next sub-task in
+** turn, which sorts it and appends it to its file as a new PMA. If worker
+** threads are enabled this happens in a background thread while the VDBE
+** keeps adding records to a new in-memory list. The VDBE only waits if the
+** sub-task is still busy with its previous list.
+**
+** When the sorter is rewound, each sub-task merges its own PMAs, again in
+** a background thread, SORTER_MAX_MERGE_COUNT at a time into a second
+** temporary file, until SortSubtask.nTarget or less are left. Then the PMAs
+** of all the sub-tasks are merged incrementally by the VDBE in a single
+** pass, as described above.
+**
+** The sub-tasks running in a background thread can not use the database
+** connection: their memory is not allocated from lookaside and they
+** compare keys using a copy of the KeyInfo with KeyInfo.db set to NULL.
+*/
+struct SortSubtask {
+  SQLiteThread *pThread;          /* Thread running the current job, or NULL */
+  VdbeSorter *pSorter;            /* Sorter that owns this sub-task */
+  sqlite3 *db;                    /* Database for malloc(), NULL if threads */
+  KeyInfo *pKeyInfo;              /* How to compare keys */
+  UnpackedRecord *pUnpacked;      /* Used to unpack keys */
+  SorterCompare xCompare;         /* Compare function to use */
+  SorterRecord *pList;            /* List to sort and write as a PMA */
+  int nList;                      /* Size of pList as PMA, in bytes */
+  int nTarget;                    /* Merge until this many PMAs are left */
+  int nPMA;                       /* Number of PMAs stored in pTemp1 */
+  i64 iWriteOff;                  /* Current write offset within file pTemp1 */
+  sqlite3_file *pTemp1;           /* PMA file 1 */
+  sqlite3_file *pTemp2;           /* PMA file 2, used to merge the PMAs */
+};
+
+struct VdbeSorter {
+  int nInMemory;                  /* Current size of pRecord list as PMA */
+  int mnPmaSize;                  /* Minimum PMA size, in bytes */
+  int mxPmaSize;                  /* Maximum PMA size, in bytes.  0==no limit */
+  int pgsz;                       /* Page size of the main database */
+  u8 bUsePMA;                     /* True if one or more PMAs were written */
+  u8 bUseThreads;                 /* True to run the sub-tasks in threads */
+  u8 typeMask;                    /* SORTER_TYPE_* of the first fields */
+  SorterRecord *pRecord;          /* Head of in-memory record list */
+  MergeEngine *pMerger;           /* Final merge of the PMAs, or NULL */
+  KeyInfo *pKeyInfo;              /* Copy of the cursor KeyInfo for threads */
+  int iPrev;                      /* Sub-task that got the last list */
+  int nTask;                      /* Number of sub-tasks in aTask[] */
+  SortSubtask aTask[1];           /* One or more sub-tasks */
+};
+
+/*
+** The following type is an iterator for a PMA. It caches the current key in 
+** variables nKey/aKey. If the iterator is at EOF, pFile==0.
+*/
+struct VdbeSorterIter {
+  i64 iReadOff;                   /* Current read offset */
+  i64 iEof;                       /* 1 byte past EOF for this iterator */
+  int nAlloc;                     /* Bytes of space at aAlloc */
+  int nKey;                       /* Number of bytes in key */
+  sqlite3_file *pFile;            /* File iterator is reading from */
+  u8 *aAlloc;                     /* Allocated space */
+  u8 *aKey;                       /* Pointer to current key */
+  u8 *aBuffer;                    /* Current read buffer */
+  int nBuffer;                    /* Size of read buffer in bytes */
+};
+
+/*
+** An instance of this structure is used to organize the stream of records
+** being written to files by the merge-sort code into aligned, page-sized
+** blocks.  Doing all I/O in aligned page-sized blocks helps I/O to go
+** faster on many operating systems.
+*/
+struct FileWriter {
+  int eFWErr;                     /* Non-zero if in an error state */
+  u8 *aBuffer;                    /* Pointer to write buffer */
+  int nBuffer;                    /* Size of write buffer in bytes */
+  int iBufStart;                  /* First byte of buffer to write */
+  int iBufEnd;                    /* Last byte of buffer to write */
+  i64 iWriteOff;                  /* Offset of start of buffer in file */
+  sqlite3_file *pFile;            /* File to write to */
+};
+
+/*
+** A structure to store a single record. All in-memory records are connected
+** together into a linked list headed at VdbeSorter.pRecord using the 
+** SorterRecord.pNext pointer.
+*/
+struct SorterRecord {
+  void *pVal;
+  int nVal;
+  SorterRecord *pNext;
+};
+
+/* Minimum allowable value for the VdbeSorter.nWorking variable */
+#define SORTER_MIN_WORKING 10
+
+/* Maximum number of segments to merge in a single pass. */
+#define SORTER_MAX_MERGE_COUNT 16
+
+/*
+** Values for VdbeSorter.typeMask. While the first field of every record
+** added to the sorter is an integer (or a text value, compared with the
+** BINARY collation sequence), the records are compared with a specialized
+** function that looks at that field in place (see vdbeSorterGetCompare()).
+*/
+#define SORTER_TYPE_INTEGER 0x01
+#define SORTER_TYPE_TEXT    0x02
+
+/*
+** Resize an allocation made with sqlite3DbMallocRaw(db, ...). The database
+** handle may be NULL if this is called by a sub-task in a worker thread.
+** If the allocation fails, the old allocation is freed and NULL returned.
+*/
+static void *vdbeSorterRealloc(sqlite3 *db, void *pOld, int nNew){
+  void *pNew;
+  if( db ) return sqlite3DbReallocOrFree(db, pOld, nNew);
+  sqlite3MemdebugSetType(pOld, MEMTYPE_HEAP);
+  pNew = sqlite3_realloc(pOld, nNew);
+  if( pNew==0 ){
+    sqlite3_free(pOld);
+  }
+  sqlite3MemdebugSetType(pNew, MEMTYPE_DB|MEMTYPE_HEAP);
+  return pNew;
+}
+
+/*
+** Free all memory belonging to the VdbeSorterIter object passed as the second
+** argument. All structure fields are set to zero before returning.
+*/
+static void vdbeSorterIterZero(sqlite3 *db, VdbeSorterIter *pIter){
+  sqlite3DbFree(db, pIter->aAlloc);
+  sqlite3DbFree(db, pIter->aBuffer);
+  memset(pIter, 0, sizeof(VdbeSorterIter));
+}
+
+/*
+** Read nByte bytes of data from the stream of data iterated by object p.
+** If successful, set *ppOut to point to a buffer containing the data
+** and return SQLITE_OK. Otherwise, if an error occurs, return an SQLite
+** error code.
+**
+** The buffer indicated by *ppOut may only be considered valid until the
+** next call to this function.
+*/
+static int vdbeSorterIterRead(
+  sqlite3 *db,                    /* Database handle (for malloc), or NULL */
+  VdbeSorterIter *p,              /* Iterator */
+  int nByte,                      /* Bytes of data to read */
+  u8 **ppOut                      /* OUT: Pointer to buffer containing data */
+){
+  int iBuf;                       /* Offset within buffer to read from */
+  int nAvail;                     /* Bytes of data available in buffer */
+  assert( p->aBuffer );
+
+  /* If there is no more data to be read from the buffer, read the next 
+  ** p->nBuffer bytes of data from the file into it. Or, if there are less
+  ** than p->nBuffer bytes remaining in the PMA, read all remaining data.  */
+  iBuf = p->iReadOff % p->nBuffer;
+  if( iBuf==0 ){
+    int nRead;                    /* Bytes to read from disk */
+    int rc;                       /* sqlite3OsRead() return code */
+
+    /* Determine how many bytes of data to read. */
+    if( (p->iEof - p->iReadOff) > (i64)p->nBuffer ){
+      nRead = p->nBuffer;
+    }else{
+      nRead = (int)(p->iEof - p->iReadOff);
+    }
+    assert( nRead>0 );
+
+    /* Read data from the file. Return early if an error occurs. */
+    rc = sqlite3OsRead(p->pFile, p->aBuffer, nRead, p->iReadOff);
+    assert( rc!=SQLITE_IOERR_SHORT_READ );
+    if( rc!=SQLITE_OK ) return rc;
+  }
+  nAvail = p->nBuffer - iBuf; 
+
+  if( nByte<=nAvail ){
+    /* The requested data is available in the in-memory buffer. In this
+    ** case there is no need to make a copy of the data, just return a 
+    ** pointer into the buffer to the caller.  */
+    *ppOut = &p->aBuffer[iBuf];
+    p->iReadOff += nByte;
+  }else{
+    /* The requested data is not all available in the in-memory buffer.
+    ** In this case, allocate space at p->aAlloc[] to copy the requested
+    ** range into. Then return a copy of pointer p->aAlloc to the caller.  */
+    int nRem;                     /* Bytes remaining to copy */
+
+    /* Extend the p->aAlloc[] allocation if required. */
+    if( p->nAlloc<nByte ){
+      int nNew = p->nAlloc*2;
+      while( nByte>nNew ) nNew = nNew*2;
+      p->aAlloc = vdbeSorterRealloc(db, p->aAlloc, nNew);
+      if( !p->aAlloc ) return SQLITE_NOMEM;
+      p->nAlloc = nNew;
+    }
+
+    /* Copy as much data as is available in the buffer into the start of
+    ** p->aAlloc[].  */
+    memcpy(p->aAlloc, &p->aBuffer[iBuf], nAvail);
+    p->iReadOff += nAvail;
+    nRem = nByte - nAvail;
+
+    /* The following loop copies up to p->nBuffer bytes per iteration into
+    ** the p->aAlloc[] buffer.  */
+    while( nRem>0 ){
+      int rc;                     /* vdbeSorterIterRead() return code */
+      int nCopy;                  /* Number of bytes to copy */
+      u8 *aNext;                  /* Pointer to buffer to copy data from */
+
+      nCopy = nRem;
+      if( nRem>p->nBuffer ) nCopy = p->nBuffer;
+      rc = vdbeSorterIterRead(db, p, nCopy, &aNext);
+      if( rc!=SQLITE_OK ) return rc;
+      assert( aNext!=p->aAlloc );
+      memcpy(&p->aAlloc[nByte - nRem], aNext, nCopy);
+      nRem -= nCopy;
+    }
+
+    *ppOut = p->aAlloc;
+  }
+
+  return SQLITE_OK;
+}
+
+/*
+** Read a varint from the stream of data accessed by p. Set *pnOut to
+** the value read.
+*/
+static int vdbeSorterIterVarint(sqlite3 *db, VdbeSorterIter *p, u64 *pnOut){
+  int iBuf;
+
+  iBuf = p->iReadOff % p->nBuffer;
+  if( iBuf && (p->nBuffer-iBuf)>=9 ){
+    p->iReadOff += sqlite3GetVarint(&p->aBuffer[iBuf], pnOut);
+  }else{
+    u8 aVarint[16], *a;
+    int i = 0, rc;
+    do{
+      rc = vdbeSorterIterRead(db, p, 1, &a);
+      if( rc ) return rc;
+      aVarint[(i++)&0xf] = a[0];
+    }while( (a[0]&0x80)!=0 );
+    sqlite3GetVarint(aVarint, pnOut);
+  }
+
+  return SQLITE_OK;
+}
+
+
+/*
+** Advance iterator pIter to the next key in its PMA. Return SQLITE_OK if
+** no error occurs, or an SQLite error code if one does.
+*/
+static int vdbeSorterIterNext(
+  sqlite3 *db,                    /* Database handle (for sqlite3DbMalloc() ) */
+  VdbeSorterIter *pIter           /* Iterator to advance */
+){
+  int rc;                         /* Return Code */
+  u64 nRec = 0;                   /* Size of record in bytes */
+
+  if( pIter->iReadOff>=pIter->iEof ){
+    /* This is an EOF condition */
+    vdbeSorterIterZero(db, pIter);
+    return SQLITE_OK;
+  }
+
+  rc = vdbeSorterIterVarint(db, pIter, &nRec);
+  if( rc==SQLITE_OK ){
+    pIter->nKey = (int)nRec;
+    rc = vdbeSorterIterRead(db, pIter, (int)nRec, &pIter->aKey);
+  }
+
+  return rc;
+}
+
+/*
+** Initialize iterator pIter to scan through the PMA stored in file pFile
+** starting at offset iStart and ending at offset iEof-1. This function 
+** leaves the iterator pointing to the first key in the PMA (or EOF if the 
+** PMA is empty).
+*/
+static int vdbeSorterIterInit(
+  SortSubtask *pTask,             /* Sub-task doing the merge */
+  sqlite3_file *pFile,            /* File the PMA is stored in */
+  i64 iStart,                     /* Start offset in pFile */
+  i64 iFileEof,                   /* Bytes of data stored in pFile */
+  VdbeSorterIter *pIter,          /* Iterator to populate */
+  i64 *pnByte                     /* IN/OUT: Increment this value by PMA size */
+){
+  sqlite3 *db = pTask->db;
+  int rc = SQLITE_OK;
+  int nBuf;
+
+  nBuf = pTask->pSorter->pgsz;
+
+  assert( iFileEof>iStart );
+  assert( pIter->aAlloc==0 );
+  assert( pIter->aBuffer==0 );
+  pIter->pFile = pFile;
+  pIter->iReadOff = iStart;
+  pIter->nAlloc = 128;
+  pIter->aAlloc = (u8 *)sqlite3DbMallocRaw(db, pIter->nAlloc);
+  pIter->nBuffer = nBuf;
+  pIter->aBuffer = (u8 *)sqlite3DbMallocRaw(db, nBuf);
+
+  if( !pIter->aBuffer || !pIter->aAlloc ){
+    rc = SQLITE_NOMEM;
+  }else{
+    int iBuf;
+
+    iBuf = iStart % nBuf;
+    if( iBuf ){
+      int nRead = nBuf - iBuf;
+      if( (iStart + nRead) > iFileEof ){
+        nRead = (int)(iFileEof - iStart);
+      }
+      rc = sqlite3OsRead(pFile, &pIter->aBuffer[iBuf], nRead, iStart);
+      assert( rc!=SQLITE_IOERR_SHORT_READ );
+    }
+
+    if( rc==SQLITE_OK ){
+      u64 nByte;                       /* Size of PMA in bytes */
+      pIter->iEof = iFileEof;
+      rc = vdbeSorterIterVarint(db, pIter, &nByte);
+      pIter->iEof = pIter->iReadOff + nByte;
+      *pnByte += nByte;
+    }
+  }
+
+  if( rc==SQLITE_OK ){
+    rc = vdbeSorterIterNext(db, pIter);
+  }
+  return rc;
+}
+
+
+/*
+** Compare key1 (buffer pKey1, size nKey1 bytes) with key2 (buffer pKey2, 
+** size nKey2 bytes).  Argument pKeyInfo supplies the collation functions
+** used by the comparison. If an error occurs, return an SQLite error code.
+** Otherwise, return SQLITE_OK and set *pRes to a negative, zero or positive
+** value, depending on whether key1 is smaller, equal to or larger than key2.
+**
+** If the bOmitRowid argument is non-zero, assume both keys end in a rowid
+** field. For the purposes of the comparison, ignore it. Also, if bOmitRowid
+** is true and key1 contains even a single NULL value, it is considered to
+** be less than key2. Even if key2 also contains NULL values.
+*/
+static void vdbeSorterCompare(
+  const SortSubtask *pTask,       /* Sub-task (for pKeyInfo and pUnpacked) */
+  int nIgnore,                    /* Ignore the last nIgnore fields */
+  const void *pKey1, int nKey1,   /* Left side of comparison */
+  const void *pKey2, int nKey2,   /* Right side of comparison */
+  int *pRes                       /* OUT: Result of comparison */
+){
+  KeyInfo *pKeyInfo = pTask->pKeyInfo;
+  UnpackedRecord *r2 = pTask->pUnpacked;
+  int i;
+
+  sqlite3VdbeRecordUnpack(pKeyInfo, nKey2, pKey2, r2);
+
+  if( nIgnore ){
+    r2->nField = pKeyInfo->nField - nIgnore;
+    assert( r2->nField>0 );
+    for(i=0; i<r2->nField; i++){
+      if( r2->aMem[i].flags & MEM_Null ){
+        *pRes = -1;
+        return;
+      }
+    }
+    assert( r2->default_rc==0 );
+  }
+
+  *pRes = sqlite3VdbeRecordCompare(nKey1, pKey1, r2, 0);
+}
+
+/*
+** The following functions are the SorterCompare implementations used to
+** sort the records and merge the PMAs. Each of them compares key1 (buffer
+** pKey1, size nKey1 bytes) with key2 (buffer pKey2, size nKey2 bytes) and
+** returns a negative, zero or positive value, depending on whether key1 is
+** smaller, equal to or larger than key2.
+**
+** If *pbKey2Cached is true when called, pTask->pUnpacked already contains
+** the unpacked key2 and pKey2 is not unpacked again. Otherwise, it is set
+** to true if key2 is unpacked into pTask->pUnpacked. This saves unpacking
+** the same key over and over while merging two lists.
+**
+** vdbeSorterCompareRecord() compares the records field by field, using
+** the collation sequences of the KeyInfo. The others only work if the first
+** field of all the records has the same type (see VdbeSorter.typeMask and
+** vdbeSorterGetCompare()), compare that field directly within the record
+** and only unpack the records if the first fields are equal.
+*/
+static int vdbeSorterCompareRecord(
+  const SortSubtask *pTask,       /* Sub-task (for pKeyInfo and pUnpacked) */
+  int *pbKey2Cached,              /* True if pTask->pUnpacked is key2 */
+  const void *pKey1, int nKey1,   /* Left side of comparison */
+  const void *pKey2, int nKey2    /* Right side of comparison */
+){
+  UnpackedRecord *r2 = pTask->pUnpacked;
+  if( *pbKey2Cached==0 ){
+    sqlite3VdbeRecordUnpack(pTask->pKeyInfo, nKey2, pKey2, r2);
+    *pbKey2Cached = 1;
+  }
+  return sqlite3VdbeRecordCompare(nKey1, pKey1, r2, 0);
+}
+
+/*
+** Compare the second and subsequent fields of two records whose first
+** fields are known to be equal.
+*/
+static int vdbeSorterCompareTail(
+  const SortSubtask *pTask,       /* Sub-task (for pKeyInfo and pUnpacked) */
+  int *pbKey2Cached,              /* True if pTask->pUnpacked is key2 */
+  const void *pKey1, int nKey1,   /* Left side of comparison */
+  const void *pKey2, int nKey2    /* Right side of comparison */
+){
+  UnpackedRecord *r2 = pTask->pUnpacked;
+  if( pTask->pKeyInfo->nField<2 ) return 0;
+  if( *pbKey2Cached==0 ){
+    sqlite3VdbeRecordUnpack(pTask->pKeyInfo, nKey2, pKey2, r2);
+    *pbKey2Cached = 1;
+  }
+  return sqlite3VdbeRecordCompare(nKey1, pKey1, r2, 1);
+}
+
+/*
+** Return the value of an integer stored in a record as serial type
+** serial_type (1 to 6, 8 or 9) at a[].
+*/
+static i64 vdbeSorterIntValue(int serial_type, const u8 *a){
+  static const u8 aLen[] = { 0, 1, 2, 3, 4, 6, 8 };
+  i64 v;
+  int i;
+  if( serial_type>7 ) return serial_type-8;
+  v = (signed char)a[0];
+  for(i=1; i<aLen[serial_type]; i++){
+    v = v*256 + a[i];
+  }
+  return v;
+}
+
+/*
+** A SorterCompare for records whose first field is an integer.
+*/
+static int vdbeSorterCompareInt(
+  const SortSubtask *pTask,       /* Sub-task (for pKeyInfo and pUnpacked) */
+  int *pbKey2Cached,              /* True if pTask->pUnpacked is key2 */
+  const void *pKey1, int nKey1,   /* Left side of comparison */
+  const void *pKey2, int nKey2    /* Right side of comparison */
+){
+  const u8 *p1 = (const u8 *)pKey1;
+  const u8 *p2 = (const u8 *)pKey2;
+  i64 v1 = vdbeSorterIntValue(p1[1], &p1[p1[0]]);
+  i64 v2 = vdbeSorterIntValue(p2[1], &p2[p2[0]]);
+  int res;
+
+  if( v1==v2 ){
+    return vdbeSorterCompareTail(pTask, pbKey2Cached, pKey1, nKey1,
+                                 pKey2, nKey2);
+  }
+  res = v1<v2 ? -1 : +1;
+  return pTask->pKeyInfo->aSortOrder[0] ? -res : res;
+}
+
+/*
+** A SorterCompare for records whose first field is a text value compared
+** using the BINARY collation sequence.
+*/
+static int vdbeSorterCompareText(
+  const SortSubtask *pTask,       /* Sub-task (for pKeyInfo and pUnpacked) */
+  int *pbKey2Cached,              /* True if pTask->pUnpacked is key2 */
+  const void *pKey1, int nKey1,   /* Left side of comparison */
+  const void *pKey2, int nKey2    /* Right side of comparison */
+){
+  const u8 *p1 = (const u8 *)pKey1;
+  const u8 *p2 = (const u8 *)pKey2;
+  u32 n1, n2;
+  int res;
+
+  getVarint32(&p1[1], n1);
+  getVarint32(&p2[1], n2);
+  n1 = (n1-13)/2;
+  n2 = (n2-13)/2;
+  res = memcmp(&p1[p1[0]], &p2[p2[0]], MIN(n1, n2));
+  if( res==0 ) res = (int)n1 - (int)n2;
+
+  if( res==0 ){
+    return vdbeSorterCompareTail(pTask, pbKey2Cached, pKey1, nKey1,
+                                 pKey2, nKey2);
+  }
+  return pTask->pKeyInfo->aSortOrder[0] ? -res : res;
+}
+
+/*
+** Return the SorterCompare to use for the records added to the sorter so
+** far.
+*/
+static SorterCompare vdbeSorterGetCompare(const VdbeSorter *pSorter){
+  if( pSorter->typeMask==SORTER_TYPE_INTEGER ) return vdbeSorterCompareInt;
+  if( pSorter->typeMask==SORTER_TYPE_TEXT ) return vdbeSorterCompareText;
+  return vdbeSorterCompareRecord;
+}
+
+/*
+** This function is called to compare two iterator keys when merging 
+** multiple b-tree segments. Parameter iOut is the index of the aTree[] 
+** value to recalculate.
+*/
+static int vdbeSorterDoCompare(
+  const SortSubtask *pTask,       /* Sub-task doing the merge */
+  MergeEngine *pMerger,           /* Merge engine to update */
+  int iOut                        /* Index of aTree[] to recalculate */
+){
+  int i1;
+  int i2;
+  int iRes;
+  VdbeSorterIter *p1;
+  VdbeSorterIter *p2;
+
+  assert( iOut<pMerger->nTree && iOut>0 );
+
+  if( iOut>=(pMerger->nTree/2) ){
+    i1 = (iOut - pMerger->nTree/2) * 2;
+    i2 = i1 + 1;
+  }else{
+    i1 = pMerger->aTree[iOut*2];
+    i2 = pMerger->aTree[iOut*2+1];
+  }
+
+  p1 = &pMerger->aIter[i1];
+  p2 = &pMerger->aIter[i2];
+
+  if( p1->pFile==0 ){
+    iRes = i2;
+  }else if( p2->pFile==0 ){
+    iRes = i1;
+  }else{
+    int res;
+    int bCached = 0;
+    assert( pTask->pUnpacked!=0 );  /* allocated in sqlite3VdbeSorterInit() */
+    res = pTask->xCompare(
+        pTask, &bCached, p1->aKey, p1->nKey, p2->aKey, p2->nKey
+    );
+    if( res<=0 ){
+      iRes = i1;
+    }else{
+      iRes = i2;
+    }
+  }
+
+  pMerger->aTree[iOut] = iRes;
+  return SQLITE_OK;
+}
+
+/*
+** Allocate a new MergeEngine object with space for at least nIter
+** iterators, all at EOF.
+*/
+static MergeEngine *vdbeMergeEngineNew(sqlite3 *db, int nIter){
+  int N = 2;                      /* Power of 2 >= nIter */
+  int nByte;                      /* Bytes of space required for the object */
+  MergeEngine *pNew;              /* Object to return */
+
+  while( N<nIter ) N += N;
+  nByte = sizeof(MergeEngine) + N * (sizeof(int) + sizeof(VdbeSorterIter));
+  pNew = (MergeEngine *)sqlite3DbMallocZero(db, nByte);
+  if( pNew ){
+    pNew->nTree = N;
+    pNew->aIter = (VdbeSorterIter *)&pNew[1];
+    pNew->aTree = (int *)&pNew->aIter[N];
+  }
+  return pNew;
+}
+
+/*
+** Free the MergeEngine object passed as the second argument, and the
+** iterators it contains.
+*/
+static void vdbeMergeEngineFree(sqlite3 *db, MergeEngine *pMerger){
+  if( pMerger ){
+    int i;
+    for(i=0; i<pMerger->nTree; i++){
+      vdbeSorterIterZero(db, &pMerger->aIter[i]);
+    }
+    sqlite3DbFree(db, pMerger);
+  }
+}
+
+/*
+** Initialize the aTree[] array of the merge engine, once its iterators
+** point to the first key of their PMAs.
+*/
+static int vdbeMergeEngineInit(const SortSubtask *pTask, MergeEngine *pMerger){
+  int rc = SQLITE_OK;
+  int i;
+  for(i=pMerger->nTree-1; rc==SQLITE_OK && i>0; i--){
+    rc = vdbeSorterDoCompare(pTask, pMerger, i);
+  }
+  return rc;
+}
+
+/*
+** Advance the merge engine to its next key. Set *pbEof to true if there
+** are no more keys.
+*/
+static int vdbeMergeEngineStep(
+  const SortSubtask *pTask,       /* Sub-task doing the merge */
+  MergeEngine *pMerger,           /* Merge engine to advance */
+  int *pbEof                      /* OUT: True if the merge is finished */
+){
+  int rc;
+  int iPrev = pMerger->aTree[1];  /* Index of iterator to advance */
+  int i;                          /* Index of aTree[] to recalculate */
+
+  rc = vdbeSorterIterNext(pTask->db, &pMerger->aIter[iPrev]);
+  for(i=(pMerger->nTree+iPrev)/2; rc==SQLITE_OK && i>0; i=i/2){
+    rc = vdbeSorterDoCompare(pTask, pMerger, i);
+  }
+
+  *pbEof = (pMerger->aIter[pMerger->aTree[1]].pFile==0);
+  return rc;
+}
+
+/*
+** Initialize the temporary index cursor just opened as a sorter cursor.
+*/
+int sqlite3VdbeSorterInit(sqlite3 *db, VdbeCursor *pCsr){
+  int pgsz;                       /* Page size of main database */
+  int mxCache;                    /* Cache size */
+  VdbeSorter *pSorter;            /* The new sorter */
+  KeyInfo *pKeyInfo;              /* KeyInfo used by the sub-tasks */
+  sqlite3 *dbTask = db;           /* Database used by the sub-tasks */
+  int nWorker = 0;                /* Number of worker threads */
+  int nTask;                      /* Number of sub-tasks */
+  int i;
+  char *d;                        /* Dummy */
+
+  assert( pCsr->pKeyInfo && pCsr->pBt==0 );
+  pKeyInfo = pCsr->pKeyInfo;
+
+  /* Worker threads are only useful if the sorter may write PMAs */
+#if SQLITE_MAX_WORKER_THREADS>0
+  if( !sqlite3TempInMemory(db) ){
+    nWorker = db->aLimit[SQLITE_LIMIT_WORKER_THREADS];
+  }
+#endif
+  nTask = nWorker>0 ? nWorker : 1;
+
+  pCsr->pSorter = pSorter = sqlite3DbMallocZero(db,
+      sizeof(VdbeSorter) + (nTask-1)*sizeof(SortSubtask)
+  );
+  if( pSorter==0 ){
+    return SQLITE_NOMEM;
+  }
+  pSorter->nTask = nTask;
+  pSorter->iPrev = nTask-1;
+
+  if( nWorker>0 ){
+    /* The sub-tasks may not use the database connection, see above */
+    int nCol = pKeyInfo->nField + pKeyInfo->nXField;
+    int szKeyInfo = sizeof(KeyInfo) + nCol*(sizeof(CollSeq*)+1);
+    pKeyInfo = (KeyInfo *)sqlite3DbMallocRaw(0, szKeyInfo);
+    if( pKeyInfo==0 ){
+      db->mallocFailed = 1;
+      return SQLITE_NOMEM;
+    }
+    memcpy(pKeyInfo, pCsr->pKeyInfo, szKeyInfo);
+    pKeyInfo->aSortOrder = (u8*)&pKeyInfo->aColl[nCol];
+    pKeyInfo->db = 0;
+    pSorter->pKeyInfo = pKeyInfo;
+    pSorter->bUseThreads = 1;
+    dbTask = 0;
+  }
+
+  for(i=0; i<nTask; i++){
+    SortSubtask *pTask = &pSorter->aTask[i];
+    pTask->pSorter = pSorter;
+    pTask->db = dbTask;
+    pTask->pKeyInfo = pKeyInfo;
+    pTask->xCompare = vdbeSorterCompareRecord;
+    pTask->nTarget = SORTER_MAX_MERGE_COUNT / nTask;
+    if( pTask->nTarget<1 ) pTask->nTarget = 1;
+    pTask->pUnpacked = sqlite3VdbeAllocUnpackedRecord(pKeyInfo, 0, 0, &d);
+    if( pTask->pUnpacked==0 ){
+      db->mallocFailed = 1;
+      return SQLITE_NOMEM;
+    }
+    assert( pTask->pUnpacked==(UnpackedRecord *)d );
+  }
+
+  /* The first fields may only be compared in place if they use the BINARY
+  ** collation sequence, see sqlite3VdbeSorterWrite() */
+  if( pKeyInfo->aColl[0]==0 || pKeyInfo->aColl[0]==db->pDfltColl ){
+    pSorter->typeMask = SORTER_TYPE_INTEGER|SORTER_TYPE_TEXT;
+  }
+
+  pSorter->pgsz = pgsz = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
+  if( !sqlite3TempInMemory(db) ){
+    pSorter->mnPmaSize = SORTER_MIN_WORKING * pgsz;
+    mxCache = db->aDb[0].pSchema->cache_size;
+    if( mxCache<SORTER_MIN_WORKING ) mxCache = SORTER_MIN_WORKING;
+    pSorter->mxPmaSize = mxCache * pgsz;
+  }
+
+  return SQLITE_OK;
+}
+
+/*
+** Free the list of sorted records starting at pRecord.
+*/
+static void vdbeSorterRecordFree(sqlite3 *db, SorterRecord *pRecord){
+  SorterRecord *p;
+  SorterRecord *pNext;
+  for(p=pRecord; p; p=pNext){
+    pNext = p->pNext;
+    sqlite3DbFree(db, p);
+  }
+}
+
+/*
+** The main routine of a sub-task, run by a worker thread or by the VDBE
+** itself. If the sub-task was given a list of records, sort it and write
+** it to a PMA. Otherwise merge the PMAs of the sub-task. Return an SQLite
+** error code cast to a pointer.
+*/
+static void *vdbeSorterTaskMain(void *pCtx);
+
+#if SQLITE_MAX_WORKER_THREADS>0
+/*
+** Wait for the job of sub-task pTask to finish, if it is running in a
+** worker thread, and return its result.
+*/
+static int vdbeSorterJoinTask(SortSubtask *pTask){
+  int rc = SQLITE_OK;
+  if( pTask->pThread ){
+    void *pRet = SQLITE_INT_TO_PTR(SQLITE_ERROR);
+    (void)sqlite3ThreadJoin(pTask->pThread, &pRet);
+    rc = SQLITE_PTR_TO_INT(pRet);
+    pTask->pThread = 0;
+  }
+  return rc;
+}
+#else
+# define vdbeSorterJoinTask(pTask) SQLITE_OK
+#endif
+
+/*
+** Wait for all the sub-tasks of the sorter. Return the first error code
+** reported by one of them, or rcin if it is not SQLITE_OK.
+*/
+static int vdbeSorterJoinAll(VdbeSorter *pSorter, int rcin){
+  int rc = rcin;
+  int i;
+  for(i=0; i<pSorter->nTask; i++){
+    int rc2 = vdbeSorterJoinTask(&pSorter->aTask[i]);
+    if( rc==SQLITE_OK ) rc = rc2;
+  }
+  return rc;
+}
+
+/*
+** Start the job of sub-task pTask, in a worker thread if the sorter uses
+** them. Otherwise the job is done before returning.
+*/
+static int vdbeSorterStartTask(SortSubtask *pTask){
+#if SQLITE_MAX_WORKER_THREADS>0
+  if( pTask->pSorter->bUseThreads ){
+    assert( pTask->pThread==0 );
+    return sqlite3ThreadCreate(&pTask->pThread, vdbeSorterTaskMain, pTask);
+  }
+#endif
+  return SQLITE_PTR_TO_INT(vdbeSorterTaskMain(pTask));
+}
+
+/*
+** Free any cursor components allocated by sqlite3VdbeSorterXXX routines.
+*/
+void sqlite3VdbeSorterClose(sqlite3 *db, VdbeCursor *pCsr){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  if( pSorter ){
+    int i;
+    (void)vdbeSorterJoinAll(pSorter, SQLITE_OK);
+    vdbeMergeEngineFree(pSorter->aTask[0].db, pSorter->pMerger);
+    for(i=0; i<pSorter->nTask; i++){
+      SortSubtask *pTask = &pSorter->aTask[i];
+      vdbeSorterRecordFree(pTask->db, pTask->pList);
+      if( pTask->pTemp1 ){
+        sqlite3OsCloseFree(pTask->pTemp1);
+      }
+      if( pTask->pTemp2 ){
+        sqlite3OsCloseFree(pTask->pTemp2);
+      }
+      sqlite3DbFree(pTask->db, pTask->pUnpacked);
+    }
+    vdbeSorterRecordFree(pSorter->aTask[0].db, pSorter->pRecord);
+    sqlite3DbFree(0, pSorter->pKeyInfo);
+    sqlite3DbFree(db, pSorter);
+    pCsr->pSorter = 0;
+  }
+}
+
+/*
+** Allocate space for a file-handle and open a temporary file. If successful,
+** set *ppFile to point to the malloc'd file-handle and return SQLITE_OK.
+** Otherwise, set *ppFile to 0 and return an SQLite error code.
+*/
+static int vdbeSorterOpenTempFile(sqlite3 *db, sqlite3_file **ppFile){
+  int dummy;
+  return sqlite3OsOpenMalloc(db->pVfs, 0, ppFile,
+      SQLITE_OPEN_TEMP_JOURNAL |
+      SQLITE_OPEN_READWRITE    | SQLITE_OPEN_CREATE |
+      SQLITE_OPEN_EXCLUSIVE    | SQLITE_OPEN_DELETEONCLOSE, &dummy
+  );
+}
+
+/*
+** Merge the two sorted lists p1 and p2 into a single list.
+** Set *ppOut to the head of the new list.
+*/
+static void vdbeSorterMerge(
+  const SortSubtask *pTask,       /* For pKeyInfo */
+  SorterRecord *p1,               /* First list to merge */
+  SorterRecord *p2,               /* Second list to merge */
+  SorterRecord **ppOut            /* OUT: Head of merged list */
+){
+  SorterRecord *pFinal = 0;
+  SorterRecord **pp = &pFinal;
+  int bCached = 0;                /* True if p2 is in pTask->pUnpacked */
+
+  while( p1 && p2 ){
+    int res;
+    res = pTask->xCompare(
+        pTask, &bCached, p1->pVal, p1->nVal, p2->pVal, p2->nVal
+    );
+    if( res<=0 ){
+      *pp = p1;
+      pp = &p1->pNext;
+      p1 = p1->pNext;
+    }else{
+      *pp = p2;
+       pp = &p2->pNext;
+      p2 = p2->pNext;
+      bCached = 0;
+    }
+  }
+  *pp = p1 ? p1 : p2;
+  *ppOut = pFinal;
+}
+
+/*
+** Sort the linked list of records headed at *ppList. Return SQLITE_OK
+** if successful, or an SQLite error code (i.e. SQLITE_NOMEM) if an error
+** occurs.
+*/
+static int vdbeSorterSort(const SortSubtask *pTask, SorterRecord **ppList){
+  int i;
+  SorterRecord **aSlot;
+  SorterRecord *p;
+
+  aSlot = (SorterRecord **)sqlite3MallocZero(64 * sizeof(SorterRecord *));
+  if( !aSlot ){
+    return SQLITE_NOMEM;
+  }
+
+  p = *ppList;
+  while( p ){
+    SorterRecord *pNext = p->pNext;
+    p->pNext = 0;
+    for(i=0; aSlot[i]; i++){
+      vdbeSorterMerge(pTask, p, aSlot[i], &p);
+      aSlot[i] = 0;
+    }
+    aSlot[i] = p;
+    p = pNext;
+  }
+
+  p = 0;
+  for(i=0; i<64; i++){
+    vdbeSorterMerge(pTask, p, aSlot[i], &p);
+  }
+  *ppList = p;
+
+  sqlite3_free(aSlot);
+  return SQLITE_OK;
+}
+
+
+/*
+** Initialize a file-writer object.
+*/
+static void fileWriterInit(
+  sqlite3 *db,                    /* Database (for malloc), or NULL */
+  int nBuf,                       /* Size of the write buffer */
+  sqlite3_file *pFile,            /* File to write to */
+  FileWriter *p,                  /* Object to populate */
+  i64 iStart                      /* Offset of pFile to begin writing at */
+){
+  memset(p, 0, sizeof(FileWriter));
+  p->aBuffer = (u8 *)sqlite3DbMallocRaw(db, nBuf);
+  if( !p->aBuffer ){
+    p->eFWErr = SQLITE_NOMEM;
+  }else{
+    p->iBufEnd = p->iBufStart = (iStart % nBuf);
+    p->iWriteOff = iStart - p->iBufStart;
+    p->nBuffer = nBuf;
+    p->pFile = pFile;
+  }
+}
+
+/*
+** Write nData bytes of data to the file-write object. Return SQLITE_OK
+** if successful, or an SQLite error code if an error occurs.
+*/
+static void fileWriterWrite(FileWriter *p, u8 *pData, int nData){
+  int nRem = nData;
+  while( nRem>0 && p->eFWErr==0 ){
+    int nCopy = nRem;
+    if( nCopy>(p->nBuffer - p->iBufEnd) ){
+      nCopy = p->nBuffer - p->iBufEnd;
+    }
+
+    memcpy(&p->aBuffer[p->iBufEnd], &pData[nData-nRem], nCopy);
+    p->iBufEnd += nCopy;
+    if( p->iBufEnd==p->nBuffer ){
+      p->eFWErr = sqlite3OsWrite(p->pFile, 
+          &p->aBuffer[p->iBufStart], p->iBufEnd - p->iBufStart, 
+          p->iWriteOff + p->iBufStart
+      );
+      p->iBufStart = p->iBufEnd = 0;
+      p->iWriteOff += p->nBuffer;
+    }
+    assert( p->iBufEnd<p->nBuffer );
+
+    nRem -= nCopy;
+  }
+}
+
+/*
+** Flush any buffered data to disk and clean up the file-writer object.
+** The results of using the file-writer after this call are undefined.
+** Return SQLITE_OK if flushing the buffered data succeeds or is not 
+** required. Otherwise, return an SQLite error code.
+**
+** Before returning, set *piEof to the offset immediately following the
+** last byte written to the file.
+*/
+static int fileWriterFinish(sqlite3 *db, FileWriter *p, i64 *piEof){
+  int rc;
+  if( p->eFWErr==0 && ALWAYS(p->aBuffer) && p->iBufEnd>p->iBufStart ){
+    p->eFWErr = sqlite3OsWrite(p->pFile, 
+        &p->aBuffer[p->iBufStart], p->iBufEnd - p->iBufStart, 
+        p->iWriteOff + p->iBufStart
+    );
+  }
+  *piEof = (p->iWriteOff + p->iBufEnd);
+  sqlite3DbFree(db, p->aBuffer);
+  rc = p->eFWErr;
+  memset(p, 0, sizeof(FileWriter));
+  return rc;
+}
+
+/*
+** Write value iVal encoded as a varint to the file-write object. Return 
+** SQLITE_OK if successful, or an SQLite error code if an error occurs.
+*/
+static void fileWriterWriteVarint(FileWriter *p, u64 iVal){
+  int nByte; 
+  u8 aByte[10];
+  nByte = sqlite3PutVarint(aByte, iVal);
+  fileWriterWrite(p, aByte, nByte);
+}
+
+
+/*
+** Sort the list of records given to sub-task pTask and write it to a new
+** PMA at the end of file pTask->pTemp1. Return SQLITE_OK if successful, or
+** an SQLite error code otherwise.
+**
+** The format of a PMA is:
+**
+**     * A varint. This varint contains the total number of bytes of content
+**       in the PMA (not including the varint itself).
+**
+**     * One or more records packed end-to-end in order of ascending keys. 
+**       Each record consists of a varint followed by a blob of data (the 
+**       key). The varint is the number of bytes in the blob of data.
+*/
+static int vdbeSorterListToPMA(SortSubtask *pTask){
+  sqlite3 *db = pTask->db;
+  int rc;                         /* Return code */
+  FileWriter writer;
+#ifdef SQLITE_DEBUG
+  i64 nExpect = pTask->iWriteOff
+              + sqlite3VarintLen(pTask->nList)
+              + pTask->nList;
+#endif
+
+  memset(&writer, 0, sizeof(FileWriter));
+  assert( pTask->pList && pTask->pTemp1 );
+
+  rc = vdbeSorterSort(pTask, &pTask->pList);
+
+  if( rc==SQLITE_OK ){
+    SorterRecord *p;
+    SorterRecord *pNext = 0;
+
+    fileWriterInit(db, pTask->pSorter->pgsz, pTask->pTemp1, &writer,
+                   pTask->iWriteOff);
+    pTask->nPMA++;
+    fileWriterWriteVarint(&writer, pTask->nList);
+    for(p=pTask->pList; p; p=pNext){
+      pNext = p->pNext;
+      fileWriterWriteVarint(&writer, p->nVal);
+      fileWriterWrite(&writer, p->pVal, p->nVal);
+      sqlite3DbFree(db, p);
+    }
+    pTask->pList = 0;
+    rc = fileWriterFinish(db, &writer, &pTask->iWriteOff);
+  }
+
+  assert( rc!=SQLITE_OK || (nExpect==pTask->iWriteOff) );
+  return rc;
+}
+
+/*
+** Merge the PMAs stored in pTask->pTemp1, SORTER_MAX_MERGE_COUNT at a
+** time, into new PMAs written to pTask->pTemp2. The two files are then
+** swapped, and the process repeated until pTask->nTarget or less PMAs
+** are left.
+*/
+static int vdbeSorterMergePMAs(SortSubtask *pTask){
+  sqlite3 *db = pTask->db;
+  int rc = SQLITE_OK;             /* Return code */
+
+  assert( pTask->pTemp2 );
+  while( rc==SQLITE_OK && pTask->nPMA>pTask->nTarget ){
+    i64 iReadOff = 0;             /* Read offset within pTemp1 */
+    i64 iWrite2 = 0;              /* Write offset for pTemp2 */
+    int nNew = 0;                 /* Number of PMAs written to pTemp2 */
+    sqlite3_file *pTmp;
+
+    while( rc==SQLITE_OK && iReadOff<pTask->iWriteOff ){
+      MergeEngine *pMerger;       /* Merges the next group of PMAs */
+      i64 nWrite = 0;             /* Number of bytes in new PMA */
+      int i;
+
+      pMerger = vdbeMergeEngineNew(db, SORTER_MAX_MERGE_COUNT);
+      if( pMerger==0 ){
+        rc = SQLITE_NOMEM;
+        break;
+      }
+      for(i=0; i<SORTER_MAX_MERGE_COUNT; i++){
+        VdbeSorterIter *pIter = &pMerger->aIter[i];
+        rc = vdbeSorterIterInit(pTask, pTask->pTemp1, iReadOff,
+                                pTask->iWriteOff, pIter, &nWrite);
+        iReadOff = pIter->iEof;
+        assert( rc!=SQLITE_OK || iReadOff<=pTask->iWriteOff );
+        if( rc!=SQLITE_OK || iReadOff>=pTask->iWriteOff ) break;
+      }
+      if( rc==SQLITE_OK ){
+        rc = vdbeMergeEngineInit(pTask, pMerger);
+      }
+
+      if( rc==SQLITE_OK ){
+        int rc2;                  /* Return code from fileWriterFinish() */
+        int bEof = 0;
+        FileWriter writer;        /* Object used to write to disk */
+
+        fileWriterInit(db, pTask->pSorter->pgsz, pTask->pTemp2, &writer,
+                       iWrite2);
+        fileWriterWriteVarint(&writer, nWrite);
+        while( rc==SQLITE_OK && bEof==0 ){
+          VdbeSorterIter *pIter = &pMerger->aIter[ pMerger->aTree[1] ];
+          assert( pIter->pFile );
+
+          fileWriterWriteVarint(&writer, pIter->nKey);
+          fileWriterWrite(&writer, pIter->aKey, pIter->nKey);
+          rc = vdbeMergeEngineStep(pTask, pMerger, &bEof);
+        }
+        rc2 = fileWriterFinish(db, &writer, &iWrite2);
+        if( rc==SQLITE_OK ) rc = rc2;
+      }
+      vdbeMergeEngineFree(db, pMerger);
+      nNew++;
+    }
+
+    pTmp = pTask->pTemp1;
+    pTask->pTemp1 = pTask->pTemp2;
+    pTask->pTemp2 = pTmp;
+    pTask->iWriteOff = iWrite2;
+    pTask->nPMA = nNew;
+  }
+
+  return rc;
+}
+
+static void *vdbeSorterTaskMain(void *pCtx){
+  SortSubtask *pTask = (SortSubtask *)pCtx;
+  int rc;
+  if( pTask->pList ){
+    rc = vdbeSorterListToPMA(pTask);
+  }else{
+    rc = vdbeSorterMergePMAs(pTask);
+  }
+  return SQLITE_INT_TO_PTR(rc);
+}
+
+/*
+** Hand the in-memory list of records over to the next sub-task, which
+** sorts it and writes it to a new PMA. Return SQLITE_OK if successful, or
+** an SQLite error code otherwise. If the sorter uses worker threads, the
+** error may also be reported when the sub-task is joined.
+*/
+static int vdbeSorterFlushPMA(sqlite3 *db, const VdbeCursor *pCsr){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  SortSubtask *pTask;
+  int rc;
+
+  if( pSorter->nInMemory==0 ){
+    assert( pSorter->pRecord==0 );
+    return SQLITE_OK;
+  }
+
+  /* Wait for the sub-task to finish with its previous list */
+  pSorter->iPrev = (pSorter->iPrev + 1) % pSorter->nTask;
+  pTask = &pSorter->aTask[pSorter->iPrev];
+  rc = vdbeSorterJoinTask(pTask);
+
+  /* If the temporary PMA file of the sub-task has not been opened, open
+  ** it now. */
+  if( rc==SQLITE_OK && pTask->pTemp1==0 ){
+    rc = vdbeSorterOpenTempFile(db, &pTask->pTemp1);
+    assert( rc!=SQLITE_OK || pTask->pTemp1 );
+    assert( pTask->iWriteOff==0 );
+    assert( pTask->nPMA==0 );
+  }
+
+  if( rc==SQLITE_OK ){
+    assert( pTask->pList==0 );
+    pTask->pList = pSorter->pRecord;
+    pTask->nList = pSorter->nInMemory;
+    pSorter->pRecord = 0;
+    pSorter->nInMemory = 0;
+    pSorter->bUsePMA = 1;
+    pTask->xCompare = vdbeSorterGetCompare(pSorter);
+    rc = vdbeSorterStartTask(pTask);
+  }
+
+  return rc;
+}
+
+/*
+** Add a record to the sorter.
+*/
+int sqlite3VdbeSorterWrite(
+  sqlite3 *db,                    /* Database handle */
+  const VdbeCursor *pCsr,               /* Sorter cursor */
+  Mem *pVal                       /* Memory cell containing record */
+){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  int rc = SQLITE_OK;             /* Return Code */
+  SorterRecord *pNew;             /* New list element */
+
+  assert( pSorter );
+  pSorter->nInMemory += sqlite3VarintLen(pVal->n) + pVal->n;
+
+  /* Keep track of the type of the first field of the records. The
+  ** specialized comparisons are only used if the record header size is a
+  ** single byte varint (as it nearly always is), so that the first serial
+  ** type starts at offset 1 and the first value at offset z[0]. */
+  if( pSorter->typeMask ){
+    u32 t = 0;
+    if( (pVal->z[0] & 0x80)==0 ){
+      getVarint32((const u8*)&pVal->z[1], t);
+    }
+    if( t>0 && t<10 && t!=7 ){
+      pSorter->typeMask &= SORTER_TYPE_INTEGER;
+    }else if( t>=13 && (t & 0x01) ){
+      pSorter->typeMask &= SORTER_TYPE_TEXT;
+    }else{
+      pSorter->typeMask = 0;
+    }
+  }
+
+  /* The record may be freed by a worker thread, see SortSubtask.db */
+  pNew = (SorterRecord *)sqlite3DbMallocRaw(pSorter->aTask[0].db,
+      pVal->n + sizeof(SorterRecord)
+  );
+  if( pNew==0 ){
+    db->mallocFailed = 1;
+    rc = SQLITE_NOMEM;
+  }else{
+    pNew->pVal = (void *)&pNew[1];
+    memcpy(pNew->pVal, pVal->z, pVal->n);
+    pNew->nVal = pVal->n;
+    pNew->pNext = pSorter->pRecord;
+    pSorter->pRecord = pNew;
+  }
+
+  /* See if the contents of the sorter should now be written out. They
+  ** are written out when either of the following are true:
+  **
+  **   * The total memory allocated for the in-memory list is greater 
+  **     than (page-size * cache-size), or
+  **
+  **   * The total memory allocated for the in-memory list is greater 
+  **     than (page-size * 10) and sqlite3HeapNearlyFull() returns true.
+  */
+  if( rc==SQLITE_OK && pSorter->mxPmaSize>0 && (
+        (pSorter->nInMemory>pSorter->mxPmaSize)
+     || (pSorter->nInMemory>pSorter->mnPmaSize && sqlite3HeapNearlyFull())
+  )){
+    rc = vdbeSorterFlushPMA(db, pCsr);
+  }
+
+  return rc;
+}
+
+/*
+** Once the sorter has been populated, this function is called to prepare
+** for iterating through its contents in sorted order.
+*/
+int sqlite3VdbeSorterRewind(sqlite3 *db, const VdbeCursor *pCsr, int *pbEof){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  SortSubtask *pMain;             /* Sub-task used by the VDBE itself */
+  MergeEngine *pMerger;           /* Final merge of all the PMAs */
+  int rc;                         /* Return code */
+  int nIter = 0;                  /* Number of iterators used */
+  int iIter = 0;                  /* Next iterator to initialize */
+  int i;
+
+  assert( pSorter );
+  pMain = &pSorter->aTask[0];
+
+  /* If no data has been written to disk, then do not do so now. Instead,
+  ** sort the VdbeSorter.pRecord list. The vdbe layer will read data directly
+  ** from the in-memory list.  */
+  if( pSorter->bUsePMA==0 ){
+    *pbEof = !pSorter->pRecord;
+    assert( pSorter->pMerger==0 );
+    pMain->xCompare = vdbeSorterGetCompare(pSorter);
+    return vdbeSorterSort(pMain, &pSorter->pRecord);
+  }
+
+  /* Write the current in-memory list to a PMA. */
+  rc = vdbeSorterFlushPMA(db, pCsr);
+
+  /* Have each sub-task reduce the number of its PMAs, so that the PMAs of
+  ** all the sub-tasks can be merged in a single pass. */
+  for(i=0; i<pSorter->nTask; i++){
+    SortSubtask *pTask = &pSorter->aTask[i];
+    int rc2 = vdbeSorterJoinTask(pTask);
+    if( rc==SQLITE_OK ) rc = rc2;
+    pTask->xCompare = vdbeSorterGetCompare(pSorter);
+    if( rc==SQLITE_OK && pTask->nPMA>pTask->nTarget ){
+      if( pTask->pTemp2==0 ){
+        rc = vdbeSorterOpenTempFile(db, &pTask->pTemp2);
+      }
+      if( rc==SQLITE_OK ){
+        assert( pTask->pList==0 );
+        rc = vdbeSorterStartTask(pTask);
+      }
+    }
+  }
+  rc = vdbeSorterJoinAll(pSorter, rc);
+  if( rc!=SQLITE_OK ) return rc;
+
+  /* Initialize an iterator for each PMA left, and the merge tree */
+  for(i=0; i<pSorter->nTask; i++){
+    nIter += pSorter->aTask[i].nPMA;
+  }
+  assert( nIter>0 );
+  pSorter->pMerger = pMerger = vdbeMergeEngineNew(pMain->db, nIter);
+  if( pMerger==0 ){
+    db->mallocFailed = 1;
+    return SQLITE_NOMEM;
+  }
+  for(i=0; rc==SQLITE_OK && i<pSorter->nTask; i++){
+    SortSubtask *pTask = &pSorter->aTask[i];
+    i64 iReadOff = 0;
+    i64 nByte = 0;
+    while( rc==SQLITE_OK && iReadOff<pTask->iWriteOff ){
+      VdbeSorterIter *pIter = &pMerger->aIter[iIter++];
+      assert( iIter<=nIter );
+      rc = vdbeSorterIterInit(pMain, pTask->pTemp1, iReadOff,
+                              pTask->iWriteOff, pIter, &nByte);
+      iReadOff = pIter->iEof;
+    }
+  }
+  if( rc==SQLITE_OK ){
+    rc = vdbeMergeEngineInit(pMain, pMerger);
+  }
+
+  *pbEof = (pMerger->aIter[pMerger->aTree[1]].pFile==0);
+  return rc;
+}
+
+/*
+** Advance to the next element in the sorter.
+*/
+int sqlite3VdbeSorterNext(sqlite3 *db, const VdbeCursor *pCsr, int *pbEof){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  int rc;                         /* Return code */
+
+  if( pSorter->pMerger ){
+    rc = vdbeMergeEngineStep(&pSorter->aTask[0], pSorter->pMerger, pbEof);
+  }else{
+    SorterRecord *pFree = pSorter->pRecord;
+    pSorter->pRecord = pFree->pNext;
+    pFree->pNext = 0;
+    vdbeSorterRecordFree(pSorter->aTask[0].db, pFree);
+    *pbEof = !pSorter->pRecord;
+    rc = SQLITE_OK;
+  }
+  return rc;
+}
+
+/*
+** Return a pointer to a buffer owned by the sorter that contains the 
+** current key.
+*/
+static void *vdbeSorterRowkey(
+  const VdbeSorter *pSorter,      /* Sorter object */
+  int *pnKey                      /* OUT: Size of current key in bytes */
+){
+  void *pKey;
+  if( pSorter->pMerger ){
+    VdbeSorterIter *pIter;
+    pIter = &pSorter->pMerger->aIter[ pSorter->pMerger->aTree[1] ];
+    *pnKey = pIter->nKey;
+    pKey = pIter->aKey;
+  }else{
+    *pnKey = pSorter->pRecord->nVal;
+    pKey = pSorter->pRecord->pVal;
+  }
+  return pKey;
+}
+
+/*
+** Copy the current sorter key into the memory cell pOut.
+*/
+int sqlite3VdbeSorterRowkey(const VdbeCursor *pCsr, Mem *pOut){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  void *pKey; int nKey;           /* Sorter key to copy into pOut */
+
+  pKey = vdbeSorterRowkey(pSorter, &nKey);
+  if( sqlite3VdbeMemGrow(pOut, nKey, 0) ){
+    return SQLITE_NOMEM;
+  }
+  pOut->n = nKey;
+  MemSetTypeFlag(pOut, MEM_Blob);
+  memcpy(pOut->z, pKey, nKey);
+
+  return SQLITE_OK;
+}
+
+/*
+** Compare the key in memory cell pVal with the key that the sorter cursor
+** passed as the first argument currently points to. For the purposes of
+** the comparison, ignore the rowid field at the end of each record.
+**
+** If an error occurs, return an SQLite error code (i.e. SQLITE_NOMEM).
+** Otherwise, set *pRes to a negative, zero or positive value if the
+** key in pVal is smaller than, equal to or larger than the current sorter
+** key.
+*/
+int sqlite3VdbeSorterCompare(
+  const VdbeCursor *pCsr,         /* Sorter cursor */
+  Mem *pVal,                      /* Value to compare to current sorter key */
+  int nIgnore,                    /* Ignore this many fields at the end */
+  int *pRes                       /* OUT: Result of comparison */
+){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  void *pKey; int nKey;           /* Sorter key to compare pVal with */
+
+  pKey = vdbeSorterRowkey(pSorter, &nKey);
+  vdbeSorterCompare(&pSorter->aTask[0], nIgnore, pVal->z, pVal->n, pKey, nKey,
+                    pRes);
+  return SQLITE_OK;
+}
@@ -0,0 +1,239 @@
+/*
+** 2014 June 18
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+**
+** This file contains the group commit used when the "PRAGMA
+** wal_group_commit" setting of a WAL database is non-zero.
+**
+** With PRAGMA synchronous=FULL, each transaction committed to a WAL
+** database is synced to disk by the committing connection while it holds
+** the WAL write lock. Commits are made durable one at a time, each with
+** a sync of its own.
+**
+** Instead, the connections of a process that use group commit on the
+** same database share a WalGroup object. A commit made by one of them is
+** appended to the WAL and made visible to readers without being synced.
+** Once the write lock has been released, the committing connection waits
+** for the commit to become durable (see sqlite3WalGroupSync()). The first
+** to wait is the leader. It waits for up to the configured delay for the
+** other members of the group to append their own commits, then syncs the
+** WAL once for all of them.
+**
+** As with synchronous=NORMAL, a transaction may be read by other
+** connections before it is durable. But COMMIT does not return until it
+** is.
+**
+** Connections join the group the first time they commit with group
+** commit enabled. Groups are identified by the address of the first page
+** of the wal-index, which is shared by all connections of the process
+** that have the same database open (the same database may be opened
+** using different names).
+**
+** Group commit requires pthreads, like the background checkpointer in
+** walckpt.c. In other builds sqlite3WalGroupOpen() does not create a
+** group and each commit is synced by the committing connection.
+*/
+#include "sqliteInt.h"
+#include "wal.h"
+
+#if !defined(SQLITE_OMIT_WAL) && SQLITE_MAX_WORKER_THREADS>0 \
+ && SQLITE_OS_UNIX && defined(SQLITE_MUTEX_PTHREADS) && SQLITE_THREADSAFE>0
+
+#include <pthread.h>
+#include <errno.h>
+#include <sys/time.h>
+
+/*
+** The group of the connections of this process that use group commit on
+** one database. The fields following the mutex may only be used while
+** holding it.
+*/
+struct WalGroup {
+  void *pKey;                     /* First page of the shared wal-index */
+  int nRef;                       /* Number of Wal objects in the group */
+  WalGroup *pNext;                /* Next group in walGroupList */
+  pthread_mutex_t mutex;          /* Mutex protecting the following */
+  pthread_cond_t cond;            /* Signalled by appends and after syncs */
+  u64 iAppend;                    /* Ticket of the last commit appended */
+  u64 iSynced;                    /* Commits up to this ticket are durable */
+  int mDirty;                     /* WAL files written since the last sync */
+  int bSyncing;                   /* True while the leader is syncing */
+};
+
+/*
+** All groups of this process. Protected by the STATIC_MASTER mutex.
+*/
+static WalGroup *walGroupList = 0;
+
+/*
+** Join the group of the connections whose wal-index starts at pKey,
+** creating it if necessary. Return NULL if there is no thread support or
+** if a malloc fails, in which case the caller syncs its own commits.
+*/
+WalGroup *sqlite3WalGroupOpen(void *pKey){
+  sqlite3_mutex *pMaster;
+  WalGroup *p;
+
+  if( sqlite3GlobalConfig.bCoreMutex==0 ) return 0;
+
+  pMaster = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
+  sqlite3_mutex_enter(pMaster);
+  for(p=walGroupList; p && p->pKey!=pKey; p=p->pNext);
+  if( p==0 ){
+    p = (WalGroup*)sqlite3MallocZero(sizeof(WalGroup));
+    if( p ){
+      p->pKey = pKey;
+      pthread_mutex_init(&p->mutex, 0);
+      pthread_cond_init(&p->cond, 0);
+      p->pNext = walGroupList;
+      walGroupList = p;
+    }
+  }
+  if( p ){
+    pthread_mutex_lock(&p->mutex);
+    p->nRef++;
+    pthread_mutex_unlock(&p->mutex);
+  }
+  sqlite3_mutex_leave(pMaster);
+  return p;
+}
+
+/*
+** Leave a group. It is freed once its last member has left.
+*/
+void sqlite3WalGroupClose(WalGroup *p){
+  if( p ){
+    sqlite3_mutex *pMaster = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
+    int nRef;
+    sqlite3_mutex_enter(pMaster);
+    pthread_mutex_lock(&p->mutex);
+    nRef = --p->nRef;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+    if( nRef==0 ){
+      WalGroup **pp;
+      for(pp=&walGroupList; *pp!=p; pp=&(*pp)->pNext);
+      *pp = p->pNext;
+      pthread_cond_destroy(&p->cond);
+      pthread_mutex_destroy(&p->mutex);
+      sqlite3_free(p);
+    }
+    sqlite3_mutex_leave(pMaster);
+  }
+}
+
+/*
+** Called by a member of the group, while it holds the WAL write lock,
+** after appending a commit to WAL file iWal without syncing it. Return
+** the ticket to pass to sqlite3WalGroupSync().
+*/
+u64 sqlite3WalGroupAppend(WalGroup *p, int iWal){
+  u64 iTicket;
+  pthread_mutex_lock(&p->mutex);
+  iTicket = ++p->iAppend;
+  p->mDirty |= (1<<iWal);
+  pthread_cond_broadcast(&p->cond);
+  pthread_mutex_unlock(&p->mutex);
+  return iTicket;
+}
+
+/*
+** Wait until the commit with ticket iTicket is durable. The caller must
+** not hold the WAL write lock.
+**
+** If no other member is syncing the WAL, this connection is the leader.
+** As each member has at most one commit that is not yet durable, it waits
+** until there are as many such commits as members, or for at most nDelay
+** microseconds. It then syncs each WAL file that has been written since
+** the last sync, using file handle apFd[i] for file i.
+**
+** If a sync fails, the error is returned to the leader only. The commits
+** it was syncing are left for the next leader to sync again.
+*/
+int sqlite3WalGroupSync(
+  WalGroup *p,                    /* Group of the connection */
+  u64 iTicket,                    /* Ticket of the commit to wait for */
+  int nDelay,                     /* Maximum batching delay in microseconds */
+  sqlite3_file **apFd,            /* Handles of the WAL files to sync */
+  int sync_flags                  /* Flags to pass to OsSync() */
+){
+  int rc = SQLITE_OK;
+
+  pthread_mutex_lock(&p->mutex);
+  while( rc==SQLITE_OK && p->iSynced<iTicket ){
+    u64 iTarget;                  /* Last ticket appended before the sync */
+    int mSync;                    /* WAL files to sync */
+    int i;
+
+    if( p->bSyncing ){
+      pthread_cond_wait(&p->cond, &p->mutex);
+      continue;
+    }
+    p->bSyncing = 1;
+
+    if( nDelay>0 && p->iAppend-p->iSynced<(u64)p->nRef ){
+      struct timeval now;
+      struct timespec ts;
+      i64 iUs;
+      gettimeofday(&now, 0);
+      iUs = now.tv_usec + (i64)nDelay;
+      ts.tv_sec = now.tv_sec + (time_t)(iUs/1000000);
+      ts.tv_nsec = (long)(iUs%1000000)*1000;
+      while( p->iAppend-p->iSynced<(u64)p->nRef ){
+        if( pthread_cond_timedwait(&p->cond, &p->mutex, &ts)==ETIMEDOUT ){
+          break;
+        }
+      }
+    }
+
+    iTarget = p->iAppend;
+    mSync = p->mDirty;
+    p->mDirty = 0;
+    pthread_mutex_unlock(&p->mutex);
+    for(i=0; rc==SQLITE_OK && i<2; i++){
+      if( mSync & (1<<i) ){
+        assert( apFd[i] );
+        rc = sqlite3OsSync(apFd[i], sync_flags);
+      }
+    }
+    pthread_mutex_lock(&p->mutex);
+    p->bSyncing = 0;
+    if( rc==SQLITE_OK ){
+      p->iSynced = iTarget;
+    }else{
+      p->mDirty |= mSync;
+    }
+    pthread_cond_broadcast(&p->cond);
+  }
+  pthread_mutex_unlock(&p->mutex);
+  return rc;
+}
+
+#elif !defined(SQLITE_OMIT_WAL)
+
+/*
+** No thread support. Commits are always synced by the committing
+** connection.
+*/
+WalGroup *sqlite3WalGroupOpen(void *pKey){ return 0; }
+void sqlite3WalGroupClose(WalGroup *p){ assert( p==0 ); }
+u64 sqlite3WalGroupAppend(WalGroup *p, int iWal){ return 0; }
+int sqlite3WalGroupSync(
+  WalGroup *p,
+  u64 iTicket,
+  int nDelay,
+  sqlite3_file **apFd,
+  int sync_flags
+){
+  return SQLITE_OK;
+}
+
+#endif
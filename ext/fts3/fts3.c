@@ -545,6 +545,7 @@ static int fts3DestroyMethod(sqlite3_vtab *pVtab){
   fts3DbExec(&rc, db, "DROP TABLE IF EXISTS %Q.'%q_segdir'", zDb, p->zName);
   fts3DbExec(&rc, db, "DROP TABLE IF EXISTS %Q.'%q_docsize'", zDb, p->zName);
   fts3DbExec(&rc, db, "DROP TABLE IF EXISTS %Q.'%q_stat'", zDb, p->zName);
+  fts3DbExec(&rc, db, "DROP TABLE IF EXISTS %Q.'%q_label'", zDb, p->zName);
 
   /* If everything has worked, invoke fts3DisconnectMethod() to free the
   ** memory associated with the Fts3Table structure and return SQLITE_OK.
@@ -609,6 +610,18 @@ void sqlite3Fts3CreateStatTable(int *pRc, Fts3Table *p){
   if( (*pRc)==SQLITE_OK ) p->bHasStat = 1;
 }
 
+/*
+** Create the %_label table of a labeled table, if it does not exist.
+*/
+void sqlite3Fts3CreateLabelTable(int *pRc, Fts3Table *p){
+  fts3DbExec(pRc, p->db, 
+      "CREATE TABLE IF NOT EXISTS %Q.'%q_label'"
+          "(docid INTEGER PRIMARY KEY, label INT);",
+      p->zDb, p->zName
+  );
+  if( (*pRc)==SQLITE_OK ) p->bHasLabel = 1;
+}
+
 /*
 ** Create the backing store tables (%_content, %_segments and %_segdir)
 ** required by the FTS3 table passed as the only argument. This is done
@@ -673,6 +686,9 @@ static int fts3CreateTables(Fts3Table *p){
   if( p->bHasStat ){
     sqlite3Fts3CreateStatTable(&rc, p);
   }
+  if( p->bLabels ){
+    sqlite3Fts3CreateLabelTable(&rc, p);
+  }
   return rc;
 }
 
@@ -1336,6 +1352,11 @@ static int fts3InitVtab(
   p->bAutoincrmerge = 0xff;   /* 0xff means setting unknown */
   p->zContentTbl = zContent;
   p->zLanguageid = zLanguageid;
+#ifdef SQLITE_ENABLE_SELINUX
+  /* SeSQLite adds the security_context column to the declared schema, the
+  ** label of each row is kept in the %_label table. */
+  p->bLabels = (u8)sesqlite_vtab_labeled(db);
+#endif
   zContent = 0;
   zLanguageid = 0;
   TESTONLY( p->inTransaction = -1 );
@@ -1416,6 +1437,18 @@ static int fts3InitVtab(
     if( rc2==SQLITE_OK ) p->bHasStat = 1;
   }
 
+  /* A table created without SeSQLite, or whose %_label table was dropped,
+  ** has no labels. Its existing rows are treated as unlabeled (and so are
+  ** denied) and the %_label table is created by the first write that stores
+  ** a label (see fts3InsertLabel()).
+  */
+  if( p->bLabels && !isCreate ){
+    int rc2 = SQLITE_OK;
+    fts3DbExec(&rc2, db, "SELECT 1 FROM %Q.'%q_label' WHERE docid=0",
+               p->zDb, p->zName);
+    if( rc2==SQLITE_OK ) p->bHasLabel = 1;
+  }
+
   /* Figure out the page-size for the database. This is required in order to
   ** estimate the cost of loading large doclists from the database.  */
   fts3DatabasePageSize(&rc, p);
@@ -1674,6 +1707,22 @@ static int fts3CursorSeekStmt(Fts3Cursor *pCsr, sqlite3_stmt **ppStmt){
   return rc;
 }
 
+/*
+** Load the label of the current row of a labeled table (see
+** Fts3Table.bLabels) from the %_label table into pCsr->iLabel. The label is
+** read only once for each row. Return SQLITE_OK on success.
+*/
+static int fts3CursorLabel(Fts3Cursor *pCsr){
+  int rc = SQLITE_OK;
+  if( pCsr->bLabel==0 || pCsr->iLabelDocid!=pCsr->iPrevId ){
+    Fts3Table *p = (Fts3Table *)pCsr->base.pVtab;
+    rc = sqlite3Fts3SelectLabel(p, pCsr->iPrevId, &pCsr->iLabel);
+    pCsr->iLabelDocid = pCsr->iPrevId;
+    pCsr->bLabel = (rc==SQLITE_OK);
+  }
+  return rc;
+}
+
 /*
 ** Position the pCsr->pStmt statement so that it is on the row
 ** of the %_content table that contains the last match.  Return
@@ -3226,9 +3275,13 @@ static int fts3ColumnMethod(
   Fts3Table *p = (Fts3Table *)pCursor->pVtab;
 
   /* The column value supplied by SQLite must be in range. */
-  assert( iCol>=0 && iCol<=p->nColumn+2 );
+  assert( iCol>=0 && iCol<=p->nColumn+2+p->bLabels );
 
-  if( iCol==p->nColumn+1 ){
+  if( iCol==p->nColumn+3 ){
+    /* The security_context column of a labeled table. */
+    rc = fts3CursorLabel(pCsr);
+    if( rc==SQLITE_OK ) sqlite3_result_int(pCtx, pCsr->iLabel);
+  }else if( iCol==p->nColumn+1 ){
     /* This call is a request for the "docid" column. Since "docid" is an 
     ** alias for "rowid", use the xRowid() method to obtain the value.
     */
@@ -3608,6 +3661,12 @@ static int fts3RenameMethod(
       p->zDb, p->zName, zName
     );
   }
+  if( p->bHasLabel ){
+    fts3DbExec(&rc, db,
+      "ALTER TABLE %Q.'%q_label'  RENAME TO '%q_label';",
+      p->zDb, p->zName, zName
+    );
+  }
   fts3DbExec(&rc, db,
     "ALTER TABLE %Q.'%q_segments' RENAME TO '%q_segments';",
     p->zDb, p->zName, zName
@@ -5288,6 +5347,31 @@ static int fts3EvalTestDeferredAndNear(Fts3Cursor *pCsr, int *pRc){
   return (rc==SQLITE_OK && bMiss);
 }
 
+/*
+** This function is called as part of each xNext operation on a labeled
+** table (see Fts3Table.bLabels), once the cursor points to the next row
+** matching the query. It returns 1 if the subject can not select the row,
+** so that the row is skipped before the %_content table is read for the
+** deferred tokens and before snippet(), offsets() and matchinfo() see it.
+** Otherwise, or if an error occurs, it returns 0.
+*/
+static int fts3EvalTestLabel(Fts3Cursor *pCsr, int *pRc){
+  int bDenied = 0;
+#ifdef SQLITE_ENABLE_SELINUX
+  Fts3Table *p = (Fts3Table *)pCsr->base.pVtab;
+  if( *pRc==SQLITE_OK && p->bLabels ){
+    *pRc = fts3CursorLabel(pCsr);
+    if( *pRc==SQLITE_OK ){
+      bDenied = !sesqlite_tuple_visible(p->db, p->zDb, pCsr->iLabel);
+    }
+  }
+#else
+  UNUSED_PARAMETER(pCsr);
+  UNUSED_PARAMETER(pRc);
+#endif
+  return bDenied;
+}
+
 /*
 ** Advance to the next document that matches the FTS expression in
 ** Fts3Cursor.pExpr.
@@ -5309,7 +5393,10 @@ static int fts3EvalNext(Fts3Cursor *pCsr){
       pCsr->isRequireSeek = 1;
       pCsr->isMatchinfoNeeded = 1;
       pCsr->iPrevId = pExpr->iDocid;
-    }while( pCsr->isEof==0 && fts3EvalTestDeferredAndNear(pCsr, &rc) );
+    }while( pCsr->isEof==0 && (
+          fts3EvalTestLabel(pCsr, &rc)
+       || fts3EvalTestDeferredAndNear(pCsr, &rc)
+    ));
   }
 
   /* Check if the cursor is past the end of the docid range specified
@@ -5472,7 +5559,9 @@ static int fts3EvalGatherStats(
            && fts3EvalTestDeferredAndNear(pCsr, &rc) 
       );
 
-      if( rc==SQLITE_OK && pCsr->isEof==0 ){
+      if( rc==SQLITE_OK && pCsr->isEof==0 
+       && fts3EvalTestLabel(pCsr, &rc)==0 && rc==SQLITE_OK
+      ){
         fts3EvalUpdateCounts(pRoot);
       }
     }
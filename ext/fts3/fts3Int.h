@@ -211,12 +211,14 @@ struct Fts3Table {
   char *zContentTbl;              /* content=xxx option, or NULL */
   char *zLanguageid;              /* languageid=xxx option, or NULL */
   u8 bAutoincrmerge;              /* True if automerge=1 */
+  u8 bLabels;                     /* True if rows have a security_context */
+  u8 bHasLabel;                   /* True if the %_label table exists */
   u32 nLeafAdd;                   /* Number of leaf blocks added this trans */
 
   /* Precompiled statements used by the implementation. Each of these 
   ** statements is run and reset within a single virtual table API call. 
   */
-  sqlite3_stmt *aStmt[37];
+  sqlite3_stmt *aStmt[41];
 
   char *zReadExprlist;
   char *zWriteExprlist;
@@ -304,6 +306,9 @@ struct Fts3Cursor {
   u32 *aMatchinfo;                /* Information about most recent match */
   int nMatchinfo;                 /* Number of elements in aMatchinfo[] */
   char *zMatchinfo;               /* Matchinfo specification */
+  i64 iLabelDocid;                /* Docid whose label is in iLabel */
+  int iLabel;                     /* Label of row iLabelDocid, if bLabel */
+  u8 bLabel;                      /* True if iLabel is valid */
 };
 
 #define FTS3_EVAL_FILTER    0
@@ -454,6 +459,7 @@ int sqlite3Fts3ReadBlock(Fts3Table*, sqlite3_int64, char **, int*, int*);
 
 int sqlite3Fts3SelectDoctotal(Fts3Table *, sqlite3_stmt **);
 int sqlite3Fts3SelectDocsize(Fts3Table *, sqlite3_int64, sqlite3_stmt **);
+int sqlite3Fts3SelectLabel(Fts3Table *, sqlite3_int64, int *);
 
 #ifndef SQLITE_DISABLE_FTS4_DEFERRED
 void sqlite3Fts3FreeDeferredTokens(Fts3Cursor *);
@@ -538,6 +544,7 @@ void sqlite3Fts3DoclistPrev(int,char*,int,char**,sqlite3_int64*,int*,u8*);
 int sqlite3Fts3EvalPhraseStats(Fts3Cursor *, Fts3Expr *, u32 *);
 int sqlite3Fts3FirstFilter(sqlite3_int64, char *, int, char *);
 void sqlite3Fts3CreateStatTable(int*, Fts3Table*);
+void sqlite3Fts3CreateLabelTable(int*, Fts3Table*);
 
 /* fts3_tokenizer.c */
 const char *sqlite3Fts3NextToken(const char *, int *);
@@ -581,6 +588,12 @@ int sqlite3Fts3EvalPhrasePoslist(Fts3Cursor *, Fts3Expr *, int iCol, char **);
 int sqlite3Fts3MsrOvfl(Fts3Cursor *, Fts3MultiSegReader *, int *);
 int sqlite3Fts3MsrIncrRestart(Fts3MultiSegReader *pCsr);
 
+/* ext/security/sesqlite (labeled FTS tables, see Fts3Table.bLabels) */
+#ifdef SQLITE_ENABLE_SELINUX
+int sesqlite_vtab_labeled(sqlite3 *db);
+int sesqlite_tuple_visible(sqlite3 *db, const char *zDb, int label);
+#endif
+
 /* fts3_tokenize_vtab.c */
 int sqlite3Fts3InitTok(sqlite3*, Fts3Hash *);
 
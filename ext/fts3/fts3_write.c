@@ -268,6 +268,11 @@ struct SegmentNode {
 #define SQL_SELECT_INDEXES            35
 #define SQL_SELECT_MXLEVEL            36
 
+#define SQL_SELECT_LABEL              37
+#define SQL_REPLACE_LABEL             38
+#define SQL_DELETE_LABEL              39
+#define SQL_DELETE_ALL_LABEL          40
+
 /*
 ** This function is used to obtain an SQLite prepared statement handle
 ** for the statement identified by the second argument. If successful,
@@ -369,7 +374,13 @@ static int fts3SqlStmt(
 
 /* SQL_SELECT_MXLEVEL
 **   Return the largest relative level in the FTS index or indexes.  */
-/* 36 */  "SELECT max( level %% 1024 ) FROM %Q.'%q_segdir'"
+/* 36 */  "SELECT max( level %% 1024 ) FROM %Q.'%q_segdir'",
+
+/* The %_label table of the labeled tables, see Fts3Table.bLabels. */
+/* 37 */  "SELECT label FROM %Q.'%q_label' WHERE docid=?",
+/* 38 */  "REPLACE INTO %Q.'%q_label'(docid, label) VALUES(?,?)",
+/* 39 */  "DELETE FROM %Q.'%q_label' WHERE docid = ?",
+/* 40 */  "DELETE FROM %Q.'%q_label'"
   };
   int rc = SQLITE_OK;
   sqlite3_stmt *pStmt;
@@ -462,6 +473,33 @@ int sqlite3Fts3SelectDocsize(
   return fts3SelectDocsize(pTab, iDocid, ppStmt);
 }
 
+/*
+** Read the label of row iDocid of a labeled table from the %_label table.
+** If the row has no label, *piLabel is set to 0, the id that no subject
+** can select.
+*/
+int sqlite3Fts3SelectLabel(
+  Fts3Table *pTab,                /* Fts3 table handle */
+  sqlite3_int64 iDocid,           /* Docid to read the label of */
+  int *piLabel                    /* OUT: Label of the row */
+){
+  sqlite3_stmt *pStmt = 0;
+  int rc;
+
+  assert( pTab->bLabels );
+  *piLabel = 0;
+  if( pTab->bHasLabel==0 ) return SQLITE_OK;
+  rc = fts3SqlStmt(pTab, SQL_SELECT_LABEL, &pStmt, 0);
+  if( rc==SQLITE_OK ){
+    sqlite3_bind_int64(pStmt, 1, iDocid);
+    if( sqlite3_step(pStmt)==SQLITE_ROW ){
+      *piLabel = sqlite3_column_int(pStmt, 0);
+    }
+    rc = sqlite3_reset(pStmt);
+  }
+  return rc;
+}
+
 /*
 ** Similar to fts3SqlStmt(). Except, after binding the parameters in
 ** array apVal[] to the SQL statement identified by eStmt, the statement
@@ -1019,6 +1057,9 @@ static int fts3DeleteAll(Fts3Table *p, int bContent){
   if( p->bHasStat ){
     fts3SqlExec(&rc, p, SQL_DELETE_ALL_STAT, 0);
   }
+  if( bContent && p->bHasLabel ){
+    fts3SqlExec(&rc, p, SQL_DELETE_ALL_LABEL, 0);
+  }
   return rc;
 }
 
@@ -3134,6 +3175,38 @@ static void fts3InsertDocsize(
   *pRC = sqlite3_reset(pStmt);
 }
 
+/*
+** Insert the label of the document with docid equal to p->iPrevDocid into
+** the %_label table of a labeled table. pLabel is the value of the
+** security_context column supplied by the INSERT or UPDATE.
+**
+** If the table was created without SeSQLite it has no %_label table yet.
+** In that case the table is created here, by the first write that needs it.
+*/
+static void fts3InsertLabel(
+  int *pRC,                       /* Result code */
+  Fts3Table *p,                   /* Table into which to insert */
+  sqlite3_value *pLabel           /* Label of the document */
+){
+  sqlite3_stmt *pStmt;     /* Statement used to insert the label */
+  int rc;                  /* Result code from subfunctions */
+
+  if( *pRC ) return;
+  if( p->bHasLabel==0 ){
+    sqlite3Fts3CreateLabelTable(pRC, p);
+    if( *pRC ) return;
+  }
+  rc = fts3SqlStmt(p, SQL_REPLACE_LABEL, &pStmt, 0);
+  if( rc ){
+    *pRC = rc;
+    return;
+  }
+  sqlite3_bind_int64(pStmt, 1, p->iPrevDocid);
+  sqlite3_bind_value(pStmt, 2, pLabel);
+  sqlite3_step(pStmt);
+  *pRC = sqlite3_reset(pStmt);
+}
+
 /*
 ** Record 0 of the %_stat table contains a blob consisting of N varints,
 ** where N is the number of user defined columns in the fts3 table plus
@@ -5237,6 +5310,9 @@ static int fts3DeleteByRowid(
         if( p->bHasDocsize ){
           fts3SqlExec(&rc, p, SQL_DELETE_DOCSIZE, &pRowid);
         }
+        if( p->bHasLabel ){
+          fts3SqlExec(&rc, p, SQL_DELETE_LABEL, &pRowid);
+        }
       }
     }
   }
@@ -5255,7 +5331,9 @@ static int fts3DeleteByRowid(
 **       <langid> HIDDEN
 **     );
 **
-** 
+** Labeled tables (see Fts3Table.bLabels) have one more column at the end,
+** the security_context added by SeSQLite, whose value is stored in the
+** %_label table.
 */
 int sqlite3Fts3UpdateMethod(
   sqlite3_vtab *pVtab,            /* FTS3 vtab object */
@@ -5274,7 +5352,7 @@ int sqlite3Fts3UpdateMethod(
   assert( p->pSegments==0 );
   assert( 
       nArg==1                     /* DELETE operations */
-   || nArg==(2 + p->nColumn + 3)  /* INSERT or UPDATE operations */
+   || nArg==(2 + p->nColumn + 3 + p->bLabels)  /* INSERT or UPDATE */
   );
 
   /* Check for a "special" INSERT operation. One of the form:
@@ -5381,6 +5459,9 @@ int sqlite3Fts3UpdateMethod(
     if( p->bHasDocsize ){
       fts3InsertDocsize(&rc, p, aSzIns);
     }
+    if( p->bLabels ){
+      fts3InsertLabel(&rc, p, apVal[2 + p->nColumn + 3]);
+    }
     nChng++;
   }
 
@@ -36,14 +36,48 @@ extern int tcon_id;
 extern SESQLITE_HASH *hash;
 extern SESQLITE_BIHASH *hash_id;
 
-extern sqlite3_stmt *stmt_insert;
-extern sqlite3_stmt *stmt_update;
-extern sqlite3_stmt *stmt_select_id;
-extern sqlite3_stmt *stmt_select_label;
-extern sqlite3_stmt *stmt_con_insert;
+/*
+ * The state of a SeSQLite connection, stored in db->pSelinux. The rest
+ * (the label dictionary, the labels of the objects of main, the contexts
+ * and the AVC) is shared by all the connections of the process, which
+ * must open the same main database, and is protected by the mutexes
+ * returned by sesqlite_mutex.
+ */
+struct sesqlite_conn {
+	sqlite3_stmt *stmt_insert;       /* insert into main.selinux_id */
+	sqlite3_stmt *stmt_update;       /* relabel the rows of main.selinux_id */
+	sqlite3_stmt *stmt_select_id;    /* label -> id in main.selinux_id */
+	sqlite3_stmt *stmt_select_label; /* id -> label in main.selinux_id */
+	sqlite3_stmt *stmt_con_insert;   /* insert or replace into main.selinux_context */
+	SESQLITE_HASH *attached;         /* attached db name -> struct sesqlite_attached */
+	void *pPending;                  /* labels added by the transaction, see sesqlite_shm.c */
+	void *pShm;                      /* the shared label log of main, see sesqlite_shm.c */
+	Hash guards;                     /* scan guards of the label counts, see sesqlite_count.c */
+	int vacuum;                      /* 1 while VACUUM copies the database */
+	int loading;                     /* 1 while the label counts are computed */
+	Hash stmts;                      /* SQL text -> statement kept by the cache, see sesqlite_stmt.c */
+	void *pLru;                      /* the kept statements, most recently used first */
+	int nStmt;                       /* statements kept by the cache */
+	int mxStmt;                      /* size of the cache, 0 disables it */
+};
+
+#define SESQLITE_CONN(db) ((struct sesqlite_conn*) (db)->pSelinux)
+
+/*
+ * The mutexes of the state shared by the connections. They are allocated
+ * by the first sqlite3SelinuxInit and are no-ops if SQLite is built with
+ * SQLITE_THREADSAFE=0. No SQL is ever run while one of them is held,
+ * except for SESQLITE_MUTEX_INIT, which serializes the initialization.
+ */
+#define SESQLITE_MUTEX_INIT    0 /* the connection count, the shared state setup */
+#define SESQLITE_MUTEX_LABELS  1 /* the label dictionary, the object labels, the contexts */
+#define SESQLITE_MUTEX_AVC     2 /* the userspace AVC */
+#define SESQLITE_NMUTEX        3
+
+sqlite3_mutex *sesqlite_mutex(int id);
 
-extern int set_vacuum(int type); 
-extern int is_vacuum(); 
+int set_vacuum(sqlite3 *db, int type);
+int is_vacuum(sqlite3 *db);
 
 #define SECURITY_CONTEXT_COLUMN_NAME "security_context"
 #define SECURITY_CONTEXT_COLUMN_TYPE "hidden INT"
@@ -95,7 +129,12 @@ const char *authtype[] = { "SQLITE_COPY", "SQLITE_CREATE_INDEX",
 #define SELINUX_NELEM_PERM		10
 
 
-extern struct sesqlite_context *contexts;
+/*
+ * Returns the contexts read from the sesqlite_contexts file. The contexts
+ * replaced by restorecon are kept until the last connection is closed,
+ * so the strings of the returned contexts can be used without locking.
+ */
+struct sesqlite_context *sesqlite_get_contexts(void);
 
 int lookup_security_context(
 	SESQLITE_BIHASH *hash,
@@ -113,10 +152,85 @@ int lookup_security_label(
 	char *col_name
 );
 
+/*
+ * Attached databases keep their own selinux_id dictionary. The ids stored
+ * in their rows are translated to and from the ids of the main database,
+ * which are the ones used by the in-memory hashmaps and the AVC.
+ * Both functions return the id unchanged for main and temp.
+ */
+int sesqlite_global_id(
+	sqlite3 *db,
+	const char *zDb,
+	int id
+);
+
+int sesqlite_local_id(
+	sqlite3 *db,
+	const char *zDb,
+	int id
+);
+
+/*
+ * Returns the name to store in the db column of selinux_context for
+ * objects of zDb: attached databases always describe themselves as main,
+ * so that they can be opened on their own as well.
+ */
+const char *sesqlite_stored_db(
+	sqlite3 *db,
+	const char *zDb
+);
+
 /* */
 int sqlite3SelinuxInit(
 	sqlite3 *db
 );
+
+/*
+ * Returns 1 if the connection has statements (other than the ones
+ * prepared by SeSQLite) or backups still running, 0 otherwise.
+ */
+int sqlite3SelinuxBusy(
+	sqlite3 *db
+);
+
+/*
+ * Finalizes the statements prepared by SeSQLite for the connection and
+ * releases its state. The shared state is released with the last
+ * connection. Invoked by sqlite3_close before the connection is closed.
+ */
+void sqlite3SelinuxClose(
+	sqlite3 *db
+);
+
+/*
+ * Returns a statement kept by the statement cache of the connection for
+ * the SQL text, if it is still valid, and sets *pzTail past the text.
+ * Returns NULL otherwise. Invoked by sqlite3_prepare_v2, see sesqlite_stmt.c.
+ */
+sqlite3_stmt *sqlite3SelinuxStmtLookup(
+	sqlite3 *db,
+	const char *zSql,
+	int nBytes,
+	const char **pzTail
+);
+
+/*
+ * Resets the statement and keeps it in the statement cache of the
+ * connection instead of deleting it. Returns 1 and the result of the
+ * reset in *pRc if it did, 0 if the statement has to be finalized.
+ * Invoked by sqlite3_finalize.
+ */
+int sqlite3SelinuxStmtPark(
+	sqlite3 *db,
+	sqlite3_stmt *pStmt,
+	int *pRc
+);
+
+/*
+ * Returns the generation of the policy that the statements compiled now
+ * are checked against, see sesqlite_policy_changed.
+ */
+unsigned int sqlite3SelinuxPolicy(void);
 /**
  * Used to store
  */
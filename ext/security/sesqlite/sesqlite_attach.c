@@ -0,0 +1,447 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/* SeSqlite extension to add SELinux checks in SQLite */
+
+#if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
+
+#include "sesqlite_attach.h"
+#include "sesqlite_init.h"
+#include "sesqlite_utils.h"
+#include "sesqlite_contexts.h"
+#include "sesqlite_shm.h"
+
+static struct sesqlite_attached *find_attached(
+	sqlite3 *db,
+	const char *zDb
+){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	struct sesqlite_attached *p = NULL;
+
+	if( pConn==NULL || pConn->attached==NULL || zDb==NULL )
+		return NULL;
+
+	SESQLITE_HASH_FIND(pConn->attached, zDb, -1, (void**) &p, 0);
+	return p;
+}
+
+static void map_id(
+	struct sesqlite_attached *p,
+	int local,
+	int global
+){
+	SESQLITE_HASH_INSERT(p->local2global, NULL, local, &global, sizeof(int));
+	SESQLITE_HASH_INSERT(p->global2local, NULL, global, &local, sizeof(int));
+}
+
+/*
+ * Returns the id (in the attached database) of the label assigned to the
+ * rows of its selinux_id table. The label of selinux_id itself is stored
+ * with id 0 while it is being inserted, it is fixed by initialize_attached.
+ */
+static int attached_tuple_id(
+	sqlite3 *db,
+	struct sesqlite_attached *p,
+	int id
+){
+	int tid = lookup_security_context(hash_id, p->zDb, SELINUX_ID);
+	return tid==id ? 0 : sesqlite_local_id(db, p->zDb, tid);
+}
+
+int sesqlite_global_id(
+	sqlite3 *db,
+	const char *zDb,
+	int id
+){
+	struct sesqlite_attached *p = find_attached(db, zDb);
+	int *value = NULL;
+	int global = 0;
+
+	if( p==NULL )
+		return id;
+
+	SESQLITE_HASH_FIND(p->local2global, NULL, id, (void**) &value, 0);
+	if( value!=NULL )
+		return *value;
+
+	/* the label was added to the attached file after it was loaded */
+	sqlite3_bind_int(p->stmt_select_label, 1, id);
+	if( sqlite3_step(p->stmt_select_label)==SQLITE_ROW ){
+		global = insert_id(db, "main",
+			(char*) sqlite3_column_text(p->stmt_select_label, 0));
+		map_id(p, id, global);
+	}
+	sqlite3_reset(p->stmt_select_label);
+
+	return global;
+}
+
+int sesqlite_local_id(
+	sqlite3 *db,
+	const char *zDb,
+	int id
+){
+	struct sesqlite_attached *p = find_attached(db, zDb);
+	int *value = NULL;
+	char *label = NULL;
+	int local = 0;
+
+	if( p==NULL )
+		return id;
+
+	SESQLITE_HASH_FIND(p->global2local, NULL, id, (void**) &value, 0);
+	if( value!=NULL )
+		return *value;
+
+	label = sesqlite_label(id);
+	assert( label!=NULL );
+
+	sqlite3_bind_text(p->stmt_select_id, 1, label, -1, SQLITE_TRANSIENT);
+	if( sqlite3_step(p->stmt_select_id)==SQLITE_ROW )
+		local = sqlite3_column_int(p->stmt_select_id, 0);
+	sqlite3_reset(p->stmt_select_id);
+
+	if( local==0 ){
+		sqlite3_bind_int(p->stmt_insert, 1, attached_tuple_id(db, p, id));
+		sqlite3_bind_text(p->stmt_insert, 2, label, -1, SQLITE_TRANSIENT);
+		sqlite3_step(p->stmt_insert);
+		sqlite3_reset(p->stmt_insert);
+		local = sqlite3_last_insert_rowid(db);
+	}
+
+	map_id(p, local, id);
+	return local;
+}
+
+const char *sesqlite_stored_db(
+	sqlite3 *db,
+	const char *zDb
+){
+	return find_attached(db, zDb) ? "main" : zDb;
+}
+
+sqlite3_stmt *sesqlite_context_stmt(
+	sqlite3 *db,
+	const char *zDb,
+	sqlite3_stmt *stmt
+){
+	struct sesqlite_attached *p = find_attached(db, zDb);
+	return p ? p->stmt_con_insert : stmt;
+}
+
+SESQLITE_HASH *sesqlite_objects(
+	sqlite3 *db,
+	const char *zDb
+){
+	struct sesqlite_attached *p = find_attached(db, zDb);
+	return p ? p->objects : hash;
+}
+
+int sesqlite_attached_stmt(
+	sqlite3 *db,
+	sqlite3_stmt *pStmt
+){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	sqliteHashElem *elem;
+
+	if( pConn==NULL || pConn->attached==NULL )
+		return 0;
+
+	for( elem = sqliteHashFirst(pConn->attached); elem; elem = sqliteHashNext(elem) ){
+		struct sesqlite_attached *p = elem->pData;
+		if( pStmt==p->stmt_insert || pStmt==p->stmt_select_id
+		    || pStmt==p->stmt_select_label || pStmt==p->stmt_con_insert )
+			return 1;
+	}
+	return 0;
+}
+
+/* Prepare the statements used on the dictionaries of the attached db */
+static int prepare_attached_stmt(
+	sqlite3 *db,
+	struct sesqlite_attached *p
+){
+	int rc = SQLITE_OK;
+	char *zSql = NULL;
+
+	zSql = sqlite3_mprintf("INSERT INTO"
+		" %Q.selinux_id(security_context, security_label)"
+		" VALUES (?1, ?2);", p->zDb);
+	rc = sqlite3_prepare_v2(db, zSql, -1, &p->stmt_insert, 0);
+	sqlite3_free(zSql);
+	if( SQLITE_OK!=rc ) return rc;
+
+	zSql = sqlite3_mprintf("SELECT rowid"
+		" FROM %Q.selinux_id"
+		" WHERE security_label = ?1;", p->zDb);
+	rc = sqlite3_prepare_v2(db, zSql, -1, &p->stmt_select_id, 0);
+	sqlite3_free(zSql);
+	if( SQLITE_OK!=rc ) return rc;
+
+	zSql = sqlite3_mprintf("SELECT security_label"
+		" FROM %Q.selinux_id"
+		" WHERE rowid = ?1;", p->zDb);
+	rc = sqlite3_prepare_v2(db, zSql, -1, &p->stmt_select_label, 0);
+	sqlite3_free(zSql);
+	if( SQLITE_OK!=rc ) return rc;
+
+	zSql = sqlite3_mprintf("INSERT OR REPLACE INTO"
+		" %Q.selinux_context(security_context, security_label, db, name, column)"
+		" VALUES (?1, ?2, ?3, ?4, ?5);", p->zDb);
+	rc = sqlite3_prepare_v2(db, zSql, -1, &p->stmt_con_insert, 0);
+	sqlite3_free(zSql);
+	return rc;
+}
+
+/*
+ * The attached database was never labeled: insert the tuple labels in its
+ * selinux_id (like initialize_mapping does for main) and label its schema.
+ */
+static int initialize_attached(
+	sqlite3 *db,
+	struct sesqlite_attached *p
+){
+	struct sesqlite_context_element *pp;
+	char *zSql = NULL;
+	int *value = NULL;
+	int global = 0;
+	int local = 0;
+	int rc = SQLITE_OK;
+
+	for( pp = sesqlite_get_contexts()->tuple_context; pp!=NULL; pp = pp->next ){
+		global = insert_id(db, "main", pp->security_context);
+
+		SESQLITE_HASH_FIND(p->global2local, NULL, global, (void**) &value, 0);
+		if( value!=NULL )
+			continue;
+
+		sqlite3_bind_int( p->stmt_insert, 1, 0);
+		sqlite3_bind_text(p->stmt_insert, 2, pp->security_context, -1, SQLITE_TRANSIENT);
+
+		rc = sqlite3_step(p->stmt_insert);
+		sqlite3_reset(p->stmt_insert);
+		if( rc!=SQLITE_DONE ) return SQLITE_ERROR;
+
+		local = sqlite3_last_insert_rowid(db);
+		map_id(p, local, global);
+	}
+
+	zSql = sqlite3_mprintf("UPDATE %Q.selinux_id SET security_context = %d;",
+		p->zDb, sesqlite_local_id(db, p->zDb,
+			lookup_security_context(hash_id, p->zDb, SELINUX_ID)));
+	rc = sqlite3_exec(db, zSql, 0, 0, 0);
+	sqlite3_free(zSql);
+	if( SQLITE_OK!=rc ){
+		fprintf(stderr, "SESQLITE ERROR: Unable to update %s.selinux_id table\n", p->zDb);
+		return rc;
+	}
+
+	return reload_sesqlite_contexts(db, p->stmt_con_insert,
+		sesqlite_get_contexts(), NULL, p->zDb, "*", "*", NULL, NULL);
+}
+
+/*
+ * The attached database was already labeled: translate its selinux_id and
+ * load the rows of its selinux_context stored for main in the hashmaps,
+ * using the name it was attached as instead.
+ */
+static int load_attached(
+	sqlite3 *db,
+	struct sesqlite_attached *p
+){
+	sqlite3_stmt *select_stmt = NULL;
+	char *zSql = NULL;
+	int rc = SQLITE_OK;
+
+	zSql = sqlite3_mprintf(
+		"SELECT rowid, security_label FROM %Q.selinux_id;", p->zDb);
+	rc = sqlite3_prepare_v2(db, zSql, -1, &select_stmt, 0);
+	sqlite3_free(zSql);
+	if( SQLITE_OK!=rc ) return rc;
+
+	while( sqlite3_step(select_stmt)==SQLITE_ROW ){
+		int local = sqlite3_column_int(select_stmt, 0);
+		map_id(p, local, insert_id(db, "main",
+			(char*) sqlite3_column_text(select_stmt, 1)));
+	}
+	sqlite3_finalize(select_stmt);
+
+	zSql = sqlite3_mprintf(
+		"SELECT security_label, name, column FROM %Q.selinux_context"
+		" WHERE db = 'main';", p->zDb);
+	rc = sqlite3_prepare_v2(db, zSql, -1, &select_stmt, 0);
+	sqlite3_free(zSql);
+	if( SQLITE_OK!=rc ) return rc;
+
+	while( sqlite3_step(select_stmt)==SQLITE_ROW ){
+		int id = sqlite3_column_int(select_stmt, 0);
+		const char *tblName = (const char*) sqlite3_column_text(select_stmt, 1);
+		const char *colName = (const char*) sqlite3_column_text(select_stmt, 2);
+
+		insert_key(db,
+			p->zDb,
+			( tblName==0 || strlen(tblName)==0) ? NULL : tblName,
+			( colName==0 || strlen(colName)==0) ? NULL : colName,
+			sesqlite_global_id(db, p->zDb, id));
+	}
+
+	sqlite3_finalize(select_stmt);
+	return SQLITE_OK;
+}
+
+static void free_attached(
+	struct sesqlite_attached *p
+){
+	sqlite3_stmt *aStmt[4];
+	int i;
+
+	/* sqlite3_finalize would close a zombie connection right away */
+	aStmt[0] = p->stmt_insert;
+	aStmt[1] = p->stmt_select_id;
+	aStmt[2] = p->stmt_select_label;
+	aStmt[3] = p->stmt_con_insert;
+	for( i = 0; i<4; i++ ){
+		if( aStmt[i] ) sqlite3VdbeFinalize((Vdbe*) aStmt[i]);
+	}
+	if( p->local2global ){
+		SESQLITE_HASH_CLEAR(p->local2global);
+		sqlite3_free(p->local2global);
+	}
+	if( p->global2local ){
+		SESQLITE_HASH_CLEAR(p->global2local);
+		sqlite3_free(p->global2local);
+	}
+	if( p->objects ){
+		SESQLITE_HASH_CLEAR(p->objects);
+		sqlite3_free(p->objects);
+	}
+	sqlite3_free(p->zDb);
+	sqlite3_free(p);
+}
+
+int sesqlite_attach(
+	sqlite3 *db,
+	const char *zDb
+){
+	int (*xAddExtraColumn)(void*,void*,int,void*,char**);
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	struct sesqlite_attached *p = NULL;
+	int reopen = 0;
+	int rc = SQLITE_OK;
+
+#ifdef SQLITE_DEBUG
+	sesqlite_print("Attaching", zDb, NULL, NULL, ".");
+#endif
+
+	if( pConn->attached==NULL ){
+		pConn->attached = sqlite3_malloc(sizeof(SESQLITE_HASH));
+		if( !pConn->attached ) return SQLITE_NOMEM;
+		SESQLITE_HASH_INIT(pConn->attached, SESQLITE_HASH_STRING, 1, 0);
+	}
+
+	p = sqlite3_malloc(sizeof(struct sesqlite_attached));
+	if( !p ) return SQLITE_NOMEM;
+	memset(p, 0, sizeof(struct sesqlite_attached));
+
+	p->zDb = sqlite3_mprintf("%s", zDb);
+	p->local2global = sqlite3_malloc(sizeof(SESQLITE_HASH));
+	p->global2local = sqlite3_malloc(sizeof(SESQLITE_HASH));
+	p->objects = sqlite3_malloc(sizeof(SESQLITE_HASH));
+	if( !p->zDb || !p->local2global || !p->global2local || !p->objects ){
+		free_attached(p);
+		return SQLITE_NOMEM;
+	}
+	SESQLITE_HASH_INIT(p->local2global, SESQLITE_HASH_INT, 0, 1);
+	SESQLITE_HASH_INIT(p->global2local, SESQLITE_HASH_INT, 0, 1);
+	SESQLITE_HASH_INIT(p->objects, SESQLITE_HASH_STRING, 1, 1);
+
+	rc = isReopen(db, zDb, &reopen);
+
+	/* like in main, the internal tables have no security_context column */
+	if( SQLITE_OK==rc ){
+		xAddExtraColumn = db->xAddExtraColumn;
+		db->xAddExtraColumn = 0;
+		rc = create_internal_table(db, zDb);
+		db->xAddExtraColumn = xAddExtraColumn;
+	}
+
+	if( SQLITE_OK==rc )
+		rc = prepare_attached_stmt(db, p);
+
+	if( SQLITE_OK!=rc ){
+		free_attached(p);
+		return rc;
+	}
+
+	SESQLITE_HASH_INSERT(pConn->attached, p->zDb, -1, p, 0);
+
+	/* a labeled file is checked against the db_database context stored
+	 * in it, a new one against the context it is going to be given */
+	if( reopen )
+		rc = load_attached(db, p);
+	if( SQLITE_OK==rc && !checkAccess(db, zDb, NULL, NULL,
+			SELINUX_DB_DATABASE, SELINUX_ACCESS) )
+		rc = SQLITE_AUTH;
+	if( SQLITE_OK==rc && !reopen )
+		rc = initialize_attached(db, p);
+	if( SQLITE_OK!=rc )
+		sesqlite_detach(db, zDb);
+
+	return rc;
+}
+
+void sesqlite_detach(
+	sqlite3 *db,
+	const char *zDb
+){
+	struct sesqlite_attached *p = find_attached(db, zDb);
+
+	if( p==NULL )
+		return;
+
+#ifdef SQLITE_DEBUG
+	sesqlite_print("Detaching", zDb, NULL, NULL, ".");
+#endif
+
+	/* the labels of the objects of zDb are forgotten with p->objects,
+	 * another file could be attached with the same name */
+	SESQLITE_HASH_REMOVE(SESQLITE_CONN(db)->attached, zDb, -1);
+	free_attached(p);
+}
+
+void sesqlite_detach_all(
+	sqlite3 *db
+){
+	struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+	sqliteHashElem *elem;
+
+	if( pConn->attached==NULL )
+		return;
+
+	while( (elem = sqliteHashFirst(pConn->attached))!=NULL ){
+		struct sesqlite_attached *p = elem->pData;
+		SESQLITE_HASH_REMOVE(pConn->attached, p->zDb, -1);
+		free_attached(p);
+	}
+	SESQLITE_HASH_CLEAR(pConn->attached);
+	sqlite3_free(pConn->attached);
+	pConn->attached = NULL;
+}
+
+#endif /* !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX) */
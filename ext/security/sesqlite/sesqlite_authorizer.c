@@ -22,36 +22,123 @@
 #if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
 
 #include "sesqlite_authorizer.h"
+#include "sesqlite_attach.h"
 #include "sesqlite_utils.h"
+#include "sesqlite_shm.h"
+#include "sesqlite_init.h"
+#include "sesqlite_stmt.h"
 
 /* Comment the following line to disable the userspace AVC */
 #define USE_AVC
 
 #ifdef USE_AVC
-static SESQLITE_HASH *avc; /* userspace AVC HashMap*/
-static int *avc_deny;
-static int *avc_allow;
-#endif
+/*
+ * The userspace AVC keeps the decisions for the subject of the process,
+ * which is the same for all the connections. The label ids are the small
+ * dense rowids of selinux_id, so the decisions are stored in a matrix with
+ * one row for each label id and one byte for each class and permission,
+ * and the rows are added as the dictionary grows. A byte is AVC_UNKNOWN
+ * until the policy is asked, then AVC_DENY or AVC_ALLOW.
+ */
+#define AVC_UNKNOWN 0
+#define AVC_DENY    1
+#define AVC_ALLOW   2
+#define AVC_NSLOT   ((SELINUX_NELEM_CLASS+1) * SELINUX_NELEM_PERM)
+#define AVC_SLOT(id, tclass, perm) \
+	((id) * AVC_NSLOT + (tclass) * SELINUX_NELEM_PERM + (perm))
+
+static unsigned char *avc;    /* nAvcRow rows of AVC_NSLOT decisions */
+static int nAvcRow;
+static unsigned int avc_generation; /* incremented when the AVC is cleared */
 
-static int vacuum;
+/*
+ * Memo of the last decisions taken by one selinux_check_access call site
+ * while a statement runs, attached to the (constant) class argument with
+ * sqlite3_set_auxdata. The rows of a leaf page usually carry a handful of
+ * distinct labels, so a scan finds the decision for most of its rows in
+ * here, without resolving the class and the permission, translating the
+ * label of an attached database and looking up the AVC again for every row.
+ */
+#define SESQLITE_MEMO_SIZE 4
+
+typedef struct sesqlite_memo {
+	unsigned int generation;        /* avc_generation of the decisions */
+	int tclass;                     /* class code of the call site */
+	int tperm;                      /* permission code of the call site */
+	int nUsed;                      /* slots filled in aId and aRes */
+	int iNext;                      /* next slot to replace */
+	int aId[SESQLITE_MEMO_SIZE];    /* labels, as stored in the tuples */
+	int aRes[SESQLITE_MEMO_SIZE];   /* decisions for the labels in aId */
+} sesqlite_memo;
+
+/*
+ * Returns the decision stored in the AVC for the label id, the class and
+ * the permission: 1 allow, 0 deny, -1 if the decision was never taken.
+ */
+static int avc_lookup(int id, int tclass, int perm){
+    int res = AVC_UNKNOWN;
+
+    assert( tclass<=SELINUX_NELEM_CLASS && perm<SELINUX_NELEM_PERM );
+    sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+    if( id<nAvcRow )
+	res = avc[AVC_SLOT(id, tclass, perm)];
+    sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+    return res - 1;
+}
+
+/*
+ * Stores a decision, adding the rows up to the label id if needed. If the
+ * memory is not available the decision is simply not cached.
+ */
+static void avc_store(int id, int tclass, int perm, int res){
+    sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+    if( id>=nAvcRow ){
+	int nNew = nAvcRow ? nAvcRow : 64;
+	unsigned char *aNew;
+	while( nNew<=id ) nNew *= 2;
+	aNew = sqlite3_realloc(avc, nNew * AVC_NSLOT);
+	if( aNew!=NULL ){
+	    memset(&aNew[nAvcRow * AVC_NSLOT], AVC_UNKNOWN,
+		(nNew - nAvcRow) * AVC_NSLOT);
+	    avc = aNew;
+	    nAvcRow = nNew;
+	}
+    }
+    if( id<nAvcRow )
+	avc[AVC_SLOT(id, tclass, perm)] = ( res==1 ? AVC_ALLOW : AVC_DENY );
+    sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+}
+#endif
 
 int insert_id(sqlite3 *db, char *db_name, char *sec_label){
 
+    struct sesqlite_conn *pConn = SESQLITE_CONN(db);
     int rc = SQLITE_OK;
-    int *value = NULL;
     int rowid = 0;
 
-    SESQLITE_BIHASH_FINDKEY(hash_id, sec_label, -1, (void**) &value, 0);
-	if( value!=NULL )
-		return *value;
-	sqlite3_bind_int(stmt_insert, 1, lookup_security_context(hash_id, db_name, SELINUX_ID));
-	sqlite3_bind_text(stmt_insert, 2, sec_label, strlen(sec_label), SQLITE_TRANSIENT);
+    rowid = sesqlite_label_id(sec_label);
+	if( rowid!=0 )
+		return rowid;
+	sqlite3_bind_int(pConn->stmt_insert, 1, lookup_security_context(hash_id, db_name, SELINUX_ID));
+	sqlite3_bind_text(pConn->stmt_insert, 2, sec_label, strlen(sec_label), SQLITE_TRANSIENT);
+
+	rc = sqlite3_step(pConn->stmt_insert);
+	sqlite3_reset(pConn->stmt_insert);
 
-	rc = sqlite3_step(stmt_insert);
-	rc = sqlite3_reset(stmt_insert);
+	if( rc==SQLITE_DONE ){
+		rowid = sqlite3_last_insert_rowid(db);
+		sesqlite_shm_publish(db, rowid, sec_label);
+	}else{
+		/* added by another process (or connection), not yet known */
+		sqlite3_bind_text(pConn->stmt_select_id, 1, sec_label, -1, SQLITE_TRANSIENT);
+		if( sqlite3_step(pConn->stmt_select_id)==SQLITE_ROW )
+			rowid = sqlite3_column_int(pConn->stmt_select_id, 0);
+		sqlite3_reset(pConn->stmt_select_id);
+		if( rowid==0 )
+			return 0;
+	}
 
-	rowid = sqlite3_last_insert_rowid(db);
-	SESQLITE_BIHASH_INSERT(hash_id, &rowid, sizeof(int), sec_label, -1);
+	sesqlite_label_add(rowid, sec_label);
     return rowid;
 }
 
@@ -76,25 +163,20 @@ int getContext(
     const char *column,
     int tclass
 ){
-    char *key = NULL;
-    int *res = NULL;
 	int id = 0;
 
-    key = make_key(dbname, table, column);
-    assert(key != NULL);
-    SESQLITE_HASH_FIND(hash, key, -1, (void**) &res, 0);
+    id = get_key(db, dbname, table, column);
 
-    if (res != NULL) {
+    if (id != -1) {
 
 #ifdef SQLITE_DEBUG
-		char *after = sqlite3_mprintf("-> %d", *res);
+		char *after = sqlite3_mprintf("-> %d", id);
 		sesqlite_print("Hash hint for", dbname, table, column, after);
-		free(after);
+		sqlite3_free(after);
 #endif
 
-		id = *res;
-
     }else{
+        struct sesqlite_context *contexts = sesqlite_get_contexts();
         security_context_t security_context_new = 0;
         switch (tclass) {
 
@@ -127,7 +209,7 @@ int getContext(
 
         }
         id = insert_id(db, (char*) dbname, security_context_new);
-        SESQLITE_HASH_INSERT(hash, key, -1, &id, sizeof(int));
+        insert_key(db, dbname, table, column, id);
 
 #ifdef SQLITE_DEBUG
         fprintf(stdout, "Compute New Context: db=%s, table=%s, column=%s -> %d\n",
@@ -135,7 +217,6 @@ int getContext(
 #endif
 
     }
-	sqlite3_free(key);
 	return id;
 }
 
@@ -186,22 +267,14 @@ int checkAccess(
     int id = getContext(db, dbname, table, column, tclass);
     assert(id != 0);
 
-    unsigned int key = compress(
-	scon_id,
-	id,
-	access_vector[tclass].c_code,
-	access_vector[tclass].perm[perm].p_code
-    );
-
 #ifdef USE_AVC
-    int *avc_res;
-    SESQLITE_HASH_FIND(avc, NULL, key, (void**) &avc_res, 0);
-    if ( avc_res!=NULL ){
-	res = ( avc_res==avc_allow ); /* Yes, let's just compare the pointers */
-    }else{
+    int c_code = access_vector[tclass].c_code;
+    int p_code = access_vector[tclass].perm[perm].p_code;
+
+    res = avc_lookup(id, c_code, p_code);
+    if ( res==-1 ){
 #endif
-	char *ttcon;
-	SESQLITE_BIHASH_FIND(hash_id, &id, sizeof(int), (void**) &ttcon, 0);
+	char *ttcon = sesqlite_label(id);
 	sqlite3Dequote(ttcon);
 	res = ( 0==selinux_check_access(
 	    scon,
@@ -211,7 +284,7 @@ int checkAccess(
 	    NULL
 	));
 #ifdef USE_AVC
-	SESQLITE_HASH_INSERT(avc, NULL, key, (res==1 ? avc_allow : avc_deny), 0);
+	avc_store(id, c_code, p_code, res);
     }
 #endif
 
@@ -436,23 +509,14 @@ int selinuxAuthorizer(void *pUserData, int type, const char *arg1,
 		break;
 
 	case SQLITE_ATTACH: /* Filename      | NULL            */
-		// TODO change when multiple databases are supported by SeSqlite.
-		//modify access vector policy
-		//UNION selinux_context
-		if ((arg1 != NULL) && (strlen(arg1) != 0)) {
-			fprintf(stderr,
-					"SeSqlite does not support multiple databases yet. [db filename: %s]\n",
-					arg1);
-			rc = SQLITE_DENY;
-		}
+		/* The labels of the attached database are loaded by the schema
+		 * change callback, which also checks the access to the file
+		 * against its own db_database context (see sesqlite_attach). */
 		break;
 
 	case SQLITE_DETACH: /* Database Name | NULL            */
-		// TODO change when multiple databases are supported by SeSqlite.
-		if ((arg1 != NULL) && (strlen(arg1) != 0)) {
-			fprintf(stderr,
-					"SeSqlite does not support multiple databases yet. [db filename: %s]\n",
-					arg1);
+		if (arg1 == NULL || !checkAccess(pdb, arg1, NULL, NULL,
+		SELINUX_DB_DATABASE, SELINUX_ACCESS)) {
 			rc = SQLITE_DENY;
 		}
 		break;
@@ -504,15 +568,65 @@ int selinuxAuthorizer(void *pUserData, int type, const char *arg1,
 	return rc;
 }
 
-int set_vacuum(int type){
-    vacuum = type;
+int set_vacuum(sqlite3 *db, int type){
+    struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+    if( pConn ) pConn->vacuum = type;
     return SQLITE_OK;
 }
 
-int is_vacuum(void){
-    return vacuum;
+int is_vacuum(sqlite3 *db){
+    struct sesqlite_conn *pConn = SESQLITE_CONN(db);
+    return pConn!=NULL && pConn->vacuum;
 }
 
+#ifdef USE_AVC
+/*
+ * Returns the decisions cache of the selinux_check_access call site, creating
+ * it the first time a row reaches the call site. Returns NULL on OOM, in
+ * which case the decision is taken without the cache.
+ */
+static sesqlite_memo *getMemo(
+	sqlite3_context *context,
+	sqlite3_value **argv
+){
+	sesqlite_memo *memo = sqlite3_get_auxdata(context, 1);
+	int i, j;
+
+	if( memo!=NULL ){
+		/* read without the mutex, a stale value only delays the reset */
+		if( memo->generation!=avc_generation ){
+			/* the AVC was cleared while the statement was running */
+			memo->generation = avc_generation;
+			memo->nUsed = 0;
+			memo->iNext = 0;
+		}
+		return memo;
+	}
+
+	memo = sqlite3_malloc(sizeof(sesqlite_memo));
+	if( memo==NULL )
+		return NULL;
+	memset(memo, 0, sizeof(sesqlite_memo));
+	memo->generation = avc_generation;
+
+	for(i = 0; i <= SELINUX_NELEM_CLASS; i++){
+		if( strcmp(access_vector[i].c_name, argv[1]->z)==0 ){
+			for(j = 0; j <= SELINUX_NELEM_PERM; j++){
+				if( strcmp(access_vector[i].perm[j].p_name, argv[2]->z)==0 ){
+					memo->tclass = access_vector[i].c_code;
+					memo->tperm = access_vector[i].perm[j].p_code;
+					break;
+				}
+			}
+		}
+	}
+
+	/* the cache is kept only if the class is a constant of the statement */
+	sqlite3_set_auxdata(context, 1, memo, sqlite3_free);
+	return sqlite3_get_auxdata(context, 1);
+}
+#endif
+
 /*
  * Function invoked when using the SQL function selinux_check_access
  */
@@ -521,46 +635,60 @@ static void selinuxCheckAccessFunction(
 	int argc,
 	sqlite3_value **argv
 ){
+    sqlite3 *db = sqlite3_user_data(context);
     int res = 0;
-    int id = sqlite3_value_int(argv[0]);
+    int label = sqlite3_value_int(argv[0]);
+    int id = label;
     char *ttcon = NULL;
-    assert(id != 0);
 
+#ifdef USE_AVC
+    sesqlite_memo *memo = getMemo(context, argv);
+    int i;
+
+    if( memo!=NULL ){
+	for(i = 0; i < memo->nUsed; i++){
+	    if( memo->aId[i]==label ){
+		res = memo->aRes[i];
+		goto check_done;
+	    }
+	}
+    }
+#endif
 
-	char *zClass = sqlite3_mprintf("%s", argv[1]->z);
-	char *zPerm = sqlite3_mprintf("%s", argv[2]->z);
-	char *zTable = sqlite3_mprintf("%s", argv[3]->z);
+    /* the optional 5th argument is the database the tuple belongs to */
+    if( argc==5 )
+	id = sesqlite_global_id(db, (const char*) sqlite3_value_text(argv[4]), id);
+    if( id==0 ){
+	/* unknown label */
+	sqlite3_result_int(context, 0);
+	return;
+    }
 
 #ifdef USE_AVC
     int tclass = 0;
     int tperm = 0;
 
-    int i = 0, j = 0;
-    for(i = 0; i <= SELINUX_NELEM_CLASS; i++){
-	if(strcmp(access_vector[i].c_name, argv[1]->z) == 0){
-	    for(j = 0; j <= SELINUX_NELEM_PERM; j++){
-		if(strcmp(access_vector[i].perm[j].p_name, argv[2]->z) == 0){
-		    tclass = access_vector[i].c_code;
-		    tperm = access_vector[i].perm[j].p_code;
-		    break;
+    if( memo!=NULL ){
+	tclass = memo->tclass;
+	tperm = memo->tperm;
+    }else{
+	int j;
+	for(i = 0; i <= SELINUX_NELEM_CLASS; i++){
+	    if(strcmp(access_vector[i].c_name, argv[1]->z) == 0){
+		for(j = 0; j <= SELINUX_NELEM_PERM; j++){
+		    if(strcmp(access_vector[i].perm[j].p_name, argv[2]->z) == 0){
+			tclass = access_vector[i].c_code;
+			tperm = access_vector[i].perm[j].p_code;
+			break;
+		     }
 		 }
-	     }
+	    }
 	}
     }
 
-    unsigned int key = compress(
-	scon_id,
-	id,
-	tclass,
-	tperm
-    );
-
-    int *avc_res;
-    SESQLITE_HASH_FIND(avc, NULL, key, (void**) &avc_res, 0);
-    if( avc_res!=NULL ){
-	res = ( avc_res==avc_allow ); /* Yes, let's just compare the pointers */
-    }else{
-	SESQLITE_BIHASH_FIND(hash_id, &id, sizeof(int), (void**) &ttcon, 0);
+    res = avc_lookup(id, tclass, tperm);
+    if( res==-1 ){
+	ttcon = sesqlite_label(id);
 	res = ( 0==selinux_check_access(
 	    scon,       /* source security context */
 	    ttcon,      /* target security context */
@@ -568,10 +696,21 @@ static void selinuxCheckAccessFunction(
 	    argv[2]->z, /* requested permissions string */
 	    NULL        /* auxiliary audit data */
 	));
-	SESQLITE_HASH_INSERT(avc, NULL, key, (res==1 ? avc_allow : avc_deny), 0);
+	avc_store(id, tclass, tperm, res);
+    }
+
+    if( memo!=NULL ){
+	/* round robin: the labels of the previous pages are replaced first */
+	memo->aId[memo->iNext] = label;
+	memo->aRes[memo->iNext] = res;
+	memo->iNext = (memo->iNext + 1) % SESQLITE_MEMO_SIZE;
+	if( memo->nUsed < SESQLITE_MEMO_SIZE )
+	    memo->nUsed++;
     }
+
+check_done:
 #else
-    SESQLITE_BIHASH_FIND(hash_id, &id, sizeof(int), (void**) &ttcon, 0);
+    ttcon = sesqlite_label(id);
     res = ( 0==selinux_check_access(
 	scon,       /* source security context */
 	ttcon, /* target security context */
@@ -582,7 +721,7 @@ static void selinuxCheckAccessFunction(
 #endif
 
 #ifdef SQLITE_DEBUG
-    SESQLITE_BIHASH_FIND(hash_id, &id, sizeof(int), (void**) &ttcon, 0);
+    ttcon = sesqlite_label(id);
     fprintf(stdout, "table: %s, context: %s, action: %s => %s\n", 
 	    argv[3]->z,
 	    ttcon,
@@ -604,15 +743,17 @@ static void selinuxGetconIdFunction(
 ){
     sqlite3 *db = sqlite3_user_data(context);
     if(security_check_context(argv[0]->z) == 0){
-	//TODO get the db name
 	int id = insert_id(db, "main", argv[0]->z);
+	/* getcon_id(label, db) returns the id to store in a table of db */
+	if( argc==2 )
+	    id = sesqlite_local_id(db, (const char*) sqlite3_value_text(argv[1]), id);
 	sqlite3_result_int(context, id);
 
     }else{
 	sqlite3_result_error(context,
 	    "SeSQLite - The requested label is not a valid selinux context.", -1);
     }
-	sqlite3_reset(stmt_select_id);
+	sqlite3_reset(SESQLITE_CONN(db)->stmt_select_id);
 }
 
 /*
@@ -624,17 +765,20 @@ static void selinuxGetconLabelFunction(
     sqlite3_value **argv
 ){
     sqlite3 *db = sqlite3_user_data(context);
+    sqlite3_stmt *stmt = SESQLITE_CONN(db)->stmt_select_label;
     int id = sqlite3_value_int(argv[0]);
-    sqlite3_bind_int(stmt_select_label, 1, id);
+    if( argc==2 )
+	id = sesqlite_global_id(db, (const char*) sqlite3_value_text(argv[1]), id);
+    sqlite3_bind_int(stmt, 1, id);
 
-    if( SQLITE_ROW==sqlite3_step(stmt_select_label) )
+    if( SQLITE_ROW==sqlite3_step(stmt) )
         sqlite3_result_text(context,
-            sqlite3_column_text(stmt_select_label, 0), -1, SQLITE_TRANSIENT);
+            sqlite3_column_text(stmt, 0), -1, SQLITE_TRANSIENT);
     else
         sqlite3_result_error(context,
             "SeSQLite - The requested id is not registered.", -1);
 
-    sqlite3_reset(stmt_select_label);
+    sqlite3_reset(stmt);
 }
 
 int create_security_context_column(
@@ -651,8 +795,6 @@ int create_security_context_column(
 	int iDb = 0;
 	int i = 0;
 	int id = 0;
-	int *res = NULL;
-	char *key = NULL;
 	*zColumn = NULL;
 
 	sqlite3* db = (sqlite3*) pArg;
@@ -694,26 +836,23 @@ int create_security_context_column(
 
 	zType = sqlite3MPrintf(db, SECURITY_CONTEXT_COLUMN_TYPE);
 	pCol->zType = sqlite3MPrintf(db, zType);
+	sqlite3DbFree(db, zType);
 	pCol->affinity = SQLITE_AFF_INTEGER;
 	pCol->colFlags |= COLFLAG_HIDDEN;
 
 	/* Get id */
-	key = make_key(pParse->db->aDb[iDb].zName, p->zName, NULL);
-	SESQLITE_HASH_FIND(hash, key, -1, (void**) &res, 0);
-	if( res!= NULL ){
-		id = *res;
-	}else{
+	id = get_key(db, pParse->db->aDb[iDb].zName, p->zName, NULL);
+	if( id==-1 ){
 		id = lookup_security_label(db,
-			stmt_insert,
+			SESQLITE_CONN(db)->stmt_insert,
 			hash_id,
 			0,
 			pParse->db->aDb[iDb].zName,
 			p->zName,
 			NULL
 		);
-		SESQLITE_HASH_INSERT(hash, key, -1, &id, sizeof(int));
+		insert_key(db, pParse->db->aDb[iDb].zName, p->zName, NULL, id);
 	}
-	sqlite3_free(key);
 
 	sqlite3NestedParse(pParse,
 		"INSERT INTO %Q.%s (security_context, security_label, db, name) VALUES(\
@@ -721,11 +860,12 @@ int create_security_context_column(
 		'%s',\
 		'%s')",
 		pParse->db->aDb[iDb].zName, SELINUX_CONTEXT,
-		lookup_security_context(hash_id, 
-			pParse->db->aDb[iDb].zName, 
-			SELINUX_CONTEXT),
-		id,
-		pParse->db->aDb[iDb].zName, 
+		sesqlite_local_id(db, pParse->db->aDb[iDb].zName,
+			lookup_security_context(hash_id, 
+				pParse->db->aDb[iDb].zName, 
+				SELINUX_CONTEXT)),
+		sesqlite_local_id(db, pParse->db->aDb[iDb].zName, id),
+		sesqlite_stored_db(db, pParse->db->aDb[iDb].zName), 
 		p->zName);
 	sqlite3ChangeCookie(pParse, iDb);
 
@@ -735,22 +875,18 @@ int create_security_context_column(
 	for (iCol = 0; iCol < p->nCol; iCol++) {
 
 		/* Get id */
-		key = make_key(pParse->db->aDb[iDb].zName, p->zName, p->aCol[iCol].zName);
-		SESQLITE_HASH_FIND(hash, key, -1, (void**) &res, 0);
-		if( res!= NULL ){
-			id = *res;
-		}else{
+		id = get_key(db, pParse->db->aDb[iDb].zName, p->zName, p->aCol[iCol].zName);
+		if( id==-1 ){
 			id = lookup_security_label(db,
-				stmt_insert,
+				SESQLITE_CONN(db)->stmt_insert,
 				hash_id,
 				1,
 				pParse->db->aDb[iDb].zName,
 				p->zName,
 				p->aCol[iCol].zName
 			);
-			SESQLITE_HASH_INSERT(hash, key, -1, &id, sizeof(int));
+			insert_key(db, pParse->db->aDb[iDb].zName, p->zName, p->aCol[iCol].zName, id);
 		}
-		sqlite3_free(key);
 
 		sqlite3NestedParse(pParse,
 			"INSERT INTO %Q.%s(security_context, security_label, db, name, column) VALUES(\
@@ -759,11 +895,12 @@ int create_security_context_column(
 			'%s',\
 			'%s')",
 			pParse->db->aDb[iDb].zName, SELINUX_CONTEXT,
-			lookup_security_context(hash_id, 
-				pParse->db->aDb[iDb].zName, 
-				SELINUX_CONTEXT),
-			id,
-			pParse->db->aDb[iDb].zName, 
+			sesqlite_local_id(db, pParse->db->aDb[iDb].zName,
+				lookup_security_context(hash_id, 
+					pParse->db->aDb[iDb].zName, 
+					SELINUX_CONTEXT)),
+			sesqlite_local_id(db, pParse->db->aDb[iDb].zName, id),
+			sesqlite_stored_db(db, pParse->db->aDb[iDb].zName), 
 			p->zName, 
 			p->aCol[iCol].zName);
 
@@ -772,22 +909,18 @@ int create_security_context_column(
 
 	if(HasRowid(p)){
 		/* Get id */
-		key = make_key(pParse->db->aDb[iDb].zName, p->zName, "ROWID");
-		SESQLITE_HASH_FIND(hash, key, -1, (void**) &res, 0);
-		if( res!= NULL ){
-			id = *res;
-		}else{
+		id = get_key(db, pParse->db->aDb[iDb].zName, p->zName, "ROWID");
+		if( id==-1 ){
 			id = lookup_security_label(db,
-				stmt_insert,
+				SESQLITE_CONN(db)->stmt_insert,
 				hash_id,
 				1,
 				pParse->db->aDb[iDb].zName,
 				p->zName,
 				"ROWID"
 			);
-			SESQLITE_HASH_INSERT(hash, key, -1, &id, sizeof(int));
+			insert_key(db, pParse->db->aDb[iDb].zName, p->zName, "ROWID", id);
 		}
-		sqlite3_free(key);
 
 		sqlite3NestedParse(pParse,
 			"INSERT INTO %Q.%s(security_context, security_label, db, name, column) VALUES(\
@@ -796,11 +929,12 @@ int create_security_context_column(
 			'%s',\
 			'%s')",
 			pParse->db->aDb[iDb].zName, SELINUX_CONTEXT,
-			lookup_security_context(hash_id, 
-				pParse->db->aDb[iDb].zName, 
-				SELINUX_CONTEXT),
-			id,
-			pParse->db->aDb[iDb].zName, p->zName, "ROWID");
+			sesqlite_local_id(db, pParse->db->aDb[iDb].zName,
+				lookup_security_context(hash_id, 
+					pParse->db->aDb[iDb].zName, 
+					SELINUX_CONTEXT)),
+			sesqlite_local_id(db, pParse->db->aDb[iDb].zName, id),
+			sesqlite_stored_db(db, pParse->db->aDb[iDb].zName), p->zName, "ROWID");
 
 		sqlite3ChangeCookie(pParse, iDb);
 	}
@@ -827,13 +961,13 @@ static int selinux_schemachange_callback(
     case SQLITE_SCHEMA_DROP_TABLE:
 	sqlite3NestedParse(pParse,
 	    "DELETE FROM %s.%s WHERE db = '%s' AND name = '%s'",
-	    zDb, SELINUX_CONTEXT, zDb, zTable);
+	    zDb, SELINUX_CONTEXT, sesqlite_stored_db(db, zDb), zTable);
 	break;
 
     case SQLITE_SCHEMA_ALTER_RENAME:
 	sqlite3NestedParse(pParse,
 	    "UPDATE %s.%s SET name = '%s' WHERE db = '%s' AND name = '%s'",
-	    zDb, SELINUX_CONTEXT, zTable, zDb, arg1);
+	    zDb, SELINUX_CONTEXT, zTable, sesqlite_stored_db(db, zDb), arg1);
 	break;
 
     case SQLITE_SCHEMA_ALTER_ADD:
@@ -844,17 +978,30 @@ static int selinux_schemachange_callback(
 	    '%s',\
 	    '%s')",
     	  zDb, SELINUX_CONTEXT,
-	  lookup_security_context(hash_id, 
-	      (char *) zDb, 
-	      SELINUX_CONTEXT),
-	  lookup_security_label(db, 
-	      stmt_insert, 
-	      hash_id, 
-	      1, 
-	      (char *) zDb, 
-	      (char *) zTable, 
-	      arg1),
-    	  (char *) zDb, (char *) zTable, arg1);
+	  sesqlite_local_id(db, zDb,
+	      lookup_security_context(hash_id, 
+		  (char *) zDb, 
+		  SELINUX_CONTEXT)),
+	  sesqlite_local_id(db, zDb,
+	      lookup_security_label(db, 
+		  SESQLITE_CONN(db)->stmt_insert, 
+		  hash_id, 
+		  1, 
+		  (char *) zDb, 
+		  (char *) zTable, 
+		  arg1)),
+    	  sesqlite_stored_db(db, zDb), (char *) zTable, arg1);
+	break;
+
+    case SQLITE_SCHEMA_ATTACH:
+	/* the decisions cached by name (e.g. the scan guards) may refer to
+	 * a different database attached with the same name */
+	sesqlite_clearavc();
+	return sesqlite_attach(db, zDb);
+
+    case SQLITE_SCHEMA_DETACH:
+	sesqlite_clearavc();
+	sesqlite_detach(db, zDb);
 	break;
     }
 
@@ -863,49 +1010,82 @@ static int selinux_schemachange_callback(
 
 void sesqlite_clearavc(){
 #ifdef USE_AVC
-    SESQLITE_HASH_CLEAR(avc);
+    sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_AVC));
+    if( avc!=NULL )
+	memset(avc, AVC_UNKNOWN, nAvcRow * AVC_NSLOT);
+    avc_generation++;
+    sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_AVC));
 #endif
+    /* the statements kept by the cache were checked with the old decisions */
+    sesqlite_policy_changed();
 }
 
-int selinux_commit_callback(void *pArg){
+unsigned int sesqlite_avc_generation(){
 #ifdef USE_AVC
-#ifdef SQLITE_DEBUG
-    fprintf(stdout, "Cleaning AVC after commit\n");
+    return avc_generation;
+#else
+    return 0;
 #endif
-    sesqlite_clearavc();
+}
+
+int sesqlite_vtab_labeled(sqlite3 *db){
+    return db->xAddExtraColumn!=NULL && !is_vacuum(db);
+}
+
+int sesqlite_tuple_visible(sqlite3 *db, const char *zDb, int label){
+    int res = 0;
+    int id = sesqlite_global_id(db, zDb, label);
+    char *ttcon = NULL;
+
+    if( id==0 )
+	return 0; /* unknown label */
+
+#ifdef USE_AVC
+    res = avc_lookup(id, SELINUX_DB_TUPLE, SELINUX_SELECT);
+    if( res!=-1 )
+	return res;
+#endif
+
+    ttcon = sesqlite_label(id);
+    res = ( 0==selinux_check_access(
+	scon,
+	ttcon,
+	access_vector[SELINUX_DB_TUPLE].c_name,
+	"select",
+	NULL
+    ));
+
+#ifdef USE_AVC
+    avc_store(id, SELINUX_DB_TUPLE, SELINUX_SELECT, res);
 #endif
+    return res;
+}
+
+int selinux_commit_callback(void *pArg){
+    sqlite3 *db = (sqlite3*) pArg;
+    sesqlite_shm_commit(db);
+#if defined(USE_AVC) && defined(SQLITE_DEBUG)
+    fprintf(stdout, "Checking the policy after commit\n");
+#endif
+    /* a commit alone does not change the decisions, only a new policy does */
+    sesqlite_policy_check();
     return 0;
 }
 
 void selinux_rollback_callback(void *pArg){
-#ifdef USE_AVC
-#ifdef SQLITE_DEBUG
-    fprintf(stdout, "Cleaning AVC after rollback\n");
-#endif
-    sesqlite_clearavc();
+    sqlite3 *db = (sqlite3*) pArg;
+    sesqlite_shm_rollback(db);
+#if defined(USE_AVC) && defined(SQLITE_DEBUG)
+    fprintf(stdout, "Checking the policy after rollback\n");
 #endif
+    /* a rollback alone does not change the decisions, only a new policy does */
+    sesqlite_policy_check();
 }
 
 int initialize_authorizer(sqlite3 *db){
 
     int rc = SQLITE_OK;
 
-#ifdef USE_AVC
-    /* initialize avc cache */
-    avc = sqlite3_malloc(sizeof(SESQLITE_HASH));
-    avc_allow = sqlite3_malloc(sizeof(int));
-    avc_deny  = sqlite3_malloc(sizeof(int));
-    if( !avc || !avc_allow || !avc_deny ){
-	return SQLITE_NOMEM;
-    }else{
-	/* copyKey=0 because it is ineffective for SESQLITE_HASH_INT,
-	 * copyValue=0 because we DO want to compare by pointers. */
-	SESQLITE_HASH_INIT(avc, SESQLITE_HASH_INT, 0, 0);
-	*avc_allow = 0;
-	*avc_deny = -1;
-    }
-#endif
-
     rc =sqlite3_set_add_extra_column(db, create_security_context_column, db);
     if (rc != SQLITE_OK)
 	return rc;
@@ -914,14 +1094,21 @@ int initialize_authorizer(sqlite3 *db){
     sqlite3_schemachange_hook(db, selinux_schemachange_callback, db);
 
     /* set the commit callback */
-    sqlite3_commit_hook(db, selinux_commit_callback, 0);
+    sqlite3_commit_hook(db, selinux_commit_callback, db);
 
     /* set the rollback callback */
-    sqlite3_rollback_hook(db, selinux_rollback_callback, 0);
+    sqlite3_rollback_hook(db, selinux_rollback_callback, db);
 
     /* create the SQL function selinux_check_access */
     rc = sqlite3_create_function(db, "selinux_check_access", 4,
-	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, 0, selinuxCheckAccessFunction,
+	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxCheckAccessFunction,
+	0, 0);
+    if (rc != SQLITE_OK)
+	return rc;
+
+    /* selinux_check_access on a tuple of a given (possibly attached) db */
+    rc = sqlite3_create_function(db, "selinux_check_access", 5,
+	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxCheckAccessFunction,
 	0, 0);
     if (rc != SQLITE_OK)
 	return rc;
@@ -933,13 +1120,27 @@ int initialize_authorizer(sqlite3 *db){
     if (rc != SQLITE_OK)
 	return rc;
 
-    /* create the SQL function getcon_id */
+    /* getcon_id(label, db) for tables of an attached db */
+    rc = sqlite3_create_function(db, "getcon_id", 2,
+	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxGetconIdFunction,
+	0, 0);
+    if (rc != SQLITE_OK)
+	return rc;
+
+    /* create the SQL function getcon_label */
     rc = sqlite3_create_function(db, "getcon_label", 1,
 	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxGetconLabelFunction,
 	0, 0);
     if (rc != SQLITE_OK)
 	return rc;
 
+    /* getcon_label(id, db) for tables of an attached db */
+    rc = sqlite3_create_function(db, "getcon_label", 2,
+	SQLITE_UTF8 /* | SQLITE_DETERMINISTIC */, db, selinuxGetconLabelFunction,
+	0, 0);
+    if (rc != SQLITE_OK)
+	return rc;
+
     /* set the authorizer */
     rc = sqlite3_set_authorizer(db, selinuxAuthorizer, db);
 
@@ -20,6 +20,7 @@
 #if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
 
 #include "sesqlite.h"
+#include "sesqlite_shm.h"
 
 /**
  * Compute the default context to give to a table or a column
@@ -74,15 +75,19 @@ int compute_sql_context(
 int lookup_security_context(SESQLITE_BIHASH *hash, char *db_name, char *tbl_name){
 
     int *id = NULL;
+    int res = 0;
     char *sec_context = NULL;
 
     compute_sql_context(0, db_name, tbl_name, NULL, 
-	    contexts->tuple_context, &sec_context);
+	    sesqlite_get_contexts()->tuple_context, &sec_context);
 
+    sqlite3_mutex_enter(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
     SESQLITE_BIHASH_FINDKEY(hash, sec_context, -1, (void**) &id, 0);
     assert(id != NULL); /* check if SELinux can compute a security context */
+    res = *id;
+    sqlite3_mutex_leave(sesqlite_mutex(SESQLITE_MUTEX_LABELS));
 
-    return *id;
+    return res;
 }
 
 int lookup_security_label(sqlite3 *db, 
@@ -95,16 +100,16 @@ int lookup_security_label(sqlite3 *db,
 
     int rc = SQLITE_OK;
     int rowid = 0;
-    int *id = NULL;
     char *context = NULL;
+    struct sesqlite_context *sc = sesqlite_get_contexts();
 
 	compute_sql_context(type, db_name, tbl_name, col_name,
-	    type ? contexts->column_context : contexts->table_context, &context);
+	    type ? sc->column_context : sc->table_context, &context);
 
     assert(context != NULL);
-    SESQLITE_BIHASH_FINDKEY(hash, context, -1, (void**) &id, 0);
-    if( id!=NULL )
-      return *id;
+    rowid = sesqlite_label_id(context);
+    if( rowid!=0 )
+      return rowid;
 
 	sqlite3_bind_int(stmt, 1, lookup_security_context(hash, db_name, SELINUX_ID));
 	sqlite3_bind_text(stmt, 2, context, strlen(context),
@@ -114,7 +119,8 @@ int lookup_security_label(sqlite3 *db,
 	rc = sqlite3_reset(stmt);
 
 	rowid = sqlite3_last_insert_rowid(db);
-	SESQLITE_BIHASH_INSERT(hash, &rowid, sizeof(int), context, -1);
+	sesqlite_label_add(rowid, context);
+	sesqlite_shm_publish(db, rowid, context);
     return rowid;
 }
 
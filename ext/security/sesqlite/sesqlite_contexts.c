@@ -22,6 +22,8 @@
 #if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
 
 #include "sesqlite_contexts.h"
+#include "sesqlite_attach.h"
+#include "sesqlite_shm.h"
 
 /*
  * Function to insert a new_node in a list. Note that this
@@ -62,7 +64,7 @@ void free_sesqlite_context_list(
 		sqlite3_free(head->security_context);
 		temp = head;
 		head = head->next;
-		free(temp);
+		sqlite3_free(temp);
 	}
 }
 
@@ -73,8 +75,9 @@ void free_sesqlite_context(
 	free_sesqlite_context_list(sc->db_context);
 	free_sesqlite_context_list(sc->table_context);
 	free_sesqlite_context_list(sc->column_context);
+	free_sesqlite_context_list(sc->view_context);
 	free_sesqlite_context_list(sc->tuple_context);
-	free(sc);
+	sqlite3_free(sc);
 }
 
 struct sesqlite_context *read_sesqlite_context(
@@ -142,13 +145,13 @@ struct sesqlite_context *read_sesqlite_context(
 			new->next = NULL;
 
 			token = strtok_r(NULL, " \t", &rest);
-			new->origin = sqlite3MPrintf(db, "%s", token);
+			new->origin = sqlite3_mprintf("%s", token);
 			char *con = strtok_r(NULL, " \t", &rest);
-			new->security_context = sqlite3MPrintf(db, "%s", con);
+			new->security_context = sqlite3_mprintf("%s", con);
 
-			new->fparam = sqlite3MPrintf(db, "%s", token);
-			new->sparam = sqlite3MPrintf(db, "%s", token);
-			new->tparam = sqlite3MPrintf(db, "%s", token);
+			new->fparam = sqlite3_mprintf("%s", token);
+			new->sparam = sqlite3_mprintf("%s", token);
+			new->tparam = sqlite3_mprintf("%s", token);
 
 			sorted_insert(&sc->db_context, new);
 			ndb_line++;
@@ -160,14 +163,14 @@ struct sesqlite_context *read_sesqlite_context(
 			new->next = NULL;
 
 			token = strtok_r(NULL, " \t", &rest);
-			new->origin = sqlite3MPrintf(db, "%s", token);
+			new->origin = sqlite3_mprintf("%s", token);
 			char *con = strtok_r(NULL, " \t", &rest);
-			new->security_context = sqlite3MPrintf(db, "%s", con);
+			new->security_context = sqlite3_mprintf("%s", con);
 
 			stoken = strtok_r(token, ".", &srest);
-			new->fparam = sqlite3MPrintf(db, "%s", stoken);
+			new->fparam = sqlite3_mprintf("%s", stoken);
 			stoken = strtok_r(NULL, ".", &srest);
-			new->sparam = sqlite3MPrintf(db, "%s", stoken);
+			new->sparam = sqlite3_mprintf("%s", stoken);
 			new->tparam = NULL;
 
 			sorted_insert(&sc->table_context, new);
@@ -180,14 +183,14 @@ struct sesqlite_context *read_sesqlite_context(
 			new->next = NULL;
 
 			token = strtok_r(NULL, " \t", &rest);
-			new->origin = sqlite3MPrintf(db, "%s", token);
+			new->origin = sqlite3_mprintf("%s", token);
 			char *con = strtok_r(NULL, " \t", &rest);
-			new->security_context = sqlite3MPrintf(db, "%s", con);
+			new->security_context = sqlite3_mprintf("%s", con);
 
 			stoken = strtok_r(token, ".", &srest);
-			new->fparam = sqlite3MPrintf(db, "%s", stoken);
+			new->fparam = sqlite3_mprintf("%s", stoken);
 			stoken = strtok_r(NULL, ".", &srest);
-			new->sparam = sqlite3MPrintf(db, "%s", stoken);
+			new->sparam = sqlite3_mprintf("%s", stoken);
 			new->tparam = NULL;
 
 			sorted_insert(&sc->view_context, new);
@@ -200,16 +203,16 @@ struct sesqlite_context *read_sesqlite_context(
 			new->next = NULL;
 
 			token = strtok_r(NULL, " \t", &rest);
-			new->origin = sqlite3MPrintf(db, "%s", token);
+			new->origin = sqlite3_mprintf("%s", token);
 			char *con = strtok_r(NULL, " \t", &rest);
-			new->security_context = sqlite3MPrintf(db, "%s", con);
+			new->security_context = sqlite3_mprintf("%s", con);
 
 			stoken = strtok_r(token, ".", &srest);
-			new->fparam = sqlite3MPrintf(db, "%s", stoken);
+			new->fparam = sqlite3_mprintf("%s", stoken);
 			stoken = strtok_r(NULL, ".", &srest);
-			new->sparam = sqlite3MPrintf(db, "%s", stoken);
+			new->sparam = sqlite3_mprintf("%s", stoken);
 			stoken = strtok_r(NULL, ".", &srest);
-			new->tparam = sqlite3MPrintf(db, "%s", stoken);
+			new->tparam = sqlite3_mprintf("%s", stoken);
 
 			sorted_insert(&sc->column_context, new);
 			ncolumn_line++;
@@ -221,14 +224,14 @@ struct sesqlite_context *read_sesqlite_context(
 			new->next = NULL;
 
 			token = strtok_r(NULL, " \t", &rest);
-			new->origin = sqlite3MPrintf(db, "%s", token);
+			new->origin = sqlite3_mprintf("%s", token);
 			char *con = strtok_r(NULL, " \t", &rest);
-			new->security_context = sqlite3MPrintf(db, "%s", con);
+			new->security_context = sqlite3_mprintf("%s", con);
 			
 			stoken = strtok_r(token, ".", &srest);
-			new->fparam = sqlite3MPrintf(db, "%s", stoken);
+			new->fparam = sqlite3_mprintf("%s", stoken);
 			stoken = strtok_r(NULL, ".", &srest);
-			new->sparam = sqlite3MPrintf(db, "%s", stoken);
+			new->sparam = sqlite3_mprintf("%s", stoken);
 			new->tparam = NULL;
 
 			sorted_insert(&sc->tuple_context, new);
@@ -265,13 +268,154 @@ int filter_accepts(
 	return ( sqlite3StrNICmp(filter, name, wildcard)==0 );
 }
 
+/*
+ * An object labeled by reload_sesqlite_contexts, stored in the hashmaps
+ * only after its label was written.
+ */
+struct sesqlite_labeled {
+	char *dbName;
+	char *tblName;                  /* NULL for a database */
+	char *colName;                  /* NULL for a database or a table */
+	int id;                         /* the new label */
+	struct sesqlite_labeled *next;
+};
+
+static int labeled_add(
+	struct sesqlite_labeled **ppLabeled,
+	const char *dbName,
+	const char *tblName,
+	const char *colName,
+	int id
+){
+	struct sesqlite_labeled *p;
+	int nDb = strlen(dbName) + 1;
+	int nTbl = tblName ? strlen(tblName) + 1 : 0;
+	int nCol = colName ? strlen(colName) + 1 : 0;
+
+	p = sqlite3_malloc(sizeof(*p) + nDb + nTbl + nCol);
+	if( !p ) return SQLITE_NOMEM;
+
+	p->dbName = (char*) &p[1];
+	memcpy(p->dbName, dbName, nDb);
+	p->tblName = tblName ? memcpy(&p->dbName[nDb], tblName, nTbl) : NULL;
+	p->colName = colName ? memcpy(&p->dbName[nDb + nTbl], colName, nCol) : NULL;
+	p->id = id;
+	p->next = *ppLabeled;
+	*ppLabeled = p;
+	return SQLITE_OK;
+}
+
+void free_labeled_objects(
+	struct sesqlite_labeled *pLabeled
+){
+	struct sesqlite_labeled *pNext;
+
+	for( ; pLabeled; pLabeled = pNext ){
+		pNext = pLabeled->next;
+		sqlite3_free(pLabeled);
+	}
+}
+
+void store_labeled_objects(
+	sqlite3 *db,
+	struct sesqlite_labeled *pLabeled
+){
+	struct sesqlite_labeled *p;
+
+	for( p = pLabeled; p; p = p->next )
+		insert_key(db, p->dbName, p->tblName, p->colName, p->id);
+	free_labeled_objects(pLabeled);
+}
+
+/*
+ * Store the context of a db/table/column in the selinux_context table of
+ * the database it belongs to, translating the ids if it is attached.
+ * Returns SQLITE_OK or the error of the INSERT.
+ */
+static int write_context(
+	sqlite3 *db,
+	sqlite3_stmt *stmt,
+	const char *dbName,
+	const char *tblName,
+	const char *colName,
+	int sec_con_id,
+	int sec_label_id
+){
+	int rc = SQLITE_OK;
+
+	stmt = sesqlite_context_stmt(db, dbName, stmt);
+
+	sqlite3_bind_int( stmt, 1, sesqlite_local_id(db, dbName, sec_con_id));
+	sqlite3_bind_int( stmt, 2, sesqlite_local_id(db, dbName, sec_label_id));
+	sqlite3_bind_text(stmt, 3, sesqlite_stored_db(db, dbName), -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text(stmt, 4, tblName ? tblName : "", -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text(stmt, 5, colName ? colName : "", -1, SQLITE_TRANSIENT);
+
+	rc = sqlite3_step(stmt);
+	if( SQLITE_DONE==rc )
+		rc = SQLITE_OK;
+	sqlite3_reset(stmt);
+
+	return rc;
+}
+
+/*
+ * Label a db/table/column with the rules in con. If old is not NULL the
+ * label is written only if it differs from the one the object has now,
+ * which is read from the hashmap without touching the database.
+ * Once written, the object is added to *ppLabeled and *pnCount (if not
+ * NULL) is incremented. Returns SQLITE_OK or the error of the write.
+ */
+static int label_object(
+	sqlite3 *db,
+	sqlite3_stmt *stmt,
+	struct sesqlite_context *sc,
+	struct sesqlite_context *old,
+	int isColumn,
+	struct sesqlite_context_element *con,
+	char *dbName,
+	char *tblName,
+	char *colName,
+	int sec_con_id,
+	struct sesqlite_labeled **ppLabeled,
+	int *pnCount
+){
+	char *sec_label = NULL;
+	int id = 0;
+	int sec_label_id = 0;
+	int rc = SQLITE_OK;
+
+	if( old ){
+		compute_sql_context(isColumn, dbName, tblName, colName, con, &sec_label);
+		if( sec_label!=NULL )
+			id = sesqlite_label_id(sec_label);
+		if( id!=0 && id==get_key(db, dbName, tblName, colName) )
+			return SQLITE_OK;
+	}
+
+	sec_label_id = insert_context(db, isColumn, dbName, tblName, colName,
+		con, sc->tuple_context);
+
+	rc = write_context(db, stmt, dbName, tblName, colName,
+		sec_con_id, sec_label_id);
+	if( SQLITE_OK==rc )
+		rc = labeled_add(ppLabeled, dbName, tblName, colName, sec_label_id);
+	if( SQLITE_OK==rc && pnCount )
+		(*pnCount)++;
+
+	return rc;
+}
+
 int reload_sesqlite_contexts(
 	sqlite3 *db,                  /* the database connection */
 	sqlite3_stmt *stmt,           /* the INSERT OR REPLACE statement */
 	struct sesqlite_context *sc,  /* the sesqlite_context */
+	struct sesqlite_context *old, /* the previous one or NULL */
 	char *dbFilter,               /* the db filter or NULL as wildcard */
 	char *tblFilter,              /* the table filter or NULL as wildcard */
-	char *colFilter               /* the column filter or NULL as wildcard */
+	char *colFilter,              /* the column filter or NULL as wildcard */
+	int *pnCount,                 /* OUT: number of labels written or NULL */
+	struct sesqlite_labeled **ppLabeled /* OUT: the labeled objects or NULL */
 ){
 	/* The following code is used to scan all the databases, tables
 	 * and columns directly from the structs used to store the schema */
@@ -283,11 +427,13 @@ int reload_sesqlite_contexts(
 	char *dbName = NULL;
 	char *tblName = NULL;
 	char *colName = NULL;
-	char *result = NULL;
-	int rc = SQLITE_OK;
+	char *sec_con = NULL;
+	char *old_sec_con = NULL;
+	struct sesqlite_context *prev = NULL;
+	struct sesqlite_labeled *pLabeled = NULL;
 	int count = 0;
+	int rc = SQLITE_OK;
 
-	int sec_label_id = 0;
 	int sec_con_id = 0;
 
 	/* Scan the databases */
@@ -301,25 +447,25 @@ int reload_sesqlite_contexts(
 		if( !filter_accepts(dbFilter, dbName) )
 			continue;
 
-			sec_label_id = insert_context(db, 0, dbName, NULL, NULL,
-				sc->db_context, sc->tuple_context);
-
-			sec_con_id = insert_context(db, 0, dbName, SELINUX_CONTEXT, NULL,
-				sc->tuple_context, sc->tuple_context);
-
-			insert_key(db, dbName, NULL, NULL, sec_label_id);
-
-			sqlite3_bind_int( stmt, 1, sec_con_id);
-			sqlite3_bind_int( stmt, 2, sec_label_id);
-			sqlite3_bind_text(stmt, 3, dbName,  -1, SQLITE_TRANSIENT);
-			sqlite3_bind_text(stmt, 4, "",      -1, SQLITE_TRANSIENT);
-			sqlite3_bind_text(stmt, 5, "",      -1, SQLITE_TRANSIENT);
-
-			rc = sqlite3_step(stmt);
-			assert( rc==SQLITE_DONE );
+		/* the label of the tuples of selinux_context, when it changes
+		 * every row of the database has to be written again */
+		sec_con_id = insert_context(db, 0, dbName, SELINUX_CONTEXT, NULL,
+			sc->tuple_context, sc->tuple_context);
+
+		prev = old;
+		if( old ){
+			compute_sql_context(0, dbName, SELINUX_CONTEXT, NULL,
+				sc->tuple_context, &sec_con);
+			compute_sql_context(0, dbName, SELINUX_CONTEXT, NULL,
+				old->tuple_context, &old_sec_con);
+			if( sec_con==NULL || old_sec_con==NULL
+			    || strcmp(sec_con, old_sec_con)!=0 )
+				prev = NULL;
+		}
 
-			rc = sqlite3_reset(stmt);
-			assert( rc==SQLITE_OK );
+		rc = label_object(db, stmt, sc, prev, 0, sc->db_context,
+			dbName, NULL, NULL, sec_con_id, &pLabeled, NULL);
+		if( SQLITE_OK!=rc ) goto reload_done;
 
 		/* Scan the tables */
 		pTbls = &db->aDb[i].pSchema->tblHash;
@@ -334,26 +480,9 @@ int reload_sesqlite_contexts(
 			if( !filter_accepts(tblFilter, tblName) )
 				continue;
 
-			sec_label_id = insert_context(db, 0, dbName, tblName, NULL,
-				sc->table_context, sc->tuple_context);
-
-			sec_con_id = insert_context(db, 0, dbName, SELINUX_CONTEXT, NULL,
-				sc->tuple_context, sc->tuple_context);
-
-			insert_key(db, dbName, tblName, NULL, sec_label_id);
-
-			sqlite3_bind_int( stmt, 1, sec_con_id);
-			sqlite3_bind_int( stmt, 2, sec_label_id);
-			sqlite3_bind_text(stmt, 3, dbName,  -1, SQLITE_TRANSIENT);
-			sqlite3_bind_text(stmt, 4, tblName, -1, SQLITE_TRANSIENT);
-			sqlite3_bind_text(stmt, 5, "",      -1, SQLITE_TRANSIENT);
-
-			rc = sqlite3_step(stmt);
-			assert( rc==SQLITE_DONE );
-
-			rc = sqlite3_reset(stmt);
-			assert( rc==SQLITE_OK );
-			++count;
+			rc = label_object(db, stmt, sc, prev, 0, sc->table_context,
+				dbName, tblName, NULL, sec_con_id, &pLabeled, &count);
+			if( SQLITE_OK!=rc ) goto reload_done;
 
 			/* Scan the columns */
 			Column *pCol;
@@ -364,55 +493,32 @@ int reload_sesqlite_contexts(
 				if( !filter_accepts(colFilter, colName) )
 					continue;
 
-				sec_label_id = insert_context(db, 1, dbName, tblName, colName,
-					sc->column_context, sc->tuple_context);
-
-				sec_con_id = insert_context(db, 0, dbName, SELINUX_CONTEXT, NULL,
-					sc->tuple_context, sc->tuple_context);
-
-				insert_key(db, dbName, tblName, colName, sec_label_id);
-
-				sqlite3_bind_int( stmt, 1, sec_con_id);
-				sqlite3_bind_int( stmt, 2, sec_label_id);
-				sqlite3_bind_text(stmt, 3, dbName,  -1, SQLITE_TRANSIENT);
-				sqlite3_bind_text(stmt, 4, tblName, -1, SQLITE_TRANSIENT);
-				sqlite3_bind_text(stmt, 5, colName, -1, SQLITE_TRANSIENT);
-
-				rc = sqlite3_step(stmt);
-				assert( rc==SQLITE_DONE );
-
-				rc = sqlite3_reset(stmt);
-				assert( rc==SQLITE_OK );
-				++count;
+				rc = label_object(db, stmt, sc, prev, 1, sc->column_context,
+					dbName, tblName, colName, sec_con_id, &pLabeled, &count);
+				if( SQLITE_OK!=rc ) goto reload_done;
 			}
 
 			/* assign security context to rowid if exists */
 			if( HasRowid(pTab) && filter_accepts(colFilter, "ROWID") ){
-				sec_label_id = insert_context(db, 1, dbName, tblName, "ROWID",
-					sc->column_context, sc->tuple_context);
-
-				sec_con_id = insert_context(db, 0, dbName, SELINUX_CONTEXT, NULL,
-					sc->tuple_context, sc->tuple_context);
-
-				insert_key(db, dbName, tblName, "ROWID", sec_label_id);
-
-				sqlite3_bind_int( stmt, 1, sec_con_id);
-				sqlite3_bind_int( stmt, 2, sec_label_id);
-				sqlite3_bind_text(stmt, 3, dbName,  -1, SQLITE_TRANSIENT);
-				sqlite3_bind_text(stmt, 4, tblName, -1, SQLITE_TRANSIENT);
-				sqlite3_bind_text(stmt, 5, "ROWID", -1, SQLITE_TRANSIENT);
-
-				rc = sqlite3_step(stmt);
-				assert( rc==SQLITE_DONE );
-
-				rc = sqlite3_reset(stmt);
-				assert( rc==SQLITE_OK );
-				++count;
+				rc = label_object(db, stmt, sc, prev, 1, sc->column_context,
+					dbName, tblName, "ROWID", sec_con_id, &pLabeled, &count);
+				if( SQLITE_OK!=rc ) goto reload_done;
 			}
 		}
 	}
 
-	return count;
+reload_done:
+	if( SQLITE_OK!=rc ){
+		free_labeled_objects(pLabeled);
+		count = 0;
+	}else if( ppLabeled ){
+		*ppLabeled = pLabeled;
+	}else{
+		store_labeled_objects(db, pLabeled);
+	}
+
+	if( pnCount ) *pnCount = count;
+	return rc;
 }
 
 int load_sesqlite_contexts(
@@ -420,7 +526,8 @@ int load_sesqlite_contexts(
 	sqlite3_stmt *stmt,            /* the INSERT OR REPLACE statement */
 	struct sesqlite_context *sc    /* the sesqlite_context */
 ){
-	return reload_sesqlite_contexts(db, stmt, sc, "*", "*", "*");
+	return reload_sesqlite_contexts(db, stmt, sc, NULL, "*", "*", "*",
+		NULL, NULL);
 }
 
 #endif
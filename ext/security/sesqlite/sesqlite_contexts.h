@@ -19,6 +19,9 @@
 
 #include "sesqlite.h"
 
+/* An object labeled by reload_sesqlite_contexts */
+struct sesqlite_labeled;
+
 /*
  * Read the sesqlite_contexts file and return a struct
  * representing it.
@@ -35,20 +38,42 @@ struct sesqlite_context *read_sesqlite_context(
  * The *filter parameters can be NULL to indicate a wildcard or a string
  * to indicate that only the (db/table/column) that match the filter must
  * have its value reloaded.
- * It returns the number of tuples updated in the sesqlite_context table.
+ * If old is not NULL, it is the sesqlite_context that sc replaces and only
+ * the objects whose label changes are written.
+ * The number of tuples updated in the sesqlite_context table is stored in
+ * *pnCount. The hashmaps are changed only when all the tuples are written:
+ * if ppLabeled is NULL they are changed before returning, otherwise the
+ * labeled objects are returned in *ppLabeled, to be stored by the caller
+ * with store_labeled_objects (e.g. once the transaction is released).
+ * It returns SQLITE_OK or the error of the first write that failed, in
+ * which case the writes done so far are not undone.
  */
 int reload_sesqlite_contexts(
 	sqlite3 *db,                  /* the database connection */
 	sqlite3_stmt *stmt,           /* the INSERT OR REPLACE statement */
 	struct sesqlite_context *sc,  /* the sesqlite_context */
+	struct sesqlite_context *old, /* the previous one or NULL */
 	char *dbFilter,               /* the db filter or NULL as wildcard */
 	char *tblFilter,              /* the table filter or NULL as wildcard */
-	char *colFilter               /* the column filter or NULL as wildcard */
+	char *colFilter,              /* the column filter or NULL as wildcard */
+	int *pnCount,                 /* OUT: number of labels written or NULL */
+	struct sesqlite_labeled **ppLabeled /* OUT: the labeled objects or NULL */
+);
+
+/* Stores the labeled objects in the hashmaps and frees the list */
+void store_labeled_objects(
+	sqlite3 *db,
+	struct sesqlite_labeled *pLabeled
+);
+
+/* Frees the labeled objects without storing them */
+void free_labeled_objects(
+	struct sesqlite_labeled *pLabeled
 );
 
 /*
  * Just a convenience function to load the sesqlite_contexts unfiltered.
- * It returns the number of tuples inserted in the sesqlite_context table.
+ * It returns SQLITE_OK or an error code.
  */
 int load_sesqlite_contexts(
 	sqlite3 *db,                  /* the database connection */
@@ -26,8 +26,26 @@ int initialize(sqlite3 *db);
 int compute_sql_context(int isColumn, char *dbName, char *tblName,
 	char *colName, struct sesqlite_context_element * con, char **res);
 
+/* Checks whether the database zDb was already labeled by SeSQLite */
+int isReopen(sqlite3 *db, const char *zDb, int *reopen);
+
+/* Returns the label id of a db/table/column, -1 if it has no label */
+int get_key(sqlite3 *db, const char *dbName, const char *tblName,
+	const char *colName);
+
+/* Caches the label id of a db/table/column */
+void insert_key(sqlite3 *db, const char *dbName, const char *tblName,
+	const char *colName, int id);
+
+/* Registers the label catalog module, see sesqlite_vtab.c */
+int initialize_catalog(sqlite3 *db);
+
+/* Creates the selinux_context and selinux_id tables in the database zDb */
+int create_internal_table(sqlite3 *db, const char *zDb);
+
+/* The internal tables are created with sqlite3_mprintf, %Q is the db name */
 #define SELINUX_CONTEXT_TABLE \
-	"CREATE TABLE IF NOT EXISTS selinux_context(" \
+	"CREATE TABLE IF NOT EXISTS %Q.selinux_context(" \
 	" security_context INT," \
 	" security_label INT," \
 	" db TEXT," \
@@ -39,7 +57,7 @@ int compute_sql_context(int isColumn, char *dbName, char *tblName,
 
 /* use rowid */
 #define SELINUX_ID_TABLE \
-	"CREATE TABLE IF NOT EXISTS selinux_id(" \
+	"CREATE TABLE IF NOT EXISTS %Q.selinux_id(" \
 	" security_context INT," \
 	" security_label TEXT UNIQUE" \
 	");"
@@ -50,5 +68,5 @@ int compute_sql_context(int isColumn, char *dbName, char *tblName,
     return; \
   }
 
-#define MORE_TOKENS (NULL!=strtok(NULL, ""))
+#define MORE_TOKENS(SAVE) (NULL!=strtok_r(NULL, "", &(SAVE)))
 
@@ -0,0 +1,83 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include "sesqlite.h"
+
+/* Comment the following line to keep the labels private to the process */
+#define USE_SHARED_LABELS
+
+/*
+ * Opens the label dictionary shared by the processes using the main
+ * database of the connection, if the database is a file and the VFS
+ * supports shared memory. Otherwise the dictionary stays private to the
+ * process. The connections of the process to the same file share the log.
+ */
+int sesqlite_shm_open(sqlite3 *db);
+
+/*
+ * Releases the log of the connection. The last connection of the process
+ * to close it also deletes its files, unless another process uses them.
+ */
+void sesqlite_shm_close(sqlite3 *db);
+
+/*
+ * Adds to hash_id the labels published by the other processes in the logs
+ * open in the process. The SESQLITE_MUTEX_LABELS mutex must be held.
+ */
+void sesqlite_shm_sync(void);
+
+/*
+ * Records a label added to selinux_id by the transaction of the connection.
+ * When the transaction commits the label is published to the other
+ * processes, when it rolls back the label is removed from hash_id, because
+ * its id is going to be reused for another label. If the row is already
+ * committed, the label is published right away.
+ */
+void sesqlite_shm_publish(sqlite3 *db, int id, const char *label);
+
+/* Invoked by the commit and rollback hooks of the connection */
+void sesqlite_shm_commit(sqlite3 *db);
+void sesqlite_shm_rollback(sqlite3 *db);
+
+/*
+ * Returns the label with the given id, NULL if it is unknown. On a miss
+ * the labels published by the other processes are loaded first.
+ */
+char *sesqlite_label(int id);
+
+/*
+ * Returns the id of the label, 0 if it is unknown. On a miss the labels
+ * published by the other processes are loaded first.
+ */
+int sesqlite_label_id(const char *label);
+
+/*
+ * Adds the label with the given id to hash_id. A different label known
+ * with the same id, or the same label known with a different id, is left
+ * by a rolled back transaction and is replaced. The strings of the labels
+ * removed stay valid until the last connection closes, so the strings
+ * returned by sesqlite_label can be used without holding the mutex.
+ */
+void sesqlite_label_add(int id, const char *label);
+
+/*
+ * Frees the strings of the labels removed from hash_id. Invoked when the
+ * last connection closes, with hash_id.
+ */
+void sesqlite_label_free(void);
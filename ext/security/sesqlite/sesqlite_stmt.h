@@ -0,0 +1,52 @@
+/*
+** Authors: Simone Mutti <simone.mutti@unibg.it>
+**          Enrico Bacis <enrico.bacis@unibg.it>
+**
+** Copyright 2015, Università degli Studi di Bergamo
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include "sesqlite.h"
+
+/* Statements kept by each connection when "pragma stmtcache" is not used */
+#ifndef SESQLITE_STMT_CACHE_SIZE
+# define SESQLITE_STMT_CACHE_SIZE 16
+#endif
+
+/*
+ * Invalidates the statements compiled so far by all the connections: the
+ * labels of the objects, the subject or the policy changed, so the checks
+ * done by the authorizer while preparing them may not hold anymore.
+ */
+void sesqlite_policy_changed(void);
+
+/*
+ * Opens (and closes) the SELinux status, used by sesqlite_policy_check to
+ * learn when the kernel loads a new policy or changes the booleans.
+ */
+void sesqlite_policy_open(void);
+void sesqlite_policy_close(void);
+
+/*
+ * Clears the AVC, and with it the statements kept by the cache, if the
+ * policy changed since the last check. Without the SELinux status there
+ * is no way to tell, and the AVC is always cleared.
+ */
+void sesqlite_policy_check(void);
+
+/* Finalizes the statements kept by the cache of the connection */
+void sesqlite_stmt_close(sqlite3 *db);
+
+/* "pragma stmtcache(N)" sets the size of the cache of the connection */
+void selinux_stmtcache_pragma(void *pArg, sqlite3 *db, char *args);
@@ -65,5 +65,32 @@ char *make_key(
 	return key;
 }
 
+static sqlite3_mutex *aMutex[SESQLITE_NMUTEX];
+
+int sesqlite_mutex_init(void){
+	sqlite3_mutex *pMaster = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_MASTER);
+	int rc = SQLITE_OK;
+	int i;
+
+	sqlite3_mutex_enter(pMaster);
+	for( i = 0; i<SESQLITE_NMUTEX && rc==SQLITE_OK; i++ ){
+		if( aMutex[i]!=NULL )
+			continue;
+		/* the label functions call each other while holding the mutex */
+		aMutex[i] = sqlite3_mutex_alloc(i==SESQLITE_MUTEX_AVC
+			? SQLITE_MUTEX_FAST : SQLITE_MUTEX_RECURSIVE);
+		if( aMutex[i]==NULL && sqlite3_threadsafe() )
+			rc = SQLITE_NOMEM;
+	}
+	sqlite3_mutex_leave(pMaster);
+
+	return rc;
+}
+
+sqlite3_mutex *sesqlite_mutex(int id){
+	assert( id>=0 && id<SESQLITE_NMUTEX );
+	return aMutex[id];
+}
+
 #endif
 
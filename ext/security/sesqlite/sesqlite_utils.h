@@ -30,8 +30,38 @@ void sesqlite_print(
 	const char *after
 );
 
+/*
+ * Clears the AVC and invalidates the statements kept by the statement
+ * cache, whose checks were done with the decisions cleared.
+ */
 void sesqlite_clearavc();
 
+/*
+ * Returns a number that changes every time the AVC is cleared, so that the
+ * decisions derived from it can be invalidated.
+ */
+unsigned int sesqlite_avc_generation();
+
+/*
+ * Returns 1 if the tables (and virtual tables) created from now on get the
+ * security_context column, 0 otherwise.
+ */
+int sesqlite_vtab_labeled(sqlite3 *db);
+
+/*
+ * Returns 1 if the subject can select the tuples of database zDb labeled
+ * with the given id, 0 otherwise. Used by the virtual tables that filter
+ * their rows by themselves (e.g. the labeled FTS tables), it shares the
+ * AVC with selinux_check_access.
+ */
+int sesqlite_tuple_visible(sqlite3 *db, const char *zDb, int label);
+
+/*
+ * Allocates the mutexes returned by sesqlite_mutex, if this was not done
+ * by a previous connection.
+ */
+int sesqlite_mutex_init(void);
+
 /*
  * Makes the key based on the database, the table and the column.
  * The user must invoke free on the returned pointer to free the memory.
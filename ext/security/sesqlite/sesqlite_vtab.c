@@ -20,36 +20,25 @@
 #if !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX)
 
 #include "sesqlite_vtab.h"
+#include "sesqlite_init.h"
+#include "sesqlite_shm.h"
 
-int setHashMap(SESQLITE_HASH *h) {
-	phash = h;
-	return 0;
-}
-
-static int sesqlite_get_row(sesqlite_cursor *c) {
-	int rc = SQLITE_OK;
-	sesqlite_vtab *v = (sesqlite_vtab *) c->cur.pVtab;
-	size_t length = 0;
-	char *key = NULL;
-
-	if (c->eof)
-		return SQLITE_OK;
-	rc = sqlite3_step(c->stmt);
-	if (rc == SQLITE_ROW) {
-		return SQLITE_OK; /* we have a valid row */
-	}
-
-	sqlite3_reset(c->stmt);
-	c->eof = 1;
-	return (rc == SQLITE_DONE ? SQLITE_OK : rc); /* DONE -> OK */
-}
+/*
+ * The constraints of a scan of the catalog, taken from xFilter.
+ */
+typedef struct sesqlite_catalog_filter {
+	const char *azEq[CATALOG_NCOL]; /* equality on the text columns */
+	int labelId; /* equality on label or label_id, 0 if none */
+	int nRange; /* number of range constraints */
+	int aRangeCol[CATALOG_MAX_RANGE]; /* column of each range constraint */
+	char aRangeOp[CATALOG_MAX_RANGE]; /* operator of each range constraint */
+	const char *azRange[CATALOG_MAX_RANGE]; /* value of each range constraint */
+} sesqlite_catalog_filter;
 
 static int sesqlite_connect(sqlite3 *db, void *udp, int argc,
 		const char * const *argv, sqlite3_vtab **vtab, char **errmsg) {
 
 	sesqlite_vtab *v = NULL;
-	sqlite3_stmt **appStmt[N_STATEMENT];
-	int rc, i;
 
 	*vtab = NULL;
 	*errmsg = NULL;
@@ -63,108 +52,329 @@ static int sesqlite_connect(sqlite3 *db, void *udp, int argc,
 	*vtab = (sqlite3_vtab*) v;
 	if (v == NULL)
 		return SQLITE_NOMEM;
+	memset(v, 0, sizeof(sesqlite_vtab));
 
 	v->db = db; /* stash this for later */
-	(*vtab)->zErrMsg = NULL; /* initalize this */
+	v->zDb = sqlite3_mprintf("%s", argv[1]);
+	if (v->zDb == NULL) {
+		sqlite3_free(v);
+		*vtab = NULL;
+		return SQLITE_NOMEM;
+	}
 	return SQLITE_OK;
 }
 
 static int sesqlite_disconnect(sqlite3_vtab *vtab) {
+	sqlite3_free(((sesqlite_vtab*) vtab)->zDb);
 	sqlite3_free(vtab);
 	return SQLITE_OK;
 }
 
+/*
+ * Equality and range constraints on the columns are all handled by
+ * xFilter: the equalities on db, name and column become lookups in the
+ * schema, the ones on label and label_id a lookup in the label dictionary,
+ * the ranges (also used for prefixes, e.g. name>='abc' AND name<'abd') are
+ * checked while walking the schema.
+ */
 static int sesqlite_bestindex(sqlite3_vtab *vtab, sqlite3_index_info *pInfo) {
+	const struct sqlite3_index_constraint *pCons;
+	char *zIdx = NULL;
+	char op;
+	int nArg = 0;
+	int nRange = 0;
+	int i;
 
-	//TODO VERY SIMPLE IMPLEMENTATION
-	/*
-	 * if we have 1 constraint -> WHERE table = xxx
-	 * if we have 2 constraints -> WHERE table = xxx AND column = yyy
-	 */
-//	int i;
-//	for (i = 0; i < pInfo->nConstraint; i++) {
-//		pInfo->aConstraintUsage[i].argvIndex = i + 1;
-//		pInfo->aConstraintUsage[i].omit = 1;
-//	}
-//
-//	switch (pInfo->nConstraint) {
-//	case 0:
-//		pInfo->idxNum = QUERY_ALL;
-//		break;
-//	case 1:
-//		pInfo->idxNum = QUERY_TABLE;
-//		break;
-//	case 2:
-//		pInfo->idxNum = QUERY_COLUMN;
-//		break;
-//	default:
-//		break;
-//	}
-	return SQLITE_OK;
+	zIdx = sqlite3_malloc(pInfo->nConstraint * 2 + 1);
+	if (zIdx == NULL)
+		return SQLITE_NOMEM;
+
+	pInfo->idxNum = 0;
+	for (i = 0, pCons = pInfo->aConstraint; i < pInfo->nConstraint; i++, pCons++) {
+		if (!pCons->usable || pCons->iColumn < 0 || pCons->iColumn >= CATALOG_NCOL)
+			continue;
+
+		switch (pCons->op) {
+		case SQLITE_INDEX_CONSTRAINT_EQ: op = CATALOG_OP_EQ; break;
+		case SQLITE_INDEX_CONSTRAINT_GT: op = CATALOG_OP_GT; break;
+		case SQLITE_INDEX_CONSTRAINT_GE: op = CATALOG_OP_GE; break;
+		case SQLITE_INDEX_CONSTRAINT_LT: op = CATALOG_OP_LT; break;
+		case SQLITE_INDEX_CONSTRAINT_LE: op = CATALOG_OP_LE; break;
+		default: continue;
+		}
+
+		/* ranges only on the text columns, the others are left to SQLite */
+		if (op != CATALOG_OP_EQ) {
+			if (pCons->iColumn == CATALOG_LABEL_ID || nRange == CATALOG_MAX_RANGE)
+				continue;
+			nRange++;
+		}
 
+		if (op == CATALOG_OP_EQ)
+			pInfo->idxNum |= (1 << pCons->iColumn);
+
+		zIdx[nArg * 2] = '0' + pCons->iColumn;
+		zIdx[nArg * 2 + 1] = op;
+		nArg++;
+		pInfo->aConstraintUsage[i].argvIndex = nArg;
+		pInfo->aConstraintUsage[i].omit = 1;
+	}
+	zIdx[nArg * 2] = 0;
+
+	pInfo->idxStr = zIdx;
+	pInfo->needToFreeIdxStr = 1;
+
+	/* the whole schema, one database, one table or a single object */
+	if (pInfo->idxNum & (1 << CATALOG_COLUMN)
+			&& pInfo->idxNum & (1 << CATALOG_NAME))
+		pInfo->estimatedCost = 1.0;
+	else if (pInfo->idxNum & (1 << CATALOG_NAME))
+		pInfo->estimatedCost = 10.0;
+	else if (pInfo->idxNum & (1 << CATALOG_DB))
+		pInfo->estimatedCost = 10000.0;
+	else
+		pInfo->estimatedCost = 100000.0;
+
+	return SQLITE_OK;
 }
 
 static int sesqlite_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **cur) {
-	sesqlite_vtab *v = (sesqlite_vtab*) vtab;
 	sesqlite_cursor *c = NULL;
-	int rc = 0;
 
 	c = sqlite3_malloc(sizeof(sesqlite_cursor));
 	*cur = (sqlite3_vtab_cursor*) c;
 	if (c == NULL)
 		return SQLITE_NOMEM;
+	memset(c, 0, sizeof(sesqlite_cursor));
 
 	return SQLITE_OK;
 }
 
 static int sesqlite_close(sqlite3_vtab_cursor *cur) {
-	sqlite3_finalize(((sesqlite_cursor*) cur)->stmt);
+	sqlite3_free(((sesqlite_cursor*) cur)->aRow);
 	sqlite3_free(cur);
 	return SQLITE_OK;
 }
 
+/*
+ * Returns 1 if the value of a text column satisfies the constraints of f.
+ * The comparisons are the ones of the BINARY collation, so the constraints
+ * can be omitted by SQLite.
+ */
+static int catalog_match(sesqlite_catalog_filter *f, int iCol, const char *z) {
+	int i, c;
+
+	if (f->azEq[iCol] && (z == NULL || strcmp(f->azEq[iCol], z) != 0))
+		return 0;
+
+	for (i = 0; i < f->nRange; i++) {
+		if (f->aRangeCol[i] != iCol)
+			continue;
+		if (z == NULL)
+			return 0;
+		c = strcmp(z, f->azRange[i]);
+		switch (f->aRangeOp[i]) {
+		case CATALOG_OP_GT: if (c <= 0) return 0; break;
+		case CATALOG_OP_GE: if (c < 0) return 0; break;
+		case CATALOG_OP_LT: if (c >= 0) return 0; break;
+		case CATALOG_OP_LE: if (c > 0) return 0; break;
+		}
+	}
+
+	return 1;
+}
+
+/*
+ * Appends the object to the rows of the cursor if it satisfies the
+ * constraints on its label.
+ */
+static int catalog_add(sesqlite_cursor *c, sesqlite_catalog_filter *f,
+		sqlite3 *db, const char *zDb, const char *zTab, const char *zCol) {
+	sesqlite_catalog_row *aNew;
+	int id = get_key(db, zDb, zTab, zCol);
+
+	if (f->labelId && f->labelId != id)
+		return SQLITE_OK;
+
+	if (c->nRow == c->nAlloc) {
+		aNew = sqlite3_realloc(c->aRow,
+				(c->nAlloc * 2 + 16) * sizeof(sesqlite_catalog_row));
+		if (aNew == NULL)
+			return SQLITE_NOMEM;
+		c->aRow = aNew;
+		c->nAlloc = c->nAlloc * 2 + 16;
+	}
+
+	c->aRow[c->nRow].zDb = zDb;
+	c->aRow[c->nRow].zTab = zTab;
+	c->aRow[c->nRow].zCol = zCol;
+	c->aRow[c->nRow].id = id;
+	c->nRow++;
+	return SQLITE_OK;
+}
+
+/*
+ * Adds the table and its columns, following the same order used by
+ * reload_sesqlite_contexts to label them.
+ */
+static int catalog_add_table(sesqlite_cursor *c, sesqlite_catalog_filter *f,
+		sqlite3 *db, const char *zDb, Table *pTab) {
+	int rc = SQLITE_OK;
+	int j;
+
+	if (!catalog_match(f, CATALOG_NAME, pTab->zName))
+		return SQLITE_OK;
+
+	if (catalog_match(f, CATALOG_COLUMN, NULL))
+		rc = catalog_add(c, f, db, zDb, pTab->zName, NULL);
+
+	for (j = 0; rc == SQLITE_OK && j < pTab->nCol; j++) {
+		if (catalog_match(f, CATALOG_COLUMN, pTab->aCol[j].zName))
+			rc = catalog_add(c, f, db, zDb, pTab->zName, pTab->aCol[j].zName);
+	}
+
+	if (rc == SQLITE_OK && HasRowid(pTab) && catalog_match(f, CATALOG_COLUMN, "ROWID"))
+		rc = catalog_add(c, f, db, zDb, pTab->zName, "ROWID");
+
+	return rc;
+}
+
 static int sesqlite_filter(sqlite3_vtab_cursor *cur, int idxnum,
 		const char *idxstr, int argc, sqlite3_value **value) {
 	sesqlite_cursor *c = (sesqlite_cursor*) cur;
 	sesqlite_vtab *v = (sesqlite_vtab *) cur->pVtab;
-	int rc = 0;
+	sqlite3 *db = v->db;
+	sesqlite_catalog_filter f;
+	const char *z;
+	HashElem *x;
+	Table *pTab;
+	int labelId;
+	int iCol;
+	int rc = SQLITE_OK;
 	int i;
 
-	//static query
-	rc = sqlite3_prepare_v2(v->db, "select * from selinux_context", -1,
-			&c->stmt,
-			NULL);
-	if (rc != SQLITE_OK) {
-		sqlite3_free(c);
-		return rc;
+	c->nRow = 0;
+	c->iRow = 0;
+	memset(&f, 0, sizeof(f));
+
+	for (i = 0; i < argc; i++) {
+		iCol = idxstr[i * 2] - '0';
+
+		if (iCol == CATALOG_LABEL_ID) {
+			if (sqlite3_value_numeric_type(value[i]) != SQLITE_INTEGER)
+				return SQLITE_OK; /* not an id */
+			labelId = sqlite3_value_int(value[i]);
+			if (f.labelId && f.labelId != labelId)
+				return SQLITE_OK;
+			f.labelId = labelId;
+			continue;
+		}
+
+		z = (const char*) sqlite3_value_text(value[i]);
+		if (z == NULL)
+			return SQLITE_OK; /* nothing is equal to (or less than) NULL */
+
+		if (idxstr[i * 2 + 1] != CATALOG_OP_EQ) {
+			f.aRangeCol[f.nRange] = iCol;
+			f.aRangeOp[f.nRange] = idxstr[i * 2 + 1];
+			f.azRange[f.nRange] = z;
+			f.nRange++;
+		} else if (iCol == CATALOG_LABEL) {
+			labelId = sesqlite_label_id(z);
+			if (labelId == 0)
+				return SQLITE_OK; /* unknown label */
+			if (f.labelId && f.labelId != labelId)
+				return SQLITE_OK;
+			f.labelId = labelId;
+		} else {
+			if (f.azEq[iCol] && strcmp(f.azEq[iCol], z) != 0)
+				return SQLITE_OK;
+			f.azEq[iCol] = z;
+		}
 	}
-	rc = sqlite3_reset(c->stmt); /* start a new scan */
-	if (rc != SQLITE_OK)
-		return rc;
-	c->eof = 0; /* clear EOF flag */
 
-	sesqlite_get_row(c); /* fetch first row */
-	return SQLITE_OK;
+	for (i = 0; rc == SQLITE_OK && i < db->nDb; i++) {
+		const char *zDb = db->aDb[i].zName;
+
+		if (OMIT_TEMPDB && i == 1)
+			continue;
+		if (db->aDb[i].pSchema == NULL || !catalog_match(&f, CATALOG_DB, zDb))
+			continue;
+
+		/* the database itself */
+		if (catalog_match(&f, CATALOG_NAME, NULL)
+				&& catalog_match(&f, CATALOG_COLUMN, NULL))
+			rc = catalog_add(c, &f, db, zDb, NULL, NULL);
+
+		if (f.azEq[CATALOG_NAME]) {
+			/* a single table, the lookup is case insensitive */
+			pTab = sqlite3HashFind(&db->aDb[i].pSchema->tblHash,
+					f.azEq[CATALOG_NAME], sqlite3Strlen30(f.azEq[CATALOG_NAME]));
+			if (rc == SQLITE_OK && pTab)
+				rc = catalog_add_table(c, &f, db, zDb, pTab);
+		} else {
+			for (x = sqliteHashFirst(&db->aDb[i].pSchema->tblHash);
+					rc == SQLITE_OK && x; x = sqliteHashNext(x)) {
+				rc = catalog_add_table(c, &f, db, zDb, sqliteHashData(x));
+			}
+		}
+	}
+
+	return rc;
 }
 
 static int sesqlite_next(sqlite3_vtab_cursor *cur) {
-	return sesqlite_get_row((sesqlite_cursor*) cur);
+	((sesqlite_cursor*) cur)->iRow++;
+	return SQLITE_OK;
 }
 
 static int sesqlite_eof(sqlite3_vtab_cursor *cur) {
-	return ((sesqlite_cursor*) cur)->eof;
+	sesqlite_cursor *c = (sesqlite_cursor*) cur;
+	return c->iRow >= c->nRow;
 }
 
 static int sesqlite_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx,
 		int cidx) {
 	sesqlite_cursor *c = (sesqlite_cursor*) cur;
-	sqlite3_result_value(ctx, sqlite3_column_value(c->stmt, cidx));
+	sesqlite_vtab *v = (sesqlite_vtab *) cur->pVtab;
+	sesqlite_catalog_row *r = &c->aRow[c->iRow];
+	char *label = NULL;
+
+	switch (cidx) {
+	case CATALOG_DB:
+		sqlite3_result_text(ctx, r->zDb, -1, SQLITE_TRANSIENT);
+		break;
+	case CATALOG_NAME:
+		if (r->zTab)
+			sqlite3_result_text(ctx, r->zTab, -1, SQLITE_TRANSIENT);
+		break;
+	case CATALOG_COLUMN:
+		if (r->zCol)
+			sqlite3_result_text(ctx, r->zCol, -1, SQLITE_TRANSIENT);
+		break;
+	case CATALOG_LABEL:
+		if (r->id != -1)
+			label = sesqlite_label(r->id);
+		if (label)
+			sqlite3_result_text(ctx, label, -1, SQLITE_TRANSIENT);
+		break;
+	case CATALOG_LABEL_ID:
+		if (r->id != -1)
+			sqlite3_result_int(ctx, r->id);
+		break;
+	default:
+		/* the security_context added by SeSQLite: the rows have the label
+		 * of the rows of selinux_context they describe */
+		sqlite3_result_int(ctx, sesqlite_local_id(v->db, v->zDb,
+				lookup_security_context(hash_id, (char*) r->zDb, SELINUX_CONTEXT)));
+		break;
+	}
 
 	return SQLITE_OK;
 }
 
 static int sesqlite_rowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid) {
-	*rowid = sqlite3_column_int64(((sesqlite_cursor*) cur)->stmt, 0);
+	*rowid = ((sesqlite_cursor*) cur)->iRow;
 	return SQLITE_OK;
 }
 
@@ -172,10 +382,8 @@ static int sesqlite_rename(sqlite3_vtab *vtab, const char *newname) {
 	return SQLITE_OK;
 }
 
-static int seslite_update(sqlite3_vtab *pVtab, int argc, sqlite3_value ** argv,
-		sqlite3_int64 *pRowId) {
-	return SQLITE_OK;
+int initialize_catalog(sqlite3 *db) {
+	return sqlite3_create_module(db, SESQLITE_CATALOG_MODULE, &sesqlite_mod, 0);
 }
 
 #endif /* !defined(SQLITE_CORE) || defined(SQLITE_ENABLE_SELINUX) */
-
@@ -23,45 +23,61 @@
 extern "C" {
 #endif  /* __cplusplus */
 
-//TODO can be shared among all users in the db
-SESQLITE_HASH *phash; /* HashMap */
+/*
+ * The label catalog: one row for each database, table and column known to
+ * SeSQLite, with its label. It is read from the schema and the in-memory
+ * hashmaps, the selinux_context table is never queried. Usage:
+ *
+ *     CREATE VIRTUAL TABLE selinux_catalog USING selinux_catalog;
+ *     SELECT * FROM selinux_catalog WHERE db='main' AND name='t1';
+ */
+#define SESQLITE_CATALOG_MODULE "selinux_catalog"
 
 static const char *sesqlite_sql =
-		"CREATE TABLE selinuxModule ( security_context TEXT, name TEXT, column TEXT );";
-
-#define N_STATEMENT 3
-static const char *azSql[N_STATEMENT] = {
-/* Read and write the xxx_node table */
-"SELECT * FROM selinux_context ",
-
-/* Read and write the xxx_rowid table */
-"SELECT security_context FROM selinux_context WHERE "
-		"name = ?1",
+		"CREATE TABLE x(db TEXT, name TEXT, column TEXT, label TEXT, label_id INT);";
 
-/* Read and write the xxx_parent table */
-"SELECT security_context FROM selinux_context WHERE "
-		"name = ?1 AND column = ?2", };
+/* The columns of the catalog */
+#define CATALOG_DB        0
+#define CATALOG_NAME      1
+#define CATALOG_COLUMN    2
+#define CATALOG_LABEL     3
+#define CATALOG_LABEL_ID  4
+#define CATALOG_NCOL      5
 
-typedef enum sesqliteQueryType {
-	QUERY_ALL, /* table scan */
-	QUERY_TABLE, /* lookup by rowid */
-	QUERY_COLUMN /* QUERY_FULLTEXT + [i] is a full-text search for column i*/
-} sesqliteQueryType;
+/*
+ * The constraints used by xFilter are described by idxStr, two characters
+ * for each argument: the column (a digit) and the operator, one of
+ * CATALOG_OP_*. idxNum has the bit (1<<column) set for each equality.
+ */
+#define CATALOG_OP_EQ  '='
+#define CATALOG_OP_GT  '>'
+#define CATALOG_OP_GE  'g'
+#define CATALOG_OP_LT  '<'
+#define CATALOG_OP_LE  'l'
+
+/* at most this many range constraints are handled by xFilter */
+#define CATALOG_MAX_RANGE 8
 
 typedef struct sesqlite_vtab_s {
 	sqlite3_vtab vtab; /* this must go first */
-	sesqliteQueryType iCursorType; /* Copy of sqlite3_index_info.idxNum */
 	sqlite3 *db; /* module specific fields then follow */
-	sqlite3_stmt *pSelectAll; /* sql statement */
-	sqlite3_stmt *pSelectTable; /* sql statement */
-	sqlite3_stmt *pSelectColumn; /* sql statement */
+	char *zDb; /* the database of the virtual table */
 } sesqlite_vtab;
 
+/* A row of the catalog, the names point into the schema */
+typedef struct sesqlite_catalog_row {
+	const char *zDb;
+	const char *zTab; /* NULL for the database */
+	const char *zCol; /* NULL for the database and the table */
+	int id; /* label id, -1 if the object has no label */
+} sesqlite_catalog_row;
+
 typedef struct sesqlite_cursor_s {
 	sqlite3_vtab_cursor cur; /* this must go first */
-	sqlite3_stmt *stmt; /* sql statement */
-	int eof; /* EOF flag */
-	char *res;
+	sesqlite_catalog_row *aRow; /* the rows matching the constraints */
+	int nRow; /* number of rows in aRow */
+	int nAlloc; /* slots allocated in aRow */
+	int iRow; /* the current row */
 } sesqlite_cursor;
 
 static int sesqlite_connect(sqlite3 *db, void *udp, int argc,
@@ -89,9 +105,6 @@ static int sesqlite_rowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *rowid);
 
 static int sesqlite_rename(sqlite3_vtab *vtab, const char *newname);
 
-static int seslite_update(sqlite3_vtab *pVtab, int argc, sqlite3_value ** argv,
-		sqlite3_int64 *pRowId);
-
 static sqlite3_module sesqlite_mod = {
 /* iVersion      */0,
 /* xCreate       */sesqlite_connect,
@@ -106,7 +119,7 @@ static sqlite3_module sesqlite_mod = {
 /* xEof          */sesqlite_eof,
 /* xColumn       */sesqlite_column,
 /* xRowid        */sesqlite_rowid,
-/* xUpdate       */seslite_update,
+/* xUpdate       */0,
 /* xBegin        */0,
 /* xSync         */0,
 /* xCommit       */0,
@@ -207,6 +207,27 @@ static void attachFunc(
     rc = sqlite3Init(db, &zErrDyn);
     sqlite3BtreeLeaveAll(db);
   }
+#ifndef SQLITE_OMIT_SCHEMACHANGE_NOTIFICATIONS
+  /* Give the schema change callback a chance to set up its own state for
+  ** the new database (SeSQLite loads the label dictionaries here). If it
+  ** fails the database is detached again by the error handling below.
+  */
+  if( rc==SQLITE_OK && db->xSchemaChangeCallback ){
+    rc = db->xSchemaChangeCallback(
+      db->pSchemaChangeArg,
+      SQLITE_SCHEMA_ATTACH,
+      zName,
+      NULL,
+      (void*) zFile,
+      NULL
+    );
+    if( rc==SQLITE_AUTH && zErrDyn==0 ){
+      zErrDyn = sqlite3MPrintf(db, "not authorized");
+    }else if( rc && zErrDyn==0 ){
+      zErrDyn = sqlite3MPrintf(db, "cannot initialize database: %s", zName);
+    }
+  }
+#endif
   if( rc ){
     int iDb = db->nDb - 1;
     assert( iDb>=2 );
@@ -284,6 +305,19 @@ static void detachFunc(
     goto detach_error;
   }
 
+#ifndef SQLITE_OMIT_SCHEMACHANGE_NOTIFICATIONS
+  if( db->xSchemaChangeCallback ){
+    db->xSchemaChangeCallback(
+      db->pSchemaChangeArg,
+      SQLITE_SCHEMA_DETACH,
+      pDb->zName,
+      NULL,
+      NULL,
+      NULL
+    );
+  }
+#endif
+
   sqlite3BtreeClose(pDb->pBt);
   pDb->pBt = 0;
   pDb->pSchema = 0;
@@ -379,7 +379,9 @@ int sqlite3_backup_step(sqlite3_backup *p, int nPage){
     pgszSrc = sqlite3BtreeGetPageSize(p->pSrc);
     pgszDest = sqlite3BtreeGetPageSize(p->pDest);
     destMode = sqlite3PagerGetJournalMode(sqlite3BtreePager(p->pDest));
-    if( SQLITE_OK==rc && destMode==PAGER_JOURNALMODE_WAL && pgszSrc!=pgszDest ){
+    if( SQLITE_OK==rc && PAGER_JOURNALMODE_ISWAL(destMode)
+     && pgszSrc!=pgszDest
+    ){
       rc = SQLITE_READONLY;
     }
   
@@ -428,8 +430,10 @@ int sqlite3_backup_step(sqlite3_backup *p, int nPage){
         if( p->pDestDb ){
           sqlite3ResetAllSchemasOfConnection(p->pDestDb);
         }
-        if( destMode==PAGER_JOURNALMODE_WAL ){
-          rc = sqlite3BtreeSetVersion(p->pDest, 2);
+        if( PAGER_JOURNALMODE_ISWAL(destMode) ){
+          rc = sqlite3BtreeSetVersion(p->pDest,
+              destMode==PAGER_JOURNALMODE_WAL2 ? 3 : 2
+          );
         }
       }
       if( rc==SQLITE_OK ){
@@ -2424,24 +2424,24 @@ static int lockBtree(BtShared *pBt){
       goto page1_init_failed;
     }
 #else
-    if( page1[18]>2 ){
+    if( page1[18]>3 ){
       pBt->btsFlags |= BTS_READ_ONLY;
     }
-    if( page1[19]>2 ){
+    if( page1[19]>3 ){
       goto page1_init_failed;
     }
 
     /* If the write version is set to 2, this database should be accessed
-    ** in WAL mode. If the log is not already open, open it now. Then 
-    ** return SQLITE_OK and return without populating BtShared.pPage1.
-    ** The caller detects this and calls this function again. This is
-    ** required as the version of page 1 currently in the page1 buffer
-    ** may not be the latest version - there may be a newer one in the log
-    ** file.
+    ** in WAL mode, or if it is set to 3, in wal2 mode. If the log is not
+    ** already open, open it now. Then return SQLITE_OK and return without
+    ** populating BtShared.pPage1. The caller detects this and calls this
+    ** function again. This is required as the version of page 1 currently
+    ** in the page1 buffer may not be the latest version - there may be a
+    ** newer one in the log file.
     */
-    if( page1[19]==2 && (pBt->btsFlags & BTS_NO_WAL)==0 ){
+    if( (page1[19]==2 || page1[19]==3) && (pBt->btsFlags & BTS_NO_WAL)==0 ){
       int isOpen = 0;
-      rc = sqlite3PagerOpenWal(pBt->pPager, &isOpen);
+      rc = sqlite3PagerOpenWal(pBt->pPager, page1[19]==3, &isOpen);
       if( rc!=SQLITE_OK ){
         goto page1_init_failed;
       }else if( isOpen==0 ){
@@ -2734,6 +2734,19 @@ int sqlite3BtreeBeginTrans(Btree *p, int wrflag){
     */
     while( pBt->pPage1==0 && SQLITE_OK==(rc = lockBtree(pBt)) );
 
+    /* Within a BEGIN CONCURRENT transaction, have the pager record the
+    ** pages used from the moment the snapshot is opened. A shared cache
+    ** has a single pager for all of its connections, so this is only
+    ** done if no other connection is using it. */
+    if( rc==SQLITE_OK && pBt->inTransaction==TRANS_NONE
+     && p->db->bConcurrent && !p->db->autoCommit
+#ifndef SQLITE_OMIT_SHARED_CACHE
+     && (!p->sharable || pBt->nRef==1)
+#endif
+    ){
+      rc = sqlite3PagerBeginConcurrent(pBt->pPager);
+    }
+
     if( rc==SQLITE_OK && wrflag ){
       if( (pBt->btsFlags & BTS_READ_ONLY)!=0 ){
         rc = SQLITE_READONLY;
@@ -3453,6 +3466,7 @@ int sqlite3BtreeRollback(Btree *p, int tripCode){
     int rc2;
 
     assert( TRANS_WRITE==pBt->inTransaction );
+    pBt->nRollback++;
     rc2 = sqlite3PagerRollback(pBt->pPager);
     if( rc2!=SQLITE_OK ){
       rc = rc2;
@@ -3535,6 +3549,7 @@ int sqlite3BtreeSavepoint(Btree *p, int op, int iSavepoint){
     assert( op==SAVEPOINT_RELEASE || op==SAVEPOINT_ROLLBACK );
     assert( iSavepoint>=0 || (iSavepoint==-1 && op==SAVEPOINT_ROLLBACK) );
     sqlite3BtreeEnter(p);
+    if( op==SAVEPOINT_ROLLBACK ) pBt->nRollback++;
     rc = sqlite3PagerSavepoint(pBt->pPager, op, iSavepoint);
     if( rc==SQLITE_OK ){
       if( iSavepoint<0 && (pBt->btsFlags & BTS_INITIALLY_EMPTY)!=0 ){
@@ -4254,6 +4269,75 @@ static int moveToChild(BtCursor *pCur, u32 newPgno){
   return SQLITE_OK;
 }
 
+/*
+** The number of leaves that a cursor must have stepped off of in a row,
+** using sqlite3BtreeNext() or sqlite3BtreePrevious(), before it starts
+** reading ahead.
+*/
+#define BTREE_READAHEAD_MIN 4
+
+/*
+** The cursor has just moved up from a leaf page to its parent, in the
+** course of a scan by sqlite3BtreeNext() (if bPrev is 0) or
+** sqlite3BtreePrevious() (if bPrev is 1). If the scan is long enough,
+** ask the pager to read ahead the children of the parent that the scan
+** has yet to visit, so that they are already in the OS cache when the
+** cursor gets there.
+**
+** Up to "PRAGMA readahead" children are read ahead at a time. The next
+** batch is requested once the cursor is halfway through the current one.
+** BtCursor.iAhead remembers the end of the current batch. It is only valid
+** while BtCursor.bAhead is set, which is cleared when the cursor seeks or
+** moves on to another parent.
+*/
+static void btreeReadahead(BtCursor *pCur, int bPrev){
+  Pager *pPager = pCur->pBt->pPager;
+  MemPage *pPage = pCur->apPage[pCur->iPage];
+  int iIdx = pCur->aiIdx[pCur->iPage];   /* Child the cursor came from */
+  int nAhead;                            /* Children to read ahead */
+  int iFirst;                            /* First child to read ahead */
+  int iLast;                             /* Last child to read ahead */
+  int i;
+  int nPgno = 0;
+  Pgno aPgno[PAGER_MAX_READAHEAD];
+
+  assert( !pPage->leaf );
+  nAhead = sqlite3PagerReadaheadLimit(pPager, -1);
+  if( nAhead==0 || iIdx>pPage->nCell ) return;
+  if( pCur->nSeqLeaf<BTREE_READAHEAD_MIN ){
+    if( ++pCur->nSeqLeaf<BTREE_READAHEAD_MIN ) return;
+  }
+
+  if( bPrev ){
+    iFirst = iIdx-1;
+    iLast = MAX(iIdx-nAhead, 0);
+    if( pCur->bAhead ){
+      if( iIdx-nAhead/2>pCur->iAhead ) return;
+      iFirst = MIN(iFirst, pCur->iAhead-1);
+    }
+  }else{
+    iFirst = iIdx+1;
+    iLast = MIN(iIdx+nAhead, pPage->nCell);
+    if( pCur->bAhead ){
+      if( iIdx+nAhead/2<pCur->iAhead ) return;
+      iFirst = MAX(iFirst, pCur->iAhead+1);
+    }
+  }
+  pCur->bAhead = 1;
+  pCur->iAhead = (u16)iLast;
+
+  for(i=iFirst; bPrev ? i>=iLast : i<=iLast; i+=(bPrev ? -1 : 1)){
+    if( i==pPage->nCell ){
+      aPgno[nPgno++] = get4byte(&pPage->aData[pPage->hdrOffset+8]);
+    }else{
+      aPgno[nPgno++] = get4byte(findCell(pPage, i));
+    }
+  }
+  if( nPgno>0 ){
+    sqlite3PagerReadahead(pPager, aPgno, nPgno);
+  }
+}
+
 #if 0
 /*
 ** Page pParent is an internal (non-leaf) tree page. This function 
@@ -4344,6 +4428,8 @@ static int moveToRoot(BtCursor *pCur){
     }
     sqlite3BtreeClearCursor(pCur);
   }
+  pCur->nSeqLeaf = 0;
+  pCur->bAhead = 0;
 
   if( pCur->iPage>=0 ){
     while( pCur->iPage ) releasePage(pCur->apPage[pCur->iPage--]);
@@ -4811,6 +4897,7 @@ int sqlite3BtreeNext(BtCursor *pCur, int *pRes){
   pCur->info.nSize = 0;
   pCur->validNKey = 0;
   if( idx>=pPage->nCell ){
+    int iLeaf = pCur->iPage;
     if( !pPage->leaf ){
       rc = moveToChild(pCur, get4byte(&pPage->aData[pPage->hdrOffset+8]));
       if( rc ){
@@ -4830,6 +4917,11 @@ int sqlite3BtreeNext(BtCursor *pCur, int *pRes){
       moveToParent(pCur);
       pPage = pCur->apPage[pCur->iPage];
     }while( pCur->aiIdx[pCur->iPage]>=pPage->nCell );
+    if( pCur->iPage==iLeaf-1 ){
+      btreeReadahead(pCur, 0);
+    }else{
+      pCur->bAhead = 0;
+    }
     *pRes = 0;
     if( pPage->intKey ){
       rc = sqlite3BtreeNext(pCur, pRes);
@@ -4906,6 +4998,7 @@ int sqlite3BtreePrevious(BtCursor *pCur, int *pRes){
     }
     rc = moveToRightmost(pCur);
   }else{
+    int iLeaf = pCur->iPage;
     while( pCur->aiIdx[pCur->iPage]==0 ){
       if( pCur->iPage==0 ){
         pCur->eState = CURSOR_INVALID;
@@ -4914,6 +5007,11 @@ int sqlite3BtreePrevious(BtCursor *pCur, int *pRes){
       }
       moveToParent(pCur);
     }
+    if( pCur->iPage==iLeaf-1 ){
+      btreeReadahead(pCur, 1);
+    }else{
+      pCur->bAhead = 0;
+    }
     pCur->info.nSize = 0;
     pCur->validNKey = 0;
 
@@ -6964,6 +7062,7 @@ int sqlite3BtreeInsert(
   */
   rc = saveAllCursors(pBt, pCur->pgnoRoot, pCur);
   if( rc ) return rc;
+  BT_TABCHANGE(pBt, pCur->pgnoRoot)++;
 
   if( pCur->pKeyInfo==0 ){
     /* If this is an insert into a table b-tree, invalidate any incrblob 
@@ -7087,6 +7186,7 @@ int sqlite3BtreeDelete(BtCursor *pCur){
   ){
     return SQLITE_ERROR;  /* Something has gone awry. */
   }
+  BT_TABCHANGE(pBt, pCur->pgnoRoot)++;
 
   iCellDepth = pCur->iPage;
   iCellIdx = pCur->aiIdx[iCellDepth];
@@ -7417,6 +7517,7 @@ int sqlite3BtreeClearTable(Btree *p, int iTable, int *pnChange){
     ** is the root of a table b-tree - if it is not, the following call is
     ** a no-op).  */
     invalidateIncrblobCursors(p, 0, 1);
+    BT_TABCHANGE(pBt, (Pgno)iTable)++;
     rc = clearDatabasePage(pBt, (Pgno)iTable, 0, pnChange);
   }
   sqlite3BtreeLeave(p);
@@ -8341,6 +8442,23 @@ int sqlite3BtreeSchemaLocked(Btree *p){
   return rc;
 }
 
+/*
+** Return a value that changes whenever the content of the table with root
+** page iTable may have changed: when it is written through any connection
+** that shares the BtShared object, when a transaction or savepoint is
+** rolled back, and when the pager detects a change made to the database
+** by another process. The value may also change when the table has not.
+**
+** The caller must hold a read transaction on p.
+*/
+u32 sqlite3BtreeTableVersion(Btree *p, u32 iTable){
+  BtShared *pBt = p->pBt;
+  assert( p->inTrans!=TRANS_NONE );
+  assert( sqlite3BtreeHoldsMutex(p) );
+  return BT_TABCHANGE(pBt, iTable) + pBt->nRollback
+       + sqlite3PagerDataVersion(pBt->pPager);
+}
+
 
 #ifndef SQLITE_OMIT_SHARED_CACHE
 /*
@@ -8420,6 +8538,7 @@ int sqlite3BtreePutData(BtCursor *pCsr, u32 offset, u32 amt, void *z){
   assert( !hasReadConflicts(pCsr->pBtree, pCsr->pgnoRoot) );
   assert( pCsr->apPage[pCsr->iPage]->intKey );
 
+  BT_TABCHANGE(pCsr->pBt, pCsr->pgnoRoot)++;
   return accessPayload(pCsr, offset, amt, (unsigned char *)z, 1);
 }
 
@@ -8450,13 +8569,14 @@ int sqlite3BtreeSetVersion(Btree *pBtree, int iVersion){
   BtShared *pBt = pBtree->pBt;
   int rc;                         /* Return code */
  
-  assert( iVersion==1 || iVersion==2 );
+  assert( iVersion==1 || iVersion==2 || iVersion==3 );
 
-  /* If setting the version fields to 1, do not automatically open the
-  ** WAL connection, even if the version fields are currently set to 2.
+  /* Do not automatically open the WAL connection while the version fields
+  ** are being changed. If setting them to 1, the caller has just closed
+  ** the WAL. And when switching between WAL (2) and wal2 (3) mode, the log
+  ** would be opened in the mode the fields are being changed from.
   */
-  pBt->btsFlags &= ~BTS_NO_WAL;
-  if( iVersion==1 ) pBt->btsFlags |= BTS_NO_WAL;
+  pBt->btsFlags |= BTS_NO_WAL;
 
   rc = sqlite3BtreeBeginTrans(pBtree, 0);
   if( rc==SQLITE_OK ){
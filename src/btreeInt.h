@@ -368,6 +368,15 @@ struct Btree {
 #define TRANS_READ  1
 #define TRANS_WRITE 2
 
+/*
+** Each write to a table increments one of the BT_NTABCHANGE counters in
+** BtShared.aTabChange[], the one selected by the root page of the table.
+** Tables may share a counter. See sqlite3BtreeTableVersion().
+*/
+#define BT_NTABCHANGE 64            /* Must be a power of two */
+#define BT_TABCHANGE(pBt, iRoot) \
+  (pBt)->aTabChange[(iRoot) & (BT_NTABCHANGE-1)]
+
 /*
 ** An instance of this object represents a single database file.
 ** 
@@ -436,6 +445,8 @@ struct BtShared {
   Btree *pWriter;       /* Btree with currently open write transaction */
 #endif
   u8 *pTmpSpace;        /* BtShared.pageSize bytes of space for tmp use */
+  u32 nRollback;        /* Number of rollbacks, including ROLLBACK TO */
+  u32 aTabChange[BT_NTABCHANGE];  /* Write counters. See BT_TABCHANGE() */
 };
 
 /*
@@ -512,8 +523,11 @@ struct BtCursor {
   u8 isIncrblobHandle;      /* True if this cursor is an incr. io handle */
 #endif
   u8 hints;                             /* As configured by CursorSetHints() */
+  u8 nSeqLeaf;              /* Leaves left by Next/Prev since the last seek */
+  u8 bAhead;                /* True if iAhead is valid */
   i16 iPage;                            /* Index of current page in apPage */
   u16 aiIdx[BTCURSOR_MAX_DEPTH];        /* Current index in apPage[i] */
+  u16 iAhead;               /* Last child of the leaves' parent read ahead */
   MemPage *apPage[BTCURSOR_MAX_DEPTH];  /* Pages from root to current page */
 };
 
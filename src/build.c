@@ -474,6 +474,7 @@ void sqlite3ResetOneSchema(sqlite3 *db, int iDb){
   assert( sqlite3SchemaMutexHeld(db, iDb, 0) );
   assert( pDb->pSchema!=0 );
   sqlite3SchemaClear(pDb->pSchema);
+  sqlite3VdbeAutoidxPurge(db, 0);
 
   /* If any database other than TEMP is reset, then also reset TEMP
   ** since TEMP might be holding triggers that reference tables in the
@@ -502,6 +503,7 @@ void sqlite3ResetAllSchemasOfConnection(sqlite3 *db){
   }
   db->flags &= ~SQLITE_InternChanges;
   sqlite3VtabUnlockList(db);
+  sqlite3VdbeAutoidxPurge(db, 0);
   sqlite3BtreeLeaveAll(db);
   sqlite3CollapseDatabaseArray(db);
 }
@@ -1918,7 +1920,7 @@ void sqlite3EndTable(
 	code = 1;
     }
 
-    if( db->xAddExtraColumn && !is_vacuum() ){
+    if( db->xAddExtraColumn && !is_vacuum(db) ){
 	rc = db->xAddExtraColumn(db->pAddColumnArg, NULL, code, p, &zColumn);
 	if(rc == -1){
 	    /*TODO call abort*/
@@ -1937,7 +1939,7 @@ void sqlite3EndTable(
       if( pEnd2->z[0]!=';' ) n += pEnd2->n;
 
 #if defined(SQLITE_ENABLE_SELINUX)
-      if(!is_vacuum() &&
+      if(!is_vacuum(db) &&
 	      0!=sqlite3StrNICmp(p->zName, "sqlite_", 7) && 
 	      0!=sqlite3StrNICmp(p->zName, "selinux_", 8)) {
         int pStmt = 0;
@@ -3833,13 +3835,13 @@ void sqlite3BeginTransaction(Parse *pParse, int type){
   }
   v = sqlite3GetVdbe(pParse);
   if( !v ) return;
-  if( type!=TK_DEFERRED ){
+  if( type!=TK_DEFERRED && type!=TK_CONCURRENT ){
     for(i=0; i<db->nDb; i++){
       sqlite3VdbeAddOp2(v, OP_Transaction, i, (type==TK_EXCLUSIVE)+1);
       sqlite3VdbeUsesBtree(v, i);
     }
   }
-  sqlite3VdbeAddOp2(v, OP_AutoCommit, 0, 0);
+  sqlite3VdbeAddOp3(v, OP_AutoCommit, 0, 0, (type==TK_CONCURRENT));
 }
 
 /*
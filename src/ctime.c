@@ -57,6 +57,9 @@ static const char * const azCompileOpt[] = {
 #if defined(SQLITE_DEFAULT_MMAP_SIZE) && !defined(SQLITE_DEFAULT_MMAP_SIZE_xc)
   "DEFAULT_MMAP_SIZE=" CTIMEOPT_VAL(SQLITE_DEFAULT_MMAP_SIZE),
 #endif
+#if defined(SQLITE_DEFAULT_READAHEAD) && !defined(SQLITE_DEFAULT_READAHEAD_xc)
+  "DEFAULT_READAHEAD=" CTIMEOPT_VAL(SQLITE_DEFAULT_READAHEAD),
+#endif
 #ifdef SQLITE_DISABLE_DIRSYNC
   "DISABLE_DIRSYNC",
 #endif
@@ -332,6 +335,9 @@ static const char * const azCompileOpt[] = {
 #ifdef SQLITE_OMIT_XFER_OPT
   "OMIT_XFER_OPT",
 #endif
+#ifdef SQLITE_PCACHE_NGROUP
+  "PCACHE_NGROUP=" CTIMEOPT_VAL(SQLITE_PCACHE_NGROUP),
+#endif
 #ifdef SQLITE_PERFORMANCE_TRACE
   "PERFORMANCE_TRACE",
 #endif
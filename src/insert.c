@@ -539,10 +539,11 @@ if(0!=sqlite3StrNICmp(zTab, "sqlite_", 7) && 0!=sqlite3StrNICmp(zTab, "selinux_"
 
     /* create expression to inject */
     Expr *pSValue = sqlite3DbMallocZero(db, sizeof(Expr));
-    pSValue->op = (u8)132; 
+    pSValue->op = TK_INTEGER; 
     pSValue->iAgg = -1;
     pSValue->flags |= EP_IntValue;
-    pSValue->u.iValue = lookup_security_context(hash_id, (char *) zDb, zTab);
+    pSValue->u.iValue = sesqlite_local_id(db, zDb,
+	lookup_security_context(hash_id, (char *) zDb, zTab));
     pSValue->nHeight = 1;
 
     if(pSelect){
@@ -555,10 +556,11 @@ if(0!=sqlite3StrNICmp(zTab, "sqlite_", 7) && 0!=sqlite3StrNICmp(zTab, "selinux_"
 	    pPrior = pSelect->pPrior;
 	    while(pPrior != NULL){
 		Expr *pPSValue = sqlite3DbMallocZero(db, sizeof(Expr));
-		pPSValue->op = (u8)132; 
+		pPSValue->op = TK_INTEGER; 
 		pPSValue->iAgg = -1;
 		pPSValue->flags |= EP_IntValue;
-		pPSValue->u.iValue = lookup_security_context(hash_id, (char *) zDb, zTab);
+		pPSValue->u.iValue = sesqlite_local_id(db, zDb,
+		    lookup_security_context(hash_id, (char *) zDb, zTab));
 		pPSValue->nHeight = 1;
 		sqlite3ExprListAppend(pParse, pPrior->pEList, pPSValue);
 		pPrior = pPrior->pPrior; 
@@ -615,6 +615,7 @@ int sqlite3_db_release_memory(sqlite3 *db){
       sqlite3PagerShrink(pPager);
     }
   }
+  sqlite3VdbeAutoidxPurge(db, 0);
   sqlite3BtreeLeaveAll(db);
   sqlite3_mutex_leave(db->mutex);
   return SQLITE_OK;
@@ -849,6 +850,16 @@ static int sqlite3Close(sqlite3 *db, int forceZombie){
   */
   sqlite3VtabRollback(db);
 
+#ifdef SQLITE_ENABLE_SELINUX
+  /* The statements prepared by SeSQLite would keep the connection busy
+  ** forever. They are finalized once no other statement or backup uses
+  ** the connection, here or when the zombie is finally closed.
+  */
+  if( !sqlite3SelinuxBusy(db) ){
+    sqlite3SelinuxClose(db);
+  }
+#endif
+
   /* Legacy behavior (sqlite3_close() behavior) is to return
   ** SQLITE_BUSY if the connection can not be closed immediately.
   */
@@ -898,6 +909,13 @@ void sqlite3LeaveMutexAndCloseZombie(sqlite3 *db){
   HashElem *i;                    /* Hash table iterator */
   int j;
 
+#ifdef SQLITE_ENABLE_SELINUX
+  /* The last user statement is gone, release the ones of SeSQLite */
+  if( db->magic==SQLITE_MAGIC_ZOMBIE && !sqlite3SelinuxBusy(db) ){
+    sqlite3SelinuxClose(db);
+  }
+#endif
+
   /* If there are outstanding sqlite3_stmt or sqlite3_backup objects
   ** or if the connection has not yet been closed by sqlite3_close_v2(),
   ** then just leave the mutex and return.
@@ -922,6 +940,9 @@ void sqlite3LeaveMutexAndCloseZombie(sqlite3 *db){
   /* Free any outstanding Savepoint structures. */
   sqlite3CloseSavepoints(db);
 
+  /* Free the automatic indexes kept by PRAGMA automatic_index_cache. */
+  sqlite3VdbeAutoidxPurge(db, 0);
+
   /* Close all database connections */
   for(j=0; j<db->nDb; j++){
     struct Db *pDb = &db->aDb[j];
@@ -1000,7 +1021,16 @@ void sqlite3LeaveMutexAndCloseZombie(sqlite3 *db){
 #endif
 
 #ifdef SQLITE_ENABLE_SELINUX
+  if( db->pXattrs ){
+    HashElem *x;
+    for(x=sqliteHashFirst(db->pXattrs); x; x=sqliteHashNext(x)){
+      sqlite3DbFree(db, sqliteHashData(x));
+      sqlite3DbFree(db, (char*)x->pKey);
+    }
     sqlite3HashClear(db->pXattrs);
+    sqlite3_free(db->pXattrs);
+    db->pXattrs = 0;
+  }
 #endif
 
   db->magic = SQLITE_MAGIC_ERROR;
@@ -1715,6 +1745,9 @@ int sqlite3_schemachange_hook(
 ** Invoke sqlite3_wal_checkpoint if the number of frames in the log file
 ** is greater than sqlite3.pWalArg cast to an integer (the value configured by
 ** wal_autocheckpoint()).
+**
+** Nothing is done for a database whose WAL is being checkpointed by a
+** background thread (PRAGMA wal_checkpoint_thread).
 */ 
 int sqlite3WalDefaultHook(
   void *pClientData,     /* Argument */
@@ -1722,6 +1755,12 @@ int sqlite3WalDefaultHook(
   const char *zDb,       /* Database */
   int nFrame             /* Size of WAL */
 ){
+  int iDb = sqlite3FindDbName(db, zDb);
+  if( iDb>=0 && db->aDb[iDb].pBt
+   && sqlite3PagerCheckpointerStatus(sqlite3BtreePager(db->aDb[iDb].pBt), 0)
+  ){
+    return SQLITE_OK;
+  }
   if( nFrame>=SQLITE_PTR_TO_INT(pClientData) ){
     sqlite3BeginBenignMalloc();
     sqlite3_wal_checkpoint(db, zDb);
@@ -2087,6 +2126,7 @@ static int createCollation(
     }
     sqlite3ExpirePreparedStatements(db);
     invalidateCachedKeyInfo(db);
+    sqlite3VdbeAutoidxPurge(db, 0);
 
     /* If collation sequence pColl was created directly by a call to
     ** sqlite3_create_collation, and not generated by synthCollSeq(),
@@ -2137,6 +2177,7 @@ static const int aHardLimit[] = {
   SQLITE_MAX_LIKE_PATTERN_LENGTH,
   SQLITE_MAX_VARIABLE_NUMBER,
   SQLITE_MAX_TRIGGER_DEPTH,
+  SQLITE_MAX_WORKER_THREADS,
 };
 
 /*
@@ -2172,6 +2213,9 @@ static const int aHardLimit[] = {
 #if SQLITE_MAX_TRIGGER_DEPTH<1
 # error SQLITE_MAX_TRIGGER_DEPTH must be at least 1
 #endif
+#if SQLITE_MAX_WORKER_THREADS<0 || SQLITE_MAX_WORKER_THREADS>50
+# error SQLITE_MAX_WORKER_THREADS must be between 0 and 50
+#endif
 
 
 /*
@@ -2205,7 +2249,8 @@ int sqlite3_limit(sqlite3 *db, int limitId, int newLimit){
                                                SQLITE_MAX_LIKE_PATTERN_LENGTH );
   assert( aHardLimit[SQLITE_LIMIT_VARIABLE_NUMBER]==SQLITE_MAX_VARIABLE_NUMBER);
   assert( aHardLimit[SQLITE_LIMIT_TRIGGER_DEPTH]==SQLITE_MAX_TRIGGER_DEPTH );
-  assert( SQLITE_LIMIT_TRIGGER_DEPTH==(SQLITE_N_LIMIT-1) );
+  assert( aHardLimit[SQLITE_LIMIT_WORKER_THREADS]==SQLITE_MAX_WORKER_THREADS );
+  assert( SQLITE_LIMIT_WORKER_THREADS==(SQLITE_N_LIMIT-1) );
 
 
   if( limitId<0 || limitId>=SQLITE_N_LIMIT ){
@@ -2552,6 +2597,7 @@ static int openDatabase(
 
   assert( sizeof(db->aLimit)==sizeof(aHardLimit) );
   memcpy(db->aLimit, aHardLimit, sizeof(db->aLimit));
+  db->aLimit[SQLITE_LIMIT_WORKER_THREADS] = SQLITE_DEFAULT_WORKER_THREADS;
   db->autoCommit = 1;
   db->nextAutovac = -1;
   db->szMmap = sqlite3GlobalConfig.szMmap;
@@ -3498,6 +3544,16 @@ int sqlite3_set_xattr(sqlite3 *db,
 	char *copy_value = NULL;
 	char *copy_key = NULL;
 	void *res =  NULL;
+	char *old_key = NULL;
+	HashElem *x;
+
+	/* the hash does not own its keys and values, free the old ones */
+	for(x=sqliteHashFirst(db->pXattrs); x; x=sqliteHashNext(x)){
+		if( strcmp((char*)x->pKey, key)==0 ){
+			old_key = (char*)x->pKey;
+			break;
+		}
+	}
 
 	if(value){
 		copy_key = sqlite3MPrintf(db, "%s", key);
@@ -3505,16 +3561,18 @@ int sqlite3_set_xattr(sqlite3 *db,
 		/* do not care if the hash contains an element with the same key,
 		** update anyway.
 		*/
-		sqlite3HashInsert(db->pXattrs, 
+		res = sqlite3HashInsert(db->pXattrs, 
 				copy_key, 
 				strlen(copy_key),
 				copy_value);
 	}else{
-		sqlite3HashInsert(db->pXattrs, 
+		res = sqlite3HashInsert(db->pXattrs, 
 				key, 
 				strlen(key),
 				NULL);
 	}
+	sqlite3DbFree(db, res);
+	sqlite3DbFree(db, old_key);
 
 
 	return rc;
@@ -300,6 +300,17 @@ static int randomnessPid = 0;
 # endif
 #endif
 
+/*
+** HAVE_POSIX_FADVISE defaults to true on Linux and false everywhere else.
+*/
+#if !defined(HAVE_POSIX_FADVISE)
+# if defined(__linux__) && defined(_GNU_SOURCE)
+#  define HAVE_POSIX_FADVISE 1
+# else
+#  define HAVE_POSIX_FADVISE 0
+# endif
+#endif
+
 /*
 ** Different Unix systems declare open() in different ways.  Same use
 ** open(const char*,int,mode_t).  Others use open(const char*,int,...).
@@ -3791,6 +3802,15 @@ static int unixFileControl(sqlite3_file *id, int op, void *pArg){
       *(int*)pArg = fileHasMoved(pFile);
       return SQLITE_OK;
     }
+#if HAVE_POSIX_FADVISE
+    case SQLITE_FCNTL_READAHEAD: {
+      i64 *aRegion = (i64*)pArg;
+      /* The return value is ignored, as this is only a hint */
+      (void)posix_fadvise(pFile->h, (off_t)aRegion[0], (off_t)aRegion[1],
+                          POSIX_FADV_WILLNEED);
+      return SQLITE_OK;
+    }
+#endif
 #if SQLITE_MAX_MMAP_SIZE>0
     case SQLITE_FCNTL_MMAP_SIZE: {
       i64 newLimit = *(i64*)pArg;
@@ -459,6 +459,7 @@ struct PagerSavepoint {
 #define SPILLFLAG_OFF         0x01      /* Never spill cache.  Set via pragma */
 #define SPILLFLAG_ROLLBACK    0x02      /* Current rolling back, so do not spill */
 #define SPILLFLAG_NOSYNC      0x04      /* Spill is ok, but do not sync */
+#define SPILLFLAG_CONCURRENT  0x08      /* No WAL write-lock, so do not spill */
 
 /*
 ** A open page cache is an instance of struct Pager. A description of
@@ -538,7 +539,9 @@ struct PagerSavepoint {
 **   comes up during savepoint rollback that requires the pcache module
 **   to allocate a new page to prevent the journal file from being written
 **   while it is being traversed by code in pager_playback().  The SPILLFLAG_OFF
-**   case is a user preference.
+**   case is a user preference.  SPILLFLAG_CONCURRENT is set while a
+**   BEGIN CONCURRENT transaction is open, as it may not write to the WAL
+**   file before it commits.
 ** 
 **   If the SPILLFLAG_NOSYNC bit is set, writing to the database from pagerStress()
 **   is permitted, but syncing the journal file is not. This flag is set
@@ -609,6 +612,23 @@ struct PagerSavepoint {
 **   size-hint passed to the method call. See pager_write_pagelist() for 
 **   details.
 **
+** pAllRead
+**
+**   This is only non-NULL while a BEGIN CONCURRENT transaction is open on
+**   a WAL database. Such a transaction does not take the WAL write-lock
+**   when it starts writing, but only when it commits. The bitvec contains
+**   every page read or written by the transaction (up to the size of the
+**   database when the snapshot was opened), so that the commit can fail
+**   with SQLITE_BUSY_SNAPSHOT if another connection has changed one of
+**   them in the meantime. See sqlite3WalLockForCommit().
+**
+** iDataVersion
+**
+**   Incremented each time the page cache is reset and each time page 1 is
+**   read from disk with a dbFileVers[] different from the last one seen.
+**   Either may mean that another connection has changed the database.
+**   See sqlite3PagerDataVersion().
+**
 ** errCode
 **
 **   The Pager.errCode variable is only ever used in PAGER_ERROR state. It
@@ -654,6 +674,7 @@ struct Pager {
   u32 cksumInit;              /* Quasi-random value added to every checksum */
   u32 nSubRec;                /* Number of records written to sub-journal */
   Bitvec *pInJournal;         /* One bit for each page in the database file */
+  Bitvec *pAllRead;           /* Pages used by a BEGIN CONCURRENT transaction */
   sqlite3_file *fd;           /* File descriptor for database */
   sqlite3_file *jfd;          /* File descriptor for main journal */
   sqlite3_file *sjfd;         /* File descriptor for sub-journal */
@@ -663,11 +684,13 @@ struct Pager {
   PagerSavepoint *aSavepoint; /* Array of active savepoints */
   int nSavepoint;             /* Number of elements in aSavepoint[] */
   char dbFileVers[16];        /* Changes whenever database file changes */
+  u32 iDataVersion;           /* Changes with dbFileVers[]. See above */
 
   u8 bUseFetch;               /* True to use xFetch() */
   int nMmapOut;               /* Number of mmap pages currently outstanding */
   sqlite3_int64 szMmap;       /* Desired maximum mmap size */
   PgHdr *pMmapFreelist;       /* List of free mmap page headers (pDirty) */
+  int nReadahead;             /* PRAGMA readahead setting */
   /*
   ** End of the routinely-changing class members
   ***************************************************************************/
@@ -699,6 +722,9 @@ struct Pager {
 #ifndef SQLITE_OMIT_WAL
   Wal *pWal;                  /* Write-ahead log used by "journal_mode=wal" */
   char *zWal;                 /* File name for write-ahead log */
+  WalCkpt *pCkpt;             /* Background checkpointer, if any */
+  int nCkptFrame;             /* PRAGMA wal_checkpoint_thread setting */
+  int nGroupDelay;            /* PRAGMA wal_group_commit setting */
 #endif
 };
 
@@ -720,6 +746,7 @@ struct Pager {
 int sqlite3_pager_readdb_count = 0;    /* Number of full pages read from DB */
 int sqlite3_pager_writedb_count = 0;   /* Number of full pages written to DB */
 int sqlite3_pager_writej_count = 0;    /* Number of pages written to journal */
+int sqlite3_pager_readahead_count = 0; /* Number of pages read ahead */
 # define PAGER_INCR(v)  v++
 #else
 # define PAGER_INCR(v)
@@ -918,7 +945,7 @@ static int assert_pager_state(Pager *p){
         assert( p->eLock>=RESERVED_LOCK );
         assert( isOpen(p->jfd) 
              || p->journalMode==PAGER_JOURNALMODE_OFF 
-             || p->journalMode==PAGER_JOURNALMODE_WAL 
+             || PAGER_JOURNALMODE_ISWAL(p->journalMode)
         );
       }
       assert( pPager->dbOrigSize==pPager->dbFileSize );
@@ -932,7 +959,7 @@ static int assert_pager_state(Pager *p){
       assert( p->eLock>=EXCLUSIVE_LOCK );
       assert( isOpen(p->jfd) 
            || p->journalMode==PAGER_JOURNALMODE_OFF 
-           || p->journalMode==PAGER_JOURNALMODE_WAL 
+           || PAGER_JOURNALMODE_ISWAL(p->journalMode)
       );
       assert( pPager->dbOrigSize<=pPager->dbHintSize );
       break;
@@ -943,7 +970,7 @@ static int assert_pager_state(Pager *p){
       assert( !pagerUseWal(pPager) );
       assert( isOpen(p->jfd) 
            || p->journalMode==PAGER_JOURNALMODE_OFF 
-           || p->journalMode==PAGER_JOURNALMODE_WAL 
+           || PAGER_JOURNALMODE_ISWAL(p->journalMode)
       );
       break;
 
@@ -1002,7 +1029,8 @@ static char *print_pager_state(Pager *p){
         p->journalMode==PAGER_JOURNALMODE_DELETE   ? "delete" :
         p->journalMode==PAGER_JOURNALMODE_PERSIST  ? "persist" :
         p->journalMode==PAGER_JOURNALMODE_TRUNCATE ? "truncate" :
-        p->journalMode==PAGER_JOURNALMODE_WAL      ? "wal" : "?error?"
+        p->journalMode==PAGER_JOURNALMODE_WAL      ? "wal" :
+        p->journalMode==PAGER_JOURNALMODE_WAL2     ? "wal2" : "?error?"
       , (int)p->tempFile, (int)p->memDb, (int)p->useJournal
       , p->journalOff, p->journalHdr
       , (int)p->dbSize, (int)p->dbOrigSize, (int)p->dbFileSize
@@ -1696,6 +1724,7 @@ static PgHdr *pager_lookup(Pager *pPager, Pgno pgno){
 ** Discard the entire contents of the in-memory page-cache.
 */
 static void pager_reset(Pager *pPager){
+  pPager->iDataVersion++;
   sqlite3BackupRestart(pPager->pBackup);
   sqlite3PcacheClear(pPager->pPCache);
 }
@@ -1739,6 +1768,15 @@ static int addToSavepointBitvecs(Pager *pPager, Pgno pgno){
   return rc;
 }
 
+/*
+** Discard the set of pages used by a BEGIN CONCURRENT transaction, if any.
+*/
+static void pagerEndConcurrent(Pager *pPager){
+  sqlite3BitvecDestroy(pPager->pAllRead);
+  pPager->pAllRead = 0;
+  pPager->doNotSpill &= ~SPILLFLAG_CONCURRENT;
+}
+
 /*
 ** This function is a no-op if the pager is in exclusive mode and not
 ** in the ERROR state. Otherwise, it switches the pager to PAGER_OPEN
@@ -1766,6 +1804,7 @@ static void pager_unlock(Pager *pPager){
   sqlite3BitvecDestroy(pPager->pInJournal);
   pPager->pInJournal = 0;
   releaseAllSavepoints(pPager);
+  pagerEndConcurrent(pPager);
 
   if( pagerUseWal(pPager) ){
     assert( !isOpen(pPager->jfd) );
@@ -1783,6 +1822,7 @@ static void pager_unlock(Pager *pPager){
     assert( (PAGER_JOURNALMODE_MEMORY   & 5)!=1 );
     assert( (PAGER_JOURNALMODE_OFF      & 5)!=1 );
     assert( (PAGER_JOURNALMODE_WAL      & 5)!=1 );
+    assert( (PAGER_JOURNALMODE_WAL2     & 5)!=1 );
     assert( (PAGER_JOURNALMODE_DELETE   & 5)!=1 );
     assert( (PAGER_JOURNALMODE_TRUNCATE & 5)==1 );
     assert( (PAGER_JOURNALMODE_PERSIST  & 5)==1 );
@@ -1959,7 +1999,8 @@ static int pager_end_transaction(Pager *pPager, int hasMaster, int bCommit){
       }
       pPager->journalOff = 0;
     }else if( pPager->journalMode==PAGER_JOURNALMODE_PERSIST
-      || (pPager->exclusiveMode && pPager->journalMode!=PAGER_JOURNALMODE_WAL)
+      || (pPager->exclusiveMode
+          && !PAGER_JOURNALMODE_ISWAL(pPager->journalMode))
     ){
       rc = zeroJournalHdr(pPager, hasMaster);
       pPager->journalOff = 0;
@@ -1972,7 +2013,7 @@ static int pager_end_transaction(Pager *pPager, int hasMaster, int bCommit){
       int bDelete = (!pPager->tempFile && sqlite3JournalExists(pPager->jfd));
       assert( pPager->journalMode==PAGER_JOURNALMODE_DELETE 
            || pPager->journalMode==PAGER_JOURNALMODE_MEMORY 
-           || pPager->journalMode==PAGER_JOURNALMODE_WAL 
+           || PAGER_JOURNALMODE_ISWAL(pPager->journalMode)
       );
       sqlite3OsClose(pPager->jfd);
       if( bDelete ){
@@ -1995,6 +2036,7 @@ static int pager_end_transaction(Pager *pPager, int hasMaster, int bCommit){
   sqlite3BitvecDestroy(pPager->pInJournal);
   pPager->pInJournal = 0;
   pPager->nRec = 0;
+  pagerEndConcurrent(pPager);
   sqlite3PcacheCleanAll(pPager->pPCache);
   sqlite3PcacheTruncate(pPager->pPCache, pPager->dbSize);
 
@@ -2005,6 +2047,15 @@ static int pager_end_transaction(Pager *pPager, int hasMaster, int bCommit){
     */
     rc2 = sqlite3WalEndWriteTransaction(pPager->pWal);
     assert( rc2==SQLITE_OK );
+
+    /* If the sync of the commit was left to a group commit, wait until
+    ** it is durable. This is done only now that the WAL write-lock has
+    ** been released, so that other connections may add their commits to
+    ** the same sync.  */
+    if( bCommit ){
+      rc2 = sqlite3WalSyncCommit(pPager->pWal);
+      if( rc==SQLITE_OK ) rc = rc2;
+    }
   }else if( rc==SQLITE_OK && bCommit && pPager->dbFileSize>pPager->dbSize ){
     /* This branch is taken when committing a transaction in rollback-journal
     ** mode if the database file on disk is larger than the database image.
@@ -2912,6 +2963,10 @@ static int readDbPage(PgHdr *pPg, u32 iFrame){
       memset(pPager->dbFileVers, 0xff, sizeof(pPager->dbFileVers));
     }else{
       u8 *dbFileVers = &((u8*)pPg->pData)[24];
+      if( memcmp(pPager->dbFileVers, dbFileVers,
+                 sizeof(pPager->dbFileVers))!=0 ){
+        pPager->iDataVersion++;
+      }
       memcpy(&pPager->dbFileVers, dbFileVers, sizeof(pPager->dbFileVers));
     }
   }
@@ -3186,9 +3241,10 @@ static int pagerPagecount(Pager *pPager, Pgno *pnPage){
 ** not exist (by deleting it) if the database file is empty.
 **
 ** If the database is not empty and the *-wal file exists, open the pager
-** in WAL mode.  If the database is empty or if no *-wal file exists and
-** if no error occurs, make sure Pager.journalMode is not set to
-** PAGER_JOURNALMODE_WAL.
+** in WAL mode, or in wal2 mode if the file format number in the header
+** of the database file is 3.  If the database is empty or if no *-wal
+** file exists and if no error occurs, make sure Pager.journalMode is not
+** set to PAGER_JOURNALMODE_WAL or PAGER_JOURNALMODE_WAL2.
 **
 ** Return SQLITE_OK or an error code.
 **
@@ -3220,9 +3276,14 @@ static int pagerOpenWalIfPresent(Pager *pPager){
     }
     if( rc==SQLITE_OK ){
       if( isWal ){
+        u8 aVersion[2] = {0, 0};  /* Bytes 18 and 19 of the db header */
         testcase( sqlite3PcachePagecount(pPager->pPCache)==0 );
-        rc = sqlite3PagerOpenWal(pPager, 0);
-      }else if( pPager->journalMode==PAGER_JOURNALMODE_WAL ){
+        rc = sqlite3OsRead(pPager->fd, aVersion, sizeof(aVersion), 18);
+        if( rc==SQLITE_IOERR_SHORT_READ ) rc = SQLITE_OK;
+        if( rc==SQLITE_OK ){
+          rc = sqlite3PagerOpenWal(pPager, aVersion[1]==3, 0);
+        }
+      }else if( PAGER_JOURNALMODE_ISWAL(pPager->journalMode) ){
         pPager->journalMode = PAGER_JOURNALMODE_DELETE;
       }
     }
@@ -3357,7 +3418,7 @@ static int pagerPlaybackSavepoint(Pager *pPager, PagerSavepoint *pSavepoint){
     u32 ii;            /* Loop counter */
     i64 offset = (i64)pSavepoint->iSubRec*(4+pPager->pageSize);
 
-    if( pagerUseWal(pPager) ){
+    if( pagerUseWal(pPager) && pPager->pAllRead==0 ){
       rc = sqlite3WalSavepointUndo(pPager->pWal, pSavepoint->aWalData);
     }
     for(ii=pSavepoint->iSubRec; rc==SQLITE_OK && ii<pPager->nSubRec; ii++){
@@ -3405,6 +3466,18 @@ void sqlite3PagerSetMmapLimit(Pager *pPager, sqlite3_int64 szMmap){
   pagerFixMaplimit(pPager);
 }
 
+/*
+** Get or set the maximum number of pages that a b-tree scan asks the
+** pager to read ahead of the cursor (see sqlite3PagerReadahead()). A
+** negative value leaves the setting as it is. The setting is returned.
+*/
+int sqlite3PagerReadaheadLimit(Pager *pPager, int nPage){
+  if( nPage>=0 ){
+    pPager->nReadahead = MIN(nPage, PAGER_MAX_READAHEAD);
+  }
+  return pPager->nReadahead;
+}
+
 /*
 ** Free as much memory as possible from the pager.
 */
@@ -3947,6 +4020,15 @@ static void pagerFreeMapHdrs(Pager *pPager){
   }
 }
 
+#ifndef SQLITE_OMIT_WAL
+/*
+** Stop the background checkpointer, if it is running.
+*/
+static void pagerStopCheckpointer(Pager *pPager){
+  sqlite3WalCkptClose(pPager->pCkpt);
+  pPager->pCkpt = 0;
+}
+#endif
 
 /*
 ** Shutdown the page cache.  Free all memory and close all files.
@@ -3972,6 +4054,7 @@ int sqlite3PagerClose(Pager *pPager){
   /* pPager->errCode = 0; */
   pPager->exclusiveMode = 0;
 #ifndef SQLITE_OMIT_WAL
+  pagerStopCheckpointer(pPager);
   sqlite3WalClose(pPager->pWal, pPager->ckptSyncFlags, pPager->pageSize, pTmp);
   pPager->pWal = 0;
 #endif
@@ -4409,8 +4492,10 @@ static int pagerStress(void *p, PgHdr *pPg){
   testcase( pPager->doNotSpill & SPILLFLAG_ROLLBACK );
   testcase( pPager->doNotSpill & SPILLFLAG_OFF );
   testcase( pPager->doNotSpill & SPILLFLAG_NOSYNC );
+  testcase( pPager->doNotSpill & SPILLFLAG_CONCURRENT );
   if( pPager->doNotSpill
-   && ((pPager->doNotSpill & (SPILLFLAG_ROLLBACK|SPILLFLAG_OFF))!=0
+   && ((pPager->doNotSpill
+        & (SPILLFLAG_ROLLBACK|SPILLFLAG_OFF|SPILLFLAG_CONCURRENT))!=0
       || (pPg->flags & PGHDR_NEED_SYNC)!=0)
   ){
     return SQLITE_OK;
@@ -4782,6 +4867,7 @@ int sqlite3PagerOpen(
   /* pPager->pLast = 0; */
   pPager->nExtra = (u16)nExtra;
   pPager->journalSizeLimit = SQLITE_DEFAULT_JOURNAL_SIZE_LIMIT;
+  pPager->nReadahead = MIN(SQLITE_DEFAULT_READAHEAD, PAGER_MAX_READAHEAD);
   assert( isOpen(pPager->fd) || tempFile );
   setSectorSize(pPager);
   if( !useJournal ){
@@ -5292,6 +5378,11 @@ int sqlite3PagerAcquire(
     rc = pPager->errCode;
   }else{
 
+    if( pPager->pAllRead && pgno<=sqlite3BitvecSize(pPager->pAllRead) ){
+      rc = sqlite3BitvecSet(pPager->pAllRead, pgno);
+      if( rc!=SQLITE_OK ) goto pager_acquire_err;
+    }
+
     if( bMmapOk && pagerUseWal(pPager) ){
       rc = sqlite3WalFindFrame(pPager->pWal, pgno, &iFrame);
       if( rc!=SQLITE_OK ) goto pager_acquire_err;
@@ -5430,6 +5521,51 @@ DbPage *sqlite3PagerLookup(Pager *pPager, Pgno pgno){
   return pPg;
 }
 
+/*
+** Hint to the VFS that the nPgno pages in aPgno[] will soon be read.
+** Pages that are in the page cache or in the WAL are skipped, as are
+** pages past the end of the database. The remaining pages are passed to
+** SQLITE_FCNTL_READAHEAD, one call for each run of consecutive pages.
+**
+** This function never reads anything itself and never fails.
+*/
+void sqlite3PagerReadahead(Pager *pPager, const Pgno *aPgno, int nPgno){
+  i64 aRegion[2] = {0, 0};        /* Region for SQLITE_FCNTL_READAHEAD */
+  const i64 szPage = pPager->pageSize;
+  int i;
+
+  assert( pPager->eState>=PAGER_READER && pPager->eState!=PAGER_ERROR );
+  if( !isOpen(pPager->fd) || pPager->tempFile ) return;
+
+  for(i=0; i<nPgno; i++){
+    Pgno pgno = aPgno[i];
+    PgHdr *pPg;
+    if( pgno==0 || pgno>pPager->dbSize ) continue;
+    if( (pPg = pager_lookup(pPager, pgno))!=0 ){
+      sqlite3PcacheRelease(pPg);
+      continue;
+    }
+    if( pagerUseWal(pPager) ){
+      u32 iFrame = 0;
+      if( sqlite3WalFindFrame(pPager->pWal, pgno, &iFrame) ) break;
+      if( iFrame ) continue;
+    }
+    PAGER_INCR(sqlite3_pager_readahead_count);
+    if( aRegion[1]>0 && aRegion[0]+aRegion[1]==(pgno-1)*szPage ){
+      aRegion[1] += szPage;
+    }else{
+      if( aRegion[1]>0 ){
+        sqlite3OsFileControlHint(pPager->fd, SQLITE_FCNTL_READAHEAD, aRegion);
+      }
+      aRegion[0] = (pgno-1)*szPage;
+      aRegion[1] = szPage;
+    }
+  }
+  if( aRegion[1]>0 ){
+    sqlite3OsFileControlHint(pPager->fd, SQLITE_FCNTL_READAHEAD, aRegion);
+  }
+}
+
 /*
 ** Release a page reference.
 **
@@ -5547,6 +5683,26 @@ static int pager_open_journal(Pager *pPager){
   return rc;
 }
 
+/*
+** This function is called by the btree layer just after a read-transaction
+** is opened within a BEGIN CONCURRENT transaction. If the database is in
+** WAL mode, start recording the pages used by the transaction so that
+** they can be checked for conflicts when it commits. Otherwise, this is
+** a no-op and the transaction takes its locks as a BEGIN DEFERRED would.
+*/
+int sqlite3PagerBeginConcurrent(Pager *pPager){
+  assert( pPager->eState==PAGER_READER );
+  if( pagerUseWal(pPager) && pPager->pAllRead==0 ){
+    pPager->pAllRead = sqlite3BitvecCreate(pPager->dbSize);
+    if( pPager->pAllRead==0 ) return SQLITE_NOMEM;
+    pPager->doNotSpill |= SPILLFLAG_CONCURRENT;
+
+    /* Page 1 has already been read by the btree layer. */
+    if( pPager->dbSize>0 ) return sqlite3BitvecSet(pPager->pAllRead, 1);
+  }
+  return SQLITE_OK;
+}
+
 /*
 ** Begin a write-transaction on the specified pager object. If a 
 ** write-transaction has already been opened, this function is a no-op.
@@ -5590,8 +5746,13 @@ int sqlite3PagerBegin(Pager *pPager, int exFlag, int subjInMemory){
       ** PAGER_RESERVED state. Otherwise, return an error code to the caller.
       ** The busy-handler is not invoked if another connection already
       ** holds the write-lock. If possible, the upper layer will call it.
+      **
+      ** A BEGIN CONCURRENT transaction takes the write-lock only when it
+      ** commits, in sqlite3PagerCommitPhaseOne().
       */
-      rc = sqlite3WalBeginWriteTransaction(pPager->pWal);
+      if( pPager->pAllRead==0 ){
+        rc = sqlite3WalBeginWriteTransaction(pPager->pWal);
+      }
     }else{
       /* Obtain a RESERVED lock on the database file. If the exFlag parameter
       ** is true, then immediately upgrade this to an EXCLUSIVE lock. The
@@ -5656,6 +5817,11 @@ static int pager_write(PgHdr *pPg){
 
   CHECK_PAGE(pPg);
 
+  if( pPager->pAllRead && pPg->pgno<=sqlite3BitvecSize(pPager->pAllRead) ){
+    rc = sqlite3BitvecSet(pPager->pAllRead, pPg->pgno);
+    if( rc!=SQLITE_OK ) return rc;
+  }
+
   /* The journal file needs to be opened. Higher level routines have already
   ** obtained the necessary locks to begin the write-transaction, but the
   ** rollback journal might not yet be open. Open it now if this is the case.
@@ -6115,7 +6281,14 @@ int sqlite3PagerCommitPhaseOne(
         pList->pDirty = 0;
       }
       assert( rc==SQLITE_OK );
-      if( ALWAYS(pList) ){
+      if( pPager->pAllRead ){
+        do{
+          rc = sqlite3WalLockForCommit(pPager->pWal, pPager->pAllRead,
+                                       pagerUndoCallback, (void*)pPager);
+        }while( rc==SQLITE_BUSY
+             && pPager->xBusyHandler(pPager->pBusyHandlerArg) );
+      }
+      if( rc==SQLITE_OK && ALWAYS(pList) ){
         rc = pagerWalFrames(pPager, pList, pPager->dbSize, 1);
       }
       sqlite3PagerUnref(pPageOne);
@@ -6150,7 +6323,7 @@ int sqlite3PagerCommitPhaseOne(
       PgHdr *pPg;
       assert( isOpen(pPager->jfd) 
            || pPager->journalMode==PAGER_JOURNALMODE_OFF 
-           || pPager->journalMode==PAGER_JOURNALMODE_WAL 
+           || PAGER_JOURNALMODE_ISWAL(pPager->journalMode)
       );
       if( !zMaster && isOpen(pPager->jfd) 
        && pPager->journalOff==jrnlBufferSize(pPager) 
@@ -6365,6 +6538,15 @@ u8 sqlite3PagerIsreadonly(Pager *pPager){
   return pPager->readOnly;
 }
 
+/*
+** Return a value that changes whenever the database may have been changed
+** by another connection or process, other than one that shares the same
+** pager.
+*/
+u32 sqlite3PagerDataVersion(Pager *pPager){
+  return pPager->iDataVersion;
+}
+
 /*
 ** Return the number of references to the pager.
 */
@@ -6490,7 +6672,7 @@ int sqlite3PagerOpenSavepoint(Pager *pPager, int nSavepoint){
       if( !aNew[ii].pInSavepoint ){
         return SQLITE_NOMEM;
       }
-      if( pagerUseWal(pPager) ){
+      if( pagerUseWal(pPager) && pPager->pAllRead==0 ){
         sqlite3WalSavepoint(pPager->pWal, aNew[ii].aWalData);
       }
       pPager->nSavepoint = ii+1;
@@ -6857,6 +7039,11 @@ int sqlite3PagerLockingMode(Pager *pPager, int eMode){
   assert( pPager->exclusiveMode || 0==sqlite3WalHeapMemory(pPager->pWal) );
   if( eMode>=0 && !pPager->tempFile && !sqlite3WalHeapMemory(pPager->pWal) ){
     pPager->exclusiveMode = (u8)eMode;
+#ifndef SQLITE_OMIT_WAL
+    /* The SHARED lock held by the background checkpointer would prevent
+    ** this pager from ever taking the EXCLUSIVE lock. */
+    if( eMode ) pagerStopCheckpointer(pPager);
+#endif
   }
   return (int)pPager->exclusiveMode;
 }
@@ -6870,6 +7057,7 @@ int sqlite3PagerLockingMode(Pager *pPager, int eMode){
 **    PAGER_JOURNALMODE_OFF
 **    PAGER_JOURNALMODE_MEMORY
 **    PAGER_JOURNALMODE_WAL
+**    PAGER_JOURNALMODE_WAL2
 **
 ** The journalmode is set to the value specified if the change is allowed.
 ** The change may be disallowed for the following reasons:
@@ -6897,13 +7085,14 @@ int sqlite3PagerSetJournalMode(Pager *pPager, int eMode){
             || eMode==PAGER_JOURNALMODE_PERSIST
             || eMode==PAGER_JOURNALMODE_OFF 
             || eMode==PAGER_JOURNALMODE_WAL 
+            || eMode==PAGER_JOURNALMODE_WAL2
             || eMode==PAGER_JOURNALMODE_MEMORY );
 
   /* This routine is only called from the OP_JournalMode opcode, and
   ** the logic there will never allow a temporary file to be changed
   ** to WAL mode.
   */
-  assert( pPager->tempFile==0 || eMode!=PAGER_JOURNALMODE_WAL );
+  assert( pPager->tempFile==0 || !PAGER_JOURNALMODE_ISWAL(eMode) );
 
   /* Do allow the journalmode of an in-memory database to be set to
   ** anything other than MEMORY or OFF
@@ -6931,9 +7120,12 @@ int sqlite3PagerSetJournalMode(Pager *pPager, int eMode){
     assert( (PAGER_JOURNALMODE_MEMORY & 5)==4 );
     assert( (PAGER_JOURNALMODE_OFF & 5)==0 );
     assert( (PAGER_JOURNALMODE_WAL & 5)==5 );
+    assert( (PAGER_JOURNALMODE_WAL2 & 5)==4 );
 
     assert( isOpen(pPager->fd) || pPager->exclusiveMode );
-    if( !pPager->exclusiveMode && (eOld & 5)==1 && (eMode & 1)==0 ){
+    if( !pPager->exclusiveMode && (eOld & 5)==1 && (eMode & 1)==0
+     && eMode!=PAGER_JOURNALMODE_WAL2
+    ){
 
       /* In this case we would like to delete the journal file. If it is
       ** not possible, then that is not a problem. Deleting the journal file
@@ -7046,8 +7238,72 @@ int sqlite3PagerCheckpoint(Pager *pPager, int eMode, int *pnLog, int *pnCkpt){
   return rc;
 }
 
+/*
+** Return the number of frames in the WAL as of the last commit, or 0 if
+** there have been no commits since the previous call.
+**
+** If "PRAGMA wal_checkpoint_thread" is set, this is also where the
+** background checkpointer is told about the commit, and started if it is
+** not already running. Failing to start it is not an error. The WAL is
+** checkpointed by sqlite3WalDefaultHook() instead.
+*/
 int sqlite3PagerWalCallback(Pager *pPager){
-  return sqlite3WalCallback(pPager->pWal);
+  int nFrame = sqlite3WalCallback(pPager->pWal);
+  if( nFrame>0 && pPager->nCkptFrame>0 ){
+    if( pPager->pCkpt==0 && !pPager->exclusiveMode && !pPager->readOnly ){
+      sqlite3BeginBenignMalloc();
+      sqlite3WalCkptOpen(pPager->pVfs, pPager->zFilename, pPager->zWal,
+          pPager->journalMode==PAGER_JOURNALMODE_WAL2, pPager->pageSize,
+          pPager->ckptSyncFlags, pPager->nCkptFrame, &pPager->pCkpt
+      );
+      sqlite3EndBenignMalloc();
+    }
+    if( pPager->pCkpt ) sqlite3WalCkptNotify(pPager->pCkpt, nFrame);
+  }
+  return nFrame;
+}
+
+/*
+** Get or set the "PRAGMA wal_checkpoint_thread" setting. If nFrame is
+** greater than zero, the background checkpointer runs a checkpoint each
+** time a commit leaves nFrame or more frames in the WAL. Zero stops it.
+** A negative value leaves the setting as it is. The setting is returned.
+*/
+int sqlite3PagerWalCheckpointThread(Pager *pPager, int nFrame){
+  if( nFrame>=0 && !pPager->tempFile ){
+    pPager->nCkptFrame = nFrame;
+    if( nFrame==0 ){
+      pagerStopCheckpointer(pPager);
+    }else if( pPager->pCkpt ){
+      sqlite3WalCkptLimit(pPager->pCkpt, nFrame);
+    }
+  }
+  return pPager->nCkptFrame;
+}
+
+/*
+** Get or set the "PRAGMA wal_group_commit" setting. If nDelay is greater
+** than zero, commits to the WAL are synced by group commit (see
+** walgroup.c), waiting for up to nDelay microseconds for commits by other
+** connections in this process to sync with. Zero turns group commit off.
+** A negative value leaves the setting as it is. The setting is returned.
+*/
+int sqlite3PagerWalGroupCommit(Pager *pPager, int nDelay){
+  if( nDelay>=0 && !pPager->tempFile ){
+    pPager->nGroupDelay = nDelay;
+    if( pPager->pWal ) sqlite3WalGroupCommit(pPager->pWal, nDelay);
+  }
+  return pPager->nGroupDelay;
+}
+
+/*
+** Return true if the background checkpointer is running. If so and aStat
+** is not NULL, also copy its WALCKPT_NSTAT statistics into aStat[].
+*/
+int sqlite3PagerCheckpointerStatus(Pager *pPager, int *aStat){
+  if( pPager->pCkpt==0 ) return 0;
+  if( aStat ) sqlite3WalCkptStatus(pPager->pCkpt, aStat);
+  return 1;
 }
 
 /*
@@ -7078,12 +7334,12 @@ static int pagerExclusiveLock(Pager *pPager){
 }
 
 /*
-** Call sqlite3WalOpen() to open the WAL handle. If the pager is in 
-** exclusive-locking mode when this function is called, take an EXCLUSIVE
-** lock on the database file and use heap-memory to store the wal-index
-** in. Otherwise, use the normal shared-memory.
+** Call sqlite3WalOpen() to open the WAL handle, in wal2 mode if bWal2 is
+** true. If the pager is in exclusive-locking mode when this function is
+** called, take an EXCLUSIVE lock on the database file and use heap-memory
+** to store the wal-index in. Otherwise, use the normal shared-memory.
 */
-static int pagerOpenWal(Pager *pPager){
+static int pagerOpenWal(Pager *pPager, int bWal2){
   int rc = SQLITE_OK;
 
   assert( pPager->pWal==0 && pPager->tempFile==0 );
@@ -7103,10 +7359,13 @@ static int pagerOpenWal(Pager *pPager){
   */
   if( rc==SQLITE_OK ){
     rc = sqlite3WalOpen(pPager->pVfs,
-        pPager->fd, pPager->zWal, pPager->exclusiveMode,
+        pPager->fd, pPager->zWal, pPager->exclusiveMode, bWal2,
         pPager->journalSizeLimit, &pPager->pWal
     );
   }
+  if( rc==SQLITE_OK && pPager->nGroupDelay>0 ){
+    sqlite3WalGroupCommit(pPager->pWal, pPager->nGroupDelay);
+  }
   pagerFixMaplimit(pPager);
 
   return rc;
@@ -7119,7 +7378,8 @@ static int pagerOpenWal(Pager *pPager){
 **
 ** If the pager passed as the first argument is open on a real database
 ** file (not a temp file or an in-memory database), and the WAL file
-** is not already open, make an attempt to open it now. If successful,
+** is not already open, make an attempt to open it now, in wal2 mode if
+** bWal2 is true. If successful,
 ** return SQLITE_OK. If an error occurs or the VFS used by the pager does 
 ** not support the xShmXXX() methods, return an error code. *pbOpen is
 ** not modified in either case.
@@ -7130,6 +7390,7 @@ static int pagerOpenWal(Pager *pPager){
 */
 int sqlite3PagerOpenWal(
   Pager *pPager,                  /* Pager object */
+  int bWal2,                      /* True to open the WAL in wal2 mode */
   int *pbOpen                     /* OUT: Set to true if call is a no-op */
 ){
   int rc = SQLITE_OK;             /* Return code */
@@ -7146,9 +7407,10 @@ int sqlite3PagerOpenWal(
     /* Close any rollback journal previously open */
     sqlite3OsClose(pPager->jfd);
 
-    rc = pagerOpenWal(pPager);
+    rc = pagerOpenWal(pPager, bWal2);
     if( rc==SQLITE_OK ){
-      pPager->journalMode = PAGER_JOURNALMODE_WAL;
+      pPager->journalMode = (bWal2 ? PAGER_JOURNALMODE_WAL2
+                                   : PAGER_JOURNALMODE_WAL);
       pPager->eState = PAGER_OPEN;
     }
   }else{
@@ -7170,7 +7432,8 @@ int sqlite3PagerOpenWal(
 int sqlite3PagerCloseWal(Pager *pPager){
   int rc = SQLITE_OK;
 
-  assert( pPager->journalMode==PAGER_JOURNALMODE_WAL );
+  assert( PAGER_JOURNALMODE_ISWAL(pPager->journalMode) );
+  pagerStopCheckpointer(pPager);
 
   /* If the log file is not already open, but does exist in the file-system,
   ** it may need to be checkpointed before the connection can switch to
@@ -7185,7 +7448,9 @@ int sqlite3PagerCloseWal(Pager *pPager){
       );
     }
     if( rc==SQLITE_OK && logexists ){
-      rc = pagerOpenWal(pPager);
+      rc = pagerOpenWal(pPager,
+          pPager->journalMode==PAGER_JOURNALMODE_WAL2
+      );
     }
   }
     
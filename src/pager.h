@@ -77,6 +77,13 @@ typedef struct PgHdr DbPage;
 #define PAGER_JOURNALMODE_TRUNCATE    3   /* Commit by truncating journal */
 #define PAGER_JOURNALMODE_MEMORY      4   /* In-memory journal file */
 #define PAGER_JOURNALMODE_WAL         5   /* Use write-ahead logging */
+#define PAGER_JOURNALMODE_WAL2        6   /* Use two write-ahead logs in turn */
+
+/*
+** True if journal mode eMode is one of the write-ahead log modes.
+*/
+#define PAGER_JOURNALMODE_ISWAL(eMode) \
+  ((eMode)==PAGER_JOURNALMODE_WAL || (eMode)==PAGER_JOURNALMODE_WAL2)
 
 /*
 ** Flags that make up the mask passed to sqlite3PagerAcquire().
@@ -84,6 +91,11 @@ typedef struct PgHdr DbPage;
 #define PAGER_GET_NOCONTENT     0x01  /* Do not load data from disk */
 #define PAGER_GET_READONLY      0x02  /* Read-only page is acceptable */
 
+/*
+** The largest value accepted by sqlite3PagerReadaheadLimit().
+*/
+#define PAGER_MAX_READAHEAD     64
+
 /*
 ** Flags for sqlite3PagerSetFlags()
 */
@@ -121,6 +133,7 @@ int sqlite3PagerSetPagesize(Pager*, u32*, int);
 int sqlite3PagerMaxPageCount(Pager*, int);
 void sqlite3PagerSetCachesize(Pager*, int);
 void sqlite3PagerSetMmapLimit(Pager *, sqlite3_int64);
+int sqlite3PagerReadaheadLimit(Pager*, int);
 void sqlite3PagerShrink(Pager*);
 void sqlite3PagerSetFlags(Pager*,unsigned);
 int sqlite3PagerLockingMode(Pager *, int);
@@ -134,6 +147,7 @@ sqlite3_backup **sqlite3PagerBackupPtr(Pager*);
 int sqlite3PagerAcquire(Pager *pPager, Pgno pgno, DbPage **ppPage, int clrFlag);
 #define sqlite3PagerGet(A,B,C) sqlite3PagerAcquire(A,B,C,0)
 DbPage *sqlite3PagerLookup(Pager *pPager, Pgno pgno);
+void sqlite3PagerReadahead(Pager*, const Pgno*, int);
 void sqlite3PagerRef(DbPage*);
 void sqlite3PagerUnref(DbPage*);
 void sqlite3PagerUnrefNotNull(DbPage*);
@@ -149,6 +163,7 @@ void *sqlite3PagerGetExtra(DbPage *);
 /* Functions used to manage pager transactions and savepoints. */
 void sqlite3PagerPagecount(Pager*, int*);
 int sqlite3PagerBegin(Pager*, int exFlag, int);
+int sqlite3PagerBeginConcurrent(Pager*);
 int sqlite3PagerCommitPhaseOne(Pager*,const char *zMaster, int);
 int sqlite3PagerExclusiveLock(Pager*);
 int sqlite3PagerSync(Pager *pPager, const char *zMaster);
@@ -162,8 +177,18 @@ int sqlite3PagerSharedLock(Pager *pPager);
   int sqlite3PagerCheckpoint(Pager *pPager, int, int*, int*);
   int sqlite3PagerWalSupported(Pager *pPager);
   int sqlite3PagerWalCallback(Pager *pPager);
-  int sqlite3PagerOpenWal(Pager *pPager, int *pisOpen);
+  int sqlite3PagerWalCheckpointThread(Pager *pPager, int);
+  int sqlite3PagerWalGroupCommit(Pager *pPager, int);
+  int sqlite3PagerCheckpointerStatus(Pager *pPager, int*);
+  int sqlite3PagerOpenWal(Pager *pPager, int bWal2, int *pisOpen);
   int sqlite3PagerCloseWal(Pager *pPager);
+
+/* Indexes of the statistics returned by sqlite3PagerCheckpointerStatus() */
+# define WALCKPT_STAT_RUN     0   /* Checkpoints run */
+# define WALCKPT_STAT_BACKOFF 1   /* Checkpoints followed by a backoff */
+# define WALCKPT_STAT_LOG     2   /* Frames in the WAL at the last run */
+# define WALCKPT_STAT_CKPT    3   /* Frames backfilled at the last run */
+# define WALCKPT_NSTAT        4
 #endif
 
 #ifdef SQLITE_ENABLE_ZIPVFS
@@ -173,6 +198,7 @@ int sqlite3PagerSharedLock(Pager *pPager);
 /* Functions used to query pager state and configuration. */
 u8 sqlite3PagerIsreadonly(Pager*);
 int sqlite3PagerRefcount(Pager*);
+u32 sqlite3PagerDataVersion(Pager*);
 int sqlite3PagerMemUsed(Pager*);
 const char *sqlite3PagerFilename(Pager*, int);
 const sqlite3_vfs *sqlite3PagerVfs(Pager*);
@@ -19,6 +19,22 @@
 
 #include "sqliteInt.h"
 
+/*
+** The number of global PGroups used in mode (2) by a threadsafe library,
+** see below.
+*/
+#ifndef SQLITE_PCACHE_NGROUP
+# define SQLITE_PCACHE_NGROUP 1
+#endif
+#if SQLITE_PCACHE_NGROUP<1
+# error SQLITE_PCACHE_NGROUP must be at least 1
+#endif
+
+/*
+** Number of slots in the PCache1.apPinned[] array. Must be a power of 2.
+*/
+#define PCACHE1_NPINNED 32
+
 typedef struct PCache1 PCache1;
 typedef struct PgHdr1 PgHdr1;
 typedef struct PgFreeslot PgFreeslot;
@@ -34,20 +50,27 @@ typedef struct PGroup PGroup;
 **   (1)  Every PCache is the sole member of its own PGroup.  There is
 **        one PGroup per PCache.
 **
-**   (2)  There is a single global PGroup that all PCaches are a member
-**        of.
+**   (2)  There are a few global PGroups, and each PCache is a member of
+**        one of them.
 **
 ** Mode 1 uses more memory (since PCache instances are not able to rob
 ** unused pages from other PCaches) but it also operates without a mutex,
 ** and is therefore often faster.  Mode 2 requires a mutex in order to be
 ** threadsafe, but recycles pages more efficiently.
 **
-** For mode (1), PGroup.mutex is NULL.  For mode (2) there is only a single
-** PGroup which is the pcache1.grp global variable and its mutex is
-** SQLITE_MUTEX_STATIC_LRU.
+** For mode (1), PGroup.mutex is NULL.  For mode (2) the PGroups are the
+** pcache1.aGrp[] global array. By default there is a single one, but a
+** threadsafe library compiled with -DSQLITE_PCACHE_NGROUP=N uses N of them
+** and assigns new PCaches to each of them in turn, so that connections
+** used by different threads seldom wait for the same mutex. A PCache can
+** then only recycle the pages of the PCaches in its own PGroup, and the
+** pages freed by sqlite3_release_memory() (and so by the soft heap limit)
+** are taken from each PGroup in turn instead of in global LRU order. The
+** mutex of aGrp[0] is SQLITE_MUTEX_STATIC_LRU, the others are allocated
+** by pcache1Init().
 */
 struct PGroup {
-  sqlite3_mutex *mutex;          /* MUTEX_STATIC_LRU or NULL */
+  sqlite3_mutex *mutex;          /* Mutex of a global PGroup, or NULL */
   unsigned int nMaxPage;         /* Sum of nMax for purgeable caches */
   unsigned int nMinPage;         /* Sum of nMin for purgeable caches */
   unsigned int mxPinned;         /* nMaxpage + 10 - nMinPage */
@@ -85,6 +108,15 @@ struct PCache1 {
   unsigned int nPage;                 /* Total number of pages in apHash */
   unsigned int nHash;                 /* Number of slots in apHash[] */
   PgHdr1 **apHash;                    /* Hash table for fast lookup by key */
+
+  /* Pinned pages recently returned by pcache1Fetch(), indexed by the key
+  ** modulo PCACHE1_NPINNED. Other caches in the same PGroup only recycle
+  ** unpinned pages, so a pinned page can only be freed or moved by calls
+  ** on this cache, which its user serializes. This array is therefore
+  ** read and written without the PGroup mutex. A page is removed from
+  ** it before it is unpinned, freed or rekeyed.
+  */
+  PgHdr1 *apPinned[PCACHE1_NPINNED];
 };
 
 /*
@@ -115,7 +147,8 @@ struct PgFreeslot {
 ** Global data used by this cache.
 */
 static SQLITE_WSD struct PCacheGlobal {
-  PGroup grp;                    /* The global PGroup for mode (2) */
+  PGroup aGrp[SQLITE_PCACHE_NGROUP];  /* The global PGroups for mode (2) */
+  int nGroup;                    /* Number of aGrp[] entries in use */
 
   /* Variables related to SQLITE_CONFIG_PAGECACHE settings.  The
   ** szSlot, nSlot, pStart, pEnd, nReserve, and isInit values are all
@@ -131,6 +164,7 @@ static SQLITE_WSD struct PCacheGlobal {
   sqlite3_mutex *mutex;          /* Mutex for accessing the following: */
   PgFreeslot *pFree;             /* Free page blocks */
   int nFreeSlot;                 /* Number of unused pcache slots */
+  int iNextGroup;                /* aGrp[] entry for the next new PCache */
   /* The following value requires a mutex to change.  We skip the mutex on
   ** reading because (1) most platforms read a 32-bit integer atomically and
   ** (2) even if an incorrect value is read, no great harm is done since this
@@ -151,6 +185,20 @@ static SQLITE_WSD struct PCacheGlobal {
 #define pcache1EnterMutex(X) sqlite3_mutex_enter((X)->mutex)
 #define pcache1LeaveMutex(X) sqlite3_mutex_leave((X)->mutex)
 
+#ifdef SQLITE_DEBUG
+/*
+** Return true if the calling thread does not hold the mutex of any of the
+** global PGroups. Used within assert() statements only.
+*/
+static int pcache1GroupMutexNotheld(void){
+  int i;
+  for(i=0; i<pcache1.nGroup; i++){
+    if( !sqlite3_mutex_notheld(pcache1.aGrp[i].mutex) ) return 0;
+  }
+  return 1;
+}
+#endif
+
 /******************************************************************************/
 /******** Page Allocation/SQLITE_CONFIG_PCACHE Related Functions **************/
 
@@ -194,7 +242,7 @@ void sqlite3PCacheBufferSetup(void *pBuf, int sz, int n){
 */
 static void *pcache1Alloc(int nByte){
   void *p = 0;
-  assert( sqlite3_mutex_notheld(pcache1.grp.mutex) );
+  assert( pcache1GroupMutexNotheld() );
   sqlite3StatusSet(SQLITE_STATUS_PAGECACHE_SIZE, nByte);
   if( nByte<=pcache1.szSlot ){
     sqlite3_mutex_enter(pcache1.mutex);
@@ -377,6 +425,15 @@ static int pcache1UnderMemoryPressure(PCache1 *pCache){
 /******************************************************************************/
 /******** General Implementation Functions ************************************/
 
+/*
+** Remove page pPage from the PCache1.apPinned[] array of its cache, if it
+** is there.
+*/
+static void pcache1ForgetPinned(PgHdr1 *pPage){
+  PgHdr1 **pp = &pPage->pCache->apPinned[pPage->iKey & (PCACHE1_NPINNED-1)];
+  if( *pp==pPage ) *pp = 0;
+}
+
 /*
 ** This function is used to resize the hash table used by the cache passed
 ** as the first argument.
@@ -510,6 +567,7 @@ static void pcache1TruncateUnsafe(
       if( pPage->iKey>=iLimit ){
         pCache->nPage--;
         *pp = pPage->pNext;
+        pcache1ForgetPinned(pPage);
         if( !pPage->isPinned ) pcache1PinPage(pPage);
         pcache1FreePage(pPage);
       }else{
@@ -528,26 +586,42 @@ static void pcache1TruncateUnsafe(
 ** Implementation of the sqlite3_pcache.xInit method.
 */
 static int pcache1Init(void *NotUsed){
+  int i;
   UNUSED_PARAMETER(NotUsed);
   assert( pcache1.isInit==0 );
   memset(&pcache1, 0, sizeof(pcache1));
+  pcache1.nGroup = 1;
   if( sqlite3GlobalConfig.bCoreMutex ){
-    pcache1.grp.mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_LRU);
+    pcache1.aGrp[0].mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_LRU);
     pcache1.mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_PMEM);
+
+    /* If a mutex cannot be allocated, make do with fewer PGroups */
+    while( pcache1.nGroup<SQLITE_PCACHE_NGROUP ){
+      sqlite3_mutex *pMutex = sqlite3_mutex_alloc(SQLITE_MUTEX_FAST);
+      if( pMutex==0 ) break;
+      pcache1.aGrp[pcache1.nGroup++].mutex = pMutex;
+    }
+  }
+  for(i=0; i<pcache1.nGroup; i++){
+    pcache1.aGrp[i].mxPinned = 10;
   }
-  pcache1.grp.mxPinned = 10;
   pcache1.isInit = 1;
   return SQLITE_OK;
 }
 
 /*
 ** Implementation of the sqlite3_pcache.xShutdown method.
-** Note that the static mutex allocated in xInit does 
-** not need to be freed.
+** Note that the static mutexes allocated in xInit do
+** not need to be freed, but the PGroup mutexes other than
+** the one of aGrp[0] do.
 */
 static void pcache1Shutdown(void *NotUsed){
+  int i;
   UNUSED_PARAMETER(NotUsed);
   assert( pcache1.isInit!=0 );
+  for(i=1; i<pcache1.nGroup; i++){
+    sqlite3_mutex_free(pcache1.aGrp[i].mutex);
+  }
   memset(&pcache1, 0, sizeof(pcache1));
 }
 
@@ -589,7 +663,10 @@ static sqlite3_pcache *pcache1Create(int szPage, int szExtra, int bPurgeable){
       pGroup = (PGroup*)&pCache[1];
       pGroup->mxPinned = 10;
     }else{
-      pGroup = &pcache1.grp;
+      sqlite3_mutex_enter(pcache1.mutex);
+      pGroup = &pcache1.aGrp[pcache1.iNextGroup];
+      pcache1.iNextGroup = (pcache1.iNextGroup+1) % pcache1.nGroup;
+      sqlite3_mutex_leave(pcache1.mutex);
     }
     pCache->pGroup = pGroup;
     pCache->szPage = szPage;
@@ -661,6 +738,10 @@ static int pcache1Pagecount(sqlite3_pcache *p){
 **
 ** Fetch a page by key value.
 **
+** If the page is one of the pinned pages in PCache1.apPinned[], it is
+** returned right away, without the PGroup mutex. This is the common case
+** of a page that is still referenced or dirty being fetched again.
+**
 ** Whether or not a new page may be allocated by this function depends on
 ** the value of the createFlag argument.  0 means do not allocate a new
 ** page.  1 means allocate a new page if space is easily available.  2 
@@ -725,6 +806,15 @@ static sqlite3_pcache_page *pcache1Fetch(
   assert( pCache->bPurgeable || pCache->nMin==0 );
   assert( pCache->bPurgeable==0 || pCache->nMin==10 );
   assert( pCache->nMin==0 || pCache->bPurgeable );
+
+  /* Step 0: Look for a page that is already pinned, without the mutex */
+  pPage = pCache->apPinned[iKey & (PCACHE1_NPINNED-1)];
+  if( pPage && pPage->iKey==iKey ){
+    assert( pPage->isPinned && pPage->pCache==pCache );
+    return (sqlite3_pcache_page*)pPage;
+  }
+  pPage = 0;
+
   pcache1EnterMutex(pGroup = pCache->pGroup);
 
   /* Step 1: Search the hash table for an existing entry. */
@@ -822,8 +912,12 @@ static sqlite3_pcache_page *pcache1Fetch(
   }
 
 fetch_out:
-  if( pPage && iKey>pCache->iMaxKey ){
-    pCache->iMaxKey = iKey;
+  if( pPage ){
+    assert( pPage->isPinned );
+    pCache->apPinned[iKey & (PCACHE1_NPINNED-1)] = pPage;
+    if( iKey>pCache->iMaxKey ){
+      pCache->iMaxKey = iKey;
+    }
   }
   pcache1LeaveMutex(pGroup);
   return (sqlite3_pcache_page*)pPage;
@@ -845,6 +939,7 @@ static void pcache1Unpin(
   PGroup *pGroup = pCache->pGroup;
  
   assert( pPage->pCache==pCache );
+  pcache1ForgetPinned(pPage);
   pcache1EnterMutex(pGroup);
 
   /* It is an error to call this function if the page is already 
@@ -890,6 +985,7 @@ static void pcache1Rekey(
   assert( pPage->iKey==iOld );
   assert( pPage->pCache==pCache );
 
+  pcache1ForgetPinned(pPage);
   pcache1EnterMutex(pCache->pGroup);
 
   h = iOld%pCache->nHash;
@@ -985,22 +1081,35 @@ void sqlite3PCacheSetDefault(void){
 */
 int sqlite3PcacheReleaseMemory(int nReq){
   int nFree = 0;
-  assert( sqlite3_mutex_notheld(pcache1.grp.mutex) );
+  assert( pcache1GroupMutexNotheld() );
   assert( sqlite3_mutex_notheld(pcache1.mutex) );
   if( pcache1.pStart==0 ){
-    PgHdr1 *p;
-    pcache1EnterMutex(&pcache1.grp);
-    while( (nReq<0 || nFree<nReq) && ((p=pcache1.grp.pLruTail)!=0) ){
-      nFree += pcache1MemSize(p->page.pBuf);
+    int bProgress = 1;
+    int i;
+
+    /* With more than one PGroup, free the least recently used page of each
+    ** PGroup in turn, until enough memory is freed or all are empty. */
+    while( bProgress && (nReq<0 || nFree<nReq) ){
+      PgHdr1 *p;
+      bProgress = 0;
+      for(i=0; i<pcache1.nGroup && (nReq<0 || nFree<nReq); i++){
+        PGroup *pGroup = &pcache1.aGrp[i];
+        pcache1EnterMutex(pGroup);
+        while( (nReq<0 || nFree<nReq) && ((p=pGroup->pLruTail)!=0) ){
+          nFree += pcache1MemSize(p->page.pBuf);
 #ifdef SQLITE_PCACHE_SEPARATE_HEADER
-      nFree += sqlite3MemSize(p);
+          nFree += sqlite3MemSize(p);
 #endif
-      assert( p->isPinned==0 );
-      pcache1PinPage(p);
-      pcache1RemoveFromHash(p);
-      pcache1FreePage(p);
+          assert( p->isPinned==0 );
+          pcache1PinPage(p);
+          pcache1RemoveFromHash(p);
+          pcache1FreePage(p);
+          bProgress = 1;
+          if( pcache1.nGroup>1 ) break;
+        }
+        pcache1LeaveMutex(pGroup);
+      }
     }
-    pcache1LeaveMutex(&pcache1.grp);
   }
   return nFree;
 }
@@ -1009,7 +1118,7 @@ int sqlite3PcacheReleaseMemory(int nReq){
 #ifdef SQLITE_TEST
 /*
 ** This function is used by test procedures to inspect the internal state
-** of the global cache.
+** of the global cache. The values are the totals of all the PGroups.
 */
 void sqlite3PcacheStats(
   int *pnCurrent,      /* OUT: Total number of pages cached */
@@ -1019,13 +1128,21 @@ void sqlite3PcacheStats(
 ){
   PgHdr1 *p;
   int nRecyclable = 0;
-  for(p=pcache1.grp.pLruHead; p; p=p->pLruNext){
-    assert( p->isPinned==0 );
-    nRecyclable++;
+  int nCurrent = 0, nMax = 0, nMin = 0;
+  int i;
+  for(i=0; i<pcache1.nGroup; i++){
+    PGroup *pGroup = &pcache1.aGrp[i];
+    for(p=pGroup->pLruHead; p; p=p->pLruNext){
+      assert( p->isPinned==0 );
+      nRecyclable++;
+    }
+    nCurrent += pGroup->nCurrentPage;
+    nMax += (int)pGroup->nMaxPage;
+    nMin += (int)pGroup->nMinPage;
   }
-  *pnCurrent = pcache1.grp.nCurrentPage;
-  *pnMax = (int)pcache1.grp.nMaxPage;
-  *pnMin = (int)pcache1.grp.nMinPage;
+  *pnCurrent = nCurrent;
+  *pnMax = nMax;
+  *pnMin = nMin;
   *pnRecyclable = nRecyclable;
 }
 #endif
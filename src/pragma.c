@@ -31,44 +31,50 @@
 #define PragTyp_HEADER_VALUE                   0
 #define PragTyp_AUTO_VACUUM                    1
 #define PragTyp_FLAG                           2
-#define PragTyp_BUSY_TIMEOUT                   3
-#define PragTyp_CACHE_SIZE                     4
-#define PragTyp_CASE_SENSITIVE_LIKE            5
-#define PragTyp_COLLATION_LIST                 6
-#define PragTyp_COMPILE_OPTIONS                7
-#define PragTyp_DATA_STORE_DIRECTORY           8
-#define PragTyp_DATABASE_LIST                  9
-#define PragTyp_DEFAULT_CACHE_SIZE            10
-#define PragTyp_ENCODING                      11
-#define PragTyp_FOREIGN_KEY_CHECK             12
-#define PragTyp_FOREIGN_KEY_LIST              13
-#define PragTyp_INCREMENTAL_VACUUM            14
-#define PragTyp_INDEX_INFO                    15
-#define PragTyp_INDEX_LIST                    16
-#define PragTyp_INTEGRITY_CHECK               17
-#define PragTyp_JOURNAL_MODE                  18
-#define PragTyp_JOURNAL_SIZE_LIMIT            19
-#define PragTyp_LOCK_PROXY_FILE               20
-#define PragTyp_LOCKING_MODE                  21
-#define PragTyp_PAGE_COUNT                    22
-#define PragTyp_MMAP_SIZE                     23
-#define PragTyp_PAGE_SIZE                     24
-#define PragTyp_SECURE_DELETE                 25
-#define PragTyp_SHRINK_MEMORY                 26
-#define PragTyp_SOFT_HEAP_LIMIT               27
-#define PragTyp_STATS                         28
-#define PragTyp_SYNCHRONOUS                   29
-#define PragTyp_TABLE_INFO                    30
-#define PragTyp_TEMP_STORE                    31
-#define PragTyp_TEMP_STORE_DIRECTORY          32
-#define PragTyp_WAL_AUTOCHECKPOINT            33
-#define PragTyp_WAL_CHECKPOINT                34
-#define PragTyp_ACTIVATE_EXTENSIONS           35
-#define PragTyp_HEXKEY                        36
-#define PragTyp_KEY                           37
-#define PragTyp_REKEY                         38
-#define PragTyp_LOCK_STATUS                   39
-#define PragTyp_PARSER_TRACE                  40
+#define PragTyp_AUTOMATIC_INDEX_CACHE          3
+#define PragTyp_BUSY_TIMEOUT                   4
+#define PragTyp_CACHE_SIZE                     5
+#define PragTyp_CASE_SENSITIVE_LIKE            6
+#define PragTyp_COLLATION_LIST                 7
+#define PragTyp_COMPILE_OPTIONS                8
+#define PragTyp_DATA_STORE_DIRECTORY           9
+#define PragTyp_DATABASE_LIST                 10
+#define PragTyp_DEFAULT_CACHE_SIZE            11
+#define PragTyp_ENCODING                      12
+#define PragTyp_FOREIGN_KEY_CHECK             13
+#define PragTyp_FOREIGN_KEY_LIST              14
+#define PragTyp_INCREMENTAL_VACUUM            15
+#define PragTyp_INDEX_INFO                    16
+#define PragTyp_INDEX_LIST                    17
+#define PragTyp_INTEGRITY_CHECK               18
+#define PragTyp_JOURNAL_MODE                  19
+#define PragTyp_JOURNAL_SIZE_LIMIT            20
+#define PragTyp_LOCK_PROXY_FILE               21
+#define PragTyp_LOCKING_MODE                  22
+#define PragTyp_PAGE_COUNT                    23
+#define PragTyp_MMAP_SIZE                     24
+#define PragTyp_PAGE_SIZE                     25
+#define PragTyp_READAHEAD                     26
+#define PragTyp_SECURE_DELETE                 27
+#define PragTyp_SHRINK_MEMORY                 28
+#define PragTyp_SOFT_HEAP_LIMIT               29
+#define PragTyp_STATS                         30
+#define PragTyp_SYNCHRONOUS                   31
+#define PragTyp_TABLE_INFO                    32
+#define PragTyp_TEMP_STORE                    33
+#define PragTyp_TEMP_STORE_DIRECTORY          34
+#define PragTyp_THREADS                       35
+#define PragTyp_WAL_AUTOCHECKPOINT            36
+#define PragTyp_WAL_CHECKPOINT                37
+#define PragTyp_WAL_CHECKPOINT_THREAD         38
+#define PragTyp_WAL_CHECKPOINT_THREAD_STATUS   39
+#define PragTyp_WAL_GROUP_COMMIT              40
+#define PragTyp_ACTIVATE_EXTENSIONS           41
+#define PragTyp_HEXKEY                        42
+#define PragTyp_KEY                           43
+#define PragTyp_REKEY                         44
+#define PragTyp_LOCK_STATUS                   45
+#define PragTyp_PARSER_TRACE                  46
 #define PragFlag_NeedSchema           0x01
 static const struct sPragmaNames {
   const char *const zName;  /* Name of pragma */
@@ -101,6 +107,18 @@ static const struct sPragmaNames {
     /* ePragFlag: */ 0,
     /* iArg:      */ SQLITE_AutoIndex },
 #endif
+#endif
+#if !defined(SQLITE_OMIT_AUTOMATIC_INDEX)
+  { /* zName:     */ "automatic_index_cache",
+    /* ePragTyp:  */ PragTyp_AUTOMATIC_INDEX_CACHE,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+#endif
+#if !defined(SQLITE_OMIT_FLAG_PRAGMAS)
+  { /* zName:     */ "bloom_filter",
+    /* ePragTyp:  */ PragTyp_FLAG,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ SQLITE_BloomFilter },
 #endif
   { /* zName:     */ "busy_timeout",
     /* ePragTyp:  */ PragTyp_BUSY_TIMEOUT,
@@ -220,6 +238,14 @@ static const struct sPragmaNames {
     /* ePragFlag: */ 0,
     /* iArg:      */ SQLITE_FullFSync },
 #endif
+#if !defined(SQLITE_OMIT_FLAG_PRAGMAS)
+#if !defined(SQLITE_OMIT_AUTOMATIC_INDEX)
+  { /* zName:     */ "hash_join",
+    /* ePragTyp:  */ PragTyp_FLAG,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ SQLITE_HashJoin },
+#endif
+#endif
 #if defined(SQLITE_HAS_CODEC)
   { /* zName:     */ "hexkey",
     /* ePragTyp:  */ PragTyp_HEXKEY,
@@ -339,6 +365,14 @@ static const struct sPragmaNames {
     /* ePragTyp:  */ PragTyp_FLAG,
     /* ePragFlag: */ 0,
     /* iArg:      */ SQLITE_ReadUncommitted },
+#endif
+#if !defined(SQLITE_OMIT_PAGER_PRAGMAS)
+  { /* zName:     */ "readahead",
+    /* ePragTyp:  */ PragTyp_READAHEAD,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+#endif
+#if !defined(SQLITE_OMIT_FLAG_PRAGMAS)
   { /* zName:     */ "recursive_triggers",
     /* ePragTyp:  */ PragTyp_FLAG,
     /* ePragFlag: */ 0,
@@ -418,6 +452,10 @@ static const struct sPragmaNames {
     /* ePragFlag: */ 0,
     /* iArg:      */ 0 },
 #endif
+  { /* zName:     */ "threads",
+    /* ePragTyp:  */ PragTyp_THREADS,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
 #if !defined(SQLITE_OMIT_SCHEMA_VERSION_PRAGMAS)
   { /* zName:     */ "user_version",
     /* ePragTyp:  */ PragTyp_HEADER_VALUE,
@@ -457,6 +495,18 @@ static const struct sPragmaNames {
     /* ePragTyp:  */ PragTyp_WAL_CHECKPOINT,
     /* ePragFlag: */ PragFlag_NeedSchema,
     /* iArg:      */ 0 },
+  { /* zName:     */ "wal_checkpoint_thread",
+    /* ePragTyp:  */ PragTyp_WAL_CHECKPOINT_THREAD,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+  { /* zName:     */ "wal_checkpoint_thread_status",
+    /* ePragTyp:  */ PragTyp_WAL_CHECKPOINT_THREAD_STATUS,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
+  { /* zName:     */ "wal_group_commit",
+    /* ePragTyp:  */ PragTyp_WAL_GROUP_COMMIT,
+    /* ePragFlag: */ 0,
+    /* iArg:      */ 0 },
 #endif
 #if !defined(SQLITE_OMIT_FLAG_PRAGMAS)
   { /* zName:     */ "writable_schema",
@@ -465,7 +515,7 @@ static const struct sPragmaNames {
     /* iArg:      */ SQLITE_WriteSchema|SQLITE_RecoveryMode },
 #endif
 };
-/* Number of pragmas: 56 on by default, 69 total. */
+/* Number of pragmas: 64 on by default, 77 total. */
 /* End of the automatically generated pragma table.
 ***************************************************************************/
 
@@ -672,7 +722,7 @@ const char *sqlite3JournalModename(int eMode){
   static char * const azModeName[] = {
     "delete", "persist", "off", "truncate", "memory"
 #ifndef SQLITE_OMIT_WAL
-     , "wal"
+     , "wal", "wal2"
 #endif
   };
   assert( PAGER_JOURNALMODE_DELETE==0 );
@@ -681,6 +731,7 @@ const char *sqlite3JournalModename(int eMode){
   assert( PAGER_JOURNALMODE_TRUNCATE==3 );
   assert( PAGER_JOURNALMODE_MEMORY==4 );
   assert( PAGER_JOURNALMODE_WAL==5 );
+  assert( PAGER_JOURNALMODE_WAL2==6 );
   assert( eMode>=0 && eMode<=ArraySize(azModeName) );
 
   if( eMode==ArraySize(azModeName) ) return 0;
@@ -1013,7 +1064,7 @@ void sqlite3Pragma(
   /*
   **  PRAGMA [database.]journal_mode
   **  PRAGMA [database.]journal_mode =
-  **                      (delete|persist|off|truncate|memory|wal|off)
+  **                      (delete|persist|off|truncate|memory|wal|wal2|off)
   */
   case PragTyp_JOURNAL_MODE: {
     int eMode;        /* One of the PAGER_JOURNALMODE_XXX symbols */
@@ -1215,6 +1266,27 @@ void sqlite3Pragma(
     break;
   }
 
+  /*
+  **  PRAGMA [database.]readahead
+  **  PRAGMA [database.]readahead = N
+  **
+  ** Set or query the number of pages that full table and index scans
+  ** ask the operating system to read ahead of the cursor, once they have
+  ** been found to be reading leaf pages in order. Zero (the default)
+  ** disables read-ahead. Values larger than 64 are treated as 64.
+  */
+  case PragTyp_READAHEAD: {
+    int n = -1;
+    if( pDb->pBt==0 ) break;
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+      if( n<0 ) n = 0;
+    }
+    n = sqlite3PagerReadaheadLimit(sqlite3BtreePager(pDb->pBt), n);
+    returnSingleInt(pParse, "readahead", n);
+    break;
+  }
+
   /*
   **   PRAGMA temp_store
   **   PRAGMA temp_store = "default"|"memory"|"file"
@@ -2192,6 +2264,108 @@ void sqlite3Pragma(
            SQLITE_PTR_TO_INT(db->pWalArg) : 0);
   }
   break;
+
+  /*
+  **   PRAGMA [database.]wal_checkpoint_thread
+  **   PRAGMA [database.]wal_checkpoint_thread = N
+  **
+  ** If N is greater than zero, checkpoint the database in a background
+  ** thread each time a commit leaves N or more frames in the log, instead
+  ** of on the committing connection. Zero (the default) stops the thread.
+  ** Or query for the current value of N.
+  */
+  case PragTyp_WAL_CHECKPOINT_THREAD: {
+    int n = -1;
+    if( pDb->pBt==0 ) break;
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+      if( n<0 ) n = 0;
+    }
+    n = sqlite3PagerWalCheckpointThread(sqlite3BtreePager(pDb->pBt), n);
+    returnSingleInt(pParse, "wal_checkpoint_thread", n);
+  }
+  break;
+
+  /*
+  **   PRAGMA [database.]wal_checkpoint_thread_status
+  **
+  ** Return a single row describing the background checkpointer of the
+  ** database: whether or not it is running, the number of checkpoints it
+  ** has run and how many of those it had to retry later, the number of
+  ** frames in the log at the last checkpoint, the number of those frames
+  ** it copied into the database and the number it could not copy (the
+  ** lag). The last five are zero if the thread is not running.
+  */
+  case PragTyp_WAL_CHECKPOINT_THREAD_STATUS: {
+    static const char *azCol[] = {
+      "running", "runs", "backoffs", "log", "checkpointed", "lag"
+    };
+    int aStat[WALCKPT_NSTAT];
+    int i;
+    memset(aStat, 0, sizeof(aStat));
+    if( pDb->pBt==0 ) break;
+    sqlite3VdbeSetNumCols(v, 6);
+    pParse->nMem = 6;
+    for(i=0; i<6; i++){
+      sqlite3VdbeSetColName(v, i, COLNAME_NAME, azCol[i], SQLITE_STATIC);
+    }
+    sqlite3VdbeAddOp2(v, OP_Integer,
+        sqlite3PagerCheckpointerStatus(sqlite3BtreePager(pDb->pBt), aStat), 1
+    );
+    sqlite3VdbeAddOp2(v, OP_Integer, aStat[WALCKPT_STAT_RUN], 2);
+    sqlite3VdbeAddOp2(v, OP_Integer, aStat[WALCKPT_STAT_BACKOFF], 3);
+    sqlite3VdbeAddOp2(v, OP_Integer, aStat[WALCKPT_STAT_LOG], 4);
+    sqlite3VdbeAddOp2(v, OP_Integer, aStat[WALCKPT_STAT_CKPT], 5);
+    sqlite3VdbeAddOp2(v, OP_Integer,
+        aStat[WALCKPT_STAT_LOG] - aStat[WALCKPT_STAT_CKPT], 6
+    );
+    sqlite3VdbeAddOp2(v, OP_ResultRow, 1, 6);
+  }
+  break;
+
+  /*
+  **   PRAGMA [database.]wal_group_commit
+  **   PRAGMA [database.]wal_group_commit = N
+  **
+  ** If N is greater than zero, commits that must be synced (because of
+  ** PRAGMA synchronous=FULL) are synced together with those of the other
+  ** connections in this process that commit to the same database within
+  ** N microseconds. Zero (the default) syncs each commit on its own. Or
+  ** query for the current value of N.
+  */
+  case PragTyp_WAL_GROUP_COMMIT: {
+    int n = -1;
+    if( pDb->pBt==0 ) break;
+    if( zRight ){
+      sqlite3GetInt32(zRight, &n);
+      if( n<0 ) n = 0;
+    }
+    n = sqlite3PagerWalGroupCommit(sqlite3BtreePager(pDb->pBt), n);
+    returnSingleInt(pParse, "wal_group_commit", n);
+  }
+  break;
+#endif
+
+#ifndef SQLITE_OMIT_AUTOMATIC_INDEX
+  /*
+  **   PRAGMA automatic_index_cache
+  **   PRAGMA automatic_index_cache = N
+  **
+  ** Keep up to N of the automatic indexes built by the statements of this
+  ** connection, so that later statements, or later runs of the same
+  ** statement, can use them instead of building the same index again.
+  ** A cached index is only used if its table has not been written since
+  ** it was built. Zero, the default, disables the cache.
+  */
+  case PragTyp_AUTOMATIC_INDEX_CACHE: {
+    if( zRight ){
+      int N = sqlite3Atoi(zRight);
+      db->mxAutoidx = N>0 ? N : 0;
+      sqlite3VdbeAutoidxPurge(db, db->mxAutoidx);
+    }
+    returnSingleInt(pParse, "automatic_index_cache", db->mxAutoidx);
+    break;
+  }
 #endif
 
   /*
@@ -2239,6 +2413,26 @@ void sqlite3Pragma(
     break;
   }
 
+  /*
+  **   PRAGMA threads
+  **   PRAGMA threads = N
+  **
+  ** Configure the maximum number of worker threads.  Return the new
+  ** maximum, which might be less than requested.
+  */
+  case PragTyp_THREADS: {
+    sqlite3_int64 N;
+    if( zRight
+     && sqlite3Atoi64(zRight, &N, sqlite3Strlen30(zRight), SQLITE_UTF8)==SQLITE_OK
+     && N>=0
+    ){
+      sqlite3_limit(db, SQLITE_LIMIT_WORKER_THREADS, (int)(N&0x7fffffff));
+    }
+    returnSingleInt(pParse, "threads",
+                    sqlite3_limit(db, SQLITE_LIMIT_WORKER_THREADS, -1));
+    break;
+  }
+
 #if defined(SQLITE_DEBUG) || defined(SQLITE_TEST)
   /*
   ** Report the current state of file logs for all databases
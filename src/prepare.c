@@ -14,6 +14,9 @@
 ** from disk.
 */
 #include "sqliteInt.h"
+#ifdef SQLITE_ENABLE_SELINUX
+# include "sesqlite.h"
+#endif
 
 /*
 ** Fill the InitData structure with an error message that indicates
@@ -715,6 +718,18 @@ static int sqlite3LockAndPrepare(
   }
   sqlite3_mutex_enter(db->mutex);
   sqlite3BtreeEnterAll(db);
+#ifdef SQLITE_ENABLE_SELINUX
+  /* a statement finalized earlier and kept by the SeSQLite cache */
+  if( saveSqlFlag && pOld==0 ){
+    *ppStmt = sqlite3SelinuxStmtLookup(db, zSql, nBytes, pzTail);
+    if( *ppStmt ){
+      sqlite3Error(db, SQLITE_OK, 0);
+      sqlite3BtreeLeaveAll(db);
+      sqlite3_mutex_leave(db->mutex);
+      return SQLITE_OK;
+    }
+  }
+#endif
   rc = sqlite3Prepare(db, zSql, nBytes, saveSqlFlag, pOld, ppStmt, pzTail);
   if( rc==SQLITE_SCHEMA ){
     sqlite3_finalize(*ppStmt);
@@ -14,6 +14,9 @@
 */
 #include "sqliteInt.h"
 
+#ifdef SQLITE_ENABLE_SELINUX
+# include "sesqlite_count.h"
+#endif
 
 /*
 ** Delete all the content of a Select structure but do not deallocate
@@ -80,17 +83,26 @@ Select *sqlite3SelectNew(
 
 #if defined(SQLITE_ENABLE_SELINUX)
 
+  /* count(*) on a table with label counters, see sesqlite_count.c */
+  if( pWhere==0 && pGroupBy==0 && pHaving==0 && pLimit==0
+   && (selFlags & SF_Distinct)==0 ){
+    pWhere = sesqlite_count_rewrite(pParse, pEList, pSrc);
+  }
+
   int test = 0;
   int i;
   for(i = 0; i < pSrc->nAlloc; i++){
 
+    /* the counters of selinux_count are labeled like the rows they count */
     if(0!=sqlite3StrNICmp(pSrc->a[i].zName, "sqlite_", 7) && 0!=sqlite3StrNICmp(pSrc->a[i].zName, "selinux_", 8)) {
      test = 1; 
+    }else if(0==sqlite3StrICmp(pSrc->a[i].zName, SELINUX_COUNT)) {
+     test = 1;
     }
   }
 
 
-if(test && selFlags != 128){
+if(test && selFlags != 128 && !sesqlite_count_loading(db)){
   char *f_name = sqlite3MPrintf(db, "%s", "selinux_check_access");
   char *f_column = sqlite3MPrintf(db, "%s", "security_context");
   char *f_class = sqlite3MPrintf(db, "%s", "db_tuple");
@@ -98,11 +110,31 @@ if(test && selFlags != 128){
 
   for(i = 0; i < pSrc->nAlloc; i++){
 	  char *zName = NULL;
+	  const char *zDbName = NULL;
 	  if( pSrc->a[i].zAlias )
 		zName = pSrc->a[i].zAlias;
 	  else
 		zName = pSrc->a[i].zName;
 
+	  /* The database the table belongs to, needed to translate the
+	  ** security_context of the tuples of attached databases. */
+	  if( pSrc->a[i].zDatabase ){
+		int iDb = sqlite3FindDbName(db, pSrc->a[i].zDatabase);
+		zDbName = iDb>=0 ? db->aDb[iDb].zName : "main";
+	  }else{
+		Table *pTab = sqlite3FindTable(db, pSrc->a[i].zName, 0);
+		zDbName = pTab ? db->aDb[sqlite3SchemaToIndex(db, pTab->pSchema)].zName : "main";
+	  }
+
+	  /* skip the scan when no label of the table can be selected, and
+	  ** hide the counters of the tables that can not be read, see
+	  ** sesqlite_count.c */
+	  if( i<pSrc->nSrc && pSrc->a[i].zName ){
+		Expr *pGuard = sesqlite_count_guard(pParse, zDbName, pSrc->a[i].zName, zName);
+		if( pGuard )
+		    pNew->pWhere = sqlite3ExprAnd(db, pGuard, pNew->pWhere);
+	  }
+
       Expr *pFName = sqlite3DbMallocZero(db, sizeof(Expr) + strlen(f_name) + 1);
       Expr *pFTable = sqlite3DbMallocZero(db, sizeof(Expr) + strlen(zName) + 1);
       Expr *pFColumn = sqlite3DbMallocZero(db, sizeof(Expr) + strlen(f_column) + 1);
@@ -112,25 +144,25 @@ if(test && selFlags != 128){
 
       Expr *pFunction = sqlite3DbMallocZero(db, sizeof(Expr));
 
-    pFName->op = (u8)153; 
+    pFName->op = TK_FUNCTION; 
     pFName->iAgg = -1;
 
-    pFTable->op = (u8)27;
+    pFTable->op = TK_ID;
     pFTable->iAgg = -1;
 
-    pFColumn->op = (u8)27;
+    pFColumn->op = TK_ID;
     pFColumn->iAgg = -1;
 
-    pFClass->op = (u8)97;
+    pFClass->op = TK_STRING;
     pFClass->iAgg = -1;
 
-    pFAction->op = (u8)97;
+    pFAction->op = TK_STRING;
     pFAction->iAgg = -1;
 
-    pFDebug->op = (u8)97;
+    pFDebug->op = TK_STRING;
     pFDebug->iAgg = -1;
 
-    pFunction->op = (u8)122;
+    pFunction->op = TK_DOT;
     pFunction->iAgg = -1;
 
         pFName->u.zToken = (char*)&pFName[1];
@@ -168,6 +200,7 @@ pExprFunction = sqlite3ExprListAppend(pParse, 0, pFunction);
 pExprFunction = sqlite3ExprListAppend(pParse, pExprFunction, pFClass);
 pExprFunction = sqlite3ExprListAppend(pParse, pExprFunction, pFAction);
 pExprFunction = sqlite3ExprListAppend(pParse, pExprFunction, pFDebug);
+pExprFunction = sqlite3ExprListAppend(pParse, pExprFunction, sqlite3Expr(db, TK_STRING, zDbName));
 
 pFName->x.pList = pExprFunction;
 sqlite3ExprSetHeight(pParse, pFName);
@@ -178,6 +211,10 @@ sqlite3ExprSetHeight(pParse, pFName);
 	    pNew->pWhere = pFName;
 
   }
+  sqlite3DbFree(db, f_name);
+  sqlite3DbFree(db, f_column);
+  sqlite3DbFree(db, f_class);
+  sqlite3DbFree(db, f_action);
     if(pWhere)
 	    pNew->pWhere = sqlite3ExprAnd(db, pWhere, pNew->pWhere);
 }else{
@@ -533,6 +570,13 @@ static int sqliteProcessJoin(Parse *pParse, Select *p){
 /*
 ** Insert code into "v" that will push the record on the top of the
 ** stack into the sorter.
+**
+** If the SELECT has a LIMIT, the sorter is an ephemeral index that never
+** holds more than LIMIT+OFFSET entries. Once it is full, a new row is only
+** inserted if it sorts before the largest entry, which is deleted to make
+** room for it. Other rows are discarded before their record is built, so
+** that a query like "ORDER BY x LIMIT 10" mostly costs a comparison with
+** the 10th row for each row scanned.
 */
 static void pushOntoSorter(
   Parse *pParse,         /* Parser context */
@@ -544,23 +588,16 @@ static void pushOntoSorter(
   int nExpr = pOrderBy->nExpr;
   int regBase = sqlite3GetTempRange(pParse, nExpr+2);
   int regRecord = sqlite3GetTempReg(pParse);
+  int addrSkip = 0;      /* Jump over the insert if the row is too large */
   int op;
   sqlite3ExprCacheClear(pParse);
   sqlite3ExprCodeExprList(pParse, pOrderBy, regBase, 0);
   sqlite3VdbeAddOp2(v, OP_Sequence, pOrderBy->iECursor, regBase+nExpr);
   sqlite3ExprCodeMove(pParse, regData, regBase+nExpr+1, 1);
-  sqlite3VdbeAddOp3(v, OP_MakeRecord, regBase, nExpr + 2, regRecord);
-  if( pSelect->selFlags & SF_UseSorter ){
-    op = OP_SorterInsert;
-  }else{
-    op = OP_IdxInsert;
-  }
-  sqlite3VdbeAddOp2(v, op, pOrderBy->iECursor, regRecord);
-  sqlite3ReleaseTempReg(pParse, regRecord);
-  sqlite3ReleaseTempRange(pParse, regBase, nExpr+2);
   if( pSelect->iLimit ){
     int addr1, addr2;
     int iLimit;
+    assert( (pSelect->selFlags & SF_UseSorter)==0 );
     if( pSelect->iOffset ){
       iLimit = pSelect->iOffset+1;
     }else{
@@ -571,9 +608,24 @@ static void pushOntoSorter(
     addr2 = sqlite3VdbeAddOp0(v, OP_Goto);
     sqlite3VdbeJumpHere(v, addr1);
     sqlite3VdbeAddOp1(v, OP_Last, pOrderBy->iECursor);
+    addrSkip = sqlite3VdbeAddOp4Int(v, OP_IdxLE, pOrderBy->iECursor, 0,
+                                    regBase, nExpr);
+    VdbeCoverage(v);
     sqlite3VdbeAddOp1(v, OP_Delete, pOrderBy->iECursor);
     sqlite3VdbeJumpHere(v, addr2);
   }
+  sqlite3VdbeAddOp3(v, OP_MakeRecord, regBase, nExpr + 2, regRecord);
+  if( pSelect->selFlags & SF_UseSorter ){
+    op = OP_SorterInsert;
+  }else{
+    op = OP_IdxInsert;
+  }
+  sqlite3VdbeAddOp2(v, op, pOrderBy->iECursor, regRecord);
+  if( addrSkip ){
+    sqlite3VdbeJumpHere(v, addrSkip);
+  }
+  sqlite3ReleaseTempReg(pParse, regRecord);
+  sqlite3ReleaseTempRange(pParse, regBase, nExpr+2);
 }
 
 /*
@@ -175,25 +175,25 @@ if(0!=sqlite3StrNICmp(pTab->zName, "sqlite_", 7) && 0!=sqlite3StrNICmp(pTab->zNa
 
       Expr *pFunction = sqlite3DbMallocZero(db, sizeof(Expr));
 
-    pFName->op = (u8)153; 
+    pFName->op = TK_FUNCTION; 
     pFName->iAgg = -1;
 
-    pFTable->op = (u8)27;
+    pFTable->op = TK_ID;
     pFTable->iAgg = -1;
 
-    pFColumn->op = (u8)27;
+    pFColumn->op = TK_ID;
     pFColumn->iAgg = -1;
 
-    pFClass->op = (u8)97;
+    pFClass->op = TK_STRING;
     pFClass->iAgg = -1;
 
-    pFAction->op = (u8)97;
+    pFAction->op = TK_STRING;
     pFAction->iAgg = -1;
 
-    pFDebug->op = (u8)97;
+    pFDebug->op = TK_STRING;
     pFDebug->iAgg = -1;
 
-    pFunction->op = (u8)122;
+    pFunction->op = TK_DOT;
     pFunction->iAgg = -1;
 
         pFName->u.zToken = (char*)&pFName[1];
@@ -231,6 +231,7 @@ pExprFunction = sqlite3ExprListAppend(pParse, 0, pFunction);
 pExprFunction = sqlite3ExprListAppend(pParse, pExprFunction, pFClass);
 pExprFunction = sqlite3ExprListAppend(pParse, pExprFunction, pFAction);
 pExprFunction = sqlite3ExprListAppend(pParse, pExprFunction, pFDebug);
+pExprFunction = sqlite3ExprListAppend(pParse, pExprFunction, sqlite3Expr(db, TK_STRING, pParse->db->aDb[iDb].zName));
 
 pFName->x.pList = pExprFunction;
 sqlite3ExprSetHeight(pParse, pFName);
@@ -240,6 +241,10 @@ sqlite3ExprSetHeight(pParse, pFName);
 	else
 	   pNewWhere = pFName;
   }
+  sqlite3DbFree(db, f_name);
+  sqlite3DbFree(db, f_column);
+  sqlite3DbFree(db, f_class);
+  sqlite3DbFree(db, f_action);
 
   if(pWhere)
     pWhere = sqlite3ExprAnd(db, pNewWhere, pWhere);
@@ -212,8 +212,8 @@ int sqlite3RunVacuum(char **pzErrMsg, sqlite3 *db){
   if( rc!=SQLITE_OK ) goto end_of_vacuum;
 
   /* Do not attempt to change the page size for a WAL database */
-  if( sqlite3PagerGetJournalMode(sqlite3BtreePager(pMain))
-                                               ==PAGER_JOURNALMODE_WAL ){
+  if( PAGER_JOURNALMODE_ISWAL(
+          sqlite3PagerGetJournalMode(sqlite3BtreePager(pMain))) ){
     db->nextPagesize = 0;
   }
 
@@ -231,7 +231,7 @@ int sqlite3RunVacuum(char **pzErrMsg, sqlite3 *db){
 #endif
 
 #ifdef SQLITE_ENABLE_SELINUX
-    set_vacuum(1);
+    set_vacuum(db, 1);
 #endif
 
   /* Query the schema of the main database. Create a mirror schema
@@ -343,7 +343,7 @@ int sqlite3RunVacuum(char **pzErrMsg, sqlite3 *db){
   rc = sqlite3BtreeSetPageSize(pMain, sqlite3BtreeGetPageSize(pTemp), nRes,1);
 
 #ifdef SQLITE_ENABLE_SELINUX
-    set_vacuum(0);
+    set_vacuum(db, 0);
 #endif
 
 end_of_vacuum:
@@ -1045,11 +1045,17 @@ case OP_SoftNull: {
 ** Synopsis: r[P2]=P4 (len=P1)
 **
 ** P4 points to a blob of data P1 bytes long.  Store this
-** blob in register P2.
+** blob in register P2.  If P4 is NULL, then register P2 is set to a
+** blob of P1 zero bytes.
 */
 case OP_Blob: {                /* out2-prerelease */
   assert( pOp->p1 <= SQLITE_MAX_LENGTH );
-  sqlite3VdbeMemSetStr(pOut, pOp->p4.z, pOp->p1, 0, 0);
+  if( pOp->p4.z==0 ){
+    sqlite3VdbeMemSetZeroBlob(pOut, pOp->p1);
+    if( sqlite3VdbeMemExpandBlob(pOut) ) goto no_mem;
+  }else{
+    sqlite3VdbeMemSetStr(pOut, pOp->p4.z, pOp->p1, 0, 0);
+  }
   pOut->enc = encoding;
   UPDATE_MAX_BLOBSIZE(pOut);
   break;
@@ -2305,15 +2311,16 @@ case OP_Column: {
   assert( pC->pVtabCursor==0 ); /* OP_Column never called on virtual table */
 #endif
   pCrsr = pC->pCursor;
-  assert( pCrsr!=0 || pC->pseudoTableReg>0 ); /* pCrsr NULL on PseudoTables */
-  assert( pCrsr!=0 || pC->nullRow );          /* pC->nullRow on PseudoTables */
+  assert( pCrsr!=0 || pC->pseudoTableReg>0    /* pCrsr NULL on PseudoTables */
+       || pC->pHash!=0 );                     /* and in-memory hash tables */
+  assert( pCrsr!=0 || pC->nullRow || pC->pHash!=0 );
 
   /* If the cursor cache is stale, bring it up-to-date */
   rc = sqlite3VdbeCursorMoveto(pC);
   if( rc ) goto abort_due_to_error;
   if( pC->cacheStatus!=p->cacheCtr || (pOp->p5&OPFLAG_CLEARCACHE)!=0 ){
     if( pC->nullRow ){
-      if( pCrsr==0 ){
+      if( pCrsr==0 && pC->pHash==0 ){
         assert( pC->pseudoTableReg>0 );
         pReg = &aMem[pC->pseudoTableReg];
         assert( pReg->flags & MEM_Blob );
@@ -2324,8 +2331,11 @@ case OP_Column: {
         MemSetTypeFlag(pDest, MEM_Null);
         goto op_column_out;
       }
+    }else if( pCrsr==0 ){
+      /* The record is an entry of an in-memory hash table */
+      pC->aRow = sqlite3VdbeHashRowdata(pC, &pC->payloadSize);
+      pC->szRow = avail = pC->payloadSize;
     }else{
-      assert( pCrsr );
       if( pC->isTable==0 ){
         assert( sqlite3BtreeCursorIsValid(pCrsr) );
         VVA_ONLY(rc =) sqlite3BtreeKeySize(pCrsr, &payloadSize64);
@@ -2781,6 +2791,7 @@ case OP_Savepoint: {
         if( db->autoCommit ){
           db->autoCommit = 0;
           db->isTransactionSavepoint = 1;
+          db->bConcurrent = 0;
         }else{
           db->nSavepoint++;
         }
@@ -2890,13 +2901,16 @@ case OP_Savepoint: {
   break;
 }
 
-/* Opcode: AutoCommit P1 P2 * * *
+/* Opcode: AutoCommit P1 P2 P3 * *
 **
 ** Set the database auto-commit flag to P1 (1 or 0). If P2 is true, roll
 ** back any currently active btree transactions. If there are any active
 ** VMs (apart from this one), then a ROLLBACK fails.  A COMMIT fails if
 ** there are active writing VMs or active VMs that use shared cache.
 **
+** If P1 is 0 and P3 is true, the transaction opened is a BEGIN CONCURRENT
+** transaction.
+**
 ** This instruction causes the VM to halt.
 */
 case OP_AutoCommit: {
@@ -2938,6 +2952,7 @@ case OP_AutoCommit: {
     }else if( (rc = sqlite3VdbeCheckFk(p, 1))!=SQLITE_OK ){
       goto vdbe_return;
     }else{
+      if( !desiredAutoCommit ) db->bConcurrent = (u8)pOp->p3;
       db->autoCommit = (u8)desiredAutoCommit;
       if( sqlite3VdbeHalt(p)==SQLITE_BUSY ){
         p->pc = pc;
@@ -3362,6 +3377,81 @@ case OP_OpenEphemeral: {
   break;
 }
 
+/* Opcode: ReuseAutoindex P1 P2 P3 P4 P5
+** Synopsis: root=P3 iDb=P5
+**
+** P1 is a cursor just opened by OP_OpenAutoindex for an automatic index
+** on the table with root page P3 in database P5. P4 is a string that
+** identifies the table and the columns of the index.
+**
+** If PRAGMA automatic_index_cache is not zero and the cache of the
+** database connection holds an index with key P4 that was built since
+** the table was last written, move that index into cursor P1 and jump
+** to P2. Otherwise fall through to the code that fills the index. If
+** that code runs to completion (see OP_SaveAutoindex), the index is
+** added to the cache when cursor P1 is closed.
+*/
+case OP_ReuseAutoindex: {     /* jump */
+  VdbeCursor *pCx;
+  AutoidxEntry *pEntry;
+  u32 iVersion;
+
+  pCx = p->apCsr[pOp->p1];
+  assert( pCx!=0 && pCx->pBt!=0 && pCx->pKeyInfo!=0 );
+  assert( pCx->pAutoidx==0 );
+  assert( pOp->p4type==P4_DYNAMIC );
+  assert( pOp->p5<db->nDb );
+  assert( (p->btreeMask & (((yDbMask)1)<<pOp->p5))!=0 );
+  if( db->mxAutoidx<=0 ) break;
+  iVersion = sqlite3BtreeTableVersion(db->aDb[pOp->p5].pBt, pOp->p3);
+  pEntry = sqlite3VdbeAutoidxTake(db, pOp->p4.z);
+  if( pEntry && pEntry->iVersion==iVersion ){
+    /* Replace the empty b-tree opened by OP_OpenAutoindex with the one
+    ** from the cache. Closing the b-tree also closes the cursor. */
+    assert( pEntry->bReady && pEntry->pBt );
+    sqlite3BtreeClose(pCx->pBt);
+    pCx->pBt = pEntry->pBt;
+    pEntry->pBt = 0;
+    pCx->pAutoidx = pEntry;
+    sqlite3BtreeCursorZero(pCx->pCursor);
+    rc = sqlite3BtreeCursor(pCx->pBt, MASTER_ROOT+1, 1, pCx->pKeyInfo,
+                            pCx->pCursor);
+    if( rc ) goto abort_due_to_error;
+    VdbeBranchTaken(1, 2);
+    pc = pOp->p2 - 1;
+    break;
+  }
+  VdbeBranchTaken(0, 2);
+  if( pEntry ){
+    /* The table has been written since the index was built */
+    sqlite3BtreeClose(pEntry->pBt);
+    pEntry->pBt = 0;
+    pEntry->bReady = 0;
+  }else{
+    int nKey = sqlite3Strlen30(pOp->p4.z);
+    pEntry = sqlite3DbMallocZero(db, sizeof(AutoidxEntry)+nKey+1);
+    if( pEntry==0 ) goto no_mem;
+    pEntry->zKey = (char*)&pEntry[1];
+    memcpy(pEntry->zKey, pOp->p4.z, nKey+1);
+  }
+  pEntry->iVersion = iVersion;
+  pCx->pAutoidx = pEntry;
+  break;
+}
+
+/* Opcode: SaveAutoindex P1 * * * *
+**
+** The automatic index open on cursor P1 has been filled with every row of
+** its table. If OP_ReuseAutoindex prepared it for caching, it is added to
+** the cache of the database connection when cursor P1 is closed.
+*/
+case OP_SaveAutoindex: {
+  VdbeCursor *pCx = p->apCsr[pOp->p1];
+  assert( pCx!=0 );
+  if( pCx->pAutoidx ) pCx->pAutoidx->bReady = 1;
+  break;
+}
+
 /* Opcode: SorterOpen P1 P2 * P4 *
 **
 ** This opcode works like OP_OpenEphemeral except that it opens
@@ -3382,6 +3472,150 @@ case OP_SorterOpen: {
   break;
 }
 
+/* Opcode: HashOpen P1 P2 P3 P4 *
+** Synopsis: nColumn=P2 nKey=P3
+**
+** Open cursor P1 on a new in-memory hash table of index records with P2
+** columns, for use by a hash join. The first P3 columns of each record
+** are its key. P4 is a pointer to a KeyInfo structure that defines the
+** content of the records, as for OP_OpenAutoindex.
+**
+** Records are added to the table by OP_HashInsert, and looked up by
+** OP_HashProbe and OP_HashNext. If the table grows too large to be held
+** in memory, it is moved to an index in a temporary file.
+*/
+case OP_HashOpen: {
+  VdbeCursor *pCx;
+
+  assert( pOp->p1>=0 );
+  assert( pOp->p2>=0 );
+  assert( pOp->p3>0 && pOp->p3<=pOp->p2 );
+  pCx = allocateCursor(p, pOp->p1, pOp->p2, -1, 1);
+  if( pCx==0 ) goto no_mem;
+  pCx->nullRow = 1;
+  pCx->pKeyInfo = pOp->p4.pKeyInfo;
+  assert( pCx->pKeyInfo->db==db );
+  assert( pCx->pKeyInfo->enc==ENC(db) );
+  pCx->isTable = 0;
+  pCx->isOrdered = 0;
+  rc = sqlite3VdbeHashInit(db, pCx, pOp->p3);
+  break;
+}
+
+/* Opcode: HashInsert P1 P2 * * *
+** Synopsis: key=r[P2]
+**
+** Register P2 holds an index record made using the MakeRecord
+** instruction. Add it to the hash table opened on cursor P1 by
+** OP_HashOpen. Records with a NULL key column are ignored.
+*/
+case OP_HashInsert: {       /* in2 */
+  VdbeCursor *pC;
+
+  assert( pOp->p1>=0 && pOp->p1<p->nCursor );
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 && pC->pHash!=0 );
+  pIn2 = &aMem[pOp->p2];
+  assert( pIn2->flags & MEM_Blob );
+  rc = ExpandBlob(pIn2);
+  if( rc==SQLITE_OK ){
+    rc = sqlite3VdbeHashInsert(db, pC, pIn2);
+    pC->cacheStatus = CACHE_STALE;
+  }
+  break;
+}
+
+/* Opcode: HashProbe P1 P2 P3 P4 *
+** Synopsis: key=r[P3@P4]
+**
+** P4 is an integer N. Point cursor P1, which was opened by OP_HashOpen,
+** at the first record of its hash table whose first N columns are equal
+** to the N values in registers P3 and following. If there is no such
+** record, or if any of the values is NULL, jump to P2.
+**
+** The values of registers P3 through P3+N-1 must not change until the
+** following OP_HashNext instructions on cursor P1 have run.
+*/
+case OP_HashProbe: {        /* jump */
+  VdbeCursor *pC;
+  UnpackedRecord r;
+  int res;
+
+  assert( pOp->p1>=0 && pOp->p1<p->nCursor );
+  assert( pOp->p4type==P4_INT32 );
+  pC = p->apCsr[pOp->p1];
+  assert( pC!=0 && pC->pHash!=0 );
+  r.pKeyInfo = pC->pKeyInfo;
+  r.nField = (u16)pOp->p4.i;
+  r.default_rc = 0;
+  r.aMem = &aMem[pOp->p3];
+#ifdef SQLITE_DEBUG
+  { int i; for(i=0; i<r.nField; i++) assert( memIsValid(&r.aMem[i]) ); }
+#endif
+  ExpandBlob(r.aMem);
+  rc = sqlite3VdbeHashProbe(pC, &r, &res);
+  if( rc!=SQLITE_OK ) goto abort_due_to_error;
+  pC->deferredMoveto = 0;
+  pC->rowidIsValid = 0;
+  pC->cacheStatus = CACHE_STALE;
+  pC->nullRow = (u8)res;
+  VdbeBranchTaken(res!=0,2);
+  if( res ){
+    pc = pOp->p2 - 1;
+  }
+  break;
+}
+
+/* Opcode: FilterAdd P1 * P3 P4 *
+** Synopsis: filter(P1) += key(P3@P4)
+**
+** P4 is an integer N. Add the key formed by the N values in registers P3
+** and following to the Bloom filter in register P1, a blob created by
+** OP_Blob. If any of the values is NULL, the filter is not changed.
+*/
+case OP_FilterAdd: {
+  u32 h;
+  int bNull;
+
+  assert( pOp->p4type==P4_INT32 );
+  assert( pOp->p1>0 && pOp->p1<=(p->nMem-p->nCursor) );
+  pIn1 = &aMem[pOp->p1];
+#ifdef SQLITE_DEBUG
+  { int i; for(i=0; i<pOp->p4.i; i++) assert( memIsValid(&aMem[pOp->p3+i]) ); }
+#endif
+  h = sqlite3VdbeHashValues(&aMem[pOp->p3], pOp->p4.i, &bNull);
+  if( !bNull ) sqlite3VdbeBloomAdd(pIn1, h);
+  break;
+}
+
+/* Opcode: Filter P1 P2 P3 P4 *
+** Synopsis: if key(P3@P4) not in filter(P1) goto P2
+**
+** P4 is an integer N. Jump to P2 if the key formed by the N values in
+** registers P3 and following has definitely not been added to the Bloom
+** filter in register P1 by OP_FilterAdd, or if any of the values is NULL.
+** Otherwise, fall through. The key may or may not have been added.
+*/
+case OP_Filter: {          /* jump */
+  u32 h;
+  int bNull;
+
+  assert( pOp->p4type==P4_INT32 );
+  assert( pOp->p1>0 && pOp->p1<=(p->nMem-p->nCursor) );
+  pIn1 = &aMem[pOp->p1];
+#ifdef SQLITE_DEBUG
+  { int i; for(i=0; i<pOp->p4.i; i++) assert( memIsValid(&aMem[pOp->p3+i]) ); }
+#endif
+  h = sqlite3VdbeHashValues(&aMem[pOp->p3], pOp->p4.i, &bNull);
+  if( bNull || sqlite3VdbeBloomTest(pIn1, h)==0 ){
+    VdbeBranchTaken(1, 2);
+    pc = pOp->p2 - 1;
+  }else{
+    VdbeBranchTaken(0, 2);
+  }
+  break;
+}
+
 /* Opcode: OpenPseudo P1 P2 P3 * *
 ** Synopsis: P3 columns in r[P2]
 **
@@ -4505,6 +4739,12 @@ case OP_Rewind: {        /* jump */
 ** This opcode works just like OP_Prev except that if cursor P1 is not
 ** open it behaves a no-op.
 */
+/* Opcode: HashNext P1 P2 * * *
+**
+** Advance cursor P1, which was opened by OP_HashOpen, to the next record
+** that matches the key of the last OP_HashProbe on the cursor, and jump
+** to P2. If there are no more matching records, fall through.
+*/
 case OP_SorterNext: {  /* jump */
   VdbeCursor *pC;
   int res;
@@ -4513,6 +4753,11 @@ case OP_SorterNext: {  /* jump */
   assert( isSorter(pC) );
   rc = sqlite3VdbeSorterNext(db, pC, &res);
   goto next_tail;
+case OP_HashNext:      /* jump */
+  pC = p->apCsr[pOp->p1];
+  assert( pC->pHash );
+  rc = sqlite3VdbeHashNext(pC, &res);
+  goto next_tail;
 case OP_PrevIfOpen:    /* jump */
 case OP_NextIfOpen:    /* jump */
   if( p->apCsr[pOp->p1]==0 ) break;
@@ -5625,6 +5870,7 @@ case OP_JournalMode: {    /* out2-prerelease */
        || eNew==PAGER_JOURNALMODE_OFF
        || eNew==PAGER_JOURNALMODE_MEMORY
        || eNew==PAGER_JOURNALMODE_WAL
+       || eNew==PAGER_JOURNALMODE_WAL2
        || eNew==PAGER_JOURNALMODE_QUERY
   );
   assert( pOp->p1>=0 && pOp->p1<db->nDb );
@@ -5639,10 +5885,10 @@ case OP_JournalMode: {    /* out2-prerelease */
 #ifndef SQLITE_OMIT_WAL
   zFilename = sqlite3PagerFilename(pPager, 1);
 
-  /* Do not allow a transition to journal_mode=WAL for a database
+  /* Do not allow a transition to journal_mode=WAL or WAL2 for a database
   ** in temporary storage or if the VFS does not support shared memory 
   */
-  if( eNew==PAGER_JOURNALMODE_WAL
+  if( PAGER_JOURNALMODE_ISWAL(eNew)
    && (sqlite3Strlen30(zFilename)==0           /* Temp file */
        || !sqlite3PagerWalSupported(pPager))   /* No shared-memory support */
   ){
@@ -5650,26 +5896,29 @@ case OP_JournalMode: {    /* out2-prerelease */
   }
 
   if( (eNew!=eOld)
-   && (eOld==PAGER_JOURNALMODE_WAL || eNew==PAGER_JOURNALMODE_WAL)
+   && (PAGER_JOURNALMODE_ISWAL(eOld) || PAGER_JOURNALMODE_ISWAL(eNew))
   ){
     if( !db->autoCommit || db->nVdbeRead>1 ){
       rc = SQLITE_ERROR;
       sqlite3SetString(&p->zErrMsg, db, 
           "cannot change %s wal mode from within a transaction",
-          (eNew==PAGER_JOURNALMODE_WAL ? "into" : "out of")
+          (PAGER_JOURNALMODE_ISWAL(eNew) ? "into" : "out of")
       );
       break;
     }else{
  
-      if( eOld==PAGER_JOURNALMODE_WAL ){
+      if( PAGER_JOURNALMODE_ISWAL(eOld) ){
         /* If leaving WAL mode, close the log file. If successful, the call
         ** to PagerCloseWal() checkpoints and deletes the write-ahead-log 
         ** file. An EXCLUSIVE lock may still be held on the database file 
-        ** after a successful return. 
+        ** after a successful return. When switching directly between
+        ** WAL and WAL2 mode, the new log is opened by the next transaction.
         */
         rc = sqlite3PagerCloseWal(pPager);
         if( rc==SQLITE_OK ){
-          sqlite3PagerSetJournalMode(pPager, eNew);
+          sqlite3PagerSetJournalMode(pPager, 
+              PAGER_JOURNALMODE_ISWAL(eNew) ? PAGER_JOURNALMODE_DELETE : eNew
+          );
         }
       }else if( eOld==PAGER_JOURNALMODE_MEMORY ){
         /* Cannot transition directly from MEMORY to WAL.  Use mode OFF
@@ -5682,7 +5931,9 @@ case OP_JournalMode: {    /* out2-prerelease */
       */
       assert( sqlite3BtreeIsInTrans(pBt)==0 );
       if( rc==SQLITE_OK ){
-        rc = sqlite3BtreeSetVersion(pBt, (eNew==PAGER_JOURNALMODE_WAL ? 2 : 1));
+        rc = sqlite3BtreeSetVersion(pBt, (eNew==PAGER_JOURNALMODE_WAL ? 2 :
+                                          eNew==PAGER_JOURNALMODE_WAL2 ? 3 : 1)
+        );
       }
     }
   }
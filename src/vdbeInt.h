@@ -41,6 +41,27 @@ typedef unsigned Bool;
 /* Opaque type used by code in vdbesort.c */
 typedef struct VdbeSorter VdbeSorter;
 
+/* Opaque type used by the hash table for hash joins (vdbehash.c) */
+typedef struct VdbeHash VdbeHash;
+
+/*
+** An automatic index in the cache of a database connection (see PRAGMA
+** automatic_index_cache). The index is stored in the ephemeral b-tree
+** pBt, on root page MASTER_ROOT+1, as created by OP_OpenAutoindex.
+**
+** While a statement uses the index, the entry is removed from the
+** sqlite3.pAutoidx list and attached to the cursor (VdbeCursor.pAutoidx).
+** It is added back when the cursor is closed, provided that the index
+** is complete (bReady).
+*/
+struct AutoidxEntry {
+  char *zKey;             /* Table and columns of the index. See where.c */
+  u32 iVersion;           /* sqlite3BtreeTableVersion() of the table */
+  u8 bReady;              /* True once the index holds every row */
+  Btree *pBt;             /* Ephemeral b-tree holding the index */
+  AutoidxEntry *pNext;    /* Next entry in sqlite3.pAutoidx */
+};
+
 /* Opaque type used by the explainer */
 typedef struct Explain Explain;
 
@@ -80,6 +101,8 @@ struct VdbeCursor {
   i64 movetoTarget;     /* Argument to the deferred sqlite3BtreeMoveto() */
   i64 lastRowid;        /* Rowid being deleted by OP_Delete */
   VdbeSorter *pSorter;  /* Sorter object for OP_SorterOpen cursors */
+  VdbeHash *pHash;      /* Hash table for OP_HashOpen cursors */
+  AutoidxEntry *pAutoidx;  /* Cache entry for OP_ReuseAutoindex cursors */
 
   /* Cached information about the header for the data record that the
   ** cursor is currently pointing to.  Only valid if cacheStatus matches
@@ -339,6 +362,9 @@ struct Vdbe {
   bft bIsReader:1;        /* True for statements that read */
   bft isPrepareV2:1;      /* True if prepared with prepare_v2() */
   bft doingRerun:1;       /* True if rerunning after an auto-reprepare */
+#ifdef SQLITE_ENABLE_SELINUX
+  bft isParked:1;         /* True if kept by the SeSQLite statement cache */
+#endif
   int nChange;            /* Number of db changes made since last reset */
   yDbMask btreeMask;      /* Bitmask of db->aDb[] entries referenced */
   yDbMask lockMask;       /* Subset of btreeMask that requires a lock */
@@ -361,6 +387,9 @@ struct Vdbe {
   VdbeFrame *pDelFrame;   /* List of frame objects to free on VM reset */
   int nFrame;             /* Number of frames in pFrame list */
   u32 expmask;            /* Binding to these vars invalidates VM */
+#ifdef SQLITE_ENABLE_SELINUX
+  u32 iPolicy;            /* SeSQLite policy generation of the compilation */
+#endif
   SubProgram *pProgram;   /* Linked list of all sub-programs used by VM */
   int nOnceFlag;          /* Size of array aOnceFlag[] */
   u8 *aOnceFlag;          /* Flags for OP_Once */
@@ -444,6 +473,19 @@ int sqlite3VdbeSorterRewind(sqlite3 *, const VdbeCursor *, int *);
 int sqlite3VdbeSorterWrite(sqlite3 *, const VdbeCursor *, Mem *);
 int sqlite3VdbeSorterCompare(const VdbeCursor *, Mem *, int, int *);
 
+int sqlite3VdbeHashInit(sqlite3 *, VdbeCursor *, int);
+void sqlite3VdbeHashClose(sqlite3 *, VdbeCursor *);
+int sqlite3VdbeHashInsert(sqlite3 *, VdbeCursor *, Mem *);
+int sqlite3VdbeHashProbe(VdbeCursor *, UnpackedRecord *, int *);
+int sqlite3VdbeHashNext(VdbeCursor *, int *);
+const u8 *sqlite3VdbeHashRowdata(const VdbeCursor *, u32 *);
+u32 sqlite3VdbeHashValues(const Mem *, int, int *);
+void sqlite3VdbeBloomAdd(Mem *, u32);
+int sqlite3VdbeBloomTest(const Mem *, u32);
+
+AutoidxEntry *sqlite3VdbeAutoidxTake(sqlite3 *, const char *);
+void sqlite3VdbeAutoidxSave(sqlite3 *, VdbeCursor *);
+
 #if !defined(SQLITE_OMIT_SHARED_CACHE) && SQLITE_THREADSAFE>0
   void sqlite3VdbeEnter(Vdbe*);
   void sqlite3VdbeLeave(Vdbe*);
@@ -15,6 +15,9 @@
 */
 #include "sqliteInt.h"
 #include "vdbeInt.h"
+#ifdef SQLITE_ENABLE_SELINUX
+# include "sesqlite.h"
+#endif
 
 #ifndef SQLITE_OMIT_DEPRECATED
 /*
@@ -73,6 +76,10 @@ int sqlite3_finalize(sqlite3_stmt *pStmt){
     sqlite3 *db = v->db;
     if( vdbeSafety(v) ) return SQLITE_MISUSE_BKPT;
     sqlite3_mutex_enter(db->mutex);
+#ifdef SQLITE_ENABLE_SELINUX
+    /* SeSQLite may keep the statement for the next prepare of its SQL */
+    if( !sqlite3SelinuxStmtPark(db, pStmt, &rc) )
+#endif
     rc = sqlite3VdbeFinalize(v);
     rc = sqlite3ApiExit(db, rc);
     sqlite3LeaveMutexAndCloseZombie(db);
@@ -1340,6 +1347,12 @@ sqlite3_stmt *sqlite3_next_stmt(sqlite3 *pDb, sqlite3_stmt *pStmt){
   }else{
     pNext = (sqlite3_stmt*)((Vdbe*)pStmt)->pNext;
   }
+#ifdef SQLITE_ENABLE_SELINUX
+  /* the statements kept by the SeSQLite cache were finalized */
+  while( pNext && ((Vdbe*)pNext)->isParked ){
+    pNext = (sqlite3_stmt*)((Vdbe*)pNext)->pNext;
+  }
+#endif
   sqlite3_mutex_leave(pDb->mutex);
   return pNext;
 }
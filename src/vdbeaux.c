@@ -16,6 +16,9 @@
 */
 #include "sqliteInt.h"
 #include "vdbeInt.h"
+#ifdef SQLITE_ENABLE_SELINUX
+# include "sesqlite.h"
+#endif
 
 /*
 ** Create a new virtual database engine.
@@ -52,6 +55,10 @@ void sqlite3VdbeSetSql(Vdbe *p, const char *z, int n, int isPrepareV2){
   assert( p->zSql==0 );
   p->zSql = sqlite3DbStrNDup(p->db, z, n);
   p->isPrepareV2 = (u8)isPrepareV2;
+#ifdef SQLITE_ENABLE_SELINUX
+  /* see the statement cache of SeSQLite */
+  p->iPolicy = sqlite3SelinuxPolicy();
+#endif
 }
 
 /*
@@ -1721,6 +1728,10 @@ void sqlite3VdbeFreeCursor(Vdbe *p, VdbeCursor *pCx){
     return;
   }
   sqlite3VdbeSorterClose(p->db, pCx);
+  sqlite3VdbeHashClose(p->db, pCx);
+  if( pCx->pAutoidx ){
+    sqlite3VdbeAutoidxSave(p->db, pCx);
+  }
   if( pCx->pBt ){
     sqlite3BtreeClose(pCx->pBt);
     /* The pCx->pCursor will be close automatically, if it exists, by
@@ -1739,6 +1750,71 @@ void sqlite3VdbeFreeCursor(Vdbe *p, VdbeCursor *pCx){
 #endif
 }
 
+/*
+** Remove the automatic index identified by zKey from the cache of
+** connection db and return it. Return NULL if there is no such index.
+*/
+AutoidxEntry *sqlite3VdbeAutoidxTake(sqlite3 *db, const char *zKey){
+  AutoidxEntry **pp;
+  for(pp=&db->pAutoidx; *pp; pp=&(*pp)->pNext){
+    AutoidxEntry *pEntry = *pp;
+    if( strcmp(pEntry->zKey, zKey)==0 ){
+      *pp = pEntry->pNext;
+      pEntry->pNext = 0;
+      return pEntry;
+    }
+  }
+  return 0;
+}
+
+/*
+** Free an automatic index cache entry and the b-tree that holds it.
+*/
+static void vdbeAutoidxFree(sqlite3 *db, AutoidxEntry *pEntry){
+  if( pEntry->pBt ) sqlite3BtreeClose(pEntry->pBt);
+  sqlite3DbFree(db, pEntry);
+}
+
+/*
+** Called when cursor pCx, which was opened by OP_OpenAutoindex and
+** prepared for caching by OP_ReuseAutoindex, is closed. If the index is
+** complete, move its b-tree to the front of the cache of connection db,
+** replacing any older index with the same key. Otherwise, discard it.
+*/
+void sqlite3VdbeAutoidxSave(sqlite3 *db, VdbeCursor *pCx){
+  AutoidxEntry *pEntry = pCx->pAutoidx;
+  pCx->pAutoidx = 0;
+  if( pEntry->bReady && pCx->pBt && db->mxAutoidx>0 ){
+    AutoidxEntry *pOld = sqlite3VdbeAutoidxTake(db, pEntry->zKey);
+    if( pOld ) vdbeAutoidxFree(db, pOld);
+    sqlite3BtreeCloseCursor(pCx->pCursor);
+    pCx->pCursor = 0;
+    pEntry->pBt = pCx->pBt;
+    pCx->pBt = 0;
+    pEntry->pNext = db->pAutoidx;
+    db->pAutoidx = pEntry;
+    sqlite3VdbeAutoidxPurge(db, db->mxAutoidx);
+  }else{
+    vdbeAutoidxFree(db, pEntry);
+  }
+}
+
+/*
+** Discard all but the nKeep most recently used automatic indexes in the
+** cache of connection db. Indexes in use by a statement are not in the
+** cache and are not affected.
+*/
+void sqlite3VdbeAutoidxPurge(sqlite3 *db, int nKeep){
+  AutoidxEntry **pp = &db->pAutoidx;
+  int i;
+  for(i=0; *pp && i<nKeep; i++) pp = &(*pp)->pNext;
+  while( *pp ){
+    AutoidxEntry *pEntry = *pp;
+    *pp = pEntry->pNext;
+    vdbeAutoidxFree(db, pEntry);
+  }
+}
+
 /*
 ** Copy the values stored in the VdbeFrame structure to its Vdbe. This
 ** is used, for example, when a trigger sub-program is halted to restore
@@ -0,0 +1,498 @@
+/*
+** 2014 June 23
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains code for the VdbeHash object, used in concert with
+** a VdbeCursor to implement the hash tables built for hash joins (see
+** the OP_HashOpen, OP_HashInsert, OP_HashProbe and OP_HashNext opcodes).
+**
+** The entries of a hash table are index records created by OP_MakeRecord.
+** The first nKey fields of each record are its key. They are hashed and
+** the record is added to a chain of the in-memory table. Records with a
+** NULL key field are never added, as they cannot match an "=" constraint.
+**
+** A probe hashes the key values it is given, and visits each record of
+** the matching chain that compares equal to them using the KeyInfo of the
+** cursor. Numeric values are hashed as doubles so that an integer and a
+** real that compare equal also hash equally.
+**
+** The memory used by the table is limited in the same way as the memory
+** used by the sorter (see vdbesort.c). If the records inserted use more
+** than cache_size pages worth of memory and temp files are not stored in
+** memory, they are moved to a b-tree index in a temporary file and the
+** rest of the table is built in that index. From then on the cursor works
+** just like one opened by OP_OpenAutoindex: probes are b-tree seeks.
+**
+** The same hash function is used by the Bloom filters of OP_FilterAdd and
+** OP_Filter. A Bloom filter is a blob register. Each key added to it sets
+** two of its bits, and a key for which either bit is clear was never added.
+*/
+
+#include "sqliteInt.h"
+#include "vdbeInt.h"
+
+typedef struct HashEntry HashEntry;
+
+/*
+** Minimum amount of memory, in pages, used by a hash table before it is
+** moved to a temporary file.
+*/
+#define HASH_MIN_WORKING 10
+
+/*
+** Initial number of slots in the hash table. This is doubled each time
+** the table contains as many records as it has slots.
+*/
+#define HASH_INIT_SLOT 64
+
+/*
+** A record stored in the in-memory hash table. The nRec bytes of the
+** record immediately follow this structure.
+*/
+struct HashEntry {
+  HashEntry *pNext;               /* Next entry in the same slot */
+  u32 iHash;                      /* Hash of the key fields */
+  int nRec;                       /* Size of the record in bytes */
+};
+#define HASH_ENTRY_REC(p) ((const u8*)&(p)[1])
+
+/*
+** Main hash table structure. One is allocated for each cursor opened by
+** OP_HashOpen.
+*/
+struct VdbeHash {
+  int nKey;                       /* Number of key fields in each record */
+  int nEntry;                     /* Number of records in aSlot[] */
+  int nSlot;                      /* Size of aSlot[]. Always a power of 2 */
+  HashEntry **aSlot;              /* Hash table of records */
+  i64 nByte;                      /* Memory used by the records */
+  i64 mxByte;                     /* Move to a b-tree when nByte exceeds */
+  HashEntry *pCur;                /* Current entry, if not on a b-tree */
+  u32 iProbe;                     /* Hash of the current probe key */
+  UnpackedRecord rProbe;          /* The current probe key */
+  BtCursor *pBtCsr;               /* Cursor to use once on a b-tree */
+};
+
+/*
+** Add the n bytes at z to hash h and return the result (FNV-1a).
+*/
+static u32 vdbeHashBytes(u32 h, const u8 *z, int n){
+  int i;
+  for(i=0; i<n; i++){
+    h = (h ^ z[i]) * 0x01000193;
+  }
+  return h;
+}
+
+/*
+** Add the value of pMem, which is not NULL, to hash h and return the
+** result. The same value is returned for all values that compare equal
+** using the BINARY collation.
+*/
+static u32 vdbeHashMem(u32 h, const Mem *pMem){
+  int f = pMem->flags;
+  u8 eType;
+  if( f & (MEM_Int|MEM_Real) ){
+    double r = (f & MEM_Real) ? pMem->r : (double)pMem->u.i;
+    u8 aBuf[8];
+    if( r==0.0 ) r = 0.0;         /* So that -0.0 and 0.0 hash equally */
+    memcpy(aBuf, &r, 8);
+    eType = 'n';
+    h = vdbeHashBytes(h, &eType, 1);
+    h = vdbeHashBytes(h, aBuf, 8);
+  }else{
+    eType = (f & MEM_Str) ? 't' : 'b';
+    h = vdbeHashBytes(h, &eType, 1);
+    h = vdbeHashBytes(h, (const u8*)pMem->z, pMem->n);
+    if( f & MEM_Zero ){
+      static const u8 zero = 0;
+      int i;
+      for(i=0; i<pMem->u.nZero; i++) h = vdbeHashBytes(h, &zero, 1);
+    }
+  }
+  return h;
+}
+
+/*
+** Hash the first nKey fields of the nRec byte record aRec. Set *pbNull
+** and return 0 if any of them is NULL.
+*/
+static u32 vdbeHashRecord(const u8 *aRec, int nRec, int nKey, int *pbNull){
+  u32 h = 0x811c9dc5;
+  u32 szHdr;
+  u32 idx;
+  u32 d;
+  int i;
+
+  *pbNull = 0;
+  idx = getVarint32(aRec, szHdr);
+  d = szHdr;
+  for(i=0; i<nKey && idx<szHdr && d<=(u32)nRec; i++){
+    u32 serial_type;
+    Mem mem;
+    idx += getVarint32(&aRec[idx], serial_type);
+    if( d+sqlite3VdbeSerialTypeLen(serial_type)>(u32)nRec ) break;
+    mem.flags = 0;
+    d += sqlite3VdbeSerialGet(&aRec[d], serial_type, &mem);
+    if( mem.flags & MEM_Null ){
+      *pbNull = 1;
+      return 0;
+    }
+    h = vdbeHashMem(h, &mem);
+  }
+  return h;
+}
+
+/*
+** Hash the nVal values in array aVal[]. Set *pbNull and return 0 if any
+** of them is NULL. This is also used to hash the keys of the Bloom
+** filters built by OP_FilterAdd.
+*/
+u32 sqlite3VdbeHashValues(const Mem *aVal, int nVal, int *pbNull){
+  u32 h = 0x811c9dc5;
+  int i;
+  *pbNull = 0;
+  for(i=0; i<nVal; i++){
+    if( aVal[i].flags & MEM_Null ){
+      *pbNull = 1;
+      return 0;
+    }
+    h = vdbeHashMem(h, &aVal[i]);
+  }
+  return h;
+}
+
+/*
+** Return the two bits of a Bloom filter that are set for keys with hash
+** h. The filter is nByte bytes in size. The second bit is derived from a
+** rotation of h, so that two keys that collide on one bit are unlikely to
+** collide on the other.
+*/
+static void vdbeBloomBits(u32 h, int nByte, u32 *aBit){
+  u32 nBit = (u32)nByte*8;
+  aBit[0] = h % nBit;
+  aBit[1] = (((h>>13) | (h<<19)) * 0x9e3779b1) % nBit;
+}
+
+/*
+** Add the key with hash h to the Bloom filter stored in blob pFilter.
+*/
+void sqlite3VdbeBloomAdd(Mem *pFilter, u32 h){
+  u32 aBit[2];
+  assert( (pFilter->flags & (MEM_Blob|MEM_Zero))==MEM_Blob && pFilter->n>0 );
+  vdbeBloomBits(h, pFilter->n, aBit);
+  pFilter->z[aBit[0]/8] |= 1<<(aBit[0]&7);
+  pFilter->z[aBit[1]/8] |= 1<<(aBit[1]&7);
+}
+
+/*
+** Return false if no key with hash h has been added to the Bloom filter
+** stored in blob pFilter. Otherwise, return true.
+*/
+int sqlite3VdbeBloomTest(const Mem *pFilter, u32 h){
+  u32 aBit[2];
+  assert( (pFilter->flags & (MEM_Blob|MEM_Zero))==MEM_Blob && pFilter->n>0 );
+  vdbeBloomBits(h, pFilter->n, aBit);
+  return (pFilter->z[aBit[0]/8] & (1<<(aBit[0]&7)))!=0
+      && (pFilter->z[aBit[1]/8] & (1<<(aBit[1]&7)))!=0;
+}
+
+/*
+** Initialize the hash table for cursor pCsr, which was allocated with
+** space for a b-tree cursor. The first nKey fields of each record
+** inserted are its key.
+*/
+int sqlite3VdbeHashInit(sqlite3 *db, VdbeCursor *pCsr, int nKey){
+  VdbeHash *pHash;
+
+  assert( pCsr->pKeyInfo && pCsr->pBt==0 && pCsr->pCursor );
+  pCsr->pHash = pHash = sqlite3DbMallocZero(db, sizeof(VdbeHash));
+  if( pHash==0 ){
+    return SQLITE_NOMEM;
+  }
+  pHash->nKey = nKey;
+  pHash->nSlot = HASH_INIT_SLOT;
+  pHash->aSlot = sqlite3MallocZero(HASH_INIT_SLOT*sizeof(HashEntry*));
+  if( pHash->aSlot==0 ){
+    db->mallocFailed = 1;
+    return SQLITE_NOMEM;
+  }
+
+  /* The b-tree cursor is only used once the table has been moved to a
+  ** temporary file. Until then pCsr->pCursor is NULL. */
+  pHash->pBtCsr = pCsr->pCursor;
+  pCsr->pCursor = 0;
+
+  if( !sqlite3TempInMemory(db) ){
+    int pgsz = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
+    int mxCache = db->aDb[0].pSchema->cache_size;
+    if( mxCache<HASH_MIN_WORKING ) mxCache = HASH_MIN_WORKING;
+    pHash->mxByte = (i64)mxCache * pgsz;
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Free the records of the in-memory table.
+*/
+static void vdbeHashClear(VdbeHash *pHash){
+  int i;
+  for(i=0; i<pHash->nSlot; i++){
+    HashEntry *p;
+    HashEntry *pNext;
+    for(p=pHash->aSlot[i]; p; p=pNext){
+      pNext = p->pNext;
+      sqlite3_free(p);
+    }
+  }
+  sqlite3_free(pHash->aSlot);
+  pHash->aSlot = 0;
+  pHash->nSlot = 0;
+  pHash->nEntry = 0;
+  pHash->nByte = 0;
+  pHash->pCur = 0;
+}
+
+/*
+** Free the hash table of cursor pCsr, if any. The b-tree, if the table
+** was moved to one, is closed by the caller.
+*/
+void sqlite3VdbeHashClose(sqlite3 *db, VdbeCursor *pCsr){
+  VdbeHash *pHash = pCsr->pHash;
+  if( pHash ){
+    vdbeHashClear(pHash);
+    sqlite3DbFree(db, pHash);
+    pCsr->pHash = 0;
+  }
+}
+
+/*
+** Double the number of slots in the hash table. If the new array cannot
+** be allocated, the table keeps working with longer chains.
+*/
+static void vdbeHashGrow(VdbeHash *pHash){
+  int nNew = pHash->nSlot*2;
+  HashEntry **aNew;
+  int i;
+
+  sqlite3BeginBenignMalloc();
+  aNew = sqlite3MallocZero(nNew*sizeof(HashEntry*));
+  sqlite3EndBenignMalloc();
+  if( aNew==0 ) return;
+  for(i=0; i<pHash->nSlot; i++){
+    HashEntry *p;
+    HashEntry *pNext;
+    for(p=pHash->aSlot[i]; p; p=pNext){
+      HashEntry **pp = &aNew[p->iHash & (nNew-1)];
+      pNext = p->pNext;
+      p->pNext = *pp;
+      *pp = p;
+    }
+  }
+  sqlite3_free(pHash->aSlot);
+  pHash->aSlot = aNew;
+  pHash->nSlot = nNew;
+}
+
+/*
+** Move the records of the in-memory table of pCsr to a b-tree index in a
+** temporary file, and make pCsr a cursor on that index.
+*/
+static int vdbeHashSpill(sqlite3 *db, VdbeCursor *pCsr){
+  static const int vfsFlags =
+      SQLITE_OPEN_READWRITE |
+      SQLITE_OPEN_CREATE |
+      SQLITE_OPEN_EXCLUSIVE |
+      SQLITE_OPEN_DELETEONCLOSE |
+      SQLITE_OPEN_TRANSIENT_DB;
+  VdbeHash *pHash = pCsr->pHash;
+  int rc;
+  int pgno;
+  int i;
+
+  assert( pCsr->pBt==0 && pCsr->pCursor==0 );
+  rc = sqlite3BtreeOpen(db->pVfs, 0, db, &pCsr->pBt,
+                        BTREE_OMIT_JOURNAL | BTREE_SINGLE, vfsFlags);
+  if( rc==SQLITE_OK ){
+    rc = sqlite3BtreeBeginTrans(pCsr->pBt, 1);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3BtreeCreateTable(pCsr->pBt, &pgno, BTREE_BLOBKEY);
+  }
+  if( rc==SQLITE_OK ){
+    rc = sqlite3BtreeCursor(pCsr->pBt, pgno, 1, pCsr->pKeyInfo, pHash->pBtCsr);
+  }
+  if( rc==SQLITE_OK ){
+    pCsr->pCursor = pHash->pBtCsr;
+    for(i=0; rc==SQLITE_OK && i<pHash->nSlot; i++){
+      HashEntry *p;
+      for(p=pHash->aSlot[i]; rc==SQLITE_OK && p; p=p->pNext){
+        rc = sqlite3BtreeInsert(
+            pCsr->pCursor, HASH_ENTRY_REC(p), p->nRec, "", 0, 0, 0, 0
+        );
+      }
+    }
+    vdbeHashClear(pHash);
+  }
+  return rc;
+}
+
+/*
+** Add the record in register pVal to the hash table of cursor pCsr.
+*/
+int sqlite3VdbeHashInsert(sqlite3 *db, VdbeCursor *pCsr, Mem *pVal){
+  VdbeHash *pHash = pCsr->pHash;
+  HashEntry *p;
+  u32 h;
+  int bNull;
+
+  assert( pHash && (pVal->flags & MEM_Blob) );
+  h = vdbeHashRecord((const u8*)pVal->z, pVal->n, pHash->nKey, &bNull);
+  if( bNull ) return SQLITE_OK;
+
+  if( pCsr->pCursor ){
+    return sqlite3BtreeInsert(pCsr->pCursor, pVal->z, pVal->n, "", 0, 0, 0, 0);
+  }
+
+  p = (HashEntry*)sqlite3Malloc(sizeof(HashEntry) + pVal->n);
+  if( p==0 ){
+    return SQLITE_NOMEM;
+  }
+  memcpy((u8*)&p[1], pVal->z, pVal->n);
+  p->nRec = pVal->n;
+  p->iHash = h;
+  p->pNext = pHash->aSlot[h & (pHash->nSlot-1)];
+  pHash->aSlot[h & (pHash->nSlot-1)] = p;
+  pHash->nEntry++;
+  pHash->nByte += sizeof(HashEntry) + pVal->n;
+
+  if( pHash->mxByte>0 && pHash->nByte>pHash->mxByte ){
+    return vdbeHashSpill(db, pCsr);
+  }
+  if( pHash->nEntry>=pHash->nSlot ){
+    vdbeHashGrow(pHash);
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Starting with entry p, return the first entry of its chain that matches
+** the current probe key, or NULL if there is none.
+*/
+static HashEntry *vdbeHashMatch(VdbeHash *pHash, HashEntry *p){
+  const UnpackedRecord *pKey = &pHash->rProbe;
+  for(; p; p=p->pNext){
+    if( p->iHash==pHash->iProbe
+     && sqlite3VdbeRecordCompare(p->nRec, HASH_ENTRY_REC(p), pKey, 0)==0
+    ){
+      break;
+    }
+  }
+  return p;
+}
+
+/*
+** If the current b-tree index entry does not match the probe key, set
+** *pRes to 1. Otherwise set it to 0.
+*/
+static int vdbeHashBtreeMatch(VdbeCursor *pCsr, int *pRes){
+  int rc = SQLITE_OK;
+  int c = 0;
+  if( sqlite3BtreeEof(pCsr->pCursor) ){
+    *pRes = 1;
+  }else{
+    rc = sqlite3VdbeIdxKeyCompare(pCsr, &pCsr->pHash->rProbe, &c);
+    *pRes = (c!=0);
+  }
+  return rc;
+}
+
+/*
+** Point cursor pCsr at the first record of its hash table whose key is
+** equal to the values of pKey. Set *pRes to 0 if there is one, or to 1 if
+** there is not. The values of pKey must not change until the cursor is
+** probed again.
+*/
+int sqlite3VdbeHashProbe(VdbeCursor *pCsr, UnpackedRecord *pKey, int *pRes){
+  VdbeHash *pHash = pCsr->pHash;
+  int bNull;
+
+  assert( pHash );
+  pHash->rProbe = *pKey;
+  pHash->rProbe.default_rc = 0;
+  pHash->iProbe = sqlite3VdbeHashValues(pKey->aMem, pKey->nField, &bNull);
+  pHash->pCur = 0;
+  if( bNull ){
+    *pRes = 1;
+    return SQLITE_OK;
+  }
+
+  if( pCsr->pCursor ){
+    int rc;
+    int res = 0;
+    pHash->rProbe.default_rc = +1;
+    rc = sqlite3BtreeMovetoUnpacked(pCsr->pCursor, &pHash->rProbe, 0, 0, &res);
+    pHash->rProbe.default_rc = 0;
+    if( rc==SQLITE_OK && res<0 ){
+      res = 0;
+      rc = sqlite3BtreeNext(pCsr->pCursor, &res);
+    }
+    if( rc==SQLITE_OK ){
+      rc = vdbeHashBtreeMatch(pCsr, pRes);
+    }
+    return rc;
+  }
+
+  pHash->pCur = vdbeHashMatch(pHash,
+      pHash->aSlot[pHash->iProbe & (pHash->nSlot-1)]
+  );
+  *pRes = (pHash->pCur==0);
+  return SQLITE_OK;
+}
+
+/*
+** Advance cursor pCsr to the next record that matches the current probe
+** key. Set *pRes to 0 if there is one, or to 1 if there is not.
+**
+** If the cursor has been set to a NULL row, by a probe that found nothing
+** or by OP_NullRow for a LEFT JOIN, there are no more records.
+*/
+int sqlite3VdbeHashNext(VdbeCursor *pCsr, int *pRes){
+  VdbeHash *pHash = pCsr->pHash;
+  assert( pHash );
+  if( pCsr->nullRow ){
+    *pRes = 1;
+    return SQLITE_OK;
+  }
+  if( pCsr->pCursor ){
+    int rc;
+    *pRes = 0;
+    rc = sqlite3BtreeNext(pCsr->pCursor, pRes);
+    if( rc==SQLITE_OK && *pRes==0 ){
+      rc = vdbeHashBtreeMatch(pCsr, pRes);
+    }
+    return rc;
+  }
+  assert( pHash->pCur );
+  pHash->pCur = vdbeHashMatch(pHash, pHash->pCur->pNext);
+  *pRes = (pHash->pCur==0);
+  return SQLITE_OK;
+}
+
+/*
+** Return a pointer to the record that in-memory cursor pCsr points to,
+** and set *pnByte to its size.
+*/
+const u8 *sqlite3VdbeHashRowdata(const VdbeCursor *pCsr, u32 *pnByte){
+  HashEntry *p = pCsr->pHash->pCur;
+  assert( pCsr->pCursor==0 && p );
+  *pnByte = (u32)p->nRec;
+  return HASH_ENTRY_REC(p);
+}
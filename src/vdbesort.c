@@ -22,6 +22,16 @@
 typedef struct VdbeSorterIter VdbeSorterIter;
 typedef struct SorterRecord SorterRecord;
 typedef struct FileWriter FileWriter;
+typedef struct MergeEngine MergeEngine;
+typedef struct SortSubtask SortSubtask;
+
+/*
+** A function used to compare two sorter records, see
+** vdbeSorterCompareRecord() for the details.
+*/
+typedef int (*SorterCompare)(
+  const SortSubtask*, int*, const void*, int, const void*, int
+);
 
 /*
 ** NOTES ON DATA STRUCTURE USED FOR N-WAY MERGES:
@@ -43,7 +53,7 @@ typedef struct FileWriter FileWriter;
 ** treated as if they are empty (always at EOF).
 **
 ** The aTree[] array is also N elements in size. The value of N is stored in
-** the VdbeSorter.nTree variable.
+** the MergeEngine.nTree variable.
 **
 ** The final (N/2) elements of aTree[] contain the results of comparing
 ** pairs of iterator keys together. Element i contains the result of 
@@ -92,19 +102,66 @@ typedef struct FileWriter FileWriter;
 ** key comparison operations are required, where N is the number of segments
 ** being merged (rounded up to the next power of 2).
 */
-struct VdbeSorter {
-  i64 iWriteOff;                  /* Current write offset within file pTemp1 */
-  i64 iReadOff;                   /* Current read offset within file pTemp1 */
-  int nInMemory;                  /* Current size of pRecord list as PMA */
+struct MergeEngine {
   int nTree;                      /* Used size of aTree/aIter (power of 2) */
+  int *aTree;                     /* Current state of incremental merge */
+  VdbeSorterIter *aIter;          /* Array of iterators to merge */
+};
+
+/*
+** NOTES ON WORKER THREADS:
+**
+** The work of the sorter is split between one or more sub-tasks, one for
+** each worker thread the statement may use (see "PRAGMA threads"), or a
+** single one if it may not use any. Each sub-task owns a temporary file
+** and the PMAs written to it.
+**
+** When the in-memory list is full, it is handed to the next sub-task in
+** turn, which sorts it and appends it to its file as a new PMA. If worker
+** threads are enabled this happens in a background thread while the VDBE
+** keeps adding records to a new in-memory list. The VDBE only waits if the
+** sub-task is still busy with its previous list.
+**
+** When the sorter is rewound, each sub-task merges its own PMAs, again in
+** a background thread, SORTER_MAX_MERGE_COUNT at a time into a second
+** temporary file, until SortSubtask.nTarget or less are left. Then the PMAs
+** of all the sub-tasks are merged incrementally by the VDBE in a single
+** pass, as described above.
+**
+** The sub-tasks running in a background thread can not use the database
+** connection: their memory is not allocated from lookaside and they
+** compare keys using a copy of the KeyInfo with KeyInfo.db set to NULL.
+*/
+struct SortSubtask {
+  SQLiteThread *pThread;          /* Thread running the current job, or NULL */
+  VdbeSorter *pSorter;            /* Sorter that owns this sub-task */
+  sqlite3 *db;                    /* Database for malloc(), NULL if threads */
+  KeyInfo *pKeyInfo;              /* How to compare keys */
+  UnpackedRecord *pUnpacked;      /* Used to unpack keys */
+  SorterCompare xCompare;         /* Compare function to use */
+  SorterRecord *pList;            /* List to sort and write as a PMA */
+  int nList;                      /* Size of pList as PMA, in bytes */
+  int nTarget;                    /* Merge until this many PMAs are left */
   int nPMA;                       /* Number of PMAs stored in pTemp1 */
+  i64 iWriteOff;                  /* Current write offset within file pTemp1 */
+  sqlite3_file *pTemp1;           /* PMA file 1 */
+  sqlite3_file *pTemp2;           /* PMA file 2, used to merge the PMAs */
+};
+
+struct VdbeSorter {
+  int nInMemory;                  /* Current size of pRecord list as PMA */
   int mnPmaSize;                  /* Minimum PMA size, in bytes */
   int mxPmaSize;                  /* Maximum PMA size, in bytes.  0==no limit */
-  VdbeSorterIter *aIter;          /* Array of iterators to merge */
-  int *aTree;                     /* Current state of incremental merge */
-  sqlite3_file *pTemp1;           /* PMA file 1 */
+  int pgsz;                       /* Page size of the main database */
+  u8 bUsePMA;                     /* True if one or more PMAs were written */
+  u8 bUseThreads;                 /* True to run the sub-tasks in threads */
+  u8 typeMask;                    /* SORTER_TYPE_* of the first fields */
   SorterRecord *pRecord;          /* Head of in-memory record list */
-  UnpackedRecord *pUnpacked;      /* Used to unpack keys */
+  MergeEngine *pMerger;           /* Final merge of the PMAs, or NULL */
+  KeyInfo *pKeyInfo;              /* Copy of the cursor KeyInfo for threads */
+  int iPrev;                      /* Sub-task that got the last list */
+  int nTask;                      /* Number of sub-tasks in aTask[] */
+  SortSubtask aTask[1];           /* One or more sub-tasks */
 };
 
 /*
@@ -156,6 +213,32 @@ struct SorterRecord {
 /* Maximum number of segments to merge in a single pass. */
 #define SORTER_MAX_MERGE_COUNT 16
 
+/*
+** Values for VdbeSorter.typeMask. While the first field of every record
+** added to the sorter is an integer (or a text value, compared with the
+** BINARY collation sequence), the records are compared with a specialized
+** function that looks at that field in place (see vdbeSorterGetCompare()).
+*/
+#define SORTER_TYPE_INTEGER 0x01
+#define SORTER_TYPE_TEXT    0x02
+
+/*
+** Resize an allocation made with sqlite3DbMallocRaw(db, ...). The database
+** handle may be NULL if this is called by a sub-task in a worker thread.
+** If the allocation fails, the old allocation is freed and NULL returned.
+*/
+static void *vdbeSorterRealloc(sqlite3 *db, void *pOld, int nNew){
+  void *pNew;
+  if( db ) return sqlite3DbReallocOrFree(db, pOld, nNew);
+  sqlite3MemdebugSetType(pOld, MEMTYPE_HEAP);
+  pNew = sqlite3_realloc(pOld, nNew);
+  if( pNew==0 ){
+    sqlite3_free(pOld);
+  }
+  sqlite3MemdebugSetType(pNew, MEMTYPE_DB|MEMTYPE_HEAP);
+  return pNew;
+}
+
 /*
 ** Free all memory belonging to the VdbeSorterIter object passed as the second
 ** argument. All structure fields are set to zero before returning.
@@ -176,7 +259,7 @@ static void vdbeSorterIterZero(sqlite3 *db, VdbeSorterIter *pIter){
 ** next call to this function.
 */
 static int vdbeSorterIterRead(
-  sqlite3 *db,                    /* Database handle (for malloc) */
+  sqlite3 *db,                    /* Database handle (for malloc), or NULL */
   VdbeSorterIter *p,              /* Iterator */
   int nByte,                      /* Bytes of data to read */
   u8 **ppOut                      /* OUT: Pointer to buffer containing data */
@@ -224,7 +307,7 @@ static int vdbeSorterIterRead(
     if( p->nAlloc<nByte ){
       int nNew = p->nAlloc*2;
       while( nByte>nNew ) nNew = nNew*2;
-      p->aAlloc = sqlite3DbReallocOrFree(db, p->aAlloc, nNew);
+      p->aAlloc = vdbeSorterRealloc(db, p->aAlloc, nNew);
       if( !p->aAlloc ) return SQLITE_NOMEM;
       p->nAlloc = nNew;
     }
@@ -315,28 +398,30 @@ static int vdbeSorterIterNext(
 ** PMA is empty).
 */
 static int vdbeSorterIterInit(
-  sqlite3 *db,                    /* Database handle */
-  const VdbeSorter *pSorter,      /* Sorter object */
+  SortSubtask *pTask,             /* Sub-task doing the merge */
+  sqlite3_file *pFile,            /* File the PMA is stored in */
   i64 iStart,                     /* Start offset in pFile */
+  i64 iFileEof,                   /* Bytes of data stored in pFile */
   VdbeSorterIter *pIter,          /* Iterator to populate */
   i64 *pnByte                     /* IN/OUT: Increment this value by PMA size */
 ){
+  sqlite3 *db = pTask->db;
   int rc = SQLITE_OK;
   int nBuf;
 
-  nBuf = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
+  nBuf = pTask->pSorter->pgsz;
 
-  assert( pSorter->iWriteOff>iStart );
+  assert( iFileEof>iStart );
   assert( pIter->aAlloc==0 );
   assert( pIter->aBuffer==0 );
-  pIter->pFile = pSorter->pTemp1;
+  pIter->pFile = pFile;
   pIter->iReadOff = iStart;
   pIter->nAlloc = 128;
   pIter->aAlloc = (u8 *)sqlite3DbMallocRaw(db, pIter->nAlloc);
   pIter->nBuffer = nBuf;
   pIter->aBuffer = (u8 *)sqlite3DbMallocRaw(db, nBuf);
 
-  if( !pIter->aBuffer ){
+  if( !pIter->aBuffer || !pIter->aAlloc ){
     rc = SQLITE_NOMEM;
   }else{
     int iBuf;
@@ -344,18 +429,16 @@ static int vdbeSorterIterInit(
     iBuf = iStart % nBuf;
     if( iBuf ){
       int nRead = nBuf - iBuf;
-      if( (iStart + nRead) > pSorter->iWriteOff ){
-        nRead = (int)(pSorter->iWriteOff - iStart);
+      if( (iStart + nRead) > iFileEof ){
+        nRead = (int)(iFileEof - iStart);
       }
-      rc = sqlite3OsRead(
-          pSorter->pTemp1, &pIter->aBuffer[iBuf], nRead, iStart
-      );
+      rc = sqlite3OsRead(pFile, &pIter->aBuffer[iBuf], nRead, iStart);
       assert( rc!=SQLITE_IOERR_SHORT_READ );
     }
 
     if( rc==SQLITE_OK ){
       u64 nByte;                       /* Size of PMA in bytes */
-      pIter->iEof = pSorter->iWriteOff;
+      pIter->iEof = iFileEof;
       rc = vdbeSorterIterVarint(db, pIter, &nByte);
       pIter->iEof = pIter->iReadOff + nByte;
       *pnByte += nByte;
@@ -380,25 +463,19 @@ static int vdbeSorterIterInit(
 ** field. For the purposes of the comparison, ignore it. Also, if bOmitRowid
 ** is true and key1 contains even a single NULL value, it is considered to
 ** be less than key2. Even if key2 also contains NULL values.
-**
-** If pKey2 is passed a NULL pointer, then it is assumed that the pCsr->aSpace
-** has been allocated and contains an unpacked record that is used as key2.
 */
 static void vdbeSorterCompare(
-  const VdbeCursor *pCsr,         /* Cursor object (for pKeyInfo) */
+  const SortSubtask *pTask,       /* Sub-task (for pKeyInfo and pUnpacked) */
   int nIgnore,                    /* Ignore the last nIgnore fields */
   const void *pKey1, int nKey1,   /* Left side of comparison */
   const void *pKey2, int nKey2,   /* Right side of comparison */
   int *pRes                       /* OUT: Result of comparison */
 ){
-  KeyInfo *pKeyInfo = pCsr->pKeyInfo;
-  VdbeSorter *pSorter = pCsr->pSorter;
-  UnpackedRecord *r2 = pSorter->pUnpacked;
+  KeyInfo *pKeyInfo = pTask->pKeyInfo;
+  UnpackedRecord *r2 = pTask->pUnpacked;
   int i;
 
-  if( pKey2 ){
-    sqlite3VdbeRecordUnpack(pKeyInfo, nKey2, pKey2, r2);
-  }
+  sqlite3VdbeRecordUnpack(pKeyInfo, nKey2, pKey2, r2);
 
   if( nIgnore ){
     r2->nField = pKeyInfo->nField - nIgnore;
@@ -415,31 +492,163 @@ static void vdbeSorterCompare(
   *pRes = sqlite3VdbeRecordCompare(nKey1, pKey1, r2, 0);
 }
 
+/*
+** The following functions are the SorterCompare implementations used to
+** sort the records and merge the PMAs. Each of them compares key1 (buffer
+** pKey1, size nKey1 bytes) with key2 (buffer pKey2, size nKey2 bytes) and
+** returns a negative, zero or positive value, depending on whether key1 is
+** smaller, equal to or larger than key2.
+**
+** If *pbKey2Cached is true when called, pTask->pUnpacked already contains
+** the unpacked key2 and pKey2 is not unpacked again. Otherwise, it is set
+** to true if key2 is unpacked into pTask->pUnpacked. This saves unpacking
+** the same key over and over while merging two lists.
+**
+** vdbeSorterCompareRecord() compares the records field by field, using
+** the collation sequences of the KeyInfo. The others only work if the first
+** field of all the records has the same type (see VdbeSorter.typeMask and
+** vdbeSorterGetCompare()), compare that field directly within the record
+** and only unpack the records if the first fields are equal.
+*/
+static int vdbeSorterCompareRecord(
+  const SortSubtask *pTask,       /* Sub-task (for pKeyInfo and pUnpacked) */
+  int *pbKey2Cached,              /* True if pTask->pUnpacked is key2 */
+  const void *pKey1, int nKey1,   /* Left side of comparison */
+  const void *pKey2, int nKey2    /* Right side of comparison */
+){
+  UnpackedRecord *r2 = pTask->pUnpacked;
+  if( *pbKey2Cached==0 ){
+    sqlite3VdbeRecordUnpack(pTask->pKeyInfo, nKey2, pKey2, r2);
+    *pbKey2Cached = 1;
+  }
+  return sqlite3VdbeRecordCompare(nKey1, pKey1, r2, 0);
+}
+
+/*
+** Compare the second and subsequent fields of two records whose first
+** fields are known to be equal.
+*/
+static int vdbeSorterCompareTail(
+  const SortSubtask *pTask,       /* Sub-task (for pKeyInfo and pUnpacked) */
+  int *pbKey2Cached,              /* True if pTask->pUnpacked is key2 */
+  const void *pKey1, int nKey1,   /* Left side of comparison */
+  const void *pKey2, int nKey2    /* Right side of comparison */
+){
+  UnpackedRecord *r2 = pTask->pUnpacked;
+  if( pTask->pKeyInfo->nField<2 ) return 0;
+  if( *pbKey2Cached==0 ){
+    sqlite3VdbeRecordUnpack(pTask->pKeyInfo, nKey2, pKey2, r2);
+    *pbKey2Cached = 1;
+  }
+  return sqlite3VdbeRecordCompare(nKey1, pKey1, r2, 1);
+}
+
+/*
+** Return the value of an integer stored in a record as serial type
+** serial_type (1 to 6, 8 or 9) at a[].
+*/
+static i64 vdbeSorterIntValue(int serial_type, const u8 *a){
+  static const u8 aLen[] = { 0, 1, 2, 3, 4, 6, 8 };
+  i64 v;
+  int i;
+  if( serial_type>7 ) return serial_type-8;
+  v = (signed char)a[0];
+  for(i=1; i<aLen[serial_type]; i++){
+    v = v*256 + a[i];
+  }
+  return v;
+}
+
+/*
+** A SorterCompare for records whose first field is an integer.
+*/
+static int vdbeSorterCompareInt(
+  const SortSubtask *pTask,       /* Sub-task (for pKeyInfo and pUnpacked) */
+  int *pbKey2Cached,              /* True if pTask->pUnpacked is key2 */
+  const void *pKey1, int nKey1,   /* Left side of comparison */
+  const void *pKey2, int nKey2    /* Right side of comparison */
+){
+  const u8 *p1 = (const u8 *)pKey1;
+  const u8 *p2 = (const u8 *)pKey2;
+  i64 v1 = vdbeSorterIntValue(p1[1], &p1[p1[0]]);
+  i64 v2 = vdbeSorterIntValue(p2[1], &p2[p2[0]]);
+  int res;
+
+  if( v1==v2 ){
+    return vdbeSorterCompareTail(pTask, pbKey2Cached, pKey1, nKey1,
+                                 pKey2, nKey2);
+  }
+  res = v1<v2 ? -1 : +1;
+  return pTask->pKeyInfo->aSortOrder[0] ? -res : res;
+}
+
+/*
+** A SorterCompare for records whose first field is a text value compared
+** using the BINARY collation sequence.
+*/
+static int vdbeSorterCompareText(
+  const SortSubtask *pTask,       /* Sub-task (for pKeyInfo and pUnpacked) */
+  int *pbKey2Cached,              /* True if pTask->pUnpacked is key2 */
+  const void *pKey1, int nKey1,   /* Left side of comparison */
+  const void *pKey2, int nKey2    /* Right side of comparison */
+){
+  const u8 *p1 = (const u8 *)pKey1;
+  const u8 *p2 = (const u8 *)pKey2;
+  u32 n1, n2;
+  int res;
+
+  getVarint32(&p1[1], n1);
+  getVarint32(&p2[1], n2);
+  n1 = (n1-13)/2;
+  n2 = (n2-13)/2;
+  res = memcmp(&p1[p1[0]], &p2[p2[0]], MIN(n1, n2));
+  if( res==0 ) res = (int)n1 - (int)n2;
+
+  if( res==0 ){
+    return vdbeSorterCompareTail(pTask, pbKey2Cached, pKey1, nKey1,
+                                 pKey2, nKey2);
+  }
+  return pTask->pKeyInfo->aSortOrder[0] ? -res : res;
+}
+
+/*
+** Return the SorterCompare to use for the records added to the sorter so
+** far.
+*/
+static SorterCompare vdbeSorterGetCompare(const VdbeSorter *pSorter){
+  if( pSorter->typeMask==SORTER_TYPE_INTEGER ) return vdbeSorterCompareInt;
+  if( pSorter->typeMask==SORTER_TYPE_TEXT ) return vdbeSorterCompareText;
+  return vdbeSorterCompareRecord;
+}
+
 /*
 ** This function is called to compare two iterator keys when merging 
 ** multiple b-tree segments. Parameter iOut is the index of the aTree[] 
 ** value to recalculate.
 */
-static int vdbeSorterDoCompare(const VdbeCursor *pCsr, int iOut){
-  VdbeSorter *pSorter = pCsr->pSorter;
+static int vdbeSorterDoCompare(
+  const SortSubtask *pTask,       /* Sub-task doing the merge */
+  MergeEngine *pMerger,           /* Merge engine to update */
+  int iOut                        /* Index of aTree[] to recalculate */
+){
   int i1;
   int i2;
   int iRes;
   VdbeSorterIter *p1;
   VdbeSorterIter *p2;
 
-  assert( iOut<pSorter->nTree && iOut>0 );
+  assert( iOut<pMerger->nTree && iOut>0 );
 
-  if( iOut>=(pSorter->nTree/2) ){
-    i1 = (iOut - pSorter->nTree/2) * 2;
+  if( iOut>=(pMerger->nTree/2) ){
+    i1 = (iOut - pMerger->nTree/2) * 2;
     i2 = i1 + 1;
   }else{
-    i1 = pSorter->aTree[iOut*2];
-    i2 = pSorter->aTree[iOut*2+1];
+    i1 = pMerger->aTree[iOut*2];
+    i2 = pMerger->aTree[iOut*2+1];
   }
 
-  p1 = &pSorter->aIter[i1];
-  p2 = &pSorter->aIter[i2];
+  p1 = &pMerger->aIter[i1];
+  p2 = &pMerger->aIter[i2];
 
   if( p1->pFile==0 ){
     iRes = i2;
@@ -447,9 +656,10 @@ static int vdbeSorterDoCompare(const VdbeCursor *pCsr, int iOut){
     iRes = i1;
   }else{
     int res;
-    assert( pCsr->pSorter->pUnpacked!=0 );  /* allocated in vdbeSorterMerge() */
-    vdbeSorterCompare(
-        pCsr, 0, p1->aKey, p1->nKey, p2->aKey, p2->nKey, &res
+    int bCached = 0;
+    assert( pTask->pUnpacked!=0 );  /* allocated in sqlite3VdbeSorterInit() */
+    res = pTask->xCompare(
+        pTask, &bCached, p1->aKey, p1->nKey, p2->aKey, p2->nKey
     );
     if( res<=0 ){
       iRes = i1;
@@ -458,10 +668,79 @@ static int vdbeSorterDoCompare(const VdbeCursor *pCsr, int iOut){
     }
   }
 
-  pSorter->aTree[iOut] = iRes;
+  pMerger->aTree[iOut] = iRes;
   return SQLITE_OK;
 }
 
+/*
+** Allocate a new MergeEngine object with space for at least nIter
+** iterators, all at EOF.
+*/
+static MergeEngine *vdbeMergeEngineNew(sqlite3 *db, int nIter){
+  int N = 2;                      /* Power of 2 >= nIter */
+  int nByte;                      /* Bytes of space required for the object */
+  MergeEngine *pNew;              /* Object to return */
+
+  while( N<nIter ) N += N;
+  nByte = sizeof(MergeEngine) + N * (sizeof(int) + sizeof(VdbeSorterIter));
+  pNew = (MergeEngine *)sqlite3DbMallocZero(db, nByte);
+  if( pNew ){
+    pNew->nTree = N;
+    pNew->aIter = (VdbeSorterIter *)&pNew[1];
+    pNew->aTree = (int *)&pNew->aIter[N];
+  }
+  return pNew;
+}
+
+/*
+** Free the MergeEngine object passed as the second argument, and the
+** iterators it contains.
+*/
+static void vdbeMergeEngineFree(sqlite3 *db, MergeEngine *pMerger){
+  if( pMerger ){
+    int i;
+    for(i=0; i<pMerger->nTree; i++){
+      vdbeSorterIterZero(db, &pMerger->aIter[i]);
+    }
+    sqlite3DbFree(db, pMerger);
+  }
+}
+
+/*
+** Initialize the aTree[] array of the merge engine, once its iterators
+** point to the first key of their PMAs.
+*/
+static int vdbeMergeEngineInit(const SortSubtask *pTask, MergeEngine *pMerger){
+  int rc = SQLITE_OK;
+  int i;
+  for(i=pMerger->nTree-1; rc==SQLITE_OK && i>0; i--){
+    rc = vdbeSorterDoCompare(pTask, pMerger, i);
+  }
+  return rc;
+}
+
+/*
+** Advance the merge engine to its next key. Set *pbEof to true if there
+** are no more keys.
+*/
+static int vdbeMergeEngineStep(
+  const SortSubtask *pTask,       /* Sub-task doing the merge */
+  MergeEngine *pMerger,           /* Merge engine to advance */
+  int *pbEof                      /* OUT: True if the merge is finished */
+){
+  int rc;
+  int iPrev = pMerger->aTree[1];  /* Index of iterator to advance */
+  int i;                          /* Index of aTree[] to recalculate */
+
+  rc = vdbeSorterIterNext(pTask->db, &pMerger->aIter[iPrev]);
+  for(i=(pMerger->nTree+iPrev)/2; rc==SQLITE_OK && i>0; i=i/2){
+    rc = vdbeSorterDoCompare(pTask, pMerger, i);
+  }
+
+  *pbEof = (pMerger->aIter[pMerger->aTree[1]].pFile==0);
+  return rc;
+}
+
 /*
 ** Initialize the temporary index cursor just opened as a sorter cursor.
 */
@@ -469,20 +748,74 @@ int sqlite3VdbeSorterInit(sqlite3 *db, VdbeCursor *pCsr){
   int pgsz;                       /* Page size of main database */
   int mxCache;                    /* Cache size */
   VdbeSorter *pSorter;            /* The new sorter */
+  KeyInfo *pKeyInfo;              /* KeyInfo used by the sub-tasks */
+  sqlite3 *dbTask = db;           /* Database used by the sub-tasks */
+  int nWorker = 0;                /* Number of worker threads */
+  int nTask;                      /* Number of sub-tasks */
+  int i;
   char *d;                        /* Dummy */
 
   assert( pCsr->pKeyInfo && pCsr->pBt==0 );
-  pCsr->pSorter = pSorter = sqlite3DbMallocZero(db, sizeof(VdbeSorter));
+  pKeyInfo = pCsr->pKeyInfo;
+
+  /* Worker threads are only useful if the sorter may write PMAs */
+#if SQLITE_MAX_WORKER_THREADS>0
+  if( !sqlite3TempInMemory(db) ){
+    nWorker = db->aLimit[SQLITE_LIMIT_WORKER_THREADS];
+  }
+#endif
+  nTask = nWorker>0 ? nWorker : 1;
+
+  pCsr->pSorter = pSorter = sqlite3DbMallocZero(db,
+      sizeof(VdbeSorter) + (nTask-1)*sizeof(SortSubtask)
+  );
   if( pSorter==0 ){
     return SQLITE_NOMEM;
   }
-  
-  pSorter->pUnpacked = sqlite3VdbeAllocUnpackedRecord(pCsr->pKeyInfo, 0, 0, &d);
-  if( pSorter->pUnpacked==0 ) return SQLITE_NOMEM;
-  assert( pSorter->pUnpacked==(UnpackedRecord *)d );
+  pSorter->nTask = nTask;
+  pSorter->iPrev = nTask-1;
+
+  if( nWorker>0 ){
+    /* The sub-tasks may not use the database connection, see above */
+    int nCol = pKeyInfo->nField + pKeyInfo->nXField;
+    int szKeyInfo = sizeof(KeyInfo) + nCol*(sizeof(CollSeq*)+1);
+    pKeyInfo = (KeyInfo *)sqlite3DbMallocRaw(0, szKeyInfo);
+    if( pKeyInfo==0 ){
+      db->mallocFailed = 1;
+      return SQLITE_NOMEM;
+    }
+    memcpy(pKeyInfo, pCsr->pKeyInfo, szKeyInfo);
+    pKeyInfo->aSortOrder = (u8*)&pKeyInfo->aColl[nCol];
+    pKeyInfo->db = 0;
+    pSorter->pKeyInfo = pKeyInfo;
+    pSorter->bUseThreads = 1;
+    dbTask = 0;
+  }
 
+  for(i=0; i<nTask; i++){
+    SortSubtask *pTask = &pSorter->aTask[i];
+    pTask->pSorter = pSorter;
+    pTask->db = dbTask;
+    pTask->pKeyInfo = pKeyInfo;
+    pTask->xCompare = vdbeSorterCompareRecord;
+    pTask->nTarget = SORTER_MAX_MERGE_COUNT / nTask;
+    if( pTask->nTarget<1 ) pTask->nTarget = 1;
+    pTask->pUnpacked = sqlite3VdbeAllocUnpackedRecord(pKeyInfo, 0, 0, &d);
+    if( pTask->pUnpacked==0 ){
+      db->mallocFailed = 1;
+      return SQLITE_NOMEM;
+    }
+    assert( pTask->pUnpacked==(UnpackedRecord *)d );
+  }
+
+  /* The first fields may only be compared in place if they use the BINARY
+  ** collation sequence, see sqlite3VdbeSorterWrite() */
+  if( pKeyInfo->aColl[0]==0 || pKeyInfo->aColl[0]==db->pDfltColl ){
+    pSorter->typeMask = SORTER_TYPE_INTEGER|SORTER_TYPE_TEXT;
+  }
+
+  pSorter->pgsz = pgsz = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
   if( !sqlite3TempInMemory(db) ){
-    pgsz = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
     pSorter->mnPmaSize = SORTER_MIN_WORKING * pgsz;
     mxCache = db->aDb[0].pSchema->cache_size;
     if( mxCache<SORTER_MIN_WORKING ) mxCache = SORTER_MIN_WORKING;
@@ -504,24 +837,83 @@ static void vdbeSorterRecordFree(sqlite3 *db, SorterRecord *pRecord){
   }
 }
 
+/*
+** The main routine of a sub-task, run by a worker thread or by the VDBE
+** itself. If the sub-task was given a list of records, sort it and write
+** it to a PMA. Otherwise merge the PMAs of the sub-task. Return an SQLite
+** error code cast to a pointer.
+*/
+static void *vdbeSorterTaskMain(void *pCtx);
+
+#if SQLITE_MAX_WORKER_THREADS>0
+/*
+** Wait for the job of sub-task pTask to finish, if it is running in a
+** worker thread, and return its result.
+*/
+static int vdbeSorterJoinTask(SortSubtask *pTask){
+  int rc = SQLITE_OK;
+  if( pTask->pThread ){
+    void *pRet = SQLITE_INT_TO_PTR(SQLITE_ERROR);
+    (void)sqlite3ThreadJoin(pTask->pThread, &pRet);
+    rc = SQLITE_PTR_TO_INT(pRet);
+    pTask->pThread = 0;
+  }
+  return rc;
+}
+#else
+# define vdbeSorterJoinTask(pTask) SQLITE_OK
+#endif
+
+/*
+** Wait for all the sub-tasks of the sorter. Return the first error code
+** reported by one of them, or rcin if it is not SQLITE_OK.
+*/
+static int vdbeSorterJoinAll(VdbeSorter *pSorter, int rcin){
+  int rc = rcin;
+  int i;
+  for(i=0; i<pSorter->nTask; i++){
+    int rc2 = vdbeSorterJoinTask(&pSorter->aTask[i]);
+    if( rc==SQLITE_OK ) rc = rc2;
+  }
+  return rc;
+}
+
+/*
+** Start the job of sub-task pTask, in a worker thread if the sorter uses
+** them. Otherwise the job is done before returning.
+*/
+static int vdbeSorterStartTask(SortSubtask *pTask){
+#if SQLITE_MAX_WORKER_THREADS>0
+  if( pTask->pSorter->bUseThreads ){
+    assert( pTask->pThread==0 );
+    return sqlite3ThreadCreate(&pTask->pThread, vdbeSorterTaskMain, pTask);
+  }
+#endif
+  return SQLITE_PTR_TO_INT(vdbeSorterTaskMain(pTask));
+}
+
 /*
 ** Free any cursor components allocated by sqlite3VdbeSorterXXX routines.
 */
 void sqlite3VdbeSorterClose(sqlite3 *db, VdbeCursor *pCsr){
   VdbeSorter *pSorter = pCsr->pSorter;
   if( pSorter ){
-    if( pSorter->aIter ){
-      int i;
-      for(i=0; i<pSorter->nTree; i++){
-        vdbeSorterIterZero(db, &pSorter->aIter[i]);
+    int i;
+    (void)vdbeSorterJoinAll(pSorter, SQLITE_OK);
+    vdbeMergeEngineFree(pSorter->aTask[0].db, pSorter->pMerger);
+    for(i=0; i<pSorter->nTask; i++){
+      SortSubtask *pTask = &pSorter->aTask[i];
+      vdbeSorterRecordFree(pTask->db, pTask->pList);
+      if( pTask->pTemp1 ){
+        sqlite3OsCloseFree(pTask->pTemp1);
       }
-      sqlite3DbFree(db, pSorter->aIter);
-    }
-    if( pSorter->pTemp1 ){
-      sqlite3OsCloseFree(pSorter->pTemp1);
+      if( pTask->pTemp2 ){
+        sqlite3OsCloseFree(pTask->pTemp2);
+      }
+      sqlite3DbFree(pTask->db, pTask->pUnpacked);
     }
-    vdbeSorterRecordFree(db, pSorter->pRecord);
-    sqlite3DbFree(db, pSorter->pUnpacked);
+    vdbeSorterRecordFree(pSorter->aTask[0].db, pSorter->pRecord);
+    sqlite3DbFree(0, pSorter->pKeyInfo);
     sqlite3DbFree(db, pSorter);
     pCsr->pSorter = 0;
   }
@@ -546,29 +938,29 @@ static int vdbeSorterOpenTempFile(sqlite3 *db, sqlite3_file **ppFile){
 ** Set *ppOut to the head of the new list.
 */
 static void vdbeSorterMerge(
-  const VdbeCursor *pCsr,         /* For pKeyInfo */
+  const SortSubtask *pTask,       /* For pKeyInfo */
   SorterRecord *p1,               /* First list to merge */
   SorterRecord *p2,               /* Second list to merge */
   SorterRecord **ppOut            /* OUT: Head of merged list */
 ){
   SorterRecord *pFinal = 0;
   SorterRecord **pp = &pFinal;
-  void *pVal2 = p2 ? p2->pVal : 0;
+  int bCached = 0;                /* True if p2 is in pTask->pUnpacked */
 
   while( p1 && p2 ){
     int res;
-    vdbeSorterCompare(pCsr, 0, p1->pVal, p1->nVal, pVal2, p2->nVal, &res);
+    res = pTask->xCompare(
+        pTask, &bCached, p1->pVal, p1->nVal, p2->pVal, p2->nVal
+    );
     if( res<=0 ){
       *pp = p1;
       pp = &p1->pNext;
       p1 = p1->pNext;
-      pVal2 = 0;
     }else{
       *pp = p2;
        pp = &p2->pNext;
       p2 = p2->pNext;
-      if( p2==0 ) break;
-      pVal2 = p2->pVal;
+      bCached = 0;
     }
   }
   *pp = p1 ? p1 : p2;
@@ -576,27 +968,26 @@ static void vdbeSorterMerge(
 }
 
 /*
-** Sort the linked list of records headed at pCsr->pRecord. Return SQLITE_OK
+** Sort the linked list of records headed at *ppList. Return SQLITE_OK
 ** if successful, or an SQLite error code (i.e. SQLITE_NOMEM) if an error
 ** occurs.
 */
-static int vdbeSorterSort(const VdbeCursor *pCsr){
+static int vdbeSorterSort(const SortSubtask *pTask, SorterRecord **ppList){
   int i;
   SorterRecord **aSlot;
   SorterRecord *p;
-  VdbeSorter *pSorter = pCsr->pSorter;
 
   aSlot = (SorterRecord **)sqlite3MallocZero(64 * sizeof(SorterRecord *));
   if( !aSlot ){
     return SQLITE_NOMEM;
   }
 
-  p = pSorter->pRecord;
+  p = *ppList;
   while( p ){
     SorterRecord *pNext = p->pNext;
     p->pNext = 0;
     for(i=0; aSlot[i]; i++){
-      vdbeSorterMerge(pCsr, p, aSlot[i], &p);
+      vdbeSorterMerge(pTask, p, aSlot[i], &p);
       aSlot[i] = 0;
     }
     aSlot[i] = p;
@@ -605,25 +996,25 @@ static int vdbeSorterSort(const VdbeCursor *pCsr){
 
   p = 0;
   for(i=0; i<64; i++){
-    vdbeSorterMerge(pCsr, p, aSlot[i], &p);
+    vdbeSorterMerge(pTask, p, aSlot[i], &p);
   }
-  pSorter->pRecord = p;
+  *ppList = p;
 
   sqlite3_free(aSlot);
   return SQLITE_OK;
 }
 
+
 /*
 ** Initialize a file-writer object.
 */
 static void fileWriterInit(
-  sqlite3 *db,                    /* Database (for malloc) */
+  sqlite3 *db,                    /* Database (for malloc), or NULL */
+  int nBuf,                       /* Size of the write buffer */
   sqlite3_file *pFile,            /* File to write to */
   FileWriter *p,                  /* Object to populate */
   i64 iStart                      /* Offset of pFile to begin writing at */
 ){
-  int nBuf = sqlite3BtreeGetPageSize(db->aDb[0].pBt);
-
   memset(p, 0, sizeof(FileWriter));
   p->aBuffer = (u8 *)sqlite3DbMallocRaw(db, nBuf);
   if( !p->aBuffer ){
@@ -699,9 +1090,11 @@ static void fileWriterWriteVarint(FileWriter *p, u64 iVal){
   fileWriterWrite(p, aByte, nByte);
 }
 
+
 /*
-** Write the current contents of the in-memory linked-list to a PMA. Return
-** SQLITE_OK if successful, or an SQLite error code otherwise.
+** Sort the list of records given to sub-task pTask and write it to a new
+** PMA at the end of file pTask->pTemp1. Return SQLITE_OK if successful, or
+** an SQLite error code otherwise.
 **
 ** The format of a PMA is:
 **
@@ -712,43 +1105,165 @@ static void fileWriterWriteVarint(FileWriter *p, u64 iVal){
 **       Each record consists of a varint followed by a blob of data (the 
 **       key). The varint is the number of bytes in the blob of data.
 */
-static int vdbeSorterListToPMA(sqlite3 *db, const VdbeCursor *pCsr){
-  int rc = SQLITE_OK;             /* Return code */
-  VdbeSorter *pSorter = pCsr->pSorter;
+static int vdbeSorterListToPMA(SortSubtask *pTask){
+  sqlite3 *db = pTask->db;
+  int rc;                         /* Return code */
   FileWriter writer;
+#ifdef SQLITE_DEBUG
+  i64 nExpect = pTask->iWriteOff
+              + sqlite3VarintLen(pTask->nList)
+              + pTask->nList;
+#endif
 
   memset(&writer, 0, sizeof(FileWriter));
+  assert( pTask->pList && pTask->pTemp1 );
 
-  if( pSorter->nInMemory==0 ){
-    assert( pSorter->pRecord==0 );
-    return rc;
-  }
-
-  rc = vdbeSorterSort(pCsr);
-
-  /* If the first temporary PMA file has not been opened, open it now. */
-  if( rc==SQLITE_OK && pSorter->pTemp1==0 ){
-    rc = vdbeSorterOpenTempFile(db, &pSorter->pTemp1);
-    assert( rc!=SQLITE_OK || pSorter->pTemp1 );
-    assert( pSorter->iWriteOff==0 );
-    assert( pSorter->nPMA==0 );
-  }
+  rc = vdbeSorterSort(pTask, &pTask->pList);
 
   if( rc==SQLITE_OK ){
     SorterRecord *p;
     SorterRecord *pNext = 0;
 
-    fileWriterInit(db, pSorter->pTemp1, &writer, pSorter->iWriteOff);
-    pSorter->nPMA++;
-    fileWriterWriteVarint(&writer, pSorter->nInMemory);
-    for(p=pSorter->pRecord; p; p=pNext){
+    fileWriterInit(db, pTask->pSorter->pgsz, pTask->pTemp1, &writer,
+                   pTask->iWriteOff);
+    pTask->nPMA++;
+    fileWriterWriteVarint(&writer, pTask->nList);
+    for(p=pTask->pList; p; p=pNext){
       pNext = p->pNext;
       fileWriterWriteVarint(&writer, p->nVal);
       fileWriterWrite(&writer, p->pVal, p->nVal);
       sqlite3DbFree(db, p);
     }
-    pSorter->pRecord = p;
-    rc = fileWriterFinish(db, &writer, &pSorter->iWriteOff);
+    pTask->pList = 0;
+    rc = fileWriterFinish(db, &writer, &pTask->iWriteOff);
+  }
+
+  assert( rc!=SQLITE_OK || (nExpect==pTask->iWriteOff) );
+  return rc;
+}
+
+/*
+** Merge the PMAs stored in pTask->pTemp1, SORTER_MAX_MERGE_COUNT at a
+** time, into new PMAs written to pTask->pTemp2. The two files are then
+** swapped, and the process repeated until pTask->nTarget or less PMAs
+** are left.
+*/
+static int vdbeSorterMergePMAs(SortSubtask *pTask){
+  sqlite3 *db = pTask->db;
+  int rc = SQLITE_OK;             /* Return code */
+
+  assert( pTask->pTemp2 );
+  while( rc==SQLITE_OK && pTask->nPMA>pTask->nTarget ){
+    i64 iReadOff = 0;             /* Read offset within pTemp1 */
+    i64 iWrite2 = 0;              /* Write offset for pTemp2 */
+    int nNew = 0;                 /* Number of PMAs written to pTemp2 */
+    sqlite3_file *pTmp;
+
+    while( rc==SQLITE_OK && iReadOff<pTask->iWriteOff ){
+      MergeEngine *pMerger;       /* Merges the next group of PMAs */
+      i64 nWrite = 0;             /* Number of bytes in new PMA */
+      int i;
+
+      pMerger = vdbeMergeEngineNew(db, SORTER_MAX_MERGE_COUNT);
+      if( pMerger==0 ){
+        rc = SQLITE_NOMEM;
+        break;
+      }
+      for(i=0; i<SORTER_MAX_MERGE_COUNT; i++){
+        VdbeSorterIter *pIter = &pMerger->aIter[i];
+        rc = vdbeSorterIterInit(pTask, pTask->pTemp1, iReadOff,
+                                pTask->iWriteOff, pIter, &nWrite);
+        iReadOff = pIter->iEof;
+        assert( rc!=SQLITE_OK || iReadOff<=pTask->iWriteOff );
+        if( rc!=SQLITE_OK || iReadOff>=pTask->iWriteOff ) break;
+      }
+      if( rc==SQLITE_OK ){
+        rc = vdbeMergeEngineInit(pTask, pMerger);
+      }
+
+      if( rc==SQLITE_OK ){
+        int rc2;                  /* Return code from fileWriterFinish() */
+        int bEof = 0;
+        FileWriter writer;        /* Object used to write to disk */
+
+        fileWriterInit(db, pTask->pSorter->pgsz, pTask->pTemp2, &writer,
+                       iWrite2);
+        fileWriterWriteVarint(&writer, nWrite);
+        while( rc==SQLITE_OK && bEof==0 ){
+          VdbeSorterIter *pIter = &pMerger->aIter[ pMerger->aTree[1] ];
+          assert( pIter->pFile );
+
+          fileWriterWriteVarint(&writer, pIter->nKey);
+          fileWriterWrite(&writer, pIter->aKey, pIter->nKey);
+          rc = vdbeMergeEngineStep(pTask, pMerger, &bEof);
+        }
+        rc2 = fileWriterFinish(db, &writer, &iWrite2);
+        if( rc==SQLITE_OK ) rc = rc2;
+      }
+      vdbeMergeEngineFree(db, pMerger);
+      nNew++;
+    }
+
+    pTmp = pTask->pTemp1;
+    pTask->pTemp1 = pTask->pTemp2;
+    pTask->pTemp2 = pTmp;
+    pTask->iWriteOff = iWrite2;
+    pTask->nPMA = nNew;
+  }
+
+  return rc;
+}
+
+static void *vdbeSorterTaskMain(void *pCtx){
+  SortSubtask *pTask = (SortSubtask *)pCtx;
+  int rc;
+  if( pTask->pList ){
+    rc = vdbeSorterListToPMA(pTask);
+  }else{
+    rc = vdbeSorterMergePMAs(pTask);
+  }
+  return SQLITE_INT_TO_PTR(rc);
+}
+
+/*
+** Hand the in-memory list of records over to the next sub-task, which
+** sorts it and writes it to a new PMA. Return SQLITE_OK if successful, or
+** an SQLite error code otherwise. If the sorter uses worker threads, the
+** error may also be reported when the sub-task is joined.
+*/
+static int vdbeSorterFlushPMA(sqlite3 *db, const VdbeCursor *pCsr){
+  VdbeSorter *pSorter = pCsr->pSorter;
+  SortSubtask *pTask;
+  int rc;
+
+  if( pSorter->nInMemory==0 ){
+    assert( pSorter->pRecord==0 );
+    return SQLITE_OK;
+  }
+
+  /* Wait for the sub-task to finish with its previous list */
+  pSorter->iPrev = (pSorter->iPrev + 1) % pSorter->nTask;
+  pTask = &pSorter->aTask[pSorter->iPrev];
+  rc = vdbeSorterJoinTask(pTask);
+
+  /* If the temporary PMA file of the sub-task has not been opened, open
+  ** it now. */
+  if( rc==SQLITE_OK && pTask->pTemp1==0 ){
+    rc = vdbeSorterOpenTempFile(db, &pTask->pTemp1);
+    assert( rc!=SQLITE_OK || pTask->pTemp1 );
+    assert( pTask->iWriteOff==0 );
+    assert( pTask->nPMA==0 );
+  }
+
+  if( rc==SQLITE_OK ){
+    assert( pTask->pList==0 );
+    pTask->pList = pSorter->pRecord;
+    pTask->nList = pSorter->nInMemory;
+    pSorter->pRecord = 0;
+    pSorter->nInMemory = 0;
+    pSorter->bUsePMA = 1;
+    pTask->xCompare = vdbeSorterGetCompare(pSorter);
+    rc = vdbeSorterStartTask(pTask);
   }
 
   return rc;
@@ -769,8 +1284,30 @@ int sqlite3VdbeSorterWrite(
   assert( pSorter );
   pSorter->nInMemory += sqlite3VarintLen(pVal->n) + pVal->n;
 
-  pNew = (SorterRecord *)sqlite3DbMallocRaw(db, pVal->n + sizeof(SorterRecord));
+  /* Keep track of the type of the first field of the records. The
+  ** specialized comparisons are only used if the record header size is a
+  ** single byte varint (as it nearly always is), so that the first serial
+  ** type starts at offset 1 and the first value at offset z[0]. */
+  if( pSorter->typeMask ){
+    u32 t = 0;
+    if( (pVal->z[0] & 0x80)==0 ){
+      getVarint32((const u8*)&pVal->z[1], t);
+    }
+    if( t>0 && t<10 && t!=7 ){
+      pSorter->typeMask &= SORTER_TYPE_INTEGER;
+    }else if( t>=13 && (t & 0x01) ){
+      pSorter->typeMask &= SORTER_TYPE_TEXT;
+    }else{
+      pSorter->typeMask = 0;
+    }
+  }
+
+  /* The record may be freed by a worker thread, see SortSubtask.db */
+  pNew = (SorterRecord *)sqlite3DbMallocRaw(pSorter->aTask[0].db,
+      pVal->n + sizeof(SorterRecord)
+  );
   if( pNew==0 ){
+    db->mallocFailed = 1;
     rc = SQLITE_NOMEM;
   }else{
     pNew->pVal = (void *)&pNew[1];
@@ -793,157 +1330,88 @@ int sqlite3VdbeSorterWrite(
         (pSorter->nInMemory>pSorter->mxPmaSize)
      || (pSorter->nInMemory>pSorter->mnPmaSize && sqlite3HeapNearlyFull())
   )){
-#ifdef SQLITE_DEBUG
-    i64 nExpect = pSorter->iWriteOff
-                + sqlite3VarintLen(pSorter->nInMemory)
-                + pSorter->nInMemory;
-#endif
-    rc = vdbeSorterListToPMA(db, pCsr);
-    pSorter->nInMemory = 0;
-    assert( rc!=SQLITE_OK || (nExpect==pSorter->iWriteOff) );
+    rc = vdbeSorterFlushPMA(db, pCsr);
   }
 
   return rc;
 }
 
-/*
-** Helper function for sqlite3VdbeSorterRewind(). 
-*/
-static int vdbeSorterInitMerge(
-  sqlite3 *db,                    /* Database handle */
-  const VdbeCursor *pCsr,         /* Cursor handle for this sorter */
-  i64 *pnByte                     /* Sum of bytes in all opened PMAs */
-){
-  VdbeSorter *pSorter = pCsr->pSorter;
-  int rc = SQLITE_OK;             /* Return code */
-  int i;                          /* Used to iterator through aIter[] */
-  i64 nByte = 0;                  /* Total bytes in all opened PMAs */
-
-  /* Initialize the iterators. */
-  for(i=0; i<SORTER_MAX_MERGE_COUNT; i++){
-    VdbeSorterIter *pIter = &pSorter->aIter[i];
-    rc = vdbeSorterIterInit(db, pSorter, pSorter->iReadOff, pIter, &nByte);
-    pSorter->iReadOff = pIter->iEof;
-    assert( rc!=SQLITE_OK || pSorter->iReadOff<=pSorter->iWriteOff );
-    if( rc!=SQLITE_OK || pSorter->iReadOff>=pSorter->iWriteOff ) break;
-  }
-
-  /* Initialize the aTree[] array. */
-  for(i=pSorter->nTree-1; rc==SQLITE_OK && i>0; i--){
-    rc = vdbeSorterDoCompare(pCsr, i);
-  }
-
-  *pnByte = nByte;
-  return rc;
-}
-
 /*
 ** Once the sorter has been populated, this function is called to prepare
 ** for iterating through its contents in sorted order.
 */
 int sqlite3VdbeSorterRewind(sqlite3 *db, const VdbeCursor *pCsr, int *pbEof){
   VdbeSorter *pSorter = pCsr->pSorter;
+  SortSubtask *pMain;             /* Sub-task used by the VDBE itself */
+  MergeEngine *pMerger;           /* Final merge of all the PMAs */
   int rc;                         /* Return code */
-  sqlite3_file *pTemp2 = 0;       /* Second temp file to use */
-  i64 iWrite2 = 0;                /* Write offset for pTemp2 */
-  int nIter;                      /* Number of iterators used */
-  int nByte;                      /* Bytes of space required for aIter/aTree */
-  int N = 2;                      /* Power of 2 >= nIter */
+  int nIter = 0;                  /* Number of iterators used */
+  int iIter = 0;                  /* Next iterator to initialize */
+  int i;
 
   assert( pSorter );
+  pMain = &pSorter->aTask[0];
 
   /* If no data has been written to disk, then do not do so now. Instead,
   ** sort the VdbeSorter.pRecord list. The vdbe layer will read data directly
   ** from the in-memory list.  */
-  if( pSorter->nPMA==0 ){
+  if( pSorter->bUsePMA==0 ){
     *pbEof = !pSorter->pRecord;
-    assert( pSorter->aTree==0 );
-    return vdbeSorterSort(pCsr);
+    assert( pSorter->pMerger==0 );
+    pMain->xCompare = vdbeSorterGetCompare(pSorter);
+    return vdbeSorterSort(pMain, &pSorter->pRecord);
   }
 
   /* Write the current in-memory list to a PMA. */
-  rc = vdbeSorterListToPMA(db, pCsr);
-  if( rc!=SQLITE_OK ) return rc;
-
-  /* Allocate space for aIter[] and aTree[]. */
-  nIter = pSorter->nPMA;
-  if( nIter>SORTER_MAX_MERGE_COUNT ) nIter = SORTER_MAX_MERGE_COUNT;
-  assert( nIter>0 );
-  while( N<nIter ) N += N;
-  nByte = N * (sizeof(int) + sizeof(VdbeSorterIter));
-  pSorter->aIter = (VdbeSorterIter *)sqlite3DbMallocZero(db, nByte);
-  if( !pSorter->aIter ) return SQLITE_NOMEM;
-  pSorter->aTree = (int *)&pSorter->aIter[N];
-  pSorter->nTree = N;
-
-  do {
-    int iNew;                     /* Index of new, merged, PMA */
-
-    for(iNew=0; 
-        rc==SQLITE_OK && iNew*SORTER_MAX_MERGE_COUNT<pSorter->nPMA; 
-        iNew++
-    ){
-      int rc2;                    /* Return code from fileWriterFinish() */
-      FileWriter writer;          /* Object used to write to disk */
-      i64 nWrite;                 /* Number of bytes in new PMA */
-
-      memset(&writer, 0, sizeof(FileWriter));
-
-      /* If there are SORTER_MAX_MERGE_COUNT or less PMAs in file pTemp1,
-      ** initialize an iterator for each of them and break out of the loop.
-      ** These iterators will be incrementally merged as the VDBE layer calls
-      ** sqlite3VdbeSorterNext().
-      **
-      ** Otherwise, if pTemp1 contains more than SORTER_MAX_MERGE_COUNT PMAs,
-      ** initialize interators for SORTER_MAX_MERGE_COUNT of them. These PMAs
-      ** are merged into a single PMA that is written to file pTemp2.
-      */
-      rc = vdbeSorterInitMerge(db, pCsr, &nWrite);
-      assert( rc!=SQLITE_OK || pSorter->aIter[ pSorter->aTree[1] ].pFile );
-      if( rc!=SQLITE_OK || pSorter->nPMA<=SORTER_MAX_MERGE_COUNT ){
-        break;
-      }
-
-      /* Open the second temp file, if it is not already open. */
-      if( pTemp2==0 ){
-        assert( iWrite2==0 );
-        rc = vdbeSorterOpenTempFile(db, &pTemp2);
+  rc = vdbeSorterFlushPMA(db, pCsr);
+
+  /* Have each sub-task reduce the number of its PMAs, so that the PMAs of
+  ** all the sub-tasks can be merged in a single pass. */
+  for(i=0; i<pSorter->nTask; i++){
+    SortSubtask *pTask = &pSorter->aTask[i];
+    int rc2 = vdbeSorterJoinTask(pTask);
+    if( rc==SQLITE_OK ) rc = rc2;
+    pTask->xCompare = vdbeSorterGetCompare(pSorter);
+    if( rc==SQLITE_OK && pTask->nPMA>pTask->nTarget ){
+      if( pTask->pTemp2==0 ){
+        rc = vdbeSorterOpenTempFile(db, &pTask->pTemp2);
       }
-
       if( rc==SQLITE_OK ){
-        int bEof = 0;
-        fileWriterInit(db, pTemp2, &writer, iWrite2);
-        fileWriterWriteVarint(&writer, nWrite);
-        while( rc==SQLITE_OK && bEof==0 ){
-          VdbeSorterIter *pIter = &pSorter->aIter[ pSorter->aTree[1] ];
-          assert( pIter->pFile );
-
-          fileWriterWriteVarint(&writer, pIter->nKey);
-          fileWriterWrite(&writer, pIter->aKey, pIter->nKey);
-          rc = sqlite3VdbeSorterNext(db, pCsr, &bEof);
-        }
-        rc2 = fileWriterFinish(db, &writer, &iWrite2);
-        if( rc==SQLITE_OK ) rc = rc2;
+        assert( pTask->pList==0 );
+        rc = vdbeSorterStartTask(pTask);
       }
     }
+  }
+  rc = vdbeSorterJoinAll(pSorter, rc);
+  if( rc!=SQLITE_OK ) return rc;
 
-    if( pSorter->nPMA<=SORTER_MAX_MERGE_COUNT ){
-      break;
-    }else{
-      sqlite3_file *pTmp = pSorter->pTemp1;
-      pSorter->nPMA = iNew;
-      pSorter->pTemp1 = pTemp2;
-      pTemp2 = pTmp;
-      pSorter->iWriteOff = iWrite2;
-      pSorter->iReadOff = 0;
-      iWrite2 = 0;
+  /* Initialize an iterator for each PMA left, and the merge tree */
+  for(i=0; i<pSorter->nTask; i++){
+    nIter += pSorter->aTask[i].nPMA;
+  }
+  assert( nIter>0 );
+  pSorter->pMerger = pMerger = vdbeMergeEngineNew(pMain->db, nIter);
+  if( pMerger==0 ){
+    db->mallocFailed = 1;
+    return SQLITE_NOMEM;
+  }
+  for(i=0; rc==SQLITE_OK && i<pSorter->nTask; i++){
+    SortSubtask *pTask = &pSorter->aTask[i];
+    i64 iReadOff = 0;
+    i64 nByte = 0;
+    while( rc==SQLITE_OK && iReadOff<pTask->iWriteOff ){
+      VdbeSorterIter *pIter = &pMerger->aIter[iIter++];
+      assert( iIter<=nIter );
+      rc = vdbeSorterIterInit(pMain, pTask->pTemp1, iReadOff,
+                              pTask->iWriteOff, pIter, &nByte);
+      iReadOff = pIter->iEof;
     }
-  }while( rc==SQLITE_OK );
-
-  if( pTemp2 ){
-    sqlite3OsCloseFree(pTemp2);
   }
-  *pbEof = (pSorter->aIter[pSorter->aTree[1]].pFile==0);
+  if( rc==SQLITE_OK ){
+    rc = vdbeMergeEngineInit(pMain, pMerger);
+  }
+
+  *pbEof = (pMerger->aIter[pMerger->aTree[1]].pFile==0);
   return rc;
 }
 
@@ -954,21 +1422,13 @@ int sqlite3VdbeSorterNext(sqlite3 *db, const VdbeCursor *pCsr, int *pbEof){
   VdbeSorter *pSorter = pCsr->pSorter;
   int rc;                         /* Return code */
 
-  if( pSorter->aTree ){
-    int iPrev = pSorter->aTree[1];/* Index of iterator to advance */
-    int i;                        /* Index of aTree[] to recalculate */
-
-    rc = vdbeSorterIterNext(db, &pSorter->aIter[iPrev]);
-    for(i=(pSorter->nTree+iPrev)/2; rc==SQLITE_OK && i>0; i=i/2){
-      rc = vdbeSorterDoCompare(pCsr, i);
-    }
-
-    *pbEof = (pSorter->aIter[pSorter->aTree[1]].pFile==0);
+  if( pSorter->pMerger ){
+    rc = vdbeMergeEngineStep(&pSorter->aTask[0], pSorter->pMerger, pbEof);
   }else{
     SorterRecord *pFree = pSorter->pRecord;
     pSorter->pRecord = pFree->pNext;
     pFree->pNext = 0;
-    vdbeSorterRecordFree(db, pFree);
+    vdbeSorterRecordFree(pSorter->aTask[0].db, pFree);
     *pbEof = !pSorter->pRecord;
     rc = SQLITE_OK;
   }
@@ -984,9 +1444,9 @@ static void *vdbeSorterRowkey(
   int *pnKey                      /* OUT: Size of current key in bytes */
 ){
   void *pKey;
-  if( pSorter->aTree ){
+  if( pSorter->pMerger ){
     VdbeSorterIter *pIter;
-    pIter = &pSorter->aIter[ pSorter->aTree[1] ];
+    pIter = &pSorter->pMerger->aIter[ pSorter->pMerger->aTree[1] ];
     *pnKey = pIter->nKey;
     pKey = pIter->aKey;
   }else{
@@ -1034,6 +1494,7 @@ int sqlite3VdbeSorterCompare(
   void *pKey; int nKey;           /* Sorter key to compare pVal with */
 
   pKey = vdbeSorterRowkey(pSorter, &nKey);
-  vdbeSorterCompare(pCsr, nIgnore, pVal->z, pVal->n, pKey, nKey, pRes);
+  vdbeSorterCompare(&pSorter->aTask[0], nIgnore, pVal->z, pVal->n, pKey, nKey,
+                    pRes);
   return SQLITE_OK;
 }
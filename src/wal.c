@@ -239,6 +239,46 @@
 ** When a rollback occurs, the value of K is decreased. Hash table entries
 ** that correspond to frames greater than the new K value are removed
 ** from the hash table at this point.
+**
+** WAL2 MODE
+**
+** In "journal_mode=wal2" mode, which is used by databases with the value
+** 3 in the file format bytes (18 and 19) of the database header, there
+** are two WAL files, "<db>-wal" (file 0) and "<db>-wal2" (file 1). Each
+** has the usual format. Writers append to one of them, the "current"
+** file, while the other is checkpointed. Once the current file has grown
+** past the journal_size_limit (or the wal_autocheckpoint size if there is
+** no limit) and every frame of the other file has been checkpointed, the
+** next writer switches to the other file and starts overwriting it from
+** the beginning. Unlike in the default mode, this does not wait for the
+** readers of the WAL to finish, so the size of the WAL files is bounded
+** even if readers are never absent.
+**
+** The first salt of a WAL file is one greater than the first salt of the
+** file it replaced. This is how recovery knows which of the two files
+** is current, and so in which order the frames of the two files must be
+** replayed.
+**
+** Both files share a single wal-index. The hash tables alternate between
+** the files: the even-numbered ones index the frames of file 0 and the
+** odd-numbered ones those of file 1. The mxFrame field of the wal-index
+** header holds the number of valid frames in file 0. The mxFrame2 field
+** holds that of file 1 in its low 31 bits, and the index of the current
+** file in its most significant bit. The nBackfill field of WalCkptInfo
+** counts the checkpointed frames of the non-current file.
+**
+** The aReadMark[] array is not used. Instead, each of the first four
+** reader locks describes a set of snapshots:
+**
+**   WAL_LOCK_PART1:       File 0 is current and file 1 is ignored,
+**   WAL_LOCK_PART1_FULL2: File 0 is current and file 1 is also read,
+**   WAL_LOCK_PART2:       File 1 is current and file 0 is ignored,
+**   WAL_LOCK_PART2_FULL1: File 1 is current and file 0 is also read.
+**
+** A checkpointer of file N takes an exclusive lock on the two locks
+** for which N is current, and a writer may only switch from file N to
+** file M while it can take an exclusive lock on both locks for which M
+** is current and on the lock that reads file M from file N.
 */
 #ifndef SQLITE_OMIT_WAL
 
@@ -281,6 +321,18 @@ int sqlite3WalTrace = 0;
 #define WAL_READ_LOCK(I)       (3+(I))
 #define WAL_NREADER            (SQLITE_SHM_NLOCK-3)
 
+/*
+** Reader locks used in wal2 mode (see "WAL2 MODE" above). The lock used
+** by a reader of a snapshot in which file iWal is current is returned
+** by walReadLockIdx(iWal, bFull), where bFull is true if the snapshot
+** also includes the other file.
+*/
+#define WAL_LOCK_PART1         1
+#define WAL_LOCK_PART1_FULL2   2
+#define WAL_LOCK_PART2         3
+#define WAL_LOCK_PART2_FULL1   4
+#define walReadLockIdx(iWal, bFull) (1 + 2*(iWal) + (bFull))
+
 
 /* Object declarations */
 typedef struct WalIndexHdr WalIndexHdr;
@@ -300,7 +352,7 @@ typedef struct WalCkptInfo WalCkptInfo;
 */
 struct WalIndexHdr {
   u32 iVersion;                   /* Wal-index version */
-  u32 unused;                     /* Unused (padding) field */
+  u32 mxFrame2;                   /* wal2 only: see walidxGetMxFrame() */
   u32 iChange;                    /* Counter incremented each transaction */
   u8 isInit;                      /* 1 when initialized */
   u8 bigEndCksum;                 /* True if checksums in WAL are big-endian */
@@ -411,7 +463,7 @@ struct WalCkptInfo {
 struct Wal {
   sqlite3_vfs *pVfs;         /* The VFS used to create pDbFd */
   sqlite3_file *pDbFd;       /* File handle for the database file */
-  sqlite3_file *pWalFd;      /* File handle for WAL file */
+  sqlite3_file *apWalFd[2];  /* File handles for WAL files (one unless wal2) */
   u32 iCallback;             /* Value to pass to log callback (or 0) */
   i64 mxWalSize;             /* Truncate WAL to this size upon reset */
   int nWiData;               /* Size of array apWiData */
@@ -427,9 +479,14 @@ struct Wal {
   u8 truncateOnCommit;       /* True to truncate WAL file on commit */
   u8 syncHeader;             /* Fsync the WAL header if true */
   u8 padToSectorBoundary;    /* Pad transactions out to the next sector */
+  u8 bWal2;                  /* True in wal2 mode */
   WalIndexHdr hdr;           /* Wal-index header for current transaction */
-  const char *zWalName;      /* Name of WAL file */
+  const char *azWalName[2];  /* Names of WAL files (one unless wal2) */
   u32 nCkpt;                 /* Checkpoint sequence counter in the wal-header */
+  WalGroup *pGroup;          /* Group commit, or NULL */
+  int nGroupDelay;           /* Group commit batching delay in microseconds */
+  u64 iGroupTicket;          /* Commit left to pGroup to sync, or 0 */
+  u8 groupSyncFlags;         /* Flags to sync commit iGroupTicket with */
 #ifdef SQLITE_DEBUG
   u8 lockError;              /* True if a locking error has occurred */
 #endif
@@ -894,16 +951,100 @@ static u32 walFramePgno(Wal *pWal, u32 iFrame){
   return pWal->apWiData[iHash][(iFrame-1-HASHTABLE_NPAGE_ONE)%HASHTABLE_NPAGE];
 }
 
+/*
+** Return one less than the number of the first frame indexed by the
+** iHash'th hash table of a wal-index.
+*/
+static u32 walHashZero(int iHash){
+  return iHash==0 ? 0 : HASHTABLE_NPAGE_ONE + (iHash-1)*HASHTABLE_NPAGE;
+}
+
+/*
+** Return true if the WAL uses two alternating files (journal_mode=wal2).
+*/
+#define isWalMode2(pWal) ((pWal)->bWal2)
+
+/*
+** Return the number of valid frames in WAL file iWal according to
+** wal-index header pHdr. This is always the mxFrame field of the header
+** unless the WAL is in wal2 mode.
+*/
+static u32 walidxGetMxFrame(volatile WalIndexHdr *pHdr, int iWal){
+  assert( iWal==0 || iWal==1 );
+  return iWal ? (pHdr->mxFrame2 & 0x7FFFFFFF) : pHdr->mxFrame;
+}
+static void walidxSetMxFrame(WalIndexHdr *pHdr, int iWal, u32 mxFrame){
+  assert( iWal==0 || iWal==1 );
+  assert( mxFrame<=0x7FFFFFFF );
+  if( iWal ){
+    pHdr->mxFrame2 = (pHdr->mxFrame2 & 0x80000000) | mxFrame;
+  }else{
+    pHdr->mxFrame = mxFrame;
+  }
+}
+
+/*
+** Return the index of the current WAL file (the one written to) according
+** to wal-index header pHdr. This is always 0 unless the WAL is in wal2
+** mode.
+*/
+static int walidxGetFile(volatile WalIndexHdr *pHdr){
+  return (int)(pHdr->mxFrame2 >> 31);
+}
+static void walidxSetFile(WalIndexHdr *pHdr, int iWal){
+  assert( iWal==0 || iWal==1 );
+  pHdr->mxFrame2 = (pHdr->mxFrame2 & 0x7FFFFFFF) | ((u32)iWal << 31);
+}
+
+/*
+** Return the number of frames in the WAL file or files according to
+** wal-index header pHdr.
+*/
+static u32 walidxTotalFrames(volatile WalIndexHdr *pHdr){
+  return walidxGetMxFrame(pHdr, 0) + walidxGetMxFrame(pHdr, 1);
+}
+
+/*
+** Return the number by which frame iFrame of WAL file iWal is known in
+** the wal-index. In wal2 mode the frames of file iWal are indexed by the
+** hash tables 2*N+iWal (see "WAL2 MODE" above). Otherwise, iWal must
+** be 0 and iFrame is returned unchanged.
+*/
+static u32 walIndexFrame(Wal *pWal, int iWal, u32 iFrame){
+  int iHash;
+  if( isWalMode2(pWal)==0 ){
+    assert( iWal==0 );
+    return iFrame;
+  }
+  iHash = walFramePage(iFrame);
+  return walHashZero(2*iHash+iWal) + (iFrame - walHashZero(iHash));
+}
+
+/*
+** The reverse of walIndexFrame(). Return the frame number in its WAL file
+** of wal-index frame iIdx, and set *piWal to the index of that file.
+*/
+static u32 walIndexFrameDecode(Wal *pWal, u32 iIdx, int *piWal){
+  int iHash;
+  if( isWalMode2(pWal)==0 ){
+    *piWal = 0;
+    return iIdx;
+  }
+  iHash = walFramePage(iIdx);
+  *piWal = (iHash & 1);
+  return walHashZero(iHash/2) + (iIdx - walHashZero(iHash));
+}
+
 /*
 ** Remove entries from the hash table that point to WAL slots greater
-** than pWal->hdr.mxFrame.
+** than the mxFrame of the current WAL file in pWal->hdr.
 **
-** This function is called whenever pWal->hdr.mxFrame is decreased due
+** This function is called whenever that value is decreased due
 ** to a rollback or savepoint.
 **
-** At most only the hash table containing pWal->hdr.mxFrame needs to be
+** At most only the hash table containing the last frame needs to be
 ** updated.  Any later hash tables will be automatically cleared when
-** pWal->hdr.mxFrame advances to the point where those hash tables are
+** the mxFrame value advances to the point where those hash tables are
 ** actually needed.
 */
 static void walCleanupHash(Wal *pWal){
@@ -913,26 +1054,29 @@ static void walCleanupHash(Wal *pWal){
   int iLimit = 0;                 /* Zero values greater than this */
   int nByte;                      /* Number of bytes to zero in aPgno[] */
   int i;                          /* Used to iterate through aHash[] */
+  int iWal = walidxGetFile(&pWal->hdr);
+  u32 mxFrame = walidxGetMxFrame(&pWal->hdr, iWal);
 
   assert( pWal->writeLock );
-  testcase( pWal->hdr.mxFrame==HASHTABLE_NPAGE_ONE-1 );
-  testcase( pWal->hdr.mxFrame==HASHTABLE_NPAGE_ONE );
-  testcase( pWal->hdr.mxFrame==HASHTABLE_NPAGE_ONE+1 );
+  testcase( mxFrame==HASHTABLE_NPAGE_ONE-1 );
+  testcase( mxFrame==HASHTABLE_NPAGE_ONE );
+  testcase( mxFrame==HASHTABLE_NPAGE_ONE+1 );
 
-  if( pWal->hdr.mxFrame==0 ) return;
+  if( mxFrame==0 ) return;
+  mxFrame = walIndexFrame(pWal, iWal, mxFrame);
 
   /* Obtain pointers to the hash-table and page-number array containing 
-  ** the entry that corresponds to frame pWal->hdr.mxFrame. It is guaranteed
+  ** the entry that corresponds to frame mxFrame. It is guaranteed
   ** that the page said hash-table and array reside on is already mapped.
   */
-  assert( pWal->nWiData>walFramePage(pWal->hdr.mxFrame) );
-  assert( pWal->apWiData[walFramePage(pWal->hdr.mxFrame)] );
-  walHashGet(pWal, walFramePage(pWal->hdr.mxFrame), &aHash, &aPgno, &iZero);
+  assert( pWal->nWiData>walFramePage(mxFrame) );
+  assert( pWal->apWiData[walFramePage(mxFrame)] );
+  walHashGet(pWal, walFramePage(mxFrame), &aHash, &aPgno, &iZero);
 
   /* Zero all hash-table entries that correspond to frame numbers greater
-  ** than pWal->hdr.mxFrame.
+  ** than mxFrame.
   */
-  iLimit = pWal->hdr.mxFrame - iZero;
+  iLimit = mxFrame - iZero;
   assert( iLimit>0 );
   for(i=0; i<HASHTABLE_NSLOT; i++){
     if( aHash[i]>iLimit ){
@@ -941,7 +1085,7 @@ static void walCleanupHash(Wal *pWal){
   }
   
   /* Zero the entries in the aPgno array that correspond to frames with
-  ** frame numbers greater than pWal->hdr.mxFrame. 
+  ** frame numbers greater than mxFrame. 
   */
   nByte = (int)((char *)aHash - (char *)&aPgno[iLimit+1]);
   memset((void *)&aPgno[iLimit+1], 0, nByte);
@@ -966,14 +1110,15 @@ static void walCleanupHash(Wal *pWal){
 
 /*
 ** Set an entry in the wal-index that will map database page number
-** pPage into WAL frame iFrame.
+** pPage into frame iFrame of WAL file iWal.
 */
-static int walIndexAppend(Wal *pWal, u32 iFrame, u32 iPage){
+static int walIndexAppend(Wal *pWal, int iWal, u32 iFrame, u32 iPage){
   int rc;                         /* Return code */
   u32 iZero = 0;                  /* One less than frame number of aPgno[1] */
   volatile u32 *aPgno = 0;        /* Page number array */
   volatile ht_slot *aHash = 0;    /* Hash table */
 
+  iFrame = walIndexFrame(pWal, iWal, iFrame);
   rc = walHashGet(pWal, walFramePage(iFrame), &aHash, &aPgno, &iZero);
 
   /* Assuming the wal-index file was successfully mapped, populate the
@@ -1047,6 +1192,141 @@ static int walIndexAppend(Wal *pWal, u32 iFrame, u32 iPage){
 }
 
 
+/*
+** Read the header of WAL file iWal into buffer aBuf[]. Set *pbValid to
+** true if the file contains a valid header followed by at least some
+** frame data, or to false otherwise. If the header is valid but its
+** version number is not one that this library understands, return
+** SQLITE_CANTOPEN.
+*/
+static int walReadHeader(
+  Wal *pWal,                      /* WAL handle */
+  int iWal,                       /* WAL file to read (always 0 unless wal2) */
+  u8 *aBuf,                       /* OUT: Buffer of WAL_HDRSIZE bytes */
+  i64 *pnSize,                    /* OUT: Size of the WAL file */
+  int *pbValid                    /* OUT: True if the header is valid */
+){
+  int rc;                         /* Return Code */
+  u32 magic;                      /* Magic value read from WAL header */
+  int szPage;                     /* Page size according to the log */
+  u32 aCksum[2];                  /* Checksum of the WAL header */
+
+  *pbValid = 0;
+  rc = sqlite3OsFileSize(pWal->apWalFd[iWal], pnSize);
+  if( rc!=SQLITE_OK || *pnSize<=WAL_HDRSIZE ) return rc;
+
+  /* Read in the WAL header. */
+  rc = sqlite3OsRead(pWal->apWalFd[iWal], aBuf, WAL_HDRSIZE, 0);
+  if( rc!=SQLITE_OK ) return rc;
+
+  /* If the database page size is not a power of two, or is greater than
+  ** SQLITE_MAX_PAGE_SIZE, conclude that the WAL file contains no valid 
+  ** data. Similarly, if the 'magic' value is invalid, ignore the whole
+  ** WAL file.
+  */
+  magic = sqlite3Get4byte(&aBuf[0]);
+  szPage = sqlite3Get4byte(&aBuf[8]);
+  if( (magic&0xFFFFFFFE)!=WAL_MAGIC 
+   || szPage&(szPage-1) 
+   || szPage>SQLITE_MAX_PAGE_SIZE 
+   || szPage<512 
+  ){
+    return SQLITE_OK;
+  }
+
+  /* Verify that the WAL header checksum is correct */
+  walChecksumBytes((magic&0x00000001)==SQLITE_BIGENDIAN, 
+      aBuf, WAL_HDRSIZE-2*4, 0, aCksum
+  );
+  if( aCksum[0]!=sqlite3Get4byte(&aBuf[24])
+   || aCksum[1]!=sqlite3Get4byte(&aBuf[28])
+  ){
+    return SQLITE_OK;
+  }
+
+  /* Verify that the version number on the WAL format is one that
+  ** are able to understand */
+  if( sqlite3Get4byte(&aBuf[4])!=WAL_MAX_VERSION ){
+    return SQLITE_CANTOPEN_BKPT;
+  }
+
+  *pbValid = 1;
+  return SQLITE_OK;
+}
+
+/*
+** Add the frames of WAL file iWal, the valid header of which has been
+** read into aBuf[] by walReadHeader(), to the wal-index. Leave the
+** salts and checksums of the file in pWal->hdr, and update the size of
+** the file and of the database in pWal->hdr for each commit frame found.
+*/
+static int walRecoverFile(
+  Wal *pWal,                      /* WAL handle */
+  int iWal,                       /* WAL file to read (always 0 unless wal2) */
+  u8 *aBuf,                       /* Header of WAL file iWal */
+  i64 nSize                       /* Size of WAL file iWal */
+){
+  int rc = SQLITE_OK;             /* Return Code */
+  u32 aFrameCksum[2] = {0, 0};
+  u8 *aFrame = 0;                 /* Malloc'd buffer to load entire frame */
+  int szFrame;                    /* Number of bytes in buffer aFrame[] */
+  u8 *aData;                      /* Pointer to data part of aFrame buffer */
+  int iFrame;                     /* Index of last frame read */
+  i64 iOffset;                    /* Next offset to read from log file */
+  int szPage;                     /* Page size according to the log */
+  int isValid;                    /* True if this frame is valid */
+
+  szPage = sqlite3Get4byte(&aBuf[8]);
+  pWal->hdr.bigEndCksum = (u8)(sqlite3Get4byte(&aBuf[0])&0x00000001);
+  pWal->szPage = szPage;
+  pWal->nCkpt = sqlite3Get4byte(&aBuf[12]);
+  memcpy(&pWal->hdr.aSalt, &aBuf[16], 8);
+  walChecksumBytes(pWal->hdr.bigEndCksum==SQLITE_BIGENDIAN, 
+      aBuf, WAL_HDRSIZE-2*4, 0, pWal->hdr.aFrameCksum
+  );
+  walidxSetFile(&pWal->hdr, iWal);
+
+  /* Malloc a buffer to read frames into. */
+  szFrame = szPage + WAL_FRAME_HDRSIZE;
+  aFrame = (u8 *)sqlite3_malloc(szFrame);
+  if( !aFrame ){
+    return SQLITE_NOMEM;
+  }
+  aData = &aFrame[WAL_FRAME_HDRSIZE];
+
+  /* Read all frames from the log file. */
+  iFrame = 0;
+  for(iOffset=WAL_HDRSIZE; (iOffset+szFrame)<=nSize; iOffset+=szFrame){
+    u32 pgno;                     /* Database page number for frame */
+    u32 nTruncate;                /* dbsize field from frame header */
+
+    /* Read and decode the next log frame. */
+    iFrame++;
+    rc = sqlite3OsRead(pWal->apWalFd[iWal], aFrame, szFrame, iOffset);
+    if( rc!=SQLITE_OK ) break;
+    isValid = walDecodeFrame(pWal, &pgno, &nTruncate, aData, aFrame);
+    if( !isValid ) break;
+    rc = walIndexAppend(pWal, iWal, iFrame, pgno);
+    if( rc!=SQLITE_OK ) break;
+
+    /* If nTruncate is non-zero, this is a commit record. */
+    if( nTruncate ){
+      walidxSetMxFrame(&pWal->hdr, iWal, iFrame);
+      pWal->hdr.nPage = nTruncate;
+      pWal->hdr.szPage = (u16)((szPage&0xff00) | (szPage>>16));
+      testcase( szPage<=32768 );
+      testcase( szPage>=65536 );
+      aFrameCksum[0] = pWal->hdr.aFrameCksum[0];
+      aFrameCksum[1] = pWal->hdr.aFrameCksum[1];
+    }
+  }
+  pWal->hdr.aFrameCksum[0] = aFrameCksum[0];
+  pWal->hdr.aFrameCksum[1] = aFrameCksum[1];
+
+  sqlite3_free(aFrame);
+  return rc;
+}
+
 /*
 ** Recover the wal-index by reading the write-ahead log file. 
 **
@@ -1056,13 +1336,21 @@ static int walIndexAppend(Wal *pWal, u32 iFrame, u32 iPage){
 ** WAL_RECOVER_LOCK is also held so that other threads will know
 ** that this thread is running recovery.  If unable to establish
 ** the necessary locks, this routine returns SQLITE_BUSY.
+**
+** In wal2 mode, the frames of the non-current WAL file are read before
+** those of the current one. The current file is the one with the first
+** salt one greater than that of the other file. If the salts of the two
+** files are not related in this way, the content of file 1 is ignored.
 */
 static int walIndexRecover(Wal *pWal){
   int rc;                         /* Return Code */
-  i64 nSize;                      /* Size of log file */
-  u32 aFrameCksum[2] = {0, 0};
   int iLock;                      /* Lock offset to lock for checkpoint */
   int nLock;                      /* Number of locks to hold */
+  u8 aBuf[2][WAL_HDRSIZE];        /* Headers of the WAL files */
+  i64 aSize[2] = {0, 0};          /* Sizes of the WAL files */
+  int aValid[2] = {0, 0};         /* True for files with valid headers */
+  int iCur = 0;                   /* Index of the current WAL file */
+  int i;
 
   /* Obtain an exclusive lock on all byte in the locking range not already
   ** locked by the caller. The caller is guaranteed to have locked the
@@ -1084,111 +1372,37 @@ static int walIndexRecover(Wal *pWal){
 
   memset(&pWal->hdr, 0, sizeof(WalIndexHdr));
 
-  rc = sqlite3OsFileSize(pWal->pWalFd, &nSize);
+  for(i=0; rc==SQLITE_OK && i<1+isWalMode2(pWal); i++){
+    rc = walReadHeader(pWal, i, aBuf[i], &aSize[i], &aValid[i]);
+  }
   if( rc!=SQLITE_OK ){
     goto recovery_error;
   }
 
-  if( nSize>WAL_HDRSIZE ){
-    u8 aBuf[WAL_HDRSIZE];         /* Buffer to load WAL header into */
-    u8 *aFrame = 0;               /* Malloc'd buffer to load entire frame */
-    int szFrame;                  /* Number of bytes in buffer aFrame[] */
-    u8 *aData;                    /* Pointer to data part of aFrame buffer */
-    int iFrame;                   /* Index of last frame read */
-    i64 iOffset;                  /* Next offset to read from log file */
-    int szPage;                   /* Page size according to the log */
-    u32 magic;                    /* Magic value read from WAL header */
-    u32 version;                  /* Magic value read from WAL header */
-    int isValid;                  /* True if this frame is valid */
-
-    /* Read in the WAL header. */
-    rc = sqlite3OsRead(pWal->pWalFd, aBuf, WAL_HDRSIZE, 0);
-    if( rc!=SQLITE_OK ){
-      goto recovery_error;
-    }
-
-    /* If the database page size is not a power of two, or is greater than
-    ** SQLITE_MAX_PAGE_SIZE, conclude that the WAL file contains no valid 
-    ** data. Similarly, if the 'magic' value is invalid, ignore the whole
-    ** WAL file.
-    */
-    magic = sqlite3Get4byte(&aBuf[0]);
-    szPage = sqlite3Get4byte(&aBuf[8]);
-    if( (magic&0xFFFFFFFE)!=WAL_MAGIC 
-     || szPage&(szPage-1) 
-     || szPage>SQLITE_MAX_PAGE_SIZE 
-     || szPage<512 
-    ){
-      goto finished;
-    }
-    pWal->hdr.bigEndCksum = (u8)(magic&0x00000001);
-    pWal->szPage = szPage;
-    pWal->nCkpt = sqlite3Get4byte(&aBuf[12]);
-    memcpy(&pWal->hdr.aSalt, &aBuf[16], 8);
-
-    /* Verify that the WAL header checksum is correct */
-    walChecksumBytes(pWal->hdr.bigEndCksum==SQLITE_BIGENDIAN, 
-        aBuf, WAL_HDRSIZE-2*4, 0, pWal->hdr.aFrameCksum
-    );
-    if( pWal->hdr.aFrameCksum[0]!=sqlite3Get4byte(&aBuf[24])
-     || pWal->hdr.aFrameCksum[1]!=sqlite3Get4byte(&aBuf[28])
-    ){
-      goto finished;
-    }
-
-    /* Verify that the version number on the WAL format is one that
-    ** are able to understand */
-    version = sqlite3Get4byte(&aBuf[4]);
-    if( version!=WAL_MAX_VERSION ){
-      rc = SQLITE_CANTOPEN_BKPT;
-      goto finished;
+  if( aValid[0] && aValid[1] ){
+    u32 iSalt0 = sqlite3Get4byte(&aBuf[0][16]);
+    u32 iSalt1 = sqlite3Get4byte(&aBuf[1][16]);
+    if( memcmp(&aBuf[0][8], &aBuf[1][8], 4) ){
+      aValid[1] = 0;
+    }else if( iSalt1==iSalt0+1 ){
+      iCur = 1;
+    }else if( iSalt0!=iSalt1+1 ){
+      aValid[1] = 0;
     }
+  }else if( aValid[1] ){
+    iCur = 1;
+  }
 
-    /* Malloc a buffer to read frames into. */
-    szFrame = szPage + WAL_FRAME_HDRSIZE;
-    aFrame = (u8 *)sqlite3_malloc(szFrame);
-    if( !aFrame ){
-      rc = SQLITE_NOMEM;
-      goto recovery_error;
+  for(i=0; rc==SQLITE_OK && i<2; i++){
+    int iWal = (i==0 ? !iCur : iCur);
+    if( aValid[iWal] ){
+      rc = walRecoverFile(pWal, iWal, aBuf[iWal], aSize[iWal]);
     }
-    aData = &aFrame[WAL_FRAME_HDRSIZE];
-
-    /* Read all frames from the log file. */
-    iFrame = 0;
-    for(iOffset=WAL_HDRSIZE; (iOffset+szFrame)<=nSize; iOffset+=szFrame){
-      u32 pgno;                   /* Database page number for frame */
-      u32 nTruncate;              /* dbsize field from frame header */
-
-      /* Read and decode the next log frame. */
-      iFrame++;
-      rc = sqlite3OsRead(pWal->pWalFd, aFrame, szFrame, iOffset);
-      if( rc!=SQLITE_OK ) break;
-      isValid = walDecodeFrame(pWal, &pgno, &nTruncate, aData, aFrame);
-      if( !isValid ) break;
-      rc = walIndexAppend(pWal, iFrame, pgno);
-      if( rc!=SQLITE_OK ) break;
-
-      /* If nTruncate is non-zero, this is a commit record. */
-      if( nTruncate ){
-        pWal->hdr.mxFrame = iFrame;
-        pWal->hdr.nPage = nTruncate;
-        pWal->hdr.szPage = (u16)((szPage&0xff00) | (szPage>>16));
-        testcase( szPage<=32768 );
-        testcase( szPage>=65536 );
-        aFrameCksum[0] = pWal->hdr.aFrameCksum[0];
-        aFrameCksum[1] = pWal->hdr.aFrameCksum[1];
-      }
-    }
-
-    sqlite3_free(aFrame);
   }
+  walidxSetFile(&pWal->hdr, iCur);
 
-finished:
   if( rc==SQLITE_OK ){
     volatile WalCkptInfo *pInfo;
-    int i;
-    pWal->hdr.aFrameCksum[0] = aFrameCksum[0];
-    pWal->hdr.aFrameCksum[1] = aFrameCksum[1];
     walIndexWriteHdr(pWal);
 
     /* Reset the checkpoint-header. This is safe because this thread is 
@@ -1199,7 +1413,9 @@ finished:
     pInfo->nBackfill = 0;
     pInfo->aReadMark[0] = 0;
     for(i=1; i<WAL_NREADER; i++) pInfo->aReadMark[i] = READMARK_NOT_USED;
-    if( pWal->hdr.mxFrame ) pInfo->aReadMark[1] = pWal->hdr.mxFrame;
+    if( pWal->hdr.mxFrame && !isWalMode2(pWal) ){
+      pInfo->aReadMark[1] = pWal->hdr.mxFrame;
+    }
 
     /* If more than one frame was recovered from the log file, report an
     ** event via sqlite3_log(). This is to help with identifying performance
@@ -1209,7 +1425,7 @@ finished:
     if( pWal->hdr.nPage ){
       sqlite3_log(SQLITE_NOTICE_RECOVER_WAL,
           "recovered %d frames from WAL file %s",
-          pWal->hdr.mxFrame, pWal->zWalName
+          walidxTotalFrames(&pWal->hdr), pWal->azWalName[0]
       );
     }
   }
@@ -1240,6 +1456,9 @@ static void walIndexClose(Wal *pWal, int isDelete){
 ** already be opened on connection pDbFd. The buffer that zWalName points
 ** to must remain valid for the lifetime of the returned Wal* handle.
 **
+** If bWal2 is true, the WAL is opened in wal2 mode and the second WAL
+** file, named zWalName with "2" appended, is opened as well.
+**
 ** A SHARED lock should be held on the database file when this function
 ** is called. The purpose of this SHARED lock is to prevent any other
 ** client from unlinking the WAL or wal-index file. If another process
@@ -1255,12 +1474,16 @@ int sqlite3WalOpen(
   sqlite3_file *pDbFd,            /* The open database file */
   const char *zWalName,           /* Name of the WAL file */
   int bNoShm,                     /* True to run in heap-memory mode */
+  int bWal2,                      /* True to open in wal2 mode */
   i64 mxWalSize,                  /* Truncate WAL to this size on reset */
   Wal **ppWal                     /* OUT: Allocated Wal handle */
 ){
   int rc;                         /* Return Code */
   Wal *pRet;                      /* Object to allocate and return */
   int flags;                      /* Flags passed to OsOpen() */
+  int szFile = ROUND8(pVfs->szOsFile);
+  int nWalName = sqlite3Strlen30(zWalName);
+  int i;
 
   assert( zWalName && zWalName[0] );
   assert( pDbFd );
@@ -1277,33 +1500,50 @@ int sqlite3WalOpen(
 #endif
 
 
-  /* Allocate an instance of struct Wal to return. */
+  /* Allocate an instance of struct Wal to return. In wal2 mode, the
+  ** file handle and the name of the second WAL file follow it. */
   *ppWal = 0;
-  pRet = (Wal*)sqlite3MallocZero(sizeof(Wal) + pVfs->szOsFile);
+  pRet = (Wal*)sqlite3MallocZero(
+      sizeof(Wal) + szFile + (bWal2 ? szFile + nWalName + 2 : 0)
+  );
   if( !pRet ){
     return SQLITE_NOMEM;
   }
 
   pRet->pVfs = pVfs;
-  pRet->pWalFd = (sqlite3_file *)&pRet[1];
+  pRet->apWalFd[0] = (sqlite3_file *)&pRet[1];
   pRet->pDbFd = pDbFd;
   pRet->readLock = -1;
   pRet->mxWalSize = mxWalSize;
-  pRet->zWalName = zWalName;
+  pRet->azWalName[0] = zWalName;
   pRet->syncHeader = 1;
   pRet->padToSectorBoundary = 1;
   pRet->exclusiveMode = (bNoShm ? WAL_HEAPMEMORY_MODE: WAL_NORMAL_MODE);
-
-  /* Open file handle on the write-ahead log file. */
-  flags = (SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE|SQLITE_OPEN_WAL);
-  rc = sqlite3OsOpen(pVfs, zWalName, pRet->pWalFd, flags, &flags);
-  if( rc==SQLITE_OK && flags&SQLITE_OPEN_READONLY ){
-    pRet->readOnly = WAL_RDONLY;
+  if( bWal2 ){
+    char *zWalName2 = &((char*)pRet->apWalFd[0])[2*szFile];
+    memcpy(zWalName2, zWalName, nWalName);
+    memcpy(&zWalName2[nWalName], "2", 2);
+    pRet->apWalFd[1] = (sqlite3_file *)&((char*)pRet->apWalFd[0])[szFile];
+    pRet->azWalName[1] = zWalName2;
+    pRet->bWal2 = 1;
+  }
+
+  /* Open file handles on the write-ahead log files. */
+  rc = SQLITE_OK;
+  for(i=0; rc==SQLITE_OK && i<1+bWal2; i++){
+    flags = (SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE|SQLITE_OPEN_WAL);
+    rc = sqlite3OsOpen(pVfs, pRet->azWalName[i], pRet->apWalFd[i],
+        flags, &flags
+    );
+    if( rc==SQLITE_OK && flags&SQLITE_OPEN_READONLY ){
+      pRet->readOnly = WAL_RDONLY;
+    }
   }
 
   if( rc!=SQLITE_OK ){
     walIndexClose(pRet, 0);
-    sqlite3OsClose(pRet->pWalFd);
+    sqlite3OsClose(pRet->apWalFd[0]);
+    if( bWal2 ) sqlite3OsClose(pRet->apWalFd[1]);
     sqlite3_free(pRet);
   }else{
     int iDC = sqlite3OsDeviceCharacteristics(pDbFd);
@@ -1519,10 +1759,14 @@ static void walIteratorFree(WalIterator *p){
 ** The calling routine should invoke walIteratorFree() to destroy the
 ** WalIterator object when it has finished with it.
 */
-static int walIteratorInit(Wal *pWal, WalIterator **pp){
+static int walIteratorInit(
+  Wal *pWal,                      /* WAL handle */
+  int iWal,                       /* WAL file to iterate (0 unless wal2) */
+  u32 iLast,                      /* Last frame of file iWal to visit */
+  WalIterator **pp                /* OUT: New iterator */
+){
   WalIterator *p;                 /* Return value */
   int nSegment;                   /* Number of segments to merge */
-  u32 iLast;                      /* Last frame in log */
   int nByte;                      /* Number of bytes to allocate */
   int i;                          /* Iterator variable */
   ht_slot *aTmp;                  /* Temp space used by merge-sort */
@@ -1531,8 +1775,7 @@ static int walIteratorInit(Wal *pWal, WalIterator **pp){
   /* This routine only runs while holding the checkpoint lock. And
   ** it only runs if there is actually content in the log (mxFrame>0).
   */
-  assert( pWal->ckptLock && pWal->hdr.mxFrame>0 );
-  iLast = pWal->hdr.mxFrame;
+  assert( pWal->ckptLock && iLast>0 );
 
   /* Allocate space for the WalIterator object. */
   nSegment = walFramePage(iLast) + 1;
@@ -1561,17 +1804,24 @@ static int walIteratorInit(Wal *pWal, WalIterator **pp){
     u32 iZero;
     volatile u32 *aPgno;
 
-    rc = walHashGet(pWal, i, &aHash, &aPgno, &iZero);
+    /* The frame numbers returned by the iterator are those of file iWal,
+    ** not the wal-index frame numbers (which are different in wal2 mode). 
+    ** So iZero is the number of frames of file iWal indexed by the
+    ** hash tables preceding this one.  */
+    rc = walHashGet(pWal, isWalMode2(pWal) ? 2*i+iWal : i,
+        &aHash, &aPgno, &iZero
+    );
     if( rc==SQLITE_OK ){
       int j;                      /* Counter variable */
       int nEntry;                 /* Number of entries in this segment */
       ht_slot *aIndex;            /* Sorted index for this segment */
 
       aPgno++;
+      iZero = walHashZero(i);
       if( (i+1)==nSegment ){
         nEntry = (int)(iLast - iZero);
       }else{
-        nEntry = (int)((u32*)aHash - (u32*)aPgno);
+        nEntry = (int)(walHashZero(i+1) - iZero);
       }
       aIndex = &((ht_slot *)&p->aSegment[p->nSegment])[iZero];
       iZero++;
@@ -1623,6 +1873,119 @@ static int walPagesize(Wal *pWal){
   return (pWal->hdr.szPage&0xfe00) + ((pWal->hdr.szPage&0x0001)<<16);
 }
 
+/*
+** This is the wal2 version of walCheckpoint(). Copy the content of WAL
+** file iWal back into the database file.
+**
+** Usually iWal is the non-current file, the frames of which are counted
+** by the nBackfill field of the wal-index. Its content is only copied
+** while no reader is using it, which is the case once no reader holds a
+** lock for a snapshot in which iWal is current. The checkpoint holds
+** these two locks exclusively while it runs, which also prevents writers
+** from switching to file iWal.
+**
+** sqlite3WalClose() also uses this function to checkpoint the current
+** file, once the non-current file has been checkpointed.
+**
+** Readers only ever wait for a single checkpoint of one file, so unlike
+** walCheckpoint() there is nothing further to wait for in RESTART mode.
+*/
+static int walCheckpoint2(
+  Wal *pWal,                      /* Wal connection */
+  int iWal,                       /* WAL file to checkpoint */
+  int eMode,                      /* One of PASSIVE, FULL or RESTART */
+  int (*xBusyCall)(void*),        /* Function to call when busy */
+  void *pBusyArg,                 /* Context argument for xBusyHandler */
+  int sync_flags,                 /* Flags for OsSync() (or 0) */
+  u8 *zBuf                        /* Temporary buffer to use */
+){
+  int rc;                         /* Return code */
+  int szPage = walPagesize(pWal); /* Database page-size */
+  WalIterator *pIter = 0;         /* Wal iterator context */
+  u32 iDbpage = 0;                /* Next database page to write */
+  u32 iFrame = 0;                 /* Wal frame containing data for iDbpage */
+  u32 mxPage = pWal->hdr.nPage;   /* Max database page to write */
+  int iCur = walidxGetFile(&pWal->hdr);
+  u32 mxFrame = walidxGetMxFrame(&pWal->hdr, iWal);
+  int iLock = WAL_READ_LOCK(walReadLockIdx(iWal, 0));
+  volatile WalCkptInfo *pInfo = walCkptInfo(pWal);
+  int (*xBusy)(void*) = 0;        /* Function to call when waiting for locks */
+
+  assert( isWalMode2(pWal) );
+  if( iWal!=iCur && pInfo->nBackfill>=mxFrame ) return SQLITE_OK;
+  if( eMode!=SQLITE_CHECKPOINT_PASSIVE ) xBusy = xBusyCall;
+
+  rc = walBusyLock(pWal, xBusy, pBusyArg, iLock, 2);
+  if( rc==SQLITE_OK ){
+    u32 nBackfill = (iWal==iCur ? 0 : pInfo->nBackfill);
+
+    /* If a writer has switched files since the snapshot in pWal->hdr
+    ** was read, file iWal is now current and may not be checkpointed.  */
+    walShmBarrier(pWal);
+    if( walidxGetFile(walIndexHdr(pWal))!=iCur || nBackfill>=mxFrame ){
+      walUnlockExclusive(pWal, iLock, 2);
+      return (eMode==SQLITE_CHECKPOINT_PASSIVE ? SQLITE_OK : SQLITE_BUSY);
+    }
+
+    rc = walIteratorInit(pWal, iWal, mxFrame, &pIter);
+    if( rc!=SQLITE_OK ){
+      pIter = 0;
+    }else if( sync_flags ){
+      rc = sqlite3OsSync(pWal->apWalFd[iWal], sync_flags);
+    }
+    if( rc==SQLITE_OK ){
+      i64 nSize;                  /* Current size of database file */
+      i64 nReq = ((i64)mxPage * szPage);
+      rc = sqlite3OsFileSize(pWal->pDbFd, &nSize);
+      if( rc==SQLITE_OK && nSize<nReq ){
+        sqlite3OsFileControlHint(pWal->pDbFd, SQLITE_FCNTL_SIZE_HINT, &nReq);
+      }
+    }
+
+    /* Iterate through the contents of the WAL, copying data to the db file. */
+    while( rc==SQLITE_OK && 0==walIteratorNext(pIter, &iDbpage, &iFrame) ){
+      i64 iOffset;
+      assert( walFramePgno(pWal, walIndexFrame(pWal, iWal, iFrame))==iDbpage );
+      if( iFrame<=nBackfill || iDbpage>mxPage ) continue;
+      iOffset = walFrameOffset(iFrame, szPage) + WAL_FRAME_HDRSIZE;
+      rc = sqlite3OsRead(pWal->apWalFd[iWal], zBuf, szPage, iOffset);
+      if( rc!=SQLITE_OK ) break;
+      iOffset = (iDbpage-1)*(i64)szPage;
+      testcase( IS_BIG_INT(iOffset) );
+      rc = sqlite3OsWrite(pWal->pDbFd, zBuf, szPage, iOffset);
+      if( rc!=SQLITE_OK ) break;
+    }
+
+    /* The database may only be truncated if the current file contains
+    ** no frames, as otherwise nPage might not be the size of the
+    ** database according to the most recent snapshot.  */
+    if( rc==SQLITE_OK ){
+      if( iWal==iCur || walidxGetMxFrame(walIndexHdr(pWal), iCur)==0 ){
+        i64 szDb = pWal->hdr.nPage*(i64)szPage;
+        testcase( IS_BIG_INT(szDb) );
+        rc = sqlite3OsTruncate(pWal->pDbFd, szDb);
+      }
+      if( rc==SQLITE_OK && sync_flags ){
+        rc = sqlite3OsSync(pWal->pDbFd, sync_flags);
+      }
+      if( rc==SQLITE_OK && iWal!=iCur ){
+        pInfo->nBackfill = mxFrame;
+      }
+    }
+
+    walUnlockExclusive(pWal, iLock, 2);
+  }
+
+  if( rc==SQLITE_BUSY && eMode==SQLITE_CHECKPOINT_PASSIVE ){
+    /* Reset the return code so as not to report a checkpoint failure
+    ** just because there are active readers.  */
+    rc = SQLITE_OK;
+  }
+
+  walIteratorFree(pIter);
+  return rc;
+}
+
 /*
 ** Copy as much content as we can from the WAL back into the database file
 ** in response to an sqlite3_wal_checkpoint() request or the equivalent.
@@ -1673,6 +2036,12 @@ static int walCheckpoint(
   volatile WalCkptInfo *pInfo;    /* The checkpoint status information */
   int (*xBusy)(void*) = 0;        /* Function to call when waiting for locks */
 
+  if( isWalMode2(pWal) ){
+    return walCheckpoint2(pWal, !walidxGetFile(&pWal->hdr),
+        eMode, xBusyCall, pBusyArg, sync_flags, zBuf
+    );
+  }
+
   szPage = walPagesize(pWal);
   testcase( szPage<=32768 );
   testcase( szPage>=65536 );
@@ -1680,7 +2049,7 @@ static int walCheckpoint(
   if( pInfo->nBackfill>=pWal->hdr.mxFrame ) return SQLITE_OK;
 
   /* Allocate the iterator */
-  rc = walIteratorInit(pWal, &pIter);
+  rc = walIteratorInit(pWal, 0, pWal->hdr.mxFrame, &pIter);
   if( rc!=SQLITE_OK ){
     return rc;
   }
@@ -1720,7 +2089,7 @@ static int walCheckpoint(
 
     /* Sync the WAL to disk */
     if( sync_flags ){
-      rc = sqlite3OsSync(pWal->pWalFd, sync_flags);
+      rc = sqlite3OsSync(pWal->apWalFd[0], sync_flags);
     }
 
     /* If the database may grow as a result of this checkpoint, hint
@@ -1742,7 +2111,7 @@ static int walCheckpoint(
       if( iFrame<=nBackfill || iFrame>mxSafeFrame || iDbpage>mxPage ) continue;
       iOffset = walFrameOffset(iFrame, szPage) + WAL_FRAME_HDRSIZE;
       /* testcase( IS_BIG_INT(iOffset) ); // requires a 4GiB WAL file */
-      rc = sqlite3OsRead(pWal->pWalFd, zBuf, szPage, iOffset);
+      rc = sqlite3OsRead(pWal->apWalFd[0], zBuf, szPage, iOffset);
       if( rc!=SQLITE_OK ) break;
       iOffset = (iDbpage-1)*(i64)szPage;
       testcase( IS_BIG_INT(iOffset) );
@@ -1799,23 +2168,25 @@ static int walCheckpoint(
 }
 
 /*
-** If the WAL file is currently larger than nMax bytes in size, truncate
+** If WAL file iWal is currently larger than nMax bytes in size, truncate
 ** it to exactly nMax bytes. If an error occurs while doing so, ignore it.
 */
-static void walLimitSize(Wal *pWal, i64 nMax){
+static void walLimitSize(Wal *pWal, int iWal, i64 nMax){
   i64 sz;
   int rx;
   sqlite3BeginBenignMalloc();
-  rx = sqlite3OsFileSize(pWal->pWalFd, &sz);
+  rx = sqlite3OsFileSize(pWal->apWalFd[iWal], &sz);
   if( rx==SQLITE_OK && (sz > nMax ) ){
-    rx = sqlite3OsTruncate(pWal->pWalFd, nMax);
+    rx = sqlite3OsTruncate(pWal->apWalFd[iWal], nMax);
   }
   sqlite3EndBenignMalloc();
   if( rx ){
-    sqlite3_log(rx, "cannot limit WAL size: %s", pWal->zWalName);
+    sqlite3_log(rx, "cannot limit WAL size: %s", pWal->azWalName[iWal]);
   }
 }
 
+static int walIndexReadHdr(Wal *pWal, int *pChanged);
+
 /*
 ** Close a connection to a log file.
 */
@@ -1828,6 +2199,8 @@ int sqlite3WalClose(
   int rc = SQLITE_OK;
   if( pWal ){
     int isDelete = 0;             /* True to unlink wal and wal-index files */
+    int iCur = 0;                 /* Current WAL file, deleted last */
+    int i;
 
     /* If an EXCLUSIVE lock can be obtained on the database file (using the
     ** ordinary, rollback-mode locking methods, this guarantees that the
@@ -1845,6 +2218,25 @@ int sqlite3WalClose(
       rc = sqlite3WalCheckpoint(
           pWal, SQLITE_CHECKPOINT_PASSIVE, 0, 0, sync_flags, nBuf, zBuf, 0, 0
       );
+      if( rc==SQLITE_OK && isWalMode2(pWal) ){
+        /* The checkpoint above only copied the non-current file of a wal2
+        ** database into the database file. As there are no other
+        ** connections, the current file may now be copied as well.  */
+        int notUsed;
+        rc = walIndexReadHdr(pWal, &notUsed);
+        iCur = walidxGetFile(&pWal->hdr);
+        if( rc==SQLITE_OK && walidxGetMxFrame(&pWal->hdr, iCur)>0 ){
+          if( walPagesize(pWal)!=nBuf ){
+            rc = SQLITE_CORRUPT_BKPT;
+          }else{
+            pWal->ckptLock = 1;
+            rc = walCheckpoint2(pWal, iCur,
+                SQLITE_CHECKPOINT_PASSIVE, 0, 0, sync_flags, zBuf
+            );
+            pWal->ckptLock = 0;
+          }
+        }
+      }
       if( rc==SQLITE_OK ){
         int bPersist = -1;
         sqlite3OsFileControlHint(
@@ -1862,18 +2254,26 @@ int sqlite3WalClose(
           ** non-negative value (pWal->mxWalSize>=0).  Note that we truncate
           ** to zero bytes as truncating to the journal_size_limit might
           ** leave a corrupt WAL file on disk. */
-          walLimitSize(pWal, 0);
+          for(i=isWalMode2(pWal); i>=0; i--){
+            walLimitSize(pWal, i==0 ? iCur : !iCur, 0);
+          }
         }
       }
     }
 
+    /* In wal2 mode, the current WAL file is deleted last. Were it deleted
+    ** first, recovery might find only the out-of-date non-current file. */
     walIndexClose(pWal, isDelete);
-    sqlite3OsClose(pWal->pWalFd);
-    if( isDelete ){
-      sqlite3BeginBenignMalloc();
-      sqlite3OsDelete(pWal->pVfs, pWal->zWalName, 0);
-      sqlite3EndBenignMalloc();
+    for(i=isWalMode2(pWal); i>=0; i--){
+      int iWal = (i==0 ? iCur : !iCur);
+      sqlite3OsClose(pWal->apWalFd[iWal]);
+      if( isDelete ){
+        sqlite3BeginBenignMalloc();
+        sqlite3OsDelete(pWal->pVfs, pWal->azWalName[iWal], 0);
+        sqlite3EndBenignMalloc();
+      }
     }
+    sqlite3WalGroupClose(pWal->pGroup);
     WALTRACE(("WAL%p: closed\n", pWal));
     sqlite3_free((void *)pWal->apWiData);
     sqlite3_free(pWal);
@@ -2142,6 +2542,29 @@ static int walTryBeginRead(Wal *pWal, int *pChanged, int useWal, int cnt){
   }
 
   pInfo = walCkptInfo(pWal);
+  if( isWalMode2(pWal) ){
+    /* In wal2 mode, the reader lock is determined by the snapshot: which
+    ** file is current and whether or not the other file has been fully
+    ** checkpointed. Once it is held, check that the snapshot has not
+    ** changed. If it has, a writer may have switched files, or a
+    ** checkpointer started, between the two.  */
+    int iCur = walidxGetFile(&pWal->hdr);
+    u32 mxOther = walidxGetMxFrame(&pWal->hdr, !iCur);
+    int eLock = walReadLockIdx(iCur, pInfo->nBackfill<mxOther);
+    assert( useWal==0 );
+    rc = walLockShared(pWal, WAL_READ_LOCK(eLock));
+    if( rc!=SQLITE_OK ){
+      return rc==SQLITE_BUSY ? WAL_RETRY : rc;
+    }
+    walShmBarrier(pWal);
+    if( memcmp((void *)walIndexHdr(pWal), &pWal->hdr, sizeof(WalIndexHdr)) ){
+      walUnlockShared(pWal, WAL_READ_LOCK(eLock));
+      return WAL_RETRY;
+    }
+    pWal->readLock = (i16)eLock;
+    return SQLITE_OK;
+  }
+
   if( !useWal && pInfo->nBackfill==pWal->hdr.mxFrame ){
     /* The WAL has been completely backfilled (or it is empty).
     ** and can be safely ignored.
@@ -2289,35 +2712,25 @@ void sqlite3WalEndReadTransaction(Wal *pWal){
 }
 
 /*
-** Search the wal file for page pgno. If found, set *piRead to the frame that
-** contains the page. Otherwise, if pgno is not in the wal file, set *piRead
-** to zero.
-**
-** Return SQLITE_OK if successful, or an error code if an error occurs. If an
-** error does occur, the final value of *piRead is undefined.
+** Search WAL file iWal for page pgno, considering only the frames that
+** are part of the snapshot in pWal->hdr. If found, set *piRead to the
+** wal-index frame number (see walIndexFrame()) of the last frame that
+** contains the page. Otherwise, set *piRead to zero.
 */
-int sqlite3WalFindFrame(
+static int walSearchWal(
   Wal *pWal,                      /* WAL handle */
+  int iWal,                       /* WAL file to search (0 unless wal2) */
   Pgno pgno,                      /* Database page number to read data for */
   u32 *piRead                     /* OUT: Frame number (or zero) */
 ){
   u32 iRead = 0;                  /* If !=0, WAL frame to return data from */
-  u32 iLast = pWal->hdr.mxFrame;  /* Last page in WAL for this reader */
+  u32 mxFrame = walidxGetMxFrame(&pWal->hdr, iWal);
+  u32 iLast;                      /* Last frame in wal-index for this reader */
   int iHash;                      /* Used to loop through N hash tables */
 
-  /* This routine is only be called from within a read transaction. */
-  assert( pWal->readLock>=0 || pWal->lockError );
-
-  /* If the "last page" field of the wal-index header snapshot is 0, then
-  ** no data will be read from the wal under any circumstances. Return early
-  ** in this case as an optimization.  Likewise, if pWal->readLock==0, 
-  ** then the WAL is ignored by the reader so return early, as if the 
-  ** WAL were empty.
-  */
-  if( iLast==0 || pWal->readLock==0 ){
-    *piRead = 0;
-    return SQLITE_OK;
-  }
+  *piRead = 0;
+  if( mxFrame==0 ) return SQLITE_OK;
+  iLast = walIndexFrame(pWal, iWal, mxFrame);
 
   /* Search the hash table or tables for an entry matching page number
   ** pgno. Each iteration of the following for() loop searches one
@@ -2343,6 +2756,10 @@ int sqlite3WalFindFrame(
   **   (iFrame<=iLast): 
   **     This condition filters out entries that were added to the hash
   **     table after the current read-transaction had started.
+  **
+  ** In wal2 mode, only every second hash table indexes file iWal. Since
+  ** the wal-index frame numbers of the frames of a file increase with
+  ** their frame numbers, the (iFrame<=iLast) test works in the same way.
   */
   for(iHash=walFramePage(iLast); iHash>=0 && iRead==0; iHash--){
     volatile ht_slot *aHash;      /* Pointer to hash table */
@@ -2352,6 +2769,7 @@ int sqlite3WalFindFrame(
     int nCollide;                 /* Number of hash collisions remaining */
     int rc;                       /* Error code */
 
+    if( isWalMode2(pWal) && (iHash&1)!=iWal ) continue;
     rc = walHashGet(pWal, iHash, &aHash, &aPgno, &iZero);
     if( rc!=SQLITE_OK ){
       return rc;
@@ -2376,9 +2794,9 @@ int sqlite3WalFindFrame(
   {
     u32 iRead2 = 0;
     u32 iTest;
-    for(iTest=iLast; iTest>0; iTest--){
-      if( walFramePgno(pWal, iTest)==pgno ){
-        iRead2 = iTest;
+    for(iTest=mxFrame; iTest>0; iTest--){
+      if( walFramePgno(pWal, walIndexFrame(pWal, iWal, iTest))==pgno ){
+        iRead2 = walIndexFrame(pWal, iWal, iTest);
         break;
       }
     }
@@ -2390,6 +2808,61 @@ int sqlite3WalFindFrame(
   return SQLITE_OK;
 }
 
+/*
+** Return true if a wal2 mode reader must search the non-current WAL file
+** of its snapshot for pages not found in the current one. This is so if
+** it holds one of the read-locks that also read the other file. It is
+** also so if the current file of the snapshot is not that of its lock,
+** which only happens to a writer that has just switched files, and so
+** which still needs the frames of the file it was writing before.
+*/
+static int walSearchOther(Wal *pWal){
+  int eLock = pWal->readLock;
+  assert( isWalMode2(pWal) && eLock>=WAL_LOCK_PART1 );
+  assert( eLock<=WAL_LOCK_PART2_FULL1 );
+  return (eLock & 1)==0 || ((eLock-1)>>1)!=walidxGetFile(&pWal->hdr);
+}
+
+/*
+** Search the wal file for page pgno. If found, set *piRead to the frame that
+** contains the page. Otherwise, if pgno is not in the wal file, set *piRead
+** to zero.
+**
+** Return SQLITE_OK if successful, or an error code if an error occurs. If an
+** error does occur, the final value of *piRead is undefined.
+*/
+int sqlite3WalFindFrame(
+  Wal *pWal,                      /* WAL handle */
+  Pgno pgno,                      /* Database page number to read data for */
+  u32 *piRead                     /* OUT: Frame number (or zero) */
+){
+  int rc;
+
+  /* This routine is only be called from within a read transaction. */
+  assert( pWal->readLock>=0 || pWal->lockError );
+
+  if( isWalMode2(pWal) ){
+    int iCur = walidxGetFile(&pWal->hdr);
+    rc = walSearchWal(pWal, iCur, pgno, piRead);
+    if( rc==SQLITE_OK && *piRead==0 && walSearchOther(pWal) ){
+      rc = walSearchWal(pWal, !iCur, pgno, piRead);
+    }
+    return rc;
+  }
+
+  /* If the "last page" field of the wal-index header snapshot is 0, then
+  ** no data will be read from the wal under any circumstances. Return early
+  ** in this case as an optimization.  Likewise, if pWal->readLock==0, 
+  ** then the WAL is ignored by the reader so return early, as if the 
+  ** WAL were empty.
+  */
+  if( pWal->hdr.mxFrame==0 || pWal->readLock==0 ){
+    *piRead = 0;
+    return SQLITE_OK;
+  }
+  return walSearchWal(pWal, 0, pgno, piRead);
+}
+
 /*
 ** Read the contents of frame iRead from the wal file into buffer pOut
 ** (which is nOut bytes in size). Return SQLITE_OK if successful, or an
@@ -2402,14 +2875,16 @@ int sqlite3WalReadFrame(
   u8 *pOut                        /* Buffer to write page data to */
 ){
   int sz;
+  int iWal;
   i64 iOffset;
   sz = pWal->hdr.szPage;
   sz = (sz&0xfe00) + ((sz&0x0001)<<16);
   testcase( sz<=32768 );
   testcase( sz>=65536 );
+  iRead = walIndexFrameDecode(pWal, iRead, &iWal);
   iOffset = walFrameOffset(iRead, sz) + WAL_FRAME_HDRSIZE;
   /* testcase( IS_BIG_INT(iOffset) ); // requires a 4GiB WAL */
-  return sqlite3OsRead(pWal->pWalFd, pOut, (nOut>sz ? sz : nOut), iOffset);
+  return sqlite3OsRead(pWal->apWalFd[iWal], pOut, (nOut>sz?sz:nOut), iOffset);
 }
 
 /* 
@@ -2469,6 +2944,101 @@ int sqlite3WalBeginWriteTransaction(Wal *pWal){
   return rc;
 }
 
+/*
+** This routine is called instead of sqlite3WalBeginWriteTransaction() by
+** a BEGIN CONCURRENT transaction, when it is ready to commit. Such a
+** transaction builds its changes in the page cache without holding the
+** WRITER lock, so other connections may have committed in the meantime.
+**
+** Bitvec pRead contains the number of every page read or written by the
+** transaction. If any frame appended to the log since the snapshot was
+** opened contains one of those pages, the transaction cannot be committed
+** and SQLITE_BUSY_SNAPSHOT is returned. SQLITE_BUSY_SNAPSHOT is also
+** returned if the log has been restarted or the size of the database has
+** changed, as the frames that are no longer in the log can not be checked.
+**
+** Otherwise the WRITER lock is left held and the snapshot is moved forward
+** to the end of the log, so that the frames of this transaction follow
+** those of the transactions committed in the meantime. xDrop is invoked
+** for each page written by those transactions, so that the caller may
+** discard any stale copy of it from its cache.
+*/
+int sqlite3WalLockForCommit(
+  Wal *pWal,                      /* WAL handle */
+  Bitvec *pRead,                  /* Pages read by the transaction */
+  int (*xDrop)(void*,Pgno),       /* Called for pages committed by others */
+  void *pDropCtx                  /* First argument passed to xDrop */
+){
+  WalIndexHdr hdr;                /* Current wal-index header */
+  u32 iFrame;                     /* Frame being checked */
+  int iCur = walidxGetFile(&pWal->hdr);
+  int rc;
+
+  assert( pWal->readLock>=0 );
+  assert( pWal->writeLock==0 );
+
+  if( pWal->readOnly ){
+    return SQLITE_READONLY;
+  }
+  rc = walLockExclusive(pWal, WAL_WRITE_LOCK, 1);
+  if( rc ){
+    return rc;
+  }
+  pWal->writeLock = 1;
+
+  /* The wal-index header can not change while the WRITER lock is held. */
+  memcpy(&hdr, (void *)walIndexHdr(pWal), sizeof(WalIndexHdr));
+  if( memcmp(&pWal->hdr, &hdr, sizeof(WalIndexHdr))==0 ){
+    return SQLITE_OK;
+  }
+  if( hdr.aSalt[0]!=pWal->hdr.aSalt[0] || hdr.aSalt[1]!=pWal->hdr.aSalt[1]
+   || walidxGetFile(&hdr)!=iCur
+   || walidxGetMxFrame(&hdr, iCur)<walidxGetMxFrame(&pWal->hdr, iCur)
+   || hdr.nPage!=pWal->hdr.nPage || hdr.szPage!=pWal->hdr.szPage
+  ){
+    rc = SQLITE_BUSY_SNAPSHOT;
+  }
+  for(iFrame=walidxGetMxFrame(&pWal->hdr, iCur)+1;
+      rc==SQLITE_OK && iFrame<=walidxGetMxFrame(&hdr, iCur);
+      iFrame++){
+    volatile u32 *aPage;
+    u32 iIdx = walIndexFrame(pWal, iCur, iFrame);
+    rc = walIndexPage(pWal, walFramePage(iIdx), &aPage);
+    if( rc==SQLITE_OK && sqlite3BitvecTest(pRead, walFramePgno(pWal, iIdx)) ){
+      rc = SQLITE_BUSY_SNAPSHOT;
+    }
+  }
+  if( rc!=SQLITE_OK ){
+    walUnlockExclusive(pWal, WAL_WRITE_LOCK, 1);
+    pWal->writeLock = 0;
+    return rc;
+  }
+
+  /* Move the snapshot forward. A reader that holds WAL_READ_LOCK(0) does
+  ** not use the log at all, so it must take a read-mark to see the new
+  ** frames. */
+  iFrame = walidxGetMxFrame(&pWal->hdr, iCur);
+  memcpy(&pWal->hdr, &hdr, sizeof(WalIndexHdr));
+  if( pWal->readLock==0 ){
+    int cnt = 0;
+    assert( !isWalMode2(pWal) );
+    walUnlockShared(pWal, WAL_READ_LOCK(0));
+    pWal->readLock = -1;
+    do{
+      int notUsed;
+      rc = walTryBeginRead(pWal, &notUsed, 1, ++cnt);
+    }while( rc==WAL_RETRY );
+    assert( (rc&0xff)!=SQLITE_BUSY ); /* BUSY not possible when useWal==1 */
+  }
+  for(iFrame++;
+      rc==SQLITE_OK && iFrame<=walidxGetMxFrame(&pWal->hdr, iCur);
+      iFrame++){
+    u32 iIdx = walIndexFrame(pWal, iCur, iFrame);
+    rc = xDrop(pDropCtx, walFramePgno(pWal, iIdx));
+  }
+  return rc;
+}
+
 /*
 ** End a write transaction.  The commit has already been done.  This
 ** routine merely releases the lock.
@@ -2482,6 +3052,38 @@ int sqlite3WalEndWriteTransaction(Wal *pWal){
   return SQLITE_OK;
 }
 
+/*
+** If the sync of the last transaction committed by this connection was
+** left to a group commit (see walgroup.c), wait until it has been synced.
+** This is called after the WRITER lock has been released, so that other
+** members of the group can append their own commits in the meantime.
+*/
+int sqlite3WalSyncCommit(Wal *pWal){
+  int rc = SQLITE_OK;
+  if( pWal->iGroupTicket ){
+    assert( pWal->writeLock==0 );
+    rc = sqlite3WalGroupSync(pWal->pGroup, pWal->iGroupTicket,
+        pWal->nGroupDelay, pWal->apWalFd, pWal->groupSyncFlags
+    );
+    pWal->iGroupTicket = 0;
+  }
+  return rc;
+}
+
+/*
+** Enable group commit for this connection, with a batching delay of
+** nDelay microseconds, or disable it if nDelay is zero. The connection
+** joins its group when it next commits (see sqlite3WalFrames()).
+*/
+void sqlite3WalGroupCommit(Wal *pWal, int nDelay){
+  assert( pWal->iGroupTicket==0 );
+  if( nDelay<=0 ){
+    sqlite3WalGroupClose(pWal->pGroup);
+    pWal->pGroup = 0;
+  }
+  pWal->nGroupDelay = nDelay;
+}
+
 /*
 ** If any data has been written (but not committed) to the log file, this
 ** function moves the write-pointer back to the start of the transaction.
@@ -2493,22 +3095,30 @@ int sqlite3WalEndWriteTransaction(Wal *pWal){
 **
 ** Otherwise, if the callback function does not return an error, this
 ** function returns SQLITE_OK.
+**
+** A BEGIN CONCURRENT transaction does not hold the WRITER lock until it
+** commits. If it is rolled back before then, there is nothing to undo.
 */
 int sqlite3WalUndo(Wal *pWal, int (*xUndo)(void *, Pgno), void *pUndoCtx){
   int rc = SQLITE_OK;
-  if( ALWAYS(pWal->writeLock) ){
-    Pgno iMax = pWal->hdr.mxFrame;
+  if( pWal->writeLock ){
+    int iCur = walidxGetFile(&pWal->hdr);
+    Pgno iMax = walidxGetMxFrame(&pWal->hdr, iCur);
     Pgno iFrame;
   
     /* Restore the clients cache of the wal-index header to the state it
-    ** was in before the client began writing to the database. 
+    ** was in before the client began writing to the database. A wal2
+    ** writer that switched files wrote the wal-index header as it did,
+    ** so the current file is the same in both.
     */
     memcpy(&pWal->hdr, (void *)walIndexHdr(pWal), sizeof(WalIndexHdr));
+    assert( walidxGetFile(&pWal->hdr)==iCur );
 
-    for(iFrame=pWal->hdr.mxFrame+1; 
+    for(iFrame=walidxGetMxFrame(&pWal->hdr, iCur)+1; 
         ALWAYS(rc==SQLITE_OK) && iFrame<=iMax; 
         iFrame++
     ){
+      u32 iIdx = walIndexFrame(pWal, iCur, iFrame);
       /* This call cannot fail. Unless the page for which the page number
       ** is passed as the second argument is (a) in the cache and 
       ** (b) has an outstanding reference, then xUndo is either a no-op
@@ -2520,10 +3130,10 @@ int sqlite3WalUndo(Wal *pWal, int (*xUndo)(void *, Pgno), void *pUndoCtx){
       ** page 1 is never written to the log until the transaction is
       ** committed. As a result, the call to xUndo may not fail.
       */
-      assert( walFramePgno(pWal, iFrame)!=1 );
-      rc = xUndo(pUndoCtx, walFramePgno(pWal, iFrame));
+      assert( walFramePgno(pWal, iIdx)!=1 );
+      rc = xUndo(pUndoCtx, walFramePgno(pWal, iIdx));
     }
-    if( iMax!=pWal->hdr.mxFrame ) walCleanupHash(pWal);
+    if( iMax!=walidxGetMxFrame(&pWal->hdr, iCur) ) walCleanupHash(pWal);
   }
   assert( rc==SQLITE_OK );
   return rc;
@@ -2537,7 +3147,7 @@ int sqlite3WalUndo(Wal *pWal, int (*xUndo)(void *, Pgno), void *pUndoCtx){
 */
 void sqlite3WalSavepoint(Wal *pWal, u32 *aWalData){
   assert( pWal->writeLock );
-  aWalData[0] = pWal->hdr.mxFrame;
+  aWalData[0] = walidxGetMxFrame(&pWal->hdr, walidxGetFile(&pWal->hdr));
   aWalData[1] = pWal->hdr.aFrameCksum[0];
   aWalData[2] = pWal->hdr.aFrameCksum[1];
   aWalData[3] = pWal->nCkpt;
@@ -2551,9 +3161,12 @@ void sqlite3WalSavepoint(Wal *pWal, u32 *aWalData){
 */
 int sqlite3WalSavepointUndo(Wal *pWal, u32 *aWalData){
   int rc = SQLITE_OK;
+  int iCur = walidxGetFile(&pWal->hdr);
 
   assert( pWal->writeLock );
-  assert( aWalData[3]!=pWal->nCkpt || aWalData[0]<=pWal->hdr.mxFrame );
+  assert( aWalData[3]!=pWal->nCkpt
+       || aWalData[0]<=walidxGetMxFrame(&pWal->hdr, iCur)
+  );
 
   if( aWalData[3]!=pWal->nCkpt ){
     /* This savepoint was opened immediately after the write-transaction
@@ -2564,8 +3177,8 @@ int sqlite3WalSavepointUndo(Wal *pWal, u32 *aWalData){
     aWalData[3] = pWal->nCkpt;
   }
 
-  if( aWalData[0]<pWal->hdr.mxFrame ){
-    pWal->hdr.mxFrame = aWalData[0];
+  if( aWalData[0]<walidxGetMxFrame(&pWal->hdr, iCur) ){
+    walidxSetMxFrame(&pWal->hdr, iCur, aWalData[0]);
     pWal->hdr.aFrameCksum[0] = aWalData[1];
     pWal->hdr.aFrameCksum[1] = aWalData[2];
     walCleanupHash(pWal);
@@ -2575,6 +3188,87 @@ int sqlite3WalSavepointUndo(Wal *pWal, u32 *aWalData){
 }
 
 
+/*
+** Return the size in bytes beyond which a wal2 writer switches to the
+** other WAL file: the journal_size_limit, or the size of a WAL of
+** SQLITE_DEFAULT_WAL_AUTOCHECKPOINT frames if there is no limit.
+*/
+static i64 walSwitchLimit(Wal *pWal){
+  if( pWal->mxWalSize>=0 ) return pWal->mxWalSize;
+  return walFrameOffset(SQLITE_DEFAULT_WAL_AUTOCHECKPOINT+1, pWal->szPage);
+}
+
+/*
+** This is the wal2 version of walRestartLog(). If the current WAL file has
+** grown beyond walSwitchLimit() bytes and every frame of the other file
+** has been checkpointed, switch to the other file, so that the frames of
+** this transaction overwrite it from the start.
+**
+** The switch requires that no reader may be using the other file: no
+** reader may hold either of the locks for which it is current, or the
+** lock that reads it from the current file. The writer's own lock is
+** the one for which the current file is current. It keeps it after the
+** switch, as it is still reading the old file (see walSearchOther()).
+*/
+static int walRestartLog2(Wal *pWal){
+  int rc = SQLITE_OK;
+  int iCur = walidxGetFile(&pWal->hdr);
+  int iNew = !iCur;
+  u32 mxNew = walidxGetMxFrame(&pWal->hdr, iNew);
+  volatile WalCkptInfo *pInfo = walCkptInfo(pWal);
+  int iFull = walReadLockIdx(iCur, 1);
+
+  /* Switch only before the first frame of the transaction is written, so
+  ** that the wal-index header written below contains no uncommitted
+  ** frames. And not at all unless the other file is fully checkpointed
+  ** and the current file is large enough.  */
+  if( memcmp(&pWal->hdr, (void*)walIndexHdr(pWal), sizeof(WalIndexHdr))
+   || walFrameOffset(walidxGetMxFrame(&pWal->hdr, iCur)+1, pWal->szPage)
+          <=walSwitchLimit(pWal)
+   || (mxNew>0 && pInfo->nBackfill<mxNew)
+  ){
+    return SQLITE_OK;
+  }
+
+  /* If this connection is reading the other file, it is no longer
+  ** required to do so, as it has been fully checkpointed.  */
+  if( pWal->readLock==iFull ){
+    rc = walLockShared(pWal, WAL_READ_LOCK(walReadLockIdx(iCur, 0)));
+    if( rc!=SQLITE_OK ){
+      return rc==SQLITE_BUSY ? SQLITE_OK : rc;
+    }
+    walUnlockShared(pWal, WAL_READ_LOCK(iFull));
+    pWal->readLock = (i16)walReadLockIdx(iCur, 0);
+  }
+  assert( pWal->readLock==walReadLockIdx(iCur, 0) );
+
+  rc = walLockExclusive(pWal, WAL_READ_LOCK(walReadLockIdx(iNew, 0)), 2);
+  if( rc==SQLITE_OK ){
+    rc = walLockExclusive(pWal, WAL_READ_LOCK(iFull), 1);
+    if( rc==SQLITE_OK ){
+      u32 *aSalt = pWal->hdr.aSalt;       /* Big-endian salt values */
+      u32 salt1;
+      sqlite3_randomness(4, &salt1);
+
+      /* Readers decide whether or not to read the other file by comparing
+      ** its size with nBackfill. So nBackfill must be zeroed before the
+      ** new header is visible.  */
+      pInfo->nBackfill = 0;
+      walShmBarrier(pWal);
+      pWal->nCkpt++;
+      walidxSetFile(&pWal->hdr, iNew);
+      walidxSetMxFrame(&pWal->hdr, iNew, 0);
+      sqlite3Put4byte((u8*)&aSalt[0], 1 + sqlite3Get4byte((u8*)&aSalt[0]));
+      aSalt[1] = salt1;
+      walIndexWriteHdr(pWal);
+      walUnlockExclusive(pWal, WAL_READ_LOCK(iFull), 1);
+    }
+    walUnlockExclusive(pWal, WAL_READ_LOCK(walReadLockIdx(iNew, 0)), 2);
+  }
+  if( rc==SQLITE_BUSY ) rc = SQLITE_OK;
+  return rc;
+}
+
 /*
 ** This function is called just before writing a set of frames to the log
 ** file (see sqlite3WalFrames()). It checks to see if, instead of appending
@@ -2591,6 +3285,9 @@ static int walRestartLog(Wal *pWal){
   int rc = SQLITE_OK;
   int cnt;
 
+  if( isWalMode2(pWal) ){
+    return walRestartLog2(pWal);
+  }
   if( pWal->readLock==0 ){
     volatile WalCkptInfo *pInfo = walCkptInfo(pWal);
     assert( pInfo->nBackfill==pWal->hdr.mxFrame );
@@ -2729,6 +3426,7 @@ int sqlite3WalFrames(
   int szFrame;                    /* The size of a single frame */
   i64 iOffset;                    /* Next byte to write in WAL file */
   WalWriter w;                    /* The writer */
+  int iWal;                       /* WAL file to write to (0 unless wal2) */
 
   assert( pList );
   assert( pWal->writeLock );
@@ -2755,7 +3453,8 @@ int sqlite3WalFrames(
   ** header to the start of the WAL file. See comments at the top of
   ** this source file for a description of the WAL header format.
   */
-  iFrame = pWal->hdr.mxFrame;
+  iWal = walidxGetFile(&pWal->hdr);
+  iFrame = walidxGetMxFrame(&pWal->hdr, iWal);
   if( iFrame==0 ){
     u8 aWalHdr[WAL_HDRSIZE];      /* Buffer to assemble wal-header in */
     u32 aCksum[2];                /* Checksum for wal-header */
@@ -2776,7 +3475,7 @@ int sqlite3WalFrames(
     pWal->hdr.aFrameCksum[1] = aCksum[1];
     pWal->truncateOnCommit = 1;
 
-    rc = sqlite3OsWrite(pWal->pWalFd, aWalHdr, sizeof(aWalHdr), 0);
+    rc = sqlite3OsWrite(pWal->apWalFd[iWal], aWalHdr, sizeof(aWalHdr), 0);
     WALTRACE(("WAL%p: wal-header write %s\n", pWal, rc ? "failed" : "ok"));
     if( rc!=SQLITE_OK ){
       return rc;
@@ -2790,7 +3489,7 @@ int sqlite3WalFrames(
     **     http://localhost:591/sqlite/info/ff5be73dee
     */
     if( pWal->syncHeader && sync_flags ){
-      rc = sqlite3OsSync(pWal->pWalFd, sync_flags & SQLITE_SYNC_MASK);
+      rc = sqlite3OsSync(pWal->apWalFd[iWal], sync_flags & SQLITE_SYNC_MASK);
       if( rc ) return rc;
     }
   }
@@ -2798,7 +3497,7 @@ int sqlite3WalFrames(
 
   /* Setup information needed to write frames into the WAL */
   w.pWal = pWal;
-  w.pFd = pWal->pWalFd;
+  w.pFd = pWal->apWalFd[iWal];
   w.iSyncPoint = 0;
   w.syncFlags = sync_flags;
   w.szPage = szPage;
@@ -2833,7 +3532,7 @@ int sqlite3WalFrames(
   */
   if( isCommit && (sync_flags & WAL_SYNC_TRANSACTIONS)!=0 ){
     if( pWal->padToSectorBoundary ){
-      int sectorSize = sqlite3SectorSize(pWal->pWalFd);
+      int sectorSize = sqlite3SectorSize(w.pFd);
       w.iSyncPoint = ((iOffset+sectorSize-1)/sectorSize)*sectorSize;
       while( iOffset<w.iSyncPoint ){
         rc = walWriteOneFrame(&w, pLast, nTruncate, iOffset);
@@ -2842,20 +3541,35 @@ int sqlite3WalFrames(
         nExtra++;
       }
     }else{
-      rc = sqlite3OsSync(w.pFd, sync_flags & SQLITE_SYNC_MASK);
+      if( pWal->nGroupDelay>0 && pWal->pGroup==0 && !pWal->exclusiveMode ){
+        sqlite3BeginBenignMalloc();
+        pWal->pGroup = sqlite3WalGroupOpen((void*)pWal->apWiData[0]);
+        sqlite3EndBenignMalloc();
+      }
+      if( pWal->pGroup && !pWal->exclusiveMode ){
+        /* Leave the sync to sqlite3WalSyncCommit(), which is called once
+        ** the WRITER lock has been released. */
+        pWal->iGroupTicket = sqlite3WalGroupAppend(pWal->pGroup, iWal);
+        pWal->groupSyncFlags = (u8)(sync_flags & SQLITE_SYNC_MASK);
+      }else{
+        rc = sqlite3OsSync(w.pFd, sync_flags & SQLITE_SYNC_MASK);
+      }
     }
   }
 
   /* If this frame set completes the first transaction in the WAL and
   ** if PRAGMA journal_size_limit is set, then truncate the WAL to the
-  ** journal size limit, if possible.
+  ** journal size limit, if possible. In wal2 mode, files are always
+  ** truncated to the size at which writers switch files.
   */
-  if( isCommit && pWal->truncateOnCommit && pWal->mxWalSize>=0 ){
-    i64 sz = pWal->mxWalSize;
-    if( walFrameOffset(iFrame+nExtra+1, szPage)>pWal->mxWalSize ){
+  if( isCommit && pWal->truncateOnCommit
+   && (pWal->mxWalSize>=0 || isWalMode2(pWal))
+  ){
+    i64 sz = (isWalMode2(pWal) ? walSwitchLimit(pWal) : pWal->mxWalSize);
+    if( walFrameOffset(iFrame+nExtra+1, szPage)>sz ){
       sz = walFrameOffset(iFrame+nExtra+1, szPage);
     }
-    walLimitSize(pWal, sz);
+    walLimitSize(pWal, iWal, sz);
     pWal->truncateOnCommit = 0;
   }
 
@@ -2864,15 +3578,15 @@ int sqlite3WalFrames(
   ** guarantees that there are no other writers, and no data that may
   ** be in use by existing readers is being overwritten.
   */
-  iFrame = pWal->hdr.mxFrame;
+  iFrame = walidxGetMxFrame(&pWal->hdr, iWal);
   for(p=pList; p && rc==SQLITE_OK; p=p->pDirty){
     iFrame++;
-    rc = walIndexAppend(pWal, iFrame, p->pgno);
+    rc = walIndexAppend(pWal, iWal, iFrame, p->pgno);
   }
   while( rc==SQLITE_OK && nExtra>0 ){
     iFrame++;
     nExtra--;
-    rc = walIndexAppend(pWal, iFrame, pLast->pgno);
+    rc = walIndexAppend(pWal, iWal, iFrame, pLast->pgno);
   }
 
   if( rc==SQLITE_OK ){
@@ -2880,15 +3594,22 @@ int sqlite3WalFrames(
     pWal->hdr.szPage = (u16)((szPage&0xff00) | (szPage>>16));
     testcase( szPage<=32768 );
     testcase( szPage>=65536 );
-    pWal->hdr.mxFrame = iFrame;
+    walidxSetMxFrame(&pWal->hdr, iWal, iFrame);
     if( isCommit ){
       pWal->hdr.iChange++;
       pWal->hdr.nPage = nTruncate;
     }
-    /* If this is a commit, update the wal-index header too. */
+    /* If this is a commit, update the wal-index header too. In wal2
+    ** mode, the callback is passed the number of frames in both files
+    ** that have not been checkpointed. */
     if( isCommit ){
       walIndexWriteHdr(pWal);
-      pWal->iCallback = iFrame;
+      if( isWalMode2(pWal) ){
+        pWal->iCallback = walidxTotalFrames(&pWal->hdr)
+                        - walCkptInfo(pWal)->nBackfill;
+      }else{
+        pWal->iCallback = iFrame;
+      }
     }
   }
 
@@ -2964,15 +3685,17 @@ int sqlite3WalCheckpoint(
 
   /* Copy data from the log to the database file. */
   if( rc==SQLITE_OK ){
-    if( pWal->hdr.mxFrame && walPagesize(pWal)!=nBuf ){
+    if( walidxTotalFrames(&pWal->hdr) && walPagesize(pWal)!=nBuf ){
       rc = SQLITE_CORRUPT_BKPT;
     }else{
       rc = walCheckpoint(pWal, eMode2, xBusy, pBusyArg, sync_flags, zBuf);
     }
 
-    /* If no error occurred, set the output variables. */
+    /* If no error occurred, set the output variables. In wal2 mode, the
+    ** frames of both files are counted in *pnLog, but only those of the
+    ** non-current file in *pnCkpt.  */
     if( rc==SQLITE_OK || rc==SQLITE_BUSY ){
-      if( pnLog ) *pnLog = (int)pWal->hdr.mxFrame;
+      if( pnLog ) *pnLog = (int)walidxTotalFrames(&pWal->hdr);
       if( pnCkpt ) *pnCkpt = (int)(walCkptInfo(pWal)->nBackfill);
     }
   }
@@ -34,6 +34,8 @@
 # define sqlite3WalDbsize(y)                     0
 # define sqlite3WalBeginWriteTransaction(y)      0
 # define sqlite3WalEndWriteTransaction(x)        0
+# define sqlite3WalSyncCommit(z)                 0
+# define sqlite3WalLockForCommit(w,x,y,z)        0
 # define sqlite3WalUndo(x,y,z)                   0
 # define sqlite3WalSavepoint(y,z)
 # define sqlite3WalSavepointUndo(y,z)            0
@@ -54,7 +56,9 @@
 typedef struct Wal Wal;
 
 /* Open and close a connection to a write-ahead log. */
-int sqlite3WalOpen(sqlite3_vfs*, sqlite3_file*, const char *, int, i64, Wal**);
+int sqlite3WalOpen(
+    sqlite3_vfs*, sqlite3_file*, const char *, int, int, i64, Wal**
+);
 int sqlite3WalClose(Wal *pWal, int sync_flags, int, u8 *);
 
 /* Set the limiting size of a WAL file. */
@@ -81,6 +85,15 @@ Pgno sqlite3WalDbsize(Wal *pWal);
 int sqlite3WalBeginWriteTransaction(Wal *pWal);
 int sqlite3WalEndWriteTransaction(Wal *pWal);
 
+/* Wait until the last commit is durable, if its sync was left to a group
+** commit (see walgroup.c). Called after the WRITER lock is released. */
+int sqlite3WalSyncCommit(Wal *pWal);
+
+/* Obtain the WRITER lock for a BEGIN CONCURRENT transaction that is about
+** to commit, provided that no page it read has been written since its
+** snapshot was opened. */
+int sqlite3WalLockForCommit(Wal*, Bitvec*, int (*xDrop)(void*,Pgno), void*);
+
 /* Undo any frames written (but not committed) to the log */
 int sqlite3WalUndo(Wal *pWal, int (*xUndo)(void *, Pgno), void *pUndoCtx);
 
@@ -126,6 +139,38 @@ int sqlite3WalExclusiveMode(Wal *pWal, int op);
 */
 int sqlite3WalHeapMemory(Wal *pWal);
 
+/* Background checkpointer (see walckpt.c). sqlite3WalCkptOpen() sets
+** *ppCkpt to NULL and returns SQLITE_OK if there is no thread support.
+*/
+typedef struct WalCkpt WalCkpt;
+int sqlite3WalCkptOpen(
+  sqlite3_vfs *pVfs,              /* VFS used to open the database */
+  const char *zDb,                /* Database file name */
+  const char *zWal,               /* WAL file name */
+  int bWal2,                      /* True for a wal2 mode database */
+  int szPage,                     /* Database page size */
+  int sync_flags,                 /* Flags to sync db file with (or 0) */
+  int nFrame,                     /* Checkpoint once the WAL is this large */
+  WalCkpt **ppCkpt                /* OUT: New checkpointer */
+);
+void sqlite3WalCkptClose(WalCkpt*);
+void sqlite3WalCkptLimit(WalCkpt*, int nFrame);
+void sqlite3WalCkptNotify(WalCkpt*, int nFrame);
+void sqlite3WalCkptStatus(WalCkpt*, int *aStat);   /* See WALCKPT_STAT_* */
+
+/* Enable group commit with a batching delay of nDelay microseconds, or
+** disable it if nDelay is zero. */
+void sqlite3WalGroupCommit(Wal *pWal, int nDelay);
+
+/* Group commit (see walgroup.c). sqlite3WalGroupOpen() returns NULL if
+** there is no thread support.
+*/
+typedef struct WalGroup WalGroup;
+WalGroup *sqlite3WalGroupOpen(void *pKey);
+void sqlite3WalGroupClose(WalGroup*);
+u64 sqlite3WalGroupAppend(WalGroup*, int iWal);
+int sqlite3WalGroupSync(WalGroup*, u64, int nDelay, sqlite3_file**, int);
+
 #ifdef SQLITE_ENABLE_ZIPVFS
 /* If the WAL file is not empty, return the number of bytes of content
 ** stored in each frame (i.e. the db page-size when the WAL was created).
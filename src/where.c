@@ -1562,14 +1562,60 @@ static int termCanDriveIndex(
   if( !sqlite3IndexAffinityOk(pTerm->pExpr, aff) ) return 0;
   return 1;
 }
+
+/*
+** Return TRUE if the WHERE clause term pTerm could be used to look up
+** rows of pSrc in a hash table. This requires that it could drive an
+** index, and that it compares values using the BINARY collating sequence,
+** as hash values are computed from the bytes of the values.
+*/
+static int termCanDriveHash(
+  Parse *pParse,                 /* Parsing context */
+  WhereTerm *pTerm,              /* WHERE clause term to check */
+  struct SrcList_item *pSrc,     /* Table we are trying to access */
+  Bitmask notReady               /* Tables in outer loops of the join */
+){
+  Expr *pX;
+  CollSeq *pColl;
+  if( !termCanDriveIndex(pTerm, pSrc, notReady) ) return 0;
+  pX = pTerm->pExpr;
+  pColl = sqlite3BinaryCompareCollSeq(pParse, pX->pLeft, pX->pRight);
+  return pColl==0 || sqlite3StrICmp(pColl->zName, "BINARY")==0;
+}
 #endif
 
 
 #ifndef SQLITE_OMIT_AUTOMATIC_INDEX
+/*
+** Return a string that identifies automatic index pIdx, on a table of
+** database iDb, in the cache of automatic indexes (see OP_ReuseAutoindex).
+** Automatic indexes with the same string have the same content as long
+** as the table is not written. Or return NULL if a malloc fails.
+*/
+static char *autoIndexKey(sqlite3 *db, Index *pIdx, int iDb){
+  Table *pTab = pIdx->pTable;
+  StrAccum txt;
+  int i;
+
+  sqlite3StrAccumInit(&txt, 0, 0, SQLITE_MAX_LENGTH);
+  txt.db = db;
+  sqlite3XPrintf(&txt, 0, "%d.%d.%s", iDb, pTab->tnum, pTab->zName);
+  for(i=0; i<pIdx->nKeyCol; i++){
+    sqlite3XPrintf(&txt, 0, "%c%d %s",
+                   i ? ',' : '(', pIdx->aiColumn[i], pIdx->azColl[i]);
+  }
+  sqlite3StrAccumAppend(&txt, ")", 1);
+  return sqlite3StrAccumFinish(&txt);
+}
+
 /*
 ** Generate code to construct the Index object for an automatic index
 ** and to set up the WhereLevel object pLevel so that the code generator
 ** makes use of the automatic index.
+**
+** If the WhereLoop is a hash join (WHERE_HASH_JOIN), the records of the
+** index are added to a hash table instead of a b-tree, keyed by the
+** columns of the == terms that use the BINARY collating sequence.
 */
 static void constructAutomaticIndex(
   Parse *pParse,              /* The parsing context */
@@ -1596,6 +1642,8 @@ static void constructAutomaticIndex(
   Bitmask idxCols;            /* Bitmap of columns used for indexing */
   Bitmask extraCols;          /* Bitmap of additional columns */
   u8 sentWarning = 0;         /* True if a warnning has been issued */
+  int bHash;                  /* True to build a hash table */
+  int addrReuse = 0;          /* OP_ReuseAutoindex, or 0 */
 
   /* Generate code to skip over the creation and initialization of the
   ** transient index on 2nd and subsequent iterations of the loop. */
@@ -1609,17 +1657,19 @@ static void constructAutomaticIndex(
   pTable = pSrc->pTab;
   pWCEnd = &pWC->a[pWC->nTerm];
   pLoop = pLevel->pWLoop;
+  bHash = (pLoop->wsFlags & WHERE_HASH_JOIN)!=0;
   idxCols = 0;
   for(pTerm=pWC->a; pTerm<pWCEnd; pTerm++){
-    if( termCanDriveIndex(pTerm, pSrc, notReady) ){
+    if( bHash ? termCanDriveHash(pParse, pTerm, pSrc, notReady)
+              : termCanDriveIndex(pTerm, pSrc, notReady) ){
       int iCol = pTerm->u.leftColumn;
       Bitmask cMask = iCol>=BMS ? MASKBIT(BMS-1) : MASKBIT(iCol);
       testcase( iCol==BMS );
       testcase( iCol==BMS-1 );
       if( !sentWarning ){
         sqlite3_log(SQLITE_WARNING_AUTOINDEX,
-            "automatic index on %s(%s)", pTable->zName,
-            pTable->aCol[iCol].zName);
+            bHash ? "hash join on %s(%s)" : "automatic index on %s(%s)",
+            pTable->zName, pTable->aCol[iCol].zName);
         sentWarning = 1;
       }
       if( (idxCols & cMask)==0 ){
@@ -1632,7 +1682,7 @@ static void constructAutomaticIndex(
   assert( nKeyCol>0 );
   pLoop->u.btree.nEq = pLoop->nLTerm = nKeyCol;
   pLoop->wsFlags = WHERE_COLUMN_EQ | WHERE_IDX_ONLY | WHERE_INDEXED
-                     | WHERE_AUTO_INDEX;
+                     | WHERE_AUTO_INDEX | (bHash ? WHERE_HASH_JOIN : 0);
 
   /* Count the number of additional columns needed to create a
   ** covering index.  A "covering index" is an index that contains all
@@ -1658,12 +1708,13 @@ static void constructAutomaticIndex(
   pIdx = sqlite3AllocateIndexObject(pParse->db, nKeyCol+1, 0, &zNotUsed);
   if( pIdx==0 ) return;
   pLoop->u.btree.pIndex = pIdx;
-  pIdx->zName = "auto-index";
+  pIdx->zName = bHash ? "hash-table" : "auto-index";
   pIdx->pTable = pTable;
   n = 0;
   idxCols = 0;
   for(pTerm=pWC->a; pTerm<pWCEnd; pTerm++){
-    if( termCanDriveIndex(pTerm, pSrc, notReady) ){
+    if( bHash ? termCanDriveHash(pParse, pTerm, pSrc, notReady)
+              : termCanDriveIndex(pTerm, pSrc, notReady) ){
       int iCol = pTerm->u.leftColumn;
       Bitmask cMask = iCol>=BMS ? MASKBIT(BMS-1) : MASKBIT(iCol);
       testcase( iCol==BMS-1 );
@@ -1703,26 +1754,231 @@ static void constructAutomaticIndex(
   /* Create the automatic index */
   assert( pLevel->iIdxCur>=0 );
   pLevel->iIdxCur = pParse->nTab++;
-  sqlite3VdbeAddOp2(v, OP_OpenAutoindex, pLevel->iIdxCur, nKeyCol+1);
+  if( bHash ){
+    sqlite3VdbeAddOp3(v, OP_HashOpen, pLevel->iIdxCur, nKeyCol+1,
+                      pLoop->u.btree.nEq);
+  }else{
+    sqlite3VdbeAddOp2(v, OP_OpenAutoindex, pLevel->iIdxCur, nKeyCol+1);
+  }
   sqlite3VdbeSetP4KeyInfo(pParse, pIdx);
   VdbeComment((v, "for %s", pTable->zName));
 
+  /* An automatic index on an ordinary table may be taken from the cache
+  ** of automatic indexes of the connection (PRAGMA automatic_index_cache),
+  ** in which case the code that fills it is skipped */
+  if( !bHash && pSrc->pSelect==0 && (pTable->tabFlags & TF_Ephemeral)==0 ){
+    sqlite3 *db = pParse->db;
+    int iDb = sqlite3SchemaToIndex(db, pTable->pSchema);
+    char *zKey = autoIndexKey(db, pIdx, iDb);
+    if( zKey ){
+      addrReuse = sqlite3VdbeAddOp4(v, OP_ReuseAutoindex, pLevel->iIdxCur,
+                                    0, pTable->tnum, zKey, P4_DYNAMIC);
+      sqlite3VdbeChangeP5(v, (u8)iDb);
+      VdbeCoverage(v);
+    }
+  }
+
   /* Fill the automatic index with content */
   addrTop = sqlite3VdbeAddOp1(v, OP_Rewind, pLevel->iTabCur); VdbeCoverage(v);
   regRecord = sqlite3GetTempReg(pParse);
   sqlite3GenerateIndexKey(pParse, pIdx, pLevel->iTabCur, regRecord, 0, 0, 0, 0);
-  sqlite3VdbeAddOp2(v, OP_IdxInsert, pLevel->iIdxCur, regRecord);
-  sqlite3VdbeChangeP5(v, OPFLAG_USESEEKRESULT);
+  if( bHash ){
+    sqlite3VdbeAddOp2(v, OP_HashInsert, pLevel->iIdxCur, regRecord);
+  }else{
+    sqlite3VdbeAddOp2(v, OP_IdxInsert, pLevel->iIdxCur, regRecord);
+    sqlite3VdbeChangeP5(v, OPFLAG_USESEEKRESULT);
+  }
   sqlite3VdbeAddOp2(v, OP_Next, pLevel->iTabCur, addrTop+1); VdbeCoverage(v);
   sqlite3VdbeChangeP5(v, SQLITE_STMTSTATUS_AUTOINDEX);
   sqlite3VdbeJumpHere(v, addrTop);
   sqlite3ReleaseTempReg(pParse, regRecord);
+  if( addrReuse ){
+    sqlite3VdbeAddOp1(v, OP_SaveAutoindex, pLevel->iIdxCur);
+    sqlite3VdbeJumpHere(v, addrReuse);
+  }
   
   /* Jump here when skipping the initialization */
   sqlite3VdbeJumpHere(v, addrInit);
 }
 #endif /* SQLITE_OMIT_AUTOMATIC_INDEX */
 
+/*
+** Return TRUE if the seeks done by WhereLoop pLoop, which implements FROM
+** clause term pItem, could each be preceded by a check of a Bloom filter.
+** This requires that pLoop seeks using == terms only, each of which
+** compares values using the BINARY collating sequence, and that pItem is
+** an ordinary table that is not on the right of a LEFT JOIN.
+*/
+static int whereLoopCanUseBloom(
+  Parse *pParse,                 /* Parsing context */
+  WhereLoop *pLoop,              /* The loop to check */
+  struct SrcList_item *pItem     /* FROM clause term implemented by pLoop */
+){
+  Table *pTab = pItem->pTab;
+  int nEq;
+  int j;
+  if( (pParse->db->flags & SQLITE_BloomFilter)==0 ) return 0;
+  if( pLoop->wsFlags & (WHERE_COLUMN_IN|WHERE_COLUMN_NULL|WHERE_SKIPSCAN
+                       |WHERE_MULTI_OR|WHERE_VIRTUALTABLE|WHERE_HASH_JOIN) ){
+    return 0;
+  }
+  if( (pLoop->wsFlags & WHERE_AUTO_INDEX)!=0 ){
+    /* Until it is constructed, an automatic index has only the flag
+    ** WHERE_AUTO_INDEX and the one term in aLTerm[] it was planned for. */
+    nEq = pLoop->nLTerm;
+  }else{
+    if( (pLoop->wsFlags & WHERE_COLUMN_EQ)==0 ) return 0;
+    if( (pLoop->wsFlags & (WHERE_IPK|WHERE_INDEXED))==0 ) return 0;
+    if( pLoop->u.btree.nSkip>0 ) return 0;
+    nEq = pLoop->u.btree.nEq;
+  }
+  if( nEq==0 ) return 0;
+  if( (pItem->jointype & JT_LEFT)!=0 ) return 0;
+  if( pTab->pSelect || (pTab->tabFlags & TF_Ephemeral)!=0 ) return 0;
+  if( IsVirtual(pTab) ) return 0;
+  for(j=0; j<nEq; j++){
+    WhereTerm *pTerm = pLoop->aLTerm[j];
+    CollSeq *pColl;
+    if( pTerm==0 || (pTerm->eOperator & WO_EQ)==0 ) return 0;
+    pColl = sqlite3BinaryCompareCollSeq(pParse,
+                pTerm->pExpr->pLeft, pTerm->pExpr->pRight);
+    if( pColl && sqlite3StrICmp(pColl->zName, "BINARY")!=0 ) return 0;
+  }
+  return 1;
+}
+
+/*
+** Return TRUE if WHERE clause term pTerm is used to build the Bloom
+** filter of a table with cursor iCur and mask mSelf. These are the terms
+** that refer to no other table, in this query or an outer one, and
+** that contain no subqueries.
+*/
+static int termFiltersBloom(WhereTerm *pTerm, int iCur, Bitmask mSelf){
+  return (pTerm->wtFlags & TERM_VIRTUAL)==0
+      && pTerm->prereqAll==mSelf
+      && sqlite3ExprIsTableConstant(pTerm->pExpr, iCur);
+}
+
+/*
+** If it is cheaper to run WhereLoop pLoop after the loops of path pPath
+** with a Bloom filter checked before each of its seeks than without,
+** set *prCost to the total cost with a filter and return TRUE. *prCost
+** is the total cost without a filter when this function is called.
+**
+** A seek is only done if the filter says that it may find a row of the
+** table that satisfies the terms used to build the filter. The chance
+** of that is estimated from pLoop->nOut, which already accounts for
+** those terms, but only mildly unless likelihood() was used.
+**
+** TUNING: Each filter term that is not used by the seek itself and has
+** no explicit likelihood is assumed to be true for 1 row in 4. Building
+** the filter costs a full scan of the table, and checking it costs about
+** as much as visiting one row.
+*/
+static int whereLoopBloomCost(
+  WhereInfo *pWInfo,             /* The WHERE clause */
+  WherePath *pPath,              /* Loops that run before pLoop */
+  WhereLoop *pLoop,              /* The loop to check */
+  LogEst *prCost                 /* IN/OUT: Total cost of the path */
+){
+  struct SrcList_item *pItem = &pWInfo->pTabList->a[pLoop->iTab];
+  WhereClause *pWC = &pWInfo->sWC;
+  LogEst rHit = pLoop->nOut;     /* Chance that a seek finds a row */
+  LogEst rCost;                  /* Total cost with a Bloom filter */
+  int i, j;
+
+  if( !whereLoopCanUseBloom(pWInfo->pParse, pLoop, pItem) ) return 0;
+  for(i=0; i<pWC->nTerm; i++){
+    WhereTerm *pTerm = &pWC->a[i];
+    if( !termFiltersBloom(pTerm, pItem->iCursor, pLoop->maskSelf) ) continue;
+    for(j=pLoop->nLTerm-1; j>=0 && pLoop->aLTerm[j]!=pTerm; j--){}
+    if( j<0 && pTerm->truthProb==-1 ){
+      rHit -= 20;  assert( 20==sqlite3LogEst(4) );
+    }
+  }
+  if( rHit>=0 ) return 0;
+
+  rCost = sqlite3LogEstAdd(pLoop->rSetup,
+                           sqlite3LogEst(pItem->pTab->nRowEst) + 16);
+  rCost = sqlite3LogEstAdd(rCost,
+                           pPath->nRow + sqlite3LogEstAdd(0, pLoop->rRun+rHit));
+  rCost = sqlite3LogEstAdd(rCost, pPath->rCost);
+  if( rCost>=*prCost ) return 0;
+  *prCost = rCost;
+  return 1;
+}
+
+/*
+** Generate code to construct the Bloom filter that level pLevel of the
+** join checks before each of its seeks. For each row of the table that
+** satisfies the filter terms (see termFiltersBloom()), the key formed by
+** the columns of the == constraints of the seeks is added to the filter.
+** A seek with a key that is not in the filter cannot find a row that
+** would be used by the join, so it is skipped.
+*/
+static void constructBloomFilter(
+  Parse *pParse,              /* The parsing context */
+  WhereInfo *pWInfo,          /* The WHERE clause */
+  WhereLevel *pLevel          /* Level of the join to build a filter for */
+){
+  WhereLoop *pLoop = pLevel->pWLoop;
+  struct SrcList_item *pItem = &pWInfo->pTabList->a[pLevel->iFrom];
+  Table *pTab = pItem->pTab;
+  WhereClause *pWC = &pWInfo->sWC;
+  Vdbe *v = pParse->pVdbe;
+  int iCur = pLevel->iTabCur;
+  int nEq;                    /* Number of columns in each key */
+  i64 nByte;                  /* Size of the filter in bytes */
+  int addrOnce;               /* Address of the initialization bypass jump */
+  int addrTop;                /* Top of the filter fill loop */
+  int addrCont;               /* Jump here to skip a row */
+  int regKey;                 /* First register of each key */
+  int i, j;
+
+  /* The == terms of an automatic index are only chosen when the index
+  ** is constructed, so check again that they suit the filter. */
+  if( !whereLoopCanUseBloom(pParse, pLoop, pItem) ) return;
+  nEq = pLoop->u.btree.nEq;
+
+  /* TUNING: The filter has 8 bits for each row of the table, which gives
+  ** about 5% false positives. But it is never smaller than 4KiB or larger
+  ** than 8MiB. */
+  nByte = pTab->nRowEst;
+  if( nByte<4096 ) nByte = 4096;
+  if( nByte>8388608 ) nByte = 8388608;
+  if( nByte>pParse->db->aLimit[SQLITE_LIMIT_LENGTH] ){
+    nByte = pParse->db->aLimit[SQLITE_LIMIT_LENGTH];
+  }
+
+  addrOnce = sqlite3CodeOnce(pParse); VdbeCoverage(v);
+  pLevel->regBloom = ++pParse->nMem;
+  sqlite3VdbeAddOp2(v, OP_Blob, (int)nByte, pLevel->regBloom);
+  VdbeComment((v, "Bloom filter for %s", pTab->zName));
+  sqlite3ExprCachePush(pParse);
+  addrTop = sqlite3VdbeAddOp1(v, OP_Rewind, iCur); VdbeCoverage(v);
+  addrCont = sqlite3VdbeMakeLabel(v);
+  for(i=0; i<pWC->nTerm; i++){
+    WhereTerm *pTerm = &pWC->a[i];
+    if( termFiltersBloom(pTerm, iCur, pLoop->maskSelf) ){
+      sqlite3ExprIfFalse(pParse, pTerm->pExpr, addrCont, SQLITE_JUMPIFNULL);
+    }
+  }
+  regKey = sqlite3GetTempRange(pParse, nEq);
+  for(j=0; j<nEq; j++){
+    sqlite3ExprCodeGetColumnOfTable(v, pTab, iCur,
+                                    pLoop->aLTerm[j]->u.leftColumn, regKey+j);
+  }
+  sqlite3VdbeAddOp4Int(v, OP_FilterAdd, pLevel->regBloom, 0, regKey, nEq);
+  sqlite3ReleaseTempRange(pParse, regKey, nEq);
+  sqlite3VdbeResolveLabel(v, addrCont);
+  sqlite3VdbeAddOp2(v, OP_Next, iCur, addrTop+1); VdbeCoverage(v);
+  sqlite3VdbeJumpHere(v, addrTop);
+  sqlite3ExprCachePop(pParse, 1);
+
+  /* Jump here when skipping the initialization */
+  sqlite3VdbeJumpHere(v, addrOnce);
+}
+
 #ifndef SQLITE_OMIT_VIRTUALTABLE
 /*
 ** Allocate and populate an sqlite3_index_info structure. It is the 
@@ -2693,7 +2949,9 @@ static void explainOneScan(
     ){
       char *zWhere = explainIndexRange(db, pLoop, pItem->pTab);
       zMsg = sqlite3MAppendf(db, zMsg,
-               ((flags & WHERE_AUTO_INDEX) ? 
+               ((flags & WHERE_HASH_JOIN) ?
+                   "%s USING %.0sHASH TABLE%.0s%s" :
+                (flags & WHERE_AUTO_INDEX) ? 
                    "%s USING AUTOMATIC %sINDEX%.0s%s" :
                    "%s USING %sINDEX %s%s"), 
                zMsg, ((flags & WHERE_IDX_ONLY) ? "COVERING " : ""),
@@ -2718,6 +2976,9 @@ static void explainOneScan(
                   pLoop->u.vtab.idxNum, pLoop->u.vtab.idxStr);
     }
 #endif
+    if( pLevel->regBloom ){
+      zMsg = sqlite3MAppendf(db, zMsg, "%s WITH BLOOM FILTER", zMsg);
+    }
     zMsg = sqlite3MAppendf(db, zMsg, "%s", zMsg);
     sqlite3VdbeAddOp4(v, OP_Explain, iId, iLevel, iFrom, zMsg, P4_DYNAMIC);
   }
@@ -2863,6 +3124,11 @@ static Bitmask codeOneLoopStart(
     if( iRowidReg!=iReleaseReg ) sqlite3ReleaseTempReg(pParse, iReleaseReg);
     addrNxt = pLevel->addrNxt;
     sqlite3VdbeAddOp2(v, OP_MustBeInt, iRowidReg, addrNxt); VdbeCoverage(v);
+    if( pLevel->regBloom ){
+      sqlite3VdbeAddOp4Int(v, OP_Filter, pLevel->regBloom, addrNxt,
+                           iRowidReg, 1);
+      VdbeCoverage(v);
+    }
     sqlite3VdbeAddOp3(v, OP_NotExists, iCur, addrNxt, iRowidReg);
     VdbeCoverage(v);
     sqlite3ExprCacheAffinityChange(pParse, iRowidReg, 1);
@@ -2959,6 +3225,28 @@ static Bitmask codeOneLoopStart(
       VdbeCoverageIf(v, testOp==OP_Gt);
       sqlite3VdbeChangeP5(v, SQLITE_AFF_NUMERIC | SQLITE_JUMPIFNULL);
     }
+  }else if( pLoop->wsFlags & WHERE_HASH_JOIN ){
+    /* Case 4a: A hash join.
+    **
+    **         The values of the == terms are looked up in the hash table
+    **         built by constructAutomaticIndex(). Its records cover all
+    **         the columns used, so the table itself is never read.
+    */
+    u16 nEq = pLoop->u.btree.nEq;     /* Number of == terms */
+    int iIdxCur = pLevel->iIdxCur;    /* The VDBE cursor for the hash table */
+    int regBase;                      /* Registers holding the key values */
+    char *zAff;                       /* Affinity of the key values */
+
+    assert( omitTable );
+    regBase = codeAllEqualityTerms(pParse, pLevel, 0, 0, &zAff);
+    codeApplyAffinity(pParse, regBase, nEq, zAff);
+    sqlite3DbFree(db, zAff);
+    addrNxt = pLevel->addrNxt;
+    sqlite3VdbeAddOp4Int(v, OP_HashProbe, iIdxCur, addrNxt, regBase, nEq);
+    VdbeCoverage(v);
+    pLevel->p2 = sqlite3VdbeCurrentAddr(v);
+    pLevel->op = OP_HashNext;
+    pLevel->p1 = iIdxCur;
   }else if( pLoop->wsFlags & WHERE_INDEXED ){
     /* Case 4: A scan using an index.
     **
@@ -3124,6 +3412,11 @@ static Bitmask codeOneLoopStart(
       start_constraints = 1;
     }
     codeApplyAffinity(pParse, regBase, nConstraint - bSeekPastNull, zStartAff);
+    if( pLevel->regBloom ){
+      sqlite3VdbeAddOp4Int(v, OP_Filter, pLevel->regBloom, addrNxt,
+                           regBase, nEq);
+      VdbeCoverage(v);
+    }
     op = aStartOp[(start_constraints<<2) + (startEq<<1) + bRev];
     assert( op!=0 );
     sqlite3VdbeAddOp4Int(v, op, iIdxCur, addrNxt, regBase, nConstraint);
@@ -3768,15 +4061,18 @@ static int whereLoopInsert(WhereLoopBuilder *pBuilder, WhereLoop *pTemplate){
       ** a candidate to replace the other. */
       continue;
     }
-    /* In the current implementation, the rSetup value is either zero
-    ** or the cost of building an automatic index (NlogN) and the NlogN
-    ** is the same for compatible WhereLoops. */
+    /* In the current implementation, the rSetup value is either zero,
+    ** the cost of building an automatic index (NlogN) or the cost of
+    ** building the hash table of a hash join (N). The NlogN and N are the
+    ** same for compatible WhereLoops. */
     assert( p->rSetup==0 || pTemplate->rSetup==0 
-                 || p->rSetup==pTemplate->rSetup );
+                 || p->rSetup==pTemplate->rSetup
+                 || ((p->wsFlags ^ pTemplate->wsFlags) & WHERE_HASH_JOIN)!=0 );
 
     /* whereLoopAddBtree() always generates and inserts the automatic index
-    ** case first.  Hence compatible candidate WhereLoops never have a larger
-    ** rSetup. Call this SETUP-INVARIANT */
+    ** cases first, followed by the hash join cases.  Hence compatible
+    ** candidate WhereLoops never have a larger rSetup. Call this
+    ** SETUP-INVARIANT */
     assert( p->rSetup>=pTemplate->rSetup );
 
     if( (p->prereq & pTemplate->prereq)==p->prereq
@@ -4266,6 +4562,34 @@ static int whereLoopAddBtree(
         rc = whereLoopInsert(pBuilder, pNew);
       }
     }
+
+    /* Generate hash join WhereLoops, if enabled by PRAGMA hash_join. Only
+    ** terms that refer to other tables of the join are used: a table that
+    ** is probed with a constant key is best scanned once. */
+    if( pWInfo->pParse->db->flags & SQLITE_HashJoin ){
+      for(pTerm=pWC->a; rc==SQLITE_OK && pTerm<pWCEnd; pTerm++){
+        if( pTerm->prereqRight & pNew->maskSelf ) continue;
+        if( pTerm->prereqRight==0 ) continue;
+        if( termCanDriveHash(pWInfo->pParse, pTerm, pSrc, 0) ){
+          pNew->u.btree.nEq = 1;
+          pNew->u.btree.nSkip = 0;
+          pNew->u.btree.pIndex = 0;
+          pNew->nLTerm = 1;
+          pNew->aLTerm[0] = pTerm;
+          /* TUNING: One-time cost for building the hash table is about
+          ** 3*N, as there is no sort. */
+          pNew->rSetup = rSize + 16;  assert( 16==sqlite3LogEst(3) );
+          /* TUNING: A probe costs about as much as visiting 2 rows, and
+          ** yields 20 rows, as for an automatic index. */
+          pNew->nOut = 43;  assert( 43==sqlite3LogEst(20) );
+          pNew->rRun = sqlite3LogEstAdd(10, pNew->nOut);
+          assert( 10==sqlite3LogEst(2) );
+          pNew->wsFlags = WHERE_AUTO_INDEX | WHERE_HASH_JOIN;
+          pNew->prereq = mExtra | pTerm->prereqRight;
+          rc = whereLoopInsert(pBuilder, pNew);
+        }
+      }
+    }
   }
 #endif /* SQLITE_OMIT_AUTOMATIC_INDEX */
 
@@ -5020,6 +5344,7 @@ static int wherePathSolver(WhereInfo *pWInfo, LogEst nRowEst){
       for(pWLoop=pWInfo->pLoops; pWLoop; pWLoop=pWLoop->pNextLoop){
         Bitmask maskNew;
         Bitmask revMask = 0;
+        Bitmask bloomMask;
         u8 isOrderedValid = pFrom->isOrderedValid;
         u8 isOrdered = pFrom->isOrdered;
         if( (pWLoop->prereq & ~pFrom->maskLoop)!=0 ) continue;
@@ -5028,6 +5353,10 @@ static int wherePathSolver(WhereInfo *pWInfo, LogEst nRowEst){
         ** Compute its cost */
         rCost = sqlite3LogEstAdd(pWLoop->rSetup,pWLoop->rRun + pFrom->nRow);
         rCost = sqlite3LogEstAdd(rCost, pFrom->rCost);
+        bloomMask = pFrom->bloomLoop;
+        if( iLoop>0 && whereLoopBloomCost(pWInfo, pFrom, pWLoop, &rCost) ){
+          bloomMask |= MASKBIT(iLoop);
+        }
         nOut = pFrom->nRow + pWLoop->nOut;
         maskNew = pFrom->maskLoop | pWLoop->maskSelf;
         if( !isOrderedValid ){
@@ -5120,6 +5449,7 @@ static int wherePathSolver(WhereInfo *pWInfo, LogEst nRowEst){
         /* pWLoop is a winner.  Add it to the set of best so far */
         pTo->maskLoop = pFrom->maskLoop | pWLoop->maskSelf;
         pTo->revLoop = revMask;
+        pTo->bloomLoop = bloomMask;
         pTo->nRow = nOut;
         pTo->rCost = rCost;
         pTo->isOrderedValid = isOrderedValid;
@@ -5183,6 +5513,7 @@ static int wherePathSolver(WhereInfo *pWInfo, LogEst nRowEst){
     pLevel->iFrom = pWLoop->iTab;
     pLevel->iTabCur = pWInfo->pTabList->a[pLevel->iFrom].iCursor;
   }
+  pWInfo->bloomMask = pFrom->bloomLoop;
   if( (pWInfo->wctrlFlags & WHERE_WANT_DISTINCT)!=0
    && (pWInfo->wctrlFlags & WHERE_DISTINCTBY)==0
    && pWInfo->eDistinct==WHERE_DISTINCT_NOOP
@@ -5693,7 +6024,8 @@ WhereInfo *sqlite3WhereBegin(
       /* noop */
     }else
 #endif
-    if( (pLoop->wsFlags & WHERE_IDX_ONLY)==0
+    if( ((pLoop->wsFlags & WHERE_IDX_ONLY)==0
+          || (pWInfo->bloomMask & MASKBIT(ii))!=0)
          && (wctrlFlags & WHERE_OMIT_OPEN_CLOSE)==0 ){
       int op = OP_OpenRead;
       if( pWInfo->okOnePass ){
@@ -5763,6 +6095,10 @@ WhereInfo *sqlite3WhereBegin(
       if( db->mallocFailed ) goto whereBeginError;
     }
 #endif
+    if( (pWInfo->bloomMask & MASKBIT(ii))!=0 ){
+      constructBloomFilter(pParse, pWInfo, pLevel);
+      if( db->mallocFailed ) goto whereBeginError;
+    }
     explainOneScan(pParse, pTabList, pLevel, ii, pLevel->iFrom, wctrlFlags);
     pLevel->addrBody = sqlite3VdbeCurrentAddr(v);
     notReady = codeOneLoopStart(pWInfo, ii, notReady);
@@ -5903,7 +6239,9 @@ void sqlite3WhereEnd(WhereInfo *pWInfo){
      && (pWInfo->wctrlFlags & WHERE_OMIT_OPEN_CLOSE)==0
     ){
       int ws = pLoop->wsFlags;
-      if( !pWInfo->okOnePass && (ws & WHERE_IDX_ONLY)==0 ){
+      if( !pWInfo->okOnePass
+       && ((ws & WHERE_IDX_ONLY)==0 || (pWInfo->bloomMask & MASKBIT(i))!=0)
+      ){
         sqlite3VdbeAddOp1(v, OP_Close, pTabItem->iCursor);
       }
       if( (ws & WHERE_INDEXED)!=0
@@ -5951,7 +6289,14 @@ void sqlite3WhereEnd(WhereInfo *pWInfo){
           assert( (pLoop->wsFlags & WHERE_IDX_ONLY)==0 || x>=0 );
         }else if( pOp->opcode==OP_Rowid ){
           pOp->p1 = pLevel->iIdxCur;
-          pOp->opcode = OP_IdxRowid;
+          if( pLoop->wsFlags & WHERE_HASH_JOIN ){
+            /* The rowid is the last column of the hash table records */
+            pOp->opcode = OP_Column;
+            pOp->p3 = pOp->p2;
+            pOp->p2 = pIdx->nKeyCol;
+          }else{
+            pOp->opcode = OP_IdxRowid;
+          }
         }
       }
     }
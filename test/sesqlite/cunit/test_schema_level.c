@@ -59,6 +59,17 @@ void test_create_table(void) {
     CU_ASSERT(SQLITE_EXEC(db, "CREATE TABLE t6(z INT);") == SQLITE_OK); /* no create */
 }
 
+void test_catalog(void) {
+
+    SQLITE_INIT
+    CU_ASSERT(SQLITE_EXEC(db, "CREATE VIRTUAL TABLE selinux_catalog USING selinux_catalog;") == SQLITE_OK);
+    CU_ASSERT(SQLITE_ASSERT(db, "SELECT name, column FROM selinux_catalog WHERE db='main' AND name='t1' AND column>='a' AND column<'c';",
+	ROW("t1","a"), ROW("t1","b")) == SQLITE_OK);
+    CU_ASSERT(SQLITE_ASSERT(db, "SELECT count(*) FROM selinux_catalog WHERE name='t1' AND label_id IS NOT NULL;", ROW("5")) == SQLITE_OK);
+    CU_ASSERT(SQLITE_ASSERT(db, "SELECT count(*) FROM selinux_catalog WHERE name='T1';", ROW("0")) == SQLITE_OK);
+    CU_ASSERT(SQLITE_EXEC(db, "DROP TABLE selinux_catalog;") == SQLITE_OK);
+}
+
 void test_insert_table(void) {
 
     SQLITE_INIT
@@ -104,6 +115,44 @@ void test_select_table(void) {
     CU_ASSERT(SQLITE_EXEC(db, "SELECT * FROM t2;") == SQLITE_OK);
 }
 
+void test_attach_database(void) {
+
+    SQLITE_INIT
+    unlink("attach.db");
+    CU_ASSERT(SQLITE_EXEC(db, "ATTACH DATABASE 'attach.db' AS aux;") == SQLITE_OK);
+    CU_ASSERT(SQLITE_EXEC(db, "CREATE TABLE aux.t1(h INT);") == SQLITE_OK);
+    CU_ASSERT(SQLITE_EXEC(db, "UPDATE aux.selinux_context SET security_label=getcon_id('unconfined_u:object_r:sqlite_db_no_access_t:s0', 'aux') WHERE db='main' AND name='' AND column='';") == SQLITE_OK);
+    CU_ASSERT(SQLITE_EXEC(db, "DETACH DATABASE aux;") == SQLITE_OK);
+    /* the file is checked against its own label, not against its name */
+    CU_ASSERT(SQLITE_EXEC(db, "ATTACH DATABASE 'attach.db' AS aux;") == SQLITE_AUTH);
+    CU_ASSERT(SQLITE_EXEC(db, "ATTACH DATABASE 'attach.db' AS other;") == SQLITE_AUTH);
+    CU_ASSERT(SQLITE_EXEC(db, "ATTACH DATABASE ':memory:' AS aux;") == SQLITE_OK);
+    CU_ASSERT(SQLITE_EXEC(db, "DETACH DATABASE aux;") == SQLITE_OK);
+    unlink("attach.db");
+}
+
+void test_restorecon(void) {
+
+    SQLITE_INIT
+    int nChange;
+    CU_ASSERT(SQLITE_EXEC(db, "CREATE TABLE tr(a INT);") == SQLITE_OK);
+    CU_ASSERT(SQLITE_EXEC(db, "PRAGMA chcon('unconfined_u:object_r:sqlite_column_no_select_t:s0 main.tr.a');") == SQLITE_OK);
+    CU_ASSERT(SQLITE_EXEC(db, "SELECT a FROM tr;") == SQLITE_AUTH);
+    /* the label is not changed when it can not be written */
+    CU_ASSERT(SQLITE_EXEC(db, "PRAGMA query_only=1;") == SQLITE_OK);
+    CU_ASSERT(SQLITE_EXEC(db, "PRAGMA restorecon('main.tr.a');") == SQLITE_OK);
+    CU_ASSERT(SQLITE_EXEC(db, "PRAGMA query_only=0;") == SQLITE_OK);
+    CU_ASSERT(SQLITE_EXEC(db, "SELECT a FROM tr;") == SQLITE_AUTH);
+    /* only the label that changed is written, and only once */
+    nChange = sqlite3_total_changes(db);
+    CU_ASSERT(SQLITE_EXEC(db, "PRAGMA restorecon('main.tr.a');") == SQLITE_OK);
+    CU_ASSERT(sqlite3_total_changes(db) - nChange == 1);
+    CU_ASSERT(SQLITE_EXEC(db, "SELECT a FROM tr;") == SQLITE_OK);
+    nChange = sqlite3_total_changes(db);
+    CU_ASSERT(SQLITE_EXEC(db, "PRAGMA restorecon('main.tr.a');") == SQLITE_OK);
+    CU_ASSERT(sqlite3_total_changes(db) - nChange == 0);
+    CU_ASSERT(SQLITE_EXEC(db, "DROP TABLE tr;") == SQLITE_OK);
+}
 
 void test_vacuum_table(void) {
 
@@ -129,10 +178,13 @@ int main(int argc, char **argv) {
 
     /* add the tests to the suite */
     if ((NULL == CU_ADD_TEST(pSuite, test_create_table))
+		    || (NULL == CU_ADD_TEST(pSuite, test_catalog))
 		    || (NULL == CU_ADD_TEST(pSuite, test_insert_table))
 		    || (NULL == CU_ADD_TEST(pSuite, test_select_table))
 		    || (NULL == CU_ADD_TEST(pSuite, test_update_table))
 		    || (NULL == CU_ADD_TEST(pSuite, test_delete_table))
+		    || (NULL == CU_ADD_TEST(pSuite, test_attach_database))
+		    || (NULL == CU_ADD_TEST(pSuite, test_restorecon))
 		    /* || (NULL == CU_ADD_TEST(pSuite, test_vacuum)) */ ){
 	    CU_cleanup_registry();
 	    return CU_get_error();
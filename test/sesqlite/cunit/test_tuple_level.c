@@ -24,6 +24,10 @@
 
 static sqlite3 *db;
 
+/* the label dictionary of the process, as used by the authorizer */
+char *sesqlite_label(int id);
+int sesqlite_label_id(const char *label);
+
 /* The suite initialization function.
  * Returns zero on success, non-zero otherwise.
  */
@@ -155,6 +159,254 @@ void test_delete_tuple(void) {
 
 }
 
+void test_label_count(void) {
+
+	SQLITE_INIT
+	CU_ASSERT(SQLITE_EXEC(db, "PRAGMA labelcount('main.t1');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT count(*) FROM t1;", ROW("2")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "INSERT INTO t1(a, b) values(106, 107);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "UPDATE t1 SET security_context=getcon_id('unconfined_u:object_r:sqlite_tuple_no_select_t:s0') WHERE a=102;") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT count(*) FROM t1;", ROW("2")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "PRAGMA nolabelcount('main.t1');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT count(*) FROM t1;", ROW("2")) == SQLITE_OK);
+
+}
+
+void test_label_count_guard(void) {
+
+	SQLITE_INIT
+	CU_ASSERT(SQLITE_EXEC(db, "CREATE TABLE tg(a INT, b INT);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "INSERT INTO tg(a, b) values(100, 101);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "PRAGMA chcon('unconfined_u:object_r:column_all:s0 main.tg.security_context');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "UPDATE tg SET security_context=getcon_id('unconfined_u:object_r:sqlite_tuple_no_select_t:s0') WHERE a=100;") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "PRAGMA labelcount('main.tg');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT count(*), total(a) FROM tg WHERE b>0;", ROW("0","0.0")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "INSERT INTO tg(a, b) values(102, 103);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT count(*), total(a) FROM tg WHERE b>0;", ROW("1","102.0")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "DROP TABLE tg;") == SQLITE_OK);
+
+}
+
+void test_label_count_rows(void) {
+
+	SQLITE_INIT
+	CU_ASSERT(SQLITE_EXEC(db, "CREATE TABLE tc(a INT, b INT);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "INSERT INTO tc(a, b) values(100, 101), (102, 103);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "PRAGMA chcon('unconfined_u:object_r:column_all:s0 main.tc.security_context');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "UPDATE tc SET security_context=getcon_id('unconfined_u:object_r:sqlite_tuple_no_select_t:s0') WHERE a=100;") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "PRAGMA labelcount('main.tc');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT name, count FROM selinux_count WHERE name='tc';", ROW("tc","1")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "INSERT INTO tc(a, b) values(104, 105);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT name, count FROM selinux_count WHERE name='tc';", ROW("tc","2")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "PRAGMA chcon('unconfined_u:object_r:sqlite_table_no_select_t:s0 main.tc');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "SELECT count(*) FROM tc;") != SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT count(*) FROM selinux_count WHERE name='tc';", ROW("0")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "PRAGMA chcon('unconfined_u:object_r:sqlite_table_t:s0 main.tc');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "DROP TABLE tc;") == SQLITE_OK);
+
+}
+
+void test_fts_label(void) {
+
+	SQLITE_INIT
+	CU_ASSERT(SQLITE_EXEC(db, "CREATE VIRTUAL TABLE ft USING fts4(body);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "INSERT INTO ft(body) values('alpha beta');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "INSERT INTO ft(security_context, body) values(getcon_id('unconfined_u:object_r:sqlite_tuple_no_select_t:s0'), 'alpha gamma');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT docid, snippet(ft) FROM ft WHERE ft MATCH 'alpha';", ROW("1","<b>alpha</b> beta")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT count(*) FROM ft WHERE ft MATCH 'gamma';", ROW("0")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "DROP TABLE ft;") == SQLITE_OK);
+
+}
+
+void test_attach_tuple(void) {
+
+	SQLITE_INIT
+	CU_ASSERT(SQLITE_EXEC(db, "ATTACH DATABASE ':memory:' AS aux;") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "CREATE TABLE aux.t1(h INT, i INT);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "INSERT INTO aux.t1(h, i) values(400, 401), (402, 403);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "UPDATE aux.t1 SET security_context=getcon_id('unconfined_u:object_r:sqlite_tuple_no_select_t:s0', 'aux') WHERE h=400;") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT * FROM aux.t1;", ROW("402","403")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT * FROM t1;", ROW("104","105"), ROW("106","107")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "DETACH DATABASE aux;") == SQLITE_OK);
+
+}
+
+void test_label_rollback(void) {
+
+	SQLITE_INIT
+	CU_ASSERT(SQLITE_EXEC(db, "BEGIN; SELECT getcon_id('unconfined_u:object_r:sqlite_tuple_t:s0:c1'); ROLLBACK;") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT getcon_label(getcon_id('unconfined_u:object_r:sqlite_tuple_no_select_t:s0:c2'));",
+		ROW("unconfined_u:object_r:sqlite_tuple_no_select_t:s0:c2")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "INSERT INTO t1(a, b) values(108, 109);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "UPDATE t1 SET security_context=getcon_id('unconfined_u:object_r:sqlite_tuple_no_select_t:s0:c2') WHERE a=108;") == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT count(*) FROM t1 WHERE a=108;", ROW("0")) == SQLITE_OK);
+	CU_ASSERT(SQLITE_ASSERT(db, "SELECT getcon_label(getcon_id('unconfined_u:object_r:sqlite_tuple_t:s0:c1'));",
+		ROW("unconfined_u:object_r:sqlite_tuple_t:s0:c1")) == SQLITE_OK);
+
+}
+
+/*
+ * Runs zSql, then zBetween, then prepares zSql again. Returns 1 if the
+ * second statement is the one kept by the statement cache (it already ran),
+ * 0 if it was compiled again, -1 on errors.
+ */
+static int stmt_reused(sqlite3 *pDb, const char *zSql, const char *zBetween) {
+
+	sqlite3_stmt *pStmt = NULL;
+	int reused;
+
+	if (sqlite3_prepare_v2(pDb, zSql, -1, &pStmt, NULL) != SQLITE_OK)
+		return -1;
+	while (sqlite3_step(pStmt) == SQLITE_ROW)
+		;
+	sqlite3_finalize(pStmt);
+
+	if (zBetween && sqlite3_exec(pDb, zBetween, 0, 0, 0) != SQLITE_OK)
+		return -1;
+
+	if (sqlite3_prepare_v2(pDb, zSql, -1, &pStmt, NULL) != SQLITE_OK)
+		return -1;
+	reused = sqlite3_stmt_status(pStmt, SQLITE_STMTSTATUS_VM_STEP, 0) > 0;
+	sqlite3_finalize(pStmt);
+	return reused;
+}
+
+void test_stmt_cache(void) {
+
+	SQLITE_INIT
+	CU_ASSERT(SQLITE_EXEC(db, "CREATE TABLE ts(a INT, b INT);") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "INSERT INTO ts(a, b) values(500, 501);") == SQLITE_OK);
+	CU_ASSERT(stmt_reused(db, "SELECT a FROM ts;", NULL) == 1);
+	CU_ASSERT(stmt_reused(db, "SELECT a FROM ts;", "INSERT INTO ts(a, b) values(502, 503);") == 1);
+	CU_ASSERT(stmt_reused(db, "SELECT a FROM ts;", "BEGIN; INSERT INTO ts(a, b) values(504, 505); ROLLBACK;") == 1);
+	CU_ASSERT(stmt_reused(db, "SELECT a FROM ts;", "PRAGMA chcon('unconfined_u:object_r:column_all:s0 main.ts.a');") == 0);
+	CU_ASSERT(stmt_reused(db, "SELECT a FROM ts;", "CREATE INDEX ts_a ON ts(a);") == 0);
+	CU_ASSERT(stmt_reused(db, "SELECT a FROM ts;", "PRAGMA stmtcache(0);") == 0);
+	CU_ASSERT(stmt_reused(db, "SELECT a FROM ts;", NULL) == 0);
+	CU_ASSERT(SQLITE_EXEC(db, "PRAGMA stmtcache(16);") == SQLITE_OK);
+	CU_ASSERT(stmt_reused(db, "SELECT a FROM ts;", NULL) == 1);
+	CU_ASSERT(SQLITE_EXEC(db, "PRAGMA chcon('unconfined_u:object_r:sqlite_column_no_select_t:s0 main.ts.a');") == SQLITE_OK);
+	CU_ASSERT(SQLITE_EXEC(db, "SELECT a FROM ts;") == SQLITE_AUTH);
+	CU_ASSERT(SQLITE_EXEC(db, "DROP TABLE ts;") == SQLITE_OK);
+
+}
+
+/* Returns the integer result of zSql, -1 on errors */
+static int query_int(sqlite3 *pDb, const char *zSql) {
+
+	sqlite3_stmt *pStmt = NULL;
+	int res = -1;
+
+	if (sqlite3_prepare_v2(pDb, zSql, -1, &pStmt, NULL) == SQLITE_OK
+			&& sqlite3_step(pStmt) == SQLITE_ROW)
+		res = sqlite3_column_int(pStmt, 0);
+	sqlite3_finalize(pStmt);
+	return res;
+}
+
+/*
+ * Process A of test_shared_labels: adds a label in a transaction that is
+ * rolled back and one that is committed, and sends their ids to B.
+ */
+static int shared_labels_writer(int in, int out) {
+
+	sqlite3 *pDb;
+	int ids[2];
+	char c;
+
+	if (sqlite3_open("shared.db", &pDb) != SQLITE_OK)
+		return 1;
+	if (write(out, "o", 1) != 1 || read(in, &c, 1) != 1)
+		return 2;
+
+	sqlite3_exec(pDb, "BEGIN;", 0, 0, 0);
+	ids[0] = query_int(pDb, "SELECT getcon_id('unconfined_u:object_r:sqlite_tuple_t:s0:c3');");
+	sqlite3_exec(pDb, "ROLLBACK;", 0, 0, 0);
+	ids[1] = query_int(pDb, "SELECT getcon_id('unconfined_u:object_r:sqlite_tuple_t:s0:c4');");
+
+	if (write(out, ids, sizeof(ids)) != sizeof(ids) || read(in, &c, 1) != 1)
+		return 3;
+	return sqlite3_close(pDb) == SQLITE_OK ? 0 : 4;
+}
+
+/*
+ * Process B of test_shared_labels: once A is done, looks the labels up in
+ * the dictionary of the process, without running any SQL after the open.
+ */
+static int shared_labels_reader(int in, int out) {
+
+	sqlite3 *pDb;
+	int ids[2];
+	int rc = 0;
+	char c;
+
+	if (read(in, &c, 1) != 1 || sqlite3_open("shared.db", &pDb) != SQLITE_OK)
+		return 1;
+	if (write(out, "o", 1) != 1 || read(in, ids, sizeof(ids)) != sizeof(ids))
+		return 2;
+
+	/* the id of the rolled back label was reused by the committed one */
+	if (ids[0] <= 0 || ids[1] != ids[0])
+		rc = 3;
+	else if (sesqlite_label_id("unconfined_u:object_r:sqlite_tuple_t:s0:c3") != 0)
+		rc = 4;
+	else if (sesqlite_label(ids[1]) == NULL
+			|| strcmp(sesqlite_label(ids[1]), "unconfined_u:object_r:sqlite_tuple_t:s0:c4") != 0)
+		rc = 5;
+	else if (sesqlite_label_id("unconfined_u:object_r:sqlite_tuple_t:s0:c4") != ids[1])
+		rc = 6;
+
+	if (write(out, "o", 1) != 1)
+		rc = 7;
+	sqlite3_close(pDb);
+	return rc;
+}
+
+void test_shared_labels(void) {
+
+	int a2b[2], b2a[2];
+	int status;
+	pid_t pids[2];
+	int i;
+
+	unlink("shared.db");
+	unlink("shared.db-sesqlite");
+	unlink("shared.db-sesqlite-shm");
+	CU_ASSERT_FATAL(pipe(a2b) == 0 && pipe(b2a) == 0);
+
+	fflush(stdout);
+	fflush(stderr);
+	for (i = 0; i < 2; i++) {
+		pids[i] = fork();
+		CU_ASSERT_FATAL(pids[i] >= 0);
+		if (pids[i] == 0) {
+			/* the children have their own connection to shared.db */
+			sqlite3_close(db);
+			_exit(i == 0 ? shared_labels_writer(b2a[0], a2b[1])
+				: shared_labels_reader(a2b[0], b2a[1]));
+		}
+	}
+
+	for (i = 0; i < 2; i++) {
+		CU_ASSERT(waitpid(pids[i], &status, 0) == pids[i]);
+		CU_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+
+	close(a2b[0]); close(a2b[1]);
+	close(b2a[0]); close(b2a[1]);
+	unlink("shared.db");
+}
+
+void test_stmt_cache_close(void) {
+
+	SQLITE_INIT
+	CU_ASSERT(stmt_reused(db, "SELECT 1;", NULL) == 1);
+	CU_ASSERT(stmt_reused(db, "SELECT 2;", NULL) == 1);
+	CU_ASSERT(sqlite3_close(db) == SQLITE_OK);
+	CU_ASSERT(SQLITE_OPEN(db, ":memory:") == SQLITE_OK);
+
+}
+
 int main(int argc, char **argv) {
 
 	CU_pSuite pSuite = NULL;
@@ -179,6 +431,15 @@ int main(int argc, char **argv) {
 			|| (NULL == CU_ADD_TEST(pSuite, test_select_tuple))
 			|| (NULL == CU_ADD_TEST(pSuite, test_update_tuple))
 			|| (NULL == CU_ADD_TEST(pSuite, test_delete_tuple))
+			|| (NULL == CU_ADD_TEST(pSuite, test_label_count))
+			|| (NULL == CU_ADD_TEST(pSuite, test_label_count_guard))
+			|| (NULL == CU_ADD_TEST(pSuite, test_label_count_rows))
+			|| (NULL == CU_ADD_TEST(pSuite, test_fts_label))
+			|| (NULL == CU_ADD_TEST(pSuite, test_attach_tuple))
+			|| (NULL == CU_ADD_TEST(pSuite, test_label_rollback))
+			|| (NULL == CU_ADD_TEST(pSuite, test_stmt_cache))
+			|| (NULL == CU_ADD_TEST(pSuite, test_shared_labels))
+			|| (NULL == CU_ADD_TEST(pSuite, test_stmt_cache_close))
 		) {
 		CU_cleanup_registry();
 		return CU_get_error();
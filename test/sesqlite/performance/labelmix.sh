@@ -0,0 +1,89 @@
+#!/bin/sh
+#
+# Sweeps the label mix of the rows and measures plain SQLite (base) and
+# SeSQLite (se) on the same workload, see tool/mkspeedsql_labelmix.tcl.
+#
+# Usage: ./labelmix.sh OUTFILE
+#
+# Each dimension is swept on its own, keeping the others at the default
+# value. The results are appended to OUTFILE, one line for each kind of
+# statement of each run:
+#
+#   engine,rows,labels,denied,joins,flush,subjects,subject,repeat,
+#   tag,statements,rows_returned,prepare,run,finalize,policy_queries
+#
+# The se binary is linked with policystub.c, so no SELinux policy (or
+# kernel) is needed. Every subject runs the queries in its own process,
+# on the database built by the setup phase.
+#
+# The following variables can be set in the environment:
+#
+#   BIN_BASE BIN_SE      binaries to run (./speedtest8, ./speedtest8_stub)
+#   ROWS REPEAT          rows per table (20000), runs of each scenario (1)
+#   LABELS DENIED JOINS FLUSH SUBJECTS
+#                        values to sweep, the first one is the default
+#   SESQLITE_STUB_DELAY  see policystub.c
+
+set -e
+
+OUT=${1:?usage: $0 OUTFILE}
+TOP=${TOP:-../../..}
+BIN_BASE=${BIN_BASE:-./speedtest8}
+BIN_SE=${BIN_SE:-./speedtest8_stub}
+ROWS=${ROWS:-20000}
+REPEAT=${REPEAT:-1}
+LABELS=${LABELS:-"4 1 2 16 64"}
+DENIED=${DENIED:-"25 0 10 50 90 100"}
+JOINS=${JOINS:-"1 2 3 4"}
+FLUSH=${FLUSH:-"0 1 10 100"}
+SUBJECTS=${SUBJECTS:-"1 2 4 8"}
+
+DB=labelmix.db
+SETUP_SQL=labelmix_setup.sql
+QUERY_SQL=labelmix_query.sql
+
+first() { echo $1; }
+
+# run ENGINE LABELS DENIED JOINS FLUSH SUBJECTS
+run() {
+	engine=$1; labels=$2; denied=$3; joins=$4; flush=$5; subjects=$6
+	if [ $engine = se ]; then bin=$BIN_SE; else bin=$BIN_BASE; fi
+
+	args="-engine $engine -rows $ROWS -labels $labels -denied $denied"
+	args="$args -joins $joins -flush $flush"
+	tclsh $TOP/tool/mkspeedsql_labelmix.tcl -phase setup $args > $SETUP_SQL
+	tclsh $TOP/tool/mkspeedsql_labelmix.tcl -phase query $args > $QUERY_SQL
+
+	for r in $(seq 1 $REPEAT); do
+		scenario="$engine,$ROWS,$labels,$denied,$joins,$flush,$subjects"
+		echo "[$scenario] run $r"
+		rm -f $DB*
+		$bin -quiet -csv $OUT -tag "$scenario,0,$r" $DB $SETUP_SQL > /dev/null
+		for s in $(seq 1 $subjects); do
+			SESQLITE_SUBJECT="unconfined_u:unconfined_r:bench_s${s}_t:s0" \
+			$bin -quiet -keepdb -csv $OUT -tag "$scenario,$s,$r" \
+				$DB $QUERY_SQL > /dev/null
+		done
+	done
+}
+
+# sweep ENGINE: the defaults first, then one dimension at a time
+sweep() {
+	l=$(first $LABELS); d=$(first $DENIED); j=$(first $JOINS)
+	f=$(first $FLUSH); s=$(first $SUBJECTS)
+
+	run $1 $l $d $j $f $s
+	for x in $LABELS;   do [ $x = $l ] || run $1 $x $d $j $f $s; done
+	for x in $DENIED;   do [ $x = $d ] || run $1 $l $x $j $f $s; done
+	for x in $JOINS;    do [ $x = $j ] || run $1 $l $d $x $f $s; done
+	for x in $FLUSH;    do [ $x = $f ] || run $1 $l $d $j $x $s; done
+	for x in $SUBJECTS; do [ $x = $s ] || run $1 $l $d $j $f $x; done
+}
+
+echo "engine,rows,labels,denied,joins,flush,subjects,subject,repeat,\
+tag,statements,rows_returned,prepare,run,finalize,policy_queries" > $OUT
+
+sweep base
+sweep se
+
+rm -f $DB* $SETUP_SQL $QUERY_SQL
@@ -0,0 +1,85 @@
+/*
+** Stand-in for the libselinux functions used by SeSQLite.
+**
+** Linking this file instead of -lselinux allows to run the benchmarks on
+** machines without SELinux in enforcing mode (or without SELinux at all).
+** The decisions follow the naming convention of the test policy: a
+** permission is denied when the name of the permission follows "no_" in
+** the target context, e.g. "unconfined_u:object_r:sqlite_tuple_no_select_t:s0"
+** denies select.
+**
+** Environment variables:
+**
+**     SESQLITE_SUBJECT      context returned by getcon()
+**                           (default unconfined_u:unconfined_r:unconfined_t:s0)
+**     SESQLITE_STUB_DELAY   nanoseconds spent in each selinux_check_access(),
+**                           to emulate the cost of a query to the kernel
+**
+** The number of decisions computed is stored in policystub_queries, so
+** that the benchmark can report how many of them were not served by the AVC.
+** It is updated atomically, the threads of threadtest.c share it.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_SUBJECT "unconfined_u:unconfined_r:unconfined_t:s0"
+#define DEFAULT_OBJECT  "unconfined_u:object_r:sqlite_t:s0"
+
+unsigned long policystub_queries = 0;
+
+static long stub_delay = -1;
+
+static void stub_wait(void){
+  struct timespec start, now;
+  long elapsed;
+
+  if( stub_delay<0 ){
+    const char *z = getenv("SESQLITE_STUB_DELAY");
+    stub_delay = z ? atol(z) : 0;
+  }
+  if( stub_delay==0 ) return;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  do{
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = (now.tv_sec - start.tv_sec) * 1000000000L
+            + (now.tv_nsec - start.tv_nsec);
+  }while( elapsed<stub_delay );
+}
+
+int getcon(char **con){
+  const char *z = getenv("SESQLITE_SUBJECT");
+  *con = strdup(z ? z : DEFAULT_SUBJECT);
+  return *con ? 0 : -1;
+}
+
+int selinux_check_access(
+  const char *scon,
+  const char *tcon,
+  const char *tclass,
+  const char *perm,
+  void *aux
+){
+  const char *z = strstr(tcon, "no_");
+
+  __sync_fetch_and_add(&policystub_queries, 1);
+  stub_wait();
+
+  /* "column_no_select_update" denies both select and update */
+  return ( z && strstr(z, perm) ) ? -1 : 0;
+}
+
+int security_compute_create_raw(
+  const char *scon,
+  const char *tcon,
+  unsigned short tclass,
+  char **newcon
+){
+  *newcon = strdup(DEFAULT_OBJECT);
+  return *newcon ? 0 : -1;
+}
+
+int security_check_context(const char *con){
+  return 0;
+}
@@ -53,6 +53,63 @@
 // static sqlite_uint64 finalizeTime = 0;
 static struct timespec prepTime, runTime, finalizeTime;
 
+/*
+** Totals for each kind of statement, written with the -csv option.
+** The kind (tag) of a statement is the text of the C-style comment at
+** its beginning, or "-" if there is none.
+*/
+#define MX_TAG 32
+static struct TagStat {
+  char zTag[32];
+  int nStmt;
+  int nRow;
+  struct timespec prepTime, runTime, finalizeTime;
+  unsigned long nQuery;
+} aTag[MX_TAG];
+static int nTag = 0;
+
+/*
+** Number of decisions asked to the policy backend, only available when
+** linked with policystub.c.
+*/
+#if defined(__GNUC__)
+extern unsigned long policystub_queries __attribute__((weak));
+#endif
+
+static unsigned long policyQueries(void){
+#if defined(__GNUC__)
+  if( &policystub_queries ) return policystub_queries;
+#endif
+  return 0;
+}
+
+static struct TagStat *findTag(const char *zSql){
+  char zTag[sizeof(aTag[0].zTag)];
+  int i, n = 0;
+
+  while( isspace(*zSql) ){ zSql++; }
+  if( zSql[0]=='/' && zSql[1]=='*' ){
+    zSql += 2;
+    while( isspace(*zSql) ){ zSql++; }
+    while( zSql[n] && !(zSql[n]=='*' && zSql[n+1]=='/') ){ n++; }
+    while( n>0 && isspace(zSql[n-1]) ){ n--; }
+  }
+  if( n==0 ){
+    zSql = "-";
+    n = 1;
+  }
+  if( n>=sizeof(zTag) ) n = sizeof(zTag)-1;
+  memcpy(zTag, zSql, n);
+  zTag[n] = 0;
+
+  for(i=0; i<nTag; i++){
+    if( strcmp(aTag[i].zTag, zTag)==0 ) return &aTag[i];
+  }
+  if( nTag==MX_TAG ) return &aTag[MX_TAG-1];
+  memcpy(aTag[nTag].zTag, zTag, n+1);
+  return &aTag[nTag++];
+}
+
 /*
 ** Prepare and run a single statement of SQL.
 */
@@ -60,6 +117,8 @@ static void prepareAndRun(sqlite3 *db, const char *zSql, int bQuiet){
   sqlite3_stmt *pStmt;
   const char *stmtTail;
   struct timespec iStart, iElapse;
+  struct TagStat *pTag = findTag(zSql);
+  unsigned long nQuery = policyQueries();
   int rc;
   
   if (!bQuiet){
@@ -70,6 +129,7 @@ static void prepareAndRun(sqlite3 *db, const char *zSql, int bQuiet){
   rc = sqlite3_prepare_v2(db, zSql, -1, &pStmt, &stmtTail);
   iElapse = tsSubtract(tsTOD(), iStart);
   prepTime = tsAdd(prepTime, iElapse);
+  pTag->prepTime = tsAdd(pTag->prepTime, iElapse);
   if (!bQuiet){
     printf("sqlite3_prepare_v2() returns %d in %g secs\n", rc, tsFloat(iElapse));
   }
@@ -79,6 +139,8 @@ static void prepareAndRun(sqlite3 *db, const char *zSql, int bQuiet){
     while( (rc=sqlite3_step(pStmt))==SQLITE_ROW ){ nRow++; }
     iElapse = tsSubtract(tsTOD(), iStart);
     runTime = tsAdd(runTime, iElapse);
+    pTag->runTime = tsAdd(pTag->runTime, iElapse);
+    pTag->nRow += nRow;
     if (!bQuiet){
       printf("sqlite3_step() returns %d after %d rows in %g secs\n",
              rc, nRow, tsFloat(iElapse));
@@ -87,10 +149,38 @@ static void prepareAndRun(sqlite3 *db, const char *zSql, int bQuiet){
     rc = sqlite3_finalize(pStmt);
     iElapse = tsSubtract(tsTOD(), iStart);
     finalizeTime = tsAdd(finalizeTime, iElapse);
+    pTag->finalizeTime = tsAdd(pTag->finalizeTime, iElapse);
     if (!bQuiet){
       printf("sqlite3_finalize() returns %d in %g secs\n", rc, tsFloat(iElapse));
     }
   }
+  pTag->nStmt++;
+  pTag->nQuery += policyQueries() - nQuery;
+}
+
+/*
+** Append one line for each kind of statement to the CSV file zFile:
+**
+**     [PREFIX,]tag,statements,rows,prepare,run,finalize,policy_queries
+**
+** Times are in seconds.
+*/
+static void writeCsv(const char *zFile, const char *zPrefix){
+  FILE *out = fopen(zFile, "a");
+  int i;
+
+  if( out==0 ){
+    fprintf(stderr, "cannot open %s\n", zFile);
+    return;
+  }
+  for(i=0; i<nTag; i++){
+    fprintf(out, "%s%s%s,%d,%d,%.9f,%.9f,%.9f,%lu\n",
+        zPrefix ? zPrefix : "", zPrefix ? "," : "",
+        aTag[i].zTag, aTag[i].nStmt, aTag[i].nRow,
+        tsFloat(aTag[i].prepTime), tsFloat(aTag[i].runTime),
+        tsFloat(aTag[i].finalizeTime), aTag[i].nQuery);
+  }
+  fclose(out);
 }
 
 int main(int argc, char **argv){
@@ -105,6 +195,9 @@ int main(int argc, char **argv){
   int nByte = 0;
   const char *zArgv0 = argv[0];
   int bQuiet = 0;
+  int bKeep = 0;
+  const char *zCsv = 0;
+  const char *zCsvPrefix = 0;
 #if !defined(_MSC_VER)
   struct tms tmsStart, tmsEnd;
   clock_t clkStart, clkEnd;
@@ -169,6 +262,27 @@ int main(int argc, char **argv){
      continue;
     }
 
+    if( argc>3 && strcmp(argv[1], "-keepdb")==0 ){
+     bKeep = 1;
+     argv++;
+     argc--;
+     continue;
+    }
+
+    if( argc>4 && strcmp(argv[1], "-csv")==0 ){
+     zCsv = argv[2];
+     argv += 2;
+     argc -= 2;
+     continue;
+    }
+
+    if( argc>4 && strcmp(argv[1], "-tag")==0 ){
+     zCsvPrefix = argv[2];
+     argv += 2;
+     argc -= 2;
+     continue;
+    }
+
     break;
   }
 
@@ -180,7 +294,10 @@ int main(int argc, char **argv){
               "\t-log <log>\n"
 #endif
               "\t-priority <value> : set priority of task\n"
-              "\t-quiet : only display summary results\n",
+              "\t-quiet : only display summary results\n"
+              "\t-keepdb : do not delete FILENAME before running the script\n"
+              "\t-csv <file> : append the totals of each kind of statement to file\n"
+              "\t-tag <prefix> : first fields of the lines written with -csv\n",
               zArgv0);
    exit(1);
   }
@@ -194,7 +311,7 @@ int main(int argc, char **argv){
   zSql[nSql] = 0;
 
   printf("SQLite version: %d - %s\n", sqlite3_libversion_number(), sqlite3_sourceid());
-  unlink(argv[1]);
+  if( !bKeep ) unlink(argv[1]);
 #if !defined(_MSC_VER)
   clkStart = times(&tmsStart);
 #endif
@@ -259,6 +376,8 @@ int main(int argc, char **argv){
 //   printf("Total real time:       %15.3g secs\n", (clkEnd - clkStart) / (double)CLOCKS_PER_SEC );
 // #endif
 
+  if( zCsv ) writeCsv(zCsv, zCsvPrefix);
+
 #ifdef HAVE_OSINST
   if( pVfs ){
     sqlite3_instvfs_destroy(pVfs);
@@ -0,0 +1,56 @@
+#!/bin/sh
+#
+# Measures how plain SQLite (base) and SeSQLite (se) scale with the number
+# of threads, each one with its own connection, see threadtest.c.
+#
+# Usage: ./threads.sh OUTFILE
+#
+# The results are appended to OUTFILE, one line for each run:
+#
+#   engine,rows,labels,denied,write,repeat,
+#   threads,reads,writes,busy,seconds,throughput,policy_queries
+#
+# The se binary is linked with policystub.c, so no SELinux policy (or
+# kernel) is needed.
+#
+# The following variables can be set in the environment:
+#
+#   BIN_BASE BIN_SE      binaries to run (./threadtest, ./threadtest_stub)
+#   ROWS OPS REPEAT      rows in the table (10000), statements run by each
+#                        thread (2000), runs of each scenario (1)
+#   THREADS              values to sweep (1 2 4 8 16 32 64)
+#   LABELS DENIED WRITE  see threadtest.c (4, 25, 10)
+#   SESQLITE_STUB_DELAY  see policystub.c
+
+set -e
+
+OUT=${1:?usage: $0 OUTFILE}
+BIN_BASE=${BIN_BASE:-./threadtest}
+BIN_SE=${BIN_SE:-./threadtest_stub}
+ROWS=${ROWS:-10000}
+OPS=${OPS:-2000}
+REPEAT=${REPEAT:-1}
+THREADS=${THREADS:-"1 2 4 8 16 32 64"}
+LABELS=${LABELS:-4}
+DENIED=${DENIED:-25}
+WRITE=${WRITE:-10}
+
+DB=threads.db
+
+echo "engine,rows,labels,denied,write,repeat,\
+threads,reads,writes,busy,seconds,throughput,policy_queries" > $OUT
+
+for engine in base se; do
+	if [ $engine = se ]; then bin=$BIN_SE; else bin=$BIN_BASE; fi
+	for t in $THREADS; do
+		for r in $(seq 1 $REPEAT); do
+			scenario="$engine,$ROWS,$LABELS,$DENIED,$WRITE,$r"
+			echo "[$scenario] $t threads"
+			$bin -engine $engine -threads $t -rows $ROWS -ops $OPS \
+				-labels $LABELS -denied $DENIED -write $WRITE \
+				-csv $OUT -tag "$scenario" $DB > /dev/null
+		done
+	done
+done
+
+rm -f $DB*
@@ -0,0 +1,285 @@
+/*
+** Multi-thread performance test for SQLite and SeSQLite.
+**
+** The program fills a table with labeled rows, then starts N threads,
+** each one with its own connection to the same database, running a mix
+** of reads and writes on the rows. The throughput of all the threads is
+** reported, so that running it with 1..64 threads shows how well the
+** library scales (see threads.sh).
+**
+** The library must be compiled with SQLITE_THREADSAFE=1 or 2:
+**
+**     gcc -c -O2 sqlite3.c
+**     gcc threadtest.c sqlite3.o -ldl -lpthread -I../src
+**
+** Usage:
+**
+**     ./a.out [options] FILENAME
+**
+** The labels are all created by the setup phase, before the threads start,
+** so that the threads measure the cost of the checks and not the one of
+** adding new labels. Every row gets one of -labels labels, the ones named
+** bench_no_select_<i> (-denied percent of them) are denied to the subject
+** by the test policy and by policystub.c.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "sqlite3.h"
+#include "ts_util.h"
+
+/*
+** Number of decisions asked to the policy backend, only available when
+** linked with policystub.c.
+*/
+#if defined(__GNUC__)
+extern unsigned long policystub_queries __attribute__((weak));
+#endif
+
+static unsigned long policyQueries(void){
+#if defined(__GNUC__)
+  if( &policystub_queries ) return policystub_queries;
+#endif
+  return 0;
+}
+
+/*
+** Parameters of the run, see the usage message.
+*/
+static const char *zFile = 0;
+static int bLabels = 1;
+static int nThread = 1;
+static int nRow = 10000;
+static int nOp = 2000;
+static int nLabel = 4;
+static int pctDenied = 25;
+static int pctWrite = 10;
+static int bWal = 1;
+
+/*
+** Totals of a thread.
+*/
+typedef struct Worker {
+  pthread_t tid;
+  int iSeed;
+  int nRead;
+  int nWrite;
+  int nRow;
+  int nBusy;
+  int rc;
+} Worker;
+
+static void fatal(sqlite3 *db, const char *zWhat){
+  fprintf(stderr, "%s: %s\n", zWhat, db ? sqlite3_errmsg(db) : "out of memory");
+  exit(1);
+}
+
+static void execOrDie(sqlite3 *db, const char *zSql){
+  char *zErr = 0;
+  if( sqlite3_exec(db, zSql, 0, 0, &zErr)!=SQLITE_OK ){
+    fprintf(stderr, "%s\n%s\n", zSql, zErr);
+    exit(1);
+  }
+}
+
+static sqlite3 *openDb(void){
+  sqlite3 *db = 0;
+  if( sqlite3_open_v2(zFile, &db,
+        SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE|SQLITE_OPEN_NOMUTEX, 0)
+      !=SQLITE_OK ){
+    fatal(db, "sqlite3_open_v2");
+  }
+  sqlite3_busy_timeout(db, 60000);
+  return db;
+}
+
+/*
+** Creates the table and fills it. The label of a row only depends on the
+** row number, so that every run sees the same mix.
+*/
+static void setup(void){
+  sqlite3 *db = openDb();
+  sqlite3_stmt *pStmt;
+  int nDenied = 0, nAllowed = 0;
+  int i;
+
+  if( pctDenied>0 ){
+    nDenied = (nLabel*pctDenied + 50)/100;
+    if( nDenied<1 ) nDenied = 1;
+  }
+  if( pctDenied<100 ){
+    nAllowed = nLabel - nDenied;
+    if( nAllowed<1 ) nAllowed = 1;
+  }
+
+  if( bWal ) execOrDie(db, "PRAGMA journal_mode=WAL;");
+  execOrDie(db, "CREATE TABLE bench(a INTEGER PRIMARY KEY, b INTEGER, c TEXT);");
+  execOrDie(db, "BEGIN;");
+  if( sqlite3_prepare_v2(db, bLabels
+        ? "INSERT INTO bench(security_context,a,b,c)"
+          " VALUES(getcon_id(?1),?2,?3,?3);"
+        : "INSERT INTO bench(a,b,c) VALUES(?2,?3,?3);",
+        -1, &pStmt, 0)!=SQLITE_OK ){
+    fatal(db, "sqlite3_prepare_v2");
+  }
+  srand(0);
+  for(i=1; i<=nRow; i++){
+    char zLabel[100];
+    if( rand()%100 < pctDenied ){
+      sprintf(zLabel, "unconfined_u:object_r:bench_no_select_%d_t:s0",
+              i % nDenied);
+    }else{
+      sprintf(zLabel, "unconfined_u:object_r:bench_%d_t:s0", i % nAllowed);
+    }
+    sqlite3_bind_text(pStmt, 1, zLabel, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(pStmt, 2, i);
+    sqlite3_bind_int(pStmt, 3, rand()%500000);
+    if( sqlite3_step(pStmt)!=SQLITE_DONE ) fatal(db, "insert");
+    sqlite3_reset(pStmt);
+  }
+  sqlite3_finalize(pStmt);
+  execOrDie(db, "COMMIT;");
+  sqlite3_close(db);
+}
+
+/*
+** The body of a thread: nOp statements on its own connection, pctWrite
+** percent of them are updates of a single row, the others read a range
+** of 100 rows.
+*/
+static void *worker(void *pArg){
+  Worker *p = (Worker*) pArg;
+  sqlite3 *db = openDb();
+  sqlite3_stmt *pRead, *pWrite;
+  unsigned int seed = p->iSeed;
+  int i;
+
+  if( sqlite3_prepare_v2(db,
+        "SELECT count(*), sum(b) FROM bench WHERE a>=?1 AND a<?1+100;",
+        -1, &pRead, 0)!=SQLITE_OK
+   || sqlite3_prepare_v2(db,
+        "UPDATE bench SET b=b+1 WHERE a=?1;",
+        -1, &pWrite, 0)!=SQLITE_OK ){
+    fatal(db, "sqlite3_prepare_v2");
+  }
+
+  for(i=0; i<nOp; i++){
+    int iRow = rand_r(&seed)%nRow + 1;
+    sqlite3_stmt *pStmt;
+    int rc;
+
+    if( rand_r(&seed)%100 < pctWrite ){
+      pStmt = pWrite;
+      p->nWrite++;
+    }else{
+      pStmt = pRead;
+      p->nRead++;
+    }
+    sqlite3_bind_int(pStmt, 1, iRow);
+    while( (rc = sqlite3_step(pStmt))==SQLITE_ROW ){
+      p->nRow += sqlite3_column_int(pStmt, 0);
+    }
+    if( rc==SQLITE_BUSY || rc==SQLITE_LOCKED ) p->nBusy++;
+    else if( rc!=SQLITE_DONE ) p->rc = rc;
+    sqlite3_reset(pStmt);
+  }
+
+  sqlite3_finalize(pRead);
+  sqlite3_finalize(pWrite);
+  if( sqlite3_close(db)!=SQLITE_OK ) p->rc = SQLITE_BUSY;
+  return 0;
+}
+
+int main(int argc, char **argv){
+  const char *zArgv0 = argv[0];
+  const char *zCsv = 0;
+  const char *zPrefix = 0;
+  Worker *aWorker;
+  struct timespec iStart, iElapse;
+  unsigned long nQueryStart;
+  int nRead = 0, nWrite = 0, nBusy = 0, nErr = 0;
+  int i;
+
+  for(i=1; i<argc-1; i+=2){
+    if( strcmp(argv[i], "-engine")==0 ) bLabels = strcmp(argv[i+1], "base")!=0;
+    else if( strcmp(argv[i], "-threads")==0 ) nThread = atoi(argv[i+1]);
+    else if( strcmp(argv[i], "-rows")==0 ) nRow = atoi(argv[i+1]);
+    else if( strcmp(argv[i], "-ops")==0 ) nOp = atoi(argv[i+1]);
+    else if( strcmp(argv[i], "-labels")==0 ) nLabel = atoi(argv[i+1]);
+    else if( strcmp(argv[i], "-denied")==0 ) pctDenied = atoi(argv[i+1]);
+    else if( strcmp(argv[i], "-write")==0 ) pctWrite = atoi(argv[i+1]);
+    else if( strcmp(argv[i], "-wal")==0 ) bWal = atoi(argv[i+1]);
+    else if( strcmp(argv[i], "-csv")==0 ) zCsv = argv[i+1];
+    else if( strcmp(argv[i], "-tag")==0 ) zPrefix = argv[i+1];
+    else break;
+  }
+  if( i!=argc-1 || nThread<1 || nRow<1 || nLabel<1 ){
+    fprintf(stderr, "Usage: %s [options] FILENAME\n"
+              "Runs threads with one connection each on a new database\n"
+              "\toptions:\n"
+              "\t-engine se|base : label the rows or not (se)\n"
+              "\t-threads <n> : threads and connections (1)\n"
+              "\t-rows <n> : rows in the table (10000)\n"
+              "\t-ops <n> : statements run by each thread (2000)\n"
+              "\t-labels <n> : distinct labels of the rows (4)\n"
+              "\t-denied <p> : percentage of labels denied to the subject (25)\n"
+              "\t-write <p> : percentage of updates among the statements (10)\n"
+              "\t-wal <0|1> : use the WAL journal mode (1)\n"
+              "\t-csv <file> : append the results to file\n"
+              "\t-tag <prefix> : first fields of the line written with -csv\n",
+              zArgv0);
+    exit(1);
+  }
+  zFile = argv[i];
+
+  if( !sqlite3_threadsafe() ){
+    fprintf(stderr, "%s: the library was compiled with SQLITE_THREADSAFE=0\n",
+            zArgv0);
+    exit(1);
+  }
+
+  unlink(zFile);
+  setup();
+
+  aWorker = calloc(nThread, sizeof(Worker));
+  if( aWorker==0 ) fatal(0, "calloc");
+  nQueryStart = policyQueries();
+  iStart = tsTOD();
+  for(i=0; i<nThread; i++){
+    aWorker[i].iSeed = i+1;
+    if( pthread_create(&aWorker[i].tid, 0, worker, &aWorker[i]) ){
+      fatal(0, "pthread_create");
+    }
+  }
+  for(i=0; i<nThread; i++){
+    pthread_join(aWorker[i].tid, 0);
+    nRead += aWorker[i].nRead;
+    nWrite += aWorker[i].nWrite;
+    nBusy += aWorker[i].nBusy;
+    if( aWorker[i].rc ) nErr++;
+  }
+  iElapse = tsSubtract(tsTOD(), iStart);
+
+  printf("threads %d: %d reads, %d writes (%d busy) in %.3f secs, "
+         "%.0f statements/sec\n",
+         nThread, nRead, nWrite, nBusy, tsFloat(iElapse),
+         (nRead+nWrite)/tsFloat(iElapse));
+  if( zCsv ){
+    FILE *out = fopen(zCsv, "a");
+    if( out==0 ){
+      fprintf(stderr, "cannot open %s\n", zCsv);
+      exit(1);
+    }
+    fprintf(out, "%s%s%d,%d,%d,%d,%.6f,%.1f,%lu\n",
+            zPrefix ? zPrefix : "", zPrefix ? "," : "",
+            nThread, nRead, nWrite, nBusy, tsFloat(iElapse),
+            (nRead+nWrite)/tsFloat(iElapse), policyQueries()-nQueryStart);
+    fclose(out);
+  }
+  free(aWorker);
+  return nErr ? 1 : 0;
+}
@@ -67,6 +67,20 @@ set pragma_def {
   IF:   !defined(SQLITE_OMIT_FLAG_PRAGMAS)
   IF:   !defined(SQLITE_OMIT_AUTOMATIC_INDEX)
 
+  NAME: hash_join
+  TYPE: FLAG
+  ARG:  SQLITE_HashJoin
+  IF:   !defined(SQLITE_OMIT_FLAG_PRAGMAS)
+  IF:   !defined(SQLITE_OMIT_AUTOMATIC_INDEX)
+
+  NAME: bloom_filter
+  TYPE: FLAG
+  ARG:  SQLITE_BloomFilter
+  IF:   !defined(SQLITE_OMIT_FLAG_PRAGMAS)
+
+  NAME: automatic_index_cache
+  IF:   !defined(SQLITE_OMIT_AUTOMATIC_INDEX)
+
   NAME: sql_trace
   TYPE: FLAG
   ARG:  SQLITE_SqlTrace
@@ -172,6 +186,9 @@ set pragma_def {
   NAME: mmap_size
   IF:   !defined(SQLITE_OMIT_PAGER_PRAGMAS)
 
+  NAME: readahead
+  IF:   !defined(SQLITE_OMIT_PAGER_PRAGMAS)
+
   NAME: auto_vacuum
   FLAG: NeedSchema
   IF:   !defined(SQLITE_OMIT_AUTOVACUUM)
@@ -270,6 +287,15 @@ set pragma_def {
   NAME: wal_autocheckpoint
   IF:   !defined(SQLITE_OMIT_WAL)
 
+  NAME: wal_checkpoint_thread
+  IF:   !defined(SQLITE_OMIT_WAL)
+
+  NAME: wal_checkpoint_thread_status
+  IF:   !defined(SQLITE_OMIT_WAL)
+
+  NAME: wal_group_commit
+  IF:   !defined(SQLITE_OMIT_WAL)
+
   NAME: shrink_memory
 
   NAME: busy_timeout
@@ -294,6 +320,8 @@ set pragma_def {
   IF:   defined(SQLITE_HAS_CODEC) || defined(SQLITE_ENABLE_CEROD)
 
   NAME: soft_heap_limit
+
+  NAME: threads
 }
 fconfigure stdout -translation lf
 set name {}
@@ -0,0 +1,142 @@
+#
+# This file generates SQL text used to measure the cost of the tuple-level
+# checks of SeSQLite as the mix of labels in the rows changes.
+#
+# Usage:
+#
+#     tclsh mkspeedsql_labelmix.tcl ?OPTIONS?
+#
+#     -phase setup|query   create and fill the tables, or query them (query)
+#     -engine base|se      base omits the labels, for plain SQLite (se)
+#     -rows N              rows in each table (20000)
+#     -labels N            distinct labels assigned to the rows (4)
+#     -denied P            percentage of rows the subject can not select (25)
+#     -joins N             tables joined by the join queries (1 = no joins)
+#     -flush N             clear the AVC every N queries (0 = never)
+#
+# The labels are split between the denied ones (named bench_no_select_<i>)
+# and the allowed ones (bench_<i>). If both kinds are needed at least one
+# label of each kind is used, so the number of labels can exceed -labels by
+# one when -labels is 1. Every statement starts with a comment naming its
+# kind, which is used by speedtest8 -csv to group the timings.
+#
+
+array set opt {
+  -phase  query
+  -engine se
+  -rows   20000
+  -labels 4
+  -denied 25
+  -joins  1
+  -flush  0
+}
+foreach {k v} $argv {
+  if {![info exists opt($k)]} {
+    puts stderr "unknown option $k"
+    exit 1
+  }
+  set opt($k) $v
+}
+set nTable [expr {$opt(-joins)<1 ? 1 : $opt(-joins)}]
+
+# Set a uniform random seed
+expr srand(0)
+
+# Number of denied and allowed labels
+#
+set nDenied 0
+set nAllowed 0
+if {$opt(-denied)>0} {
+  set nDenied [expr {int($opt(-labels)*$opt(-denied)/100.0 + 0.5)}]
+  if {$nDenied<1} {set nDenied 1}
+}
+if {$opt(-denied)<100} {
+  set nAllowed [expr {$opt(-labels) - $nDenied}]
+  if {$nAllowed<1} {set nAllowed 1}
+}
+
+proc label {i} {
+  if {rand()*100 < $::opt(-denied)} {
+    return "unconfined_u:object_r:bench_no_select_[expr {$i % $::nDenied}]_t:s0"
+  }
+  return "unconfined_u:object_r:bench_[expr {$i % $::nAllowed}]_t:s0"
+}
+
+# The setup: one table for each joined table, all with the same rows
+#
+if {$opt(-phase)=="setup"} {
+  puts {/* schema */ PRAGMA page_size=1024;}
+  puts {/* schema */ PRAGMA cache_size=8192;}
+  for {set t 1} {$t<=$nTable} {incr t} {
+    puts "/* schema */ CREATE TABLE bench$t\(a INTEGER, b INTEGER, c TEXT);"
+    puts "/* schema */ CREATE INDEX bench${t}a ON bench$t\(a);"
+  }
+  for {set t 1} {$t<=$nTable} {incr t} {
+    expr srand($t)
+    puts {/* insert */ BEGIN;}
+    for {set i 1} {$i<=$opt(-rows)} {incr i} {
+      set r [expr {int(rand()*500000)}]
+      if {$opt(-engine)=="se"} {
+        puts "/* insert */ INSERT INTO bench$t\(security_context,a,b,c)\
+              VALUES(getcon_id('[label $i]'),$i,$r,'$r');"
+      } else {
+        puts "/* insert */ INSERT INTO bench$t\(a,b,c) VALUES($i,$r,'$r');"
+      }
+    }
+    puts {/* insert */ COMMIT;}
+  }
+  exit 0
+}
+
+# The queries. The AVC is also cleared by SeSQLite at every commit.
+#
+set nQuery 0
+proc query {kind sql} {
+  puts "/* $kind */ $sql"
+  incr ::nQuery
+  if {$::opt(-flush)>0 && $::nQuery % $::opt(-flush)==0} {
+    puts {/* flush */ PRAGMA clearavc;}
+  }
+}
+
+# Full scans
+#
+for {set i 0} {$i<20} {incr i} {
+  set lwr [expr {$i*25000}]
+  set upr [expr {($i+10)*25000}]
+  query scan "SELECT count(*), avg(b) FROM bench1 WHERE b>=$lwr AND b<$upr;"
+}
+for {set i 0} {$i<10} {incr i} {
+  query count "SELECT count(*) FROM bench1;"
+}
+for {set i 0} {$i<10} {incr i} {
+  query like "SELECT count(*) FROM bench1 WHERE c LIKE '%[expr {$i*7}]%';"
+}
+
+# Index lookups
+#
+for {set i 0} {$i<1000} {incr i} {
+  set id [expr {int(rand()*$opt(-rows))+1}]
+  query lookup "SELECT c FROM bench1 WHERE a=$id;"
+}
+
+# Joins on the indexed column
+#
+if {$nTable>1} {
+  set from bench1
+  for {set t 2} {$t<=$nTable} {incr t} {
+    append from " JOIN bench$t ON bench$t.a=bench1.a"
+  }
+  for {set i 0} {$i<10} {incr i} {
+    set upr [expr {($i+1)*50000}]
+    query join "SELECT count(*) FROM $from WHERE bench1.b<$upr;"
+  }
+}
+
+# Updates, each one is a transaction
+#
+for {set i 0} {$i<20} {incr i} {
+  set lwr [expr {$i*($opt(-rows)/20)}]
+  set upr [expr {$lwr+100}]
+  query update "UPDATE bench1 SET b=b+1 WHERE a>=$lwr AND a<$upr;"
+}
@@ -126,6 +126,10 @@ foreach hdr {
    sesqlite_authorizer.h
    sesqlite_contexts.h
    sesqlite_utils.h
+   sesqlite_attach.h
+   sesqlite_count.h
+   sesqlite_shm.h
+   sesqlite_stmt.h
 } {
   set available_hdr($hdr) 1
 }
@@ -258,6 +262,7 @@ foreach file {
    malloc.c
    printf.c
    random.c
+   threads.c
    utf.c
    util.c
    hash.c
@@ -272,6 +277,8 @@ foreach file {
    rowset.c
    pager.c
    wal.c
+   walckpt.c
+   walgroup.c
 
    btmutex.c
    btree.c
@@ -284,6 +291,7 @@ foreach file {
    vdbe.c
    vdbeblob.c
    vdbesort.c
+   vdbehash.c
    journal.c
    memjournal.c
 
@@ -346,6 +354,10 @@ foreach file {
    sesqlite_authorizer.c
    sesqlite_contexts.c
    sesqlite_utils.c
+   sesqlite_attach.c
+   sesqlite_count.c
+   sesqlite_shm.c
+   sesqlite_stmt.c
 } {
   copy_file tsrc/$file
 }